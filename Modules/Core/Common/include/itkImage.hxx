@@ -30,6 +30,7 @@
 
 #include "itkImage.h"
 #include "itkProcessObject.h"
+#include "itkTraceEventRecorder.h"
 #include <algorithm>
 
 namespace itk
@@ -54,6 +55,12 @@ Image< TPixel, VImageDimension >
   num = static_cast<SizeValueType>(this->GetOffsetTable()[VImageDimension]);
 
   m_Buffer->Reserve(num, initializePixels);
+
+  if ( TraceEventRecorder::GetEnabled() )
+    {
+    TraceEventRecorder::RecordInstantEvent( "memory", this->GetNameOfClass(),
+                                            "bytes", static_cast< double >( num ) * sizeof( PixelType ) );
+    }
 }
 
 
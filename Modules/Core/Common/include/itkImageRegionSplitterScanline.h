@@ -0,0 +1,92 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageRegionSplitterScanline_h
+#define itkImageRegionSplitterScanline_h
+
+#include "itkImageRegionSplitterBase.h"
+
+namespace itk
+{
+
+/** \class ImageRegionSplitterScanline
+ * \brief Divide an image region into blocks of complete scanlines
+ *
+ * ImageRegionSplitterScanline divides an ImageRegion into many small
+ * pieces, for instance to be distributed dynamically to threads. The
+ * fastest dimension is never split, so every piece is made of whole
+ * scanlines. The outermost dimension is split first; when it has fewer
+ * elements than the number of requested pieces, each of its pieces is
+ * divided further along the next outermost dimension, and so on. A
+ * 512x512x300 region split in 3000 pieces gives 300 slices each cut in
+ * 10 blocks of 52 scanlines.
+ *
+ * Consecutive piece numbers are adjacent in memory.
+ *
+ * \sa ImageRegionSplitterSlowDimension
+ *
+ * \ingroup ITKSystemObjects
+ * \ingroup DataProcessing
+ * \ingroup ITKCommon
+ */
+
+class ITKCommon_EXPORT ImageRegionSplitterScanline
+  :public ImageRegionSplitterBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageRegionSplitterScanline Self;
+  typedef ImageRegionSplitterBase     Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageRegionSplitterScanline, ImageRegionSplitterBase);
+
+
+protected:
+  ImageRegionSplitterScanline();
+
+  virtual unsigned int GetNumberOfSplitsInternal( unsigned int dim,
+                                                  const IndexValueType regionIndex[],
+                                                  const SizeValueType regionSize[],
+                                                  unsigned int requestedNumber ) const ITK_OVERRIDE;
+
+  virtual unsigned int GetSplitInternal( unsigned int dim,
+                                         unsigned int i,
+                                         unsigned int numberOfPieces,
+                                         IndexValueType regionIndex[],
+                                         SizeValueType regionSize[] ) const ITK_OVERRIDE;
+
+private:
+  ImageRegionSplitterScanline(const ImageRegionSplitterScanline &); //purposely not implemented
+  void operator=(const ImageRegionSplitterScanline &);      //purposely not implemented
+
+  /** Compute the number of pieces, and the number of values per piece,
+   * along each dimension. Returns the total number of pieces. */
+  static unsigned int ComputeSplits( unsigned int dim,
+                                     const SizeValueType regionSize[],
+                                     unsigned int requestedNumber,
+                                     unsigned int splits[],
+                                     SizeValueType valuesPerPiece[] );
+};
+} // end namespace itk
+
+#endif
@@ -32,6 +32,7 @@
 #include "itkImage.h"
 #include "itkImageRegionSplitterBase.h"
 #include "itkImageSourceCommon.h"
+#include "itkSimpleFastMutexLock.h"
 
 namespace itk
 {
@@ -213,6 +214,31 @@ public:
   virtual ProcessObject::DataObjectPointer MakeOutput(ProcessObject::DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
   virtual ProcessObject::DataObjectPointer MakeOutput(const ProcessObject::DataObjectIdentifierType &) ITK_OVERRIDE;
 
+  /** Set/Get whether the output is processed in many small pieces
+   * that the threads pick up dynamically, instead of one static piece
+   * per thread. This balances the load of filters whose cost per pixel
+   * varies across the image.
+   *
+   * When on, ThreadedGenerateData() may be called several times by the
+   * same thread, each time with a different region and the same
+   * threadId, so it must not reset per-thread state that was
+   * accumulated in a previous call; such state should be initialized in
+   * BeforeThreadedGenerateData() instead. BeforeThreadedGenerateData()
+   * and AfterThreadedGenerateData() are still called exactly once. A
+   * ProgressReporter created in ThreadedGenerateData() reports the
+   * progress of the current piece only. Filters which override
+   * SplitRequestedRegion() are not supported. Off by default. */
+  itkSetMacro(DynamicMultiThreading, bool);
+  itkGetConstMacro(DynamicMultiThreading, bool);
+  itkBooleanMacro(DynamicMultiThreading);
+
+  /** Set/Get the approximate number of pixels in each piece when
+   * DynamicMultiThreading is on. The actual pieces are made of whole
+   * scanlines, so they may be larger. When 0, the default, the
+   * requested region is divided in about 16 pieces per thread. */
+  itkSetMacro(DynamicChunkSize, SizeValueType);
+  itkGetConstMacro(DynamicChunkSize, SizeValueType);
+
 protected:
   ImageSource();
   virtual ~ImageSource() {}
@@ -329,6 +355,26 @@ protected:
   virtual
   unsigned int SplitRequestedRegion(unsigned int i, unsigned int pieces, OutputImageRegionType & splitRegion);
 
+  /** \brief Returns the dynamic image region splitter
+   *
+   * This is an adapter function from the private common base class to
+   * the interface of this class.
+   */
+  static const ImageRegionSplitterBase* GetGlobalDynamicSplitter()
+  {
+    return ImageSourceCommon::GetGlobalDynamicSplitter();
+  }
+
+  /** \brief Get the image splitter used when DynamicMultiThreading is on.
+   *
+   * When GetImageRegionSplitter() returns the global default splitter,
+   * the requested region is divided in blocks of scanlines by an
+   * ImageRegionSplitterScanline. Otherwise the filter's own splitter
+   * is used, as it may restrict the directions along which the region
+   * can be divided.
+   */
+  virtual const ImageRegionSplitterBase* GetDynamicImageRegionSplitter() const;
+
   /** Static function used as a "callback" by the MultiThreader.  The threading
    * library will call this routine for each thread, which will delegate the
    * control to ThreadedGenerateData(). */
@@ -340,9 +386,28 @@ protected:
     Pointer Filter;
   };
 
+  /** Static function used as a "callback" by the MultiThreader when
+   * DynamicMultiThreading is on. Each thread repeatedly takes the next
+   * unprocessed piece and calls ThreadedGenerateData() on it. */
+  static ITK_THREAD_RETURN_TYPE DynamicThreaderCallback(void *arg);
+
+  /** Internal structure used for passing the shared piece counter into
+   * the threading library when DynamicMultiThreading is on. */
+  struct DynamicThreadStruct {
+    Pointer                        Filter;
+    const ImageRegionSplitterBase *Splitter;
+    OutputImageRegionType          Region;
+    unsigned int                   NumberOfPieces;
+    unsigned int                   NextPiece;
+    SimpleFastMutexLock            NextPieceLock;
+  };
+
 private:
   ImageSource(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
+
+  bool          m_DynamicMultiThreading;
+  SizeValueType m_DynamicChunkSize;
 };
 } // end namespace itk
 
@@ -31,8 +31,11 @@
 
 #include "itkOutputDataObjectIterator.h"
 #include "itkImageRegionSplitterBase.h"
+#include "itkMutexLockHolder.h"
+#include "itkTraceEventRecorder.h"
 
 #include "vnl/vnl_math.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -41,7 +44,9 @@ namespace itk
  */
 template< typename TOutputImage >
 ImageSource< TOutputImage >
-::ImageSource()
+::ImageSource() :
+  m_DynamicMultiThreading(false),
+  m_DynamicChunkSize(0)
 {
   // Create the output. We use static_cast<> here because we know the default
   // output must be of type TOutputImage
@@ -196,6 +201,20 @@ ImageSource< TOutputImage >
 
 }
 
+//----------------------------------------------------------------------------
+template< typename TOutputImage >
+const ImageRegionSplitterBase*
+ImageSource< TOutputImage >
+::GetDynamicImageRegionSplitter(void) const
+{
+  const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
+  if ( splitter == this->GetGlobalDefaultSplitter() )
+    {
+    return this->GetGlobalDynamicSplitter();
+    }
+  return splitter;
+}
+
 //----------------------------------------------------------------------------
 template< typename TOutputImage >
 void
@@ -238,20 +257,62 @@ ImageSource< TOutputImage >
   // separate threads
   this->BeforeThreadedGenerateData();
 
-  // Set up the multithreaded processing
-  ThreadStruct str;
-  str.Filter = this;
-
   // Get the output pointer
   const OutputImageType *outputPtr = this->GetOutput();
-  const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
-  const unsigned int validThreads = splitter->GetNumberOfSplits( outputPtr->GetRequestedRegion(), this->GetNumberOfThreads() );
 
-  this->GetMultiThreader()->SetNumberOfThreads( validThreads );
-  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  if ( m_DynamicMultiThreading )
+    {
+    // The dynamic pieces are independent of the threads that process
+    // them, so they are shared among the threads the global thread
+    // budget grants to this filter, if there is one. A
+    // SingleMethodExecute() of that many threads shares this lease.
+    const MultiThreader::ThreadBudgetLease threadBudgetLease( this->GetNumberOfThreads() );
+    const ThreadIdType numberOfThreads = threadBudgetLease.GetNumberOfThreads();
+
+    // Set up the dynamically load balanced processing
+    DynamicThreadStruct str;
+    str.Filter = this;
+    str.Splitter = this->GetDynamicImageRegionSplitter();
+    str.Region = outputPtr->GetRequestedRegion();
+    str.NextPiece = 0;
+
+    SizeValueType requestedPieces = static_cast< SizeValueType >( numberOfThreads ) * 16;
+    if ( m_DynamicChunkSize > 0 )
+      {
+      requestedPieces = ( str.Region.GetNumberOfPixels() + m_DynamicChunkSize - 1 ) / m_DynamicChunkSize;
+      }
+    requestedPieces = std::max( requestedPieces, NumericTraits< SizeValueType >::OneValue() );
+    requestedPieces = std::min( requestedPieces,
+                                static_cast< SizeValueType >( NumericTraits< unsigned int >::max() ) );
+    str.NumberOfPieces = str.Splitter->GetNumberOfSplits( str.Region, static_cast< unsigned int >( requestedPieces ) );
+
+    const unsigned int validThreads = std::min( static_cast< unsigned int >( numberOfThreads ),
+                                                str.NumberOfPieces );
+
+    this->GetMultiThreader()->SetNumberOfThreads( validThreads );
+    this->GetMultiThreader()->SetSingleMethod(this->DynamicThreaderCallback, &str);
+
+    // multithread the execution
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+  else
+    {
+    // Set up the multithreaded processing. There is one piece per
+    // thread, as SplitRequestedRegion() reports to the subclasses, which
+    // may synchronize the pieces (see Barrier), so their number is not
+    // reduced by the global thread budget.
+    ThreadStruct str;
+    str.Filter = this;
+
+    const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
+    const unsigned int validThreads = splitter->GetNumberOfSplits( outputPtr->GetRequestedRegion(), this->GetNumberOfThreads() );
 
-  // multithread the execution
-  this->GetMultiThreader()->SingleMethodExecute();
+    this->GetMultiThreader()->SetNumberOfThreads( validThreads );
+    this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+
+    // multithread the execution
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
@@ -304,6 +365,9 @@ ImageSource< TOutputImage >
 
   if ( threadId < total )
     {
+    TraceEventRecorder::Scope traceEvent( "thread", str->Filter->GetNameOfClass() );
+    traceEvent.SetArgument( 0, "piece", threadId );
+    traceEvent.SetArgument( 1, "pixels", splitRegion.GetNumberOfPixels() );
     str->Filter->ThreadedGenerateData(splitRegion, threadId);
     }
   // else
@@ -315,6 +379,46 @@ ImageSource< TOutputImage >
 
   return ITK_THREAD_RETURN_VALUE;
 }
+
+// Callback routine used by the threading library when
+// DynamicMultiThreading is on. Each thread takes the pieces one at a
+// time until all of them have been processed, so that a thread which
+// is done with a cheap piece immediately helps with the rest.
+template< typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+ImageSource< TOutputImage >
+::DynamicThreaderCallback(void *arg)
+{
+  const ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+
+  DynamicThreadStruct *str =
+    (DynamicThreadStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  for (;; )
+    {
+    unsigned int piece;
+      {
+      MutexLockHolder< SimpleFastMutexLock > lock(str->NextPieceLock);
+      piece = str->NextPiece++;
+      }
+    if ( piece >= str->NumberOfPieces )
+      {
+      break;
+      }
+
+    typename TOutputImage::RegionType splitRegion = str->Region;
+    const unsigned int total = str->Splitter->GetSplit(piece, str->NumberOfPieces, splitRegion);
+    if ( piece < total )
+      {
+      TraceEventRecorder::Scope traceEvent( "thread", str->Filter->GetNameOfClass() );
+      traceEvent.SetArgument( 0, "piece", piece );
+      traceEvent.SetArgument( 1, "pixels", splitRegion.GetNumberOfPixels() );
+      str->Filter->ThreadedGenerateData(splitRegion, threadId);
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
 } // end namespace itk
 
 #endif
@@ -42,6 +42,12 @@ struct ITKCommon_EXPORT ImageSourceCommon
    * Provide access to a common static object for image region splitting
    */
   static  const ImageRegionSplitterBase*  GetGlobalDefaultSplitter();
+
+  /**
+   * Provide access to a common static object for splitting a region
+   * into the many small pieces used by dynamic multi-threading
+   */
+  static  const ImageRegionSplitterBase*  GetGlobalDynamicSplitter();
 };
 
 } // end namespace itk
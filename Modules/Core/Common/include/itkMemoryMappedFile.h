@@ -0,0 +1,101 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMemoryMappedFile_h
+#define itkMemoryMappedFile_h
+
+#include "itkLightObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include <string>
+
+namespace itk
+{
+/** \class MemoryMappedFile
+ * \brief A range of bytes of a file mapped into memory.
+ *
+ * The mapping is copy on write: the mapped memory may be modified, but
+ * the modifications are private to the process and are never written
+ * back to the file. The pages of the file are read by the operating
+ * system when they are first accessed, and pages that were not modified
+ * may be dropped from memory under pressure and read again later.
+ *
+ * The file must not be truncated while it is mapped.
+ *
+ * \sa MemoryMappedImportImageContainer
+ * \ingroup ITKCommon
+ */
+class ITKCommon_EXPORT MemoryMappedFile:public LightObject
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedFile           Self;
+  typedef LightObject                Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedFile, LightObject);
+
+  /** Type of a position in a file. */
+  typedef ::itk::uintmax_t OffsetType;
+
+  /** Map length bytes of the file, starting at the given offset, in
+   * place of the current mapping. The offset does not need to be
+   * aligned. Returns false, and leaves nothing mapped, if the file
+   * cannot be opened, is too short, or cannot be mapped. */
+  bool Map(const std::string & fileName, OffsetType offset, size_t length);
+
+  /** Release the current mapping, if any. */
+  void Unmap();
+
+  /** First mapped byte, or ITK_NULLPTR when nothing is mapped. */
+  void * GetData() const
+  {
+    return m_Data;
+  }
+
+  /** Number of mapped bytes. */
+  size_t GetLength() const
+  {
+    return m_Length;
+  }
+
+protected:
+  MemoryMappedFile();
+  virtual ~MemoryMappedFile();
+  virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  MemoryMappedFile(const Self &); //purposely not implemented
+  void operator=(const Self &);   //purposely not implemented
+
+  // The mapping itself starts at the page boundary before m_Data.
+  void  *m_Data;
+  size_t m_Length;
+  void  *m_MappingAddress;
+  size_t m_MappingLength;
+#if defined( _WIN32 )
+  void *m_MappingHandle;
+#endif
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,100 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMemoryMappedImportImageContainer_h
+#define itkMemoryMappedImportImageContainer_h
+
+#include "itkImportImageContainer.h"
+#include "itkMemoryMappedFile.h"
+
+namespace itk
+{
+/** \class MemoryMappedImportImageContainer
+ *  \brief An ImportImageContainer whose elements are mapped from a file.
+ *
+ * The container imports the elements of a MemoryMappedFile and keeps the
+ * mapping alive for as long as it uses them. It can be set as the pixel
+ * container of an Image or a VectorImage, so that the pixels are read
+ * from the file on demand by the operating system instead of being
+ * copied into an allocated buffer.
+ *
+ * The mapping is copy on write, so the pixels may be modified, for
+ * instance by an in place filter, without changing the file. Once the
+ * container is reserved to a larger size, squeezed or initialized, it
+ * releases the mapping and behaves as an ImportImageContainer.
+ *
+ * \sa MemoryMappedFile
+ * \ingroup ImageObjects
+ * \ingroup ITKCommon
+ */
+template< typename TElementIdentifier, typename TElement >
+class MemoryMappedImportImageContainer:
+  public ImportImageContainer< TElementIdentifier, TElement >
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedImportImageContainer                     Self;
+  typedef ImportImageContainer< TElementIdentifier, TElement > Superclass;
+  typedef SmartPointer< Self >                                 Pointer;
+  typedef SmartPointer< const Self >                           ConstPointer;
+
+  typedef typename Superclass::ElementIdentifier ElementIdentifier;
+  typedef typename Superclass::Element           Element;
+  typedef MemoryMappedFile::OffsetType           OffsetType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Standard part of every itk Object. */
+  itkTypeMacro(MemoryMappedImportImageContainer, ImportImageContainer);
+
+  /** Map size elements stored in the file from the given offset, and
+   * import them in place of the current elements. Returns false, and
+   * leaves the container unchanged, if the elements cannot be mapped or
+   * if the offset is not a multiple of the alignment of an element on
+   * this platform. */
+  bool MapFile(const std::string & fileName, OffsetType offset, ElementIdentifier size);
+
+  /** The mapping the elements come from, or ITK_NULLPTR when they do not
+   * come from a file. */
+  const MemoryMappedFile * GetMappedFile() const
+  {
+    return m_MappedFile.GetPointer();
+  }
+
+protected:
+  MemoryMappedImportImageContainer() {}
+  virtual ~MemoryMappedImportImageContainer() {}
+
+  virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Release the mapping along with the elements. */
+  virtual void DeallocateManagedMemory() ITK_OVERRIDE;
+
+private:
+  MemoryMappedImportImageContainer(const Self &); //purposely not implemented
+  void operator=(const Self &);                   //purposely not implemented
+
+  MemoryMappedFile::Pointer m_MappedFile;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMemoryMappedImportImageContainer.hxx"
+#endif
+
+#endif
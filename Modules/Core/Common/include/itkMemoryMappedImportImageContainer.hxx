@@ -0,0 +1,82 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMemoryMappedImportImageContainer_hxx
+#define itkMemoryMappedImportImageContainer_hxx
+
+#include "itkMemoryMappedImportImageContainer.h"
+
+namespace itk
+{
+template< typename TElementIdentifier, typename TElement >
+bool
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::MapFile(const std::string & fileName, OffsetType offset, ElementIdentifier size)
+{
+  // the mapping starts on a page boundary, so the elements are aligned
+  // as their offset in the file
+  struct AlignmentOfElement
+  {
+    char    m_Char;
+    TElement m_Element;
+  };
+  const OffsetType alignment = sizeof( AlignmentOfElement ) - sizeof( TElement );
+  if ( alignment > 1 && offset % alignment != 0 )
+    {
+    return false;
+    }
+
+  MemoryMappedFile::Pointer mappedFile = MemoryMappedFile::New();
+  if ( !mappedFile->Map( fileName, offset, static_cast< size_t >( size ) * sizeof( TElement ) ) )
+    {
+    return false;
+    }
+
+  this->SetImportPointer(static_cast< TElement * >( mappedFile->GetData() ), size, false);
+  m_MappedFile = mappedFile;
+  return true;
+}
+
+template< typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::DeallocateManagedMemory()
+{
+  Superclass::DeallocateManagedMemory();
+  m_MappedFile = ITK_NULLPTR;
+}
+
+template< typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "MappedFile: ";
+  if ( m_MappedFile )
+    {
+    os << m_MappedFile.GetPointer() << std::endl;
+    }
+  else
+    {
+    os << "(none)" << std::endl;
+    }
+}
+} // end namespace itk
+
+#endif
@@ -33,6 +33,7 @@
 #include "itkIntTypes.h"
 
 #include "itkThreadPool.h"
+#include "itkWorkStealingThreadPool.h"
 
 namespace itk
 {
@@ -89,6 +90,14 @@ public:
   static void SetGlobalDefaultUseThreadPool( const bool GlobalDefaultUseThreadPool );
   static bool GetGlobalDefaultUseThreadPool( );
 
+  /** Set/Get whether SingleMethodExecute() schedules its threads on the
+   * persistent WorkStealingThreadPool.  When on, this takes precedence
+   * over the UseThreadPool setting.  This defaults to the environment
+   * variable "ITK_USE_WORKSTEALING" if set, else to false.
+   */
+  static void SetGlobalDefaultUseWorkStealing( const bool GlobalDefaultUseWorkStealing );
+  static bool GetGlobalDefaultUseWorkStealing( );
+
   /** Set/Get the value which is used to initialize the NumberOfThreads in the
    * constructor.  It will be clamped to the range [1, m_GlobalMaximumNumberOfThreads ].
    * Therefore the caller of this method should check that the requested number
@@ -97,10 +106,80 @@ public:
 
   static ThreadIdType  GetGlobalDefaultNumberOfThreads();
 
+  /** Set/Get the process wide thread budget: the number of threads that
+   * may run threaded work at the same time, summed over every pipeline
+   * and every level of nesting.  Zero, the default, disables the budget.
+   * This defaults to the environment variable "ITK_GLOBAL_THREAD_BUDGET"
+   * if set.
+   *
+   * With a budget, ProcessObject::UpdateOutputData() leases threads for
+   * GenerateData(), and ImageSource shares the threads that were granted
+   * among the pieces of its dynamic multithreading.  The NumberOfThreads
+   * of the filter, and the number of pieces of its static splitting, are
+   * not changed.  A SingleMethodExecute() invoked from one of the
+   * threads of another execution only gets the threads that are still
+   * free, so a nested call usually runs inline.  Concurrent filters are
+   * each granted at most an equal share of the budget.  A
+   * SingleMethodExecute() that is not nested in another execution keeps
+   * all its threads, which are charged to the budget.
+   * \sa ThreadBudgetLease */
+  static void SetGlobalThreadBudget(ThreadIdType val);
+  static ThreadIdType GetGlobalThreadBudget();
+
+  /** Number of threads currently charged to the global thread budget. */
+  static ThreadIdType GetGlobalNumberOfActiveThreads();
+
+  /** \class ThreadBudgetLease
+   * \brief Reserves threads from the global thread budget for its lifetime.
+   *
+   * The lease is granted between 1 and the requested number of threads.
+   * A lease taken by a thread that already holds one shares the outer
+   * lease, a lease taken from a thread that runs a SingleMethodExecute()
+   * piece is only granted the threads that are still free, and a top
+   * level lease is granted at most an equal share of the budget among
+   * the top level leases alive.  The calling thread always counts as
+   * one granted thread, even when the budget is used up.
+   *
+   * With reduceTopLevel off, a top level lease, or a lease taken by a
+   * thread that holds one, is granted all the requested threads and
+   * charged the ones it adds.  SingleMethodExecute() does so because the
+   * pieces of an execution may wait on each other (see Barrier), so they
+   * cannot be run by fewer threads unless their number was chosen from a
+   * lease.
+   *
+   * Leases must be destroyed by the thread that created them, in reverse
+   * order of creation.  When the budget is zero a lease grants the
+   * requested number of threads and does nothing else.
+   * \ingroup ITKCommon */
+  class ITKCommon_EXPORT ThreadBudgetLease
+  {
+  public:
+    explicit ThreadBudgetLease(ThreadIdType numberOfThreads, bool reduceTopLevel = true);
+    ~ThreadBudgetLease();
+
+    /** Number of threads granted by the lease. */
+    ThreadIdType GetNumberOfThreads() const { return m_NumberOfThreads; }
+
+    /** Whether the lease was taken against an enabled budget. */
+    bool GetActive() const { return m_Active; }
+
+  private:
+    ThreadBudgetLease(const ThreadBudgetLease &); // purposely not implemented
+    void operator=(const ThreadBudgetLease &);    // purposely not implemented
+
+    ThreadIdType m_NumberOfThreads;
+    ThreadIdType m_NumberOfChargedThreads;
+    bool         m_Active;
+    bool         m_TopLevel;
+    void        *m_Previous;
+  };
+
   /** Execute the SingleMethod (as define by SetSingleMethod) using
    * m_NumberOfThreads threads. As a side effect the m_NumberOfThreads will be
    * checked against the current m_GlobalMaximumNumberOfThreads and clamped if
-   * necessary. */
+   * necessary. When the global thread budget is enabled, the
+   * m_NumberOfThreads pieces may be run by fewer threads, each of them
+   * running several pieces one after the other. */
   void SingleMethodExecute();
 
   /** Execute the MultipleMethods (as define by calling SetMultipleMethod for
@@ -143,6 +222,19 @@ public:
   /** Get the UseThreadPool flag*/
   itkGetMacro(UseThreadPool,bool);
 
+  /** Set the WorkStealingThreadPool used by this MultiThreader. If not set,
+    * the global WorkStealingThreadPool will be used. */
+  itkSetObjectMacro(WorkStealingThreadPool, WorkStealingThreadPool);
+
+  /** Get the WorkStealingThreadPool used by this MultiThreader */
+  itkGetModifiableObjectMacro(WorkStealingThreadPool, WorkStealingThreadPool);
+
+  /** Set the flag to run SingleMethodExecute on the work stealing
+    * thread pool */
+  itkSetMacro(UseWorkStealing,bool);
+  /** Get the UseWorkStealing flag*/
+  itkGetMacro(UseWorkStealing,bool);
+
   /** This is the structure that is passed to the thread that is
    * created from the SingleMethodExecute, MultipleMethodExecute or
    * the SpawnThread method. It is passed in as a void *, and it is up
@@ -183,6 +275,12 @@ private:
   // choose whether to use Spawn or ThreadPool methods
   bool m_UseThreadPool;
 
+  // Work stealing thread pool instance, created on first use
+  WorkStealingThreadPool::Pointer m_WorkStealingThreadPool;
+
+  // choose whether SingleMethodExecute uses the work stealing pool
+  bool m_UseWorkStealing;
+
   /** An array of thread info containing a thread id
    *  (0, 1, 2, .. ITK_MAX_THREADS-1), the thread count, and a pointer
    *  to void so that user data can be passed to each thread. */
@@ -214,6 +312,12 @@ private:
    */
   static bool m_GlobalDefaultUseThreadPool;
 
+  /** Global value to effect whether the work stealing implementation
+   * should be used. This defaults to the environmental variable
+   * "ITK_USE_WORKSTEALING" if set, else it defaults to false.
+   */
+  static bool m_GlobalDefaultUseWorkStealing;
+
   /*  Global variable defining the default number of threads to set at
    *  construction time of a MultiThreader instance.  The
    *  m_GlobalDefaultNumberOfThreads must always be less than or equal to the
@@ -236,6 +340,14 @@ private:
    */
   ThreadIdType m_NumberOfThreads;
 
+  /** Global process wide thread budget, 0 when disabled. */
+  static ThreadIdType m_GlobalThreadBudget;
+
+  /** Describes the executors of a SingleMethodExecute() that runs under
+   * the thread budget.  Executor i runs the pieces i, i + E, i + 2E, ...
+   * where E is the number of executors. */
+  ThreadInfoStruct m_ExecutorInfoArray[ITK_MAX_THREADS];
+
   /** Static function used as a "proxy callback" by the MultiThreader.  The
    * threading library will call this routine for each thread, which
    * will delegate the control to the prescribed SingleMethod. This
@@ -244,6 +356,19 @@ private:
    * exceptions thrown by the threads. */
   static ITK_THREAD_RETURN_TYPE SingleMethodProxy(void *arg);
 
+  /** Implementation of SingleMethodExecute on the work stealing pool.
+   * Threads 1..N-1 are submitted as tasks, thread 0 runs in the calling
+   * thread, which then helps with the remaining tasks while waiting. */
+  void WorkStealingSingleMethodExecute();
+
+  /** Implementation of SingleMethodExecute when the thread budget is
+   * enabled.  The m_NumberOfThreads pieces are run by numberOfExecutors
+   * threads, the calling thread being the first one. */
+  void BudgetedSingleMethodExecute(ThreadIdType numberOfExecutors);
+
+  /** Runs the pieces assigned to one executor. */
+  static ITK_THREAD_RETURN_TYPE ExecutorProxy(void *arg);
+
   /** Assign work to a thread in the thread pool */
   ThreadProcessIdType ThreadPoolDispatchSingleMethodThread(ThreadInfoStruct *);
   /** wait for a thread in the threadpool to finish work */
@@ -21,6 +21,7 @@
 #include "itkCommand.h"
 #include "itkImageAlgorithm.h"
 #include "itkImageRegionSplitterSlowDimension.h"
+#include "itkTraceEventRecorder.h"
 
 namespace itk
 {
@@ -190,6 +191,9 @@ StreamingImageFilter< TInputImage, TOutputImage >
    * Loop over the number of pieces, execute the upstream pipeline on each
    * piece, and copy the results into the output image.
    */
+  TraceEventRecorder::Scope filterTraceEvent( "filter", this->GetNameOfClass() );
+  filterTraceEvent.SetArgument( 0, "pieces", numDivisions );
+
   unsigned int         piece=0;
   for (;
        piece < numDivisions && !this->GetAbortGenerateData();
@@ -198,6 +202,10 @@ StreamingImageFilter< TInputImage, TOutputImage >
     InputImageRegionType streamRegion = outputRegion;
     m_RegionSplitter->GetSplit(piece, numDivisions, streamRegion);
 
+    TraceEventRecorder::Scope traceEvent( "stream", this->GetNameOfClass() );
+    traceEvent.SetArgument( 0, "piece", piece );
+    traceEvent.SetArgument( 1, "pixels", streamRegion.GetNumberOfPixels() );
+
     inputPtr->SetRequestedRegion(streamRegion);
     inputPtr->PropagateRequestedRegion();
     inputPtr->UpdateOutputData();
@@ -0,0 +1,181 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTraceEventRecorder_h
+#define itkTraceEventRecorder_h
+
+#include "itkIntTypes.h"
+#include "itkMacro.h"
+#include <iostream>
+#include <string>
+
+namespace itk
+{
+/** \class TraceEventRecorder
+ * \brief Process wide recorder of the execution of the pipeline.
+ *
+ * When it is enabled, the recorder collects timed events from all the
+ * threads of the process:
+ *
+ * - "filter" events span the GenerateData() of each ProcessObject;
+ * - "thread" events span each call of ThreadedGenerateData() made by
+ *   an ImageSource, with the piece and the number of pixels of its
+ *   region, so that an unbalanced split shows as a ragged end of the
+ *   pieces of a filter;
+ * - "memory" events mark each allocation of a pixel buffer, with its
+ *   size in bytes;
+ * - "stream" events span each piece of a StreamingImageFilter or of a
+ *   streamed ImageFileWriter.
+ *
+ * The events are written in the Chrome trace event format, which can
+ * be loaded in chrome://tracing or other trace viewers.
+ *
+ * The recorder is disabled by default, and then costs one test of a
+ * static boolean per instrumented call. Setting the ITK_TRACE_EVENTS
+ * environmental variable to a file name enables it at startup and
+ * writes the events to that file when the process exits.
+ *
+ * \ingroup ITKCommon
+ */
+class ITKCommon_EXPORT TraceEventRecorder
+{
+public:
+  /** Enable or disable the recording of events. Events already
+   * recorded are kept. */
+  static void SetEnabled(bool enabled);
+  static bool GetEnabled()
+  {
+    return m_Enabled;
+  }
+  static void EnabledOn()
+  {
+    SetEnabled(true);
+  }
+  static void EnabledOff()
+  {
+    SetEnabled(false);
+  }
+
+  /** Time in microseconds since the start of the process, as used for
+   * the time stamps of the events. */
+  static double GetTimeStamp();
+
+  /** Record an event of the calling thread that started at the given
+   * time stamp and lasted duration microseconds. Up to two numeric
+   * arguments are attached to the event; a null name skips an
+   * argument. The category and the argument names are not copied and
+   * should be string literals. Nothing is recorded when the recorder
+   * is disabled. */
+  static void RecordCompleteEvent(const char *category,
+                                  const std::string & name,
+                                  double start,
+                                  double duration,
+                                  const char *argumentName0 = ITK_NULLPTR,
+                                  double argumentValue0 = 0.0,
+                                  const char *argumentName1 = ITK_NULLPTR,
+                                  double argumentValue1 = 0.0);
+
+  /** Record an event of the calling thread without duration, at the
+   * current time. */
+  static void RecordInstantEvent(const char *category,
+                                 const std::string & name,
+                                 const char *argumentName0 = ITK_NULLPTR,
+                                 double argumentValue0 = 0.0,
+                                 const char *argumentName1 = ITK_NULLPTR,
+                                 double argumentValue1 = 0.0);
+
+  /** Number of events recorded so far. */
+  static SizeValueType GetNumberOfEvents();
+
+  /** Discard the events recorded so far. */
+  static void Clear();
+
+  /** Write the events as a Chrome trace event JSON object. */
+  static void WriteChromeTrace(std::ostream & os);
+  static bool WriteChromeTrace(const std::string & fileName);
+
+  /** \class Scope
+   * \brief Records a complete event spanning its own lifetime.
+   *
+   * The start time is only taken if the recorder is enabled when the
+   * scope is created, so a disabled scope costs two tests. The name is
+   * not copied and must outlive the scope.
+   *
+   * \ingroup ITKCommon
+   */
+  class ITKCommon_EXPORT Scope
+  {
+  public:
+    Scope(const char *category, const char *name) :
+      m_Category(category),
+      m_Name(name),
+      m_Start(-1.0)
+    {
+      m_ArgumentName[0] = m_ArgumentName[1] = ITK_NULLPTR;
+      m_ArgumentValue[0] = m_ArgumentValue[1] = 0.0;
+      if ( TraceEventRecorder::GetEnabled() )
+        {
+        m_Start = TraceEventRecorder::GetTimeStamp();
+        }
+    }
+
+    ~Scope()
+    {
+      if ( m_Start >= 0.0 )
+        {
+        TraceEventRecorder::RecordCompleteEvent( m_Category, m_Name, m_Start,
+                                                 TraceEventRecorder::GetTimeStamp() - m_Start,
+                                                 m_ArgumentName[0], m_ArgumentValue[0],
+                                                 m_ArgumentName[1], m_ArgumentValue[1] );
+        }
+    }
+
+    /** True when the event will be recorded. Use it to skip the
+     * computation of the arguments otherwise. */
+    bool GetActive() const
+    {
+      return m_Start >= 0.0;
+    }
+
+    /** Attach the argument of the given index, 0 or 1, to the event. */
+    void SetArgument(unsigned int index, const char *name, double value)
+    {
+      m_ArgumentName[index] = name;
+      m_ArgumentValue[index] = value;
+    }
+
+  private:
+    Scope(const Scope &);          // purposely not implemented
+    void operator=(const Scope &); // purposely not implemented
+
+    const char *m_Category;
+    const char *m_Name;
+    double      m_Start;
+    const char *m_ArgumentName[2];
+    double      m_ArgumentValue[2];
+  };
+
+private:
+  TraceEventRecorder();                          // purposely not implemented
+  TraceEventRecorder(const TraceEventRecorder &); // purposely not implemented
+  void operator=(const TraceEventRecorder &);    // purposely not implemented
+
+  static bool m_Enabled;
+};
+} // end namespace itk
+
+#endif
@@ -29,6 +29,7 @@
 #define itkVectorImage_hxx
 #include "itkVectorImage.h"
 #include "itkProcessObject.h"
+#include "itkTraceEventRecorder.h"
 
 namespace itk
 {
@@ -59,6 +60,13 @@ VectorImage< TPixel, VImageDimension >
   num = this->GetOffsetTable()[VImageDimension];
 
   m_Buffer->Reserve(num * m_VectorLength,UseDefaultConstructor);
+
+  if ( TraceEventRecorder::GetEnabled() )
+    {
+    TraceEventRecorder::RecordInstantEvent( "memory", this->GetNameOfClass(),
+                                            "bytes", static_cast< double >( num ) * m_VectorLength
+                                            * sizeof( InternalPixelType ) );
+    }
 }
 
 template< typename TPixel, unsigned int VImageDimension >
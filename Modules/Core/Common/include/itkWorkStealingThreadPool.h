@@ -0,0 +1,223 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkWorkStealingThreadPool_h
+#define itkWorkStealingThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkThreadSupport.h"
+#include "itkIntTypes.h"
+#include "itkMutexLock.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <deque>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class WorkStealingThreadPool
+ * \brief Persistent worker threads that schedule tasks by work stealing.
+ *
+ * Each worker owns a fixed size, lock-free double ended queue (a
+ * Chase-Lev deque).  A worker pushes and pops tasks at the bottom of
+ * its own deque, while idle workers steal from the top of the deques of
+ * the other workers.  Tasks submitted from a thread that is not one of
+ * the workers are placed in a shared injection queue.  Workers are
+ * created once and then sleep on a condition variable when no work is
+ * available, so no thread is created or destroyed per execution.
+ *
+ * Tasks are grouped in a TaskGroup.  Wait() returns once all the tasks
+ * of a group have run.  While tasks of the group are still queued, the
+ * waiting thread runs them itself, which keeps nested submissions (a
+ * task that submits and waits on another group) free of deadlocks.
+ * It never runs the tasks of other groups, and it sleeps on the
+ * condition variable once every task of its group has been taken.
+ *
+ * The pool is used by MultiThreader::SingleMethodExecute() when
+ * MultiThreader::SetUseWorkStealing() is on, or globally through
+ * MultiThreader::SetGlobalDefaultUseWorkStealing() or the
+ * ITK_USE_WORKSTEALING environment variable.
+ *
+ * \sa ThreadPool
+ * \ingroup OSSystemObjects
+ * \ingroup ITKCommon
+ */
+class ITKCommon_EXPORT WorkStealingThreadPool : public Object
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef WorkStealingThreadPool   Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer< Self >     Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(WorkStealingThreadPool, Object);
+
+  /** Returns the global instance of the WorkStealingThreadPool */
+  static Pointer New();
+
+  /** Returns the global singleton instance of the WorkStealingThreadPool
+   *
+   * This method is a Singleton and does not have a New method.
+   */
+  static Pointer GetInstance();
+
+  /** \class TaskGroup
+   * \brief Counts the tasks of a submission that have not yet run.
+   * \ingroup ITKCommon */
+  class TaskGroup
+  {
+  public:
+    TaskGroup() : m_NumberOfPendingTasks(0), m_NumberOfQueuedTasks(0) {}
+
+    /** Number of submitted tasks of this group that have not finished. */
+    long GetNumberOfPendingTasks() const { return m_NumberOfPendingTasks; }
+
+  private:
+    friend class WorkStealingThreadPool;
+    volatile long m_NumberOfPendingTasks;
+    /** Number of tasks of this group not yet taken by a thread. */
+    volatile long m_NumberOfQueuedTasks;
+  };
+
+  /** \class Task
+   * \brief A function and its argument to be run by the pool.
+   * \ingroup ITKCommon */
+  struct Task
+  {
+    Task() :
+      m_Function(ITK_NULLPTR),
+      m_UserData(ITK_NULLPTR),
+      m_Group(ITK_NULLPTR)
+    {
+    }
+
+    ThreadFunctionType  m_Function;
+    void               *m_UserData;
+    TaskGroup          *m_Group;
+  };
+
+  /** Make sure at least numberOfWorkers persistent worker threads exist.
+   * Workers are never removed; the count is clamped to ITK_MAX_THREADS. */
+  void InitializeThreads(ThreadIdType numberOfWorkers);
+
+  /** Number of worker threads currently owned by the pool. */
+  ThreadIdType GetNumberOfWorkers() const;
+
+  /** Submit numberOfTasks tasks that all belong to group.  The task
+   * storage must stay valid until Wait() on the group has returned.
+   * When called from a worker thread the tasks are pushed on that
+   * worker's own deque, otherwise on the shared injection queue. */
+  void Submit(Task *tasks, unsigned int numberOfTasks, TaskGroup & group);
+
+  /** Block until every task of group has completed.  The calling thread
+   * runs the queued tasks of group while it waits, but no other task. */
+  void Wait(TaskGroup & group);
+
+  /** Return true if the calling thread is one of the pool's workers. */
+  static bool IsWorkerThread();
+
+protected:
+  WorkStealingThreadPool();
+  virtual ~WorkStealingThreadPool();
+
+  virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  WorkStealingThreadPool(const Self &); // purposely not implemented
+  void operator=(const Self &);         // purposely not implemented
+
+  /** \class WorkerDeque
+   * Fixed capacity Chase-Lev deque. Only the owning worker calls
+   * Push() and Pop(); any thread may call Steal().  When a group is
+   * given, Pop() and Steal() only take a task of that group.
+   * \ingroup ITKCommon */
+  class WorkerDeque
+  {
+  public:
+    itkStaticConstMacro(Capacity, long, 1024);
+
+    WorkerDeque();
+
+    /** Returns false when the deque is full. */
+    bool Push(Task *task);
+    Task * Pop(const TaskGroup *group = ITK_NULLPTR);
+    Task * Steal(const TaskGroup *group = ITK_NULLPTR);
+
+  private:
+    volatile long  m_Top;
+    volatile long  m_Bottom;
+    Task * volatile m_Buffer[Capacity];
+    /** Group of each task of m_Buffer, so that a thief can check the
+     * group of a task without dereferencing it. */
+    TaskGroup * volatile m_Groups[Capacity];
+  };
+
+  struct WorkerInfo
+  {
+    WorkStealingThreadPool *m_Pool;
+    ThreadIdType            m_WorkerId;
+    ThreadProcessIdType     m_ThreadHandle;
+    WorkerDeque             m_Deque;
+  };
+
+  /** Find a task for the given worker (-1 for a non worker thread):
+   * own deque first, then the injection queue, then steal.  When group
+   * is not null, only a task of that group is taken. */
+  Task * FindTask(int workerId, const TaskGroup *group = ITK_NULLPTR);
+
+  /** Run a task and signal its group when it was the last one. */
+  void RunTask(Task *task);
+
+  /** Create one worker thread. Must be called with m_WorkersLock held. */
+  void AddWorker();
+
+  /** Worker thread entry point */
+  static ITK_THREAD_RETURN_TYPE WorkerExecute(void *param);
+
+  /** Workers, indexed by worker id.  Only the first m_NumberOfWorkers
+   * entries are valid; entries are never removed while the pool lives. */
+  WorkerInfo *m_Workers[ITK_MAX_THREADS];
+  volatile long m_NumberOfWorkers;
+  SimpleFastMutexLock m_WorkersLock;
+
+  /** Tasks submitted from threads that are not workers. */
+  std::deque< Task * > m_InjectionQueue;
+  SimpleFastMutexLock  m_InjectionQueueLock;
+
+  /** Number of tasks submitted but not yet taken by a thread. */
+  volatile long m_NumberOfQueuedTasks;
+
+  /** Sleeping threads wait on m_Condition for new tasks or for the
+   * completion of a group. */
+  SimpleMutexLock            m_ConditionLock;
+  ConditionVariable::Pointer m_Condition;
+  bool                       m_ScheduleForDestruction;
+
+  static Pointer             m_Instance;
+  static SimpleFastMutexLock m_InstanceLock;
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,129 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageRegionSplitterScanline.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+ImageRegionSplitterScanline
+::ImageRegionSplitterScanline()
+{
+}
+
+unsigned int
+ImageRegionSplitterScanline
+::ComputeSplits(unsigned int dim,
+                const SizeValueType regionSize[],
+                unsigned int requestedNumber,
+                unsigned int splits[],
+                SizeValueType valuesPerPiece[])
+{
+  for ( unsigned int d = 0; d < dim; ++d )
+    {
+    splits[d] = 1;
+    valuesPerPiece[d] = regionSize[d];
+    }
+
+  // the fastest dimension is only split for one dimensional regions
+  const unsigned int lowestSplitAxis = ( dim > 1 ) ? 1 : 0;
+
+  unsigned int remaining = requestedNumber;
+  unsigned int total = 1;
+  for ( int d = static_cast< int >( dim ) - 1;
+        d >= static_cast< int >( lowestSplitAxis ) && remaining > 1;
+        --d )
+    {
+    if ( regionSize[d] <= 1 )
+      {
+      continue;
+      }
+    const double range = static_cast< double >( regionSize[d] );
+    const unsigned int pieces = static_cast< unsigned int >(
+      std::min( regionSize[d], static_cast< SizeValueType >( remaining ) ) );
+    valuesPerPiece[d] = Math::Ceil< SizeValueType >( range / static_cast< double >( pieces ) );
+    splits[d] = Math::Ceil< unsigned int >( range / static_cast< double >( valuesPerPiece[d] ) );
+
+    total *= splits[d];
+    remaining /= splits[d];
+    }
+  return total;
+}
+
+unsigned int
+ImageRegionSplitterScanline
+::GetNumberOfSplitsInternal(unsigned int dim,
+                            const IndexValueType itkNotUsed(regionIndex)[],
+                            const SizeValueType regionSize[],
+                            unsigned int requestedNumber) const
+{
+  std::vector< unsigned int >  splits(dim);
+  std::vector< SizeValueType > valuesPerPiece(dim);
+  return ComputeSplits( dim, regionSize, requestedNumber, &splits[0], &valuesPerPiece[0] );
+}
+
+unsigned int
+ImageRegionSplitterScanline
+::GetSplitInternal(unsigned int dim,
+                   unsigned int i,
+                   unsigned int numberOfPieces,
+                   IndexValueType regionIndex[],
+                   SizeValueType regionSize[]) const
+{
+  std::vector< unsigned int >  splits(dim);
+  std::vector< SizeValueType > valuesPerPiece(dim);
+  const unsigned int total = ComputeSplits( dim, regionSize, numberOfPieces, &splits[0], &valuesPerPiece[0] );
+
+  if ( i >= total )
+    {
+    itkDebugMacro("  Piece " << i << " out of " << total << " pieces");
+    return total;
+    }
+
+  // The lowest split dimension varies fastest with i, so that
+  // consecutive pieces are adjacent in memory.
+  unsigned int remainder = i;
+  for ( unsigned int d = 0; d < dim; ++d )
+    {
+    if ( splits[d] == 1 )
+      {
+      continue;
+      }
+    const SizeValueType pieceIndex = remainder % splits[d];
+    remainder /= splits[d];
+
+    const SizeValueType offset = pieceIndex * valuesPerPiece[d];
+    regionIndex[d] += static_cast< IndexValueType >( offset );
+    if ( pieceIndex + 1 < splits[d] )
+      {
+      regionSize[d] = valuesPerPiece[d];
+      }
+    else
+      {
+      // last piece needs to process the "rest" dimension being split
+      regionSize[d] = regionSize[d] - offset;
+      }
+    }
+
+  return total;
+}
+
+}
@@ -17,6 +17,7 @@
  *=========================================================================*/
 
 #include "itkImageRegionSplitterSlowDimension.h"
+#include "itkImageRegionSplitterScanline.h"
 #include "itkImageSourceCommon.h"
 #include "itkSimpleFastMutexLock.h"
 #include "itkMutexLockHolder.h"
@@ -28,6 +29,7 @@ namespace
 {
 SimpleFastMutexLock globalDefaultSplitterLock;
 ImageRegionSplitterBase::Pointer globalDefaultSplitter;
+ImageRegionSplitterBase::Pointer globalDynamicSplitter;
 }
 
 const ImageRegionSplitterBase*  ImageSourceCommon::GetGlobalDefaultSplitter(void)
@@ -45,5 +47,18 @@ const ImageRegionSplitterBase*  ImageSourceCommon::GetGlobalDefaultSplitter(void
   return globalDefaultSplitter;
 }
 
+const ImageRegionSplitterBase*  ImageSourceCommon::GetGlobalDynamicSplitter(void)
+{
+  if ( globalDynamicSplitter.IsNull() )
+    {
+    MutexLockHolder< SimpleFastMutexLock > lock(globalDefaultSplitterLock);
+    if ( globalDynamicSplitter.IsNull() )
+      {
+      globalDynamicSplitter = ImageRegionSplitterScanline::New().GetPointer();
+      }
+    }
+  return globalDynamicSplitter;
+}
+
 
 }
@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMemoryMappedFile.h"
+
+#if defined( _WIN32 )
+#include "itkWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+MemoryMappedFile
+::MemoryMappedFile() :
+  m_Data(ITK_NULLPTR),
+  m_Length(0),
+  m_MappingAddress(ITK_NULLPTR),
+  m_MappingLength(0)
+#if defined( _WIN32 )
+  , m_MappingHandle(ITK_NULLPTR)
+#endif
+{
+}
+
+MemoryMappedFile
+::~MemoryMappedFile()
+{
+  this->Unmap();
+}
+
+bool
+MemoryMappedFile
+::Map(const std::string & fileName, OffsetType offset, size_t length)
+{
+  this->Unmap();
+
+  if ( length == 0 )
+    {
+    return false;
+    }
+
+#if defined( _WIN32 )
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  const OffsetType alignedOffset = offset - offset % systemInfo.dwAllocationGranularity;
+  const size_t     mappingLength = length + static_cast< size_t >( offset - alignedOffset );
+
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, ITK_NULLPTR,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, ITK_NULLPTR);
+  if ( file == INVALID_HANDLE_VALUE )
+    {
+    return false;
+    }
+
+  LARGE_INTEGER fileSize;
+  if ( !GetFileSizeEx(file, &fileSize)
+       || static_cast< OffsetType >( fileSize.QuadPart ) < offset + length )
+    {
+    CloseHandle(file);
+    return false;
+    }
+
+  // the mapping object keeps the file open
+  HANDLE mapping = CreateFileMappingA(file, ITK_NULLPTR, PAGE_WRITECOPY, 0, 0, ITK_NULLPTR);
+  CloseHandle(file);
+  if ( mapping == ITK_NULLPTR )
+    {
+    return false;
+    }
+
+  void *address = MapViewOfFile( mapping, FILE_MAP_COPY,
+                                 static_cast< DWORD >( alignedOffset >> 32 ),
+                                 static_cast< DWORD >( alignedOffset & 0xffffffff ),
+                                 mappingLength );
+  if ( address == ITK_NULLPTR )
+    {
+    CloseHandle(mapping);
+    return false;
+    }
+  m_MappingHandle = mapping;
+#else
+  const OffsetType alignedOffset = offset - offset % static_cast< OffsetType >( sysconf(_SC_PAGESIZE) );
+  const size_t     mappingLength = length + static_cast< size_t >( offset - alignedOffset );
+
+  const int file = open(fileName.c_str(), O_RDONLY);
+  if ( file < 0 )
+    {
+    return false;
+    }
+
+  // mapping past the end of the file would fault on access
+  struct stat fileStatus;
+  if ( fstat(file, &fileStatus) != 0
+       || static_cast< OffsetType >( fileStatus.st_size ) < offset + length )
+    {
+    close(file);
+    return false;
+    }
+
+  // the mapping keeps a reference to the file
+  void *address = mmap(ITK_NULLPTR, mappingLength, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       file, static_cast< off_t >( alignedOffset ));
+  close(file);
+  if ( address == MAP_FAILED )
+    {
+    return false;
+    }
+#endif
+
+  m_MappingAddress = address;
+  m_MappingLength = mappingLength;
+  m_Data = static_cast< char * >( address ) + ( offset - alignedOffset );
+  m_Length = length;
+  return true;
+}
+
+void
+MemoryMappedFile
+::Unmap()
+{
+  if ( m_MappingAddress == ITK_NULLPTR )
+    {
+    return;
+    }
+#if defined( _WIN32 )
+  UnmapViewOfFile(m_MappingAddress);
+  CloseHandle(m_MappingHandle);
+  m_MappingHandle = ITK_NULLPTR;
+#else
+  munmap(m_MappingAddress, m_MappingLength);
+#endif
+  m_MappingAddress = ITK_NULLPTR;
+  m_MappingLength = 0;
+  m_Data = ITK_NULLPTR;
+  m_Length = 0;
+}
+
+void
+MemoryMappedFile
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Data: " << m_Data << std::endl;
+  os << indent << "Length: " << m_Length << std::endl;
+}
+} // end namespace itk
@@ -97,6 +97,271 @@ bool MultiThreader::GetGlobalDefaultUseThreadPool( )
   return m_GlobalDefaultUseThreadPool;
   }
 
+// GlobalDefaultUseWorkStealingIsInitialized plays the same role for the
+// ITK_USE_WORKSTEALING environmental variable.
+static bool GlobalDefaultUseWorkStealingIsInitialized=false;
+
+bool MultiThreader::m_GlobalDefaultUseWorkStealing = false;
+
+void MultiThreader::SetGlobalDefaultUseWorkStealing( const bool GlobalDefaultUseWorkStealing )
+  {
+  m_GlobalDefaultUseWorkStealing = GlobalDefaultUseWorkStealing;
+  GlobalDefaultUseWorkStealingIsInitialized=true;
+  }
+
+bool MultiThreader::GetGlobalDefaultUseWorkStealing( )
+  {
+  // This method must be concurrent thread safe
+
+  if( !GlobalDefaultUseWorkStealingIsInitialized )
+    {
+
+    MutexLockHolder< SimpleFastMutexLock > lock(globalDefaultInitializerLock);
+
+    // After we have the lock, double check the initialization
+    // flag to ensure it hasn't been changed by another thread.
+
+    if (!GlobalDefaultUseWorkStealingIsInitialized )
+      {
+      // look for runtime request to use work stealing
+      std::string use_workstealing;
+
+      if( itksys::SystemTools::GetEnv("ITK_USE_WORKSTEALING",use_workstealing) )
+        {
+
+        use_workstealing = itksys::SystemTools::UpperCase(use_workstealing);
+
+        // NOTE: GlobalDefaultUseWorkStealingIsInitialized=true after this call
+        if(use_workstealing != "NO" && use_workstealing != "OFF" && use_workstealing != "FALSE")
+          {
+          MultiThreader::SetGlobalDefaultUseWorkStealing( true );
+          }
+        else
+          {
+          MultiThreader::SetGlobalDefaultUseWorkStealing( false );
+          }
+        }
+
+      // always set that we are initialized
+      GlobalDefaultUseWorkStealingIsInitialized=true;
+      }
+    }
+  return m_GlobalDefaultUseWorkStealing;
+  }
+
+// GlobalThreadBudgetIsInitialized plays the same role for the
+// ITK_GLOBAL_THREAD_BUDGET environmental variable.
+static bool GlobalThreadBudgetIsInitialized=false;
+
+ThreadIdType MultiThreader::m_GlobalThreadBudget = 0;
+
+namespace
+{
+// Threads currently charged to the budget, and number of top level
+// leases alive. Both are protected by globalThreadBudgetLock.
+ThreadIdType        globalNumberOfActiveThreads = 0;
+ThreadIdType        globalNumberOfTopLevelLeases = 0;
+SimpleFastMutexLock globalThreadBudgetLock;
+
+// Thread local storage of the innermost budget state of the calling
+// thread: ITK_NULLPTR, the ThreadBudgetLease held by the thread, or
+// &executorMarker while the thread runs SingleMethodExecute pieces.
+char executorMarker;
+
+#if defined( ITK_USE_PTHREADS )
+pthread_key_t  budgetStateKey;
+pthread_once_t budgetStateKeyOnce = PTHREAD_ONCE_INIT;
+
+extern "C" void CreateBudgetStateKey()
+{
+  pthread_key_create(&budgetStateKey, ITK_NULLPTR);
+}
+
+inline void SetCurrentBudgetState(void *state)
+{
+  pthread_once(&budgetStateKeyOnce, &CreateBudgetStateKey);
+  pthread_setspecific(budgetStateKey, state);
+}
+
+inline void * GetCurrentBudgetState()
+{
+  pthread_once(&budgetStateKeyOnce, &CreateBudgetStateKey);
+  return pthread_getspecific(budgetStateKey);
+}
+#elif defined( ITK_USE_WIN32_THREADS )
+DWORD               budgetStateIndex = TLS_OUT_OF_INDEXES;
+SimpleFastMutexLock budgetStateIndexLock;
+
+inline DWORD GetBudgetStateIndex()
+{
+  if( budgetStateIndex == TLS_OUT_OF_INDEXES )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(budgetStateIndexLock);
+    if( budgetStateIndex == TLS_OUT_OF_INDEXES )
+      {
+      budgetStateIndex = TlsAlloc();
+      }
+    }
+  return budgetStateIndex;
+}
+
+inline void SetCurrentBudgetState(void *state)
+{
+  TlsSetValue(GetBudgetStateIndex(), state);
+}
+
+inline void * GetCurrentBudgetState()
+{
+  return TlsGetValue( GetBudgetStateIndex() );
+}
+#else
+void *budgetState = ITK_NULLPTR;
+
+inline void SetCurrentBudgetState(void *state)
+{
+  budgetState = state;
+}
+
+inline void * GetCurrentBudgetState()
+{
+  return budgetState;
+}
+#endif
+
+// Marks the calling thread as running SingleMethodExecute pieces for
+// the lifetime of the object.
+class ExecutorScope
+{
+public:
+  ExecutorScope() :
+    m_Previous( GetCurrentBudgetState() )
+  {
+    SetCurrentBudgetState(&executorMarker);
+  }
+
+  ~ExecutorScope()
+  {
+    SetCurrentBudgetState(m_Previous);
+  }
+
+private:
+  void *m_Previous;
+};
+} // end anonymous namespace
+
+void MultiThreader::SetGlobalThreadBudget(ThreadIdType val)
+{
+  m_GlobalThreadBudget = vcl_min( val, (ThreadIdType) ITK_MAX_THREADS );
+  GlobalThreadBudgetIsInitialized=true;
+}
+
+ThreadIdType MultiThreader::GetGlobalThreadBudget()
+{
+  // This method must be concurrent thread safe
+
+  if( !GlobalThreadBudgetIsInitialized )
+    {
+    MutexLockHolder< SimpleFastMutexLock > lock(globalDefaultInitializerLock);
+
+    if( !GlobalThreadBudgetIsInitialized )
+      {
+      std::string threadBudget;
+      if( itksys::SystemTools::GetEnv("ITK_GLOBAL_THREAD_BUDGET",threadBudget) )
+        {
+        const int val = atoi( threadBudget.c_str() );
+        MultiThreader::SetGlobalThreadBudget( val > 0 ? static_cast< ThreadIdType >( val ) : 0 );
+        }
+
+      // always set that we are initialized
+      GlobalThreadBudgetIsInitialized=true;
+      }
+    }
+  return m_GlobalThreadBudget;
+}
+
+ThreadIdType MultiThreader::GetGlobalNumberOfActiveThreads()
+{
+  MutexLockHolder< SimpleFastMutexLock > lock(globalThreadBudgetLock);
+  return globalNumberOfActiveThreads;
+}
+
+MultiThreader::ThreadBudgetLease::ThreadBudgetLease(ThreadIdType numberOfThreads, bool reduceTopLevel) :
+  m_NumberOfThreads( vcl_max( numberOfThreads, NumericTraits< ThreadIdType >::OneValue() ) ),
+  m_NumberOfChargedThreads(0),
+  m_Active(false),
+  m_TopLevel(false),
+  m_Previous(ITK_NULLPTR)
+{
+  const ThreadIdType budget = MultiThreader::GetGlobalThreadBudget();
+  if( budget == 0 )
+    {
+    return;
+    }
+
+  m_Active = true;
+  m_Previous = GetCurrentBudgetState();
+
+  MutexLockHolder< SimpleFastMutexLock > lock(globalThreadBudgetLock);
+  const ThreadIdType available =
+    budget > globalNumberOfActiveThreads ? budget - globalNumberOfActiveThreads : 0;
+  if( m_Previous == &executorMarker )
+    {
+    // The calling thread is already charged by the execution it is part
+    // of; only the threads that are still free can be added to it.
+    m_NumberOfChargedThreads = vcl_min( m_NumberOfThreads - 1, available );
+    m_NumberOfThreads = m_NumberOfChargedThreads + 1;
+    }
+  else if( m_Previous != ITK_NULLPTR )
+    {
+    // The calling thread already holds a lease, which is not running
+    // anything while this one is alive: share it. Without
+    // reduceTopLevel the number of threads was not chosen from the
+    // outer lease, so all of them are kept and the extra ones charged.
+    const ThreadIdType shared = static_cast< ThreadBudgetLease * >( m_Previous )->m_NumberOfThreads;
+    if( reduceTopLevel || m_NumberOfThreads <= shared )
+      {
+      m_NumberOfThreads = vcl_min( m_NumberOfThreads, shared );
+      }
+    else
+      {
+      m_NumberOfChargedThreads = m_NumberOfThreads - shared;
+      }
+    }
+  else
+    {
+    m_TopLevel = true;
+    ++globalNumberOfTopLevelLeases;
+    if( reduceTopLevel )
+      {
+      const ThreadIdType fairShare = vcl_max( budget / globalNumberOfTopLevelLeases,
+                                              NumericTraits< ThreadIdType >::OneValue() );
+      m_NumberOfThreads = vcl_min( m_NumberOfThreads, fairShare );
+      m_NumberOfThreads = vcl_min( m_NumberOfThreads,
+                                   vcl_max( available, NumericTraits< ThreadIdType >::OneValue() ) );
+      }
+    m_NumberOfChargedThreads = m_NumberOfThreads;
+    }
+  globalNumberOfActiveThreads += m_NumberOfChargedThreads;
+
+  SetCurrentBudgetState(this);
+}
+
+MultiThreader::ThreadBudgetLease::~ThreadBudgetLease()
+{
+  if( !m_Active )
+    {
+    return;
+    }
+
+  MutexLockHolder< SimpleFastMutexLock > lock(globalThreadBudgetLock);
+  globalNumberOfActiveThreads -= m_NumberOfChargedThreads;
+  if( m_TopLevel )
+    {
+    --globalNumberOfTopLevelLeases;
+    }
+  SetCurrentBudgetState(m_Previous);
+}
+
 // Initialize static member that controls global maximum number of threads.
 ThreadIdType MultiThreader::m_GlobalMaximumNumberOfThreads = ITK_MAX_THREADS;
 
@@ -238,7 +503,8 @@ ThreadIdType MultiThreader::GetGlobalDefaultNumberOfThreads()
 
 MultiThreader::MultiThreader() :
   m_ThreadPool(ThreadPool::GetInstance() ),
-  m_UseThreadPool( MultiThreader::GetGlobalDefaultUseThreadPool() )
+  m_UseThreadPool( MultiThreader::GetGlobalDefaultUseThreadPool() ),
+  m_UseWorkStealing( MultiThreader::GetGlobalDefaultUseWorkStealing() )
 {
   for( ThreadIdType i = 0; i < ITK_MAX_THREADS; ++i )
     {
@@ -252,6 +518,10 @@ MultiThreader::MultiThreader() :
     m_SpawnedThreadActiveFlag[i]            = 0;
     m_SpawnedThreadActiveFlagLock[i]        = ITK_NULLPTR;
     m_SpawnedThreadInfoArray[i].ThreadID    = i;
+
+    m_ExecutorInfoArray[i].ThreadID         = i;
+    m_ExecutorInfoArray[i].ActiveFlag       = ITK_NULLPTR;
+    m_ExecutorInfoArray[i].ActiveFlagLock   = ITK_NULLPTR;
     }
 
   m_SingleMethod = ITK_NULLPTR;
@@ -304,6 +574,22 @@ void MultiThreader::SingleMethodExecute()
   // obey the global maximum number of threads limit
   m_NumberOfThreads = vcl_min( m_GlobalMaximumNumberOfThreads, m_NumberOfThreads );
 
+  // obey the global thread budget. An execution that is not nested in
+  // another one keeps all its threads, since its pieces may synchronize
+  // with each other, but they are charged to the budget.
+  const ThreadBudgetLease lease(m_NumberOfThreads, false);
+  if( lease.GetActive() )
+    {
+    this->BudgetedSingleMethodExecute( lease.GetNumberOfThreads() );
+    return;
+    }
+
+  if( m_UseWorkStealing )
+    {
+    this->WorkStealingSingleMethodExecute();
+    return;
+    }
+
   // Spawn a set of threads through the SingleMethodProxy. Exceptions
   // thrown from a thread will be caught by the SingleMethodProxy. A
   // naive mechanism is in place for determining whether a thread
@@ -418,6 +704,253 @@ void MultiThreader::SingleMethodExecute()
     }
 }
 
+void
+MultiThreader
+::WorkStealingSingleMethodExecute()
+{
+  if( m_WorkStealingThreadPool.IsNull() )
+    {
+    m_WorkStealingThreadPool = WorkStealingThreadPool::GetInstance();
+    }
+
+  // The calling thread runs the first piece, so N-1 workers are enough
+  // to run all the pieces concurrently.
+  m_WorkStealingThreadPool->InitializeThreads(m_NumberOfThreads - 1);
+
+  WorkStealingThreadPool::TaskGroup       group;
+  std::vector< WorkStealingThreadPool::Task > tasks( m_NumberOfThreads > 1 ? m_NumberOfThreads - 1 : 0 );
+  for( ThreadIdType thread_loop = 1; thread_loop < m_NumberOfThreads; ++thread_loop )
+    {
+    m_ThreadInfoArray[thread_loop].UserData    = m_SingleData;
+    m_ThreadInfoArray[thread_loop].NumberOfThreads = m_NumberOfThreads;
+    m_ThreadInfoArray[thread_loop].ThreadFunction = m_SingleMethod;
+    m_ThreadInfoArray[thread_loop].ThreadExitCode = ThreadInfoStruct::SUCCESS;
+
+    tasks[thread_loop - 1].m_Function = this->SingleMethodProxy;
+    tasks[thread_loop - 1].m_UserData = &m_ThreadInfoArray[thread_loop];
+    }
+  if( !tasks.empty() )
+    {
+    m_WorkStealingThreadPool->Submit(&tasks[0], static_cast< unsigned int >( tasks.size() ), group);
+    }
+
+  // Now, the parent thread calls this->SingleMethod() itself. The
+  // tasks reference m_ThreadInfoArray, so they must all have completed
+  // before any exception leaves this method.
+  bool        exceptionOccurred = false;
+  std::string exceptionDetails;
+  try
+    {
+    m_ThreadInfoArray[0].UserData = m_SingleData;
+    m_ThreadInfoArray[0].NumberOfThreads = m_NumberOfThreads;
+    m_SingleMethod( (void *)( &m_ThreadInfoArray[0] ) );
+    }
+  catch( ProcessAborted & )
+    {
+    m_WorkStealingThreadPool->Wait(group);
+    throw;
+    }
+  catch( std::exception & e )
+    {
+    // get the details of the exception to rethrow them
+    exceptionDetails = e.what();
+    exceptionOccurred = true;
+    }
+  catch( ... )
+    {
+    exceptionOccurred = true;
+    }
+
+  m_WorkStealingThreadPool->Wait(group);
+
+  for( ThreadIdType thread_loop = 1; thread_loop < m_NumberOfThreads; ++thread_loop )
+    {
+    if( m_ThreadInfoArray[thread_loop].ThreadExitCode != ThreadInfoStruct::SUCCESS )
+      {
+      exceptionOccurred = true;
+      }
+    }
+
+  if( exceptionOccurred )
+    {
+    if( exceptionDetails.empty() )
+      {
+      itkExceptionMacro("Exception occurred during SingleMethodExecute");
+      }
+    else
+      {
+      itkExceptionMacro(<< "Exception occurred during SingleMethodExecute" << std::endl << exceptionDetails);
+      }
+    }
+}
+
+void
+MultiThreader
+::BudgetedSingleMethodExecute(ThreadIdType numberOfExecutors)
+{
+  for( ThreadIdType thread_loop = 0; thread_loop < m_NumberOfThreads; ++thread_loop )
+    {
+    m_ThreadInfoArray[thread_loop].UserData    = m_SingleData;
+    m_ThreadInfoArray[thread_loop].NumberOfThreads = m_NumberOfThreads;
+    m_ThreadInfoArray[thread_loop].ThreadFunction = m_SingleMethod;
+    m_ThreadInfoArray[thread_loop].ThreadExitCode = ThreadInfoStruct::SUCCESS;
+    }
+  for( ThreadIdType executor = 0; executor < numberOfExecutors; ++executor )
+    {
+    m_ExecutorInfoArray[executor].UserData    = this;
+    m_ExecutorInfoArray[executor].NumberOfThreads = numberOfExecutors;
+    m_ExecutorInfoArray[executor].ThreadFunction = this->ExecutorProxy;
+    m_ExecutorInfoArray[executor].ThreadExitCode = ThreadInfoStruct::SUCCESS;
+    }
+
+  // Start the executors 1..E-1, either on the work stealing pool, where
+  // a nested execution shares the workers of the outer one, or through
+  // the usual dispatch.
+  bool        exceptionOccurred = false;
+  std::string exceptionDetails;
+
+  WorkStealingThreadPool::TaskGroup           group;
+  std::vector< WorkStealingThreadPool::Task > tasks;
+  ThreadProcessIdType                         process_id[ITK_MAX_THREADS];
+  ThreadIdType                                numberOfDispatched = 1;
+  if( m_UseWorkStealing )
+    {
+    if( m_WorkStealingThreadPool.IsNull() )
+      {
+      m_WorkStealingThreadPool = WorkStealingThreadPool::GetInstance();
+      }
+    m_WorkStealingThreadPool->InitializeThreads(numberOfExecutors - 1);
+
+    tasks.resize(numberOfExecutors - 1);
+    for( ThreadIdType executor = 1; executor < numberOfExecutors; ++executor )
+      {
+      tasks[executor - 1].m_Function = this->SingleMethodProxy;
+      tasks[executor - 1].m_UserData = &m_ExecutorInfoArray[executor];
+      }
+    if( !tasks.empty() )
+      {
+      m_WorkStealingThreadPool->Submit(&tasks[0], static_cast< unsigned int >( tasks.size() ), group);
+      }
+    }
+  else
+    {
+    try
+      {
+      for(; numberOfDispatched < numberOfExecutors; ++numberOfDispatched )
+        {
+        process_id[numberOfDispatched] =
+          this->DispatchSingleMethodThread(&m_ExecutorInfoArray[numberOfDispatched]);
+        }
+      }
+    catch( std::exception & e )
+      {
+      exceptionDetails = e.what();
+      exceptionOccurred = true;
+      }
+    catch( ... )
+      {
+      exceptionOccurred = true;
+      }
+    }
+
+  // The parent thread is the first executor. Its first piece is run
+  // here so that the details of its exceptions are kept.
+  try
+    {
+    const ExecutorScope scope;
+    m_SingleMethod( (void *)( &m_ThreadInfoArray[0] ) );
+    }
+  catch( ProcessAborted & )
+    {
+    m_ThreadInfoArray[0].ThreadExitCode = ThreadInfoStruct::ITK_PROCESS_ABORTED_EXCEPTION;
+    }
+  catch( std::exception & e )
+    {
+    exceptionDetails = e.what();
+    exceptionOccurred = true;
+    }
+  catch( ... )
+    {
+    exceptionOccurred = true;
+    }
+  if( m_ThreadInfoArray[0].ThreadExitCode == ThreadInfoStruct::SUCCESS )
+    {
+    const ExecutorScope scope;
+    for( ThreadIdType thread_loop = numberOfExecutors; thread_loop < m_NumberOfThreads;
+         thread_loop += numberOfExecutors )
+      {
+      this->SingleMethodProxy( &m_ThreadInfoArray[thread_loop] );
+      }
+    }
+
+  // Wait for the other executors
+  if( m_UseWorkStealing )
+    {
+    m_WorkStealingThreadPool->Wait(group);
+    }
+  else
+    {
+    for( ThreadIdType executor = 1; executor < numberOfDispatched; ++executor )
+      {
+      try
+        {
+        this->WaitForSingleMethodThread(process_id[executor]);
+        }
+      catch( std::exception & e )
+        {
+        exceptionDetails = e.what();
+        exceptionOccurred = true;
+        }
+      catch( ... )
+        {
+        exceptionOccurred = true;
+        }
+      }
+    }
+
+  if( m_ThreadInfoArray[0].ThreadExitCode == ThreadInfoStruct::ITK_PROCESS_ABORTED_EXCEPTION )
+    {
+    throw ProcessAborted(__FILE__, __LINE__);
+    }
+  for( ThreadIdType thread_loop = 0; thread_loop < m_NumberOfThreads; ++thread_loop )
+    {
+    if( m_ThreadInfoArray[thread_loop].ThreadExitCode != ThreadInfoStruct::SUCCESS )
+      {
+      exceptionOccurred = true;
+      }
+    }
+
+  if( exceptionOccurred )
+    {
+    if( exceptionDetails.empty() )
+      {
+      itkExceptionMacro("Exception occurred during SingleMethodExecute");
+      }
+    else
+      {
+      itkExceptionMacro(<< "Exception occurred during SingleMethodExecute" << std::endl << exceptionDetails);
+      }
+    }
+}
+
+ITK_THREAD_RETURN_TYPE
+MultiThreader
+::ExecutorProxy(void *arg)
+{
+  const ThreadInfoStruct *executorInfo = reinterpret_cast< ThreadInfoStruct * >( arg );
+  MultiThreader          *threader = reinterpret_cast< MultiThreader * >( executorInfo->UserData );
+
+  // the pieces catch their own exceptions
+  const ExecutorScope scope;
+  for( ThreadIdType thread_loop = executorInfo->ThreadID; thread_loop < threader->m_NumberOfThreads;
+       thread_loop += executorInfo->NumberOfThreads )
+    {
+    threader->SingleMethodProxy( &threader->m_ThreadInfoArray[thread_loop] );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 ITK_THREAD_RETURN_TYPE
 MultiThreader
 ::SingleMethodProxy(void *arg)
@@ -487,10 +1020,14 @@ void MultiThreader::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
 
   os << indent << "Thread Count: " << m_NumberOfThreads << "\n";
+  os << indent << "UseThreadPool: " << m_UseThreadPool << "\n";
+  os << indent << "UseWorkStealing: " << m_UseWorkStealing << "\n";
   os << indent << "Global Maximum Number Of Threads: "
      << m_GlobalMaximumNumberOfThreads << std::endl;
   os << indent << "Global Default Number Of Threads: "
      << m_GlobalDefaultNumberOfThreads << std::endl;
+  os << indent << "Global Thread Budget: "
+     << m_GlobalThreadBudget << std::endl;
 }
 
 }
@@ -27,6 +27,7 @@
  *=========================================================================*/
 #include "itkProcessObject.h"
 #include "itkMutexLockHolder.h"
+#include "itkTraceEventRecorder.h"
 
 #include <stdio.h>
 #include <sstream>
@@ -1734,8 +1735,19 @@ ProcessObject
   m_AbortGenerateData = false;
   m_Progress = 0.0f;
 
+  /**
+   * Lease threads from the global thread budget, if there is one, for
+   * the duration of GenerateData(). m_NumberOfThreads is left untouched:
+   * code that chooses its number of threads from the lease (as
+   * ImageSource does with DynamicMultiThreading) runs with the threads
+   * that were granted.
+   */
+  const MultiThreader::ThreadBudgetLease threadBudgetLease(m_NumberOfThreads);
+
   try
     {
+    TraceEventRecorder::Scope traceEvent( "filter", this->GetNameOfClass() );
+    traceEvent.SetArgument( 0, "threads", threadBudgetLease.GetNumberOfThreads() );
     this->GenerateData();
     }
   catch ( ProcessAborted & )
@@ -0,0 +1,342 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkTraceEventRecorder.h"
+#include "itkMutexLockHolder.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itksys/SystemTools.hxx"
+
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#if defined( ITK_USE_PTHREADS )
+#include <pthread.h>
+#elif defined( ITK_USE_WIN32_THREADS )
+#include "itkWindows.h"
+#endif
+
+namespace itk
+{
+bool TraceEventRecorder::m_Enabled = false;
+
+namespace
+{
+struct TraceEvent
+{
+  const char   *Category;
+  std::string   Name;
+  char          Phase;
+  double        Start;
+  double        Duration;
+  SizeValueType Thread;
+  const char   *ArgumentName[2];
+  double        ArgumentValue[2];
+};
+
+// State of the recorder. The single instance is created at static
+// initialization, where it reads ITK_TRACE_EVENTS, and writes the
+// trace file, if any, at static destruction.
+class TraceEventRecorderGlobals
+{
+public:
+  TraceEventRecorderGlobals() :
+    m_StartTime( itksys::SystemTools::GetTime() ),
+    m_NumberOfThreads(0)
+  {
+    if ( itksys::SystemTools::GetEnv("ITK_TRACE_EVENTS", m_FileName) && !m_FileName.empty() )
+      {
+      TraceEventRecorder::SetEnabled(true);
+      }
+  }
+
+  ~TraceEventRecorderGlobals()
+  {
+    TraceEventRecorder::SetEnabled(false);
+    if ( !m_FileName.empty() )
+      {
+      TraceEventRecorder::WriteChromeTrace(m_FileName);
+      }
+  }
+
+  double                    m_StartTime;
+  std::string               m_FileName;
+  SimpleFastMutexLock       m_Lock;
+  std::vector< TraceEvent > m_Events;
+  SizeValueType             m_NumberOfThreads;
+};
+
+TraceEventRecorderGlobals globals;
+
+// Thread local storage of the index of the calling thread in the
+// trace, plus one so that zero means not assigned yet.
+#if defined( ITK_USE_PTHREADS )
+pthread_key_t  traceThreadKey;
+pthread_once_t traceThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+extern "C" void CreateTraceThreadKey()
+{
+  pthread_key_create(&traceThreadKey, ITK_NULLPTR);
+}
+
+inline void SetTraceThreadState(void *state)
+{
+  pthread_once(&traceThreadKeyOnce, &CreateTraceThreadKey);
+  pthread_setspecific(traceThreadKey, state);
+}
+
+inline void * GetTraceThreadState()
+{
+  pthread_once(&traceThreadKeyOnce, &CreateTraceThreadKey);
+  return pthread_getspecific(traceThreadKey);
+}
+#elif defined( ITK_USE_WIN32_THREADS )
+DWORD               traceThreadIndex = TLS_OUT_OF_INDEXES;
+SimpleFastMutexLock traceThreadIndexLock;
+
+inline DWORD GetTraceThreadIndex()
+{
+  if ( traceThreadIndex == TLS_OUT_OF_INDEXES )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(traceThreadIndexLock);
+    if ( traceThreadIndex == TLS_OUT_OF_INDEXES )
+      {
+      traceThreadIndex = TlsAlloc();
+      }
+    }
+  return traceThreadIndex;
+}
+
+inline void SetTraceThreadState(void *state)
+{
+  TlsSetValue(GetTraceThreadIndex(), state);
+}
+
+inline void * GetTraceThreadState()
+{
+  return TlsGetValue( GetTraceThreadIndex() );
+}
+#else
+void *traceThreadState = ITK_NULLPTR;
+
+inline void SetTraceThreadState(void *state)
+{
+  traceThreadState = state;
+}
+
+inline void * GetTraceThreadState()
+{
+  return traceThreadState;
+}
+#endif
+
+// Must be called with globals.m_Lock held.
+SizeValueType GetTraceThread()
+{
+  SizeValueType thread = static_cast< SizeValueType >( reinterpret_cast< size_t >( GetTraceThreadState() ) );
+  if ( thread == 0 )
+    {
+    thread = ++globals.m_NumberOfThreads;
+    SetTraceThreadState( reinterpret_cast< void * >( static_cast< size_t >( thread ) ) );
+    }
+  return thread - 1;
+}
+
+void RecordEvent(const char *category, const std::string & name, char phase,
+                 double start, double duration,
+                 const char *argumentName0, double argumentValue0,
+                 const char *argumentName1, double argumentValue1)
+{
+  TraceEvent event;
+  event.Category = category;
+  event.Name = name;
+  event.Phase = phase;
+  event.Start = start;
+  event.Duration = duration;
+  event.ArgumentName[0] = argumentName0;
+  event.ArgumentValue[0] = argumentValue0;
+  event.ArgumentName[1] = argumentName1;
+  event.ArgumentValue[1] = argumentValue1;
+
+  MutexLockHolder< SimpleFastMutexLock > holder(globals.m_Lock);
+  event.Thread = GetTraceThread();
+  globals.m_Events.push_back(event);
+}
+
+void WriteString(std::ostream & os, const std::string & text)
+{
+  os << '"';
+  for ( std::string::const_iterator it = text.begin(); it != text.end(); ++it )
+    {
+    const unsigned char c = static_cast< unsigned char >( *it );
+    if ( c == '"' || c == '\\' )
+      {
+      os << '\\' << *it;
+      }
+    else if ( c < 0x20 )
+      {
+      os << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+      }
+    else
+      {
+      os << *it;
+      }
+    }
+  os << '"';
+}
+} // end anonymous namespace
+
+void
+TraceEventRecorder
+::SetEnabled(bool enabled)
+{
+  m_Enabled = enabled;
+}
+
+double
+TraceEventRecorder
+::GetTimeStamp()
+{
+  return ( itksys::SystemTools::GetTime() - globals.m_StartTime ) * 1e6;
+}
+
+void
+TraceEventRecorder
+::RecordCompleteEvent(const char *category,
+                      const std::string & name,
+                      double start,
+                      double duration,
+                      const char *argumentName0,
+                      double argumentValue0,
+                      const char *argumentName1,
+                      double argumentValue1)
+{
+  if ( !m_Enabled )
+    {
+    return;
+    }
+  RecordEvent(category, name, 'X', start, duration,
+              argumentName0, argumentValue0, argumentName1, argumentValue1);
+}
+
+void
+TraceEventRecorder
+::RecordInstantEvent(const char *category,
+                     const std::string & name,
+                     const char *argumentName0,
+                     double argumentValue0,
+                     const char *argumentName1,
+                     double argumentValue1)
+{
+  if ( !m_Enabled )
+    {
+    return;
+    }
+  RecordEvent(category, name, 'i', GetTimeStamp(), 0.0,
+              argumentName0, argumentValue0, argumentName1, argumentValue1);
+}
+
+SizeValueType
+TraceEventRecorder
+::GetNumberOfEvents()
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(globals.m_Lock);
+  return static_cast< SizeValueType >( globals.m_Events.size() );
+}
+
+void
+TraceEventRecorder
+::Clear()
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(globals.m_Lock);
+  globals.m_Events.clear();
+}
+
+void
+TraceEventRecorder
+::WriteChromeTrace(std::ostream & os)
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(globals.m_Lock);
+
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize    precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for ( SizeValueType thread = 0; thread < globals.m_NumberOfThreads; ++thread )
+    {
+    os << ( thread == 0 ? "\n" : ",\n" )
+       << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread
+       << ", \"args\": {\"name\": \"Thread " << thread << "\"}}";
+    }
+  for ( std::vector< TraceEvent >::const_iterator it = globals.m_Events.begin();
+        it != globals.m_Events.end(); ++it )
+    {
+    os << ( it == globals.m_Events.begin() && globals.m_NumberOfThreads == 0 ? "\n" : ",\n" )
+       << "{\"name\": ";
+    WriteString(os, it->Name);
+    os << ", \"cat\": ";
+    WriteString(os, it->Category);
+    os << ", \"ph\": \"" << it->Phase << "\", \"pid\": 1, \"tid\": " << it->Thread
+       << ", \"ts\": " << it->Start;
+    if ( it->Phase == 'X' )
+      {
+      os << ", \"dur\": " << it->Duration;
+      }
+    else
+      {
+      os << ", \"s\": \"t\"";
+      }
+    if ( it->ArgumentName[0] || it->ArgumentName[1] )
+      {
+      os << ", \"args\": {";
+      bool first = true;
+      for ( unsigned int i = 0; i < 2; ++i )
+        {
+        if ( it->ArgumentName[i] )
+          {
+          os << ( first ? "" : ", " );
+          WriteString(os, it->ArgumentName[i]);
+          os.unsetf(std::ios::floatfield);
+          os << ": " << std::setprecision(15) << it->ArgumentValue[i];
+          os << std::fixed << std::setprecision(3);
+          first = false;
+          }
+        }
+      os << "}";
+      }
+    os << "}";
+    }
+  os << "\n]}\n";
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+bool
+TraceEventRecorder
+::WriteChromeTrace(const std::string & fileName)
+{
+  std::ofstream file( fileName.c_str() );
+  if ( !file )
+    {
+    return false;
+    }
+  WriteChromeTrace(file);
+  return !file.fail();
+}
+} // end namespace itk
@@ -0,0 +1,590 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkWorkStealingThreadPool.h"
+#include "itkMutexLockHolder.h"
+
+namespace itk
+{
+
+namespace
+{
+// Minimal set of atomic operations used by the deques and counters.
+// They follow the platform choices made in itkLightObject.cxx.
+#if defined( ITK_USE_WIN32_THREADS )
+inline long AtomicIncrement(volatile long *value)
+{
+  return InterlockedIncrement(value);
+}
+inline long AtomicDecrement(volatile long *value)
+{
+  return InterlockedDecrement(value);
+}
+inline long AtomicAdd(volatile long *value, long increment)
+{
+  return InterlockedExchangeAdd(value, increment) + increment;
+}
+inline bool AtomicCompareAndSwap(volatile long *value, long expected, long desired)
+{
+  return InterlockedCompareExchange(value, desired, expected) == expected;
+}
+inline void FullMemoryBarrier()
+{
+  MemoryBarrier();
+}
+#elif defined( ITK_USE_PTHREADS )
+inline long AtomicIncrement(volatile long *value)
+{
+  return __sync_add_and_fetch(value, 1L);
+}
+inline long AtomicDecrement(volatile long *value)
+{
+  return __sync_sub_and_fetch(value, 1L);
+}
+inline long AtomicAdd(volatile long *value, long increment)
+{
+  return __sync_add_and_fetch(value, increment);
+}
+inline bool AtomicCompareAndSwap(volatile long *value, long expected, long desired)
+{
+  return __sync_bool_compare_and_swap(value, expected, desired);
+}
+inline void FullMemoryBarrier()
+{
+  __sync_synchronize();
+}
+#else
+inline long AtomicIncrement(volatile long *value)
+{
+  return ++( *value );
+}
+inline long AtomicDecrement(volatile long *value)
+{
+  return --( *value );
+}
+inline long AtomicAdd(volatile long *value, long increment)
+{
+  return ( *value += increment );
+}
+inline bool AtomicCompareAndSwap(volatile long *value, long expected, long desired)
+{
+  if( *value == expected )
+    {
+    *value = desired;
+    return true;
+    }
+  return false;
+}
+inline void FullMemoryBarrier()
+{
+}
+#endif
+
+// Thread local storage of the worker id (+1) of the calling thread.
+// Zero means the calling thread is not a worker.
+#if defined( ITK_USE_PTHREADS )
+pthread_key_t  workerIdKey;
+pthread_once_t workerIdKeyOnce = PTHREAD_ONCE_INIT;
+
+extern "C" void CreateWorkerIdKey()
+{
+  pthread_key_create(&workerIdKey, ITK_NULLPTR);
+}
+
+inline void SetCurrentWorkerId(long id)
+{
+  pthread_once(&workerIdKeyOnce, &CreateWorkerIdKey);
+  pthread_setspecific( workerIdKey, reinterpret_cast< void * >( id + 1 ) );
+}
+
+inline long GetCurrentWorkerId()
+{
+  pthread_once(&workerIdKeyOnce, &CreateWorkerIdKey);
+  return reinterpret_cast< long >( pthread_getspecific(workerIdKey) ) - 1;
+}
+#elif defined( ITK_USE_WIN32_THREADS )
+DWORD               workerIdIndex = TLS_OUT_OF_INDEXES;
+SimpleFastMutexLock workerIdIndexLock;
+
+inline DWORD GetWorkerIdIndex()
+{
+  if( workerIdIndex == TLS_OUT_OF_INDEXES )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(workerIdIndexLock);
+    if( workerIdIndex == TLS_OUT_OF_INDEXES )
+      {
+      workerIdIndex = TlsAlloc();
+      }
+    }
+  return workerIdIndex;
+}
+
+inline void SetCurrentWorkerId(long id)
+{
+  TlsSetValue( GetWorkerIdIndex(), reinterpret_cast< LPVOID >( static_cast< INT_PTR >( id + 1 ) ) );
+}
+
+inline long GetCurrentWorkerId()
+{
+  return static_cast< long >( reinterpret_cast< INT_PTR >( TlsGetValue( GetWorkerIdIndex() ) ) ) - 1;
+}
+#else
+inline void SetCurrentWorkerId(long)
+{
+}
+
+inline long GetCurrentWorkerId()
+{
+  return -1;
+}
+#endif
+} // end anonymous namespace
+
+WorkStealingThreadPool::Pointer WorkStealingThreadPool::m_Instance;
+SimpleFastMutexLock             WorkStealingThreadPool::m_InstanceLock;
+
+WorkStealingThreadPool::Pointer
+WorkStealingThreadPool
+::New()
+{
+  return Self::GetInstance();
+}
+
+WorkStealingThreadPool::Pointer
+WorkStealingThreadPool
+::GetInstance()
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_InstanceLock);
+  if( m_Instance.IsNull() )
+    {
+    // Try the factory first
+    m_Instance = ObjectFactory< Self >::Create();
+    // if the factory did not provide one, then create it here
+    if( m_Instance.IsNull() )
+      {
+      m_Instance = new WorkStealingThreadPool();
+      // Remove extra reference from construction.
+      m_Instance->UnRegister();
+      }
+    }
+  return m_Instance;
+}
+
+WorkStealingThreadPool
+::WorkStealingThreadPool() :
+  m_NumberOfWorkers(0),
+  m_NumberOfQueuedTasks(0),
+  m_Condition( ConditionVariable::New() ),
+  m_ScheduleForDestruction(false)
+{
+  for( ThreadIdType i = 0; i < ITK_MAX_THREADS; ++i )
+    {
+    m_Workers[i] = ITK_NULLPTR;
+    }
+}
+
+WorkStealingThreadPool
+::~WorkStealingThreadPool()
+{
+  m_ConditionLock.Lock();
+  m_ScheduleForDestruction = true;
+  m_Condition->Broadcast();
+  m_ConditionLock.Unlock();
+
+  for( long i = 0; i < m_NumberOfWorkers; ++i )
+    {
+#if defined( ITK_USE_PTHREADS )
+    pthread_join(m_Workers[i]->m_ThreadHandle, ITK_NULLPTR);
+#elif defined( ITK_USE_WIN32_THREADS )
+    WaitForSingleObject(m_Workers[i]->m_ThreadHandle, INFINITE);
+    CloseHandle(m_Workers[i]->m_ThreadHandle);
+#endif
+    delete m_Workers[i];
+    m_Workers[i] = ITK_NULLPTR;
+    }
+}
+
+WorkStealingThreadPool::WorkerDeque
+::WorkerDeque() :
+  m_Top(0),
+  m_Bottom(0)
+{
+  for( long i = 0; i < Capacity; ++i )
+    {
+    m_Buffer[i] = ITK_NULLPTR;
+    m_Groups[i] = ITK_NULLPTR;
+    }
+}
+
+bool
+WorkStealingThreadPool::WorkerDeque
+::Push(Task *task)
+{
+  const long bottom = m_Bottom;
+  const long top = m_Top;
+  if( bottom - top >= Capacity )
+    {
+    return false;
+    }
+  m_Buffer[bottom % Capacity] = task;
+  m_Groups[bottom % Capacity] = task->m_Group;
+  // the task must be visible before the new bottom is published
+  FullMemoryBarrier();
+  m_Bottom = bottom + 1;
+  return true;
+}
+
+WorkStealingThreadPool::Task *
+WorkStealingThreadPool::WorkerDeque
+::Pop(const TaskGroup *group)
+{
+  if( group != ITK_NULLPTR
+      && ( m_Bottom <= m_Top || m_Groups[( m_Bottom - 1 ) % Capacity] != group ) )
+    {
+    // the bottom task belongs to another group
+    return ITK_NULLPTR;
+    }
+  const long bottom = m_Bottom - 1;
+  m_Bottom = bottom;
+  FullMemoryBarrier();
+  const long top = m_Top;
+  if( top > bottom )
+    {
+    // empty
+    m_Bottom = bottom + 1;
+    return ITK_NULLPTR;
+    }
+  Task *task = m_Buffer[bottom % Capacity];
+  if( top == bottom )
+    {
+    // last element: race against the thieves for it
+    if( !AtomicCompareAndSwap(&m_Top, top, top + 1) )
+      {
+      task = ITK_NULLPTR;
+      }
+    m_Bottom = bottom + 1;
+    }
+  return task;
+}
+
+WorkStealingThreadPool::Task *
+WorkStealingThreadPool::WorkerDeque
+::Steal(const TaskGroup *group)
+{
+  const long top = m_Top;
+  FullMemoryBarrier();
+  const long bottom = m_Bottom;
+  if( top >= bottom )
+    {
+    return ITK_NULLPTR;
+    }
+  if( group != ITK_NULLPTR && m_Groups[top % Capacity] != group )
+    {
+    return ITK_NULLPTR;
+    }
+  Task *task = m_Buffer[top % Capacity];
+  if( !AtomicCompareAndSwap(&m_Top, top, top + 1) )
+    {
+    // lost the race against the owner or another thief
+    return ITK_NULLPTR;
+    }
+  return task;
+}
+
+void
+WorkStealingThreadPool
+::InitializeThreads(ThreadIdType numberOfWorkers)
+{
+#if defined( ITK_USE_PTHREADS ) || defined( ITK_USE_WIN32_THREADS )
+  if( numberOfWorkers > ITK_MAX_THREADS )
+    {
+    numberOfWorkers = ITK_MAX_THREADS;
+    }
+  if( static_cast< ThreadIdType >( m_NumberOfWorkers ) >= numberOfWorkers )
+    {
+    return;
+    }
+  MutexLockHolder< SimpleFastMutexLock > holder(m_WorkersLock);
+  while( static_cast< ThreadIdType >( m_NumberOfWorkers ) < numberOfWorkers )
+    {
+    this->AddWorker();
+    }
+#else
+  (void)numberOfWorkers;
+#endif
+}
+
+ThreadIdType
+WorkStealingThreadPool
+::GetNumberOfWorkers() const
+{
+  return static_cast< ThreadIdType >( m_NumberOfWorkers );
+}
+
+void
+WorkStealingThreadPool
+::AddWorker()
+{
+  const long workerId = m_NumberOfWorkers;
+  WorkerInfo *info = new WorkerInfo;
+  info->m_Pool = this;
+  info->m_WorkerId = static_cast< ThreadIdType >( workerId );
+  m_Workers[workerId] = info;
+
+#if defined( ITK_USE_PTHREADS )
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+#if !defined( __CYGWIN__ )
+  pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
+#endif
+  const int rc = pthread_create(&info->m_ThreadHandle, &attr, &WorkStealingThreadPool::WorkerExecute, info);
+  pthread_attr_destroy(&attr);
+  if( rc != 0 )
+    {
+    m_Workers[workerId] = ITK_NULLPTR;
+    delete info;
+    itkExceptionMacro(<< "Cannot create thread. pthread_create() returned " << rc);
+    }
+#elif defined( ITK_USE_WIN32_THREADS )
+  info->m_ThreadHandle = CreateThread(ITK_NULLPTR, 0, &WorkStealingThreadPool::WorkerExecute, info, 0, ITK_NULLPTR);
+  if( info->m_ThreadHandle == ITK_NULLPTR )
+    {
+    m_Workers[workerId] = ITK_NULLPTR;
+    delete info;
+    itkExceptionMacro(<< "Cannot create thread. CreateThread() failed");
+    }
+#endif
+
+  // publish the new worker only once it is completely constructed
+  FullMemoryBarrier();
+  AtomicIncrement(&m_NumberOfWorkers);
+  itkDebugMacro(<< "Added worker " << workerId);
+}
+
+void
+WorkStealingThreadPool
+::Submit(Task *tasks, unsigned int numberOfTasks, TaskGroup & group)
+{
+  if( numberOfTasks == 0 )
+    {
+    return;
+    }
+  AtomicAdd( &group.m_NumberOfPendingTasks, static_cast< long >( numberOfTasks ) );
+
+#if defined( ITK_USE_PTHREADS ) || defined( ITK_USE_WIN32_THREADS )
+  if( m_NumberOfWorkers == 0 )
+    {
+    this->InitializeThreads(1);
+    }
+
+  for( unsigned int i = 0; i < numberOfTasks; ++i )
+    {
+    tasks[i].m_Group = &group;
+    }
+
+  // count the tasks before they become visible, so that a thread taking
+  // one of them never sees the counters drop below zero
+  AtomicAdd( &group.m_NumberOfQueuedTasks, static_cast< long >( numberOfTasks ) );
+  AtomicAdd( &m_NumberOfQueuedTasks, static_cast< long >( numberOfTasks ) );
+
+  const long workerId = GetCurrentWorkerId();
+  unsigned int pushed = 0;
+  if( workerId >= 0 && m_Workers[workerId]->m_Pool == this )
+    {
+    WorkerDeque & deque = m_Workers[workerId]->m_Deque;
+    while( pushed < numberOfTasks && deque.Push(&tasks[pushed]) )
+      {
+      ++pushed;
+      }
+    }
+  if( pushed < numberOfTasks )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(m_InjectionQueueLock);
+    for( unsigned int i = pushed; i < numberOfTasks; ++i )
+      {
+      m_InjectionQueue.push_back(&tasks[i]);
+      }
+    }
+
+  m_ConditionLock.Lock();
+  m_Condition->Broadcast();
+  m_ConditionLock.Unlock();
+#else
+  // Without a threading library the tasks are run right away.
+  for( unsigned int i = 0; i < numberOfTasks; ++i )
+    {
+    tasks[i].m_Group = &group;
+    this->RunTask(&tasks[i]);
+    }
+#endif
+}
+
+WorkStealingThreadPool::Task *
+WorkStealingThreadPool
+::FindTask(int workerId, const TaskGroup *group)
+{
+  Task *task = ITK_NULLPTR;
+  if( ( group != ITK_NULLPTR ? group->m_NumberOfQueuedTasks : m_NumberOfQueuedTasks ) <= 0 )
+    {
+    return task;
+    }
+
+  if( workerId >= 0 )
+    {
+    task = m_Workers[workerId]->m_Deque.Pop(group);
+    }
+
+  if( task == ITK_NULLPTR )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(m_InjectionQueueLock);
+    std::deque< Task * >::iterator it = m_InjectionQueue.begin();
+    if( group != ITK_NULLPTR )
+      {
+      while( it != m_InjectionQueue.end() && ( *it )->m_Group != group )
+        {
+        ++it;
+        }
+      }
+    if( it != m_InjectionQueue.end() )
+      {
+      task = *it;
+      m_InjectionQueue.erase(it);
+      }
+    }
+
+  if( task == ITK_NULLPTR )
+    {
+    // steal, starting with the next worker to spread the contention
+    const long numberOfWorkers = m_NumberOfWorkers;
+    const long start = workerId >= 0 ? workerId + 1 : 0;
+    for( long i = 0; i < numberOfWorkers && task == ITK_NULLPTR; ++i )
+      {
+      const long victim = ( start + i ) % numberOfWorkers;
+      if( victim != workerId )
+        {
+        task = m_Workers[victim]->m_Deque.Steal(group);
+        }
+      }
+    }
+
+  if( task != ITK_NULLPTR )
+    {
+    AtomicDecrement(&task->m_Group->m_NumberOfQueuedTasks);
+    AtomicDecrement(&m_NumberOfQueuedTasks);
+    }
+  return task;
+}
+
+void
+WorkStealingThreadPool
+::RunTask(Task *task)
+{
+  TaskGroup *group = task->m_Group;
+
+  // Exceptions must be handled by the task function itself, as
+  // MultiThreader::SingleMethodProxy does.
+  ( *task->m_Function )( task->m_UserData );
+
+  if( AtomicDecrement(&group->m_NumberOfPendingTasks) == 0 )
+    {
+    m_ConditionLock.Lock();
+    m_Condition->Broadcast();
+    m_ConditionLock.Unlock();
+    }
+}
+
+void
+WorkStealingThreadPool
+::Wait(TaskGroup & group)
+{
+  const long workerId = GetCurrentWorkerId();
+  const int  ownId = ( workerId >= 0 && m_Workers[workerId]->m_Pool == this ) ? static_cast< int >( workerId ) : -1;
+
+  while( group.m_NumberOfPendingTasks > 0 )
+    {
+    // Help only with the tasks of this group: running an unrelated task
+    // could hold the caller for that task's whole run time.
+    Task *task = this->FindTask(ownId, &group);
+    if( task != ITK_NULLPTR )
+      {
+      this->RunTask(task);
+      continue;
+      }
+
+    // The remaining tasks of the group are running on other threads;
+    // the last one to finish broadcasts the condition.
+    m_ConditionLock.Lock();
+    while( group.m_NumberOfPendingTasks > 0 && group.m_NumberOfQueuedTasks <= 0 )
+      {
+      m_Condition->Wait(&m_ConditionLock);
+      }
+    m_ConditionLock.Unlock();
+    }
+}
+
+bool
+WorkStealingThreadPool
+::IsWorkerThread()
+{
+  return GetCurrentWorkerId() >= 0;
+}
+
+ITK_THREAD_RETURN_TYPE
+WorkStealingThreadPool
+::WorkerExecute(void *param)
+{
+  WorkerInfo             *info = reinterpret_cast< WorkerInfo * >( param );
+  WorkStealingThreadPool *pool = info->m_Pool;
+  const int               workerId = static_cast< int >( info->m_WorkerId );
+
+  SetCurrentWorkerId(workerId);
+
+  for(;; )
+    {
+    Task *task = pool->FindTask(workerId);
+    if( task != ITK_NULLPTR )
+      {
+      pool->RunTask(task);
+      continue;
+      }
+
+    pool->m_ConditionLock.Lock();
+    while( pool->m_NumberOfQueuedTasks <= 0 && !pool->m_ScheduleForDestruction )
+      {
+      pool->m_Condition->Wait(&pool->m_ConditionLock);
+      }
+    const bool stop = pool->m_ScheduleForDestruction && pool->m_NumberOfQueuedTasks <= 0;
+    pool->m_ConditionLock.Unlock();
+    if( stop )
+      {
+      break;
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void
+WorkStealingThreadPool
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfWorkers: " << m_NumberOfWorkers << std::endl;
+  os << indent << "NumberOfQueuedTasks: " << m_NumberOfQueuedTasks << std::endl;
+}
+
+} // end namespace itk
@@ -0,0 +1,94 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionSplitterScanline.h"
+#include "itkImageRegion.h"
+#include "itkTestingMacros.h"
+#include <iostream>
+
+int itkImageRegionSplitterScanlineTest(int, char*[])
+{
+
+  itk::ImageRegionSplitterScanline::Pointer splitter = itk::ImageRegionSplitterScanline::New();
+
+  EXERCISE_BASIC_OBJECT_METHODS( splitter, ImageRegionSplitterScanline );
+
+
+  itk::ImageRegion<3> region;
+  region.SetSize(0, 10);
+  region.SetSize(1, 11);
+  region.SetSize(2, 5);
+
+  region.SetIndex(0, 1);
+  region.SetIndex(1, 10);
+  region.SetIndex(2, -3);
+
+  const itk::ImageRegion<3> lpRegion = region;
+
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 1 ), 1 );
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 2 ), 2 );
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 5 ), 5 );
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 7 ), 5 );
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 10 ), 10 );
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 55 ), 55 );
+  // the fastest dimension is never split
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( lpRegion, 999 ), 55 );
+
+  // the outermost dimension is split first
+  region = lpRegion;
+  splitter->GetSplit(1, 5, region);
+  TEST_EXPECT_EQUAL(region.GetSize(0), 10);
+  TEST_EXPECT_EQUAL(region.GetSize(1), 11);
+  TEST_EXPECT_EQUAL(region.GetSize(2), 1);
+  TEST_EXPECT_EQUAL(region.GetIndex(2), -2);
+
+  // then the next outermost; consecutive pieces are in the same slice
+  region = lpRegion;
+  splitter->GetSplit(3, 10, region);
+  TEST_EXPECT_EQUAL(region.GetSize(0), 10);
+  TEST_EXPECT_EQUAL(region.GetSize(1), 5);
+  TEST_EXPECT_EQUAL(region.GetIndex(1), 16);
+  TEST_EXPECT_EQUAL(region.GetSize(2), 1);
+  TEST_EXPECT_EQUAL(region.GetIndex(2), -2);
+
+  // the pieces cover the region exactly once
+  for ( unsigned int requested = 1; requested < 70; ++requested )
+    {
+    const unsigned int pieces = splitter->GetNumberOfSplits( lpRegion, requested );
+    itk::SizeValueType numberOfPixels = 0;
+    for ( unsigned int i = 0; i < pieces; ++i )
+      {
+      region = lpRegion;
+      TEST_EXPECT_EQUAL( splitter->GetSplit( i, pieces, region ), pieces );
+      if ( !lpRegion.IsInside( region ) )
+        {
+        std::cerr << "Piece " << i << " of " << pieces << " is outside: " << region << std::endl;
+        return EXIT_FAILURE;
+        }
+      numberOfPixels += region.GetNumberOfPixels();
+      }
+    TEST_EXPECT_EQUAL( numberOfPixels, lpRegion.GetNumberOfPixels() );
+    }
+
+  // one dimensional regions are split along their only dimension
+  itk::ImageRegion<1> line;
+  line.SetSize(0, 100);
+  TEST_EXPECT_EQUAL( splitter->GetNumberOfSplits( line, 8 ), 8 );
+
+  return EXIT_SUCCESS;
+}
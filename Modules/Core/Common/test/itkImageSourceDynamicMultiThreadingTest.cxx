@@ -0,0 +1,155 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageSource.h"
+#include "itkImageRegionIterator.h"
+#include "itkTestingMacros.h"
+
+namespace itk
+{
+/** \class DynamicMultiThreadingTestImageSource
+ * Writes how many times each pixel was visited, and counts the calls
+ * made to the threaded methods.
+ */
+template< typename TOutputImage >
+class DynamicMultiThreadingTestImageSource : public ImageSource< TOutputImage >
+{
+public:
+  typedef DynamicMultiThreadingTestImageSource Self;
+  typedef ImageSource< TOutputImage >          Superclass;
+  typedef SmartPointer< Self >                 Pointer;
+  typedef SmartPointer< const Self >           ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(DynamicMultiThreadingTestImageSource, ImageSource);
+
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+
+  unsigned int m_NumberOfBeforeCalls;
+  unsigned int m_NumberOfAfterCalls;
+  unsigned int m_NumberOfThreadedCalls;
+  bool         m_BadThreadId;
+
+protected:
+  DynamicMultiThreadingTestImageSource() :
+    m_NumberOfBeforeCalls(0),
+    m_NumberOfAfterCalls(0),
+    m_NumberOfThreadedCalls(0),
+    m_BadThreadId(false)
+  {
+  }
+
+  virtual void GenerateOutputInformation() ITK_OVERRIDE
+  {
+    typename TOutputImage::RegionType region;
+    typename TOutputImage::SizeType   size;
+    size.Fill(17);
+    region.SetSize(size);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  virtual void BeforeThreadedGenerateData() ITK_OVERRIDE
+  {
+    ++m_NumberOfBeforeCalls;
+    this->GetOutput()->FillBuffer(0);
+  }
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & region, ThreadIdType threadId) ITK_OVERRIDE
+  {
+    m_Lock.Lock();
+    ++m_NumberOfThreadedCalls;
+    if ( threadId >= this->GetMultiThreader()->GetNumberOfThreads() )
+      {
+      m_BadThreadId = true;
+      }
+    m_Lock.Unlock();
+
+    ImageRegionIterator< TOutputImage > it(this->GetOutput(), region);
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      it.Set( it.Get() + 1 );
+      }
+  }
+
+  virtual void AfterThreadedGenerateData() ITK_OVERRIDE
+  {
+    ++m_NumberOfAfterCalls;
+  }
+
+private:
+  SimpleFastMutexLock m_Lock;
+};
+}
+
+int itkImageSourceDynamicMultiThreadingTest(int, char*[])
+{
+  typedef itk::Image< unsigned int, 3 >                              ImageType;
+  typedef itk::DynamicMultiThreadingTestImageSource< ImageType >     SourceType;
+
+  SourceType::Pointer source = SourceType::New();
+  source->SetNumberOfThreads(4);
+
+  TEST_EXPECT_TRUE( !source->GetDynamicMultiThreading() );
+  source->DynamicMultiThreadingOn();
+  TEST_EXPECT_TRUE( source->GetDynamicMultiThreading() );
+
+  // default: about 16 pieces per thread
+  TRY_EXPECT_NO_EXCEPTION( source->Update() );
+
+  const ImageType::Pointer output = source->GetOutput();
+  for ( itk::ImageRegionIterator< ImageType > it(output, output->GetBufferedRegion()); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != 1 )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " was processed " << it.Get() << " times" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  TEST_EXPECT_EQUAL( source->m_NumberOfBeforeCalls, 1 );
+  TEST_EXPECT_EQUAL( source->m_NumberOfAfterCalls, 1 );
+  TEST_EXPECT_TRUE( !source->m_BadThreadId );
+  // 17 slices with 17 rows, in about 64 blocks of scanlines
+  TEST_EXPECT_EQUAL( source->m_NumberOfThreadedCalls, 51 );
+
+  // chunk size hint of one slice
+  source->SetDynamicChunkSize( 17 * 17 );
+  TEST_EXPECT_EQUAL( source->GetDynamicChunkSize(), 17 * 17 );
+  source->m_NumberOfThreadedCalls = 0;
+  source->Modified();
+  TRY_EXPECT_NO_EXCEPTION( source->Update() );
+  TEST_EXPECT_EQUAL( source->m_NumberOfThreadedCalls, 17 );
+  for ( itk::ImageRegionIterator< ImageType > it(output, output->GetBufferedRegion()); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != 1 )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " was processed " << it.Get() << " times" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  TEST_EXPECT_EQUAL( source->m_NumberOfBeforeCalls, 2 );
+  TEST_EXPECT_EQUAL( source->m_NumberOfAfterCalls, 2 );
+
+  // static splitting is unchanged
+  source->DynamicMultiThreadingOff();
+  source->m_NumberOfThreadedCalls = 0;
+  source->Modified();
+  TRY_EXPECT_NO_EXCEPTION( source->Update() );
+  TEST_EXPECT_TRUE( source->m_NumberOfThreadedCalls <= source->GetNumberOfThreads() );
+
+  return EXIT_SUCCESS;
+}
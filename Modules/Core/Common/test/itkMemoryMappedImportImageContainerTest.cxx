@@ -0,0 +1,149 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMemoryMappedImportImageContainer.h"
+#include "itkImage.h"
+
+#include <fstream>
+
+namespace
+{
+const unsigned int HeaderSize = 8;
+const unsigned int NumberOfElements = 5000;
+
+float ReadElementFromFile(const std::string & fileName, unsigned int element)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  file.seekg(HeaderSize + element * sizeof(float), std::ios::beg);
+  float value = 0.0f;
+  file.read(reinterpret_cast< char * >( &value ), sizeof(float));
+  return value;
+}
+}
+
+int itkMemoryMappedImportImageContainerTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string fileName = argv[1];
+
+  // a header followed by the elements
+    {
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    const char    header[HeaderSize] = { 'H', 'E', 'A', 'D', 'E', 'R', '\n', '\0' };
+    file.write(header, HeaderSize);
+    for( unsigned int i = 0; i < NumberOfElements; ++i )
+      {
+      const float value = 0.5f * i;
+      file.write(reinterpret_cast< const char * >( &value ), sizeof(float));
+      }
+    }
+
+  // mapping failures
+  itk::MemoryMappedFile::Pointer mappedFile = itk::MemoryMappedFile::New();
+  if( mappedFile->Map(fileName + ".missing", 0, 16)
+      || mappedFile->Map(fileName, HeaderSize, NumberOfElements * sizeof(float) + 1)
+      || mappedFile->Map(fileName, 0, 0)
+      || mappedFile->GetData() != ITK_NULLPTR )
+    {
+    std::cerr << "A file was mapped beyond its end" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // unaligned offsets are mapped as bytes
+  if( !mappedFile->Map(fileName, 3, 10)
+      || static_cast< const char * >( mappedFile->GetData() )[0] != 'D'
+      || mappedFile->GetLength() != 10 )
+    {
+    std::cerr << "Failed to map a range of bytes" << std::endl;
+    return EXIT_FAILURE;
+    }
+  mappedFile->Unmap();
+  std::cout << mappedFile;
+
+  typedef itk::Image< float, 2 >                                             ImageType;
+  typedef itk::MemoryMappedImportImageContainer< itk::SizeValueType, float > ContainerType;
+
+  ContainerType::Pointer container = ContainerType::New();
+  if( container->MapFile(fileName, HeaderSize + 1, NumberOfElements) )
+    {
+    std::cerr << "Mapped misaligned elements" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !container->MapFile(fileName, HeaderSize, NumberOfElements)
+      || container->GetMappedFile() == ITK_NULLPTR
+      || container->Size() != NumberOfElements )
+    {
+    std::cerr << "Failed to map the elements" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << container;
+
+  // the container is used as the buffer of an image
+  ImageType::RegionType region;
+  region.SetSize(0, 100);
+  region.SetSize(1, 50);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->SetPixelContainer(container);
+
+  ImageType::IndexType index;
+  index[0] = 10;
+  index[1] = 3;
+  if( image->GetPixel(index) != 0.5f * 310 )
+    {
+    std::cerr << "Wrong mapped pixel: " << image->GetPixel(index) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // modifications are private to the process
+  image->SetPixel(index, -1.0f);
+  if( image->GetPixel(index) != -1.0f || ReadElementFromFile(fileName, 310) != 0.5f * 310 )
+    {
+    std::cerr << "Modifying the mapped pixels changed the file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // growing the container releases the mapping and keeps the elements
+  container->Reserve(NumberOfElements + 1);
+  if( container->GetMappedFile() != ITK_NULLPTR
+      || ( *container )[310] != -1.0f
+      || ( *container )[311] != 0.5f * 311 )
+    {
+    std::cerr << "Reserve did not copy the mapped elements" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( !container->MapFile(fileName, HeaderSize, NumberOfElements) )
+    {
+    std::cerr << "Failed to map the elements again" << std::endl;
+    return EXIT_FAILURE;
+    }
+  image->Initialize();
+  container->Initialize();
+  if( container->GetMappedFile() != ITK_NULLPTR || container->GetBufferPointer() != ITK_NULLPTR )
+    {
+    std::cerr << "Initialize did not release the mapping" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
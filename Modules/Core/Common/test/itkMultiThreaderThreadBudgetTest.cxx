@@ -0,0 +1,370 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiThreader.h"
+#include "itkBarrier.h"
+#include "itkImageSource.h"
+#include "itkMutexLockHolder.h"
+#include "itksys/SystemTools.hxx"
+
+namespace
+{
+const unsigned int OuterPieces = 8;
+const unsigned int InnerPieces = 4;
+
+struct BudgetTestData
+{
+  BudgetTestData() :
+    Running(0),
+    MaximumRunning(0),
+    MaximumActive(0),
+    UseWorkStealing(false),
+    ThrowOnPiece(-1)
+  {
+    for( unsigned int i = 0; i < OuterPieces; ++i )
+      {
+      OuterCount[i] = 0;
+      for( unsigned int j = 0; j < InnerPieces; ++j )
+        {
+        InnerCount[i][j] = 0;
+        }
+      }
+  }
+
+  itk::SimpleFastMutexLock Lock;
+  unsigned int             OuterCount[OuterPieces];
+  unsigned int             InnerCount[OuterPieces][InnerPieces];
+  unsigned int             Running;
+  unsigned int             MaximumRunning;
+  itk::ThreadIdType        MaximumActive;
+  bool                     UseWorkStealing;
+  int                      ThrowOnPiece;
+};
+
+struct InnerData
+{
+  BudgetTestData *Data;
+  unsigned int    OuterPiece;
+};
+
+ITK_THREAD_RETURN_TYPE InnerCallback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  InnerData *inner = static_cast< InnerData * >( info->UserData );
+
+  itk::MutexLockHolder< itk::SimpleFastMutexLock > holder(inner->Data->Lock);
+  ++inner->Data->InnerCount[inner->OuterPiece][info->ThreadID];
+  inner->Data->MaximumActive = std::max( inner->Data->MaximumActive,
+                                         itk::MultiThreader::GetGlobalNumberOfActiveThreads() );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+ITK_THREAD_RETURN_TYPE OuterCallback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  BudgetTestData *data = static_cast< BudgetTestData * >( info->UserData );
+
+  if( static_cast< int >( info->ThreadID ) == data->ThrowOnPiece )
+    {
+    itkGenericExceptionMacro(<< "Piece " << info->ThreadID << " failed");
+    }
+
+    {
+    itk::MutexLockHolder< itk::SimpleFastMutexLock > holder(data->Lock);
+    ++data->OuterCount[info->ThreadID];
+    ++data->Running;
+    data->MaximumRunning = std::max( data->MaximumRunning, data->Running );
+    data->MaximumActive = std::max( data->MaximumActive,
+                                    itk::MultiThreader::GetGlobalNumberOfActiveThreads() );
+    }
+
+  itksys::SystemTools::Delay(2);
+
+  // nested execution
+  InnerData inner;
+  inner.Data = data;
+  inner.OuterPiece = info->ThreadID;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(InnerPieces);
+  threader->SetUseWorkStealing(data->UseWorkStealing);
+  threader->SetSingleMethod(InnerCallback, &inner);
+  threader->SingleMethodExecute();
+
+    {
+    itk::MutexLockHolder< itk::SimpleFastMutexLock > holder(data->Lock);
+    --data->Running;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool RunNested(itk::ThreadIdType budget, bool useWorkStealing)
+{
+  BudgetTestData data;
+  data.UseWorkStealing = useWorkStealing;
+
+  // as in ImageSource, the number of pieces is chosen from the lease
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetUseWorkStealing(useWorkStealing);
+  threader->SetSingleMethod(OuterCallback, &data);
+  itk::ThreadIdType outerPieces;
+    {
+    const itk::MultiThreader::ThreadBudgetLease lease(OuterPieces);
+    outerPieces = lease.GetNumberOfThreads();
+    threader->SetNumberOfThreads(outerPieces);
+    threader->SingleMethodExecute();
+    }
+
+  bool ok = true;
+  for( unsigned int i = 0; i < outerPieces; ++i )
+    {
+    if( data.OuterCount[i] != 1 )
+      {
+      std::cerr << "Outer piece " << i << " ran " << data.OuterCount[i] << " times" << std::endl;
+      ok = false;
+      }
+    for( unsigned int j = 0; j < InnerPieces; ++j )
+      {
+      if( data.InnerCount[i][j] != 1 )
+        {
+        std::cerr << "Inner piece " << i << "," << j << " ran " << data.InnerCount[i][j] << " times" << std::endl;
+        ok = false;
+        }
+      }
+    }
+  if( data.MaximumRunning > budget )
+    {
+    std::cerr << data.MaximumRunning << " outer pieces ran at the same time with a budget of "
+              << budget << std::endl;
+    ok = false;
+    }
+  if( data.MaximumActive > budget )
+    {
+    std::cerr << data.MaximumActive << " active threads with a budget of " << budget << std::endl;
+    ok = false;
+    }
+  if( itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 0 )
+    {
+    std::cerr << "Threads still charged after the execution" << std::endl;
+    ok = false;
+    }
+  return ok;
+}
+
+struct BarrierData
+{
+  itk::Barrier::Pointer Barrier;
+};
+
+ITK_THREAD_RETURN_TYPE BarrierCallback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  BarrierData *data = static_cast< BarrierData * >( info->UserData );
+
+  // deadlocks if the pieces are not all running at the same time
+  data->Barrier->Wait();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Records the number of threads a filter runs with. */
+class BudgetTestImageSource : public itk::ImageSource< itk::Image< unsigned char, 2 > >
+{
+public:
+  typedef BudgetTestImageSource                                Self;
+  typedef itk::ImageSource< itk::Image< unsigned char, 2 > >   Superclass;
+  typedef itk::SmartPointer< Self >                            Pointer;
+
+  itkNewMacro(Self);
+
+  itk::ThreadIdType m_NumberOfThreadsInGenerateData;
+
+protected:
+  BudgetTestImageSource() : m_NumberOfThreadsInGenerateData(0) {}
+
+  virtual void GenerateOutputInformation() ITK_OVERRIDE
+  {
+    OutputImageRegionType region;
+    region.SetSize(0, 64);
+    region.SetSize(1, 64);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType &, itk::ThreadIdType) ITK_OVERRIDE
+  {
+    m_NumberOfThreadsInGenerateData = this->GetMultiThreader()->GetNumberOfThreads();
+  }
+};
+}
+
+int itkMultiThreaderThreadBudgetTest(int argc, char* argv[])
+{
+  // the budget may be given by the environment
+  const itk::ThreadIdType expectedBudget = argc > 1 ? atoi(argv[1]) : 0;
+  if( itk::MultiThreader::GetGlobalThreadBudget() != expectedBudget )
+    {
+    std::cerr << "Expected a global thread budget of " << expectedBudget
+              << " but got " << itk::MultiThreader::GetGlobalThreadBudget() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // without a budget, leases grant everything and charge nothing
+  itk::MultiThreader::SetGlobalThreadBudget(0);
+    {
+    const itk::MultiThreader::ThreadBudgetLease lease(12);
+    if( lease.GetActive() || lease.GetNumberOfThreads() != 12
+        || itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 0 )
+      {
+      std::cerr << "A lease without budget changed the number of threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // leases taken by the same thread share the outer one
+  itk::MultiThreader::SetGlobalThreadBudget(4);
+    {
+    const itk::MultiThreader::ThreadBudgetLease outer(8);
+    if( outer.GetNumberOfThreads() != 4 || itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 4 )
+      {
+      std::cerr << "Top level lease granted " << outer.GetNumberOfThreads() << " threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+      {
+      const itk::MultiThreader::ThreadBudgetLease small(2);
+      const itk::MultiThreader::ThreadBudgetLease large(10);
+      if( small.GetNumberOfThreads() != 2 || large.GetNumberOfThreads() != 2
+          || itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 4 )
+        {
+        std::cerr << "Nested leases granted " << small.GetNumberOfThreads() << " and "
+                  << large.GetNumberOfThreads() << " threads" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  if( itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 0 )
+    {
+    std::cerr << "Threads still charged after the leases were released" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // nested executions stay within the budget and run every piece once
+  for( itk::ThreadIdType budget = 1; budget <= 3; ++budget )
+    {
+    itk::MultiThreader::SetGlobalThreadBudget(budget);
+    if( !RunNested(budget, false) || !RunNested(budget, true) )
+      {
+      std::cerr << "Nested execution failed with a budget of " << budget << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // an execution outside of any lease keeps all its threads
+  itk::MultiThreader::SetGlobalThreadBudget(2);
+    {
+    BudgetTestData data;
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(OuterPieces);
+    threader->SetSingleMethod(OuterCallback, &data);
+    threader->SingleMethodExecute();
+    if( data.MaximumActive != OuterPieces )
+      {
+      std::cerr << "Top level execution was charged " << data.MaximumActive << " threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // exceptions in a piece are reported
+  itk::MultiThreader::SetGlobalThreadBudget(2);
+    {
+    BudgetTestData data;
+    data.ThrowOnPiece = 5;
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(OuterPieces);
+    threader->SetSingleMethod(OuterCallback, &data);
+    bool caught = false;
+    try
+      {
+      threader->SingleMethodExecute();
+      }
+    catch( itk::ExceptionObject & e )
+      {
+      std::cout << "Caught expected exception: " << e.GetDescription() << std::endl;
+      caught = true;
+      }
+    if( !caught || itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 0 )
+      {
+      std::cerr << "The exception of a piece was not reported" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // an execution nested in a lease, whose number of pieces was not
+  // chosen from the lease, keeps all its threads
+  itk::MultiThreader::SetGlobalThreadBudget(2);
+    {
+    BarrierData data;
+    data.Barrier = itk::Barrier::New();
+    data.Barrier->Initialize(OuterPieces);
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(OuterPieces);
+    threader->SetSingleMethod(BarrierCallback, &data);
+    const itk::MultiThreader::ThreadBudgetLease lease(OuterPieces);
+    threader->SingleMethodExecute();
+    if( threader->GetNumberOfThreads() != OuterPieces )
+      {
+      std::cerr << "Nested execution changed its number of threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if( itk::MultiThreader::GetGlobalNumberOfActiveThreads() != 0 )
+    {
+    std::cerr << "Threads still charged after the nested execution" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // filters keep one piece per thread they were given, since their
+  // pieces may wait on each other, and share the granted threads among
+  // the pieces of the dynamic multithreading
+  BudgetTestImageSource::Pointer source = BudgetTestImageSource::New();
+  source->SetNumberOfThreads(8);
+  source->Update();
+  if( source->m_NumberOfThreadsInGenerateData != 8 || source->GetNumberOfThreads() != 8 )
+    {
+    std::cerr << "Filter ran with " << source->m_NumberOfThreadsInGenerateData
+              << " pieces and kept " << source->GetNumberOfThreads() << " threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+  source->DynamicMultiThreadingOn();
+  source->Update();
+  if( source->m_NumberOfThreadsInGenerateData != 2 || source->GetNumberOfThreads() != 8 )
+    {
+    std::cerr << "Dynamic filter ran with " << source->m_NumberOfThreadsInGenerateData
+              << " threads and kept " << source->GetNumberOfThreads() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::MultiThreader::SetGlobalThreadBudget(0);
+  source->Modified();
+  source->Update();
+  if( source->m_NumberOfThreadsInGenerateData != 8 )
+    {
+    std::cerr << "Filter ran with " << source->m_NumberOfThreadsInGenerateData
+              << " threads without budget" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
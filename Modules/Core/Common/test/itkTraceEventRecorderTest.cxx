@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkTraceEventRecorder.h"
+#include "itkImageSource.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionIterator.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+typedef itk::Image< unsigned char, 2 > TraceImageType;
+
+/** Fills its output with a constant, one piece per thread. */
+class TraceTestImageSource : public itk::ImageSource< TraceImageType >
+{
+public:
+  typedef TraceTestImageSource                  Self;
+  typedef itk::ImageSource< TraceImageType >    Superclass;
+  typedef itk::SmartPointer< Self >             Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(TraceTestImageSource, ImageSource);
+
+protected:
+  TraceTestImageSource() {}
+
+  virtual void GenerateOutputInformation() ITK_OVERRIDE
+  {
+    OutputImageRegionType region;
+    region.SetSize(0, 64);
+    region.SetSize(1, 64);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & region, itk::ThreadIdType) ITK_OVERRIDE
+  {
+    itk::ImageRegionIterator< TraceImageType > it(this->GetOutput(), region);
+    for( ; !it.IsAtEnd(); ++it )
+      {
+      it.Set(7);
+      }
+  }
+};
+
+unsigned int CountOccurrences(const std::string & text, const std::string & pattern)
+{
+  unsigned int           count = 0;
+  std::string::size_type position = text.find(pattern);
+  while( position != std::string::npos )
+    {
+    ++count;
+    position = text.find(pattern, position + pattern.size());
+    }
+  return count;
+}
+
+bool RunPipeline()
+{
+  TraceTestImageSource::Pointer source = TraceTestImageSource::New();
+  source->SetNumberOfThreads(4);
+
+  typedef itk::StreamingImageFilter< TraceImageType, TraceImageType > StreamerType;
+  StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput(source->GetOutput());
+  streamer->SetNumberOfStreamDivisions(2);
+  streamer->Update();
+
+  TraceImageType::IndexType index;
+  index.Fill(63);
+  return streamer->GetOutput()->GetPixel(index) == 7;
+}
+}
+
+int itkTraceEventRecorderTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " trace.json" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // nothing is recorded while the recorder is disabled
+  itk::TraceEventRecorder::SetEnabled(false);
+  itk::TraceEventRecorder::Clear();
+  if( !RunPipeline() || itk::TraceEventRecorder::GetNumberOfEvents() != 0 )
+    {
+    std::cerr << "Events were recorded by a disabled recorder" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::TraceEventRecorder::EnabledOn();
+  if( !itk::TraceEventRecorder::GetEnabled() || !RunPipeline() )
+    {
+    std::cerr << "Failed to run the traced pipeline" << std::endl;
+    return EXIT_FAILURE;
+    }
+    {
+    itk::TraceEventRecorder::Scope scope("test", "Scope");
+    scope.SetArgument(0, "value", 0.5);
+    }
+  itk::TraceEventRecorder::EnabledOff();
+
+  std::ostringstream trace;
+  itk::TraceEventRecorder::WriteChromeTrace(trace);
+  const std::string text = trace.str();
+  std::cout << text;
+
+  // the source runs once per stream piece, with one event per thread
+  // piece, and the streamer runs once
+  bool ok = true;
+  const unsigned int filterEvents = CountOccurrences(text, "\"cat\": \"filter\"");
+  const unsigned int threadEvents = CountOccurrences(text, "\"cat\": \"thread\"");
+  const unsigned int streamEvents = CountOccurrences(text, "\"cat\": \"stream\"");
+  const unsigned int memoryEvents = CountOccurrences(text, "\"cat\": \"memory\"");
+  if( filterEvents != 3 || threadEvents != 8 || streamEvents != 2 || memoryEvents != 3 )
+    {
+    std::cerr << "Unexpected events: " << filterEvents << " filter, " << threadEvents << " thread, "
+              << streamEvents << " stream and " << memoryEvents << " memory" << std::endl;
+    ok = false;
+    }
+  if( CountOccurrences(text, "\"name\": \"TraceTestImageSource\"") != 10
+      || CountOccurrences(text, "\"pixels\": 512") != 8
+      || CountOccurrences(text, "\"bytes\": 2048") != 2
+      || CountOccurrences(text, "\"bytes\": 4096") != 1
+      || CountOccurrences(text, "\"value\": 0.5") != 1 )
+    {
+    std::cerr << "Unexpected event names or arguments" << std::endl;
+    ok = false;
+    }
+  if( itk::TraceEventRecorder::GetNumberOfEvents() != 17 )
+    {
+    std::cerr << "Recorded " << itk::TraceEventRecorder::GetNumberOfEvents() << " events" << std::endl;
+    ok = false;
+    }
+
+  if( !itk::TraceEventRecorder::WriteChromeTrace(std::string(argv[1])) )
+    {
+    std::cerr << "Failed to write " << argv[1] << std::endl;
+    ok = false;
+    }
+
+  itk::TraceEventRecorder::Clear();
+  if( itk::TraceEventRecorder::GetNumberOfEvents() != 0 )
+    {
+    std::cerr << "Events were not cleared" << std::endl;
+    ok = false;
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,241 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+
+namespace
+{
+struct WorkStealingTestData
+{
+  itk::SimpleFastMutexLock m_Lock;
+  unsigned int             m_Calls[ITK_MAX_THREADS];
+  unsigned int             m_NestedCalls;
+  bool                     m_Nested;
+  bool                     m_Throw;
+};
+
+ITK_THREAD_RETURN_TYPE NestedCallback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info =
+    static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  WorkStealingTestData *data = static_cast< WorkStealingTestData * >( info->UserData );
+
+  data->m_Lock.Lock();
+  ++data->m_NestedCalls;
+  data->m_Lock.Unlock();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+ITK_THREAD_RETURN_TYPE Callback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info =
+    static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  WorkStealingTestData *data = static_cast< WorkStealingTestData * >( info->UserData );
+
+  data->m_Lock.Lock();
+  ++data->m_Calls[info->ThreadID];
+  data->m_Lock.Unlock();
+
+  if( data->m_Throw && info->ThreadID == info->NumberOfThreads - 1 )
+    {
+    itkGenericExceptionMacro(<< "Expected exception from thread " << info->ThreadID);
+    }
+
+  if( data->m_Nested )
+    {
+    // a threaded call made from inside a threaded call
+    itk::MultiThreader::Pointer nested = itk::MultiThreader::New();
+    nested->SetUseWorkStealing(true);
+    nested->SetNumberOfThreads( info->NumberOfThreads );
+    nested->SetSingleMethod(NestedCallback, data);
+    nested->SingleMethodExecute();
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void Reset(WorkStealingTestData & data)
+{
+  for( unsigned int i = 0; i < ITK_MAX_THREADS; ++i )
+    {
+    data.m_Calls[i] = 0;
+    }
+  data.m_NestedCalls = 0;
+  data.m_Nested = false;
+  data.m_Throw = false;
+}
+
+bool CheckCalls(const WorkStealingTestData & data, itk::ThreadIdType numberOfThreads)
+{
+  for( itk::ThreadIdType i = 0; i < ITK_MAX_THREADS; ++i )
+    {
+    const unsigned int expected = i < numberOfThreads ? 1 : 0;
+    if( data.m_Calls[i] != expected )
+      {
+      std::cerr << "Thread " << i << " ran " << data.m_Calls[i]
+                << " times instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+struct GroupTestData
+{
+  volatile bool m_CallerIsWaiting;
+  bool          m_RanOnWaitingCaller;
+};
+
+ITK_THREAD_RETURN_TYPE UnrelatedTask(void *arg)
+{
+  GroupTestData *data = static_cast< GroupTestData * >( arg );
+  if( data->m_CallerIsWaiting && !itk::WorkStealingThreadPool::IsWorkerThread() )
+    {
+    data->m_RanOnWaitingCaller = true;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+ITK_THREAD_RETURN_TYPE GroupTask(void *)
+{
+  return ITK_THREAD_RETURN_VALUE;
+}
+}
+
+int itkWorkStealingThreadPoolTest(int argc, char* argv[])
+{
+  int count = 1000;
+  if( argc > 1 )
+    {
+    const int nt = atoi( argv[1] );
+    if(nt > 1)
+      {
+      count = nt;
+      }
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetUseWorkStealing(true);
+  if( !threader->GetUseWorkStealing() )
+    {
+    std::cerr << "UseWorkStealing was not set" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::ThreadIdType numberOfThreads = 8;
+  if( numberOfThreads > itk::MultiThreader::GetGlobalMaximumNumberOfThreads() )
+    {
+    numberOfThreads = itk::MultiThreader::GetGlobalMaximumNumberOfThreads();
+    }
+  threader->SetNumberOfThreads(numberOfThreads);
+
+  WorkStealingTestData data;
+  threader->SetSingleMethod(Callback, &data);
+
+  // Every piece must run exactly once per execution.
+  itk::TimeProbe timeProbe;
+  timeProbe.Start();
+  for( int i = 0; i < count; ++i )
+    {
+    Reset(data);
+    threader->SingleMethodExecute();
+    if( !CheckCalls(data, numberOfThreads) )
+      {
+      std::cerr << "Failed at iteration " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timeProbe.Stop();
+  std::cout << "Work stealing: " << count << " executions in "
+            << timeProbe.GetTotal() << " s" << std::endl;
+
+  // Nested executions share the same workers and must not deadlock.
+  Reset(data);
+  data.m_Nested = true;
+  threader->SingleMethodExecute();
+  if( !CheckCalls(data, numberOfThreads) || data.m_NestedCalls != numberOfThreads * numberOfThreads )
+    {
+    std::cerr << "Nested execution ran " << data.m_NestedCalls << " nested pieces instead of "
+              << numberOfThreads * numberOfThreads << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // An exception in a worker is reported by SingleMethodExecute.
+  if( numberOfThreads > 1 )
+    {
+    Reset(data);
+    data.m_Throw = true;
+    bool caught = false;
+    try
+      {
+      threader->SingleMethodExecute();
+      }
+    catch( itk::ExceptionObject & e )
+      {
+      std::cout << "Caught expected exception: " << e.GetDescription() << std::endl;
+      caught = true;
+      }
+    if( !caught || !CheckCalls(data, numberOfThreads) )
+      {
+      std::cerr << "Exception in a worker was not reported" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Waiting on a group must not run the tasks of another group.
+  itk::WorkStealingThreadPool::Pointer pool = threader->GetWorkStealingThreadPool();
+  for( int i = 0; i < 100; ++i )
+    {
+    GroupTestData groupData;
+    groupData.m_CallerIsWaiting = false;
+    groupData.m_RanOnWaitingCaller = false;
+
+    itk::WorkStealingThreadPool::TaskGroup unrelatedGroup;
+    itk::WorkStealingThreadPool::Task      unrelatedTasks[16];
+    for( unsigned int t = 0; t < 16; ++t )
+      {
+      unrelatedTasks[t].m_Function = UnrelatedTask;
+      unrelatedTasks[t].m_UserData = &groupData;
+      }
+    itk::WorkStealingThreadPool::TaskGroup group;
+    itk::WorkStealingThreadPool::Task      tasks[4];
+    for( unsigned int t = 0; t < 4; ++t )
+      {
+      tasks[t].m_Function = GroupTask;
+      tasks[t].m_UserData = ITK_NULLPTR;
+      }
+
+    pool->Submit(unrelatedTasks, 16, unrelatedGroup);
+    pool->Submit(tasks, 4, group);
+    groupData.m_CallerIsWaiting = true;
+    pool->Wait(group);
+    groupData.m_CallerIsWaiting = false;
+    pool->Wait(unrelatedGroup);
+
+    if( groupData.m_RanOnWaitingCaller )
+      {
+      std::cerr << "Wait() ran a task of another group" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Number of workers: "
+            << threader->GetWorkStealingThreadPool()->GetNumberOfWorkers() << std::endl;
+
+  return EXIT_SUCCESS;
+}
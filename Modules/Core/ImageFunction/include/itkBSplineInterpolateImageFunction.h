@@ -298,6 +298,10 @@ public:
   /** Set the input image.  This must be set by the user. */
   virtual void SetInputImage(const TImageType *inputData) ITK_OVERRIDE;
 
+  /** Get the B-spline coefficients of the input image, computed by
+   * SetInputImage(). */
+  itkGetConstObjectMacro(Coefficients, CoefficientImageType);
+
   /** The UseImageDirection flag determines whether image derivatives are
    * computed with respect to the image grid or with respect to the physical
    * space. When this flag is ON the derivatives are computed with respect to
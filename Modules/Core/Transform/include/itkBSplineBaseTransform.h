@@ -25,6 +25,22 @@
 
 namespace itk
 {
+namespace BSplineBaseTransformHelpers
+{
+/** Compile time power, for the number of weights ( VSplineOrder + 1 ) ^ NDimensions. */
+template <unsigned int VBase, unsigned int VExponent>
+struct Power
+{
+  itkStaticConstMacro( Value, unsigned int, ( VBase * Power<VBase, VExponent - 1>::Value ) );
+};
+
+template <unsigned int VBase>
+struct Power<VBase, 0>
+{
+  itkStaticConstMacro( Value, unsigned int, 1 );
+};
+} // end namespace BSplineBaseTransformHelpers
+
 /** \class BSplineBaseTransform
  * \brief A base class with common elements of BSplineTransform and BSplineDeformableTransform
  *
@@ -51,6 +67,10 @@ public:
   /** The BSpline order. */
   itkStaticConstMacro( SplineOrder, unsigned int, VSplineOrder );
 
+  /** The number of weights, that is of control points supporting a point. */
+  itkStaticConstMacro( NumberOfWeights, unsigned int,
+    ( BSplineBaseTransformHelpers::Power<VSplineOrder + 1, NDimensions>::Value ) );
+
   /** implement type-specific clone method*/
   itkCloneMacro(Self);
 
@@ -62,6 +82,7 @@ public:
 
   /** Standard Jacobian container. */
   typedef typename Superclass::JacobianType JacobianType;
+  typedef typename Superclass::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
 
   /** Transform category type. */
   typedef typename Superclass::TransformCategoryType TransformCategoryType;
@@ -273,6 +294,18 @@ public:
 
   virtual void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const ITK_OVERRIDE = 0;
 
+  /** Return the number of parameters a point depends on, that is the
+   * number of weights times the space dimension. */
+  virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices() const ITK_OVERRIDE;
+
+  /** Compute the Jacobian with respect to the parameters of the control
+   * points supporting a point only, as a SpaceDimension x
+   * GetNumberOfNonZeroJacobianIndices() block. The block of column
+   * d * GetNumberOfWeights() to ( d + 1 ) * GetNumberOfWeights() - 1
+   * holds the weights of the dimension d. */
+  virtual void ComputeSparseJacobianWithRespectToParameters( const InputPointType &, JacobianType &,
+                                                             NonZeroJacobianIndicesType & ) const ITK_OVERRIDE;
+
   virtual void ComputeJacobianWithRespectToPosition( const InputPointType &, JacobianType & ) const ITK_OVERRIDE
   {
     itkExceptionMacro( << "ComputeJacobianWithRespectToPosition not yet implemented "
@@ -24,6 +24,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -305,6 +307,51 @@ BSplineBaseTransform<TScalar, NDimensions, VSplineOrder>
     }
 }
 
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+typename BSplineBaseTransform<TScalar, NDimensions, VSplineOrder>::NumberOfParametersType
+BSplineBaseTransform<TScalar, NDimensions, VSplineOrder>
+::GetNumberOfNonZeroJacobianIndices() const
+{
+  return SpaceDimension * this->GetNumberOfWeights();
+}
+
+template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineBaseTransform<TScalar, NDimensions, VSplineOrder>
+::ComputeSparseJacobianWithRespectToParameters( const InputPointType & point, JacobianType & jacobian,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  const NumberOfParametersType numberOfWeights = NumberOfWeights;
+  const NumberOfParametersType numberOfParametersPerDimension = this->GetNumberOfParametersPerDimension();
+
+  jacobian.SetSize( SpaceDimension, SpaceDimension * numberOfWeights );
+  nonZeroJacobianIndices.resize( SpaceDimension * numberOfWeights );
+
+  // Outside of the valid region, the weights and indices are zero. The
+  // arrays wrap buffers on the stack, to avoid allocating at each point.
+  typename WeightsType::ValueType weightsBuffer[NumberOfWeights];
+  typename ParameterIndexArrayType::ValueType indicesBuffer[NumberOfWeights];
+  WeightsType             weights( weightsBuffer, numberOfWeights, false );
+  ParameterIndexArrayType indices( indicesBuffer, numberOfWeights, false );
+  this->ComputeJacobianFromBSplineWeightsWithRespectToPosition( point, weights, indices );
+
+  // Each element of the Jacobian is written once: the row of the dimension d
+  // holds the weights in its block, and zeros elsewhere.
+  for( unsigned int d = 0; d < SpaceDimension; d++ )
+    {
+    const NumberOfParametersType columnOffset = d * numberOfWeights;
+    const NumberOfParametersType parameterOffset = d * numberOfParametersPerDimension;
+    typename JacobianType::element_type * row = jacobian[d];
+    std::fill( row, row + columnOffset, 0.0 );
+    for( NumberOfParametersType w = 0; w < numberOfWeights; w++ )
+      {
+      row[columnOffset + w] = weightsBuffer[w];
+      nonZeroJacobianIndices[columnOffset + w] = parameterOffset + indicesBuffer[w];
+      }
+    std::fill( row + columnOffset + numberOfWeights, row + SpaceDimension * numberOfWeights, 0.0 );
+    }
+}
+
 template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
 unsigned int
 BSplineBaseTransform<TScalar, NDimensions, VSplineOrder>
@@ -145,6 +145,9 @@ public:
   /** The number of parameters defininig this transform. */
   typedef typename Superclass::NumberOfParametersType     NumberOfParametersType;
 
+  /** Indices of the parameters of a sparse Jacobian. */
+  typedef typename Superclass::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+
   /** Optimization flags queue type */
   typedef std::deque<bool>                                TransformsToOptimizeFlagsType;
 
@@ -371,6 +374,24 @@ public:
    */
   virtual void ComputeJacobianWithRespectToParametersCachedTemporaries( const InputPointType & p, JacobianType & outJacobian, JacobianType & jacobianWithRespectToPosition ) const ITK_OVERRIDE;
 
+  /**
+   * When exactly one transform is set to be optimized, the number of non
+   * zero Jacobian indices of that transform. Otherwise, the number of
+   * parameters.
+   */
+  virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices() const ITK_OVERRIDE;
+
+  /**
+   * When exactly one transform is set to be optimized, compute its compact
+   * Jacobian at the point mapped by the transforms applied before it, and
+   * left multiply it by the Jacobians with respect to position of the
+   * transforms applied after it. The parameters of the composite transform
+   * are then the ones of that transform, so the indices are unchanged.
+   * Otherwise, fall back to the full Jacobian.
+   */
+  virtual void ComputeSparseJacobianWithRespectToParameters( const InputPointType & p, JacobianType & jacobian,
+                                                             NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const ITK_OVERRIDE;
+
 protected:
   CompositeTransform();
   virtual ~CompositeTransform();
@@ -408,6 +429,10 @@ protected:
   /** Get a list of transforms to optimize. Helper function. */
   TransformQueueType & GetTransformsToOptimizeQueue() const;
 
+  /** Get the index of the transform to optimize, when there is exactly
+   * one. Helper function. */
+  bool GetSingleTransformToOptimize( SizeValueType & index ) const;
+
   mutable TransformQueueType            m_TransformsToOptimizeQueue;
   mutable TransformsToOptimizeFlagsType m_TransformsToOptimizeFlags;
 
@@ -716,6 +716,113 @@ CompositeTransform<TScalar, NDimensions>
 }
 
 
+template <typename TScalar, unsigned int NDimensions>
+bool
+CompositeTransform<TScalar, NDimensions>
+::GetSingleTransformToOptimize( SizeValueType & index ) const
+{
+  bool found = false;
+  for( SizeValueType tind = 0; tind < this->GetNumberOfTransforms(); tind++ )
+    {
+    if( this->GetNthTransformToOptimize( tind ) )
+      {
+      if( found )
+        {
+        return false;
+        }
+      found = true;
+      index = tind;
+      }
+    }
+  return found;
+}
+
+template <typename TScalar, unsigned int NDimensions>
+typename CompositeTransform<TScalar, NDimensions>::NumberOfParametersType
+CompositeTransform<TScalar, NDimensions>
+::GetNumberOfNonZeroJacobianIndices() const
+{
+  SizeValueType index;
+  if( this->GetSingleTransformToOptimize( index ) )
+    {
+    return this->GetNthTransformConstPointer( index )->GetNumberOfNonZeroJacobianIndices();
+    }
+  return Superclass::GetNumberOfNonZeroJacobianIndices();
+}
+
+template <typename TScalar, unsigned int NDimensions>
+void
+CompositeTransform<TScalar, NDimensions>
+::ComputeSparseJacobianWithRespectToParameters( const InputPointType & p, JacobianType & jacobian,
+                                                NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  SizeValueType index;
+  if( !this->GetSingleTransformToOptimize( index ) )
+    {
+    Superclass::ComputeSparseJacobianWithRespectToParameters( p, jacobian, nonZeroJacobianIndices );
+    return;
+    }
+
+  /* The transforms are applied in reverse queue order: map the point
+   * through the transforms applied before the optimized one. */
+  OutputPointType transformedPoint( p );
+  for( SizeValueType tind = this->GetNumberOfTransforms() - 1; tind > index; --tind )
+    {
+    transformedPoint = this->GetNthTransformConstPointer( tind )->TransformPoint( transformedPoint );
+    }
+
+  const TransformType * const optimizedTransform = this->GetNthTransformConstPointer( index );
+  optimizedTransform->ComputeSparseJacobianWithRespectToParameters( transformedPoint, jacobian, nonZeroJacobianIndices );
+  if( index == 0 )
+    {
+    return;
+    }
+
+  /* Chain the Jacobians with respect to position of the transforms applied
+   * after the optimized one, then left multiply the compact block by their
+   * product, column by column. */
+  transformedPoint = optimizedTransform->TransformPoint( transformedPoint );
+  typedef Matrix<double, NDimensions, NDimensions> PositionJacobianType;
+  JacobianType         jacobianWithRespectToPosition( NDimensions, NDimensions );
+  PositionJacobianType product;
+  product.SetIdentity();
+  for( signed long tind = static_cast<signed long>( index ) - 1; tind >= 0; --tind )
+    {
+    const TransformType * const transform = this->GetNthTransformConstPointer( tind );
+    transform->ComputeJacobianWithRespectToPosition( transformedPoint, jacobianWithRespectToPosition );
+    PositionJacobianType current;
+    for( unsigned int i = 0; i < NDimensions; i++ )
+      {
+      for( unsigned int j = 0; j < NDimensions; j++ )
+        {
+        current( i, j ) = jacobianWithRespectToPosition( i, j );
+        }
+      }
+    product = current * product;
+    if( tind > 0 )
+      {
+      transformedPoint = transform->TransformPoint( transformedPoint );
+      }
+    }
+
+  double column[NDimensions];
+  for( unsigned int c = 0; c < jacobian.cols(); c++ )
+    {
+    for( unsigned int i = 0; i < NDimensions; i++ )
+      {
+      column[i] = 0.0;
+      for( unsigned int j = 0; j < NDimensions; j++ )
+        {
+        column[i] += product( i, j ) * jacobian( j, c );
+        }
+      }
+    for( unsigned int i = 0; i < NDimensions; i++ )
+      {
+      jacobian( i, c ) = column[i];
+      }
+    }
+}
+
 template <typename TScalar, unsigned int NDimensions>
 const typename CompositeTransform<TScalar, NDimensions>::ParametersType &
 CompositeTransform<TScalar, NDimensions>
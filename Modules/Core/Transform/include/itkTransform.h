@@ -25,6 +25,7 @@
 #include "itkVariableLengthVector.h"
 #include "vnl/vnl_vector_fixed.h"
 #include "itkMatrix.h"
+#include <vector>
 
 namespace itk
 {
@@ -181,6 +182,10 @@ public:
 
   typedef typename Superclass::NumberOfParametersType    NumberOfParametersType;
 
+  /** Type of the list of parameters with a possibly non-zero Jacobian
+   * column, used by ComputeSparseJacobianWithRespectToParameters. */
+  typedef std::vector<NumberOfParametersType>            NonZeroJacobianIndicesType;
+
   /**  Method to transform a point.
    * \warning This method must be thread-safe. See, e.g., its use
    * in ResampleImageFilter.
@@ -510,6 +515,31 @@ public:
     this->ComputeJacobianWithRespectToParameters(p, jacobian);
   }
 
+  /** Return the maximum number of parameters on which the transformed
+   * position of a single point can depend, i.e. the number of columns of
+   * the compact Jacobian returned by
+   * ComputeSparseJacobianWithRespectToParameters. Transforms whose
+   * parameters have a compact support, such as the B-spline transforms,
+   * return much less than GetNumberOfParameters(). */
+  virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices() const
+  {
+    return this->GetNumberOfParameters();
+  }
+
+  /** Compute the Jacobian with respect to the parameters in a compact form.
+   * On return, \c jacobian has GetNumberOfNonZeroJacobianIndices() columns,
+   * and its column \c i holds the partial derivatives with respect to the
+   * parameter \c nonZeroJacobianIndices[i]. All the other columns of the
+   * full Jacobian are zero. This lets the callers accumulate the
+   * contribution of a point to a derivative in time proportional to the
+   * support of the transform instead of to its number of parameters.
+   * The default implementation computes the full Jacobian and lists all
+   * the parameters.
+   * \c jacobian and \c nonZeroJacobianIndices are assumed to be
+   * thread-local variables, already sized to avoid memory allocation. */
+  virtual void ComputeSparseJacobianWithRespectToParameters(const InputPointType & p, JacobianType & jacobian,
+                                                            NonZeroJacobianIndicesType & nonZeroJacobianIndices) const;
+
 
   /** This provides the ability to get a local jacobian value
    *  in a dense/local transform, e.g. DisplacementFieldTransform. For such
@@ -514,6 +514,23 @@ Transform<TScalar, NInputDimensions, NOutputDimensions>
     }
 }
 
+template <typename TScalar,
+          unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+Transform<TScalar, NInputDimensions, NOutputDimensions>
+::ComputeSparseJacobianWithRespectToParameters( const InputPointType & p, JacobianType & jacobian,
+                                                NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->ComputeJacobianWithRespectToParameters( p, jacobian );
+
+  nonZeroJacobianIndices.resize( jacobian.cols() );
+  for( NumberOfParametersType i = 0; i < nonZeroJacobianIndices.size(); ++i )
+    {
+    nonZeroJacobianIndices[i] = i;
+    }
+}
+
 } // end namespace itk
 
 #endif
@@ -27,6 +27,8 @@
 
 #include "vnl/vnl_vector.h"
 
+#include <vector>
+
 namespace itk {
 
 /**
@@ -69,6 +71,13 @@ namespace itk {
  * the corrected input image and spatially smoothing those results with a
  * B-spline scalar field estimate of the bias field.
  *
+ * The voxels used to estimate the bias field are gathered once, with the
+ * log of their intensity and their position in the B-spline fitting point
+ * set. The histogram, the sharpening, the residual bias field and the
+ * convergence measurement are then computed on these voxels with
+ * the number of threads of the filter, and only the values of the point set
+ * are updated at each iteration.
+ *
  * \author Nicholas J. Tustison
  *
  * Contributed by Nicholas J. Tustison, James C. Gee in the Insight Journal
@@ -389,16 +398,18 @@ private:
   /**
    * Sharpen the intensity histogram of the current estimate of the corrected
    * image and map those results to a new estimate of the unsmoothed corrected
-   * image.
+   * image.  The difference between both estimates, which is the unsmoothed
+   * estimate of the residual bias field, is stored in the point data of the
+   * fitting point set.
    */
-  RealImagePointer SharpenImage( const RealImageType * ) const;
+  void SharpenImage();
 
   /**
    * Given the unsmoothed estimate of the bias field, this function smooths
    * the estimate and adds the resulting control point values to the total
    * bias field estimate.
    */
-  RealImagePointer UpdateBiasFieldEstimate( RealImageType * );
+  RealImagePointer UpdateBiasFieldEstimate();
 
   /**
    * Reconstruct bias field given the control point lattice.
@@ -408,8 +419,27 @@ private:
   /**
    * Convergence is determined by the coefficient of variation of the difference
    * image between the current bias field estimate and the previous estimate.
+   * The current estimate of the corrected image is updated at the same time.
    */
-  RealType CalculateConvergenceMeasurement( const RealImageType *, const RealImageType * ) const;
+  RealType CalculateConvergenceMeasurement( const RealImageType *, const RealImageType * );
+
+  /** The steps computed in parallel over the voxels used to estimate the
+   * bias field. */
+  enum VoxelStepType {
+    IntensityRangeStep,
+    HistogramStep,
+    SharpenStep,
+    ConvergenceStep
+  };
+
+  /** Run a step with the number of threads of the filter. */
+  void RunVoxelStep( VoxelStepType step );
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE VoxelStepThreaderCallback( void *arg );
+
+  /** Run the current step on the voxels from first to last (excluded). */
+  void ThreadedVoxelStep( SizeValueType first, SizeValueType last, ThreadIdType threadId );
 
   MaskPixelType m_MaskLabel;
 
@@ -436,6 +466,33 @@ private:
   ArrayType    m_NumberOfControlPoints;
   ArrayType    m_NumberOfFittingLevels;
 
+  // The voxels used to estimate the bias field: their offsets in the bias
+  // field buffer, the log of their intensity and of their current corrected
+  // intensity, and the fitting point set whose point data are the residual
+  // bias field.
+
+  std::vector<OffsetValueType> m_VoxelOffsets;
+  std::vector<RealType>        m_LogInputValues;
+  std::vector<RealType>        m_LogUncorrectedValues;
+
+  PointSetPointer                                           m_FieldPoints;
+  typename BSplineFilterType::WeightsContainerType::Pointer m_FieldWeights;
+
+  // State of the current parallel step
+
+  VoxelStepType        m_CurrentStep;
+  RealType             m_BinMinimum;
+  RealType             m_HistogramSlope;
+  vnl_vector<RealType> m_IntensityMapping;
+  const RealImageType *m_PreviousLogBiasField;
+  const RealImageType *m_CurrentLogBiasField;
+
+  std::vector<RealType>             m_ThreadBinMinimum;
+  std::vector<RealType>             m_ThreadBinMaximum;
+  std::vector<vnl_vector<RealType> > m_ThreadHistogram;
+  std::vector<RealType>             m_ThreadCount;
+  std::vector<RealType>             m_ThreadMean;
+  std::vector<RealType>             m_ThreadSquaredDeviation;
 };
 
 } // end namespace itk
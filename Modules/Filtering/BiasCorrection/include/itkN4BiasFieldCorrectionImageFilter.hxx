@@ -20,15 +20,12 @@
 
 #include "itkN4BiasFieldCorrectionImageFilter.h"
 
-#include "itkAddImageFilter.h"
 #include "itkBSplineControlPointImageFilter.h"
 #include "itkDivideImageFilter.h"
 #include "itkExpImageFilter.h"
 #include "itkImageRegionIterator.h"
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkImportImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkIterationReporter.h"
-#include "itkSubtractImageFilter.h"
 #include "itkVectorIndexSelectionCastImageFilter.h"
 
 #include "vnl/algo/vnl_fft_1d.h"
@@ -48,7 +45,12 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   m_ConvergenceThreshold( 0.001 ),
   m_CurrentConvergenceMeasurement( NumericTraits<RealType>::ZeroValue() ),
   m_CurrentLevel( 0 ),
-  m_SplineOrder( 3 )
+  m_SplineOrder( 3 ),
+  m_CurrentStep( IntensityRangeStep ),
+  m_BinMinimum( NumericTraits<RealType>::ZeroValue() ),
+  m_HistogramSlope( NumericTraits<RealType>::ZeroValue() ),
+  m_PreviousLogBiasField( ITK_NULLPTR ),
+  m_CurrentLogBiasField( ITK_NULLPTR )
 {
   this->SetNumberOfRequiredInputs( 1 );
 
@@ -72,30 +74,39 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   typedef typename InputImageType::RegionType RegionType;
   const RegionType inputRegion = inputImage->GetBufferedRegion();
 
-  // Calculate the log of the input image.
-  RealImagePointer logInputImage = RealImageType::New();
-  logInputImage->CopyInformation( inputImage );
-  logInputImage->SetRegions( inputRegion );
-  logInputImage->Allocate( false );
-
-  ImageRegionConstIterator<InputImageType> inpItr( inputImage, inputRegion );
-  ImageRegionIterator<RealImageType> outItr( logInputImage, inputRegion );
+  // Provide an initial log bias field of zeros
 
-  inpItr.GoToBegin();
-  outItr.GoToBegin();
+  RealImagePointer logBiasField = RealImageType::New();
+  logBiasField->CopyInformation( inputImage );
+  logBiasField->SetRegions( inputImage->GetLargestPossibleRegion() );
+  logBiasField->Allocate( true ); // initialize buffer to zero
 
-  while( !inpItr.IsAtEnd() )
-    {
-    outItr.Set( static_cast< RealType >( inpItr.Get() ) );
-    ++inpItr;
-    ++outItr;
-    }
+  // Gather the voxels used to estimate the bias field with the log of
+  // their intensity.  Since the B-spline approximation algorithm works in
+  // parametric space and not physical space, their positions in the fitting
+  // point set ignore the direction cosine.  The positions and the weights
+  // of the points don't change, so the point set is only built once.
 
   const MaskImageType * maskImage = this->GetMaskImage();
   const RealImageType * confidenceImage = this->GetConfidenceImage();
 
-  ImageRegionIteratorWithIndex<RealImageType> It( logInputImage, inputRegion );
+  this->m_VoxelOffsets.clear();
+  this->m_LogInputValues.clear();
+
+  this->m_FieldPoints = PointSetType::New();
+  this->m_FieldPoints->Initialize();
+  typename PointSetType::PointsContainer::STLContainerType & points =
+    this->m_FieldPoints->GetPoints()->CastToSTLContainer();
+
+  this->m_FieldWeights = BSplineFilterType::WeightsContainerType::New();
+  this->m_FieldWeights->Initialize();
+  typename BSplineFilterType::WeightsContainerType::STLContainerType & weights =
+    this->m_FieldWeights->CastToSTLContainer();
 
+  const typename InputImageType::PointType origin = inputImage->GetOrigin();
+  const typename InputImageType::SpacingType spacing = inputImage->GetSpacing();
+
+  ImageRegionConstIteratorWithIndex<InputImageType> It( inputImage, inputRegion );
   for( It.GoToBegin(); !It.IsAtEnd(); ++It )
     {
     if( ( !maskImage ||
@@ -103,28 +114,31 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
         && ( !confidenceImage ||
              confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
       {
+      RealType pixel = static_cast< RealType >( It.Get() );
       if( It.Get() > NumericTraits<typename InputImageType::PixelType>::ZeroValue() )
         {
-        It.Set( std::log( static_cast< RealType >( It.Get() ) ) );
+        pixel = std::log( pixel );
         }
-      }
-    }
-
-  // Duplicate logInputImage since we reuse the original at each iteration.
-
-  typedef ImageDuplicator<RealImageType> DuplicatorType;
-  typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
-  duplicator->SetInputImage( logInputImage );
-  duplicator->Update();
+      this->m_VoxelOffsets.push_back( logBiasField->ComputeOffset( It.GetIndex() ) );
+      this->m_LogInputValues.push_back( pixel );
 
-  RealImagePointer logUncorrectedImage = duplicator->GetModifiableOutput();
-
-  // Provide an initial log bias field of zeros
+      PointType point;
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        point[d] = origin[d] + spacing[d] * It.GetIndex()[d];
+        }
+      points.push_back( point );
 
-  RealImagePointer logBiasField = RealImageType::New();
-  logBiasField->CopyInformation( inputImage );
-  logBiasField->SetRegions( inputImage->GetLargestPossibleRegion() );
-  logBiasField->Allocate( true ); // initialize buffer to zero
+      RealType confidenceWeight = 1.0;
+      if( confidenceImage )
+        {
+        confidenceWeight = confidenceImage->GetPixel( It.GetIndex() );
+        }
+      weights.push_back( confidenceWeight );
+      }
+    }
+  this->m_LogUncorrectedValues = this->m_LogInputValues;
+  this->m_FieldPoints->GetPointData()->CastToSTLContainer().resize( points.size() );
 
   // Iterate until convergence or iterative exhaustion.
   unsigned int maximumNumberOfLevels = 1;
@@ -153,35 +167,22 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
            this->m_CurrentConvergenceMeasurement > this->m_ConvergenceThreshold )
       {
 
-      // Sharpen the current estimate of the uncorrected image.
-
-      RealImagePointer logSharpenedImage = this->SharpenImage( logUncorrectedImage );
-
-      typedef SubtractImageFilter<RealImageType, RealImageType, RealImageType>
-      SubtracterType;
-      typename SubtracterType::Pointer subtracter1 = SubtracterType::New();
-      subtracter1->SetInput1( logUncorrectedImage );
-      subtracter1->SetInput2( logSharpenedImage );
+      // Sharpen the current estimate of the uncorrected image, which
+      // gives the residual bias field.
 
-      RealImagePointer residualBiasField = subtracter1->GetOutput();
-      residualBiasField->Update();
+      this->SharpenImage();
 
       // Smooth the residual bias field estimate and add the resulting
       // control point grid to get the new total bias field estimate.
 
-      RealImagePointer newLogBiasField = this->UpdateBiasFieldEstimate( residualBiasField );
+      RealImagePointer newLogBiasField = this->UpdateBiasFieldEstimate();
+
+      // Also update the estimate of the uncorrected image.
 
       this->m_CurrentConvergenceMeasurement =
         this->CalculateConvergenceMeasurement( logBiasField, newLogBiasField );
       logBiasField = newLogBiasField;
 
-      typename SubtracterType::Pointer subtracter2 = SubtracterType::New();
-      subtracter2->SetInput1( logInputImage );
-      subtracter2->SetInput2( logBiasField );
-
-      logUncorrectedImage = subtracter2->GetOutput();
-      logUncorrectedImage->Update();
-
       reporter.CompletedStep();
       }
 
@@ -194,6 +195,7 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
     reconstructer->SetDirection( logBiasField->GetDirection() );
     reconstructer->SetSize( logBiasField->GetLargestPossibleRegion().GetSize() );
     reconstructer->SetSplineOrder( this->m_SplineOrder );
+    reconstructer->SetNumberOfThreads( this->GetNumberOfThreads() );
     reconstructer->Update();
 
     typename BSplineReconstructerType::ArrayType numberOfLevels;
@@ -210,9 +212,16 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
       RefineControlPointLattice( numberOfLevels );
     }
 
+  this->m_VoxelOffsets.clear();
+  this->m_LogInputValues.clear();
+  this->m_LogUncorrectedValues.clear();
+  this->m_FieldPoints = ITK_NULLPTR;
+  this->m_FieldWeights = ITK_NULLPTR;
+
   typedef ExpImageFilter<RealImageType, RealImageType> ExpImageFilterType;
   typename ExpImageFilterType::Pointer expFilter = ExpImageFilterType::New();
   expFilter->SetInput( logBiasField );
+  expFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
   expFilter->Update();
 
   // Divide the input image by the bias field to get the final image.
@@ -222,6 +231,7 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   typename DividerType::Pointer divider = DividerType::New();
   divider->SetInput1( inputImage );
   divider->SetInput2( expFilter->GetOutput() );
+  divider->SetNumberOfThreads( this->GetNumberOfThreads() );
   divider->GraftOutput( this->GetOutput() );
   divider->Update();
 
@@ -229,42 +239,23 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
-typename
-N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
+void
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
-::SharpenImage( const RealImageType *unsharpenedImage ) const
+::SharpenImage()
 {
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
-
   // Build the histogram for the uncorrected image.  Store copy
   // in a vnl_vector to utilize vnl FFT routines.  Note that variables
   // in real space are denoted by a single uppercase letter whereas their
   // frequency counterparts are indicated by a trailing lowercase 'f'.
 
+  this->RunVoxelStep( IntensityRangeStep );
+
   RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
   RealType binMinimum = NumericTraits<RealType>::max();
-
-  ImageRegionConstIterator<RealImageType> ItU(
-    unsharpenedImage, unsharpenedImage->GetLargestPossibleRegion() );
-
-  for( ItU.GoToBegin(); !ItU.IsAtEnd(); ++ItU )
+  for( unsigned int n = 0; n < this->m_ThreadBinMaximum.size(); n++ )
     {
-    if( ( !maskImage ||
-          maskImage->GetPixel( ItU.GetIndex() ) == this->m_MaskLabel )
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
-      {
-      RealType pixel = ItU.Get();
-      if( pixel > binMaximum )
-        {
-        binMaximum = pixel;
-        }
-      else if( pixel < binMinimum )
-        {
-        binMinimum = pixel;
-        }
-      }
+    binMaximum = vnl_math_max( binMaximum, this->m_ThreadBinMaximum[n] );
+    binMinimum = vnl_math_min( binMinimum, this->m_ThreadBinMinimum[n] );
     }
   RealType histogramSlope = ( binMaximum - binMinimum ) /
     static_cast<RealType>( this->m_NumberOfHistogramBins - 1 );
@@ -272,32 +263,14 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   // Create the intensity profile (within the masked region, if applicable)
   // using a triangular parzen windowing scheme.
 
-  vnl_vector<RealType> H( this->m_NumberOfHistogramBins, 0.0 );
+  this->m_BinMinimum = binMinimum;
+  this->m_HistogramSlope = histogramSlope;
+  this->RunVoxelStep( HistogramStep );
 
-  for( ItU.GoToBegin(); !ItU.IsAtEnd(); ++ItU )
+  vnl_vector<RealType> H( this->m_NumberOfHistogramBins, 0.0 );
+  for( unsigned int n = 0; n < this->m_ThreadHistogram.size(); n++ )
     {
-    if( ( !maskImage ||
-          maskImage->GetPixel( ItU.GetIndex() ) == this->m_MaskLabel )
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
-      {
-      RealType pixel = ItU.Get();
-
-      RealType cidx = ( static_cast<RealType>( pixel ) - binMinimum ) /
-        histogramSlope;
-      unsigned int idx = vnl_math_floor( cidx );
-      RealType     offset = cidx - static_cast<RealType>( idx );
-
-      if( offset == 0.0 )
-        {
-        H[idx] += 1.0;
-        }
-      else if( idx < this->m_NumberOfHistogramBins - 1 )
-        {
-        H[idx] += 1.0 - offset;
-        H[idx+1] += offset;
-        }
-      }
+    H += this->m_ThreadHistogram[n];
     }
 
   // Determine information about the intensity histogram and zero-pad
@@ -425,112 +398,21 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 
   // Remove the zero-padding from the mapping.
 
-  E = E.extract( this->m_NumberOfHistogramBins, histogramOffset );
-
-  const InputImageType * inputImage = this->GetInput();
-
-  // Sharpen the image with the new mapping, E(u|v)
-  RealImagePointer sharpenedImage = RealImageType::New();
-  sharpenedImage->CopyInformation( inputImage );
-  sharpenedImage->SetRegions( inputImage->GetLargestPossibleRegion() );
-  sharpenedImage->Allocate( true ); // initialize buffer to zero
-
-  ImageRegionIterator<RealImageType> ItC(
-    sharpenedImage, sharpenedImage->GetLargestPossibleRegion() );
+  this->m_IntensityMapping = E.extract( this->m_NumberOfHistogramBins, histogramOffset );
 
-  for( ItU.GoToBegin(), ItC.GoToBegin(); !ItU.IsAtEnd(); ++ItU, ++ItC )
-    {
-    if( ( !maskImage ||
-          maskImage->GetPixel( ItU.GetIndex() ) == this->m_MaskLabel )
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
-      {
-      RealType     cidx = ( ItU.Get() - binMinimum ) / histogramSlope;
-      unsigned int idx = vnl_math_floor( cidx );
+  // Sharpen the image with the new mapping, E(u|v), and store the residual
+  // bias field in the point set.
 
-      RealType correctedPixel = 0;
-      if( idx < E.size() - 1 )
-        {
-        correctedPixel = E[idx] + ( E[idx + 1] - E[idx] )
-          * ( cidx - static_cast<RealType>( idx ) );
-        }
-      else
-        {
-        correctedPixel = E[E.size() - 1];
-        }
-      ItC.Set( correctedPixel );
-      }
-    }
-
-  return sharpenedImage;
+  this->RunVoxelStep( SharpenStep );
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
 typename
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
-::UpdateBiasFieldEstimate( RealImageType* fieldEstimate )
+::UpdateBiasFieldEstimate()
 {
-  // Temporarily set the direction cosine to identity since the B-spline
-  // approximation algorithm works in parametric space and not physical
-  // space.
-  typename ScalarImageType::DirectionType identity;
-  identity.SetIdentity();
-
-  const typename ScalarImageType::RegionType & bufferedRegion = fieldEstimate->GetBufferedRegion();
-  const SizeValueType numberOfPixels = bufferedRegion.GetNumberOfPixels();
-  const bool filterHandlesMemory = false;
-
-  typedef ImportImageFilter<RealType, ImageDimension> ImporterType;
-  typename ImporterType::Pointer importer = ImporterType::New();
-  importer->SetImportPointer( fieldEstimate->GetBufferPointer(), numberOfPixels, filterHandlesMemory );
-  importer->SetRegion( fieldEstimate->GetBufferedRegion() );
-  importer->SetOrigin( fieldEstimate->GetOrigin() );
-  importer->SetSpacing( fieldEstimate->GetSpacing() );
-  importer->SetDirection( identity );
-  importer->Update();
-
-  const typename ImporterType::OutputImageType * parametricFieldEstimate = importer->GetOutput();
-
-  PointSetPointer fieldPoints = PointSetType::New();
-  fieldPoints->Initialize();
-
-  typename BSplineFilterType::WeightsContainerType::Pointer weights =
-    BSplineFilterType::WeightsContainerType::New();
-  weights->Initialize();
-
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
-
-  ImageRegionConstIteratorWithIndex<RealImageType>
-    It( parametricFieldEstimate, parametricFieldEstimate->GetRequestedRegion() );
-
-  unsigned int index = 0;
-  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
-    {
-    if( ( !maskImage ||
-          maskImage->GetPixel( It.GetIndex() ) == this->m_MaskLabel )
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
-      {
-      PointType point;
-      parametricFieldEstimate->TransformIndexToPhysicalPoint( It.GetIndex(), point );
-
-      ScalarType scalar;
-      scalar[0] = It.Get();
-
-      fieldPoints->SetPointData( index, scalar );
-      fieldPoints->SetPoint( index, point );
-
-      RealType confidenceWeight = 1.0;
-      if( confidenceImage )
-        {
-        confidenceWeight = confidenceImage->GetPixel( It.GetIndex() );
-        }
-      weights->InsertElement( index, confidenceWeight );
-      index++;
-      }
-    }
+  const InputImageType * inputImage = this->GetInput();
 
   typename BSplineFilterType::Pointer bspliner = BSplineFilterType::New();
 
@@ -551,23 +433,24 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
     }
 
   typename ScalarImageType::PointType parametricOrigin =
-    fieldEstimate->GetOrigin();
+    inputImage->GetOrigin();
   for( unsigned int d = 0; d < ImageDimension; d++ )
     {
     parametricOrigin[d] += (
-        fieldEstimate->GetSpacing()[d] *
-        fieldEstimate->GetLargestPossibleRegion().GetIndex()[d] );
+        inputImage->GetSpacing()[d] *
+        inputImage->GetLargestPossibleRegion().GetIndex()[d] );
     }
   bspliner->SetOrigin( parametricOrigin );
-  bspliner->SetSpacing( fieldEstimate->GetSpacing() );
-  bspliner->SetSize( fieldEstimate->GetLargestPossibleRegion().GetSize() );
-  bspliner->SetDirection( fieldEstimate->GetDirection() );
+  bspliner->SetSpacing( inputImage->GetSpacing() );
+  bspliner->SetSize( inputImage->GetLargestPossibleRegion().GetSize() );
+  bspliner->SetDirection( inputImage->GetDirection() );
   bspliner->SetGenerateOutputImage( false );
   bspliner->SetNumberOfLevels( numberOfFittingLevels );
   bspliner->SetSplineOrder( this->m_SplineOrder );
   bspliner->SetNumberOfControlPoints( numberOfControlPoints );
-  bspliner->SetInput( fieldPoints );
-  bspliner->SetPointWeights( weights );
+  bspliner->SetInput( this->m_FieldPoints );
+  bspliner->SetPointWeights( this->m_FieldWeights );
+  bspliner->SetNumberOfThreads( this->GetNumberOfThreads() );
   bspliner->Update();
 
   typename BiasFieldControlPointLatticeType::Pointer phiLattice = bspliner->GetPhiLattice();
@@ -580,21 +463,16 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
     }
   else
     {
-    // Ensure that the two lattices occupy the same physical space.  Not
-    // necessary for performance since the parameters of the reconstructed
-    // bias field are specified later in this function in the reconstructer.
-    phiLattice->CopyInformation( this->m_LogBiasFieldControlPointLattice );
-
-    typedef AddImageFilter<BiasFieldControlPointLatticeType,
-                           BiasFieldControlPointLatticeType,
-                           BiasFieldControlPointLatticeType>
-      AdderType;
-    typename AdderType::Pointer adder = AdderType::New();
-    adder->SetInput1( this->m_LogBiasFieldControlPointLattice );
-    adder->SetInput2( phiLattice );
-    adder->Update();
-
-    this->m_LogBiasFieldControlPointLattice = adder->GetOutput();
+    // Add the control points in place, the two lattices have the same size.
+    ImageRegionIterator<BiasFieldControlPointLatticeType> ItL(
+      this->m_LogBiasFieldControlPointLattice,
+      this->m_LogBiasFieldControlPointLattice->GetLargestPossibleRegion() );
+    ImageRegionConstIterator<BiasFieldControlPointLatticeType> ItP(
+      phiLattice, phiLattice->GetLargestPossibleRegion() );
+    for( ItL.GoToBegin(), ItP.GoToBegin(); !ItL.IsAtEnd(); ++ItL, ++ItP )
+      {
+      ItL.Set( ItL.Get() + ItP.Get() );
+      }
     }
 
   RealImagePointer smoothField = this->ReconstructBiasField( this->m_LogBiasFieldControlPointLattice );
@@ -620,6 +498,7 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   reconstructer->SetDirection( inputImage->GetDirection() );
   reconstructer->SetSplineOrder( this->m_SplineOrder );
   reconstructer->SetSize( inputImage->GetLargestPossibleRegion().GetSize() );
+  reconstructer->SetNumberOfThreads( this->GetNumberOfThreads() );
 
   typename ScalarImageType::Pointer biasFieldBsplineImage = reconstructer->GetOutput();
   biasFieldBsplineImage->Update();
@@ -629,6 +508,7 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   typename SelectorType::Pointer selector = SelectorType::New();
   selector->SetInput( biasFieldBsplineImage );
   selector->SetIndex( 0 );
+  selector->SetNumberOfThreads( this->GetNumberOfThreads() );
 
   RealImagePointer biasField = selector->GetOutput();
   biasField->Update();
@@ -644,48 +524,186 @@ typename
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealType
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 ::CalculateConvergenceMeasurement( const RealImageType *fieldEstimate1,
-                                   const RealImageType *fieldEstimate2 ) const
+                                   const RealImageType *fieldEstimate2 )
 {
-  typedef SubtractImageFilter<RealImageType, RealImageType, RealImageType>
-    SubtracterType;
-  typename SubtracterType::Pointer subtracter = SubtracterType::New();
-  subtracter->SetInput1( fieldEstimate1 );
-  subtracter->SetInput2( fieldEstimate2 );
-  subtracter->Update();
+  // Calculate statistics over the mask region, for each thread, then merge
+  // them.
 
-  // Calculate statistics over the mask region
+  this->m_PreviousLogBiasField = fieldEstimate1;
+  this->m_CurrentLogBiasField = fieldEstimate2;
+  this->RunVoxelStep( ConvergenceStep );
+  this->m_PreviousLogBiasField = ITK_NULLPTR;
+  this->m_CurrentLogBiasField = ITK_NULLPTR;
 
   RealType mu = 0.0;
   RealType sigma = 0.0;
   RealType N = 0.0;
 
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
+  for( unsigned int n = 0; n < this->m_ThreadCount.size(); n++ )
+    {
+    const RealType threadN = this->m_ThreadCount[n];
+    if( threadN == 0.0 )
+      {
+      continue;
+      }
+    const RealType delta = this->m_ThreadMean[n] - mu;
+    const RealType totalN = N + threadN;
+    sigma += this->m_ThreadSquaredDeviation[n] + vnl_math_sqr( delta ) * N * threadN / totalN;
+    mu += delta * threadN / totalN;
+    N = totalN;
+    }
+  sigma = std::sqrt( sigma / ( N - 1.0 ) );
 
-  ImageRegionConstIteratorWithIndex<RealImageType> It(
-    subtracter->GetOutput(),
-    subtracter->GetOutput()->GetLargestPossibleRegion() );
+  return ( sigma / mu );
+}
 
-  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+void
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::RunVoxelStep( VoxelStepType step )
+{
+  this->m_CurrentStep = step;
+
+  MultiThreader *multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const ThreadIdType numberOfThreads = multiThreader->GetNumberOfThreads();
+
+  this->m_ThreadBinMinimum.assign( numberOfThreads, NumericTraits<RealType>::max() );
+  this->m_ThreadBinMaximum.assign( numberOfThreads, NumericTraits<RealType>::NonpositiveMin() );
+  this->m_ThreadCount.assign( numberOfThreads, 0.0 );
+  this->m_ThreadMean.assign( numberOfThreads, 0.0 );
+  this->m_ThreadSquaredDeviation.assign( numberOfThreads, 0.0 );
+  if( step == HistogramStep )
     {
-    if( ( !maskImage ||
-          maskImage->GetPixel( It.GetIndex() ) == this->m_MaskLabel )
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
+    this->m_ThreadHistogram.assign( numberOfThreads,
+      vnl_vector<RealType>( this->m_NumberOfHistogramBins, 0.0 ) );
+    }
+
+  multiThreader->SetSingleMethod( this->VoxelStepThreaderCallback, this );
+  multiThreader->SingleMethodExecute();
+}
+
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+ITK_THREAD_RETURN_TYPE
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::VoxelStepThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self *filter = static_cast<Self *>( info->UserData );
+
+  const SizeValueType numberOfVoxels = filter->m_VoxelOffsets.size();
+  const SizeValueType first = numberOfVoxels * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType last = numberOfVoxels * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  filter->ThreadedVoxelStep( first, last, info->ThreadID );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+void
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::ThreadedVoxelStep( SizeValueType first, SizeValueType last, ThreadIdType threadId )
+{
+  switch( this->m_CurrentStep )
+    {
+    case IntensityRangeStep:
+      {
+      RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
+      RealType binMinimum = NumericTraits<RealType>::max();
+      for( SizeValueType i = first; i < last; i++ )
+        {
+        const RealType pixel = this->m_LogUncorrectedValues[i];
+        if( pixel > binMaximum )
+          {
+          binMaximum = pixel;
+          }
+        if( pixel < binMinimum )
+          {
+          binMinimum = pixel;
+          }
+        }
+      this->m_ThreadBinMaximum[threadId] = binMaximum;
+      this->m_ThreadBinMinimum[threadId] = binMinimum;
+      break;
+      }
+    case HistogramStep:
       {
-      RealType pixel = std::exp( It.Get() );
-      N += 1.0;
+      vnl_vector<RealType> & H = this->m_ThreadHistogram[threadId];
+      for( SizeValueType i = first; i < last; i++ )
+        {
+        RealType cidx = ( this->m_LogUncorrectedValues[i] - this->m_BinMinimum ) /
+          this->m_HistogramSlope;
+        unsigned int idx = vnl_math_floor( cidx );
+        RealType     offset = cidx - static_cast<RealType>( idx );
+
+        if( offset == 0.0 )
+          {
+          H[idx] += 1.0;
+          }
+        else if( idx < this->m_NumberOfHistogramBins - 1 )
+          {
+          H[idx] += 1.0 - offset;
+          H[idx+1] += offset;
+          }
+        }
+      break;
+      }
+    case SharpenStep:
+      {
+      const vnl_vector<RealType> & E = this->m_IntensityMapping;
+      typename PointSetType::PointDataContainer::STLContainerType & residuals =
+        this->m_FieldPoints->GetPointData()->CastToSTLContainer();
+      for( SizeValueType i = first; i < last; i++ )
+        {
+        RealType     cidx = ( this->m_LogUncorrectedValues[i] - this->m_BinMinimum ) /
+          this->m_HistogramSlope;
+        unsigned int idx = vnl_math_floor( cidx );
+
+        RealType correctedPixel = 0;
+        if( idx < E.size() - 1 )
+          {
+          correctedPixel = E[idx] + ( E[idx + 1] - E[idx] )
+            * ( cidx - static_cast<RealType>( idx ) );
+          }
+        else
+          {
+          correctedPixel = E[E.size() - 1];
+          }
+        residuals[i][0] = this->m_LogUncorrectedValues[i] - correctedPixel;
+        }
+      break;
+      }
+    case ConvergenceStep:
+      {
+      const RealType *previous = this->m_PreviousLogBiasField->GetBufferPointer();
+      const RealType *current = this->m_CurrentLogBiasField->GetBufferPointer();
 
-      if( N > 1.0 )
+      RealType mu = 0.0;
+      RealType sigma = 0.0;
+      RealType N = 0.0;
+      for( SizeValueType i = first; i < last; i++ )
         {
-        sigma = sigma + vnl_math_sqr( pixel - mu ) * ( N - 1.0 ) / N;
+        const OffsetValueType offset = this->m_VoxelOffsets[i];
+
+        RealType pixel = std::exp( previous[offset] - current[offset] );
+        N += 1.0;
+
+        if( N > 1.0 )
+          {
+          sigma = sigma + vnl_math_sqr( pixel - mu ) * ( N - 1.0 ) / N;
+          }
+        mu = mu * ( 1.0 - 1.0 / N ) + pixel / N;
+
+        this->m_LogUncorrectedValues[i] = this->m_LogInputValues[i] - current[offset];
         }
-      mu = mu * ( 1.0 - 1.0 / N ) + pixel / N;
+      this->m_ThreadCount[threadId] = N;
+      this->m_ThreadMean[threadId] = mu;
+      this->m_ThreadSquaredDeviation[threadId] = sigma;
+      break;
       }
     }
-  sigma = std::sqrt( sigma / ( N - 1.0 ) );
-
-  return ( sigma / mu );
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkN4BiasFieldCorrectionImageFilter.h"
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension >                                     ImageType;
+typedef itk::Image< unsigned char, Dimension >                             MaskImageType;
+typedef itk::N4BiasFieldCorrectionImageFilter< ImageType, MaskImageType >  CorrecterType;
+
+// The standard deviation of the log of the intensity of the brightest
+// class in the mask.
+double LogStandardDeviation(const ImageType *image, const ImageType *classes, const MaskImageType *mask)
+{
+  double sum = 0.0;
+  double squaredSum = 0.0;
+  double n = 0.0;
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( mask->GetPixel( it.GetIndex() ) == 1 && classes->GetPixel( it.GetIndex() ) > 150 )
+      {
+      const double value = std::log( static_cast< double >( it.Get() ) );
+      sum += value;
+      squaredSum += value * value;
+      n += 1.0;
+      }
+    }
+  return std::sqrt( ( squaredSum - sum * sum / n ) / ( n - 1.0 ) );
+}
+
+CorrecterType::Pointer Correct(const ImageType *image, const MaskImageType *mask,
+                               itk::ThreadIdType numberOfThreads)
+{
+  CorrecterType::Pointer correcter = CorrecterType::New();
+  correcter->SetInput( image );
+  correcter->SetMaskImage( mask );
+  correcter->SetNumberOfThreads( numberOfThreads );
+
+  CorrecterType::ArrayType numberOfFittingLevels;
+  numberOfFittingLevels.Fill( 2 );
+  correcter->SetNumberOfFittingLevels( numberOfFittingLevels );
+
+  CorrecterType::VariableSizeArrayType maximumNumberOfIterations( 2 );
+  maximumNumberOfIterations.Fill( 10 );
+  correcter->SetMaximumNumberOfIterations( maximumNumberOfIterations );
+
+  // run all the iterations, so that the numbers of threads can be compared
+  correcter->SetConvergenceThreshold( 0.0 );
+  correcter->Update();
+  return correcter;
+}
+}
+
+int itkN4BiasFieldCorrectionImageFilterParallelTest(int, char* [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  ImageType::SizeType size;
+  size[0] = 48;
+  size[1] = 40;
+  size[2] = 32;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.0;
+  spacing[2] = 1.5;
+
+  // Two classes in a sphere, corrupted by a smooth multiplicative bias
+  // field and a little noise.
+  ImageType::Pointer classes = ImageType::New();
+  classes->SetRegions( size );
+  classes->SetSpacing( spacing );
+  classes->Allocate();
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->Allocate();
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( size );
+  mask->SetSpacing( spacing );
+  mask->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    double squaredRadius = 0.0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      const double x = ( index[d] - 0.5 * ( size[d] - 1 ) ) * spacing[d];
+      squaredRadius += x * x;
+      }
+    const float classValue = ( ( index[0] / 6 + index[1] / 6 ) % 2 ) ? 200.0f : 100.0f;
+    const double bias = std::exp( 0.3 * index[0] / size[0] - 0.2 * index[1] / size[1]
+                                  + 0.1 * index[2] / size[2] );
+    classes->SetPixel( index, classValue );
+    mask->SetPixel( index, squaredRadius < 18.0 * 18.0 ? 1 : 0 );
+    it.Set( static_cast< float >( classValue * bias * ( 1.0 + 0.01 * generator->GetNormalVariate() ) ) );
+    }
+
+  try
+    {
+    CorrecterType::Pointer serial = Correct( image, mask, 1 );
+
+    const double inputDeviation = LogStandardDeviation( image, classes, mask );
+    const double correctedDeviation = LogStandardDeviation( serial->GetOutput(), classes, mask );
+    std::cout << "Standard deviation of the log intensity of a class: "
+              << inputDeviation << " before correction, "
+              << correctedDeviation << " after" << std::endl;
+    if( !( correctedDeviation < 0.5 * inputDeviation ) )
+      {
+      std::cerr << "The bias field was not corrected" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    for( itk::ThreadIdType numberOfThreads = 2; numberOfThreads <= 4; numberOfThreads++ )
+      {
+      CorrecterType::Pointer parallel = Correct( image, mask, numberOfThreads );
+
+      // the histograms are summed in another order, so the outputs only
+      // differ by rounding errors
+      double maximumError = 0.0;
+      itk::ImageRegionConstIteratorWithIndex< ImageType > st( serial->GetOutput(), image->GetLargestPossibleRegion() );
+      itk::ImageRegionConstIteratorWithIndex< ImageType > pt( parallel->GetOutput(), image->GetLargestPossibleRegion() );
+      for( ; !st.IsAtEnd(); ++st, ++pt )
+        {
+        maximumError = std::max( maximumError,
+          std::fabs( static_cast< double >( st.Get() ) - pt.Get() ) / ( 1.0 + std::fabs( st.Get() ) ) );
+        }
+      std::cout << numberOfThreads << " threads: maximum relative difference "
+                << maximumError << ", convergence measurement "
+                << parallel->GetCurrentConvergenceMeasurement() << std::endl;
+      if( maximumError > 1e-3 )
+        {
+        std::cerr << "The outputs differ with " << numberOfThreads << " threads" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
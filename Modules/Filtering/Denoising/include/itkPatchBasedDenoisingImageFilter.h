@@ -53,6 +53,10 @@ namespace itk
  * scheme for defining patch weights (mask) as described in Awate and Whitaker 2005 IEEE CVPR and
  * 2006 IEEE TPAMI.
  *
+ * For images of scalar pixels, the distances between the patches are computed
+ * directly from the pixel buffer, skipping the patch pixels of zero weight,
+ * with buffers that each thread reuses from one pixel to the next.
+ *
  * \ingroup Filtering
  * \ingroup ITKDenoising
  * \sa PatchBasedDenoisingBaseImageFilter
@@ -135,6 +139,13 @@ public:
     BaseSamplerPointer sampler;
     EigenValuesCacheType eigenValsCache;
     EigenVectorsCacheType eigenVecsCache;
+    // buffers reused by the patch distances of scalar images
+    typename BaseSamplerType::SubsamplePointer selectedPatches;
+    std::vector<OffsetValueType> patchOffsets;
+    std::vector<RealValueType> patchSquaredWeights;
+    std::vector<OffsetValueType> validPatchOffsets;
+    std::vector<RealValueType> validPatchSquaredWeights;
+    std::vector<RealValueType> validPatchValues;
     };
 
   /** Set/Get flag indicating whether smooth-disc patch weights should be used.
@@ -523,6 +534,22 @@ private:
 
   RealType AddEuclideanUpdate(const RealType& a, const RealType& b);
 
+  /** Compute the gradient of the joint entropy through the patch
+   * iterators, for any pixel type. */
+  RealType InternalComputeGradientJointEntropy(InstanceIdentifier id,
+                                               typename ListAdaptorType::Pointer& inList,
+                                               BaseSamplerPointer& sampler,
+                                               ThreadDataStruct& threadData,
+                                               const FalseType &);
+
+  /** Compute the gradient of the joint entropy from the pixel buffer,
+   * for scalar pixels. */
+  RealType InternalComputeGradientJointEntropy(InstanceIdentifier id,
+                                               typename ListAdaptorType::Pointer& inList,
+                                               BaseSamplerPointer& sampler,
+                                               ThreadDataStruct& threadData,
+                                               const TrueType &);
+
   /** Returns the Exp map */
   RealType AddExponentialMapUpdate(const DiffusionTensor3D<RealValueType>& spdMatrix,
                                    const DiffusionTensor3D<RealValueType>& symMatrix);
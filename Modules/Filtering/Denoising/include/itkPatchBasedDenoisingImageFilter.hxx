@@ -1418,6 +1418,9 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
       m_ThreadData[thread].maxNorm[ic] = 0;
       }
 
+    // the patch weights may have changed since the last iteration
+    m_ThreadData[thread].patchOffsets.clear();
+
     // provide a sampler to the thread
     m_ThreadData[thread].sampler = dynamic_cast<BaseSamplerType*>(m_Sampler->Clone().GetPointer() );
     typename ListAdaptorType::Pointer searchList = ListAdaptorType::New();
@@ -2266,6 +2269,19 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
                               typename ListAdaptorType::Pointer& inList,
                               BaseSamplerPointer& sampler,
                               ThreadDataStruct& threadData)
+{
+  return this->InternalComputeGradientJointEntropy(id, inList, sampler, threadData,
+                                                   IsSame<PixelType, PixelValueType>() );
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::RealType
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
+::InternalComputeGradientJointEntropy(InstanceIdentifier id,
+                                      typename ListAdaptorType::Pointer& inList,
+                                      BaseSamplerPointer& sampler,
+                                      ThreadDataStruct& threadData,
+                                      const FalseType &)
 {
   typedef typename OutputImageType::IndexType IndexType;
 
@@ -2496,7 +2512,124 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
     }
 
   return gradientJointEntropy;
-} // end ComputeGradientJointEntropy
+} // end InternalComputeGradientJointEntropy
+
+template <typename TInputImage, typename TOutputImage>
+typename PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::RealType
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
+::InternalComputeGradientJointEntropy(InstanceIdentifier id,
+                                      typename ListAdaptorType::Pointer& inList,
+                                      BaseSamplerPointer& sampler,
+                                      ThreadDataStruct& threadData,
+                                      const TrueType &)
+{
+  const InputImagePatchIterator currentPatch = inList->GetMeasurementVector(id)[0];
+  const typename OutputImageType::IndexType nIndex = currentPatch.GetIndex();
+  const OutputImageType *output = this->m_OutputImage;
+  const InstanceIdentifier currentPatchId = output->ComputeOffset(nIndex);
+
+  const unsigned int lengthPatch = this->GetPatchLengthInVoxels();
+
+  // the offsets and weights of the patch pixels only change between
+  // iterations
+  if (threadData.patchOffsets.size() != lengthPatch)
+    {
+    const PatchWeightsType patchWeights = this->GetPatchWeights();
+    threadData.patchOffsets.resize(lengthPatch);
+    threadData.patchSquaredWeights.resize(lengthPatch);
+    threadData.validPatchOffsets.reserve(lengthPatch);
+    threadData.validPatchSquaredWeights.reserve(lengthPatch);
+    threadData.validPatchValues.reserve(lengthPatch);
+    for (unsigned int jj = 0; jj < lengthPatch; ++jj)
+      {
+      const typename InputImagePatchIterator::OffsetType offset = currentPatch.GetOffset(jj);
+      OffsetValueType bufferOffset = 0;
+      for (unsigned int dim = 0; dim < OutputImageType::ImageDimension; ++dim)
+        {
+        bufferOffset += offset[dim] * output->GetOffsetTable()[dim];
+        }
+      threadData.patchOffsets[jj] = bufferOffset;
+      threadData.patchSquaredWeights[jj] = static_cast<RealValueType>(patchWeights[jj])
+        * static_cast<RealValueType>(patchWeights[jj]);
+      }
+    }
+  if (threadData.selectedPatches.IsNull() )
+    {
+    threadData.selectedPatches = BaseSamplerType::SubsampleType::New();
+    }
+
+  // same region constraint as for the other pixel types
+  typename OutputImageType::RegionType region = this->m_InputImage->GetLargestPossibleRegion();
+  typename OutputImageType::IndexType rIndex;
+  typename OutputImageType::SizeType  rSize = region.GetSize();
+  const PatchRadiusType radius = this->GetPatchRadiusInVoxels();
+  for (unsigned int dim = 0; dim < OutputImageType::ImageDimension; ++dim)
+    {
+    rIndex[dim] = vnl_math_min(nIndex[dim], static_cast<IndexValueType>(radius[dim]) );
+    rSize[dim]  = vnl_math_max(nIndex[dim], static_cast<IndexValueType>(rSize[dim] - radius[dim] - 1) )
+      - rIndex[dim] + 1;
+    }
+  region.SetIndex(rIndex);
+  region.SetSize(rSize);
+
+  sampler->SetRegionConstraint(region);
+  sampler->CanSelectQueryOn();
+  sampler->Search(currentPatchId, threadData.selectedPatches);
+
+  // Keep the pixels of the current patch that are in bounds, as the other
+  // pixel types do, and that have a nonzero weight.
+  threadData.validPatchOffsets.clear();
+  threadData.validPatchSquaredWeights.clear();
+  threadData.validPatchValues.clear();
+  const bool patchInBounds = currentPatch.InBounds();
+  for (unsigned int jj = 0; jj < lengthPatch; ++jj)
+    {
+    bool            isInBounds = true;
+    const PixelType value = patchInBounds ? currentPatch.GetPixel(jj) : currentPatch.GetPixel(jj, isInBounds);
+    if (isInBounds && threadData.patchSquaredWeights[jj] > 0.0)
+      {
+      threadData.validPatchOffsets.push_back(threadData.patchOffsets[jj]);
+      threadData.validPatchSquaredWeights.push_back(threadData.patchSquaredWeights[jj]);
+      threadData.validPatchValues.push_back(value);
+      }
+    }
+  const size_t           numValid = threadData.validPatchValues.size();
+  const OffsetValueType *validOffsets = numValid > 0 ? &threadData.validPatchOffsets[0] : ITK_NULLPTR;
+  const RealValueType *  validSquaredWeights = numValid > 0 ? &threadData.validPatchSquaredWeights[0] : ITK_NULLPTR;
+  const RealValueType *  validValues = numValid > 0 ? &threadData.validPatchValues[0] : ITK_NULLPTR;
+
+  const RealValueType centerValue = currentPatch.GetCenterPixel();
+  const RealValueType kernelSigma = m_KernelBandwidthSigma[0];
+  const RealValueType halfInverseSquaredSigma = 0.5 / vnl_math_sqr(kernelSigma);
+  const PixelType *   buffer = output->GetBufferPointer();
+
+  RealValueType sumOfGaussiansJointEntropy = 0.0;
+  RealValueType gradientJointEntropy = 0.0;
+
+  // the instance identifiers of the sample are the offsets of the pixels in
+  // the buffer of the image
+  typedef typename BaseSamplerType::SubsampleType::InstanceIdentifierHolder InstanceIdentifierHolder;
+  const InstanceIdentifierHolder & selectedIds = threadData.selectedPatches->GetIdHolder();
+  for (typename InstanceIdentifierHolder::const_iterator selectedIt = selectedIds.begin();
+       selectedIt != selectedIds.end();
+       ++selectedIt)
+    {
+    const PixelType *selectedPatch = buffer + *selectedIt;
+
+    RealValueType squaredNorm = 0.0;
+    for (size_t jj = 0; jj < numValid; ++jj)
+      {
+      const RealValueType diff = static_cast<RealValueType>(selectedPatch[validOffsets[jj]]) - validValues[jj];
+      squaredNorm += validSquaredWeights[jj] * diff * diff;
+      }
+
+    const RealValueType gaussianJointEntropy = std::exp(-squaredNorm * halfInverseSquaredSigma);
+    sumOfGaussiansJointEntropy += gaussianJointEntropy;
+    gradientJointEntropy += (static_cast<RealValueType>(*selectedPatch) - centerValue) * gaussianJointEntropy;
+    }
+
+  return gradientJointEntropy / (sumOfGaussiansJointEntropy + m_MinProbability);
+} // end InternalComputeGradientJointEntropy
 
 template <typename TInputImage, typename TOutputImage>
 void
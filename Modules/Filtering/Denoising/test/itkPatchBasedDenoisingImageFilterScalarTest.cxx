@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkPatchBasedDenoisingImageFilter.h"
+#include "itkUniformRandomSpatialNeighborSubsampler.h"
+
+namespace
+{
+typedef float                             PixelType;
+typedef itk::Vector< PixelType, 1 >       OneComponentType;
+typedef itk::Image< PixelType, 2 >        ScalarImageType;
+typedef itk::Image< OneComponentType, 2 > OneComponentImageType;
+
+template< typename TImage >
+typename TImage::Pointer Denoise(const TImage *input,
+                                 bool useSmoothDiscPatchWeights,
+                                 bool useRandomSampler)
+{
+  typedef itk::PatchBasedDenoisingImageFilter< TImage, TImage > FilterType;
+  typedef itk::Statistics::SpatialNeighborSubsampler<
+    typename FilterType::PatchSampleType, typename TImage::RegionType > SamplerType;
+  typedef itk::Statistics::UniformRandomSpatialNeighborSubsampler<
+    typename FilterType::PatchSampleType, typename TImage::RegionType > RandomSamplerType;
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetPatchRadius(2);
+  filter->SetUseSmoothDiscPatchWeights(useSmoothDiscPatchWeights);
+  filter->SetNoiseModel(FilterType::GAUSSIAN);
+  filter->SetNoiseModelFidelityWeight(0.1);
+  filter->SetNumberOfIterations(2);
+  filter->SetNumberOfThreads(2);
+
+  if( useRandomSampler )
+    {
+    typename RandomSamplerType::Pointer sampler = RandomSamplerType::New();
+    sampler->SetRadius(6);
+    sampler->SetNumberOfResultsRequested(30);
+    filter->SetSampler(sampler);
+    }
+  else
+    {
+    typename SamplerType::Pointer sampler = SamplerType::New();
+    sampler->SetRadius(4);
+    filter->SetSampler(sampler);
+    }
+
+  filter->Update();
+  return filter->GetOutput();
+}
+}
+
+// Compare the output of the filter for a scalar image, whose patch
+// distances are computed from the pixel buffer, to the output for the
+// same image with one-component vector pixels, computed through the
+// patch iterators.
+int itkPatchBasedDenoisingImageFilterScalarTest(int, char* [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(5678);
+
+  ScalarImageType::SizeType size;
+  size[0] = 41;
+  size[1] = 33;
+  ScalarImageType::Pointer       scalarImage = ScalarImageType::New();
+  OneComponentImageType::Pointer vectorImage = OneComponentImageType::New();
+  scalarImage->SetRegions(size);
+  scalarImage->Allocate();
+  vectorImage->SetRegions(size);
+  vectorImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< ScalarImageType > it( scalarImage, scalarImage->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const double disc = ( vnl_math_sqr( it.GetIndex()[0] - 20.0 ) + vnl_math_sqr( it.GetIndex()[1] - 16.0 ) < 100.0 )
+                        ? 100.0 : 20.0;
+    it.Set( static_cast< PixelType >( disc + generator->GetNormalVariate(0.0, 100.0) ) );
+    OneComponentType value;
+    value[0] = it.Get();
+    vectorImage->SetPixel( it.GetIndex(), value );
+    }
+
+  for( unsigned int test = 0; test < 3; ++test )
+    {
+    const bool useSmoothDiscPatchWeights = ( test != 1 );
+    const bool useRandomSampler = ( test == 2 );
+    try
+      {
+      ScalarImageType::Pointer scalarOutput =
+        Denoise< ScalarImageType >( scalarImage, useSmoothDiscPatchWeights, useRandomSampler );
+      OneComponentImageType::Pointer vectorOutput =
+        Denoise< OneComponentImageType >( vectorImage, useSmoothDiscPatchWeights, useRandomSampler );
+
+      double maximumDifference = 0.0;
+      double maximumChange = 0.0;
+      itk::ImageRegionConstIterator< ScalarImageType >       sit( scalarOutput, scalarOutput->GetLargestPossibleRegion() );
+      itk::ImageRegionConstIterator< OneComponentImageType > vit( vectorOutput, vectorOutput->GetLargestPossibleRegion() );
+      itk::ImageRegionConstIterator< ScalarImageType >       iit( scalarImage, scalarImage->GetLargestPossibleRegion() );
+      for( ; !sit.IsAtEnd(); ++sit, ++vit, ++iit )
+        {
+        maximumDifference = std::max( maximumDifference, std::fabs( static_cast< double >( sit.Get() ) - vit.Get()[0] ) );
+        maximumChange = std::max( maximumChange, std::fabs( static_cast< double >( sit.Get() ) - iit.Get() ) );
+        }
+      std::cout << "Smooth disc weights " << useSmoothDiscPatchWeights
+                << ", random sampler " << useRandomSampler
+                << ": maximum difference " << maximumDifference
+                << ", maximum change " << maximumChange << std::endl;
+      if( maximumDifference > 1.0e-3 || maximumChange < 1.0 )
+        {
+        std::cerr << "The scalar image was not denoised as the vector image" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    catch( itk::ExceptionObject & excp )
+      {
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -112,6 +112,7 @@ public:
 
   /** Jacobian type. */
   typedef typename Superclass::JacobianType JacobianType;
+  typedef typename Superclass::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
 
   /** Transform category type. */
   typedef typename Superclass::TransformCategoryType TransformCategoryType;
@@ -330,6 +331,22 @@ public:
     j = this->m_IdentityJacobian;
   }
 
+  /** A point depends on the NDimensions components of the displacement
+   * of a single voxel. */
+  virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices() const ITK_OVERRIDE
+  {
+    return Dimension;
+  }
+
+  /**
+   * Compute the jacobian with respect to the parameters at a point, with
+   * the parameter indices of the displacement of the voxel nearest to the
+   * point. As for \c ComputeJacobianWithRespectToParameters, the jacobian
+   * is the identity; it is zero outside of the displacement field.
+   */
+  virtual void ComputeSparseJacobianWithRespectToParameters(const InputPointType & x, JacobianType & j,
+                                                            NonZeroJacobianIndicesType & nonZeroJacobianIndices) const ITK_OVERRIDE;
+
   /**
    * Compute the jacobian with respect to the position, by point.
    * \c j will be resized as needed.
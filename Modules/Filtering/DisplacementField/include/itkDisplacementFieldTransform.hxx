@@ -202,6 +202,33 @@ const
   this->ComputeJacobianWithRespectToPositionInternal( index, jacobian, false );
 }
 
+template <typename TScalar, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TScalar, NDimensions>
+::ComputeSparseJacobianWithRespectToParameters( const InputPointType & point,
+                                                JacobianType & jacobian,
+                                                NonZeroJacobianIndicesType & nonZeroJacobianIndices )
+const
+{
+  jacobian = this->m_IdentityJacobian;
+  nonZeroJacobianIndices.resize( NDimensions );
+
+  IndexType idx;
+  OffsetValueType offset = 0;
+  if( this->m_DisplacementField->TransformPhysicalPointToIndex( point, idx ) )
+    {
+    offset = this->m_DisplacementField->ComputeOffset( idx ) * NDimensions;
+    }
+  else
+    {
+    jacobian.Fill( 0.0 );
+    }
+  for( unsigned int d = 0; d < NDimensions; d++ )
+    {
+    nonZeroJacobianIndices[d] = offset + d;
+    }
+}
+
 template <typename TScalar, unsigned int NDimensions>
 void
 DisplacementFieldTransform<TScalar, NDimensions>
@@ -0,0 +1,264 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFelzenszwalbHuttenlocherDistanceMapImageFilter_h
+#define itkFelzenszwalbHuttenlocherDistanceMapImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include <vector>
+
+namespace itk
+{
+/** \class FelzenszwalbHuttenlocherDistanceMapImageFilter
+ *
+ *  \brief This filter calculates the exact Euclidean distance transform
+ *  of a binary image in linear time, in parallel over all the lines of
+ *  each dimension.
+ *
+ *  \par Inputs and Outputs
+ *  This is an image-to-image filter. The pixels of the input different
+ *  from BackgroundValue are the object pixels. By default, the output is
+ *  the distance of each pixel to the nearest object pixel, which is zero
+ *  in the objects, as for DanielssonDistanceMapImageFilter.
+ *
+ *  When SignedDistance is on, the output is the distance of each pixel
+ *  to the nearest pixel on the border of the objects, that is an object
+ *  pixel with a background pixel in its 3^ImageDimension neighborhood.
+ *  The inside is then considered as having negative distances, and the
+ *  outside as having positive distances, as in
+ *  SignedMaurerDistanceMapImageFilter. To change the convention, use the
+ *  InsideIsPositive(bool) function.
+ *
+ *  The output is the squared distance when SquaredDistance is on, which
+ *  avoids the square roots. When the output pixels are real, the squared
+ *  distances are computed in place in the output image, so that float
+ *  output pixels take half the memory of double ones on large volumes.
+ *  For integer output pixels, the squared distances of the intermediate
+ *  passes are kept in a double buffer, since they are not integers with
+ *  anisotropic spacing, and the final distances are truncated. Pixels
+ *  which have no object or border pixel in the image, and distances
+ *  beyond the range of the output pixel type, get the largest value of
+ *  the output pixel type.
+ *
+ *  \par Closest point map
+ *  When ComputeClosestPointMap is on, the second output holds for each
+ *  pixel the index of the object or border pixel at the computed
+ *  distance. It costs ImageDimension indices per pixel, so it is off by
+ *  default.
+ *
+ *  \par Algorithm
+ *  The squared distance transform is computed one dimension after the
+ *  other. Along each line, the lower envelope of the parabolas rooted at
+ *  the squared distances of the previous dimension is built, then
+ *  sampled, in a time linear with the length of the line. All the lines
+ *  of a dimension are independent, so they are shared evenly between the
+ *  threads, whatever the shape of the image. The spacing is taken into
+ *  account when UseImageSpacing is on, which is the default.
+ *
+ *  Reference:
+ *  P. F. Felzenszwalb and D. P. Huttenlocher, "Distance Transforms of
+ *  Sampled Functions", Theory of Computing, 8(19): 415-428, 2012.
+ *
+ * \sa SignedMaurerDistanceMapImageFilter DanielssonDistanceMapImageFilter
+ *
+ * \ingroup ImageFeatureExtraction
+ * \ingroup ITKDistanceMap
+ */
+template< typename TInputImage, typename TOutputImage >
+class FelzenszwalbHuttenlocherDistanceMapImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Select the type of the squared distances of the intermediate
+   * passes. */
+  template< bool TIsInteger, typename TPixel >
+  struct IntermediateTraits
+  {
+    typedef TPixel Type;
+  };
+  template< typename TPixel >
+  struct IntermediateTraits< true, TPixel >
+  {
+    typedef double Type;
+  };
+
+  /** Standard class typedefs. */
+  typedef FelzenszwalbHuttenlocherDistanceMapImageFilter  Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+  typedef DataObject::Pointer                             DataObjectPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(FelzenszwalbHuttenlocherDistanceMapImageFilter,
+               ImageToImageFilter);
+
+  /** Extract dimension from the output image. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Image typedef support. */
+  typedef TInputImage                          InputImageType;
+  typedef TOutputImage                         OutputImageType;
+  typedef typename InputImageType::PixelType   InputPixelType;
+  typedef typename OutputImageType::PixelType  OutputPixelType;
+  typedef typename OutputImageType::RegionType OutputImageRegionType;
+  typedef typename OutputImageType::IndexType  IndexType;
+  typedef typename OutputImageType::OffsetType OffsetType;
+  typedef typename OutputImageType::SizeType   SizeType;
+
+  /** Type of the squared distances of the intermediate passes: the
+   * output pixel type when it is real, double otherwise. */
+  typedef typename IntermediateTraits< NumericTraits< OutputPixelType >::is_integer, OutputPixelType >::Type
+  SquaredDistanceType;
+
+  /** Type of the closest point map. */
+  typedef Image< IndexType, itkGetStaticConstMacro(ImageDimension) > ClosestPointImageType;
+
+  /** Set/Get whether the output is the squared distance. Default is
+   * false. */
+  itkSetMacro(SquaredDistance, bool);
+  itkGetConstReferenceMacro(SquaredDistance, bool);
+  itkBooleanMacro(SquaredDistance);
+
+  /** Set/Get whether the output is the signed distance to the border of
+   * the objects, rather than the distance to the objects. Default is
+   * false. */
+  itkSetMacro(SignedDistance, bool);
+  itkGetConstReferenceMacro(SignedDistance, bool);
+  itkBooleanMacro(SignedDistance);
+
+  /** Set/Get whether the inside represents positive values in the signed
+   * distance map. Default is false. */
+  itkSetMacro(InsideIsPositive, bool);
+  itkGetConstReferenceMacro(InsideIsPositive, bool);
+  itkBooleanMacro(InsideIsPositive);
+
+  /** Set/Get whether the image spacing is used in computing distances.
+   * Default is true. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Set/Get whether the closest point map is computed. Default is
+   * false. */
+  itkSetMacro(ComputeClosestPointMap, bool);
+  itkGetConstReferenceMacro(ComputeClosestPointMap, bool);
+  itkBooleanMacro(ComputeClosestPointMap);
+
+  /** Set/Get the value of the background of the input binary image.
+   * Default is zero. */
+  itkSetMacro(BackgroundValue, InputPixelType);
+  itkGetConstReferenceMacro(BackgroundValue, InputPixelType);
+
+  /** Get the closest point map, which is only computed when
+   * ComputeClosestPointMap is on. */
+  ClosestPointImageType * GetClosestPointMap();
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< TInputImage::ImageDimension, TOutputImage::ImageDimension > ) );
+  itkConceptMacro( OutputHasNumericTraitsCheck,
+                   ( Concept::HasNumericTraits< OutputPixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  FelzenszwalbHuttenlocherDistanceMapImageFilter();
+  virtual ~FelzenszwalbHuttenlocherDistanceMapImageFilter() {}
+
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  typedef ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
+  using Superclass::MakeOutput;
+  virtual DataObjectPointer MakeOutput(DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
+
+  /** The whole input is needed. */
+  virtual void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** The whole output is produced. */
+  virtual void EnlargeOutputRequestedRegion(DataObject *) ITK_OVERRIDE;
+
+  /** Run one multithreaded pass per dimension. */
+  void GenerateData() ITK_OVERRIDE;
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE TransformLinesThreaderCallback(void *arg);
+
+  /** Transform the lines of the current dimension from firstLine to
+   * lastLine (excluded). */
+  void ThreadedTransformLines(SizeValueType firstLine, SizeValueType lastLine,
+                              ThreadIdType threadId);
+
+private:
+  FelzenszwalbHuttenlocherDistanceMapImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                                 //purposely not implemented
+
+  /** Whether the pixel at the given offset in the input buffer is a
+   * site of the transform: an object pixel, or a border pixel in signed
+   * mode. */
+  bool IsSite(const InputPixelType *input, OffsetValueType offset, const IndexType & index) const;
+
+  /** The buffer of the squared distances of the intermediate passes: the
+   * output buffer when the output pixels are real, a separate buffer
+   * otherwise. */
+  static SquaredDistanceType * SelectSquaredDistanceBuffer(SquaredDistanceType *output,
+                                                          SquaredDistanceType *)
+  {
+    return output;
+  }
+
+  template< typename TPixel >
+  static SquaredDistanceType * SelectSquaredDistanceBuffer(TPixel *,
+                                                          SquaredDistanceType *buffer)
+  {
+    return buffer;
+  }
+
+  InputPixelType m_BackgroundValue;
+
+  bool m_SquaredDistance;
+  bool m_SignedDistance;
+  bool m_InsideIsPositive;
+  bool m_UseImageSpacing;
+  bool m_ComputeClosestPointMap;
+
+  // state of the current pass
+  unsigned int  m_CurrentDimension;
+  SizeValueType m_NumberOfLines;
+
+  // the squared distances of the intermediate passes, and their storage
+  // when the output pixels are integers
+  SquaredDistanceType *              m_SquaredDistanceBuffer;
+  std::vector< SquaredDistanceType > m_SquaredDistances;
+
+  // offsets of the neighbors in the input buffer, to find the border
+  // pixels
+  std::vector< OffsetValueType > m_NeighborBufferOffsets;
+  std::vector< OffsetType >      m_NeighborOffsets;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFelzenszwalbHuttenlocherDistanceMapImageFilter.hxx"
+#endif
+
+#endif
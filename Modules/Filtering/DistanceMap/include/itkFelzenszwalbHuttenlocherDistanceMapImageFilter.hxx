@@ -0,0 +1,435 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFelzenszwalbHuttenlocherDistanceMapImageFilter_hxx
+#define itkFelzenszwalbHuttenlocherDistanceMapImageFilter_hxx
+
+#include "itkFelzenszwalbHuttenlocherDistanceMapImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkProgressReporter.h"
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::FelzenszwalbHuttenlocherDistanceMapImageFilter():
+  m_BackgroundValue( NumericTraits< InputPixelType >::ZeroValue() ),
+  m_SquaredDistance(false),
+  m_SignedDistance(false),
+  m_InsideIsPositive(false),
+  m_UseImageSpacing(true),
+  m_ComputeClosestPointMap(false),
+  m_CurrentDimension(0),
+  m_NumberOfLines(0),
+  m_SquaredDistanceBuffer(ITK_NULLPTR)
+{
+  this->SetNumberOfRequiredOutputs(2);
+
+  // closest point map
+  this->SetNthOutput( 1, this->MakeOutput( 1 ) );
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >::DataObjectPointer
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::MakeOutput(DataObjectPointerArraySizeType idx)
+{
+  if ( idx == 1 )
+    {
+    return ClosestPointImageType::New().GetPointer();
+    }
+  return Superclass::MakeOutput(idx);
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >::ClosestPointImageType *
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::GetClosestPointMap()
+{
+  return dynamic_cast< ClosestPointImageType * >( this->ProcessObject::GetOutput(1) );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType *input = const_cast< InputImageType * >( this->GetInput() );
+  if ( input )
+    {
+    input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  OutputImageType *output = this->GetOutput();
+  output->SetRequestedRegion( output->GetLargestPossibleRegion() );
+
+  ClosestPointImageType *closestPointMap = this->GetClosestPointMap();
+  closestPointMap->SetRequestedRegion( closestPointMap->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::GenerateData()
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType      *output = this->GetOutput();
+
+  // only allocate the closest point map when it is needed
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
+  if ( m_ComputeClosestPointMap )
+    {
+    ClosestPointImageType *closestPointMap = this->GetClosestPointMap();
+    closestPointMap->SetBufferedRegion( output->GetRequestedRegion() );
+    closestPointMap->Allocate();
+    }
+
+  // the neighbors of the pixels, to find the border of the objects
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  if ( m_SignedDistance )
+    {
+    unsigned int numberOfNeighbors = 1;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      numberOfNeighbors *= 3;
+      }
+    for ( unsigned int n = 0; n < numberOfNeighbors; n++ )
+      {
+      OffsetType      offset;
+      OffsetValueType bufferOffset = 0;
+      unsigned int    code = n;
+      bool            isCenter = true;
+      for ( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        offset[d] = static_cast< OffsetValueType >( code % 3 ) - 1;
+        bufferOffset += offset[d] * input->GetOffsetTable()[d];
+        isCenter = isCenter && offset[d] == 0;
+        code /= 3;
+        }
+      if ( !isCenter )
+        {
+        m_NeighborOffsets.push_back(offset);
+        m_NeighborBufferOffsets.push_back(bufferOffset);
+        }
+      }
+    }
+
+  // the lines of each dimension are shared evenly between the threads
+  MultiThreader *multiThreader = this->GetMultiThreader();
+  const SizeType size = output->GetRequestedRegion().GetSize();
+  if ( output->GetRequestedRegion().GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // the squared distances are computed in place in real output images
+  if ( NumericTraits< OutputPixelType >::is_integer && ImageDimension > 1 )
+    {
+    m_SquaredDistances.resize( output->GetRequestedRegion().GetNumberOfPixels() );
+    }
+  m_SquaredDistanceBuffer = SelectSquaredDistanceBuffer( output->GetBufferPointer(),
+                                                         m_SquaredDistances.empty() ? ITK_NULLPTR : &m_SquaredDistances[0] );
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    m_CurrentDimension = d;
+    m_NumberOfLines = output->GetRequestedRegion().GetNumberOfPixels() / size[d];
+
+    ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+    if ( m_NumberOfLines < numberOfThreads )
+      {
+      numberOfThreads = static_cast< ThreadIdType >( m_NumberOfLines );
+      }
+    multiThreader->SetNumberOfThreads(numberOfThreads);
+    multiThreader->SetSingleMethod(this->TransformLinesThreaderCallback, this);
+    multiThreader->SingleMethodExecute();
+    }
+
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  m_SquaredDistanceBuffer = ITK_NULLPTR;
+  std::vector< SquaredDistanceType >().swap(m_SquaredDistances);
+}
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::TransformLinesThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *filter = static_cast< Self * >( info->UserData );
+
+  const ThreadIdType  threadId = info->ThreadID;
+  const ThreadIdType  numberOfThreads = info->NumberOfThreads;
+  const SizeValueType numberOfLines = filter->m_NumberOfLines;
+
+  filter->ThreadedTransformLines(numberOfLines * threadId / numberOfThreads,
+                                 numberOfLines * ( threadId + 1 ) / numberOfThreads,
+                                 threadId);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::IsSite(const InputPixelType *input, OffsetValueType offset, const IndexType & index) const
+{
+  if ( input[offset] == m_BackgroundValue )
+    {
+    return false;
+    }
+  if ( !m_SignedDistance )
+    {
+    return true;
+    }
+
+  // in signed mode, only the object pixels with a background neighbor
+  // are sites
+  const OutputImageRegionType & region = this->GetOutput()->GetRequestedRegion();
+  bool isInterior = true;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    isInterior = isInterior
+                 && index[d] > region.GetIndex()[d]
+                 && index[d] + 1 < region.GetIndex()[d] + static_cast< OffsetValueType >( region.GetSize()[d] );
+    }
+  for ( unsigned int n = 0; n < m_NeighborOffsets.size(); n++ )
+    {
+    if ( ( isInterior || region.IsInside(index + m_NeighborOffsets[n]) )
+         && input[offset + m_NeighborBufferOffsets[n]] == m_BackgroundValue )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::ThreadedTransformLines(SizeValueType firstLine, SizeValueType lastLine,
+                         ThreadIdType threadId)
+{
+  const InputImageType  *input = this->GetInput();
+  OutputImageType       *output = this->GetOutput();
+  ClosestPointImageType *closestPointMap = this->GetClosestPointMap();
+
+  const unsigned int          d = m_CurrentDimension;
+  const bool                  isFirstDimension = ( d == 0 );
+  const bool                  isLastDimension = ( d == ImageDimension - 1 );
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  const OffsetValueType       length = region.GetSize()[d];
+  const OffsetValueType       stride = output->GetOffsetTable()[d];
+  const OffsetValueType       inputStride = input->GetOffsetTable()[d];
+  const double                spacing = m_UseImageSpacing ? output->GetSpacing()[d] : 1.0;
+  const OutputPixelType       maximum = NumericTraits< OutputPixelType >::max();
+  const OutputPixelType       minimum = NumericTraits< OutputPixelType >::NonpositiveMin();
+  const SquaredDistanceType   unreached = NumericTraits< SquaredDistanceType >::max();
+
+  const InputPixelType *inputBuffer = input->GetBufferPointer();
+  OutputPixelType      *outputBuffer = output->GetBufferPointer();
+  SquaredDistanceType  *squaredDistanceBuffer = m_SquaredDistanceBuffer;
+  IndexType            *closestPointBuffer = m_ComputeClosestPointMap ? closestPointMap->GetBufferPointer() : ITK_NULLPTR;
+
+  // The squared distances of the line, the positions of the parabolas of
+  // the lower envelope, and the boundaries between them. The sites at an
+  // infinite distance are skipped.
+  std::vector< double >          f(length);
+  std::vector< bool >            isSite(length);
+  std::vector< OffsetValueType > v(length);
+  std::vector< double >          z(length + 1);
+  std::vector< IndexType >       closestPoints;
+  if ( m_ComputeClosestPointMap )
+    {
+    closestPoints.resize(length);
+    }
+
+  ProgressReporter progress(this, threadId, lastLine - firstLine, 100,
+                            static_cast< float >( d ) / ImageDimension,
+                            1.0f / ImageDimension);
+
+  for ( SizeValueType line = firstLine; line < lastLine; line++ )
+    {
+    // the index of the first pixel of the line
+    IndexType     index = region.GetIndex();
+    SizeValueType remainder = line;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( i != d )
+        {
+        index[i] += static_cast< IndexValueType >( remainder % region.GetSize()[i] );
+        remainder /= region.GetSize()[i];
+        }
+      }
+    const OffsetValueType offset = output->ComputeOffset(index);
+    const OffsetValueType inputOffset = input->ComputeOffset(index);
+
+    // read the line, from the input for the first dimension
+    for ( OffsetValueType q = 0; q < length; q++ )
+      {
+      if ( isFirstDimension )
+        {
+        IndexType siteIndex = index;
+        siteIndex[d] += q;
+        isSite[q] = this->IsSite(inputBuffer, inputOffset + q * inputStride, siteIndex);
+        f[q] = 0.0;
+        }
+      else
+        {
+        const SquaredDistanceType value = squaredDistanceBuffer[offset + q * stride];
+        isSite[q] = ( value != unreached );
+        f[q] = static_cast< double >( value );
+        }
+      if ( m_ComputeClosestPointMap && !isFirstDimension )
+        {
+        closestPoints[q] = closestPointBuffer[offset + q * stride];
+        }
+      }
+
+    // compute the lower envelope of the parabolas
+    long k = -1;
+    for ( OffsetValueType q = 0; q < length; q++ )
+      {
+      if ( !isSite[q] )
+        {
+        continue;
+        }
+      const double xq = q * spacing;
+      double       s = 0.0;
+      while ( k >= 0 )
+        {
+        const double xv = v[k] * spacing;
+        s = ( ( f[q] + xq * xq ) - ( f[v[k]] + xv * xv ) ) / ( 2.0 * ( xq - xv ) );
+        if ( s > z[k] )
+          {
+          break;
+          }
+        k--;
+        }
+      k++;
+      v[k] = q;
+      z[k] = ( k == 0 ) ? -NumericTraits< double >::max() : s;
+      z[k + 1] = NumericTraits< double >::max();
+      }
+
+    // sample the lower envelope
+    long j = 0;
+    for ( OffsetValueType q = 0; q < length; q++ )
+      {
+      const OffsetValueType outputOffset = offset + q * stride;
+      double                squaredDistance = NumericTraits< double >::max();
+      if ( k >= 0 )
+        {
+        const double xq = q * spacing;
+        while ( z[j + 1] < xq )
+          {
+          j++;
+          }
+        const double dx = xq - v[j] * spacing;
+        squaredDistance = dx * dx + f[v[j]];
+
+        if ( m_ComputeClosestPointMap )
+          {
+          if ( isFirstDimension )
+            {
+            IndexType closestPoint = index;
+            closestPoint[d] += v[j];
+            closestPointBuffer[outputOffset] = closestPoint;
+            }
+          else
+            {
+            closestPointBuffer[outputOffset] = closestPoints[v[j]];
+            }
+          }
+        }
+      else if ( m_ComputeClosestPointMap && isFirstDimension )
+        {
+        IndexType closestPoint = index;
+        closestPoint[d] += q;
+        closestPointBuffer[outputOffset] = closestPoint;
+        }
+
+      if ( !isLastDimension )
+        {
+        squaredDistanceBuffer[outputOffset] =
+          ( k < 0 ) ? unreached : static_cast< SquaredDistanceType >( squaredDistance );
+        }
+      else if ( k < 0 )
+        {
+        outputBuffer[outputOffset] = maximum;
+        }
+      else
+        {
+        // compute the final distance in the last dimension
+        double distance = m_SquaredDistance ? squaredDistance : std::sqrt(squaredDistance);
+        if ( m_SignedDistance )
+          {
+          const bool isInside = ( inputBuffer[inputOffset + q * inputStride] != m_BackgroundValue );
+          if ( isInside != m_InsideIsPositive )
+            {
+            distance = -distance;
+            }
+          }
+        if ( distance >= static_cast< double >( maximum ) )
+          {
+          outputBuffer[outputOffset] = maximum;
+          }
+        else if ( distance <= static_cast< double >( minimum ) )
+          {
+          outputBuffer[outputOffset] = minimum;
+          }
+        else
+          {
+          outputBuffer[outputOffset] = static_cast< OutputPixelType >( distance );
+          }
+        }
+      }
+
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< InputPixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+  os << indent << "SquaredDistance: " << m_SquaredDistance << std::endl;
+  os << indent << "SignedDistance: " << m_SignedDistance << std::endl;
+  os << indent << "InsideIsPositive: " << m_InsideIsPositive << std::endl;
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  os << indent << "ComputeClosestPointMap: " << m_ComputeClosestPointMap << std::endl;
+}
+} // end namespace itk
+
+#endif
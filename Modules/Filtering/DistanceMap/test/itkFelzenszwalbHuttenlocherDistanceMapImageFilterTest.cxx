@@ -0,0 +1,238 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "itkFelzenszwalbHuttenlocherDistanceMapImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+
+namespace
+{
+typedef unsigned char InputPixelType;
+
+template< typename TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size,
+                                   const typename TImage::SpacingType & spacing,
+                                   double density)
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(2468);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetUniformVariate(0.0, 1.0) < density ? 1 : 0 );
+    }
+  return image;
+}
+
+// The squared distance between two indices.
+template< typename TImage >
+double SquaredDistance(const typename TImage::IndexType & a,
+                       const typename TImage::IndexType & b,
+                       const typename TImage::SpacingType & spacing)
+{
+  double squaredDistance = 0.0;
+  for( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    const double dx = ( a[d] - b[d] ) * spacing[d];
+    squaredDistance += dx * dx;
+    }
+  return squaredDistance;
+}
+
+// Compare the squared distances and the closest points to the ones
+// computed by brute force, with several numbers of threads. The integer
+// outputs are truncated and clamped to the range of the pixel type.
+template< typename TInputImage, typename TOutputImage >
+int UnsignedTest(const TInputImage *input, double tolerance)
+{
+  typedef itk::FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage > FilterType;
+  typedef typename TInputImage::IndexType                                                  IndexType;
+  typedef typename TOutputImage::PixelType                                                 OutputPixelType;
+
+  const typename TInputImage::SpacingType spacing = input->GetSpacing();
+  std::vector< IndexType > objectIndices;
+  itk::ImageRegionConstIteratorWithIndex< TInputImage > it( input, input->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != 0 )
+      {
+      objectIndices.push_back( it.GetIndex() );
+      }
+    }
+
+  for( unsigned int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3 )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(input);
+    filter->SquaredDistanceOn();
+    filter->ComputeClosestPointMapOn();
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+
+    double maximumError = 0.0;
+    itk::ImageRegionConstIteratorWithIndex< TOutputImage > ot( filter->GetOutput(), input->GetLargestPossibleRegion() );
+    for( ; !ot.IsAtEnd(); ++ot )
+      {
+      double expected = itk::NumericTraits< double >::max();
+      for( unsigned int n = 0; n < objectIndices.size(); ++n )
+        {
+        expected = std::min( expected, SquaredDistance< TInputImage >( ot.GetIndex(), objectIndices[n], spacing ) );
+        }
+      const IndexType closestPoint = filter->GetClosestPointMap()->GetPixel( ot.GetIndex() );
+      const double    closestPointDistance = SquaredDistance< TInputImage >( ot.GetIndex(), closestPoint, spacing );
+      if( input->GetPixel(closestPoint) == 0
+          || std::fabs( closestPointDistance - expected ) > tolerance * ( 1.0 + expected ) )
+        {
+        std::cerr << "Wrong closest point " << closestPoint << " for " << ot.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+        }
+      if( itk::NumericTraits< OutputPixelType >::is_integer )
+        {
+        expected = std::min( std::floor(expected),
+                             static_cast< double >( itk::NumericTraits< OutputPixelType >::max() ) );
+        }
+      maximumError = std::max( maximumError, std::fabs( ot.Get() - expected ) / ( 1.0 + expected ) );
+      }
+
+    std::cout << "Dimension " << TInputImage::ImageDimension
+              << ", " << numberOfThreads << " threads"
+              << ": maximum relative error " << maximumError << std::endl;
+    if( maximumError > tolerance )
+      {
+      std::cerr << "The squared distances differ from the brute force ones" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+// Compare the signed distances to the ones of
+// SignedMaurerDistanceMapImageFilter.
+template< typename TInputImage, typename TOutputImage >
+int SignedTest(const TInputImage *input, bool insideIsPositive, double tolerance)
+{
+  typedef itk::FelzenszwalbHuttenlocherDistanceMapImageFilter< TInputImage, TOutputImage > FilterType;
+  typedef itk::SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >             MaurerType;
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SignedDistanceOn();
+  filter->SetInsideIsPositive(insideIsPositive);
+  filter->Update();
+
+  typename MaurerType::Pointer maurer = MaurerType::New();
+  maurer->SetInput(input);
+  maurer->SetInsideIsPositive(insideIsPositive);
+  maurer->Update();
+
+  double maximumError = 0.0;
+  itk::ImageRegionConstIteratorWithIndex< TOutputImage > ot( filter->GetOutput(), input->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIteratorWithIndex< TOutputImage > mt( maurer->GetOutput(), input->GetLargestPossibleRegion() );
+  for( ; !ot.IsAtEnd(); ++ot, ++mt )
+    {
+    maximumError = std::max( maximumError, std::fabs( static_cast< double >( ot.Get() ) - mt.Get() ) );
+    }
+
+  std::cout << "Dimension " << TInputImage::ImageDimension
+            << ", signed, inside is positive " << insideIsPositive
+            << ": maximum difference with Maurer " << maximumError << std::endl;
+  if( maximumError > tolerance )
+    {
+    std::cerr << "The signed distances differ from the ones of SignedMaurerDistanceMapImageFilter" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkFelzenszwalbHuttenlocherDistanceMapImageFilterTest(int, char* [])
+{
+  typedef itk::Image< InputPixelType, 2 > Input2DType;
+  typedef itk::Image< InputPixelType, 3 > Input3DType;
+  typedef itk::Image< float, 2 >          Float2DType;
+  typedef itk::Image< double, 2 >         Double2DType;
+  typedef itk::Image< float, 3 >          Float3DType;
+  typedef itk::Image< int, 3 >            Int3DType;
+  typedef itk::Image< unsigned char, 3 >  UChar3DType;
+
+  try
+    {
+    Input2DType::SizeType size2D;
+    size2D[0] = 41;
+    size2D[1] = 37;
+    Input2DType::SpacingType spacing2D;
+    spacing2D[0] = 0.7;
+    spacing2D[1] = 1.3;
+    Input2DType::Pointer input2D = MakeImage< Input2DType >( size2D, spacing2D, 0.01 );
+
+    Input3DType::SizeType size3D;
+    size3D[0] = 17;
+    size3D[1] = 13;
+    size3D[2] = 11;
+    Input3DType::SpacingType spacing3D;
+    spacing3D.Fill(1.0);
+    Input3DType::Pointer input3D = MakeImage< Input3DType >( size3D, spacing3D, 0.005 );
+    spacing3D[2] = 2.5;
+    Input3DType::Pointer anisotropic3D = MakeImage< Input3DType >( size3D, spacing3D, 0.005 );
+
+    // squared distances which are not integers in the first passes, and
+    // which exceed the range of unsigned char
+    spacing3D[0] = 0.5;
+    spacing3D[1] = 1.5;
+    Input3DType::Pointer fractional3D = MakeImage< Input3DType >( size3D, spacing3D, 0.005 );
+
+    Input2DType::Pointer blob2D = MakeImage< Input2DType >( size2D, spacing2D, 0.6 );
+
+    if( UnsignedTest< Input2DType, Double2DType >( input2D, 1.0e-9 ) != EXIT_SUCCESS
+        || UnsignedTest< Input2DType, Float2DType >( input2D, 1.0e-5 ) != EXIT_SUCCESS
+        || UnsignedTest< Input3DType, Int3DType >( input3D, 0.0 ) != EXIT_SUCCESS
+        || UnsignedTest< Input3DType, Float3DType >( anisotropic3D, 1.0e-5 ) != EXIT_SUCCESS
+        || UnsignedTest< Input3DType, Int3DType >( fractional3D, 0.0 ) != EXIT_SUCCESS
+        || UnsignedTest< Input3DType, UChar3DType >( fractional3D, 0.0 ) != EXIT_SUCCESS
+        || SignedTest< Input2DType, Float2DType >( blob2D, false, 1.0e-4 ) != EXIT_SUCCESS
+        || SignedTest< Input2DType, Float2DType >( blob2D, true, 1.0e-4 ) != EXIT_SUCCESS
+        || SignedTest< Input3DType, Float3DType >( anisotropic3D, false, 1.0e-4 ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+
+    typedef itk::FelzenszwalbHuttenlocherDistanceMapImageFilter< Input2DType, Float2DType > FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->Print(std::cout);
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -22,9 +22,9 @@
 #include "itkIntTypes.h"
 #include "itkFastMarchingStoppingCriterionBase.h"
 #include "itkFastMarchingTraits.h"
+#include "itkPriorityQueueContainer.h"
 
-#include <queue>
-#include <functional>
+#include <map>
 
 namespace itk
 {
@@ -40,8 +40,9 @@ namespace itk
  *
  * Updates are preformed using an entropy satisfy scheme where only
  * "upwind" neighborhoods are used. This implementation of Fast Marching
- * uses a std::priority_queue to locate the next proper node to
- * update.
+ * uses an itk::PriorityQueueContainer to locate the next proper node to
+ * update. Each trial node is stored once in the queue, and its value is
+ * updated in place when it decreases.
  *
  * Fast Marching sweeps through N points in (N log N) steps to obtain
  * the arrival time value as the front propagates through the domain.
@@ -68,10 +69,6 @@ namespace itk
  *    \li Superclass (itk::ImageToImageFilter or
  * itk::QuadEdgeMeshToQuadEdgeMeshFilter )
  *
- * \todo In the current implemenation, std::priority_queue only allows
- * taking nodes out from the front and putting nodes in from the back.
- * Use itk::PriorityQueueContainer instead.
- *
  * \par Topology constraints:
  * Additional flexibiility in this class includes the implementation of
  * topology constraints for image-based fast marching.  Further details
@@ -136,19 +133,17 @@ public:
   typedef FastMarchingStoppingCriterionBase< TInput, TOutput > StoppingCriterionType;
   typedef typename StoppingCriterionType::Pointer              StoppingCriterionPointer;
 
-  /*
-  typedef long ElementIdentifier;
+  typedef IdentifierType ElementIdentifier;
 
   typedef MinPriorityQueueElementWrapper< NodeType,
     OutputPixelType,
     ElementIdentifier > PriorityQueueElementType;
 
-  typedef PriorityQueueContainer< PriorityQueueElementType,
-    PriorityQueueElementType,
+  typedef PriorityQueueContainer< PriorityQueueElementType *,
+    ElementWrapperPointerInterface< PriorityQueueElementType *, ElementIdentifier >,
     OutputPixelType,
     ElementIdentifier > PriorityQueueType;
   typedef typename PriorityQueueType::Pointer PriorityQueuePointer;
-  */
 
   /** \enum TopologyCheckType */
   enum TopologyCheckType {
@@ -230,17 +225,28 @@ protected:
 
   bool m_CollectPoints;
 
-  //PriorityQueuePointer m_Heap;
-  typedef std::vector< NodePairType >   HeapContainerType;
-  typedef std::greater< NodePairType >  NodeComparerType;
+  /** The trial nodes, sorted by value. By default, the elements are
+   * stored in m_HeapElements, where each node can be found to update its
+   * value. FastMarchingImageFilterBase overrides the heap functions to find
+   * them through an image instead. */
+  PriorityQueuePointer m_Heap;
+
+  typedef std::map< NodeType, PriorityQueueElementType,
+                    typename Traits::NodeCompareType > HeapElementMapType;
+  HeapElementMapType m_HeapElements;
+
+  /** \brief Insert a trial node in the heap, or update its value if it
+   * already is in the heap.
+    \param[in] iNode
+    \param[in] iValue */
+  virtual void PushOrUpdateTrialNode( const NodeType& iNode, const OutputPixelType& iValue );
 
-  typedef std::priority_queue<
-    NodeType,
-    HeapContainerType,
-    NodeComparerType >
-    PriorityQueueType;
+  /** \brief Remove the node with the smallest value from the heap
+    \return the node and its value */
+  virtual NodePairType PopTrialNode();
 
-  PriorityQueueType m_Heap;
+  /** \brief Remove all the nodes from the heap */
+  virtual void ClearHeap();
 
   TopologyCheckType m_TopologyCheck;
 
@@ -38,7 +38,7 @@ FastMarchingBase()
   m_ProcessedPoints = ITK_NULLPTR;
   m_ForbiddenPoints = ITK_NULLPTR;
 
-  //m_Heap = PriorityQueueType::New();
+  m_Heap = PriorityQueueType::New();
   m_SpeedConstant = 1.;
   m_InverseSpeed = -1.;
   m_NormalizationFactor = 1.;
@@ -103,16 +103,7 @@ Initialize( OutputDomainType* oDomain )
     }
 
   // make sure the heap is empty
-  while ( !m_Heap.empty() )
-    {
-    m_Heap.pop();
-    }
-  /*
-  while ( !m_Heap->Empty() )
-    {
-    m_Heap->Pop();
-    }
-  */
+  this->ClearHeap();
 
   this->InitializeOutput( oDomain );
 
@@ -140,50 +131,39 @@ GenerateData()
 
   try
     {
-    //while( !m_Heap->Empty() )
-    while( !m_Heap.empty() )
+    while( !m_Heap->Empty() )
       {
-      //PriorityQueueElementType element = m_Heap->Peek();
-      //m_Heap->Pop();
-      //
-      //NodeType current_node = element.m_Element;
-      //OutputPixelType current_value = element.m_Priority;
-
-
-      NodePairType current_node_pair = m_Heap.top();
-      m_Heap.pop();
+      // each node is only once in the heap, with its current value
+      NodePairType current_node_pair = this->PopTrialNode();
 
       NodeType current_node = current_node_pair.GetNode();
-      current_value = this->GetOutputValue( output, current_node );
+      current_value = current_node_pair.GetValue();
 
-      if( current_value == current_node_pair.GetValue() )
+      // is this node already alive ?
+      if( this->GetLabelValueForGivenNode( current_node ) != Traits::Alive )
         {
-        // is this node already alive ?
-        if( this->GetLabelValueForGivenNode( current_node ) != Traits::Alive )
+        m_StoppingCriterion->SetCurrentNodePair( current_node_pair );
+
+        if( m_StoppingCriterion->IsSatisfied() )
           {
-          m_StoppingCriterion->SetCurrentNodePair( current_node_pair );
+          break;
+          }
 
-          if( m_StoppingCriterion->IsSatisfied() )
+        if( this->CheckTopology( output, current_node ) )
+          {
+          if ( m_CollectPoints )
             {
-            break;
+            m_ProcessedPoints->push_back( current_node_pair );
             }
 
-          if( this->CheckTopology( output, current_node ) )
-            {
-            if ( m_CollectPoints )
-              {
-              m_ProcessedPoints->push_back( current_node_pair );
-              }
-
-              // set this node as alive
-            this->SetLabelValueForGivenNode( current_node, Traits::Alive );
+            // set this node as alive
+          this->SetLabelValueForGivenNode( current_node, Traits::Alive );
 
-            // update its neighbors
-            this->UpdateNeighbors( output, current_node );
-            }
+          // update its neighbors
+          this->UpdateNeighbors( output, current_node );
           }
-        progress.CompletedPixel();
         }
+      progress.CompletedPixel();
       }
     }
   catch ( ProcessAborted & )
@@ -194,14 +174,7 @@ GenerateData()
     // it.
     //
     // RELEASE MEMORY!!!
-    while( !m_Heap.empty() )
-      {
-      m_Heap.pop();
-      }
-    /*while( !m_Heap->Empty() )
-      {
-      m_Heap->Pop();
-      }*/
+    this->ClearHeap();
 
     throw ProcessAborted(__FILE__, __LINE__);
     }
@@ -209,14 +182,58 @@ GenerateData()
   m_TargetReachedValue = current_value;
 
   // let's release some useless memory...
-  while( !m_Heap.empty() )
+  this->ClearHeap();
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingBase< TInput, TOutput >::
+PushOrUpdateTrialNode( const NodeType& iNode, const OutputPixelType& iValue )
+  {
+  typename HeapElementMapType::iterator it = m_HeapElements.find( iNode );
+
+  if( it == m_HeapElements.end() )
     {
-    m_Heap.pop();
+    // the map does not move its elements, so that the heap can point to them
+    it = m_HeapElements.insert(
+      std::make_pair( iNode, PriorityQueueElementType( iNode, iValue ) ) ).first;
+    m_Heap->Push( &( it->second ) );
     }
-  /*while( !m_Heap->Empty() )
+  else if( it->second.m_Priority != iValue )
     {
-    m_Heap->Pop();
-    }*/
+    // decrease (or increase) the key of the node in place
+    it->second.m_Priority = iValue;
+    m_Heap->Update( &( it->second ) );
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+typename FastMarchingBase< TInput, TOutput >::NodePairType
+FastMarchingBase< TInput, TOutput >::
+PopTrialNode()
+  {
+  PriorityQueueElementType* element = m_Heap->Peek();
+  const NodePairType node_pair( element->m_Element, element->m_Priority );
+
+  m_Heap->Pop();
+  m_HeapElements.erase( node_pair.GetNode() );
+
+  return node_pair;
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingBase< TInput, TOutput >::
+ClearHeap()
+  {
+  m_Heap->Clear();
+  m_HeapElements.clear();
   }
 // -----------------------------------------------------------------------------
 
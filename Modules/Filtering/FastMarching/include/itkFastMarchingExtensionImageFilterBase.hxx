@@ -127,6 +127,12 @@ void
 FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension >
 ::InitializeOutput(OutputImageType* oImage)
 {
+  // the extension of the auxiliary values is computed while the nodes are updated one at a time
+  if ( this->m_Solver != Superclass::FastMarchingSolver )
+    {
+    itkExceptionMacro(<< "in Initialize(): only the FastMarchingSolver is supported");
+    }
+
   this->Superclass::InitializeOutput( oImage );
 
   if ( !m_AuxiliaryAliveValues )
@@ -249,7 +255,7 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
     //node.SetValue( outputPixel );
     //node.SetIndex( index );
     //m_TrialHeap.push(node);
-    this->m_Heap.push( NodePairType( iNode, outputPixel ) );
+    this->PushOrUpdateTrialNode( iNode, outputPixel );
 
     // update auxiliary values
     for ( unsigned int k = 0; k < AuxDimension; k++ )
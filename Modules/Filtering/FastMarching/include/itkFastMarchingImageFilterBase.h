@@ -23,7 +23,10 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNeighborhoodIterator.h"
 #include "itkArray.h"
+#include "itkBarrier.h"
 #include <bitset>
+#include <deque>
+#include <vector>
 
 namespace itk
 {
@@ -61,6 +64,22 @@ namespace itk
  * "Level Set Methods and Fast Marching Methods", J.A. Sethian,
  * Cambridge Press, Second edition, 1999.
  *
+ * \par Solvers
+ * By default, the nodes are processed one at a time in the order of their
+ * values (FastMarchingSolver). When the solver is set to
+ * FastIterativeSolver, the values are instead computed with the Fast
+ * Iterative Method: a list of active nodes is updated in parallel until
+ * the values converge, then the stopping criterion is applied to the
+ * nodes in the order of their values. Both solvers compute the same
+ * values and labels, up to rounding errors, as long as the alive points
+ * are enclosed by trial points, as in the usual initializations. The
+ * FastIterativeSolver does not support the topology checks, nor the
+ * auxiliary outputs of the subclasses.
+ *
+ * Reference:
+ * W.-K. Jeong and R. T. Whitaker, "A Fast Iterative Method for Eikonal
+ * Equations", SIAM Journal on Scientific Computing, 30(5):2512-2534, 2008.
+ *
  * \tparam TTraits traits
  *
  * \sa ImageFastMarchingTraits
@@ -118,6 +137,11 @@ public:
     ConnectedComponentImageType;
   typedef typename ConnectedComponentImageType::Pointer ConnectedComponentImagePointer;
 
+  /** Type of the image of the positions of the trial nodes in the pool of
+   * heap elements. */
+  typedef Image< uint32_t, ImageDimension >        HeapPositionImageType;
+  typedef typename HeapPositionImageType::Pointer  HeapPositionImagePointer;
+
   typedef NeighborhoodIterator<LabelImageType> NeighborhoodIteratorType;
   typedef typename NeighborhoodIteratorType::RadiusType NeighborhoodRadiusType;
 
@@ -128,6 +152,18 @@ public:
 
   itkGetModifiableObjectMacro(LabelImage, LabelImageType );
 
+  /** \enum SolverType */
+  enum SolverType {
+    /** \c FastMarchingSolver serial, node by node */
+    FastMarchingSolver = 0,
+    /** \c FastIterativeSolver parallel, with the Fast Iterative Method */
+    FastIterativeSolver };
+
+  /** Set/Get the solver used to compute the values. Default is
+   * FastMarchingSolver. */
+  itkSetMacro( Solver, SolverType );
+  itkGetConstReferenceMacro( Solver, SolverType );
+
   /** The output largeset possible, spacing and origin is computed as follows.
    * If the speed image is ITK_NULLPTR or if the OverrideOutputInformation is true,
    * the output information is set from user specified parameters. These
@@ -169,14 +205,36 @@ protected:
   OutputDirectionType m_OutputDirection;
   bool                m_OverrideOutputInformation;
 
+  SolverType m_Solver;
+
   /** Generate the output image meta information. */
   virtual void GenerateOutputInformation() ITK_OVERRIDE;
 
+  /** Run the selected solver. */
+  void GenerateData() ITK_OVERRIDE;
+
   virtual void EnlargeOutputRequestedRegion(DataObject *output) ITK_OVERRIDE;
 
   LabelImagePointer               m_LabelImage;
   ConnectedComponentImagePointer  m_ConnectedComponentImage;
 
+  /** With the FastMarchingSolver, the heap elements of the trial nodes are
+   * stored in a pool, whose elements don't move, and found through an
+   * image of 32 bit positions over the buffered region, which holds for
+   * each node its position in the pool plus one, or zero when it is not
+   * in the heap. This avoids the map of FastMarchingBase, which is still
+   * used when the image is not allocated: by the FastIterativeSolver,
+   * which barely uses the heap, and for regions of 2^32 nodes or more. */
+  typedef typename Superclass::PriorityQueueElementType PriorityQueueElementType;
+  HeapPositionImagePointer                m_HeapPositionImage;
+  std::deque< PriorityQueueElementType >  m_HeapElementPool;
+  std::vector< uint32_t >                 m_FreeHeapElements;
+
+  void PushOrUpdateTrialNode( const NodeType& iNode,
+                              const OutputPixelType& iValue ) ITK_OVERRIDE;
+  NodePairType PopTrialNode() ITK_OVERRIDE;
+  void ClearHeap() ITK_OVERRIDE;
+
   IdentifierType GetTotalNumberOfNodes() const ITK_OVERRIDE;
 
   void SetOutputValue( OutputImageType* oDomain,
@@ -221,6 +279,44 @@ protected:
   // --------------------------------------------------------------------------
   // --------------------------------------------------------------------------
 
+  /**
+   * Functions and variables of the Fast Iterative Method.
+   */
+
+  /** Compute the values with the Fast Iterative Method, then apply the
+   * stopping criterion to the nodes in the order of their values. */
+  void IterativeGenerateData();
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE IterateThreaderCallback( void *arg );
+
+  /** Update the values of the active nodes of a thread until they all
+   * converge. */
+  void ThreadedIterate( ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** Solve the quadratic equation from all the neighbors which have a
+   * value, whatever their label */
+  double IterativeSolve( OutputImageType* oImage, const NodeType& iNode ) const;
+
+  /** Make the neighbors of a node active, if their value can change */
+  void ActivateNeighbors( OutputImageType* oImage, const NodeType& iNode );
+
+  // active nodes, with their value when they were made active
+  std::vector< NodeType >                         m_ActiveNodes;
+  std::vector< OutputPixelType >                  m_ActiveNodeValues;
+  std::vector< OutputPixelType >                  m_NewValues;
+
+  // active nodes which remain active, and nodes which have converged to a
+  // new value, for each thread
+  std::vector< std::vector< NodeType > >          m_RemainingNodes;
+  std::vector< std::vector< OutputPixelType > >   m_RemainingNodeValues;
+  std::vector< std::vector< NodeType > >          m_ConvergedNodes;
+
+  Barrier::Pointer m_Barrier;
+
+  // --------------------------------------------------------------------------
+  // --------------------------------------------------------------------------
+
   /**
    * Functions and variables to check for topology changes (2D/3D only).
    */
@@ -23,6 +23,7 @@
 
 #include "itkImageRegionIterator.h"
 #include "itkConnectedComponentImageFilter.h"
+#include "itkProgressReporter.h"
 #include "itkRelabelComponentImageFilter.h"
 
 namespace itk
@@ -69,6 +70,7 @@ FastMarchingImageFilterBase()
 
   m_InputCache = ITK_NULLPTR;
   m_LabelImage = LabelImageType::New();
+  m_Solver = FastMarchingSolver;
   }
 // -----------------------------------------------------------------------------
 
@@ -204,10 +206,13 @@ UpdateNeighbors( OutputImageType* oImage, const NodeType& iNode )
 
     for( s = -1; s < 2; s+= 2 )
       {
-      if ( ( v > start ) && ( v < last ) )
+      // each neighbor is checked on its own, so that the nodes on the
+      // border of the image also update their inner neighbor
+      if ( ( s < 0 ) ? ( v <= start ) : ( v >= last ) )
         {
-        neighIndex[j] = v + s;
+        continue;
         }
+      neighIndex[j] = v + s;
       label = m_LabelImage->GetPixel(neighIndex);
 
       if ( ( label != Traits::Alive ) &&
@@ -244,7 +249,7 @@ UpdateValue( OutputImageType* oImage, const NodeType& iNode )
     this->SetLabelValueForGivenNode( iNode, Traits::Trial );
 
     // insert point into trial heap
-    this->m_Heap.push( NodePairType( iNode, outputPixel ) );
+    this->PushOrUpdateTrialNode( iNode, outputPixel );
     }
   }
 // -----------------------------------------------------------------------------
@@ -386,6 +391,487 @@ Solve( OutputImageType* oImage,
   }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateData()
+  {
+  if( m_Solver == FastIterativeSolver )
+    {
+    this->IterativeGenerateData();
+    }
+  else
+    {
+    Superclass::GenerateData();
+    }
+
+  // the heap is empty
+  m_HeapPositionImage = ITK_NULLPTR;
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+PushOrUpdateTrialNode( const NodeType& iNode, const OutputPixelType& iValue )
+  {
+  if( m_HeapPositionImage.IsNull() )
+    {
+    Superclass::PushOrUpdateTrialNode( iNode, iValue );
+    return;
+    }
+
+  uint32_t* position = m_HeapPositionImage->GetBufferPointer() +
+    m_HeapPositionImage->ComputeOffset( iNode );
+
+  if( *position == 0 )
+    {
+    // reuse the element of a node which left the heap, if any
+    uint32_t element;
+    if( m_FreeHeapElements.empty() )
+      {
+      element = static_cast< uint32_t >( m_HeapElementPool.size() );
+      m_HeapElementPool.push_back( PriorityQueueElementType( iNode, iValue ) );
+      }
+    else
+      {
+      element = m_FreeHeapElements.back();
+      m_FreeHeapElements.pop_back();
+      m_HeapElementPool[element] = PriorityQueueElementType( iNode, iValue );
+      }
+    *position = element + 1;
+    this->m_Heap->Push( &m_HeapElementPool[element] );
+    }
+  else
+    {
+    // decrease (or increase) the key of the node in place
+    PriorityQueueElementType* element = &m_HeapElementPool[*position - 1];
+    if( element->m_Priority != iValue )
+      {
+      element->m_Priority = iValue;
+      this->m_Heap->Update( element );
+      }
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+typename FastMarchingImageFilterBase< TInput, TOutput >::NodePairType
+FastMarchingImageFilterBase< TInput, TOutput >::
+PopTrialNode()
+  {
+  if( m_HeapPositionImage.IsNull() )
+    {
+    return Superclass::PopTrialNode();
+    }
+
+  PriorityQueueElementType* element = this->m_Heap->Peek();
+  const NodePairType node_pair( element->m_Element, element->m_Priority );
+
+  this->m_Heap->Pop();
+
+  uint32_t* position = m_HeapPositionImage->GetBufferPointer() +
+    m_HeapPositionImage->ComputeOffset( node_pair.GetNode() );
+  m_FreeHeapElements.push_back( *position - 1 );
+  *position = 0;
+
+  return node_pair;
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+ClearHeap()
+  {
+  // the elements of the pool which are still in the heap are the ones
+  // their node points to
+  if( m_HeapPositionImage.IsNotNull() )
+    {
+    for( uint32_t element = 0; element < m_HeapElementPool.size(); element++ )
+      {
+      uint32_t* position = m_HeapPositionImage->GetBufferPointer() +
+        m_HeapPositionImage->ComputeOffset( m_HeapElementPool[element].m_Element );
+      if( *position == element + 1 )
+        {
+        *position = 0;
+        }
+      }
+    }
+  Superclass::ClearHeap();
+  m_HeapElementPool.clear();
+  m_FreeHeapElements.clear();
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+IterativeGenerateData()
+  {
+  if( this->m_TopologyCheck != Superclass::Nothing )
+    {
+    itkExceptionMacro( <<"Topology checks require the FastMarchingSolver" );
+    }
+
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  // the initial trial nodes keep their values, as the alive nodes: the
+  // heap is not used to process them
+  this->ClearHeap();
+
+  m_ActiveNodes.clear();
+  m_ActiveNodeValues.clear();
+
+  if( this->m_TrialPoints )
+    {
+    NodePairContainerConstIterator pointsIter = this->m_TrialPoints->Begin();
+    NodePairContainerConstIterator pointsEnd = this->m_TrialPoints->End();
+
+    while( pointsIter != pointsEnd )
+      {
+      NodeType idx = pointsIter->Value().GetNode();
+
+      if( m_BufferedRegion.IsInside( idx ) &&
+          ( m_LabelImage->GetPixel( idx ) == Traits::InitialTrial ) )
+        {
+        this->ActivateNeighbors( output, idx );
+        }
+      ++pointsIter;
+      }
+    }
+  m_NewValues.resize( m_ActiveNodes.size() );
+
+  // update the active nodes in parallel until they all converge
+  MultiThreader* multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const ThreadIdType numberOfThreads = multiThreader->GetNumberOfThreads();
+
+  m_RemainingNodes.resize( numberOfThreads );
+  m_RemainingNodeValues.resize( numberOfThreads );
+  m_ConvergedNodes.resize( numberOfThreads );
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize( numberOfThreads );
+
+  multiThreader->SetSingleMethod( this->IterateThreaderCallback, this );
+  multiThreader->SingleMethodExecute();
+
+  m_Barrier = ITK_NULLPTR;
+  m_ActiveNodes.clear();
+  m_ActiveNodeValues.clear();
+  m_NewValues.clear();
+  m_RemainingNodes.clear();
+  m_RemainingNodeValues.clear();
+  m_ConvergedNodes.clear();
+
+  // the stopping criterion sees the nodes in the order of their values, as
+  // with the FastMarchingSolver
+  std::vector< NodePairType > reachedNodes;
+
+  ImageRegionConstIteratorWithIndex< LabelImageType > lIt( m_LabelImage, m_BufferedRegion );
+  for( lIt.GoToBegin(); !lIt.IsAtEnd(); ++lIt )
+    {
+    if( ( lIt.Get() == Traits::Far ) || ( lIt.Get() == Traits::InitialTrial ) )
+      {
+      const OutputPixelType value = output->GetPixel( lIt.GetIndex() );
+
+      if( value < this->m_LargeValue )
+        {
+        reachedNodes.push_back( NodePairType( lIt.GetIndex(), value ) );
+        }
+      }
+    }
+  std::sort( reachedNodes.begin(), reachedNodes.end() );
+
+  ProgressReporter progress( this, 0, this->GetTotalNumberOfNodes() );
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  OutputPixelType current_value = 0.;
+
+  typename std::vector< NodePairType >::const_iterator nodeIt = reachedNodes.begin();
+  while( nodeIt != reachedNodes.end() )
+    {
+    current_value = nodeIt->GetValue();
+
+    this->m_StoppingCriterion->SetCurrentNodePair( *nodeIt );
+
+    if( this->m_StoppingCriterion->IsSatisfied() )
+      {
+      break;
+      }
+
+    if( this->m_CollectPoints )
+      {
+      this->m_ProcessedPoints->push_back( *nodeIt );
+      }
+
+    m_LabelImage->SetPixel( nodeIt->GetNode(), Traits::Alive );
+    progress.CompletedPixel();
+    ++nodeIt;
+    }
+
+  this->m_TargetReachedValue = current_value;
+
+  // the nodes beyond the stopping criterion are far away again, except the
+  // ones next to an alive node, which are trial nodes
+  typename std::vector< NodePairType >::const_iterator stopIt = nodeIt;
+  for( ; nodeIt != reachedNodes.end(); ++nodeIt )
+    {
+    if( m_LabelImage->GetPixel( nodeIt->GetNode() ) == Traits::Far )
+      {
+      output->SetPixel( nodeIt->GetNode(), this->m_LargeValue );
+      }
+    }
+
+  for( nodeIt = stopIt; nodeIt != reachedNodes.end(); ++nodeIt )
+    {
+    const NodeType& node = nodeIt->GetNode();
+
+    if( m_LabelImage->GetPixel( node ) != Traits::Far )
+      {
+      continue;
+      }
+
+    NodeType neighbor = node;
+    bool hasAliveNeighbor = false;
+
+    for( unsigned int j = 0; ( j < ImageDimension ) && !hasAliveNeighbor; j++ )
+      {
+      for( int s = -1; s < 2; s += 2 )
+        {
+        neighbor[j] = node[j] + s;
+        if( ( neighbor[j] >= m_StartIndex[j] ) && ( neighbor[j] <= m_LastIndex[j] ) &&
+            ( m_LabelImage->GetPixel( neighbor ) == Traits::Alive ) )
+          {
+          hasAliveNeighbor = true;
+          }
+        }
+      neighbor[j] = node[j];
+      }
+
+    if( hasAliveNeighbor )
+      {
+      this->UpdateValue( output, node );
+      }
+    }
+
+  this->ClearHeap();
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+ITK_THREAD_RETURN_TYPE
+FastMarchingImageFilterBase< TInput, TOutput >::
+IterateThreaderCallback( void *arg )
+  {
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *filter = static_cast< Self * >( info->UserData );
+
+  filter->ThreadedIterate( info->ThreadID, info->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+ThreadedIterate( ThreadIdType threadId, ThreadIdType numberOfThreads )
+  {
+  OutputImageType* output = this->GetOutput();
+
+  std::vector< NodeType >&        remainingNodes = m_RemainingNodes[threadId];
+  std::vector< OutputPixelType >& remainingNodeValues = m_RemainingNodeValues[threadId];
+  std::vector< NodeType >&        convergedNodes = m_ConvergedNodes[threadId];
+
+  // all the threads see the same list of active nodes between the barriers
+  while( !m_ActiveNodes.empty() )
+    {
+    const SizeValueType numberOfActiveNodes = m_ActiveNodes.size();
+    const SizeValueType first = numberOfActiveNodes * threadId / numberOfThreads;
+    const SizeValueType last = numberOfActiveNodes * ( threadId + 1 ) / numberOfThreads;
+
+    // compute the new values from the current ones
+    for( SizeValueType i = first; i < last; i++ )
+      {
+      m_NewValues[i] =
+        static_cast< OutputPixelType >( this->IterativeSolve( output, m_ActiveNodes[i] ) );
+      }
+
+    m_Barrier->Wait();
+
+    // the nodes whose value decreases remain active, the other ones have
+    // converged
+    remainingNodes.clear();
+    remainingNodeValues.clear();
+    convergedNodes.clear();
+
+    for( SizeValueType i = first; i < last; i++ )
+      {
+      const NodeType& node = m_ActiveNodes[i];
+
+      if( m_NewValues[i] < output->GetPixel( node ) )
+        {
+        output->SetPixel( node, m_NewValues[i] );
+        remainingNodes.push_back( node );
+        remainingNodeValues.push_back( m_ActiveNodeValues[i] );
+        }
+      else
+        {
+        m_LabelImage->SetPixel( node, Traits::Far );
+
+        // the neighbors of a node can only change if its value changed
+        if( output->GetPixel( node ) < m_ActiveNodeValues[i] )
+          {
+          convergedNodes.push_back( node );
+          }
+        }
+      }
+
+    m_Barrier->Wait();
+
+    // build the next list of active nodes
+    if( threadId == 0 )
+      {
+      m_ActiveNodes.clear();
+      m_ActiveNodeValues.clear();
+
+      for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        m_ActiveNodes.insert( m_ActiveNodes.end(),
+                              m_RemainingNodes[t].begin(), m_RemainingNodes[t].end() );
+        m_ActiveNodeValues.insert( m_ActiveNodeValues.end(),
+                                   m_RemainingNodeValues[t].begin(), m_RemainingNodeValues[t].end() );
+        }
+
+      for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        for( size_t n = 0; n < m_ConvergedNodes[t].size(); n++ )
+          {
+          this->ActivateNeighbors( output, m_ConvergedNodes[t][n] );
+          }
+        }
+
+      m_NewValues.resize( m_ActiveNodes.size() );
+      }
+
+    m_Barrier->Wait();
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+double
+FastMarchingImageFilterBase< TInput, TOutput >::
+IterativeSolve( OutputImageType* oImage, const NodeType& iNode ) const
+  {
+  InternalNodeStructureArray neighbors;
+
+  NodeType neighbor_node = iNode;
+
+  OutputPixelType neighValue;
+
+  bool hasValue = false;
+
+  typename NodeType::IndexValueType v, temp;
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    InternalNodeStructure temp_node;
+    temp_node.m_Node = iNode;
+    temp_node.m_Value = this->m_LargeValue;
+    temp_node.m_Axis = j;
+
+    v = iNode[j];
+
+    // find smallest valued neighbor in this dimension, whatever its label
+    for ( int s = -1; s < 2; s = s + 2 )
+      {
+      temp = v + s;
+
+      if ( ( temp <= m_LastIndex[j] ) && ( temp >= m_StartIndex[j] ) )
+        {
+        neighbor_node[j] = temp;
+
+        if ( m_LabelImage->GetPixel( neighbor_node ) != Traits::Forbidden )
+          {
+          neighValue = oImage->GetPixel( neighbor_node );
+
+          if ( temp_node.m_Value > neighValue )
+            {
+            temp_node.m_Value = neighValue;
+            temp_node.m_Node = neighbor_node;
+            hasValue = true;
+            }
+          }
+        }
+      }
+
+    neighbors[j] = temp_node;
+
+    // reset neighIndex
+    neighbor_node[j] = v;
+    }
+
+  if ( !hasValue )
+    {
+    return static_cast< double >( this->m_LargeValue );
+    }
+
+  return this->Solve( oImage, iNode, neighbors );
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+ActivateNeighbors( OutputImageType* oImage, const NodeType& iNode )
+  {
+  NodeType neighIndex = iNode;
+
+  typename NodeType::IndexValueType v;
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    v = iNode[j];
+
+    for( int s = -1; s < 2; s += 2 )
+      {
+      if ( ( s < 0 ) ? ( v <= m_StartIndex[j] ) : ( v >= m_LastIndex[j] ) )
+        {
+        continue;
+        }
+      neighIndex[j] = v + s;
+
+      // only the far nodes can change: the alive, initial trial and
+      // forbidden ones are fixed, and the trial ones already are active
+      if ( m_LabelImage->GetPixel( neighIndex ) == Traits::Far )
+        {
+        m_LabelImage->SetPixel( neighIndex, Traits::Trial );
+        m_ActiveNodes.push_back( neighIndex );
+        m_ActiveNodeValues.push_back( oImage->GetPixel( neighIndex ) );
+        }
+      }
+
+    //reset neighIndex
+    neighIndex[j] = v;
+    }
+  }
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< typename TInput, typename TOutput >
 bool
@@ -532,6 +1018,18 @@ InitializeOutput( OutputImageType* oImage )
   m_LabelImage->Allocate();
   m_LabelImage->FillBuffer( Traits::Far );
 
+  // no node is in the heap. The positions, plus one, must fit in 32 bits.
+  m_HeapPositionImage = ITK_NULLPTR;
+  if( ( m_Solver == FastMarchingSolver ) &&
+      ( m_BufferedRegion.GetNumberOfPixels() < NumericTraits< uint32_t >::max() ) )
+    {
+    m_HeapPositionImage = HeapPositionImageType::New();
+    m_HeapPositionImage->CopyInformation(oImage);
+    m_HeapPositionImage->SetBufferedRegion( m_BufferedRegion );
+    m_HeapPositionImage->Allocate();
+    m_HeapPositionImage->FillBuffer( 0 );
+    }
+
   NodeType idx;
   OutputPixelType outputPixel = this->m_LargeValue;
 
@@ -634,8 +1132,8 @@ InitializeOutput( OutputImageType* oImage )
         outputPixel = pointsIter->Value().GetValue();
         this->SetOutputValue( oImage, idx, outputPixel );
 
-        //this->m_Heap->Push( PriorityQueueElementType( idx, pointsIter->second ) );
-        this->m_Heap.push( pointsIter->Value() );
+        this->PushOrUpdateTrialNode( pointsIter->Value().GetNode(),
+                                     pointsIter->Value().GetValue() );
         }
       ++pointsIter;
       }
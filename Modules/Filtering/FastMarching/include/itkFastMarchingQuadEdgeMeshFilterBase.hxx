@@ -236,7 +236,7 @@ FastMarchingQuadEdgeMeshFilterBase< TInput, TOutput >
 
       this->SetLabelValueForGivenNode( iNode, Traits::Trial );
 
-      this->m_Heap.push( NodePairType( iNode, outputPixel ) );
+      this->PushOrUpdateTrialNode( iNode, outputPixel );
       }
     }
   else
@@ -728,7 +728,8 @@ FastMarchingQuadEdgeMeshFilterBase< TInput, TOutput >
         this->SetLabelValueForGivenNode( idx, Traits::InitialTrial );
         this->SetOutputValue( oMesh, idx, outputPixel );
 
-        this->m_Heap.push( pointsIter->Value() );
+        this->PushOrUpdateTrialNode( pointsIter->Value().GetNode(),
+                                     pointsIter->Value().GetValue() );
         }
 
       ++pointsIter;
@@ -28,6 +28,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkNodePair.h"
 
+#include <functional>
+
 namespace itk
 {
 /**  \class FastMarchingTraits
@@ -122,6 +124,9 @@ class FastMarchingTraits<Image<TInputPixel, VDimension>, Image<TOutputPixel, VDi
   {
 public:
   itkStaticConstMacro(ImageDimension, unsigned int, VDimension);
+
+  /** Strict weak ordering of the nodes, to store them in maps */
+  typedef typename Index< VDimension >::LexicographicCompare NodeCompareType;
   };
 
 
@@ -143,6 +148,9 @@ class FastMarchingTraits<QuadEdgeMesh< TInputPixel, VDimension, TInputMeshTraits
   {
 public:
   itkStaticConstMacro(PointDimension, unsigned int, VDimension);
+
+  /** Strict weak ordering of the nodes, to store them in maps */
+  typedef std::less< typename TInputMeshTraits::PointIdentifier > NodeCompareType;
   };
 
 }
@@ -64,6 +64,12 @@ void
 FastMarchingUpwindGradientImageFilterBase< TInput, TOutput >::
 InitializeOutput(OutputImageType *output)
 {
+  // the upwind gradient is computed while the nodes are updated one at a time
+  if ( this->m_Solver != Superclass::FastMarchingSolver )
+    {
+    itkExceptionMacro(<< "in Initialize(): only the FastMarchingSolver is supported");
+    }
+
   Superclass::InitializeOutput(output);
 
   // allocate memory for the GradientImage if requested
@@ -0,0 +1,288 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "itkFastMarchingImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+namespace
+{
+typedef float PixelType;
+
+template< unsigned int VDimension >
+class SolverTestHelper
+{
+public:
+  typedef itk::Image< PixelType, VDimension >                       ImageType;
+  typedef itk::FastMarchingImageFilterBase< ImageType, ImageType >  FilterType;
+  typedef typename FilterType::LabelImageType                       LabelImageType;
+  typedef typename FilterType::NodeType                             NodeType;
+  typedef typename FilterType::NodePairType                         NodePairType;
+  typedef typename FilterType::NodePairContainerType                NodePairContainerType;
+  typedef itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType >
+                                                                    CriterionType;
+
+  SolverTestHelper( const typename ImageType::SizeType& size,
+                    const typename ImageType::SpacingType& spacing,
+                    bool useSpeedImage )
+    {
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+    GeneratorType::Pointer generator = GeneratorType::New();
+    generator->Initialize( 1357 );
+
+    m_Speed = ImageType::New();
+    m_Speed->SetRegions( size );
+    m_Speed->SetSpacing( spacing );
+    m_Speed->Allocate();
+    itk::ImageRegionIteratorWithIndex< ImageType > it( m_Speed, m_Speed->GetLargestPossibleRegion() );
+    for( ; !it.IsAtEnd(); ++it )
+      {
+      it.Set( useSpeedImage ?
+              static_cast< PixelType >( generator->GetUniformVariate( 0.5, 2.0 ) ) : 1 );
+      }
+    m_UseSpeedImage = useSpeedImage;
+
+    // an alive point surrounded by trial points, and a seed on the border
+    // of the image
+    m_TrialPoints = NodePairContainerType::New();
+    m_AlivePoints = NodePairContainerType::New();
+    NodeType node;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      node[d] = size[d] / 3;
+      }
+    m_AlivePoints->push_back( NodePairType( node, 0. ) );
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      NodeType neighbor = node;
+      neighbor[d] = node[d] - 1;
+      m_TrialPoints->push_back( NodePairType( neighbor, 0.5 ) );
+      neighbor[d] = node[d] + 1;
+      m_TrialPoints->push_back( NodePairType( neighbor, 0.7 ) );
+      }
+    node[0] = 0;
+    node[1] = size[1] - 1;
+    m_TrialPoints->push_back( NodePairType( node, 1.5 ) );
+
+    // a wall with a hole
+    m_ForbiddenPoints = NodePairContainerType::New();
+    for( unsigned int i = 2; i < size[1]; i++ )
+      {
+      node.Fill( 0 );
+      node[0] = size[0] / 2;
+      node[1] = i;
+      m_ForbiddenPoints->push_back( NodePairType( node, 0. ) );
+      }
+    }
+
+  typename FilterType::Pointer Run( typename FilterType::SolverType solver,
+                                    itk::ThreadIdType numberOfThreads,
+                                    PixelType threshold ) const
+    {
+    typename CriterionType::Pointer criterion = CriterionType::New();
+    criterion->SetThreshold( threshold );
+
+    typename FilterType::Pointer filter = FilterType::New();
+    if( m_UseSpeedImage )
+      {
+      filter->SetInput( m_Speed );
+      }
+    else
+      {
+      filter->SetOutputSize( m_Speed->GetLargestPossibleRegion().GetSize() );
+      filter->SetOutputSpacing( m_Speed->GetSpacing() );
+      filter->SetOverrideOutputInformation( true );
+      }
+    filter->SetTrialPoints( m_TrialPoints );
+    filter->SetAlivePoints( m_AlivePoints );
+    filter->SetForbiddenPoints( m_ForbiddenPoints );
+    filter->SetStoppingCriterion( criterion );
+    filter->SetSolver( solver );
+    filter->SetNumberOfThreads( numberOfThreads );
+    filter->CollectPointsOn();
+    filter->Update();
+    return filter;
+    }
+
+  // Compare the outputs of the serial and of the parallel solvers.
+  int Compare( itk::ThreadIdType numberOfThreads, PixelType threshold ) const
+    {
+    typename FilterType::Pointer serial =
+      this->Run( FilterType::FastMarchingSolver, 1, threshold );
+    typename FilterType::Pointer parallel =
+      this->Run( FilterType::FastIterativeSolver, numberOfThreads, threshold );
+
+    const double tolerance = 1e-4;
+
+    double maximumError = 0.;
+    unsigned int labelMismatches = 0;
+    unsigned int numberOfAliveNodes = 0;
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType >
+      sIt( serial->GetOutput(), serial->GetOutput()->GetLargestPossibleRegion() );
+    itk::ImageRegionConstIteratorWithIndex< ImageType >
+      pIt( parallel->GetOutput(), parallel->GetOutput()->GetLargestPossibleRegion() );
+
+    for( ; !sIt.IsAtEnd(); ++sIt, ++pIt )
+      {
+      const double serialValue = sIt.Get();
+      const double parallelValue = pIt.Get();
+
+      const unsigned char serialLabel = serial->GetLabelImage()->GetPixel( sIt.GetIndex() );
+      const unsigned char parallelLabel = parallel->GetLabelImage()->GetPixel( sIt.GetIndex() );
+
+      // the nodes at the threshold may be on either side of the front
+      if( std::fabs( serialValue - threshold ) < 10. * tolerance * ( 1. + serialValue ) )
+        {
+        continue;
+        }
+      if( serialLabel != parallelLabel )
+        {
+        ++labelMismatches;
+        }
+      if( serialLabel == FilterType::Traits::Alive )
+        {
+        ++numberOfAliveNodes;
+        }
+      if( serialValue != parallelValue )
+        {
+        maximumError = std::max( maximumError,
+          std::fabs( serialValue - parallelValue ) / ( 1. + std::fabs( serialValue ) ) );
+        }
+      }
+
+    std::cout << "Dimension " << VDimension
+              << ", speed image " << m_UseSpeedImage
+              << ", " << numberOfThreads << " threads"
+              << ", threshold " << threshold
+              << ": " << numberOfAliveNodes << " alive nodes"
+              << ", maximum relative error " << maximumError
+              << ", " << labelMismatches << " label mismatches" << std::endl;
+
+    if( maximumError > tolerance || labelMismatches != 0 )
+      {
+      std::cerr << "The FastIterativeSolver differs from the FastMarchingSolver" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    const double processedPointsDifference =
+      std::fabs( static_cast< double >( serial->GetProcessedPoints()->Size() )
+                 - static_cast< double >( parallel->GetProcessedPoints()->Size() ) );
+    if( processedPointsDifference > 0.01 * serial->GetProcessedPoints()->Size() )
+      {
+      std::cerr << "The numbers of processed points differ: "
+                << serial->GetProcessedPoints()->Size() << " and "
+                << parallel->GetProcessedPoints()->Size() << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    const double targetReachedValueError =
+      std::fabs( serial->GetTargetReachedValue() - parallel->GetTargetReachedValue() );
+    if( targetReachedValueError > 0.1 )
+      {
+      std::cerr << "The target reached values differ: "
+                << serial->GetTargetReachedValue() << " and "
+                << parallel->GetTargetReachedValue() << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    return EXIT_SUCCESS;
+    }
+
+private:
+  typename ImageType::Pointer             m_Speed;
+  bool                                    m_UseSpeedImage;
+  typename NodePairContainerType::Pointer m_TrialPoints;
+  typename NodePairContainerType::Pointer m_AlivePoints;
+  typename NodePairContainerType::Pointer m_ForbiddenPoints;
+};
+}
+
+// ----------------------------------------------------------------------------
+int itkFastMarchingImageFilterBaseSolverTest( int , char * [] )
+  {
+  try
+    {
+    itk::Size< 2 > size2D;
+    size2D[0] = 61;
+    size2D[1] = 53;
+    itk::Vector< double, 2 > spacing2D;
+    spacing2D[0] = 1.;
+    spacing2D[1] = 0.7;
+
+    itk::Size< 3 > size3D;
+    size3D[0] = 21;
+    size3D[1] = 19;
+    size3D[2] = 17;
+    itk::Vector< double, 3 > spacing3D;
+    spacing3D.Fill( 1. );
+    spacing3D[2] = 1.5;
+
+    const SolverTestHelper< 2 > helper2D( size2D, spacing2D, true );
+    const SolverTestHelper< 2 > constantHelper2D( size2D, spacing2D, false );
+    const SolverTestHelper< 3 > helper3D( size3D, spacing3D, true );
+
+    const PixelType large = itk::NumericTraits< PixelType >::max();
+
+    for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads *= 2 )
+      {
+      if( helper2D.Compare( numberOfThreads, large ) != EXIT_SUCCESS
+          || helper2D.Compare( numberOfThreads, 20. ) != EXIT_SUCCESS
+          || constantHelper2D.Compare( numberOfThreads, large ) != EXIT_SUCCESS
+          || helper3D.Compare( numberOfThreads, large ) != EXIT_SUCCESS
+          || helper3D.Compare( numberOfThreads, 8. ) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+
+    // the topology checks require the serial solver
+    typedef SolverTestHelper< 2 >::FilterType FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetSolver( FilterType::FastIterativeSolver );
+    filter->SetTopologyCheck( FilterType::Strict );
+
+    bool caught = false;
+    try
+      {
+      filter->Update();
+      }
+    catch( itk::ExceptionObject & excep )
+      {
+      std::cout << "Expected exception: " << excep.GetDescription() << std::endl;
+      caught = true;
+      }
+    if( !caught )
+      {
+      std::cerr << "Topology checks with the FastIterativeSolver did not throw" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & excep )
+    {
+    std::cerr << excep << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+  }
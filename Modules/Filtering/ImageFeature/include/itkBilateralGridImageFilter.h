@@ -0,0 +1,178 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBilateralGridImageFilter_h
+#define itkBilateralGridImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkFixedArray.h"
+
+namespace itk
+{
+/**
+ * \class BilateralGridImageFilter
+ * \brief Blurs an image while preserving edges, with a bilateral grid
+ *
+ * This filter approximates the output of BilateralImageFilter in a
+ * time that grows linearly with the number of pixels, whatever the
+ * domain sigma. The pixels are accumulated ("splatted") into a coarse
+ * grid over the image domain and the intensity range, whose cells
+ * measure SamplingFactor times the domain sigma along each dimension
+ * and SamplingFactor times the range sigma along the intensities. The
+ * grid is then blurred separably with a Gaussian of 1 / SamplingFactor
+ * cells, and each output pixel is interpolated ("sliced") from the
+ * grid at its position and intensity.
+ *
+ * The grid holds two floats per cell, that is about
+ * 8 * NumberOfPixels * (DynamicRange / RangeSigma)
+ *   / ( SamplingFactor^(ImageDimension+1) * Product(DomainSigma / Spacing) )
+ * bytes. Smaller sampling factors are more accurate, but cost more
+ * memory and time.
+ *
+ * The method was described by Chen, Paris and Durand (Real-time
+ * Edge-Aware Image Processing with the Bilateral Grid. ACM SIGGRAPH.
+ * 2007.)
+ *
+ * \sa BilateralImageFilter
+ *
+ * \ingroup ImageEnhancement
+ * \ingroup ImageFeatureExtraction
+ * \ingroup ITKImageFeature
+ */
+template< typename TInputImage, typename TOutputImage >
+class BilateralGridImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BilateralGridImageFilter                        Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BilateralGridImageFilter, ImageToImageFilter);
+
+  /** Image type information. */
+  typedef TInputImage  InputImageType;
+  typedef TOutputImage OutputImageType;
+
+  /** Superclass typedefs. */
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+
+  typedef typename TOutputImage::PixelType OutputPixelType;
+  typedef typename TInputImage::PixelType  InputPixelType;
+  typedef typename TInputImage::RegionType InputImageRegionType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Typedef of double containers */
+  typedef FixedArray< double, itkGetStaticConstMacro(ImageDimension) > ArrayType;
+
+  /** Standard get/set macros for filter parameters.
+   * DomainSigma is specified in the same units as the Image spacing.
+   * RangeSigma is specified in the units of intensity. */
+  itkSetMacro(DomainSigma, ArrayType);
+  itkGetConstMacro(DomainSigma, const ArrayType);
+  itkSetMacro(DomainMu, double);
+  itkGetConstReferenceMacro(DomainMu, double);
+  itkSetMacro(RangeSigma, double);
+  itkGetConstMacro(RangeSigma, double);
+
+  /** Convenience get/set methods for setting all domain parameters to the
+   * same values.  */
+  void SetDomainSigma(const double v)
+  {
+    m_DomainSigma.Fill(v);
+    this->Modified();
+  }
+
+  /** Set/Get the size of the cells of the grid, in units of the domain
+   * and range sigmas. Default is 1. */
+  itkSetClampMacro(SamplingFactor, double, 0.01, NumericTraits< double >::max());
+  itkGetConstMacro(SamplingFactor, double);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( OutputHasNumericTraitsCheck,
+                   ( Concept::HasNumericTraits< OutputPixelType > ) );
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+                   ( Concept::Convertible< InputPixelType, double > ) );
+  // End concept checking
+#endif
+
+protected:
+  BilateralGridImageFilter();
+  virtual ~BilateralGridImageFilter() {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Splat the input into the grid and blur it. */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Slice the output from the grid. */
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** Release the grid. */
+  void AfterThreadedGenerateData() ITK_OVERRIDE;
+
+  /** BilateralGridImageFilter needs the input pixels within DomainMu
+   * domain sigmas of the output requested region, as does
+   * BilateralImageFilter.
+   * \sa ImageToImageFilter::GenerateInputRequestedRegion() */
+  virtual void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+private:
+  BilateralGridImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);           //purposely not implemented
+
+  /** Blur the grid along one of its dimensions. */
+  void BlurGrid(unsigned int dimension, const std::vector< double > & kernel);
+
+  /** The number of dimensions of the grid: those of the image, then
+   * the intensities. */
+  itkStaticConstMacro(GridDimension, unsigned int, ImageDimension + 1);
+
+  double    m_RangeSigma;
+  ArrayType m_DomainSigma;
+  double    m_DomainMu;
+  double    m_RangeMu;
+  double    m_SamplingFactor;
+
+  /** The grid, in which each cell holds the weighted sum of the
+   * intensities then the sum of the weights splatted into it. */
+  std::vector< float > m_Grid;
+  SizeValueType        m_GridSize[GridDimension];
+  SizeValueType        m_GridStride[GridDimension];
+
+  /** Mapping of the input indices and intensities to grid coordinates. */
+  InputImageRegionType m_GridRegion;
+  double               m_CellSize[GridDimension];
+  double               m_MinimumIntensity;
+  SizeValueType        m_Padding[GridDimension];
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBilateralGridImageFilter.hxx"
+#endif
+
+#endif
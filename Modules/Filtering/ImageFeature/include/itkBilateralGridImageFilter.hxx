@@ -0,0 +1,316 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBilateralGridImageFilter_hxx
+#define itkBilateralGridImageFilter_hxx
+
+#include "itkBilateralGridImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::BilateralGridImageFilter()
+{
+  this->m_DomainSigma.Fill(4.0);
+  this->m_RangeSigma = 50.0;
+  this->m_DomainMu = 2.5;
+  this->m_RangeMu = 4.0;
+  this->m_SamplingFactor = 1.0;
+  this->m_MinimumIntensity = 0.0;
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    this->m_GridSize[d] = 0;
+    this->m_GridStride[d] = 0;
+    this->m_CellSize[d] = 1.0;
+    this->m_Padding[d] = 0;
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method. this should
+  // copy the output requested region to the input requested region
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input and output
+  typename Superclass::InputImagePointer inputPtr =
+    const_cast< TInputImage * >( this->GetInput() );
+
+  if ( !inputPtr )
+    {
+    return;
+    }
+
+  // Pad the image by DomainMu * sigma in all directions
+  typename TInputImage::SizeType radius;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    radius[i] =
+      ( typename TInputImage::SizeType::SizeValueType )
+      std::ceil(m_DomainMu * m_DomainSigma[i] / inputPtr->GetSpacing()[i]);
+    }
+
+  typename TInputImage::RegionType inputRequestedRegion = inputPtr->GetRequestedRegion();
+  inputRequestedRegion.PadByRadius(radius);
+
+  // crop the input requested region at the input's largest possible region
+  if ( inputRequestedRegion.Crop( inputPtr->GetLargestPossibleRegion() ) )
+    {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+    }
+  else
+    {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+
+    // store what we tried to request (prior to trying to crop)
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+    // build an exception
+    InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(inputPtr);
+    throw e;
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  const InputImageType *input = this->GetInput();
+
+  m_GridRegion = input->GetRequestedRegion();
+
+  // the range of the intensities to splat
+  ImageRegionConstIterator< InputImageType > it(input, m_GridRegion);
+  double minimum = NumericTraits< double >::max();
+  double maximum = NumericTraits< double >::NonpositiveMin();
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double value = static_cast< double >( it.Get() );
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+    }
+  m_MinimumIntensity = minimum;
+
+  // The cells measure SamplingFactor sigmas, so that the Gaussian of
+  // the grid has a sigma of 1 / SamplingFactor cells, truncated at the
+  // same number of sigmas as in BilateralImageFilter. The grid is
+  // padded by the radius of the Gaussian, plus a cell for the
+  // interpolation.
+  SizeValueType radius[GridDimension];
+  double        extent[GridDimension];
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    m_CellSize[d] = m_SamplingFactor * m_DomainSigma[d] / input->GetSpacing()[d];
+    radius[d] = static_cast< SizeValueType >( std::ceil(m_DomainMu / m_SamplingFactor) );
+    extent[d] = static_cast< double >( m_GridRegion.GetSize(d) - 1 );
+    }
+  m_CellSize[ImageDimension] = m_SamplingFactor * m_RangeSigma;
+  radius[ImageDimension] = static_cast< SizeValueType >( std::ceil(m_RangeMu / m_SamplingFactor) );
+  extent[ImageDimension] = maximum - minimum;
+
+  double numberOfCells = 1.0;
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    if ( !( m_CellSize[d] > 0.0 ) )
+      {
+      itkExceptionMacro(<< "The domain and range sigmas must be positive.");
+      }
+    m_Padding[d] = radius[d] + 1;
+    m_GridSize[d] = static_cast< SizeValueType >( std::floor(extent[d] / m_CellSize[d]) ) + 2 + 2 * m_Padding[d];
+    m_GridStride[d] = ( d == 0 ) ? 2 : m_GridStride[d - 1] * m_GridSize[d - 1];
+    numberOfCells *= static_cast< double >( m_GridSize[d] );
+    }
+  if ( 2.0 * numberOfCells > static_cast< double >( NumericTraits< SizeValueType >::max() ) )
+    {
+    itkExceptionMacro(<< "The bilateral grid of " << numberOfCells << " cells is too large. "
+                      << "Increase the SamplingFactor or the sigmas.");
+    }
+  m_Grid.assign(2 * static_cast< size_t >( numberOfCells ), 0.0f);
+
+  // splat each pixel into its nearest cell
+  ImageRegionConstIteratorWithIndex< InputImageType > sit(input, m_GridRegion);
+  for ( sit.GoToBegin(); !sit.IsAtEnd(); ++sit )
+    {
+    const double value = static_cast< double >( sit.Get() );
+    SizeValueType offset = 0;
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      const double coordinate = ( sit.GetIndex()[d] - m_GridRegion.GetIndex(d) ) / m_CellSize[d];
+      offset += ( static_cast< SizeValueType >( coordinate + 0.5 ) + m_Padding[d] ) * m_GridStride[d];
+      }
+    const double coordinate = ( value - m_MinimumIntensity ) / m_CellSize[ImageDimension];
+    offset += ( static_cast< SizeValueType >( coordinate + 0.5 ) + m_Padding[ImageDimension] )
+              * m_GridStride[ImageDimension];
+    m_Grid[offset] += static_cast< float >( value );
+    m_Grid[offset + 1] += 1.0f;
+    }
+
+  // blur the grid separably
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    std::vector< double > kernel(2 * radius[d] + 1);
+    double                sum = 0.0;
+    for ( SizeValueType k = 0; k < kernel.size(); ++k )
+      {
+      const double x = ( static_cast< double >( k ) - static_cast< double >( radius[d] ) ) * m_SamplingFactor;
+      kernel[k] = std::exp(-0.5 * x * x);
+      sum += kernel[k];
+      }
+    for ( SizeValueType k = 0; k < kernel.size(); ++k )
+      {
+      kernel[k] /= sum;
+      }
+    this->BlurGrid(d, kernel);
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::BlurGrid(unsigned int dimension, const std::vector< double > & kernel)
+{
+  const SizeValueType stride = m_GridStride[dimension];
+  const SizeValueType size = m_GridSize[dimension];
+  const SizeValueType lineStride = stride * size;
+  const SizeValueType radius = ( kernel.size() - 1 ) / 2;
+
+  std::vector< float > line(2 * size);
+  for ( SizeValueType outer = 0; outer < m_Grid.size(); outer += lineStride )
+    {
+    for ( SizeValueType inner = 0; inner < stride; inner += 2 )
+      {
+      float *first = &m_Grid[outer + inner];
+      for ( SizeValueType i = 0; i < size; ++i )
+        {
+        line[2 * i] = first[i * stride];
+        line[2 * i + 1] = first[i * stride + 1];
+        }
+      for ( SizeValueType i = 0; i < size; ++i )
+        {
+        const SizeValueType begin = ( i > radius ) ? i - radius : 0;
+        const SizeValueType end = std::min(i + radius + 1, size);
+        double              value = 0.0;
+        double              weight = 0.0;
+        for ( SizeValueType j = begin; j < end; ++j )
+          {
+          const double k = kernel[j + radius - i];
+          value += k * line[2 * j];
+          weight += k * line[2 * j + 1];
+          }
+        first[i * stride] = static_cast< float >( value );
+        first[i * stride + 1] = static_cast< float >( weight );
+        }
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  ImageRegionConstIteratorWithIndex< InputImageType > it(input, outputRegionForThread);
+  ImageRegionIterator< OutputImageType >              oit(output, outputRegionForThread);
+  for ( it.GoToBegin(), oit.GoToBegin(); !it.IsAtEnd(); ++it, ++oit )
+    {
+    const double inputValue = static_cast< double >( it.Get() );
+
+    // coordinates of the pixel in the grid
+    SizeValueType cell[GridDimension];
+    double        fraction[GridDimension];
+    for ( unsigned int d = 0; d < GridDimension; ++d )
+      {
+      const double coordinate = ( d < ImageDimension )
+                                ? ( it.GetIndex()[d] - m_GridRegion.GetIndex(d) ) / m_CellSize[d]
+                                : ( inputValue - m_MinimumIntensity ) / m_CellSize[d];
+      const double floorCoordinate = std::floor(coordinate);
+      cell[d] = static_cast< SizeValueType >( floorCoordinate ) + m_Padding[d];
+      fraction[d] = coordinate - floorCoordinate;
+      }
+
+    // multilinear interpolation of the cells around the pixel
+    double value = 0.0;
+    double weight = 0.0;
+    for ( unsigned int corner = 0; corner < ( 1u << GridDimension ); ++corner )
+      {
+      double        cornerWeight = 1.0;
+      SizeValueType offset = 0;
+      for ( unsigned int d = 0; d < GridDimension; ++d )
+        {
+        if ( corner & ( 1u << d ) )
+          {
+          cornerWeight *= fraction[d];
+          offset += ( cell[d] + 1 ) * m_GridStride[d];
+          }
+        else
+          {
+          cornerWeight *= 1.0 - fraction[d];
+          offset += cell[d] * m_GridStride[d];
+          }
+        }
+      value += cornerWeight * m_Grid[offset];
+      weight += cornerWeight * m_Grid[offset + 1];
+      }
+
+    oit.Set( static_cast< OutputPixelType >( weight > 0.0 ? value / weight : inputValue ) );
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  std::vector< float >().swap(m_Grid);
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralGridImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "DomainSigma: " << m_DomainSigma << std::endl;
+  os << indent << "DomainMu: " << m_DomainMu << std::endl;
+  os << indent << "RangeSigma: " << m_RangeSigma << std::endl;
+  os << indent << "SamplingFactor: " << m_SamplingFactor << std::endl;
+}
+} // end namespace itk
+
+#endif
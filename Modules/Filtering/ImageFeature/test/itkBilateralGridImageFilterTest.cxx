@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkBilateralGridImageFilter.h"
+#include "itkBilateralImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkStreamingImageFilter.h"
+
+namespace
+{
+// An image of two noisy plateaus on a ramp, separated by a step along
+// the first dimension.
+template< typename TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size)
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(1234);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const double step = ( it.GetIndex()[0] < static_cast< itk::IndexValueType >( size[0] / 2 ) ) ? 0.0 : 100.0;
+    const double ramp = 0.3 * it.GetIndex()[1];
+    it.Set( step + ramp + generator->GetUniformVariate(-10.0, 10.0) );
+    }
+  return image;
+}
+
+// Compare the output of BilateralGridImageFilter to the one of
+// BilateralImageFilter, and check that the step is preserved.
+template< typename TImage >
+int BilateralGridTest(const typename TImage::SizeType & size,
+                      double samplingFactor,
+                      unsigned int numberOfStreamDivisions,
+                      double maximumMeanError)
+{
+  typedef itk::BilateralImageFilter< TImage, TImage >     ExactFilterType;
+  typedef itk::BilateralGridImageFilter< TImage, TImage > GridFilterType;
+  typedef itk::StreamingImageFilter< TImage, TImage >     StreamingFilterType;
+
+  typename TImage::Pointer input = MakeImage< TImage >(size);
+
+  typename ExactFilterType::Pointer exact = ExactFilterType::New();
+  exact->SetInput(input);
+  exact->SetDomainSigma(3.0);
+  exact->SetRangeSigma(20.0);
+  exact->Update();
+
+  typename GridFilterType::Pointer grid = GridFilterType::New();
+  grid->SetInput(input);
+  grid->SetDomainSigma(3.0);
+  grid->SetRangeSigma(20.0);
+  grid->SetSamplingFactor(samplingFactor);
+
+  typename StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( grid->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streamer->Update();
+
+  double        sumOfErrors = 0.0;
+  double        sumOfSquaredErrors = 0.0;
+  double        maximumError = 0.0;
+  double        lowSum = 0.0;
+  double        highSum = 0.0;
+  unsigned long lowCount = 0;
+  unsigned long highCount = 0;
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+  itk::ImageRegionConstIterator< TImage >     eit( exact->GetOutput(), region );
+  itk::ImageRegionIteratorWithIndex< TImage > git( streamer->GetOutput(), region );
+  for( ; !git.IsAtEnd(); ++eit, ++git )
+    {
+    const double error = std::fabs( static_cast< double >( git.Get() ) - eit.Get() );
+    sumOfErrors += error;
+    sumOfSquaredErrors += error * error;
+    maximumError = std::max(maximumError, error);
+
+    // the pixels on both sides of the step
+    const itk::IndexValueType x = git.GetIndex()[0] - static_cast< itk::IndexValueType >( size[0] / 2 );
+    if( x == -1 )
+      {
+      lowSum += git.Get();
+      ++lowCount;
+      }
+    else if( x == 0 )
+      {
+      highSum += git.Get();
+      ++highCount;
+      }
+    }
+  const double numberOfPixels = static_cast< double >( region.GetNumberOfPixels() );
+  const double meanError = sumOfErrors / numberOfPixels;
+  const double stepHeight = highSum / highCount - lowSum / lowCount;
+
+  std::cout << "Dimension " << TImage::ImageDimension
+            << ", sampling factor " << samplingFactor
+            << ": mean error " << meanError
+            << ", RMS error " << std::sqrt(sumOfSquaredErrors / numberOfPixels)
+            << ", maximum error " << maximumError
+            << ", step " << stepHeight << std::endl;
+
+  if( meanError > maximumMeanError )
+    {
+    std::cerr << "The mean error exceeds " << maximumMeanError << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( stepHeight < 90.0 )
+    {
+    std::cerr << "The step was blurred" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkBilateralGridImageFilterTest(int, char* [] )
+{
+  typedef itk::Image< float, 2 > Image2DType;
+  typedef itk::Image< float, 3 > Image3DType;
+
+  try
+    {
+    Image2DType::SizeType size2D;
+    size2D[0] = 96;
+    size2D[1] = 80;
+    if( BilateralGridTest< Image2DType >( size2D, 1.0, 1, 1.0 ) != EXIT_SUCCESS
+        || BilateralGridTest< Image2DType >( size2D, 0.5, 1, 0.5 ) != EXIT_SUCCESS
+        || BilateralGridTest< Image2DType >( size2D, 0.5, 3, 0.5 ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+
+    Image3DType::SizeType size3D;
+    size3D[0] = 40;
+    size3D[1] = 32;
+    size3D[2] = 24;
+    if( BilateralGridTest< Image3DType >( size3D, 1.0, 2, 1.0 ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+
+    typedef itk::BilateralGridImageFilter< Image2DType, Image2DType > FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->Print(std::cout);
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkDirectionalNeighborhoodOperatorImageFilter_h
+#define itkDirectionalNeighborhoodOperatorImageFilter_h
+
+#include "itkNeighborhoodOperatorImageFilter.h"
+
+namespace itk
+{
+/** \class DirectionalNeighborhoodOperatorImageFilter
+ * \brief Applies a one dimensional NeighborhoodOperator along the
+ * scanlines of an image.
+ *
+ * This filter computes the same inner products as
+ * NeighborhoodOperatorImageFilter, but it is specialized for the
+ * directional operators used by separable filters, such as the ones
+ * built by NeighborhoodOperator::CreateDirectional(). Instead of
+ * sweeping a NeighborhoodIterator across the image, the lines of the
+ * image along the direction of the operator are copied in contiguous
+ * buffers, padded at both ends according to the boundary condition,
+ * and the operator is applied with one tight loop per coefficient.
+ * When the operator is not aligned with the fastest varying index, a
+ * tile of neighboring lines is copied at once, so that the input is
+ * read row by row and the loops run across the lines of the tile.
+ *
+ * The boundary condition is only looked up when the buffers are
+ * padded, so it must be a ZeroFluxNeumannBoundaryCondition, which is
+ * the default one. The filter falls back to the algorithm of
+ * NeighborhoodOperatorImageFilter for other boundary conditions and
+ * for operators that are not one dimensional.
+ *
+ * \sa NeighborhoodOperatorImageFilter
+ * \sa NeighborhoodOperator::CreateDirectional
+ * \ingroup ImageFilters
+ * \ingroup ITKImageFilterBase
+ */
+template< typename TInputImage, typename TOutputImage, typename TOperatorValueType = typename TOutputImage::PixelType >
+class DirectionalNeighborhoodOperatorImageFilter:
+  public NeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType >
+{
+public:
+  /** Standard "Self" & Superclass typedef. */
+  typedef DirectionalNeighborhoodOperatorImageFilter                                     Self;
+  typedef NeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType > Superclass;
+  typedef SmartPointer< Self >                                                           Pointer;
+  typedef SmartPointer< const Self >                                                     ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(DirectionalNeighborhoodOperatorImageFilter, NeighborhoodOperatorImageFilter);
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Inherited typedefs. */
+  typedef typename Superclass::InputImageType           InputImageType;
+  typedef typename Superclass::OutputImageType          OutputImageType;
+  typedef typename Superclass::InputPixelType           InputPixelType;
+  typedef typename Superclass::OutputPixelType          OutputPixelType;
+  typedef typename Superclass::OperatorValueType        OperatorValueType;
+  typedef typename Superclass::ComputingPixelType       ComputingPixelType;
+  typedef typename Superclass::OutputImageRegionType    OutputImageRegionType;
+  typedef typename Superclass::DefaultBoundaryCondition DefaultBoundaryCondition;
+
+  /** Types of the line buffers, which match the ones of the inner
+   * product computed by NeighborhoodOperatorImageFilter. */
+  typedef typename NumericTraits< InputPixelType >::RealType           InputRealType;
+  typedef typename NumericTraits< InputRealType >::AccumulateType      AccumulateType;
+  typedef typename NumericTraits< ComputingPixelType >::ValueType      CoefficientType;
+
+protected:
+  DirectionalNeighborhoodOperatorImageFilter();
+  virtual ~DirectionalNeighborhoodOperatorImageFilter() {}
+
+  /** Find the direction of the operator and check whether the
+   * scanline algorithm can be used. */
+  virtual void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Apply the operator to the lines of the region, or call the
+   * superclass implementation when the scanline algorithm cannot be
+   * used. */
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
+
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  DirectionalNeighborhoodOperatorImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);                             //purposely not implemented
+
+  /** Maximum number of lines copied in a tile, when the operator is
+   * not aligned with the first index. */
+  static const SizeValueType MaximumTileWidth = 64;
+
+  unsigned int m_Direction;
+  bool         m_UseScanlines;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkDirectionalNeighborhoodOperatorImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkDirectionalNeighborhoodOperatorImageFilter_hxx
+#define itkDirectionalNeighborhoodOperatorImageFilter_hxx
+
+#include "itkDirectionalNeighborhoodOperatorImageFilter.h"
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage, typename TOperatorValueType >
+DirectionalNeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType >
+::DirectionalNeighborhoodOperatorImageFilter()
+{
+  m_Direction = 0;
+  m_UseScanlines = false;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TOperatorValueType >
+void
+DirectionalNeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType >
+::BeforeThreadedGenerateData()
+{
+  // the operator must only extend along one direction
+  unsigned int numberOfDirections = 0;
+  m_Direction = 0;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    if ( this->GetOperator().GetRadius(d) > 0 )
+      {
+      m_Direction = d;
+      ++numberOfDirections;
+      }
+    }
+
+  // the padding of the lines replicates the pixels at the boundary
+  m_UseScanlines = numberOfDirections <= 1
+                   && dynamic_cast< DefaultBoundaryCondition * >( this->GetBoundaryCondition() ) != ITK_NULLPTR;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TOperatorValueType >
+void
+DirectionalNeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  if ( !m_UseScanlines )
+    {
+    Superclass::ThreadedGenerateData(outputRegionForThread, threadId);
+    return;
+    }
+
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  const unsigned int    direction = m_Direction;
+  const OffsetValueType radius = static_cast< OffsetValueType >( this->GetOperator().GetRadius(direction) );
+
+  // the coefficients of the operator, in the order of the pixels along
+  // the direction
+  std::vector< CoefficientType > coefficients(2 * radius + 1);
+  const OffsetValueType center = this->GetOperator().GetCenterNeighborhoodIndex();
+  const OffsetValueType stride = this->GetOperator().GetStride(direction);
+  for ( OffsetValueType k = 0; k < 2 * radius + 1; ++k )
+    {
+    coefficients[k] = static_cast< CoefficientType >( this->GetOperator()[center + ( k - radius ) * stride] );
+    }
+
+  // the lines are padded by the radius of the operator, and the pixels
+  // outside of the buffered region of the input are replaced by the
+  // ones on its boundary
+  const typename InputImageType::RegionType & bufferedRegion = input->GetBufferedRegion();
+  const IndexValueType lineFirst = outputRegionForThread.GetIndex(direction);
+  const IndexValueType lineLength = static_cast< IndexValueType >( outputRegionForThread.GetSize(direction) );
+  const IndexValueType paddedFirst = lineFirst - radius;
+  const IndexValueType paddedLength = lineLength + 2 * radius;
+  const IndexValueType readFirst = std::max( paddedFirst, bufferedRegion.GetIndex(direction) );
+  const IndexValueType readLast = std::min( lineFirst + lineLength + radius,
+                                            static_cast< IndexValueType >( bufferedRegion.GetIndex(direction)
+                                                                           + bufferedRegion.GetSize(direction) ) ) - 1;
+
+  // when the operator is not aligned with the first index, the tiles are
+  // made of several lines next to each other along the first index
+  SizeValueType maximumTileWidth = 1;
+  if ( direction != 0 )
+    {
+    maximumTileWidth = outputRegionForThread.GetSize(0);
+    if ( maximumTileWidth > MaximumTileWidth )
+      {
+      maximumTileWidth = MaximumTileWidth;
+      }
+    }
+  const SizeValueType tilesPerLine = ( direction != 0 )
+    ? ( outputRegionForThread.GetSize(0) + maximumTileWidth - 1 ) / maximumTileWidth : 1;
+
+  std::vector< InputRealType >  tile(paddedLength * maximumTileWidth);
+  std::vector< AccumulateType > sums(lineLength * maximumTileWidth);
+
+  // one iteration for each line, or each row of tiles, of the region
+  OutputImageRegionType lines = outputRegionForThread;
+  lines.SetSize(direction, 1);
+  lines.SetSize(0, 1);
+
+  ProgressReporter progress( this, threadId, lines.GetNumberOfPixels() * tilesPerLine, 10 );
+
+  ImageRegionConstIteratorWithIndex< OutputImageType > lit(output, lines);
+  for ( lit.GoToBegin(); !lit.IsAtEnd(); ++lit )
+    {
+    for ( SizeValueType t = 0; t < tilesPerLine; ++t )
+      {
+      typename InputImageType::SizeType tileSize;
+      tileSize.Fill(1);
+      typename InputImageType::RegionType tileRegion( lit.GetIndex(), tileSize );
+      tileRegion.SetIndex( 0, outputRegionForThread.GetIndex(0) + t * maximumTileWidth );
+      SizeValueType width = 1;
+      if ( direction != 0 )
+        {
+        width = outputRegionForThread.GetSize(0) - t * maximumTileWidth;
+        if ( width > maximumTileWidth )
+          {
+          width = maximumTileWidth;
+          }
+        tileRegion.SetSize(0, width);
+        }
+
+      // copy the input, row by row when the tile has several lines
+      tileRegion.SetIndex(direction, readFirst);
+      tileRegion.SetSize(direction, readLast - readFirst + 1);
+      ImageScanlineConstIterator< InputImageType > iit(input, tileRegion);
+      InputRealType *tileIt = &tile[( readFirst - paddedFirst ) * width];
+      while ( !iit.IsAtEnd() )
+        {
+        while ( !iit.IsAtEndOfLine() )
+          {
+          *tileIt = static_cast< InputRealType >( iit.Get() );
+          ++tileIt;
+          ++iit;
+          }
+        iit.NextLine();
+        }
+
+      // pad the ends of the lines
+      const SizeValueType firstRead = ( readFirst - paddedFirst ) * width;
+      for ( SizeValueType k = 0; k < firstRead; ++k )
+        {
+        tile[k] = tile[firstRead + k % width];
+        }
+      const SizeValueType lastRead = ( readLast - paddedFirst ) * width;
+      for ( SizeValueType k = lastRead + width; k < static_cast< SizeValueType >( paddedLength ) * width; ++k )
+        {
+        tile[k] = tile[lastRead + k % width];
+        }
+
+      // each coefficient is applied to all the pixels of the tile at
+      // once, in the same order as the inner product of the superclass
+      const SizeValueType numberOfSums = lineLength * width;
+      std::fill( sums.begin(), sums.begin() + numberOfSums, NumericTraits< AccumulateType >::ZeroValue() );
+      for ( OffsetValueType k = 0; k < 2 * radius + 1; ++k )
+        {
+        const CoefficientType coefficient = coefficients[k];
+        const InputRealType * shifted = &tile[k * width];
+        AccumulateType *      sum = &sums[0];
+        for ( SizeValueType i = 0; i < numberOfSums; ++i )
+          {
+          sum[i] += static_cast< AccumulateType >( coefficient * shifted[i] );
+          }
+        }
+
+      tileRegion.SetIndex(direction, lineFirst);
+      tileRegion.SetSize(direction, lineLength);
+      ImageScanlineIterator< OutputImageType > oit(output, tileRegion);
+      typename std::vector< AccumulateType >::const_iterator sumIt = sums.begin();
+      while ( !oit.IsAtEnd() )
+        {
+        while ( !oit.IsAtEndOfLine() )
+          {
+          oit.Set( static_cast< OutputPixelType >( static_cast< ComputingPixelType >( *sumIt ) ) );
+          ++sumIt;
+          ++oit;
+          }
+        oit.NextLine();
+        }
+      progress.CompletedPixel();
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TOperatorValueType >
+void
+DirectionalNeighborhoodOperatorImageFilter< TInputImage, TOutputImage, TOperatorValueType >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Direction: " << m_Direction << std::endl;
+  os << indent << "UseScanlines: " << m_UseScanlines << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,164 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+
+#include "itkConstantBoundaryCondition.h"
+#include "itkDerivativeOperator.h"
+#include "itkDirectionalNeighborhoodOperatorImageFilter.h"
+#include "itkGaussianOperator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension > InputImageType;
+typedef itk::Image< float, Dimension >         OutputImageType;
+typedef itk::Neighborhood< double, Dimension > OperatorType;
+
+typedef itk::NeighborhoodOperatorImageFilter< InputImageType, OutputImageType, double >            ReferenceFilterType;
+typedef itk::DirectionalNeighborhoodOperatorImageFilter< InputImageType, OutputImageType, double > FilterType;
+
+// Apply the operator with both filters on a requested region of the
+// output, and check that they compute the same values.
+bool SameOutputs(const InputImageType *input, const OperatorType & oper,
+                 const OutputImageType::RegionType & requestedRegion,
+                 itk::ThreadIdType numberOfThreads,
+                 itk::ImageBoundaryCondition< InputImageType > *condition = ITK_NULLPTR)
+{
+  ReferenceFilterType::Pointer reference = ReferenceFilterType::New();
+  reference->SetInput(input);
+  reference->SetOperator(oper);
+  reference->SetNumberOfThreads(1);
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetOperator(oper);
+  filter->SetNumberOfThreads(numberOfThreads);
+  if ( condition )
+    {
+    reference->OverrideBoundaryCondition(condition);
+    filter->OverrideBoundaryCondition(condition);
+    }
+  reference->GetOutput()->SetRequestedRegion(requestedRegion);
+  reference->Update();
+  filter->GetOutput()->SetRequestedRegion(requestedRegion);
+  filter->Update();
+
+  itk::ImageRegionConstIterator< OutputImageType > rit(reference->GetOutput(), requestedRegion);
+  itk::ImageRegionConstIterator< OutputImageType > it(filter->GetOutput(), requestedRegion);
+  for ( ; !rit.IsAtEnd(); ++rit, ++it )
+    {
+    if ( rit.Get() != it.Get() )
+      {
+      std::cerr << "Different values at " << it.GetIndex() << ": "
+                << rit.Get() << " instead of " << it.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkDirectionalNeighborhoodOperatorImageFilterTest(int, char *[])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(2468);
+
+  InputImageType::SizeType size;
+  size[0] = 83;
+  size[1] = 37;
+  size[2] = 11;
+  InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions(size);
+  input->Allocate();
+  itk::ImageRegionIterator< InputImageType > it( input, input->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< unsigned char >( generator->GetIntegerVariate(255) ) );
+    }
+
+  // the whole image, and a region away from the boundaries
+  OutputImageType::RegionType wholeRegion = input->GetLargestPossibleRegion();
+  OutputImageType::RegionType innerRegion = wholeRegion;
+  innerRegion.ShrinkByRadius(3);
+
+  try
+    {
+    for ( unsigned int direction = 0; direction < Dimension; ++direction )
+      {
+      // a kernel larger than the image along the last direction
+      itk::GaussianOperator< double, Dimension > gaussian;
+      gaussian.SetDirection(direction);
+      gaussian.SetVariance(9.0);
+      gaussian.SetMaximumKernelWidth(64);
+      gaussian.CreateDirectional();
+
+      // an antisymmetric kernel
+      itk::DerivativeOperator< double, Dimension > derivative;
+      derivative.SetDirection(direction);
+      derivative.SetOrder(1);
+      derivative.CreateDirectional();
+
+      for ( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; ++numberOfThreads )
+        {
+        std::cout << "Direction " << direction << ", "
+                  << numberOfThreads << " threads" << std::endl;
+        if ( !SameOutputs(input, gaussian, wholeRegion, numberOfThreads)
+             || !SameOutputs(input, gaussian, innerRegion, numberOfThreads)
+             || !SameOutputs(input, derivative, wholeRegion, numberOfThreads)
+             || !SameOutputs(input, derivative, innerRegion, numberOfThreads) )
+          {
+          return EXIT_FAILURE;
+          }
+        }
+
+      // other boundary conditions are handled by the superclass
+      itk::ConstantBoundaryCondition< InputImageType > constant;
+      constant.SetConstant(100);
+      if ( !SameOutputs(input, derivative, wholeRegion, 2, &constant) )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+
+    // so are operators that are not one dimensional
+    OperatorType::SizeType radius;
+    radius.Fill(1);
+    OperatorType box;
+    box.SetRadius(radius);
+    for ( OperatorType::Iterator bit = box.Begin(); bit != box.End(); ++bit )
+      {
+      *bit = 1.0 / box.Size();
+      }
+    if ( !SameOutputs(input, box, wholeRegion, 2) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -314,7 +314,11 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
   this->GetMultiThreader()->SingleMethodExecute();
   this->AfterThreadedGenerateData();
 
-  this->UpdatePointSet();
+  // The residuals are only needed to fit the next level.
+  if( this->m_MaximumNumberOfLevels > 1 )
+    {
+    this->UpdatePointSet();
+    }
 
   if( this->m_DoMultilevel )
     {
@@ -397,7 +401,11 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
     this->GetMultiThreader()->SingleMethodExecute();
     this->AfterThreadedGenerateData();
 
-    this->UpdatePointSet();
+    // The residuals are only needed to fit the next level.
+    if( this->m_CurrentLevel + 1 < this->m_MaximumNumberOfLevels )
+      {
+      this->UpdatePointSet();
+      }
     }
 
   if( this->m_DoMultilevel )
@@ -418,8 +426,6 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
     duplicator->SetInputImage( this->m_PsiLattice );
     duplicator->Update();
     this->m_PhiLattice = duplicator->GetModifiableOutput();
-
-    this->UpdatePointSet();
     }
 
   this->m_IsFittingComplete = true;
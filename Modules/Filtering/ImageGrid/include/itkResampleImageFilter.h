@@ -24,9 +24,13 @@
 #include "itkImageToImageFilter.h"
 #include "itkExtrapolateImageFunction.h"
 #include "itkLinearInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkBSplineTransform.h"
 #include "itkSize.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkIsSame.h"
 
 
 namespace itk
@@ -70,6 +74,19 @@ namespace itk
  *
  * This filter is implemented as a multithreaded filter.  It provides a
  * ThreadedGenerateData() method for its implementation.
+ *
+ * The output is computed one scanline at a time: the positions of all
+ * the pixels of a line are mapped to the input image first, then the
+ * input is evaluated at these positions.  Images of scalar pixels
+ * resampled with a LinearInterpolateImageFunction, a
+ * NearestNeighborInterpolateImageFunction or a cubic
+ * BSplineInterpolateImageFunction, but not with a subclass of these,
+ * are evaluated directly from the input buffer, or from the B-spline
+ * coefficients.  The cubic B-spline weights along the axes of the input
+ * on which all the pixels of a scanline lie at the same continuous index
+ * are computed once per scanline.  For a cubic BSplineTransform whose
+ * grid is aligned with the scanlines, the B-spline weights along the
+ * other axes of the grid are computed once per scanline.
  * \warning For multithreading, the TransformPoint method of the
  * user-designated coordinate transform must be threadsafe.
  *
@@ -145,6 +162,12 @@ public:
   typedef typename LinearInterpolatorType::Pointer
   LinearInterpolatorPointerType;
 
+  typedef NearestNeighborInterpolateImageFunction< InputImageType,
+                                                   TInterpolatorPrecisionType > NearestNeighborInterpolatorType;
+
+  typedef BSplineInterpolateImageFunction< InputImageType,
+                                           TInterpolatorPrecisionType > BSplineInterpolatorType;
+
   /** Extrapolator typedef. */
   typedef ExtrapolateImageFunction< InputImageType,
                                     TInterpolatorPrecisionType >     ExtrapolatorType;
@@ -172,6 +195,10 @@ public:
   typedef ContinuousIndex< TTransformPrecisionType, ImageDimension >
   ContinuousInputIndexType;
 
+  /** Cubic B-spline transforms are mapped one scanline at a time. */
+  typedef BSplineTransform< TTransformPrecisionType,
+                            itkGetStaticConstMacro(ImageDimension), 3 > BSplineTransformType;
+
   /** Typedef to describe the output image region type. */
   typedef typename TOutputImage::RegionType OutputImageRegionType;
 
@@ -336,10 +363,102 @@ protected:
                                                  const ComponentType minComponent,
                                                  const ComponentType maxComponent) const;
 
+  /** Evaluate the input image at the continuous indices of the pixels
+   * of an output scanline. The pixels outside of the input buffer are
+   * extrapolated, or set to the default pixel value. */
+  virtual void EvaluateScanline(const ContinuousInputIndexType *inputIndices,
+                                PixelType *values,
+                                SizeValueType length,
+                                const ComponentType minComponent,
+                                const ComponentType maxComponent) const;
+
+  /** Map the points of an output scanline through a cubic
+   * BSplineTransform, in place. The coefficients along the axes of the
+   * grid that do not vary along the scanline are summed once, so that
+   * each point only requires the weights along one axis. Returns false,
+   * without changing the points, when the scanline is not parallel to
+   * an axis of the grid. */
+  bool TransformScanlineThroughBSpline(const BSplineTransformType *transform,
+                                       PointType *points,
+                                       SizeValueType length) const;
+
 private:
   ResampleImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);      //purposely not implemented
 
+  /** Scanlines of scalar images are evaluated without calling the
+   * interpolator when it is one of these. */
+  typedef enum {
+    GenericInterpolation,
+    LinearInterpolation,
+    NearestNeighborInterpolation,
+    CubicBSplineInterpolation
+  } ScanlineInterpolationType;
+
+  /** Select the evaluation of the scanlines of scalar images at
+   * compile time. */
+  template< bool > struct ScalarDispatch {};
+
+  itkStaticConstMacro(IsScalarResampling, bool,
+                      ( IsSame< TInputImage, Image< typename NumericTraits< InputPixelType >::ValueType,
+                                                    InputImageDimension > >::Value
+                        && IsSame< PixelType, PixelComponentType >::Value ) );
+
+  void EvaluateScalarScanline(const ContinuousInputIndexType *inputIndices,
+                              PixelType *values,
+                              SizeValueType length,
+                              const ComponentType minComponent,
+                              const ComponentType maxComponent,
+                              const ScalarDispatch< true > &) const;
+
+  void EvaluateScalarScanline(const ContinuousInputIndexType *,
+                              PixelType *,
+                              SizeValueType,
+                              const ComponentType,
+                              const ComponentType,
+                              const ScalarDispatch< false > &) const
+  {}
+
+  /** Evaluate the pixels of a scanline from the coefficients of a cubic
+   * BSplineInterpolateImageFunction. */
+  void EvaluateCubicBSplineScanline(const ContinuousInputIndexType *inputIndices,
+                                    PixelType *values,
+                                    SizeValueType length,
+                                    const ComponentType minComponent,
+                                    const ComponentType maxComponent) const;
+
+  /** Whether the interpolator is a cubic BSplineInterpolateImageFunction,
+   * and not a subclass of it.
+   * The B-spline interpolator is only instantiated for scalar images. */
+  bool IsCubicBSplineInterpolator(const ScalarDispatch< true > &) const;
+
+  bool IsCubicBSplineInterpolator(const ScalarDispatch< false > &) const
+  {
+    return false;
+  }
+
+  /** The weights of the 4 coefficients of the cubic B-spline
+   * interpolation at a continuous index along one axis, and their
+   * indices with the mirror boundary conditions of
+   * BSplineInterpolateImageFunction. Returns the index of the first
+   * coefficient before the mirroring. */
+  static IndexValueType ComputeCubicBSplineWeights(double x,
+                                                   IndexValueType startIndex,
+                                                   IndexValueType endIndex,
+                                                   double *weights,
+                                                   IndexValueType *indices);
+
+  static IndexValueType MirrorIndex(IndexValueType index,
+                                    IndexValueType startIndex,
+                                    IndexValueType endIndex);
+
+  /** Evaluate one pixel through the interpolator or the extrapolator. */
+  PixelType EvaluatePixel(const ContinuousInputIndexType & inputIndex,
+                          const ComponentType minComponent,
+                          const ComponentType maxComponent) const;
+
+  ScanlineInterpolationType m_ScanlineInterpolation;
+
   SizeType                m_Size;         // Size of the output image
   InterpolatorPointerType m_Interpolator; // Image function for
                                           // interpolation
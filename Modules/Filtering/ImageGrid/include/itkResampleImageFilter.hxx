@@ -26,6 +26,12 @@
 #include "itkImageLinearIteratorWithIndex.h"
 #include "itkSpecialCoordinatesImage.h"
 #include "itkDefaultConvertPixelTraits.h"
+#include "itkImageScanlineIterator.h"
+#include "itkBSplineKernelFunction.h"
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
 
 namespace itk
 {
@@ -45,6 +51,8 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
 
   m_UseReferenceImage = false;
 
+  m_ScanlineInterpolation = GenericInterpolation;
+
   m_Size.Fill(0);
   m_OutputStartIndex.Fill(0);
 
@@ -196,6 +204,28 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
                                          zeroComponent );
       }
     }
+
+  // Images of scalar pixels are interpolated directly from the buffer
+  // of the input when the interpolation is linear or nearest neighbor.
+  // Subclasses of these interpolators may override their evaluation,
+  // so only the exact types are replaced
+  m_ScanlineInterpolation = GenericInterpolation;
+  if ( IsScalarResampling )
+    {
+    const InterpolatorType & interpolator = *m_Interpolator;
+    if ( typeid( interpolator ) == typeid( LinearInterpolatorType ) )
+      {
+      m_ScanlineInterpolation = LinearInterpolation;
+      }
+    else if ( typeid( interpolator ) == typeid( NearestNeighborInterpolatorType ) )
+      {
+      m_ScanlineInterpolation = NearestNeighborInterpolation;
+      }
+    else if ( this->IsCubicBSplineInterpolator( ScalarDispatch< ( IsScalarResampling != 0 ) >() ) )
+      {
+      m_ScanlineInterpolation = CubicBSplineInterpolation;
+      }
+    }
 }
 
 /**
@@ -301,6 +331,647 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   return outputValue;
 }
 
+/**
+ * Evaluate one pixel
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+typename ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::PixelType
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::EvaluatePixel(const ContinuousInputIndexType & inputIndex,
+                const ComponentType minComponent,
+                const ComponentType maxComponent) const
+{
+  // Evaluate input at right position and copy to the output
+  if ( m_Interpolator->IsInsideBuffer(inputIndex) )
+    {
+    return this->CastPixelWithBoundsChecking( m_Interpolator->EvaluateAtContinuousIndex(inputIndex),
+                                              minComponent, maxComponent );
+    }
+  if ( m_Extrapolator.IsNull() )
+    {
+    return m_DefaultPixelValue; // default background value
+    }
+  return this->CastPixelWithBoundsChecking( m_Extrapolator->EvaluateAtContinuousIndex(inputIndex),
+                                            minComponent, maxComponent );
+}
+
+/**
+ * Evaluate the input at the pixels of a scanline
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::EvaluateScanline(const ContinuousInputIndexType *inputIndices,
+                   PixelType *values,
+                   SizeValueType length,
+                   const ComponentType minComponent,
+                   const ComponentType maxComponent) const
+{
+  if ( m_ScanlineInterpolation != GenericInterpolation )
+    {
+    this->EvaluateScalarScanline( inputIndices, values, length, minComponent, maxComponent,
+                                  ScalarDispatch< ( IsScalarResampling != 0 ) >() );
+    return;
+    }
+
+  for ( SizeValueType i = 0; i < length; ++i )
+    {
+    values[i] = this->EvaluatePixel(inputIndices[i], minComponent, maxComponent);
+    }
+}
+
+/**
+ * Evaluate the input at the pixels of a scanline, without calling the
+ * interpolator
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::EvaluateScalarScanline(const ContinuousInputIndexType *inputIndices,
+                         PixelType *values,
+                         SizeValueType length,
+                         const ComponentType minComponent,
+                         const ComponentType maxComponent,
+                         const ScalarDispatch< true > &) const
+{
+  if ( m_ScanlineInterpolation == CubicBSplineInterpolation )
+    {
+    this->EvaluateCubicBSplineScanline(inputIndices, values, length, minComponent, maxComponent);
+    return;
+    }
+
+  typedef typename InterpolatorType::ContinuousIndexType InterpolatorIndexType;
+  typedef typename InterpolatorIndexType::ValueType      InterpolatorCoordinateType;
+  typedef typename NumericTraits< InputPixelType >::RealType RealType;
+
+  const InputImageType *inputPtr = this->GetInput();
+  const InputPixelType *buffer = inputPtr->GetBufferPointer();
+  const OffsetValueType *offsetTable = inputPtr->GetOffsetTable();
+
+  // Same bounds as ImageFunction::IsInsideBuffer()
+  const typename InputImageType::RegionType & bufferedRegion = inputPtr->GetBufferedRegion();
+  IndexValueType             startIndex[InputImageDimension];
+  IndexValueType             endIndex[InputImageDimension];
+  InterpolatorCoordinateType startContinuousIndex[InputImageDimension];
+  InterpolatorCoordinateType endContinuousIndex[InputImageDimension];
+  for ( unsigned int j = 0; j < InputImageDimension; ++j )
+    {
+    startIndex[j] = bufferedRegion.GetIndex(j);
+    endIndex[j] = startIndex[j] + static_cast< IndexValueType >( bufferedRegion.GetSize(j) ) - 1;
+    startContinuousIndex[j] = static_cast< InterpolatorCoordinateType >( startIndex[j] - 0.5 );
+    endContinuousIndex[j] = static_cast< InterpolatorCoordinateType >( endIndex[j] + 0.5 );
+    }
+
+  // The 2^Dimension neighbors of the linear interpolation, with the
+  // lowest index along dimension j for the neighbors whose bit j is 0
+  const unsigned int numberOfNeighbors = 1u << InputImageDimension;
+  RealType           neighbors[1u << InputImageDimension];
+
+  for ( SizeValueType i = 0; i < length; ++i )
+    {
+    const InterpolatorIndexType & inputIndex = inputIndices[i];
+
+    bool inside = true;
+    for ( unsigned int j = 0; j < InputImageDimension; ++j )
+      {
+      // Test for negative of a positive so we can catch NaN's.
+      if ( !( inputIndex[j] >= startContinuousIndex[j] && inputIndex[j] < endContinuousIndex[j] ) )
+        {
+        inside = false;
+        break;
+        }
+      }
+    if ( !inside )
+      {
+      values[i] = this->EvaluatePixel(inputIndices[i], minComponent, maxComponent);
+      continue;
+      }
+
+    RealType value;
+    if ( m_ScanlineInterpolation == NearestNeighborInterpolation )
+      {
+      OffsetValueType offset = 0;
+      for ( unsigned int j = 0; j < InputImageDimension; ++j )
+        {
+        offset += ( Math::RoundHalfIntegerUp< IndexValueType >(inputIndex[j]) - startIndex[j] ) * offsetTable[j];
+        }
+      value = static_cast< RealType >( buffer[offset] );
+      }
+    else
+      {
+      // Same neighbors and distances as LinearInterpolateImageFunction:
+      // the neighbors past the end of the buffer are replaced by the
+      // ones on its boundary
+      OffsetValueType            offset = 0;
+      OffsetValueType            upperOffsets[InputImageDimension];
+      InterpolatorCoordinateType distances[InputImageDimension];
+      for ( unsigned int j = 0; j < InputImageDimension; ++j )
+        {
+        IndexValueType base = Math::Floor< IndexValueType >(inputIndex[j]);
+        if ( base < startIndex[j] )
+          {
+          base = startIndex[j];
+          }
+        distances[j] = inputIndex[j] - static_cast< InterpolatorCoordinateType >( base );
+        upperOffsets[j] = ( distances[j] > 0.0 && base < endIndex[j] ) ? offsetTable[j] : 0;
+        offset += ( base - startIndex[j] ) * offsetTable[j];
+        }
+      OffsetValueType neighborOffsets[1u << InputImageDimension];
+      neighborOffsets[0] = offset;
+      for ( unsigned int j = 0; j < InputImageDimension; ++j )
+        {
+        const unsigned int count = 1u << j;
+        for ( unsigned int n = 0; n < count; ++n )
+          {
+          neighborOffsets[count + n] = neighborOffsets[n] + upperOffsets[j];
+          }
+        }
+      for ( unsigned int n = 0; n < numberOfNeighbors; ++n )
+        {
+        neighbors[n] = static_cast< RealType >( buffer[neighborOffsets[n]] );
+        }
+
+      // Interpolate along each dimension in turn
+      for ( unsigned int j = 0; j < InputImageDimension; ++j )
+        {
+        const unsigned int remaining = numberOfNeighbors >> ( j + 1 );
+        for ( unsigned int n = 0; n < remaining; ++n )
+          {
+          neighbors[n] = neighbors[2 * n] + ( neighbors[2 * n + 1] - neighbors[2 * n] ) * distances[j];
+          }
+        }
+      value = neighbors[0];
+      }
+
+    const ComponentType component = static_cast< ComponentType >( value );
+    if ( component < minComponent )
+      {
+      values[i] = static_cast< PixelType >( minComponent );
+      }
+    else if ( component > maxComponent )
+      {
+      values[i] = static_cast< PixelType >( maxComponent );
+      }
+    else
+      {
+      values[i] = static_cast< PixelType >( component );
+      }
+    }
+}
+
+/**
+ * Check whether the interpolator is a cubic B-spline interpolator
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::IsCubicBSplineInterpolator(const ScalarDispatch< true > &) const
+{
+  const InterpolatorType & interpolator = *m_Interpolator;
+  return typeid( interpolator ) == typeid( BSplineInterpolatorType )
+         && static_cast< const BSplineInterpolatorType & >( interpolator ).GetSplineOrder() == 3;
+}
+
+/**
+ * Same mirror boundary conditions as BSplineInterpolateImageFunction
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+IndexValueType
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::MirrorIndex(IndexValueType index, IndexValueType startIndex, IndexValueType endIndex)
+{
+  if ( startIndex == endIndex )
+    {
+    return startIndex;
+    }
+  if ( index < startIndex )
+    {
+    index = startIndex + ( startIndex - index );
+    }
+  if ( index >= endIndex )
+    {
+    index = endIndex - ( index - endIndex );
+    }
+  return index;
+}
+
+/**
+ * Same region of support and weights as BSplineInterpolateImageFunction
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+IndexValueType
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::ComputeCubicBSplineWeights(double x,
+                             IndexValueType startIndex,
+                             IndexValueType endIndex,
+                             double *weights,
+                             IndexValueType *indices)
+{
+  const IndexValueType first = static_cast< IndexValueType >( std::floor( static_cast< float >( x ) ) ) - 1;
+  const double         w = x - static_cast< double >( first + 1 );
+
+  weights[3] = ( 1.0 / 6.0 ) * w * w * w;
+  weights[0] = ( 1.0 / 6.0 ) + 0.5 * w * ( w - 1.0 ) - weights[3];
+  weights[2] = w + weights[0] - 2.0 * weights[3];
+  weights[1] = 1.0 - weights[0] - weights[2] - weights[3];
+  for ( unsigned int k = 0; k < 4; ++k )
+    {
+    indices[k] = MirrorIndex(first + k, startIndex, endIndex);
+    }
+  return first;
+}
+
+/**
+ * Evaluate the pixels of a scanline from the coefficients of a cubic
+ * B-spline interpolator
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::EvaluateCubicBSplineScanline(const ContinuousInputIndexType *inputIndices,
+                               PixelType *values,
+                               SizeValueType length,
+                               const ComponentType minComponent,
+                               const ComponentType maxComponent) const
+{
+  typedef typename BSplineInterpolatorType::CoefficientImageType CoefficientImageType;
+  typedef typename CoefficientImageType::PixelType               CoefficientType;
+  typedef typename InterpolatorType::ContinuousIndexType         InterpolatorIndexType;
+
+  const BSplineInterpolatorType *interpolator =
+    static_cast< const BSplineInterpolatorType * >( m_Interpolator.GetPointer() );
+  const CoefficientImageType *   coefficients = interpolator->GetCoefficients();
+  const CoefficientType *        buffer = coefficients->GetBufferPointer();
+  const OffsetValueType *        offsetTable = coefficients->GetOffsetTable();
+  const typename CoefficientImageType::IndexType & bufferStart = coefficients->GetBufferedRegion().GetIndex();
+  const typename InputImageType::IndexType &       startIndex = interpolator->GetStartIndex();
+  const typename InputImageType::IndexType &       endIndex = interpolator->GetEndIndex();
+  const InterpolatorIndexType &                    startContinuousIndex = interpolator->GetStartContinuousIndex();
+  const InterpolatorIndexType &                    endContinuousIndex = interpolator->GetEndContinuousIndex();
+
+  // The pixels outside of the buffer are evaluated one at a time
+  std::vector< bool > inside(length, true);
+  SizeValueType       firstInside = length;
+  for ( SizeValueType i = 0; i < length; ++i )
+    {
+    for ( unsigned int j = 0; j < InputImageDimension; ++j )
+      {
+      // Test for negative of a positive so we can catch NaN's.
+      if ( !( inputIndices[i][j] >= startContinuousIndex[j] && inputIndices[i][j] < endContinuousIndex[j] ) )
+        {
+        inside[i] = false;
+        break;
+        }
+      }
+    if ( inside[i] )
+      {
+      firstInside = std::min(firstInside, i);
+      }
+    else
+      {
+      values[i] = this->EvaluatePixel(inputIndices[i], minComponent, maxComponent);
+      }
+    }
+  if ( firstInside == length )
+    {
+    return;
+    }
+
+  // The axes along which the pixels of the scanline have the same
+  // continuous index, typically all but one for a linear transform that
+  // keeps the axes of the input
+  bool         isConstant[InputImageDimension];
+  unsigned int varyingAxes[InputImageDimension];
+  unsigned int numberOfVaryingAxes = 0;
+  for ( unsigned int j = 0; j < InputImageDimension; ++j )
+    {
+    isConstant[j] = true;
+    for ( SizeValueType i = firstInside; i < length && isConstant[j]; ++i )
+      {
+      isConstant[j] = !inside[i] || inputIndices[i][j] == inputIndices[firstInside][j];
+      }
+    if ( !isConstant[j] )
+      {
+      varyingAxes[numberOfVaryingAxes++] = j;
+      }
+    }
+
+  // The weights and the offsets of the coefficients along the constant
+  // axes, computed once for the scanline
+  double             constantWeights[1u << ( 2 * InputImageDimension )];
+  OffsetValueType    constantOffsets[1u << ( 2 * InputImageDimension )];
+  unsigned int       numberOfConstantTaps = 1;
+  constantWeights[0] = 1.0;
+  constantOffsets[0] = 0;
+  for ( unsigned int j = 0; j < InputImageDimension; ++j )
+    {
+    if ( !isConstant[j] )
+      {
+      continue;
+      }
+    double         weights[4];
+    IndexValueType indices[4];
+    ComputeCubicBSplineWeights(inputIndices[firstInside][j], startIndex[j], endIndex[j], weights, indices);
+    for ( unsigned int n = numberOfConstantTaps; n-- > 0; )
+      {
+      const double          weight = constantWeights[n];
+      const OffsetValueType offset = constantOffsets[n];
+      for ( unsigned int k = 4; k-- > 0; )
+        {
+        constantWeights[4 * n + k] = weight * weights[k];
+        constantOffsets[4 * n + k] = offset + ( indices[k] - bufferStart[j] ) * offsetTable[j];
+        }
+      }
+    numberOfConstantTaps *= 4;
+    }
+
+  // With a single varying axis, the coefficients are first summed along
+  // the constant axes, on the range of the scanline along the varying
+  // axis, if that range is not much longer than the scanline
+  if ( numberOfVaryingAxes == 1 )
+    {
+    const unsigned int axis = varyingAxes[0];
+    IndexValueType     lowest = NumericTraits< IndexValueType >::max();
+    IndexValueType     highest = NumericTraits< IndexValueType >::NonpositiveMin();
+    for ( SizeValueType i = firstInside; i < length; ++i )
+      {
+      if ( inside[i] )
+        {
+        const IndexValueType first =
+          static_cast< IndexValueType >( std::floor( static_cast< float >( inputIndices[i][axis] ) ) ) - 1;
+        lowest = std::min(lowest, first);
+        highest = std::max(highest, first + 3);
+        }
+      }
+    const SizeValueType lineLength = static_cast< SizeValueType >( highest - lowest + 1 );
+    if ( lineLength <= 4 * length )
+      {
+      std::vector< double > line(lineLength);
+      for ( SizeValueType k = 0; k < lineLength; ++k )
+        {
+        const IndexValueType  index = MirrorIndex(lowest + static_cast< IndexValueType >( k ),
+                                                  startIndex[axis], endIndex[axis]);
+        const CoefficientType *column = buffer + ( index - bufferStart[axis] ) * offsetTable[axis];
+        double                 sum = 0.0;
+        for ( unsigned int n = 0; n < numberOfConstantTaps; ++n )
+          {
+          sum += constantWeights[n] * column[constantOffsets[n]];
+          }
+        line[k] = sum;
+        }
+
+      for ( SizeValueType i = firstInside; i < length; ++i )
+        {
+        if ( !inside[i] )
+          {
+          continue;
+          }
+        double               weights[4];
+        IndexValueType       indices[4];
+        const IndexValueType first =
+          ComputeCubicBSplineWeights(inputIndices[i][axis], startIndex[axis], endIndex[axis], weights, indices);
+        const double *taps = &line[first - lowest];
+        const double  value = weights[0] * taps[0] + weights[1] * taps[1] + weights[2] * taps[2] + weights[3] * taps[3];
+        values[i] = this->CastPixelWithBoundsChecking(value, minComponent, maxComponent);
+        }
+      return;
+      }
+    }
+
+  // Otherwise, the weights along the varying axes are computed for each
+  // pixel
+  double          varyingWeights[1u << ( 2 * InputImageDimension )];
+  OffsetValueType varyingOffsets[1u << ( 2 * InputImageDimension )];
+  for ( SizeValueType i = firstInside; i < length; ++i )
+    {
+    if ( !inside[i] )
+      {
+      continue;
+      }
+    unsigned int numberOfVaryingTaps = 1;
+    varyingWeights[0] = 1.0;
+    varyingOffsets[0] = 0;
+    for ( unsigned int a = 0; a < numberOfVaryingAxes; ++a )
+      {
+      const unsigned int j = varyingAxes[a];
+      double             weights[4];
+      IndexValueType     indices[4];
+      ComputeCubicBSplineWeights(inputIndices[i][j], startIndex[j], endIndex[j], weights, indices);
+      for ( unsigned int n = numberOfVaryingTaps; n-- > 0; )
+        {
+        const double          weight = varyingWeights[n];
+        const OffsetValueType offset = varyingOffsets[n];
+        for ( unsigned int k = 4; k-- > 0; )
+          {
+          varyingWeights[4 * n + k] = weight * weights[k];
+          varyingOffsets[4 * n + k] = offset + ( indices[k] - bufferStart[j] ) * offsetTable[j];
+          }
+        }
+      numberOfVaryingTaps *= 4;
+      }
+
+    double value = 0.0;
+    for ( unsigned int m = 0; m < numberOfVaryingTaps; ++m )
+      {
+      const CoefficientType *column = buffer + varyingOffsets[m];
+      double                 sum = 0.0;
+      for ( unsigned int n = 0; n < numberOfConstantTaps; ++n )
+        {
+        sum += constantWeights[n] * column[constantOffsets[n]];
+        }
+      value += varyingWeights[m] * sum;
+      }
+    values[i] = this->CastPixelWithBoundsChecking(value, minComponent, maxComponent);
+    }
+}
+
+/**
+ * Map the points of a scanline through a cubic B-spline transform
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::TransformScanlineThroughBSpline(const BSplineTransformType *transform,
+                                  PointType *points,
+                                  SizeValueType length) const
+{
+  typedef typename BSplineTransformType::ImageType           CoefficientImageType;
+  typedef typename BSplineTransformType::ContinuousIndexType GridIndexType;
+  typedef typename BSplineTransformType::ScalarType          ScalarType;
+  typedef typename BSplineTransformType::InputPointType      TransformPointType;
+  typedef typename CoefficientImageType::PixelType           CoefficientType;
+
+  const unsigned int SplineOrder = 3;
+  const unsigned int SupportSize = SplineOrder + 1;
+
+  const typename BSplineTransformType::CoefficientImageArray coefficientImages = transform->GetCoefficientImages();
+  const CoefficientImageType *grid = coefficientImages[0];
+  if ( length < 2 || !grid->GetBufferPointer() )
+    {
+    return false;
+    }
+  const typename CoefficientImageType::SizeType gridSize = grid->GetLargestPossibleRegion().GetSize();
+  const OffsetValueType *                      gridOffsetTable = grid->GetOffsetTable();
+
+  // Find the axis of the grid along which the scanline runs: the
+  // continuous indices along the other axes must be the same for all the
+  // points, up to rounding errors
+  GridIndexType firstIndex;
+  GridIndexType lastIndex;
+  grid->TransformPhysicalPointToContinuousIndex( TransformPointType( points[0] ), firstIndex );
+  grid->TransformPhysicalPointToContinuousIndex( TransformPointType( points[length - 1] ), lastIndex );
+  unsigned int axis = 0;
+  for ( unsigned int j = 1; j < ImageDimension; ++j )
+    {
+    if ( std::fabs( lastIndex[j] - firstIndex[j] ) > std::fabs( lastIndex[axis] - firstIndex[axis] ) )
+      {
+      axis = j;
+      }
+    }
+  const double tolerance = 1e-9;
+  for ( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+    if ( j != axis && std::fabs( lastIndex[j] - firstIndex[j] ) > tolerance )
+      {
+      return false;
+      }
+    }
+
+  // Same valid region as BSplineTransform::InsideValidRegion()
+  const ScalarType minLimit = 0.5 * static_cast< ScalarType >( SplineOrder - 1 );
+  ScalarType       maxLimits[ImageDimension];
+  for ( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+    maxLimits[j] = static_cast< ScalarType >( gridSize[j] ) - 0.5 * static_cast< ScalarType >( SplineOrder - 1 ) - 1.0;
+    }
+
+  typedef BSplineKernelFunction< SplineOrder > KernelType;
+  typename KernelType::Pointer kernel = KernelType::New();
+
+  // The weights along the other axes, and the offsets of their support
+  // in the grid
+  unsigned int   numberOfOtherWeights = 1;
+  double         otherWeights1D[ImageDimension][SupportSize];
+  for ( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+    if ( j == axis )
+      {
+      continue;
+      }
+    ScalarType index = firstIndex[j];
+    if ( index == maxLimits[j] )
+      {
+      index -= 1e-6;
+      }
+    else if ( index >= maxLimits[j] || index < minLimit )
+      {
+      // the whole scanline is outside of the valid region, where the
+      // displacement is zero
+      return true;
+      }
+    const IndexValueType start = Math::Floor< IndexValueType >( index - static_cast< double >( SplineOrder - 1 ) / 2.0 );
+    double x = index - static_cast< double >( start );
+    for ( unsigned int k = 0; k < SupportSize; ++k )
+      {
+      otherWeights1D[j][k] = kernel->Evaluate(x);
+      x -= 1.0;
+      }
+    firstIndex[j] = start;
+    numberOfOtherWeights *= SupportSize;
+    }
+
+  // Sum the coefficients along the other axes, for all the positions of
+  // the grid along the axis of the scanline
+  const SizeValueType lineSize = gridSize[axis];
+  std::vector< CoefficientType > lines( ImageDimension * lineSize, NumericTraits< CoefficientType >::ZeroValue() );
+  for ( unsigned int w = 0; w < numberOfOtherWeights; ++w )
+    {
+    double          weight = 1.0;
+    OffsetValueType offset = 0;
+    unsigned int    remainder = w;
+    for ( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+      if ( j == axis )
+        {
+        continue;
+        }
+      const unsigned int k = remainder % SupportSize;
+      remainder /= SupportSize;
+      weight *= otherWeights1D[j][k];
+      offset += ( static_cast< OffsetValueType >( firstIndex[j] ) + k ) * gridOffsetTable[j];
+      }
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      const CoefficientType *coefficients = coefficientImages[d]->GetBufferPointer() + offset;
+      CoefficientType *      line = &lines[d * lineSize];
+      for ( SizeValueType g = 0; g < lineSize; ++g )
+        {
+        line[g] += static_cast< CoefficientType >( weight * coefficients[g * gridOffsetTable[axis]] );
+        }
+      }
+    }
+
+  // Each point only requires the weights along the axis of the scanline
+  for ( SizeValueType i = 0; i < length; ++i )
+    {
+    GridIndexType gridIndex;
+    grid->TransformPhysicalPointToContinuousIndex( TransformPointType( points[i] ), gridIndex );
+    ScalarType index = gridIndex[axis];
+    if ( index == maxLimits[axis] )
+      {
+      index -= 1e-6;
+      }
+    else if ( index >= maxLimits[axis] || index < minLimit )
+      {
+      continue;
+      }
+    const IndexValueType start = Math::Floor< IndexValueType >( index - static_cast< double >( SplineOrder - 1 ) / 2.0 );
+    double x = index - static_cast< double >( start );
+    double weights[SupportSize];
+    for ( unsigned int k = 0; k < SupportSize; ++k )
+      {
+      weights[k] = kernel->Evaluate(x);
+      x -= 1.0;
+      }
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      const CoefficientType *line = &lines[d * lineSize + start];
+      ScalarType displacement = NumericTraits< ScalarType >::ZeroValue();
+      for ( unsigned int k = 0; k < SupportSize; ++k )
+        {
+        displacement += static_cast< ScalarType >( weights[k] * line[k] );
+        }
+      points[i][d] += displacement;
+      }
+    }
+  return true;
+}
+
 /**
  * NonlinearThreadedGenerateData
  */
@@ -323,17 +994,23 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   // Get the input transform
   const TransformType *transformPtr = this->GetTransform();
 
+  // Cubic B-spline transforms are evaluated one scanline at a time,
+  // unless a subclass may override TransformPoint
+  const BSplineTransformType *bsplineTransformPtr = ITK_NULLPTR;
+  if ( typeid( *transformPtr ) == typeid( BSplineTransformType ) )
+    {
+    bsplineTransformPtr = static_cast< const BSplineTransformType * >( transformPtr );
+    }
 
   // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIterator;
+  typedef ImageScanlineIterator< TOutputImage > OutputIterator;
   OutputIterator outIt(outputPtr, outputRegionForThread);
 
-  // Define a few indices that will be used to translate from an input pixel
-  // to an output pixel
-  PointType outputPoint;         // Coordinates of current output pixel
-  PointType inputPoint;          // Coordinates of current input pixel
-
-  ContinuousInputIndexType inputIndex;
+  // The positions of the pixels of a scanline, mapped to the input image
+  const SizeValueType                     length = outputRegionForThread.GetSize(0);
+  std::vector< PointType >                points(length);
+  std::vector< ContinuousInputIndexType > inputIndices(length);
+  std::vector< PixelType >                values(length);
 
   // Support for progress methods/callbacks
   ProgressReporter progress( this,
@@ -345,47 +1022,43 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
   const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
 
-  typedef typename InterpolatorType::OutputType OutputType;
   const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
   const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
 
   // Walk the output region
-  outIt.GoToBegin();
-
   while ( !outIt.IsAtEnd() )
     {
-    // Determine the index of the current output pixel
-    outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), outputPoint);
-
-    // Compute corresponding input pixel position
-    inputPoint = transformPtr->TransformPoint(outputPoint);
-    inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
-
-    PixelType  pixval;
-    OutputType value;
-    // Evaluate input at right position and copy to the output
-    if ( m_Interpolator->IsInsideBuffer(inputIndex) )
+    // Determine the positions of the pixels of the current output scanline
+    IndexType index = outIt.GetIndex();
+    for ( SizeValueType i = 0; i < length; ++i )
       {
-      value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
-      pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-      outIt.Set(pixval);
+      outputPtr->TransformIndexToPhysicalPoint(index, points[i]);
+      ++index[0];
       }
-    else
+
+    // Compute corresponding input pixel positions
+    if ( !bsplineTransformPtr
+         || !this->TransformScanlineThroughBSpline(bsplineTransformPtr, &points[0], length) )
       {
-      if( m_Extrapolator.IsNull() )
-        {
-        outIt.Set( m_DefaultPixelValue ); // default background value
-        }
-      else
+      for ( SizeValueType i = 0; i < length; ++i )
         {
-        value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
-        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-        outIt.Set(pixval);
+        points[i] = transformPtr->TransformPoint(points[i]);
         }
       }
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      inputPtr->TransformPhysicalPointToContinuousIndex(points[i], inputIndices[i]);
+      }
+
+    this->EvaluateScanline(&inputIndices[0], &values[0], length, minOutputValue, maxOutputValue);
 
-    progress.CompletedPixel();
-    ++outIt;
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      outIt.Set(values[i]);
+      progress.CompletedPixel();
+      ++outIt;
+      }
+    outIt.NextLine();
     }
 }
 
@@ -432,22 +1105,21 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
 
   IndexType index;
 
+  // The continuous indices of the pixels of a scanline, and their values
+  const SizeValueType                     length = outputRegionForThread.GetSize(0);
+  std::vector< ContinuousInputIndexType > inputIndices(length);
+  std::vector< PixelType >                values(length);
+
   // Support for progress methods/callbacks
   ProgressReporter progress( this,
                              threadId,
                              outputRegionForThread.GetNumberOfPixels() );
 
-  typedef typename InterpolatorType::OutputType OutputType;
-
-  // Cache information from the superclass
-  PixelType defaultValue = this->GetDefaultPixelValue();
-
   // Min/max values of the output pixel type AND these values
   // represented as the output type of the interpolator
   const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
   const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
 
-  typedef typename InterpolatorType::OutputType OutputType;
   const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
   const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
 
@@ -497,34 +1169,19 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     inputPoint = transformPtr->TransformPoint(outputPoint);
     inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
 
-    while ( !outIt.IsAtEndOfLine() )
+    for ( SizeValueType i = 0; i < length; ++i )
       {
-      PixelType  pixval;
-      OutputType value;
-      // Evaluate input at right position and copy to the output
-      if ( m_Interpolator->IsInsideBuffer(inputIndex) )
-        {
-        value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
-        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-        outIt.Set(pixval);
-        }
-      else
-        {
-        if( m_Extrapolator.IsNull() )
-          {
-          outIt.Set(defaultValue); // default background value
-          }
-        else
-          {
-          value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
-          pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-          outIt.Set(pixval);
-          }
-        }
+      inputIndices[i] = inputIndex;
+      inputIndex += delta;
+      }
+
+    this->EvaluateScanline(&inputIndices[0], &values[0], length, minOutputValue, maxOutputValue);
 
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      outIt.Set(values[i]);
       progress.CompletedPixel();
       ++outIt;
-      inputIndex += delta;
       }
     outIt.NextLine();
     } //while( !outIt.IsAtEnd() )
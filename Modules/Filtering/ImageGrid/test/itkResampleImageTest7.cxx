@@ -0,0 +1,288 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkResampleImageFilter.h"
+
+/* Test the scanline evaluation of ResampleImageFilter: the output is
+ * compared to the values computed pixel by pixel with the transform
+ * and the interpolator, for linear and B-spline transforms, linear,
+ * nearest neighbor and cubic B-spline interpolators, and several numbers
+ * of threads.  A subclass of an interpolator that overrides its
+ * evaluation is not replaced by the scanline evaluation. */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension >                              InputImageType;
+typedef itk::Image< unsigned char, Dimension >                      CharImageType;
+typedef itk::ResampleImageFilter< InputImageType, InputImageType >  FilterType;
+typedef FilterType::TransformType                                   TransformType;
+typedef FilterType::InterpolatorType                                InterpolatorType;
+typedef FilterType::LinearInterpolatorType                          LinearInterpolatorType;
+typedef FilterType::NearestNeighborInterpolatorType                 NearestNeighborInterpolatorType;
+typedef FilterType::BSplineInterpolatorType                         BSplineInterpolatorType;
+typedef itk::BSplineTransform< double, Dimension, 3 >               BSplineTransformType;
+
+// A linear interpolator shifted by a constant
+class ShiftedLinearInterpolator:public LinearInterpolatorType
+{
+public:
+  typedef ShiftedLinearInterpolator       Self;
+  typedef LinearInterpolatorType          Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ShiftedLinearInterpolator, LinearInterpolateImageFunction);
+
+  virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType & index) const ITK_OVERRIDE
+  {
+    return Superclass::EvaluateAtContinuousIndex(index) + 10.0;
+  }
+
+protected:
+  ShiftedLinearInterpolator() {}
+  ~ShiftedLinearInterpolator() {}
+
+private:
+  ShiftedLinearInterpolator(const Self &); //purposely not implemented
+  void operator=(const Self &);            //purposely not implemented
+};
+
+// The outputs of type unsigned char are clamped and truncated, so they
+// may differ by one gray level from the expected values
+template< typename TOutputImage >
+int CompareToPixelwiseResampling(const InputImageType *input, const TransformType *transform,
+                                 InterpolatorType *interpolator, double tolerance)
+{
+  typedef TOutputImage                                                OutputImageType;
+  typedef itk::ResampleImageFilter< InputImageType, OutputImageType > ResampleFilterType;
+  const double minimum = itk::NumericTraits< typename OutputImageType::PixelType >::NonpositiveMin();
+  const double maximum = itk::NumericTraits< typename OutputImageType::PixelType >::max();
+
+  typename OutputImageType::SizeType size;
+  size[0] = 29;
+  size[1] = 23;
+  size[2] = 17;
+  typename OutputImageType::SpacingType spacing;
+  spacing.Fill(1.25);
+  typename OutputImageType::PointType origin;
+  origin.Fill(-2.0);
+  const typename OutputImageType::PixelType defaultValue = 7;
+
+  unsigned int numberOfDifferences = 0;
+  for ( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; numberOfThreads += 2 )
+    {
+    typename ResampleFilterType::Pointer filter = ResampleFilterType::New();
+    filter->SetInput(input);
+    filter->SetTransform(transform);
+    filter->SetInterpolator(interpolator);
+    filter->SetSize(size);
+    filter->SetOutputSpacing(spacing);
+    filter->SetOutputOrigin(origin);
+    filter->SetDefaultPixelValue(defaultValue);
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+    const OutputImageType *output = filter->GetOutput();
+
+    interpolator->SetInputImage(input);
+    itk::ImageRegionConstIteratorWithIndex< OutputImageType > it( output, output->GetLargestPossibleRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      typename OutputImageType::PointType point;
+      output->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+      InterpolatorType::ContinuousIndexType index;
+      input->TransformPhysicalPointToContinuousIndex(transform->TransformPoint(point), index);
+      double expected = defaultValue;
+      if ( interpolator->IsInsideBuffer(index) )
+        {
+        expected = std::max( minimum, std::min( maximum, interpolator->EvaluateAtContinuousIndex(index) ) );
+        }
+      const double difference = std::fabs( static_cast< typename OutputImageType::PixelType >( expected ) - it.Get() );
+      if ( difference > tolerance )
+        {
+        if ( numberOfDifferences < 10 )
+          {
+          std::cerr << "At " << it.GetIndex() << " expected " << expected
+                    << " but got " << static_cast< double >( it.Get() ) << std::endl;
+          }
+        ++numberOfDifferences;
+        }
+      }
+    }
+  if ( numberOfDifferences > 0 )
+    {
+    std::cerr << numberOfDifferences << " pixels differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkResampleImageTest7(int, char * [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(1357);
+
+  // values beyond the range of the output, to check the clamping
+  InputImageType::SizeType size;
+  size[0] = 31;
+  size[1] = 27;
+  size[2] = 19;
+  InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions(size);
+  input->Allocate();
+  itk::ImageRegionIterator< InputImageType > iit( input, input->GetLargestPossibleRegion() );
+  for ( ; !iit.IsAtEnd(); ++iit )
+    {
+    iit.Set( static_cast< float >( generator->GetUniformVariate(-50.0, 300.0) ) );
+    }
+
+  typedef itk::AffineTransform< double, Dimension > AffineTransformType;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::OutputVectorType axis;
+  axis[0] = 1.0;
+  axis[1] = 2.0;
+  axis[2] = 0.5;
+  affine->Rotate3D(axis, 0.3);
+  affine->Scale(0.9);
+  AffineTransformType::OutputVectorType translation;
+  translation.Fill(1.5);
+  affine->Translate(translation);
+
+  // an affine transform that keeps the axes, so that the pixels of a
+  // scanline have the same continuous index along all the axes but one
+  AffineTransformType::Pointer scaling = AffineTransformType::New();
+  AffineTransformType::OutputVectorType factors;
+  factors[0] = 0.8;
+  factors[1] = 1.1;
+  factors[2] = 0.95;
+  scaling->Scale(factors);
+  translation[0] = 0.3;
+  translation[1] = -1.7;
+  translation[2] = 2.2;
+  scaling->Translate(translation);
+
+  // a B-spline transform on a grid aligned with the output, and on a
+  // rotated grid
+  BSplineTransformType::Pointer bsplines[2];
+  BSplineTransformType::ParametersType parameters[2];
+  for ( unsigned int b = 0; b < 2; ++b )
+    {
+    bsplines[b] = BSplineTransformType::New();
+    BSplineTransformType::OriginType gridOrigin;
+    gridOrigin.Fill(-3.0);
+    BSplineTransformType::PhysicalDimensionsType dimensions;
+    dimensions[0] = 34.0;
+    dimensions[1] = 28.0;
+    dimensions[2] = 22.0;
+    BSplineTransformType::MeshSizeType meshSize;
+    meshSize[0] = 6;
+    meshSize[1] = 5;
+    meshSize[2] = 4;
+    BSplineTransformType::DirectionType direction;
+    direction.SetIdentity();
+    if ( b == 1 )
+      {
+      direction[0][0] = direction[1][1] = std::cos(0.2);
+      direction[0][1] = -std::sin(0.2);
+      direction[1][0] = std::sin(0.2);
+      }
+    bsplines[b]->SetTransformDomainOrigin(gridOrigin);
+    bsplines[b]->SetTransformDomainPhysicalDimensions(dimensions);
+    bsplines[b]->SetTransformDomainMeshSize(meshSize);
+    bsplines[b]->SetTransformDomainDirection(direction);
+    parameters[b].SetSize( bsplines[b]->GetNumberOfParameters() );
+    for ( unsigned int p = 0; p < parameters[b].GetSize(); ++p )
+      {
+      parameters[b][p] = generator->GetUniformVariate(-2.0, 2.0);
+      }
+    bsplines[b]->SetParameters(parameters[b]);
+    }
+
+  LinearInterpolatorType::Pointer          linear = LinearInterpolatorType::New();
+  NearestNeighborInterpolatorType::Pointer nearest = NearestNeighborInterpolatorType::New();
+  BSplineInterpolatorType::Pointer         bspline = BSplineInterpolatorType::New();
+  ShiftedLinearInterpolator::Pointer       shifted = ShiftedLinearInterpolator::New();
+
+  try
+    {
+    std::cout << "Affine transform, linear interpolation" << std::endl;
+    if ( CompareToPixelwiseResampling< InputImageType >(input, affine, linear, 1e-4) != EXIT_SUCCESS
+         || CompareToPixelwiseResampling< CharImageType >(input, affine, linear, 1.0) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Affine transform, subclass of the linear interpolator" << std::endl;
+    if ( CompareToPixelwiseResampling< InputImageType >(input, affine, shifted, 1e-4) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Affine transform, nearest neighbor interpolation" << std::endl;
+    if ( CompareToPixelwiseResampling< InputImageType >(input, affine, nearest, 0.0) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Affine transform, B-spline interpolation" << std::endl;
+    if ( CompareToPixelwiseResampling< InputImageType >(input, affine, bspline, 1e-4) != EXIT_SUCCESS
+         || CompareToPixelwiseResampling< CharImageType >(input, affine, bspline, 1.0) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Axis aligned affine transform, B-spline interpolation" << std::endl;
+    if ( CompareToPixelwiseResampling< InputImageType >(input, scaling, bspline, 1e-4) != EXIT_SUCCESS
+         || CompareToPixelwiseResampling< CharImageType >(input, scaling, bspline, 1.0) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    for ( unsigned int b = 0; b < 2; ++b )
+      {
+      std::cout << "B-spline transform " << b << ", linear interpolation" << std::endl;
+      if ( CompareToPixelwiseResampling< InputImageType >(input, bsplines[b], linear, 1e-4) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      std::cout << "B-spline transform " << b << ", nearest neighbor interpolation" << std::endl;
+      if ( CompareToPixelwiseResampling< InputImageType >(input, bsplines[b], nearest, 0.0) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      std::cout << "B-spline transform " << b << ", B-spline interpolation" << std::endl;
+      if ( CompareToPixelwiseResampling< InputImageType >(input, bsplines[b], bspline, 1e-4) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -140,6 +140,7 @@ GrayscaleGrindPeakImageFilter< TInputImage, TOutputImage >
   dilate->SetMarkerImage(markerPtr);
   dilate->SetMaskImage( this->GetInput() );
   dilate->SetFullyConnected(m_FullyConnected);
+  dilate->SetNumberOfThreads( this->GetNumberOfThreads() );
 
   // graft our output to the dilate filter to force the proper regions
   // to be generated
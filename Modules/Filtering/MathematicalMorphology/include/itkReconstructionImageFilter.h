@@ -22,7 +22,9 @@
 #include "itkShapedNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include "itkBarrier.h"
 #include <queue>
+#include <vector>
 
 //#define BASIC
 #define COPY
@@ -43,6 +45,14 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * When the filter runs with several threads, the image is split in slabs
+ * along its last dimension. Each thread reconstructs its slab with the
+ * raster, antiraster and FIFO steps, then the values are propagated
+ * across the borders of the slabs with the FIFO step until they don't
+ * change anymore. The reconstruction is unique, so the output does not
+ * depend on the number of threads. The borders of the image are checked
+ * explicitly in this case, and UseInternalCopy is not used.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -151,6 +161,16 @@ protected:
 
   void GenerateData() ITK_OVERRIDE;
 
+  /** Reconstruct the image with several threads, one slab per thread. */
+  void ParallelGenerateData();
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ReconstructionThreaderCallback(void *arg);
+
+  /** Reconstruct a slab, then propagate the values across its borders
+   * until all the slabs are stable. */
+  void ThreadedReconstruction(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
   /**
    * the value of the border - used in boundary condition.
    */
@@ -175,6 +195,31 @@ private:
   typedef typename InputImageType::IndexType                InIndexType;
   typedef ConstShapedNeighborhoodIterator< InputImageType > CNInputIterator;
   typedef ShapedNeighborhoodIterator< OutputImageType >     NOutputIterator;
+
+  typedef typename OutputImageType::OffsetType OutOffsetType;
+  typedef typename OutputImageType::SizeType   OutSizeType;
+
+  /** Whether the neighbor at the given offset of a pixel is in the slices
+   * [firstSlice, lastSlice) of the output. The index is relative to the
+   * start of the output region. */
+  static bool IsInside(const OutIndexType & index, const OutOffsetType & offset,
+                       const OutSizeType & size,
+                       OffsetValueType firstSlice, OffsetValueType lastSlice);
+
+  // the neighbors, and their offsets in the buffer
+  std::vector< OutOffsetType >   m_NeighborOffsets;
+  std::vector< OffsetValueType > m_NeighborBufferOffsets;
+
+  // whether the marker is valid, and whether a slab changed, for each
+  // thread
+  std::vector< char > m_ValidMarker;
+  std::vector< char > m_SlabChanged;
+
+  // whether the reconstruction was aborted, for each thread. The threads
+  // stop together, after the barrier which ends each round.
+  std::vector< char > m_SlabAborted;
+
+  Barrier::Pointer m_Barrier;
 }; // end of class
 } // end namespace itk
 
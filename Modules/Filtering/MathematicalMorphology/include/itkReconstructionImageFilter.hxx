@@ -24,6 +24,7 @@
 
 #include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -104,6 +105,18 @@ void
 ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 ::GenerateData()
 {
+  // the slabs are read directly in the buffers of the images, which must
+  // cover the same region
+  const OutputImageRegionType region = this->GetOutput()->GetRequestedRegion();
+  if ( this->GetNumberOfThreads() > 1
+       && region.GetSize()[OutputImageDimension - 1] > 1
+       && this->GetMarkerImage()->GetBufferedRegion() == region
+       && this->GetMaskImage()->GetBufferedRegion() == region )
+    {
+    this->ParallelGenerateData();
+    return;
+    }
+
   // Allocate the output
   this->AllocateOutputs();
   // there are 2 passes that use all pixels and a 3rd that uses some
@@ -387,6 +400,414 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     }
 }
 
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ParallelGenerateData()
+{
+  this->AllocateOutputs();
+
+  // mask and marker must have the same size
+  if ( this->GetMarkerImage()->GetRequestedRegion().GetSize() != this->GetMaskImage()->GetRequestedRegion().GetSize() )
+    {
+    itkExceptionMacro(<< "Marker and mask must have the same size.");
+    }
+
+  OutputImageType *output = this->GetOutput();
+
+  // the face or full connectivity
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  unsigned int numberOfNeighbors = 1;
+  for ( unsigned int d = 0; d < OutputImageDimension; d++ )
+    {
+    numberOfNeighbors *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighbors; n++ )
+    {
+    OutOffsetType offset;
+    unsigned int  code = n;
+    unsigned int  numberOfNonZero = 0;
+    for ( unsigned int d = 0; d < OutputImageDimension; d++ )
+      {
+      offset[d] = static_cast< OffsetValueType >( code % 3 ) - 1;
+      numberOfNonZero += ( offset[d] != 0 );
+      code /= 3;
+      }
+    if ( numberOfNonZero == 1 || ( m_FullyConnected && numberOfNonZero > 1 ) )
+      {
+      m_NeighborOffsets.push_back(offset);
+      m_NeighborBufferOffsets.push_back( output->ComputeOffset( output->GetBufferedRegion().GetIndex() + offset ) );
+      }
+    }
+
+  const SizeValueType numberOfSlices = output->GetRequestedRegion().GetSize()[OutputImageDimension - 1];
+  ThreadIdType        numberOfThreads = this->GetNumberOfThreads();
+  if ( numberOfSlices < numberOfThreads )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( numberOfSlices );
+    }
+  MultiThreader *multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads(numberOfThreads);
+  numberOfThreads = multiThreader->GetNumberOfThreads();
+
+  m_ValidMarker.assign(numberOfThreads, 1);
+  m_SlabChanged.assign(numberOfThreads, 0);
+  m_SlabAborted.assign(numberOfThreads, 0);
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize(numberOfThreads);
+
+  multiThreader->SetSingleMethod(this->ReconstructionThreaderCallback, this);
+  multiThreader->SingleMethodExecute();
+
+  const bool validMarker =
+    std::find( m_ValidMarker.begin(), m_ValidMarker.end(), 0 ) == m_ValidMarker.end();
+  const bool aborted =
+    std::find( m_SlabAborted.begin(), m_SlabAborted.end(), 1 ) != m_SlabAborted.end();
+
+  m_Barrier = ITK_NULLPTR;
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  m_ValidMarker.clear();
+  m_SlabChanged.clear();
+  m_SlabAborted.clear();
+
+  if ( aborted )
+    {
+    ProcessAborted e(__FILE__, __LINE__);
+    e.SetDescription("Object " + std::string( this->GetNameOfClass() ) + ": AbortGenerateDataOn");
+    throw e;
+    }
+
+  // be sure that the pixels in the images follow the preconditions
+  if ( !validMarker )
+    {
+    TCompare compare;
+    if ( compare(0, 1) )
+      {
+      itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+      }
+    else
+      {
+      itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+ITK_THREAD_RETURN_TYPE
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ReconstructionThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *filter = static_cast< Self * >( info->UserData );
+
+  filter->ThreadedReconstruction(info->ThreadID, info->NumberOfThreads);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+bool
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::IsInside(const OutIndexType & index, const OutOffsetType & offset,
+           const OutSizeType & size,
+           OffsetValueType firstSlice, OffsetValueType lastSlice)
+{
+  const unsigned int lastDimension = OutputImageDimension - 1;
+  for ( unsigned int d = 0; d < lastDimension; d++ )
+    {
+    const OffsetValueType i = index[d] + offset[d];
+    if ( i < 0 || i >= static_cast< OffsetValueType >( size[d] ) )
+      {
+      return false;
+      }
+    }
+  const OffsetValueType slice = index[lastDimension] + offset[lastDimension];
+  return slice >= firstSlice && slice < lastSlice;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedReconstruction(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  TCompare compare;
+
+  OutputImageType *          output = this->GetOutput();
+  const OutSizeType          size = output->GetRequestedRegion().GetSize();
+  const unsigned int         lastDimension = OutputImageDimension - 1;
+  const OffsetValueType      numberOfSlices = size[lastDimension];
+  const OffsetValueType      sliceSize = output->GetRequestedRegion().GetNumberOfPixels() / numberOfSlices;
+  const OffsetValueType      firstSlice = numberOfSlices * threadId / numberOfThreads;
+  const OffsetValueType      lastSlice = numberOfSlices * ( threadId + 1 ) / numberOfThreads;
+  const OffsetValueType      begin = firstSlice * sliceSize;
+  const OffsetValueType      end = lastSlice * sliceSize;
+  const size_t               numberOfNeighbors = m_NeighborOffsets.size();
+
+  OutputImagePixelType *       out = output->GetBufferPointer();
+  const MarkerImagePixelType * marker = this->GetMarkerImage()->GetBufferPointer();
+  const MaskImagePixelType *   mask = this->GetMaskImage()->GetBufferPointer();
+
+  // copy the marker, and check that it is below the mask
+  bool validMarker = true;
+  for ( OffsetValueType k = begin; k < end; k++ )
+    {
+    out[k] = static_cast< OutputImagePixelType >( marker[k] );
+    if ( compare( out[k], static_cast< OutputImagePixelType >( mask[k] ) ) )
+      {
+      validMarker = false;
+      }
+    }
+  m_ValidMarker[threadId] = validMarker;
+  m_Barrier->Wait();
+  if ( std::find( m_ValidMarker.begin(), m_ValidMarker.end(), 0 ) != m_ValidMarker.end() )
+    {
+    return;
+    }
+
+  // index of a position in the buffer, relative to the start of the region
+  OutIndexType index;
+
+  // the pixels of the slab are reported in the raster pass, the reverse
+  // raster pass and the first processing of the fifo, as in the sequential
+  // version. An abort is only thrown after all the threads have stopped.
+  ProgressReporter progress( this, threadId, ( end - begin ) * 3 );
+  bool             aborted = false;
+
+  typedef std::queue< OffsetValueType > FifoType;
+  FifoType fifo;
+
+  try
+    {
+    // scan in forward raster order, with the previous neighbours
+    index.Fill(0);
+    index[lastDimension] = firstSlice;
+    for ( OffsetValueType k = begin; k < end; k++ )
+      {
+      OutputImagePixelType V = out[k];
+      for ( size_t n = 0; n < numberOfNeighbors; n++ )
+        {
+        if ( m_NeighborBufferOffsets[n] < 0
+             && IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice) )
+          {
+          const OutputImagePixelType VN = out[k + m_NeighborBufferOffsets[n]];
+          if ( compare(VN, V) )
+            {
+            V = VN;
+            }
+          }
+        }
+      // this step clamps to the mask
+      const OutputImagePixelType iV = static_cast< OutputImagePixelType >( mask[k] );
+      out[k] = compare(V, iV) ? iV : V;
+      progress.CompletedPixel();
+
+      for ( unsigned int d = 0; d < lastDimension; d++ )
+        {
+        if ( ++index[d] < static_cast< OffsetValueType >( size[d] ) )
+          {
+          break;
+          }
+        index[d] = 0;
+        if ( d + 1 == lastDimension )
+          {
+          ++index[lastDimension];
+          }
+        }
+      if ( lastDimension == 0 )
+        {
+        ++index[0];
+        }
+      }
+
+    // now for the reverse raster order pass, with the later neighbours,
+    // which also puts in the fifo the pixels which can propagate their
+    // value
+    index.Fill(0);
+    index[lastDimension] = lastSlice;
+    for ( OffsetValueType k = end - 1; k >= begin; k-- )
+      {
+      for ( unsigned int d = 0; d <= lastDimension; d++ )
+        {
+        if ( d == lastDimension || index[d] > 0 )
+          {
+          --index[d];
+          break;
+          }
+        index[d] = size[d] - 1;
+        }
+
+      OutputImagePixelType V = out[k];
+      for ( size_t n = 0; n < numberOfNeighbors; n++ )
+        {
+        if ( m_NeighborBufferOffsets[n] > 0
+             && IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice) )
+          {
+          const OutputImagePixelType VN = out[k + m_NeighborBufferOffsets[n]];
+          if ( compare(VN, V) )
+            {
+            V = VN;
+            }
+          }
+        }
+      const OutputImagePixelType iV = static_cast< OutputImagePixelType >( mask[k] );
+      if ( compare(V, iV) )
+        {
+        V = iV;
+        }
+      out[k] = V;
+      progress.CompletedPixel();
+
+      for ( size_t n = 0; n < numberOfNeighbors; n++ )
+        {
+        if ( m_NeighborBufferOffsets[n] > 0
+             && IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice) )
+          {
+          const OffsetValueType      q = k + m_NeighborBufferOffsets[n];
+          const OutputImagePixelType VN = out[q];
+          const OutputImagePixelType iN = static_cast< OutputImagePixelType >( mask[q] );
+          if ( compare(V, VN) && compare(iN, VN) )
+            {
+            fifo.push(k);
+            break;
+            }
+          }
+        }
+      }
+    }
+  catch ( ProcessAborted & )
+    {
+    aborted = true;
+    fifo = FifoType();
+    }
+
+  // process the fifo, then the values propagated from the other slabs,
+  // until no slab changes
+  bool firstRound = true;
+  while ( true )
+    {
+    if ( !firstRound )
+      {
+      // the values of the borders of the neighbor slabs
+      std::vector< OffsetValueType >      updatedPixels;
+      std::vector< OutputImagePixelType > updatedValues;
+      const OffsetValueType borderSlices[2] = { firstSlice, lastSlice - 1 };
+      const unsigned int    numberOfBorderSlices = ( firstSlice == lastSlice - 1 ) ? 1 : 2;
+      for ( unsigned int b = 0; b < numberOfBorderSlices; b++ )
+        {
+        const OffsetValueType slice = borderSlices[b];
+        index.Fill(0);
+        index[lastDimension] = slice;
+        for ( OffsetValueType k = slice * sliceSize; k < ( slice + 1 ) * sliceSize; k++ )
+          {
+          OutputImagePixelType V = out[k];
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            const OffsetValueType neighborSlice = slice + m_NeighborOffsets[n][lastDimension];
+            if ( ( neighborSlice < firstSlice || neighborSlice >= lastSlice )
+                 && IsInside(index, m_NeighborOffsets[n], size, 0, numberOfSlices) )
+              {
+              const OutputImagePixelType VN = out[k + m_NeighborBufferOffsets[n]];
+              if ( compare(VN, V) )
+                {
+                V = VN;
+                }
+              }
+            }
+          const OutputImagePixelType iV = static_cast< OutputImagePixelType >( mask[k] );
+          if ( compare(V, iV) )
+            {
+            V = iV;
+            }
+          if ( compare(V, out[k]) )
+            {
+            updatedPixels.push_back(k);
+            updatedValues.push_back(V);
+            }
+
+          for ( unsigned int d = 0; d < lastDimension; d++ )
+            {
+            if ( ++index[d] < static_cast< OffsetValueType >( size[d] ) )
+              {
+              break;
+              }
+            index[d] = 0;
+            }
+          }
+        }
+
+      // wait for all the threads to read the borders before changing them
+      m_Barrier->Wait();
+
+      for ( size_t i = 0; i < updatedPixels.size(); i++ )
+        {
+        out[updatedPixels[i]] = updatedValues[i];
+        fifo.push(updatedPixels[i]);
+        }
+      m_SlabChanged[threadId] = !updatedPixels.empty();
+      }
+
+    // now process the fifo - this fill the parts that weren't dealt
+    // with by the raster and anti-raster passes
+    try
+      {
+      while ( !fifo.empty() )
+        {
+        const OffsetValueType k = fifo.front();
+        fifo.pop();
+        if ( firstRound )
+          {
+          progress.CompletedPixel();
+          }
+
+        OffsetValueType position = k;
+        for ( unsigned int d = 0; d < lastDimension; d++ )
+          {
+          index[d] = position % static_cast< OffsetValueType >( size[d] );
+          position /= static_cast< OffsetValueType >( size[d] );
+          }
+        index[lastDimension] = position;
+
+        const OutputImagePixelType V = out[k];
+        for ( size_t n = 0; n < numberOfNeighbors; n++ )
+          {
+          if ( IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice) )
+            {
+            const OffsetValueType      q = k + m_NeighborBufferOffsets[n];
+            const OutputImagePixelType VN = out[q];
+            const OutputImagePixelType iN = static_cast< OutputImagePixelType >( mask[q] );
+            // candidate for dilation via flooding
+            if ( compare(V, VN) && ( iN != VN ) )
+              {
+              // propagate the center value, clamped by the mask
+              out[q] = compare(iN, V) ? V : iN;
+              fifo.push(q);
+              }
+            }
+          }
+        }
+      }
+    catch ( ProcessAborted & )
+      {
+      aborted = true;
+      fifo = FifoType();
+      }
+
+    // all the slabs are stable when none of them changed after the
+    // first exchange of their borders
+    m_SlabAborted[threadId] = aborted;
+    m_Barrier->Wait();
+    if ( std::find( m_SlabAborted.begin(), m_SlabAborted.end(), 1 ) != m_SlabAborted.end()
+         || ( !firstRound
+              && std::find( m_SlabChanged.begin(), m_SlabChanged.end(), 1 ) == m_SlabChanged.end() ) )
+      {
+      break;
+      }
+    firstRound = false;
+    }
+}
+
 template< typename TInputImage, typename TOutputImage, typename TCompare >
 void
 ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
@@ -0,0 +1,199 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+
+#include "itkCommand.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+
+namespace
+{
+typedef unsigned char PixelType;
+
+template< typename TImage >
+bool SameImages(const TImage *image1, const TImage *image2)
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+void AbortOnProgress(itk::Object *object, const itk::EventObject &, void *)
+{
+  itk::ProcessObject *filter = dynamic_cast< itk::ProcessObject * >( object );
+  if( filter && filter->GetProgress() > 0.1 )
+    {
+    filter->AbortGenerateDataOn();
+    }
+}
+
+// Reconstruct a random mask from a marker made of a few seeds, so that
+// the values are propagated across many slabs, with several numbers of
+// threads, and compare the outputs to the one of the serial algorithm.
+template< typename TFilter >
+int ParallelTest(const typename TFilter::InputImageType::SizeType & size, bool dilation)
+{
+  typedef typename TFilter::InputImageType ImageType;
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(8642);
+
+  typename ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions(size);
+  mask->Allocate();
+  typename ImageType::Pointer marker = ImageType::New();
+  marker->SetRegions(size);
+  marker->Allocate();
+
+  const PixelType background = dilation ? 0 : 255;
+  itk::ImageRegionIterator< ImageType > mt( mask, mask->GetLargestPossibleRegion() );
+  itk::ImageRegionIterator< ImageType > kt( marker, marker->GetLargestPossibleRegion() );
+  for( ; !mt.IsAtEnd(); ++mt, ++kt )
+    {
+    const PixelType value = static_cast< PixelType >( generator->GetIntegerVariate(255) );
+    mt.Set(value);
+    kt.Set( generator->GetUniformVariate(0.0, 1.0) < 0.002 ? value : background );
+    }
+
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+    {
+    typename TFilter::Pointer serial = TFilter::New();
+    serial->SetMarkerImage(marker);
+    serial->SetMaskImage(mask);
+    serial->SetFullyConnected(fullyConnected != 0);
+    serial->SetNumberOfThreads(1);
+    serial->Update();
+
+    for( unsigned int numberOfThreads = 2; numberOfThreads <= 5; ++numberOfThreads )
+      {
+      typename TFilter::Pointer filter = TFilter::New();
+      filter->SetMarkerImage(marker);
+      filter->SetMaskImage(mask);
+      filter->SetFullyConnected(fullyConnected != 0);
+      filter->SetNumberOfThreads(numberOfThreads);
+      filter->Update();
+
+      std::cout << "Dimension " << ImageType::ImageDimension
+                << ", dilation " << dilation
+                << ", fully connected " << fullyConnected
+                << ", " << numberOfThreads << " threads" << std::endl;
+
+      if( !SameImages< ImageType >( filter->GetOutput(), serial->GetOutput() ) )
+        {
+        std::cerr << "The parallel reconstruction differs from the serial one" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // an abort must stop all the threads, and be thrown once they stopped
+  typename TFilter::Pointer aborted = TFilter::New();
+  aborted->SetMarkerImage(marker);
+  aborted->SetMaskImage(mask);
+  aborted->SetNumberOfThreads(3);
+  itk::CStyleCommand::Pointer abortCommand = itk::CStyleCommand::New();
+  abortCommand->SetCallback(AbortOnProgress);
+  aborted->AddObserver(itk::ProgressEvent(), abortCommand);
+  bool caughtAbort = false;
+  try
+    {
+    aborted->Update();
+    }
+  catch( itk::ProcessAborted & )
+    {
+    caughtAbort = true;
+    }
+  if( !caughtAbort )
+    {
+    std::cerr << "The parallel reconstruction was not aborted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a marker above the mask must be rejected
+  marker->FillBuffer( dilation ? 255 : 0 );
+  mask->FillBuffer(128);
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetMarkerImage(marker);
+  filter->SetMaskImage(mask);
+  filter->SetNumberOfThreads(3);
+  bool caught = false;
+  try
+    {
+    filter->Update();
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cout << "Expected exception: " << err.GetDescription() << std::endl;
+    caught = true;
+    }
+  if( !caught )
+    {
+    std::cerr << "An invalid marker did not throw" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkReconstructionImageFilterParallelTest(int, char* [])
+{
+  typedef itk::Image< PixelType, 2 >                                           Image2DType;
+  typedef itk::Image< PixelType, 3 >                                           Image3DType;
+  typedef itk::ReconstructionByDilationImageFilter< Image2DType, Image2DType > Dilation2DType;
+  typedef itk::ReconstructionByErosionImageFilter< Image2DType, Image2DType >  Erosion2DType;
+  typedef itk::ReconstructionByDilationImageFilter< Image3DType, Image3DType > Dilation3DType;
+  typedef itk::ReconstructionByErosionImageFilter< Image3DType, Image3DType >  Erosion3DType;
+
+  try
+    {
+    Image2DType::SizeType size2D;
+    size2D[0] = 71;
+    size2D[1] = 59;
+    Image3DType::SizeType size3D;
+    size3D[0] = 23;
+    size3D[1] = 19;
+    size3D[2] = 17;
+
+    if( ParallelTest< Dilation2DType >( size2D, true ) != EXIT_SUCCESS
+        || ParallelTest< Erosion2DType >( size2D, false ) != EXIT_SUCCESS
+        || ParallelTest< Dilation3DType >( size3D, true ) != EXIT_SUCCESS
+        || ParallelTest< Erosion3DType >( size3D, false ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -19,7 +19,7 @@
 #define itkDiscreteGaussianImageFilter_hxx
 
 #include "itkDiscreteGaussianImageFilter.h"
-#include "itkNeighborhoodOperatorImageFilter.h"
+#include "itkDirectionalNeighborhoodOperatorImageFilter.h"
 #include "itkGaussianOperator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressAccumulator.h"
@@ -164,16 +164,19 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
   // Middle filters convolves from real to real
   // Last filter convolves and changes type from real type to output type
   // Streaming filter forces the mini-pipeline to run in chunks
-
-
-  typedef NeighborhoodOperatorImageFilter< InputImageType,
-                                           RealOutputImageType, RealOutputPixelValueType > FirstFilterType;
-  typedef NeighborhoodOperatorImageFilter< RealOutputImageType,
-                                           RealOutputImageType, RealOutputPixelValueType > IntermediateFilterType;
-  typedef NeighborhoodOperatorImageFilter< RealOutputImageType,
-                                           OutputImageType, RealOutputPixelValueType > LastFilterType;
-  typedef NeighborhoodOperatorImageFilter< InputImageType,
-                                           OutputImageType, RealOutputPixelValueType > SingleFilterType;
+  //
+  // The operators are directional, so they are applied along the
+  // scanlines of the images
+
+
+  typedef DirectionalNeighborhoodOperatorImageFilter< InputImageType,
+                                                      RealOutputImageType, RealOutputPixelValueType > FirstFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< RealOutputImageType,
+                                                      RealOutputImageType, RealOutputPixelValueType > IntermediateFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< RealOutputImageType,
+                                                      OutputImageType, RealOutputPixelValueType > LastFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< InputImageType,
+                                                      OutputImageType, RealOutputPixelValueType > SingleFilterType;
 
   typedef StreamingImageFilter< OutputImageType, OutputImageType >
   StreamingFilterType;
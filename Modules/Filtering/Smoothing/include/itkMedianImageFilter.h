@@ -20,9 +20,27 @@
 
 #include "itkBoxImageFilter.h"
 #include "itkImage.h"
+#include "itkIsSame.h"
 
 namespace itk
 {
+/** \cond HIDE_META_PROGRAMMING */
+/** Pixel types of 8 and 16 bits whose median MedianImageFilter computes
+ * from a histogram of the neighborhood values. */
+template< typename TPixel >
+struct MedianImageFilterUsesHistogram : public FalseType {};
+template<>
+struct MedianImageFilterUsesHistogram< char > : public TrueType {};
+template<>
+struct MedianImageFilterUsesHistogram< signed char > : public TrueType {};
+template<>
+struct MedianImageFilterUsesHistogram< unsigned char > : public TrueType {};
+template<>
+struct MedianImageFilterUsesHistogram< short > : public TrueType {};
+template<>
+struct MedianImageFilterUsesHistogram< unsigned short > : public TrueType {};
+/** \endcond */
+
 /** \class MedianImageFilter
  * \brief Applies a median filter to an image
  *
@@ -35,6 +53,13 @@ namespace itk
  * This filter requires that the input pixel type provides an operator<()
  * (LessThan Comparable).
  *
+ * For 8 and 16 bit integer input pixels, the neighborhood is kept in a
+ * histogram of its values while it slides along each line of the
+ * output, and only the pixels entering and leaving the neighborhood are
+ * visited for each output pixel, so that the cost grows with the size
+ * of a face of the neighborhood rather than with its volume. Other
+ * pixel types are sorted for each output pixel.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -115,6 +140,15 @@ protected:
 private:
   MedianImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);    //purposely not implemented
+
+  /** Compute the median of each neighborhood by sorting its pixels. */
+  void InternalThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId, const FalseType &);
+
+  /** Compute the median of each neighborhood from a histogram of its
+   * values, updated as the neighborhood slides along the lines. */
+  void InternalThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId, const TrueType &);
 };
 } // end namespace itk
 
@@ -22,6 +22,7 @@
 #include "itkConstNeighborhoodIterator.h"
 #include "itkNeighborhoodInnerProduct.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageLinearIteratorWithIndex.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
@@ -41,6 +42,16 @@ void
 MedianImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
+{
+  this->InternalThreadedGenerateData( outputRegionForThread, threadId,
+                                      MedianImageFilterUsesHistogram< InputPixelType >() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::InternalThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                               ThreadIdType threadId, const FalseType &)
 {
   // Allocate output
   typename OutputImageType::Pointer output = this->GetOutput();
@@ -94,6 +105,150 @@ MedianImageFilter< TInputImage, TOutputImage >
       }
     }
 }
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::InternalThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                               ThreadIdType threadId, const TrueType &)
+{
+  typename OutputImageType::Pointer output = this->GetOutput();
+  typename  InputImageType::ConstPointer input  = this->GetInput();
+
+  const InputSizeType radius = this->GetRadius();
+
+  // The pixels outside of the input buffer are those of the nearest
+  // border, as with the ZeroFluxNeumannBoundaryCondition.
+  const InputImageRegionType & bufferedRegion = input->GetBufferedRegion();
+  const OffsetValueType *      offsetTable = input->GetOffsetTable();
+  const InputPixelType *       inputBuffer = input->GetBufferPointer();
+  IndexValueType               lowerBound[InputImageDimension];
+  IndexValueType               upperBound[InputImageDimension];
+  for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+    lowerBound[d] = bufferedRegion.GetIndex(d);
+    upperBound[d] = lowerBound[d] + static_cast< IndexValueType >( bufferedRegion.GetSize(d) ) - 1;
+    }
+
+  // The histogram has a bin per value, and a coarser level of blocks
+  // of bins, so that the median is found by scanning a few blocks then
+  // the bins of one block.
+  const unsigned int bits = 8 * sizeof( InputPixelType );
+  const unsigned int blockBits = bits / 2;
+  const int          minimumValue = static_cast< int >( NumericTraits< InputPixelType >::NonpositiveMin() );
+  std::vector< SizeValueType > histogram(static_cast< size_t >( 1 ) << bits, 0);
+  std::vector< SizeValueType > blocks(static_cast< size_t >( 1 ) << ( bits - blockBits ), 0);
+
+  // The neighborhood is made of columns along the first dimension.
+  // faceOffsets holds the offsets of the pixels of a column, across
+  // the other dimensions, from the start of its line in the buffer.
+  SizeValueType numberOfPixelsInFace = 1;
+  for ( unsigned int d = 1; d < InputImageDimension; ++d )
+    {
+    numberOfPixelsInFace *= 2 * radius[d] + 1;
+    }
+  std::vector< OffsetValueType > faceOffsets(numberOfPixelsInFace);
+  const SizeValueType            medianPosition = numberOfPixelsInFace * ( 2 * radius[0] + 1 ) / 2;
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  ImageLinearIteratorWithIndex< OutputImageType > it(output, outputRegionForThread);
+  it.SetDirection(0);
+  for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+    {
+    const typename OutputImageType::IndexType lineIndex = it.GetIndex();
+
+    // offsets of the pixels of the columns of this line
+    IndexValueType faceIndex[InputImageDimension];
+    for ( unsigned int d = 1; d < InputImageDimension; ++d )
+      {
+      faceIndex[d] = -static_cast< IndexValueType >( radius[d] );
+      }
+    for ( SizeValueType j = 0; j < numberOfPixelsInFace; ++j )
+      {
+      OffsetValueType offset = 0;
+      for ( unsigned int d = 1; d < InputImageDimension; ++d )
+        {
+        const IndexValueType index = std::min( std::max( lineIndex[d] + faceIndex[d], lowerBound[d] ), upperBound[d] );
+        offset += ( index - lowerBound[d] ) * offsetTable[d];
+        }
+      faceOffsets[j] = offset;
+      for ( unsigned int d = 1; d < InputImageDimension; ++d )
+        {
+        if ( ++faceIndex[d] <= static_cast< IndexValueType >( radius[d] ) )
+          {
+          break;
+          }
+        faceIndex[d] = -static_cast< IndexValueType >( radius[d] );
+        }
+      }
+
+    // add or remove the column of the pixels at the index x
+    IndexValueType x = lineIndex[0] - static_cast< IndexValueType >( radius[0] );
+    const IndexValueType lastX = lineIndex[0] + static_cast< IndexValueType >( radius[0] );
+    for ( ; x <= lastX; ++x )
+      {
+      const InputPixelType *column =
+        inputBuffer + ( std::min( std::max( x, lowerBound[0] ), upperBound[0] ) - lowerBound[0] );
+      for ( SizeValueType j = 0; j < numberOfPixelsInFace; ++j )
+        {
+        const unsigned int bin = static_cast< unsigned int >( static_cast< int >( column[faceOffsets[j]] ) - minimumValue );
+        ++histogram[bin];
+        ++blocks[bin >> blockBits];
+        }
+      }
+
+    for ( ;; )
+      {
+      // find the median
+      SizeValueType count = 0;
+      unsigned int  block = 0;
+      while ( count + blocks[block] <= medianPosition )
+        {
+        count += blocks[block++];
+        }
+      unsigned int bin = block << blockBits;
+      while ( count + histogram[bin] <= medianPosition )
+        {
+        count += histogram[bin++];
+        }
+      it.Set( static_cast< OutputPixelType >( static_cast< InputPixelType >( static_cast< int >( bin ) + minimumValue ) ) );
+      progress.CompletedPixel();
+
+      ++it;
+      const bool atEndOfLine = it.IsAtEndOfLine();
+
+      // slide the neighborhood to the next pixel, or empty the histogram
+      // at the end of the line
+      const IndexValueType firstRemoved = x - 2 * static_cast< IndexValueType >( radius[0] ) - 1;
+      const IndexValueType lastRemoved = atEndOfLine ? x - 1 : firstRemoved;
+      for ( IndexValueType removed = firstRemoved; removed <= lastRemoved; ++removed )
+        {
+        const InputPixelType *column =
+          inputBuffer + ( std::min( std::max( removed, lowerBound[0] ), upperBound[0] ) - lowerBound[0] );
+        for ( SizeValueType j = 0; j < numberOfPixelsInFace; ++j )
+          {
+          const unsigned int removedBin = static_cast< unsigned int >( static_cast< int >( column[faceOffsets[j]] ) - minimumValue );
+          --histogram[removedBin];
+          --blocks[removedBin >> blockBits];
+          }
+        }
+      if ( atEndOfLine )
+        {
+        break;
+        }
+      const InputPixelType *column =
+        inputBuffer + ( std::min( std::max( x, lowerBound[0] ), upperBound[0] ) - lowerBound[0] );
+      for ( SizeValueType j = 0; j < numberOfPixelsInFace; ++j )
+        {
+        const unsigned int addedBin = static_cast< unsigned int >( static_cast< int >( column[faceOffsets[j]] ) - minimumValue );
+        ++histogram[addedBin];
+        ++blocks[addedBin >> blockBits];
+        }
+      ++x;
+      }
+    }
+}
 } // end namespace itk
 
 #endif
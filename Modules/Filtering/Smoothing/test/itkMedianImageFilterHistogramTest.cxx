@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMedianImageFilter.h"
+#include "itkRandomImageSource.h"
+#include "itkStreamingImageFilter.h"
+
+namespace
+{
+// Compare the output of the filter, computed from a histogram of the
+// neighborhood values, to the median of the sorted neighborhood, with
+// the pixels outside of the image replaced by those of its border.
+template< typename TImage >
+int MedianHistogramTest(const typename TImage::SizeType & size,
+                        const typename TImage::SizeType & radius,
+                        unsigned int numberOfStreamDivisions)
+{
+  typedef itk::RandomImageSource< TImage >            SourceType;
+  typedef itk::MedianImageFilter< TImage, TImage >    FilterType;
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamingFilterType;
+  typedef typename TImage::PixelType                  PixelType;
+  typedef typename TImage::IndexType                  IndexType;
+
+  typename TImage::SizeType    sourceSize = size;
+  typename SourceType::Pointer source = SourceType::New();
+  source->SetSize( sourceSize.m_Size );
+  source->SetMin( itk::NumericTraits< PixelType >::NonpositiveMin() );
+  source->SetMax( itk::NumericTraits< PixelType >::max() );
+  source->SetNumberOfThreads(1);
+  source->Update();
+  const TImage *input = source->GetOutput();
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetRadius(radius);
+  filter->SetNumberOfThreads(3);
+
+  typename StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( filter->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streamer->Update();
+  const TImage *output = streamer->GetOutput();
+
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+  std::vector< PixelType >          pixels;
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( output, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    pixels.clear();
+    IndexType offset;
+    for( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+      {
+      offset[d] = -static_cast< itk::IndexValueType >( radius[d] );
+      }
+    bool atEnd = false;
+    while( !atEnd )
+      {
+      IndexType index;
+      for( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+        {
+        index[d] = std::min( std::max( it.GetIndex()[d] + offset[d], region.GetIndex(d) ),
+                             region.GetIndex(d) + static_cast< itk::IndexValueType >( region.GetSize(d) ) - 1 );
+        }
+      pixels.push_back( input->GetPixel(index) );
+
+      atEnd = true;
+      for( unsigned int d = 0; d < TImage::ImageDimension && atEnd; ++d )
+        {
+        if( ++offset[d] <= static_cast< itk::IndexValueType >( radius[d] ) )
+          {
+          atEnd = false;
+          }
+        else
+          {
+          offset[d] = -static_cast< itk::IndexValueType >( radius[d] );
+          }
+        }
+      }
+    std::nth_element( pixels.begin(), pixels.begin() + pixels.size() / 2, pixels.end() );
+    if( it.Get() != pixels[pixels.size() / 2] )
+      {
+      std::cerr << "The median at " << it.GetIndex() << " with a radius of " << radius << " is "
+                << static_cast< double >( it.Get() ) << " instead of "
+                << static_cast< double >( pixels[pixels.size() / 2] ) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMedianImageFilterHistogramTest(int, char* [] )
+{
+  typedef itk::Image< unsigned char, 2 > UCharImageType;
+  typedef itk::Image< signed char, 2 >   CharImageType;
+  typedef itk::Image< short, 3 >         ShortImageType;
+
+  UCharImageType::SizeType size2D;
+  size2D[0] = 37;
+  size2D[1] = 29;
+  UCharImageType::SizeType radius2D;
+  radius2D[0] = 4;
+  radius2D[1] = 2;
+  if( MedianHistogramTest< UCharImageType >( size2D, radius2D, 1 ) != EXIT_SUCCESS
+      || MedianHistogramTest< CharImageType >( size2D, radius2D, 3 ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // a radius larger than the image
+  radius2D[0] = 20;
+  radius2D[1] = 0;
+  if( MedianHistogramTest< UCharImageType >( size2D, radius2D, 2 ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  ShortImageType::SizeType size3D;
+  size3D[0] = 19;
+  size3D[1] = 14;
+  size3D[2] = 11;
+  ShortImageType::SizeType radius3D;
+  radius3D[0] = 2;
+  radius3D[1] = 1;
+  radius3D[2] = 3;
+  if( MedianHistogramTest< ShortImageType >( size3D, radius3D, 1 ) != EXIT_SUCCESS
+      || MedianHistogramTest< ShortImageType >( size3D, radius3D, 4 ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkExceptionCopy_h
+#define itkExceptionCopy_h
+#include "ITKIOImageBaseExport.h"
+
+#include "itkMacro.h"
+
+namespace itk
+{
+/** \class ExceptionCopy
+ * \brief Copy of an exception caught on one thread, to be rethrown on
+ * another with its own type.
+ *
+ * The classes that read or write images on background threads catch
+ * the exceptions as an ExceptionObject, and rethrow them on the calling
+ * thread. The copy keeps the type of the exception when it is one of
+ * the exception types ITK throws while reading or writing images:
+ * ImageFileReaderException, ImageFileWriterException, ProcessAborted,
+ * MemoryAllocationError, RangeError, InvalidArgumentError,
+ * IncompatibleOperandsError, DataObjectError and
+ * InvalidRequestedRegionError. Any other type, such as an exception
+ * class defined by a third-party ImageIO, is copied, and rethrown, as
+ * an ExceptionObject.
+ *
+ * \sa ImageSeriesReader
+ * \sa ImageFileReaderQueue
+ * \sa ImageFileWriterQueue
+ * \ingroup ITKIOImageBase
+ */
+class ITKIOImageBase_EXPORT ExceptionCopy
+{
+public:
+  ExceptionCopy();
+  ExceptionCopy(const ExceptionCopy & other);
+  ~ExceptionCopy();
+  ExceptionCopy & operator=(const ExceptionCopy & other);
+
+  /** Copy the exception, replacing the previous copy if any. */
+  void Store(const ExceptionObject & e);
+
+  /** Delete the copy. */
+  void Clear();
+
+  /** Whether an exception is stored. */
+  bool IsEmpty() const
+  {
+    return m_Exception == ITK_NULLPTR;
+  }
+
+  /** Throw the stored exception with its own type. Does nothing when
+   * no exception is stored. */
+  void Throw() const;
+
+private:
+  typedef ExceptionObject * ( *CopyFunction )(const ExceptionObject &);
+  typedef void ( *ThrowFunction )(const ExceptionObject &);
+
+  template< typename TException >
+  bool StoreExceptionOfType(const ExceptionObject & e);
+
+  ExceptionObject *m_Exception;
+  CopyFunction     m_Copy;
+  ThrowFunction    m_Throw;
+};
+} // end namespace itk
+
+#endif // itkExceptionCopy_h
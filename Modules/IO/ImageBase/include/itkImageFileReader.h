@@ -154,6 +154,18 @@ public:
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
 
+  /** Set/Get whether the pixels may be mapped from the file into memory
+   * instead of being read into an allocated buffer. The pixels are
+   * mapped when the ImageIO reports that they are stored as is in a file
+   * (see ImageIOBase::GetPixelDataFileLocation()) with the pixel type of
+   * the output, at an offset aligned for that type, and are read
+   * otherwise. A mapped output only occupies
+   * memory for the pages that are accessed, which the system may drop
+   * and read again from the file. Off by default. */
+  itkSetMacro(UseMemoryMapping, bool);
+  itkGetConstMacro(UseMemoryMapping, bool);
+  itkBooleanMacro(UseMemoryMapping);
+
 protected:
   ImageFileReader();
   ~ImageFileReader();
@@ -172,6 +184,10 @@ protected:
   /** Does the real work. */
   virtual void GenerateData() ITK_OVERRIDE;
 
+  /** Map the pixels of the file into the output, in place of allocating
+   * it and reading them. Returns false if they cannot be mapped. */
+  bool MapOutputFromFile();
+
   ImageIOBase::Pointer m_ImageIO;
 
   bool m_UserSpecifiedImageIO; // keep track whether the
@@ -179,6 +195,8 @@ protected:
 
   bool m_UseStreaming;
 
+  bool m_UseMemoryMapping;
+
 private:
   ImageFileReader(const Self &); //purposely not implemented
   void operator=(const Self &);  //purposely not implemented
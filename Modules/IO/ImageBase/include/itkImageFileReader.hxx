@@ -24,6 +24,7 @@
 #include "itkConvertPixelBuffer.h"
 #include "itkPixelTraits.h"
 #include "itkVectorImage.h"
+#include "itkMemoryMappedImportImageContainer.h"
 
 #include "itksys/SystemTools.hxx"
 #include <fstream>
@@ -38,6 +39,7 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   this->SetFileName("");
   m_UserSpecifiedImageIO = false;
   m_UseStreaming = true;
+  m_UseMemoryMapping = false;
 }
 
 template< typename TOutputImage, typename ConvertPixelTraits >
@@ -55,6 +57,7 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   os << indent << "UserSpecifiedImageIO flag: " << m_UserSpecifiedImageIO << "\n";
   os << indent << "m_UseStreaming: " << m_UseStreaming << "\n";
+  os << indent << "UseMemoryMapping: " << m_UseMemoryMapping << "\n";
 }
 
 template< typename TOutputImage, typename ConvertPixelTraits >
@@ -353,13 +356,6 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 {
   typename TOutputImage::Pointer output = this->GetOutput();
 
-  itkDebugMacro (<< "ImageFileReader::GenerateData() \n"
-                 << "Allocating the buffer with the EnlargedRequestedRegion \n"
-                 << output->GetRequestedRegion() << "\n");
-
-  // allocated the output image to the size of the enlarge requested region
-  this->AllocateOutputs();
-
   // Test if the file exists and if it can be opened.
   // An exception will be thrown otherwise, since we can't
   // successfully read the file. We catch the exception because some
@@ -382,6 +378,18 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
   itkDebugMacro (<< "Setting imageIO IORegion to: " << m_ActualIORegion);
   m_ImageIO->SetIORegion(m_ActualIORegion);
 
+  if ( m_UseMemoryMapping && this->MapOutputFromFile() )
+    {
+    return;
+    }
+
+  itkDebugMacro (<< "ImageFileReader::GenerateData() \n"
+                 << "Allocating the buffer with the EnlargedRequestedRegion \n"
+                 << output->GetRequestedRegion() << "\n");
+
+  // allocated the output image to the size of the enlarge requested region
+  this->AllocateOutputs();
+
   char *loadBuffer = ITK_NULLPTR;
   // the size of the buffer is computed based on the actual number of
   // pixels to be read and the actual size of the pixels to be read
@@ -463,6 +471,61 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
   loadBuffer = ITK_NULLPTR;
 }
 
+template< typename TOutputImage, typename ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::MapOutputFromFile()
+{
+  typedef typename TOutputImage::PixelContainer PixelContainerType;
+  typedef MemoryMappedImportImageContainer< typename PixelContainerType::ElementIdentifier,
+                                            typename PixelContainerType::Element >
+    MappedPixelContainerType;
+
+  typename TOutputImage::Pointer output = this->GetOutput();
+  const ImageRegionType region = output->GetRequestedRegion();
+
+  // the pixels must be stored with the pixel type of the output, and
+  // the file must not have more dimensions than the output
+  const ImageIOBase::IOComponentType ioType =
+    ImageIOBase::MapPixelType< typename ConvertPixelTraits::ComponentType >::CType;
+  if ( m_ImageIO->GetComponentType() != ioType
+       || m_ImageIO->GetNumberOfComponents() != ConvertPixelTraits::GetNumberOfComponents()
+       || m_ActualIORegion.GetNumberOfPixels() != region.GetNumberOfPixels() )
+    {
+    return false;
+    }
+
+  const bool isVectorImage = strcmp(output->GetNameOfClass(), "VectorImage") == 0;
+  const SizeValueType numberOfElements =
+    region.GetNumberOfPixels() * ( isVectorImage ? output->GetNumberOfComponentsPerPixel() : 1 );
+  const SizeValueType numberOfBytes = m_ActualIORegion.GetNumberOfPixels()
+    * m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents();
+  if ( numberOfElements * sizeof( typename PixelContainerType::Element ) != numberOfBytes )
+    {
+    return false;
+    }
+
+  std::string           fileName;
+  ImageIOBase::SizeType offset = 0;
+  if ( !m_ImageIO->GetPixelDataFileLocation(fileName, offset) || offset < 0 )
+    {
+    return false;
+    }
+
+  typename MappedPixelContainerType::Pointer container = MappedPixelContainerType::New();
+  if ( !container->MapFile( fileName, static_cast< typename MappedPixelContainerType::OffsetType >( offset ),
+                            numberOfElements ) )
+    {
+    itkDebugMacro(<< "Could not map " << fileName << ", reading it instead.");
+    return false;
+    }
+
+  itkDebugMacro(<< "Mapped " << numberOfBytes << " bytes of " << fileName << " from " << offset);
+  output->SetBufferedRegion(region);
+  output->SetPixelContainer(container);
+  return true;
+}
+
 template< typename TOutputImage, typename ConvertPixelTraits >
 void
 ImageFileReader< TOutputImage, ConvertPixelTraits >
@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageFileReaderQueue_h
+#define itkImageFileReaderQueue_h
+#include "ITKIOImageBaseExport.h"
+
+#include <string>
+#include <vector>
+#include "itkConditionVariable.h"
+#include "itkExceptionCopy.h"
+#include "itkImageFileReader.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
+
+namespace itk
+{
+/** \class ImageFileReaderQueue
+ * \brief Reads a list of image files ahead of their use, on background threads.
+ *
+ * The images of the files are returned one at a time, in the order of
+ * the file names, by GetNextImage(). Meanwhile, up to
+ * NumberOfPrefetchedImages files following the last returned image are
+ * read by NumberOfReaderThreads background threads, so that reading the
+ * next images overlaps the processing of the current one:
+ *
+ * \code
+ * queue->SetFileNames(inputFileNames);
+ * while ( !queue->IsAtEnd() )
+ *   {
+ *   filter->SetInput( queue->GetNextImage() );
+ *   ...
+ *   }
+ * \endcode
+ *
+ * Each file is read by an ImageFileReader, with the ImageIO created by
+ * the factory mechanism, and its image is returned disconnected from
+ * the pipeline. When a file cannot be read, GetNextImage() throws the
+ * exception of the reader when that file is reached, with the type
+ * kept by ExceptionCopy.
+ *
+ * \sa ImageFileReader
+ * \sa ImageFileWriterQueue
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+template< typename TOutputImage >
+class ITKIOImageBase_HIDDEN ImageFileReaderQueue:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageFileReaderQueue       Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageFileReaderQueue, Object);
+
+  typedef TOutputImage                      OutputImageType;
+  typedef typename OutputImageType::Pointer OutputImagePointer;
+  typedef std::vector< std::string >        FileNamesContainer;
+
+  /** Set the files to read, in the order in which their images are
+   * returned. The images read from the previous files and not yet
+   * returned are discarded. */
+  void SetFileNames(const FileNamesContainer & fileNames);
+  const FileNamesContainer & GetFileNames() const
+  {
+    return m_FileNames;
+  }
+
+  /** Set/Get the maximum number of files read ahead of the last image
+   * returned by GetNextImage(). This bounds the memory held by the
+   * images waiting to be used. Defaults to 2. */
+  itkSetClampMacro(NumberOfPrefetchedImages, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfPrefetchedImages, unsigned int);
+
+  /** Set/Get the number of background threads reading the files.
+   * Defaults to 1. */
+  itkSetClampMacro(NumberOfReaderThreads, ThreadIdType, 1, ITK_MAX_THREADS);
+  itkGetConstMacro(NumberOfReaderThreads, ThreadIdType);
+
+  /** Start reading the files in the background. This is called by the
+   * first GetNextImage(), but may be called earlier to begin reading
+   * while the processing is set up. */
+  void Start();
+
+  /** Stop the background threads once the files being read are done,
+   * and discard the images not yet returned. GetNextImage() then starts
+   * again from the first file. */
+  void Stop();
+
+  /** Return true when the images of all the files have been returned. */
+  bool IsAtEnd() const
+  {
+    return m_NextImage >= m_FileNames.size();
+  }
+
+  /** Return the image of the next file, waiting for it to be read.
+   * Throws the exception raised while reading the file, if any. */
+  OutputImagePointer GetNextImage();
+
+protected:
+  ImageFileReaderQueue();
+  ~ImageFileReaderQueue();
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  ImageFileReaderQueue(const Self &); //purposely not implemented
+  void operator=(const Self &);       //purposely not implemented
+
+  typedef ImageFileReader< OutputImageType > ReaderType;
+
+  /** Static function used as the body of the background threads. */
+  static ITK_THREAD_RETURN_TYPE ReaderThreadCallback(void *arg);
+
+  /** Read the files one at a time until all of them have been taken
+   * or the queue is stopped. */
+  void ReadFiles();
+
+  FileNamesContainer m_FileNames;
+  unsigned int       m_NumberOfPrefetchedImages;
+  ThreadIdType       m_NumberOfReaderThreads;
+
+  bool                        m_Started;
+  MultiThreader::Pointer      m_Threader;
+  std::vector< ThreadIdType > m_ThreadIds;
+
+  /** The state below is shared with the background threads, and
+   * guarded by m_Lock. */
+  SimpleMutexLock                   m_Lock;
+  ConditionVariable::Pointer        m_Condition;
+  bool                              m_Stopping;
+  size_t                            m_NextFileToRead;
+  size_t                            m_NextImage;
+  std::vector< OutputImagePointer > m_Images;
+  std::vector< ExceptionCopy >      m_Exceptions; // empty when read
+  std::vector< char >               m_Read;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageFileReaderQueue.hxx"
+#endif
+
+#ifdef ITK_IO_FACTORY_REGISTER_MANAGER
+#include "itkImageIOFactoryRegisterManager.h"
+#endif
+
+#endif // itkImageFileReaderQueue_h
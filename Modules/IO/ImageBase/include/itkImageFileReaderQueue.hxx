@@ -0,0 +1,224 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageFileReaderQueue_hxx
+#define itkImageFileReaderQueue_hxx
+
+#include "itkImageFileReaderQueue.h"
+
+namespace itk
+{
+template< typename TOutputImage >
+ImageFileReaderQueue< TOutputImage >
+::ImageFileReaderQueue() :
+  m_NumberOfPrefetchedImages(2),
+  m_NumberOfReaderThreads(1),
+  m_Started(false),
+  m_Threader( MultiThreader::New() ),
+  m_Condition( ConditionVariable::New() ),
+  m_Stopping(false),
+  m_NextFileToRead(0),
+  m_NextImage(0)
+{
+}
+
+template< typename TOutputImage >
+ImageFileReaderQueue< TOutputImage >
+::~ImageFileReaderQueue()
+{
+  this->Stop();
+}
+
+template< typename TOutputImage >
+void
+ImageFileReaderQueue< TOutputImage >
+::SetFileNames(const FileNamesContainer & fileNames)
+{
+  this->Stop();
+  m_FileNames = fileNames;
+  this->Modified();
+}
+
+template< typename TOutputImage >
+void
+ImageFileReaderQueue< TOutputImage >
+::Start()
+{
+  if ( m_Started )
+    {
+    return;
+    }
+
+  m_Stopping = false;
+  m_NextFileToRead = 0;
+  m_NextImage = 0;
+  m_Images.assign( m_FileNames.size(), ITK_NULLPTR );
+  m_Exceptions.assign( m_FileNames.size(), ExceptionCopy() );
+  m_Read.assign( m_FileNames.size(), 0 );
+
+  const size_t numberOfThreads = std::min( static_cast< size_t >( m_NumberOfReaderThreads ), m_FileNames.size() );
+  for ( size_t t = 0; t < numberOfThreads; ++t )
+    {
+    m_ThreadIds.push_back( m_Threader->SpawnThread(this->ReaderThreadCallback, this) );
+    }
+  m_Started = true;
+}
+
+template< typename TOutputImage >
+void
+ImageFileReaderQueue< TOutputImage >
+::Stop()
+{
+  if ( !m_Started )
+    {
+    return;
+    }
+
+  m_Lock.Lock();
+  m_Stopping = true;
+  m_Condition->Broadcast();
+  m_Lock.Unlock();
+
+  for ( size_t t = 0; t < m_ThreadIds.size(); ++t )
+    {
+    m_Threader->TerminateThread(m_ThreadIds[t]);
+    }
+  m_ThreadIds.clear();
+
+  m_Images.clear();
+  m_Exceptions.clear();
+  m_Read.clear();
+  m_NextFileToRead = 0;
+  m_NextImage = 0;
+  m_Started = false;
+}
+
+template< typename TOutputImage >
+typename ImageFileReaderQueue< TOutputImage >::OutputImagePointer
+ImageFileReaderQueue< TOutputImage >
+::GetNextImage()
+{
+  if ( this->IsAtEnd() )
+    {
+    itkExceptionMacro(<< "The images of all the " << m_FileNames.size() << " files have been returned.");
+    }
+  this->Start();
+
+  m_Lock.Lock();
+  const size_t i = m_NextImage;
+  while ( !m_Read[i] )
+    {
+    m_Condition->Wait(&m_Lock);
+    }
+  OutputImagePointer image = m_Images[i];
+  m_Images[i] = ITK_NULLPTR;
+  const ExceptionCopy exception = m_Exceptions[i];
+  m_Exceptions[i].Clear();
+
+  // make room for the next file to read
+  ++m_NextImage;
+  m_Condition->Broadcast();
+  m_Lock.Unlock();
+
+  exception.Throw();
+  return image;
+}
+
+template< typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+ImageFileReaderQueue< TOutputImage >
+::ReaderThreadCallback(void *arg)
+{
+  Self *queue = (Self *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  queue->ReadFiles();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TOutputImage >
+void
+ImageFileReaderQueue< TOutputImage >
+::ReadFiles()
+{
+  for (;; )
+    {
+    // wait until the next file is within the files to prefetch
+    m_Lock.Lock();
+    while ( !m_Stopping && m_NextFileToRead < m_FileNames.size()
+            && m_NextFileToRead >= m_NextImage + m_NumberOfPrefetchedImages )
+      {
+      m_Condition->Wait(&m_Lock);
+      }
+    if ( m_Stopping || m_NextFileToRead >= m_FileNames.size() )
+      {
+      m_Lock.Unlock();
+      break;
+      }
+    const size_t      i = m_NextFileToRead++;
+    const std::string fileName = m_FileNames[i];
+    m_Lock.Unlock();
+
+    OutputImagePointer image;
+    ExceptionCopy      exception;
+    try
+      {
+      typename ReaderType::Pointer reader = ReaderType::New();
+      reader->SetFileName(fileName);
+      reader->Update();
+      image = reader->GetOutput();
+      image->DisconnectPipeline();
+      }
+    catch ( ExceptionObject & e )
+      {
+      exception.Store(e);
+      }
+    catch ( std::exception & e )
+      {
+      exception.Store( ExceptionObject( __FILE__, __LINE__, e.what(), ITK_LOCATION ) );
+      }
+    catch ( ... )
+      {
+      // GetNextImage() would otherwise wait for this file forever
+      exception.Store( ExceptionObject( __FILE__, __LINE__, "Unknown exception while reading " + fileName,
+                                        ITK_LOCATION ) );
+      }
+
+    m_Lock.Lock();
+    m_Images[i] = image;
+    m_Exceptions[i] = exception;
+    m_Read[i] = 1;
+    m_Condition->Broadcast();
+    m_Lock.Unlock();
+    }
+}
+
+template< typename TOutputImage >
+void
+ImageFileReaderQueue< TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfFiles: " << m_FileNames.size() << std::endl;
+  os << indent << "NumberOfPrefetchedImages: " << m_NumberOfPrefetchedImages << std::endl;
+  os << indent << "NumberOfReaderThreads: " << m_NumberOfReaderThreads << std::endl;
+  os << indent << "Started: " << m_Started << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -32,6 +32,7 @@
 #include "itkDiffusionTensor3D.h"
 #include "itkMatrix.h"
 #include "itkImageAlgorithm.h"
+#include "itkTraceEventRecorder.h"
 #include <complex>
 
 namespace itk
@@ -303,12 +304,18 @@ ImageFileWriter< TInputImage >
    * Loop over the number of pieces, execute the upstream pipeline on each
    * piece, and copy the results into the output image.
    */
+  TraceEventRecorder::Scope filterTraceEvent( "filter", this->GetNameOfClass() );
+  filterTraceEvent.SetArgument( 0, "pieces", numDivisions );
+
   unsigned int piece;
 
   for ( piece = 0;
         piece < numDivisions && !this->GetAbortGenerateData();
         piece++ )
     {
+    TraceEventRecorder::Scope traceEvent( "stream", this->GetNameOfClass() );
+    traceEvent.SetArgument( 0, "piece", piece );
+
     // get the actual piece to write
     ImageIORegion streamIORegion = m_ImageIO->GetSplitRegionForWriting(piece, numDivisions,
                                                                        pasteIORegion, largestIORegion);
@@ -350,6 +357,7 @@ ImageFileWriter< TInputImage >
       }
 
     m_ImageIO->SetIORegion(streamIORegion);
+    traceEvent.SetArgument( 1, "pixels", streamRegion.GetNumberOfPixels() );
 
     // write the data
     this->GenerateData();
@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageFileWriterQueue_h
+#define itkImageFileWriterQueue_h
+#include "ITKIOImageBaseExport.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "itkConditionVariable.h"
+#include "itkExceptionCopy.h"
+#include "itkImageFileWriter.h"
+#include "itkMultiThreader.h"
+#include "itkMutexLock.h"
+
+namespace itk
+{
+/** \class ImageFileWriterQueue
+ * \brief Writes images to files on background threads.
+ *
+ * Write() queues an image and returns, while NumberOfWriterThreads
+ * background threads write the queued images with an ImageFileWriter,
+ * so that compressing and writing an image overlaps the processing of
+ * the next one. Write() waits only when NumberOfQueuedImages images are
+ * already waiting to be written. Flush() waits until all the queued
+ * images are written.
+ *
+ * The queue writes a shallow copy of the image, which shares its
+ * pixels, so the image itself may still be used, or queued again, while
+ * it is written. Its pixels are written as they are when a thread
+ * reaches them, so they must not be modified until then. The output of
+ * a filter must be disconnected from its pipeline with
+ * DisconnectPipeline() before it is queued, so that the filter updates
+ * a new output for the next image.
+ *
+ * When an image cannot be written, the exception of the writer is
+ * thrown by the next call to Write() or Flush(), with the type kept by
+ * ExceptionCopy. The queued images are written before the queue is
+ * destroyed.
+ *
+ * \sa ImageFileWriter
+ * \sa ImageFileReaderQueue
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+template< typename TInputImage >
+class ITKIOImageBase_HIDDEN ImageFileWriterQueue:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageFileWriterQueue       Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageFileWriterQueue, Object);
+
+  typedef TInputImage                           InputImageType;
+  typedef typename InputImageType::ConstPointer InputImageConstPointer;
+
+  /** Set/Get the maximum number of images waiting to be written before
+   * Write() waits. This bounds the memory held by the queued images.
+   * Defaults to 2. */
+  itkSetClampMacro(NumberOfQueuedImages, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfQueuedImages, unsigned int);
+
+  /** Set/Get the number of background threads writing the images.
+   * Defaults to 1. */
+  itkSetClampMacro(NumberOfWriterThreads, ThreadIdType, 1, ITK_MAX_THREADS);
+  itkGetConstMacro(NumberOfWriterThreads, ThreadIdType);
+
+  /** Set/Get whether the images are written compressed, as with
+   * ImageFileWriter::SetUseCompression(). Off by default. */
+  itkSetMacro(UseCompression, bool);
+  itkGetConstMacro(UseCompression, bool);
+  itkBooleanMacro(UseCompression);
+
+  /** Queue the image to be written in the file. */
+  void Write(const InputImageType *image, const std::string & fileName);
+
+  /** Wait until all the queued images are written. */
+  void Flush();
+
+protected:
+  ImageFileWriterQueue();
+  ~ImageFileWriterQueue();
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  ImageFileWriterQueue(const Self &); //purposely not implemented
+  void operator=(const Self &);       //purposely not implemented
+
+  typedef ImageFileWriter< InputImageType > WriterType;
+
+  /** An image waiting to be written. */
+  struct WriteRequest {
+    InputImageConstPointer Image;
+    std::string            FileName;
+    bool                   UseCompression;
+  };
+
+  /** Static function used as the body of the background threads. */
+  static ITK_THREAD_RETURN_TYPE WriterThreadCallback(void *arg);
+
+  /** Write the queued images until the queue is stopped and empty. */
+  void WriteImages();
+
+  /** Throw the exception of a failed write, if any. Called with
+   * m_Lock locked, which it unlocks before throwing. */
+  void ThrowWriteException();
+
+  unsigned int m_NumberOfQueuedImages;
+  ThreadIdType m_NumberOfWriterThreads;
+  bool         m_UseCompression;
+
+  MultiThreader::Pointer      m_Threader;
+  std::vector< ThreadIdType > m_ThreadIds;
+
+  /** The state below is shared with the background threads, and
+   * guarded by m_Lock. */
+  SimpleMutexLock            m_Lock;
+  ConditionVariable::Pointer m_Condition;
+  bool                       m_Stopping;
+  std::deque< WriteRequest > m_Requests;
+  unsigned int               m_NumberOfWritesInProgress;
+  ExceptionCopy              m_Exception; // of the first failed write
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageFileWriterQueue.hxx"
+#endif
+
+#ifdef ITK_IO_FACTORY_REGISTER_MANAGER
+#include "itkImageIOFactoryRegisterManager.h"
+#endif
+
+#endif // itkImageFileWriterQueue_h
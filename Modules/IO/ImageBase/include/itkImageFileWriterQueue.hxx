@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageFileWriterQueue_hxx
+#define itkImageFileWriterQueue_hxx
+
+#include "itkImageFileWriterQueue.h"
+
+namespace itk
+{
+template< typename TInputImage >
+ImageFileWriterQueue< TInputImage >
+::ImageFileWriterQueue() :
+  m_NumberOfQueuedImages(2),
+  m_NumberOfWriterThreads(1),
+  m_UseCompression(false),
+  m_Threader( MultiThreader::New() ),
+  m_Condition( ConditionVariable::New() ),
+  m_Stopping(false),
+  m_NumberOfWritesInProgress(0)
+{
+}
+
+template< typename TInputImage >
+ImageFileWriterQueue< TInputImage >
+::~ImageFileWriterQueue()
+{
+  // the threads write the queued images before they stop
+  m_Lock.Lock();
+  m_Stopping = true;
+  m_Condition->Broadcast();
+  m_Lock.Unlock();
+
+  for ( size_t t = 0; t < m_ThreadIds.size(); ++t )
+    {
+    m_Threader->TerminateThread(m_ThreadIds[t]);
+    }
+}
+
+template< typename TInputImage >
+void
+ImageFileWriterQueue< TInputImage >
+::Write(const InputImageType *image, const std::string & fileName)
+{
+  if ( image == ITK_NULLPTR )
+    {
+    itkExceptionMacro(<< "No image to write in " << fileName);
+    }
+  if ( image->GetSource() )
+    {
+    itkExceptionMacro(<< "The image to write in " << fileName
+                      << " is the output of a filter, which may modify it before it is written. "
+                      << "Call DisconnectPipeline() on the image before queuing it.");
+    }
+
+  if ( m_ThreadIds.empty() )
+    {
+    for ( ThreadIdType t = 0; t < m_NumberOfWriterThreads; ++t )
+      {
+      m_ThreadIds.push_back( m_Threader->SpawnThread(this->WriterThreadCallback, this) );
+      }
+    }
+
+  // the writer updates the requested region and the pipeline state of
+  // its input, so it is given a shallow copy of the image, which shares
+  // its pixels
+  typename InputImageType::Pointer copy = InputImageType::New();
+  copy->Graft(image);
+  copy->SetMetaDataDictionary( image->GetMetaDataDictionary() );
+
+  WriteRequest request;
+  request.Image = copy;
+  request.FileName = fileName;
+  request.UseCompression = m_UseCompression;
+
+  m_Lock.Lock();
+  while ( m_Exception.IsEmpty() && m_Requests.size() >= m_NumberOfQueuedImages )
+    {
+    m_Condition->Wait(&m_Lock);
+    }
+  this->ThrowWriteException();
+  m_Requests.push_back(request);
+  m_Condition->Broadcast();
+  m_Lock.Unlock();
+}
+
+template< typename TInputImage >
+void
+ImageFileWriterQueue< TInputImage >
+::Flush()
+{
+  m_Lock.Lock();
+  while ( !m_Requests.empty() || m_NumberOfWritesInProgress > 0 )
+    {
+    m_Condition->Wait(&m_Lock);
+    }
+  this->ThrowWriteException();
+  m_Lock.Unlock();
+}
+
+template< typename TInputImage >
+void
+ImageFileWriterQueue< TInputImage >
+::ThrowWriteException()
+{
+  if ( !m_Exception.IsEmpty() )
+    {
+    const ExceptionCopy exception = m_Exception;
+    m_Exception.Clear();
+    m_Lock.Unlock();
+    exception.Throw();
+    }
+}
+
+template< typename TInputImage >
+ITK_THREAD_RETURN_TYPE
+ImageFileWriterQueue< TInputImage >
+::WriterThreadCallback(void *arg)
+{
+  Self *queue = (Self *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  queue->WriteImages();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage >
+void
+ImageFileWriterQueue< TInputImage >
+::WriteImages()
+{
+  for (;; )
+    {
+    m_Lock.Lock();
+    while ( !m_Stopping && m_Requests.empty() )
+      {
+      m_Condition->Wait(&m_Lock);
+      }
+    if ( m_Requests.empty() )
+      {
+      m_Lock.Unlock();
+      break;
+      }
+    WriteRequest request = m_Requests.front();
+    m_Requests.pop_front();
+    ++m_NumberOfWritesInProgress;
+    // make room for the next image to queue
+    m_Condition->Broadcast();
+    m_Lock.Unlock();
+
+    ExceptionCopy exception;
+    try
+      {
+      typename WriterType::Pointer writer = WriterType::New();
+      writer->SetInput(request.Image);
+      writer->SetFileName(request.FileName);
+      writer->SetUseCompression(request.UseCompression);
+      writer->Update();
+      }
+    catch ( ExceptionObject & e )
+      {
+      exception.Store(e);
+      }
+    catch ( std::exception & e )
+      {
+      exception.Store( ExceptionObject( __FILE__, __LINE__, e.what(), ITK_LOCATION ) );
+      }
+    catch ( ... )
+      {
+      // Flush() would otherwise wait for this write forever
+      exception.Store( ExceptionObject( __FILE__, __LINE__, "Unknown exception while writing "
+                                        + request.FileName, ITK_LOCATION ) );
+      }
+
+    // release the copy while it is not shared with the caller anymore
+    request.Image = ITK_NULLPTR;
+
+    m_Lock.Lock();
+    if ( m_Exception.IsEmpty() )
+      {
+      m_Exception = exception;
+      }
+    --m_NumberOfWritesInProgress;
+    m_Condition->Broadcast();
+    m_Lock.Unlock();
+    }
+}
+
+template< typename TInputImage >
+void
+ImageFileWriterQueue< TInputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfQueuedImages: " << m_NumberOfQueuedImages << std::endl;
+  os << indent << "NumberOfWriterThreads: " << m_NumberOfWriterThreads << std::endl;
+  os << indent << "UseCompression: " << m_UseCompression << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -326,6 +326,19 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) = 0;
 
+  /** Determine whether the data that Read() would return for the
+   * current IORegion is stored as is in a single file: uncompressed,
+   * in the byte order of this machine, and contiguously. If so, set the
+   * name of that file and the position of the data in it, so that the
+   * data may be mapped into memory instead of being read. This method
+   * is called after ReadImageInformation() and SetIORegion(). The
+   * default implementation returns false. */
+  virtual bool GetPixelDataFileLocation(std::string & itkNotUsed(fileName),
+                                        SizeType & itkNotUsed(offset))
+  {
+    return false;
+  }
+
   /*-------- This part of the interfaces deals with writing data ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -24,6 +24,8 @@
 #include <string>
 #include "itkMetaDataDictionary.h"
 #include "itkImageFileReader.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkExceptionCopy.h"
 
 namespace itk
 {
@@ -35,6 +37,16 @@ namespace itk
  * the files, but the image data must have the same Size for all
  * dimensions.
  *
+ * The files are read concurrently by up to GetNumberOfThreads()
+ * threads, each reading its files directly into their slices of the
+ * output. Only the files of the slices in the requested region are
+ * read, and the MetaDataDictionaryArray remains in the order of the
+ * files. An ImageIO set with SetImageIO() holds the state of the file
+ * it reads, so the files are then read one at a time.
+ *
+ * An exception thrown while reading a file on another thread is
+ * rethrown with the type kept by ExceptionCopy.
+ *
  * \sa GDCMSeriesFileNames
  * \sa NumericSeriesFileNames
  * \ingroup IOFilters
@@ -117,7 +129,8 @@ public:
   /** Set/Get the ImageIO helper class. By default, the
    * ImageSeriesReader uses the factory mechanism of the
    * ImageFileReader to determine the file type. This method can be
-   * used to specify which IO to use. */
+   * used to specify which IO to use. The files are then read one at a
+   * time with this ImageIO, instead of concurrently. */
   itkSetObjectMacro(ImageIO, ImageIOBase);
   itkGetModifiableObjectMacro(ImageIO, ImageIOBase);
 
@@ -198,6 +211,34 @@ private:
 
   int ComputeMovingDimensionIndex(ReaderType *reader);
 
+  /** Internal structure shared by the threads reading the files. */
+  struct ReadFilesStruct {
+    Self *              Filter;
+    ImageRegionType     RequestedRegion;
+    ImageRegionType     SliceRegionToRequest;
+    SizeType            ValidSize;
+    bool                UpdateMetaDataDictionaryArray;
+    int                 NumberOfFiles;
+    int                 NextFile;
+    SizeValueType       NumberOfSlicesToRead;
+    SizeValueType       NumberOfSlicesRead;
+    DictionaryArrayType Dictionaries; // in the order of the files
+    ExceptionCopy       Exception; // copy of the first exception caught
+    SimpleFastMutexLock Lock;
+  };
+
+  /** Static function used as a "callback" by the MultiThreader. Each
+   * thread repeatedly takes the next file of the series and reads it. */
+  static ITK_THREAD_RETURN_TYPE ReadFilesThreaderCallback(void *arg);
+
+  /** Read the i-th file in the traversal order into its slice of the
+   * output, or only its information when the slice is outside of the
+   * requested region. Returns whether the slice was read. */
+  bool ReadFile(int i, ReadFilesStruct *str);
+
+  /** Delete the dictionaries read before an error. */
+  static void DeleteDictionaries(ReadFilesStruct & str);
+
   /** Modified time of the MetaDataDictionaryArray */
   TimeStamp m_MetaDataDictionaryArrayMTime;
 
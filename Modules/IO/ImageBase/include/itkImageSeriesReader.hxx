@@ -23,8 +23,8 @@
 #include "itkImageAlgorithm.h"
 #include "itkArray.h"
 #include "vnl/vnl_math.h"
-#include "itkProgressReporter.h"
 #include "itkMetaDataObject.h"
+#include "itkMutexLockHolder.h"
 
 namespace itk
 {
@@ -296,11 +296,6 @@ void ImageSeriesReader< TOutputImage >
   output->SetBufferedRegion(requestedRegion);
   output->Allocate();
 
-  // progress reported on a per slice basis
-  ProgressReporter progress(this, 0,
-                            requestedRegion.GetSize(TOutputImage::ImageDimension-1),
-                            100);
-
   // We utilize the modified time of the output information to
   // know when the meta array needs to be updated, when the output
   // information is updated so should the meta array.
@@ -310,147 +305,302 @@ void ImageSeriesReader< TOutputImage >
     this->m_OutputInformationMTime > this->m_MetaDataDictionaryArrayMTime
     && m_MetaDataDictionaryArrayUpdate;
 
-  typename  TOutputImage::InternalPixelType *outputBuffer = output->GetBufferPointer();
-  IndexType                           sliceStartIndex = requestedRegion.GetIndex();
-  const int                           numberOfFiles = static_cast< int >( m_FileNames.size() );
+  // The files are shared out to the threads one at a time. Each
+  // dictionary is kept at the position of its file, so that the array
+  // does not depend on the order in which the threads finish.
+  ReadFilesStruct str;
+  str.Filter = this;
+  str.RequestedRegion = requestedRegion;
+  str.SliceRegionToRequest = sliceRegionToRequest;
+  str.ValidSize = validSize;
+  str.UpdateMetaDataDictionaryArray = needToUpdateMetaDataDictionaryArray;
+  str.NumberOfFiles = static_cast< int >( m_FileNames.size() );
+  str.NextFile = 0;
+  str.NumberOfSlicesToRead = requestedRegion.GetSize(TOutputImage::ImageDimension-1);
+  str.NumberOfSlicesRead = 0;
+  str.Dictionaries.assign(m_FileNames.size(), ITK_NULLPTR);
+
+  // a user specified ImageIO cannot read several files at once
+  unsigned int numberOfThreads = 1;
+  if ( !m_ImageIO )
+    {
+    numberOfThreads = std::min( static_cast< unsigned int >( this->GetNumberOfThreads() ),
+                                static_cast< unsigned int >( m_FileNames.size() ) );
+    }
 
-  for ( int i = 0; i != numberOfFiles; ++i )
+  if ( numberOfThreads <= 1 )
+    {
+    // read the files on this thread, so that the exceptions are propagated
+    // with their own type
+    try
+      {
+      for ( int i = 0; i < str.NumberOfFiles && !this->GetAbortGenerateData(); i++ )
+        {
+        if ( this->ReadFile(i, &str) )
+          {
+          this->UpdateProgress( static_cast< float >( ++str.NumberOfSlicesRead )
+                                / static_cast< float >( str.NumberOfSlicesToRead ) );
+          }
+        }
+      }
+    catch ( ... )
+      {
+      DeleteDictionaries(str);
+      throw;
+      }
+    }
+  else
     {
-    if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+    this->GetMultiThreader()->SetSingleMethod(this->ReadFilesThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    if ( !str.Exception.IsEmpty() )
       {
-      sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
+      DeleteDictionaries(str);
+      // rethrow the exception of the worker thread
+      str.Exception.Throw();
       }
+    }
 
-    const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
-    const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
+  if ( this->GetAbortGenerateData() )
+    {
+    DeleteDictionaries(str);
+    ProcessAborted e(__FILE__, __LINE__);
+    e.SetDescription( "Object " + std::string( this->GetNameOfClass() ) + ": AbortGenerateDataOn" );
+    throw e;
+    }
 
-    // check if we need this slice
-    if ( !insideRequestedRegion && !needToUpdateMetaDataDictionaryArray )
+  // Move the dictionaries into the array in the order of the files
+  for ( unsigned int i = 0; i < str.Dictionaries.size(); i++ )
+    {
+    if ( str.Dictionaries[i] )
       {
-      continue;
+      m_MetaDataDictionaryArray.push_back(str.Dictionaries[i]);
       }
+    }
 
-    // configure reader
-    typename ReaderType::Pointer reader = ReaderType::New();
-    reader->SetFileName( m_FileNames[iFileName].c_str() );
+  // update the time if we modified the meta array
+  if ( needToUpdateMetaDataDictionaryArray )
+    {
+    m_MetaDataDictionaryArrayMTime.Modified();
+    }
+}
 
-    TOutputImage * readerOutput = reader->GetOutput();
+template< typename TOutputImage >
+void ImageSeriesReader< TOutputImage >
+::DeleteDictionaries(ReadFilesStruct & str)
+{
+  for ( unsigned int i = 0; i < str.Dictionaries.size(); i++ )
+    {
+    delete str.Dictionaries[i];
+    str.Dictionaries[i] = ITK_NULLPTR;
+    }
+}
 
-    if ( m_ImageIO )
+// Callback routine used by the threading library. Each thread takes
+// the files one at a time until all of them have been read, or until
+// a file could not be read.
+template< typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+ImageSeriesReader< TOutputImage >
+::ReadFilesThreaderCallback(void *arg)
+{
+  ReadFilesStruct *str =
+    (ReadFilesStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  for (;; )
+    {
+    int i;
       {
-      reader->SetImageIO(m_ImageIO);
+      MutexLockHolder< SimpleFastMutexLock > lock(str->Lock);
+      if ( !str->Exception.IsEmpty() || str->NextFile >= str->NumberOfFiles
+           || str->Filter->GetAbortGenerateData() )
+        {
+        break;
+        }
+      i = str->NextFile++;
       }
-    reader->SetUseStreaming(m_UseStreaming);
-    readerOutput->SetRequestedRegion(sliceRegionToRequest);
 
-    // update the data or info
-    if ( !insideRequestedRegion )
+    try
       {
-      reader->UpdateOutputInformation();
+      if ( str->Filter->ReadFile(i, str) )
+        {
+        // the thread that read the slice reports the progress, under the
+        // lock, so that it increases and the observers are not called
+        // concurrently
+        MutexLockHolder< SimpleFastMutexLock > lock(str->Lock);
+        str->Filter->UpdateProgress( static_cast< float >( ++str->NumberOfSlicesRead )
+                                     / static_cast< float >( str->NumberOfSlicesToRead ) );
+        }
       }
-    else
+    catch ( ExceptionObject & e )
       {
-      // read the meta data information
-      readerOutput->UpdateOutputInformation();
-
-      // propagate the requested region to determin what the region
-      // will actually be read
-      readerOutput->PropagateRequestedRegion();
-
-      // check that the size of each slice is the same
-      if ( readerOutput->GetLargestPossibleRegion().GetSize() != validSize )
+      MutexLockHolder< SimpleFastMutexLock > lock(str->Lock);
+      if ( str->Exception.IsEmpty() )
+        {
+        str->Exception.Store(e);
+        }
+      }
+    catch ( std::exception & e )
+      {
+      MutexLockHolder< SimpleFastMutexLock > lock(str->Lock);
+      if ( str->Exception.IsEmpty() )
+        {
+        str->Exception.Store( ExceptionObject( __FILE__, __LINE__, e.what(), ITK_LOCATION ) );
+        }
+      }
+    catch ( ... )
+      {
+      MutexLockHolder< SimpleFastMutexLock > lock(str->Lock);
+      if ( str->Exception.IsEmpty() )
         {
-        itkExceptionMacro( << "Size mismatch! The size of  "
-                           << m_FileNames[iFileName].c_str()
-                           << " is "
-                           << readerOutput->GetLargestPossibleRegion().GetSize()
-                           << " and does not match the required size "
-                           << validSize
-                           << " from file "
-                           << m_FileNames[m_ReverseOrder ? m_FileNames.size() - 1 : 0].c_str() );
+        str->Exception.Store( ExceptionObject( __FILE__, __LINE__,
+                                               "Unknown exception while reading a file of the series",
+                                               ITK_LOCATION ) );
         }
+      }
+    }
 
-      // get the size of the region to be read
-      SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-      if( readSize == sliceRegionToRequest.GetSize() )
-        {
-        // if the buffer of the ImageReader is going to match that of
-        // ourselves, then set the ImageReader's buffer to a section
-        // of ours
+template< typename TOutputImage >
+bool ImageSeriesReader< TOutputImage >
+::ReadFile(int i, ReadFilesStruct *str)
+{
+  TOutputImage *output = this->GetOutput();
 
-        const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
+  const ImageRegionType & requestedRegion = str->RequestedRegion;
+  const ImageRegionType & sliceRegionToRequest = str->SliceRegionToRequest;
+  const int               numberOfFiles = str->NumberOfFiles;
 
-        typedef typename TOutputImage::AccessorFunctorType AccessorFunctorType;
-        const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
+  IndexType sliceStartIndex = requestedRegion.GetIndex();
+  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    {
+    sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
+    }
 
+  const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
+  const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
 
-        const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
-          ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
+  // check if we need this slice
+  if ( !insideRequestedRegion && !str->UpdateMetaDataDictionaryArray )
+    {
+    return false;
+    }
 
-        const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
-        const bool       bufferDelete = false;
+  // configure reader
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( m_FileNames[iFileName].c_str() );
 
-        typename  TOutputImage::InternalPixelType * outputSliceBuffer = outputBuffer + numberOfPixelComponentsUpToSlice;
+  TOutputImage * readerOutput = reader->GetOutput();
 
-        if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
-          {
-          // if the input image type is a vector image then the number
-          // of components needs to be set for the size
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               numberOfPixelsInSlice*numberOfInternalComponentsPerPixel,
-                                                               bufferDelete );
-          }
-        else
-          {
-          // otherwise the actual number of pixels needs to be passed
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               numberOfPixelsInSlice,
-                                                               bufferDelete );
-          }
-        readerOutput->UpdateOutputData();
-        }
-      else
-        {
-        // the read region isn't going to match exactly what we need
-        // to update to buffer created by the reader, then copy
+  if ( m_ImageIO )
+    {
+    reader->SetImageIO(m_ImageIO);
+    }
+  reader->SetUseStreaming(m_UseStreaming);
+  readerOutput->SetRequestedRegion(sliceRegionToRequest);
 
-        reader->Update();
+  // update the data or info
+  if ( !insideRequestedRegion )
+    {
+    reader->UpdateOutputInformation();
+    }
+  else
+    {
+    // read the meta data information
+    readerOutput->UpdateOutputInformation();
 
-        // output of buffer copy
-        ImageRegionType outRegion = requestedRegion;
-        outRegion.SetIndex( sliceStartIndex );
+    // propagate the requested region to determin what the region
+    // will actually be read
+    readerOutput->PropagateRequestedRegion();
 
-        // set the moving dimension to a size of 1
-        if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
-          {
-          outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
-          }
+    // check that the size of each slice is the same
+    if ( readerOutput->GetLargestPossibleRegion().GetSize() != str->ValidSize )
+      {
+      itkExceptionMacro( << "Size mismatch! The size of  "
+                         << m_FileNames[iFileName].c_str()
+                         << " is "
+                         << readerOutput->GetLargestPossibleRegion().GetSize()
+                         << " and does not match the required size "
+                         << str->ValidSize
+                         << " from file "
+                         << m_FileNames[m_ReverseOrder ? m_FileNames.size() - 1 : 0].c_str() );
+      }
 
-        ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
+    // get the size of the region to be read
+    SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
 
-        }
+    if( readSize == sliceRegionToRequest.GetSize() )
+      {
+      // if the buffer of the ImageReader is going to match that of
+      // ourselves, then set the ImageReader's buffer to a section
+      // of ours
 
-      // report progress for read slices
-      progress.CompletedPixel();
+      const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
 
-     } // end !insidedRequestedRegion
+      typedef typename TOutputImage::AccessorFunctorType AccessorFunctorType;
+      const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
 
-    // Deep copy the MetaDataDictionary into the array
-    if ( reader->GetImageIO() &&  needToUpdateMetaDataDictionaryArray )
-      {
-      DictionaryRawPointer newDictionary = new DictionaryType;
-      *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
-      m_MetaDataDictionaryArray.push_back(newDictionary);
+
+      const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
+        ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
+
+      const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
+      const bool       bufferDelete = false;
+
+      typename  TOutputImage::InternalPixelType * outputSliceBuffer = output->GetBufferPointer() + numberOfPixelComponentsUpToSlice;
+
+      if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
+        {
+        // if the input image type is a vector image then the number
+        // of components needs to be set for the size
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             numberOfPixelsInSlice*numberOfInternalComponentsPerPixel,
+                                                             bufferDelete );
+        }
+      else
+        {
+        // otherwise the actual number of pixels needs to be passed
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             numberOfPixelsInSlice,
+                                                             bufferDelete );
+        }
+      readerOutput->UpdateOutputData();
       }
+    else
+      {
+      // the read region isn't going to match exactly what we need
+      // to update to buffer created by the reader, then copy
 
-    } // end per slice loop
+      reader->Update();
 
-  // update the time if we modified the meta array
-  if ( needToUpdateMetaDataDictionaryArray )
+      // output of buffer copy
+      ImageRegionType outRegion = requestedRegion;
+      outRegion.SetIndex( sliceStartIndex );
+
+      // set the moving dimension to a size of 1
+      if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+        {
+        outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
+        }
+
+      ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
+
+      }
+    } // end !insidedRequestedRegion
+
+  // Deep copy the MetaDataDictionary into the position of the file
+  if ( reader->GetImageIO() && str->UpdateMetaDataDictionaryArray )
     {
-    m_MetaDataDictionaryArrayMTime.Modified();
+    DictionaryRawPointer newDictionary = new DictionaryType;
+    *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
+    str->Dictionaries[i] = newDictionary;
     }
+
+  return insideRequestedRegion;
 }
 
 template< typename TOutputImage >
@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkExceptionCopy.h"
+#include "itkDataObject.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include <typeinfo>
+
+namespace itk
+{
+namespace
+{
+template< typename TException >
+ExceptionObject * CopyExceptionOfType(const ExceptionObject & e)
+{
+  return new TException( static_cast< const TException & >( e ) );
+}
+
+template< typename TException >
+void ThrowExceptionOfType(const ExceptionObject & e)
+{
+  throw static_cast< const TException & >( e );
+}
+}
+
+ExceptionCopy
+::ExceptionCopy() :
+  m_Exception(ITK_NULLPTR),
+  m_Copy(ITK_NULLPTR),
+  m_Throw(ITK_NULLPTR)
+{
+}
+
+ExceptionCopy
+::ExceptionCopy(const ExceptionCopy & other) :
+  m_Exception(ITK_NULLPTR),
+  m_Copy(other.m_Copy),
+  m_Throw(other.m_Throw)
+{
+  if ( other.m_Exception )
+    {
+    m_Exception = ( *m_Copy )( *other.m_Exception );
+    }
+}
+
+ExceptionCopy
+::~ExceptionCopy()
+{
+  delete m_Exception;
+}
+
+ExceptionCopy &
+ExceptionCopy
+::operator=(const ExceptionCopy & other)
+{
+  if ( this != &other )
+    {
+    this->Clear();
+    if ( other.m_Exception )
+      {
+      m_Exception = ( *other.m_Copy )( *other.m_Exception );
+      m_Copy = other.m_Copy;
+      m_Throw = other.m_Throw;
+      }
+    }
+  return *this;
+}
+
+template< typename TException >
+bool
+ExceptionCopy
+::StoreExceptionOfType(const ExceptionObject & e)
+{
+  if ( typeid( e ) != typeid( TException ) )
+    {
+    return false;
+    }
+  m_Copy = &CopyExceptionOfType< TException >;
+  m_Throw = &ThrowExceptionOfType< TException >;
+  m_Exception = ( *m_Copy )( e );
+  return true;
+}
+
+void
+ExceptionCopy
+::Store(const ExceptionObject & e)
+{
+  this->Clear();
+  if ( this->StoreExceptionOfType< ImageFileReaderException >(e)
+       || this->StoreExceptionOfType< ImageFileWriterException >(e)
+       || this->StoreExceptionOfType< ProcessAborted >(e)
+       || this->StoreExceptionOfType< MemoryAllocationError >(e)
+       || this->StoreExceptionOfType< RangeError >(e)
+       || this->StoreExceptionOfType< InvalidArgumentError >(e)
+       || this->StoreExceptionOfType< IncompatibleOperandsError >(e)
+       || this->StoreExceptionOfType< DataObjectError >(e)
+       || this->StoreExceptionOfType< InvalidRequestedRegionError >(e) )
+    {
+    return;
+    }
+  // an ExceptionObject, or another type, of which a copy is sliced
+  m_Copy = &CopyExceptionOfType< ExceptionObject >;
+  m_Throw = &ThrowExceptionOfType< ExceptionObject >;
+  m_Exception = ( *m_Copy )(e);
+}
+
+void
+ExceptionCopy
+::Clear()
+{
+  delete m_Exception;
+  m_Exception = ITK_NULLPTR;
+  m_Copy = ITK_NULLPTR;
+  m_Throw = ITK_NULLPTR;
+}
+
+void
+ExceptionCopy
+::Throw() const
+{
+  if ( m_Exception )
+    {
+    ( *m_Throw )( *m_Exception );
+    }
+}
+} // end namespace itk
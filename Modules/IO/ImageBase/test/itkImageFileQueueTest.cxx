@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <sstream>
+
+#include "itkImageFileReaderQueue.h"
+#include "itkImageFileWriterQueue.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkShiftScaleImageFilter.h"
+
+namespace
+{
+typedef short                                  PixelType;
+typedef itk::Image< PixelType, 3 >             ImageType;
+typedef itk::ImageFileReaderQueue< ImageType > ReaderQueueType;
+typedef itk::ImageFileWriterQueue< ImageType > WriterQueueType;
+
+const unsigned int NumberOfImages = 9;
+
+ImageType::Pointer MakeImage(unsigned int number)
+{
+  ImageType::RegionType region;
+  region.SetSize(0, 17);
+  region.SetSize(1, 13);
+  region.SetSize(2, 3 + number);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+    {
+    image->GetBufferPointer()[i] = static_cast< PixelType >( 100 * number + i % 89 );
+    }
+  return image;
+}
+
+bool SameImages(const ImageType *image1, const ImageType *image2, PixelType shift)
+{
+  if( image1->GetLargestPossibleRegion() != image2->GetLargestPossibleRegion() )
+    {
+    std::cerr << "The regions of the images differ" << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< ImageType > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() + shift != it2.Get() )
+      {
+      std::cerr << "The pixels of the images differ" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+std::string FileName(const std::string & directory, const std::string & prefix, unsigned int number)
+{
+  std::ostringstream fileName;
+  fileName << directory << "/itkImageFileQueueTest" << prefix << number << ".mha";
+  return fileName.str();
+}
+}
+
+int itkImageFileQueueTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  // write the inputs in the background
+  WriterQueueType::Pointer writerQueue = WriterQueueType::New();
+  writerQueue->SetNumberOfWriterThreads(2);
+  writerQueue->UseCompressionOn();
+  ReaderQueueType::FileNamesContainer inputFileNames;
+  for( unsigned int number = 0; number < NumberOfImages; ++number )
+    {
+    inputFileNames.push_back( FileName(directory, "Input", number) );
+    writerQueue->Write( MakeImage(number), inputFileNames.back() );
+    }
+  writerQueue->Flush();
+
+  // read, process and write the images, overlapping reading and writing
+  // with the processing
+  typedef itk::ShiftScaleImageFilter< ImageType, ImageType > FilterType;
+  ReaderQueueType::Pointer readerQueue = ReaderQueueType::New();
+  readerQueue->SetFileNames(inputFileNames);
+  readerQueue->SetNumberOfPrefetchedImages(3);
+  readerQueue->SetNumberOfReaderThreads(2);
+  for( unsigned int number = 0; !readerQueue->IsAtEnd(); ++number )
+    {
+    ImageType::Pointer input = readerQueue->GetNextImage();
+    if( !SameImages( MakeImage(number), input, 0 ) )
+      {
+      std::cerr << "Image " << number << " was not read back" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(input);
+    filter->SetShift(7);
+    filter->Update();
+    ImageType::Pointer output = filter->GetOutput();
+
+    // the output of a filter is not queued while connected to it
+    try
+      {
+      writerQueue->Write( output, FileName(directory, "Output", number) );
+      std::cerr << "An output connected to its filter was queued" << std::endl;
+      return EXIT_FAILURE;
+      }
+    catch( itk::ExceptionObject & )
+      {
+      }
+    output->DisconnectPipeline();
+    writerQueue->Write( output, FileName(directory, "Output", number) );
+    }
+  writerQueue->Flush();
+
+  ReaderQueueType::FileNamesContainer outputFileNames;
+  for( unsigned int number = 0; number < NumberOfImages; ++number )
+    {
+    outputFileNames.push_back( FileName(directory, "Output", number) );
+    }
+  readerQueue->SetFileNames(outputFileNames);
+  for( unsigned int number = 0; !readerQueue->IsAtEnd(); ++number )
+    {
+    if( !SameImages( MakeImage(number), readerQueue->GetNextImage(), 7 ) )
+      {
+      std::cerr << "Processed image " << number << " was not written" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a file that cannot be read is reported when its image is reached,
+  // with the type of the exception of the reader, and the following
+  // files are still read
+  ReaderQueueType::FileNamesContainer missingFileNames = inputFileNames;
+  missingFileNames[2] = directory + "/itkImageFileQueueTestMissing.mha";
+  readerQueue->SetFileNames(missingFileNames);
+  for( unsigned int number = 0; !readerQueue->IsAtEnd(); ++number )
+    {
+    try
+      {
+      ImageType::Pointer input = readerQueue->GetNextImage();
+      if( number == 2 || !SameImages( MakeImage(number), input, 0 ) )
+        {
+        std::cerr << "Image " << number << " was not expected" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    catch( itk::ImageFileReaderException & e )
+      {
+      if( number != 2 )
+        {
+        std::cerr << "Unexpected exception for image " << number << ": " << e << std::endl;
+        return EXIT_FAILURE;
+        }
+      std::cout << "Expected exception: " << e.GetDescription() << std::endl;
+      }
+    }
+
+  // stopping the queue before its end does not wait for the remaining files
+  readerQueue->SetFileNames(inputFileNames);
+  readerQueue->Start();
+  if( !SameImages( MakeImage(0), readerQueue->GetNextImage(), 0 ) )
+    {
+    return EXIT_FAILURE;
+    }
+  readerQueue->Stop();
+  if( !SameImages( MakeImage(0), readerQueue->GetNextImage(), 0 ) )
+    {
+    std::cerr << "The queue did not start again from its first file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // an image may be queued again while it is written, and is left as
+  // it was
+  ImageType::Pointer image = MakeImage(0);
+  ImageType::RegionType requestedRegion = image->GetLargestPossibleRegion();
+  requestedRegion.ShrinkByRadius(1);
+  image->SetRequestedRegion(requestedRegion);
+  writerQueue->Write( image, FileName(directory, "Copy", 0) );
+  writerQueue->Write( image, FileName(directory, "Copy", 1) );
+  writerQueue->Flush();
+  if( image->GetRequestedRegion() != requestedRegion || image->GetSource() )
+    {
+    std::cerr << "The queued image was modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+  ReaderQueueType::FileNamesContainer copyFileNames;
+  copyFileNames.push_back( FileName(directory, "Copy", 0) );
+  copyFileNames.push_back( FileName(directory, "Copy", 1) );
+  readerQueue->SetFileNames(copyFileNames);
+  while( !readerQueue->IsAtEnd() )
+    {
+    if( !SameImages( image, readerQueue->GetNextImage(), 0 ) )
+      {
+      std::cerr << "The copies of the image were not written" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a file that cannot be written is reported by the next call
+  writerQueue->Write( MakeImage(0), directory + "/missingDirectory/itkImageFileQueueTest.mha" );
+  try
+    {
+    writerQueue->Flush();
+    std::cerr << "The failed write was not reported" << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cout << "Expected exception: " << e.GetDescription() << std::endl;
+    }
+
+  // the exception of the writer keeps its type
+  writerQueue->Write( MakeImage(0), directory + "/itkImageFileQueueTest.unknownExtension" );
+  try
+    {
+    writerQueue->Flush();
+    std::cerr << "The failed write was not reported" << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( itk::ImageFileWriterException & e )
+    {
+    std::cout << "Expected exception: " << e.GetDescription() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <sstream>
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageSeriesReader.h"
+#include "itkMetaDataObject.h"
+#include "itkMetaImageIO.h"
+#include "itkStreamingImageFilter.h"
+
+namespace
+{
+typedef unsigned short                       PixelType;
+typedef itk::Image< PixelType, 2 >           SliceType;
+typedef itk::Image< PixelType, 3 >           VolumeType;
+typedef itk::ImageSeriesReader< VolumeType > ReaderType;
+
+const unsigned int NumberOfFiles = 17;
+
+PixelType PixelValue(const VolumeType::IndexType & index)
+{
+  return static_cast< PixelType >( 1000 * index[2] + 31 * index[1] + index[0] );
+}
+
+std::string FileKey(unsigned int file)
+{
+  std::ostringstream key;
+  key << "file" << file;
+  return key.str();
+}
+
+// Check the pixels of a volume read from the files, traversed in
+// reverse order or not.
+bool CheckVolume(const VolumeType *volume, bool reverseOrder)
+{
+  itk::ImageRegionConstIteratorWithIndex< VolumeType > it( volume, volume->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    VolumeType::IndexType fileIndex = it.GetIndex();
+    if( reverseOrder )
+      {
+      fileIndex[2] = NumberOfFiles - 1 - fileIndex[2];
+      }
+    if( it.Get() != PixelValue( fileIndex ) )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " was read as " << it.Get()
+                << " instead of " << PixelValue( fileIndex ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Check that the dictionaries are in the order of the traversal of the
+// files.
+bool CheckDictionaries(const ReaderType *reader, bool reverseOrder)
+{
+  const ReaderType::DictionaryArrayType & dictionaries = *reader->GetMetaDataDictionaryArray();
+  if( dictionaries.size() != NumberOfFiles )
+    {
+    std::cerr << dictionaries.size() << " dictionaries instead of " << NumberOfFiles << std::endl;
+    return false;
+    }
+  for( unsigned int i = 0; i < NumberOfFiles; ++i )
+    {
+    const unsigned int file = reverseOrder ? NumberOfFiles - 1 - i : i;
+    std::string        key;
+    if( !itk::ExposeMetaData< std::string >( *dictionaries[i], "SeriesFile", key ) || key != FileKey(file) )
+      {
+      std::cerr << "Dictionary " << i << " is of the file '" << key << "' instead of "
+                << FileKey(file) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageSeriesReaderParallelTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  // write the slices, each with a key naming its file
+  SliceType::RegionType sliceRegion;
+  sliceRegion.SetSize(0, 29);
+  sliceRegion.SetSize(1, 23);
+
+  ReaderType::FileNamesContainer fileNames;
+  for( unsigned int file = 0; file < NumberOfFiles; ++file )
+    {
+    SliceType::Pointer slice = SliceType::New();
+    slice->SetRegions(sliceRegion);
+    slice->Allocate();
+    itk::ImageRegionConstIteratorWithIndex< SliceType > it( slice, sliceRegion );
+    for( ; !it.IsAtEnd(); ++it )
+      {
+      VolumeType::IndexType index;
+      index[0] = it.GetIndex()[0];
+      index[1] = it.GetIndex()[1];
+      index[2] = file;
+      slice->SetPixel( it.GetIndex(), PixelValue(index) );
+      }
+    itk::EncapsulateMetaData< std::string >( slice->GetMetaDataDictionary(), "SeriesFile", FileKey(file) );
+
+    std::ostringstream fileName;
+    fileName << directory << "/itkImageSeriesReaderParallelTest" << file << ".mha";
+    fileNames.push_back( fileName.str() );
+
+    typedef itk::ImageFileWriter< SliceType > WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput(slice);
+    writer->SetImageIO( itk::MetaImageIO::New() );
+    writer->SetFileName( fileName.str() );
+    writer->Update();
+    }
+
+  // the files are read by several threads, in both orders
+  for( unsigned int reverseOrder = 0; reverseOrder < 2; ++reverseOrder )
+    {
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileNames(fileNames);
+    reader->SetReverseOrder( reverseOrder != 0 );
+    reader->SetNumberOfThreads(4);
+    reader->Update();
+    if( !CheckVolume( reader->GetOutput(), reverseOrder != 0 )
+        || !CheckDictionaries( reader, reverseOrder != 0 ) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a user specified ImageIO reads the files one at a time
+  ReaderType::Pointer ioReader = ReaderType::New();
+  ioReader->SetFileNames(fileNames);
+  ioReader->SetImageIO( itk::MetaImageIO::New() );
+  ioReader->SetNumberOfThreads(4);
+  ioReader->Update();
+  if( !CheckVolume( ioReader->GetOutput(), false ) || !CheckDictionaries( ioReader, false ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // streamed requests only read the slices of each piece
+  typedef itk::StreamingImageFilter< VolumeType, VolumeType > StreamingFilterType;
+  ReaderType::Pointer streamedReader = ReaderType::New();
+  streamedReader->SetFileNames(fileNames);
+  streamedReader->SetNumberOfThreads(4);
+  streamedReader->MetaDataDictionaryArrayUpdateOff();
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( streamedReader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(5);
+  streamer->Update();
+  const VolumeType::RegionType & lastPiece = streamedReader->GetOutput()->GetBufferedRegion();
+  if( lastPiece.GetSize(2) >= NumberOfFiles )
+    {
+    std::cerr << "The series was not streamed: " << lastPiece << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !CheckVolume( streamer->GetOutput(), false ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // a file of another size is reported from the thread reading it
+  SliceType::RegionType otherRegion;
+  otherRegion.SetSize(0, 5);
+  otherRegion.SetSize(1, 5);
+  SliceType::Pointer other = SliceType::New();
+  other->SetRegions(otherRegion);
+  other->Allocate();
+  other->FillBuffer(0);
+  const std::string otherFileName = directory + "/itkImageSeriesReaderParallelTestOther.mha";
+  typedef itk::ImageFileWriter< SliceType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(other);
+  writer->SetImageIO( itk::MetaImageIO::New() );
+  writer->SetFileName(otherFileName);
+  writer->Update();
+
+  ReaderType::FileNamesContainer mismatchedFileNames = fileNames;
+  mismatchedFileNames[NumberOfFiles / 2] = otherFileName;
+  ReaderType::Pointer mismatchedReader = ReaderType::New();
+  mismatchedReader->SetFileNames(mismatchedFileNames);
+  mismatchedReader->SetNumberOfThreads(4);
+  try
+    {
+    mismatchedReader->Update();
+    std::cerr << "The size mismatch was not reported" << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cout << "Expected exception: " << e.GetDescription() << std::endl;
+    }
+
+  // a missing file is reported with the type of the exception of the file
+  // reader, whatever the number of threads
+  ReaderType::FileNamesContainer missingFileNames = fileNames;
+  missingFileNames[NumberOfFiles / 2] = directory + "/itkImageSeriesReaderParallelTestMissing.mha";
+  for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3 )
+    {
+    ReaderType::Pointer missingReader = ReaderType::New();
+    missingReader->SetFileNames(missingFileNames);
+    missingReader->SetNumberOfThreads(numberOfThreads);
+    try
+      {
+      missingReader->Update();
+      std::cerr << "The missing file was not reported" << std::endl;
+      return EXIT_FAILURE;
+      }
+    catch( itk::ImageFileReaderException & e )
+      {
+      std::cout << "Expected exception with " << numberOfThreads << " threads: "
+                << e.GetDescription() << std::endl;
+      }
+    catch( itk::ExceptionObject & e )
+      {
+      std::cerr << "The missing file was reported as " << e.GetNameOfClass()
+                << " with " << numberOfThreads << " threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -73,6 +73,11 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) ITK_OVERRIDE;
 
+  /** Whole images that are neither compressed nor byte swapped are
+   * read as is from the pixel data file, which is the header file
+   * itself for LOCAL data. */
+  virtual bool GetPixelDataFileLocation(std::string & fileName, SizeType & offset) ITK_OVERRIDE;
+
   MetaImage * GetMetaImagePointer();
 
   /*-------- This part of the interfaces deals with writing data. ----- */
@@ -119,11 +124,12 @@ public:
                            const ImageIORegion & largestPossibleRegion) ITK_OVERRIDE;
 
   /** Determine if the ImageIO can stream reading from this
-   *  file. Only time cannot stream read/write is if compression is used.
-   *  CanRead must be called prior to this function. */
+   *  file. Files compressed as a single stream cannot be streamed, files
+   *  compressed in blocks can. CanRead must be called prior to this
+   *  function. */
   virtual bool CanStreamRead() ITK_OVERRIDE
   {
-    if ( m_MetaImage.CompressedData() )
+    if ( m_MetaImage.CompressedData() && m_CompressedBlockOffsets.empty() )
       {
       return false;
       }
@@ -131,19 +137,38 @@ public:
   }
 
   /** Determine if the ImageIO can stream writing to this
-   *  file. Only time cannot stream read/write is if compression is used.
+   *  file. Compressed files can only be streamed when they are written
+   *  in blocks, see SetUseCompressedBlocks().
    *  Assumes file passes a CanRead call and its pixels are of the same
    *  type as the template of the writer. Can verify by first calling
    *  CanRead and then CanStreamRead prior to calling CanStreamWrite. */
   virtual bool CanStreamWrite() ITK_OVERRIDE
   {
-    if ( this->GetUseCompression() )
+    if ( this->GetUseCompression() && !this->WritesCompressedBlocks() )
       {
       return false;
       }
     return true;
   }
 
+  /** Set/Get whether binary pixels are compressed in blocks of slices
+   * along the last dimension. Each block is deflated independently, so
+   * that blocks are compressed and decompressed in parallel and
+   * compressed files may be streamed. The blocks together still form
+   * the single zlib stream that earlier readers expect, but the header
+   * gains the CompressedBlockSlices and CompressedBlockOffsets fields.
+   * Off by default, which writes compressed files as before. Files
+   * compressed in blocks are always read in blocks. */
+  itkSetMacro(UseCompressedBlocks, bool);
+  itkGetConstMacro(UseCompressedBlocks, bool);
+  itkBooleanMacro(UseCompressedBlocks);
+
+  /** Set/Get the number of slices of the blocks written when
+   * UseCompressedBlocks is on. 0, the default, selects blocks of about
+   * one megabyte. */
+  itkSetMacro(SlicesPerCompressedBlock, unsigned int);
+  itkGetConstMacro(SlicesPerCompressedBlock, unsigned int);
+
   /** Determing the subsampling factor in case
    *  we want a coarse version of the image/
    * \warning this is only used when streaming is on. */
@@ -157,12 +182,52 @@ protected:
 
 private:
 
+  /** Whether compressed pixels are written in blocks: UseCompressedBlocks
+   * is on and the file can be written in blocks. */
+  bool WritesCompressedBlocks() const;
+
+  /** Number of slices of the blocks of compressed pixels to write. */
+  unsigned int GetNumberOfSlicesPerBlockForWriting() const;
+
+  /** Locate the first byte of the pixels, possibly compressed, of the
+   * file that was read, given their size. */
+  bool GetDataFileLocation(std::string & fileName, SizeType & offset, SizeType dataSize);
+
+  /** Read the slices of m_IORegion from a file compressed in blocks. */
+  bool ReadCompressedBlocks(void *buffer);
+
+  /** Append the slices of m_IORegion, which are made of whole blocks,
+   * to a file compressed in blocks. The first blocks create the file,
+   * the last ones complete it. */
+  void WriteCompressedBlocks(const void *buffer);
+
+  /** Header of a file compressed in blocks for its current blocks. */
+  std::string GetCompressedBlocksHeader() const;
+
   MetaImage m_MetaImage;
 
   MetaImageIO(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
 
   unsigned int m_SubSamplingFactor;
+
+  bool         m_UseCompressedBlocks;
+  unsigned int m_SlicesPerCompressedBlock;
+
+  // Blocks of the file compressed in blocks that is read or written:
+  // their number of slices and their offsets, from the start of the
+  // compressed data, followed by the end of the last block.
+  unsigned int            m_CompressedBlockSlices;
+  std::vector< SizeType >  m_CompressedBlockOffsets;
+
+  // State of the file compressed in blocks that is written.
+  std::string   m_CompressedHeaderFileName;
+  std::string   m_CompressedDataFileName;
+  std::string   m_CompressedHeaderBegin;
+  std::string   m_CompressedHeaderEnd;
+  unsigned int  m_CompressedHeaderNumberWidth;
+  SizeType      m_CompressedDataOffset;
+  unsigned long m_CompressedDataChecksum;
 };
 } // end namespace itk
 
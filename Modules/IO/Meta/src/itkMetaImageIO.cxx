@@ -20,7 +20,11 @@
 #include "itkSpatialOrientationAdapter.h"
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
+#include "itkMultiThreader.h"
 #include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
+
+#include <iomanip>
 
 namespace itk
 {
@@ -28,6 +32,12 @@ MetaImageIO::MetaImageIO()
 {
   m_FileType = Binary;
   m_SubSamplingFactor = 1;
+  m_UseCompressedBlocks = false;
+  m_SlicesPerCompressedBlock = 0;
+  m_CompressedBlockSlices = 0;
+  m_CompressedHeaderNumberWidth = 0;
+  m_CompressedDataOffset = 0;
+  m_CompressedDataChecksum = 0;
   if ( MET_SystemByteOrderMSB() )
     {
     m_ByteOrder = BigEndian;
@@ -52,6 +62,8 @@ void MetaImageIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   m_MetaImage.PrintInfo();
   os << indent << "SubSamplingFactor: " << m_SubSamplingFactor << "\n";
+  os << indent << "UseCompressedBlocks: " << m_UseCompressedBlocks << "\n";
+  os << indent << "SlicesPerCompressedBlock: " << m_SlicesPerCompressedBlock << "\n";
 }
 
 void MetaImageIO::SetDataFileName(const char *filename)
@@ -391,14 +403,43 @@ void MetaImageIO::ReadImageInformation()
   //
   // save the metadatadictionary in the MetaImage header.
   // NOTE: The MetaIO library only supports typeless strings as metadata
+  m_CompressedBlockSlices = 0;
+  m_CompressedBlockOffsets.clear();
   int dictFields = m_MetaImage.GetNumberOfAdditionalReadFields();
   for ( int f = 0; f < dictFields; f++ )
     {
     std::string key( m_MetaImage.GetAdditionalReadFieldName(f) );
     std::string value ( m_MetaImage.GetAdditionalReadFieldValue(f) );
+    // the blocks of compressed pixels are not metadata
+    if ( key == "CompressedBlockSlices" )
+      {
+      m_CompressedBlockSlices = static_cast< unsigned int >( atoi( value.c_str() ) );
+      continue;
+      }
+    if ( key == "CompressedBlockOffsets" )
+      {
+      std::istringstream offsets(value);
+      SizeType           offset;
+      while ( offsets >> offset )
+        {
+        m_CompressedBlockOffsets.push_back(offset);
+        }
+      continue;
+      }
     EncapsulateMetaData< std::string >( thisMetaDict,key,value );
     }
 
+  // the single zlib stream formed by blocks that do not match the image
+  // is decompressed by MetaIO
+  const unsigned int nDims = this->GetNumberOfDimensions();
+  if ( !m_MetaImage.BinaryData() || !m_MetaImage.CompressedData() || nDims == 0 || m_CompressedBlockSlices == 0
+       || m_CompressedBlockOffsets.size() !=
+          ( this->GetDimensions(nDims - 1) + m_CompressedBlockSlices - 1 ) / m_CompressedBlockSlices + 1 )
+    {
+    m_CompressedBlockSlices = 0;
+    m_CompressedBlockOffsets.clear();
+    }
+
   //
   // Read some metadata
   //
@@ -420,6 +461,14 @@ void MetaImageIO::ReadImageInformation()
 
 void MetaImageIO::Read(void *buffer)
 {
+  // files compressed in blocks are decompressed in parallel
+  if ( !m_CompressedBlockOffsets.empty() && this->ReadCompressedBlocks(buffer) )
+    {
+    m_MetaImage.ElementData(buffer, false);
+    m_MetaImage.ElementByteOrderFix( m_IORegion.GetNumberOfPixels() );
+    return;
+    }
+
   const unsigned int nDims = this->GetNumberOfDimensions();
 
   // this will check to see if we are actually streaming
@@ -487,6 +536,301 @@ void MetaImageIO::Read(void *buffer)
     }
 }
 
+namespace
+{
+// Size of a file, or -1 if it cannot be opened.
+ImageIOBase::SizeType GetFileSize(const std::string & fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  if ( !file )
+    {
+    return -1;
+    }
+  file.seekg(0, std::ios::end);
+  return static_cast< ImageIOBase::SizeType >( file.tellg() );
+}
+
+// Path of a data file named relative to the directory of its header.
+std::string GetDataFilePath(const std::string & headerFileName, const std::string & dataFileName)
+{
+  const std::string path = itksys::SystemTools::GetFilenamePath(headerFileName);
+  if ( itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) || path.empty() )
+    {
+    return dataFileName;
+    }
+  return path + "/" + dataFileName;
+}
+
+// The pixels of a file compressed in blocks form a single zlib stream:
+// a zlib header, raw deflate blocks that each start without history and
+// end on a byte boundary, and the Adler-32 checksum of the pixels. The
+// blocks are described by the CompressedBlockSlices and
+// CompressedBlockOffsets header fields, which earlier readers ignore.
+const unsigned char CompressedStreamHeader[2] = { 0x78, 0x9c };
+const unsigned int  CompressedStreamTrailerSize = 4;
+const unsigned int  CompressedBlockOffsetsPerLine = 16;
+
+bool DeflateBlock(const unsigned char *data, size_t size, bool endOfStream, std::vector< unsigned char > & block)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof( stream ));
+  if ( deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+    return false;
+    }
+
+  // room for incompressible data and the empty block that ends a flush
+  block.resize( deflateBound( &stream, static_cast< uLong >( size ) ) + 16 );
+  stream.next_in = const_cast< Bytef * >( data );
+  stream.avail_in = static_cast< uInt >( size );
+  stream.next_out = &block[0];
+  stream.avail_out = static_cast< uInt >( block.size() );
+
+  // a full flush lets the next block be decompressed on its own
+  const int result = deflate( &stream, endOfStream ? Z_FINISH : Z_FULL_FLUSH );
+  const bool succeeded = endOfStream ? result == Z_STREAM_END
+                                     : ( result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0 );
+  block.resize(stream.total_out);
+  deflateEnd(&stream);
+  return succeeded;
+}
+
+bool InflateBlock(const unsigned char *block, size_t blockSize, unsigned char *data, size_t size)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof( stream ));
+  if ( inflateInit2(&stream, -MAX_WBITS) != Z_OK )
+    {
+    return false;
+    }
+
+  stream.next_in = const_cast< Bytef * >( block );
+  stream.avail_in = static_cast< uInt >( blockSize );
+  stream.next_out = data;
+  stream.avail_out = static_cast< uInt >( size );
+
+  // the block may be followed by more of the stream, and only its first
+  // slices may be needed
+  const int result = inflate(&stream, Z_SYNC_FLUSH);
+  inflateEnd(&stream);
+  return ( result == Z_OK || result == Z_STREAM_END ) && stream.avail_out == 0;
+}
+
+struct DeflateBlocksStruct
+{
+  const unsigned char *                         Data;
+  size_t                                        DataSize;
+  size_t                                        BlockSize;
+  bool                                          EndOfStream;
+  std::vector< std::vector< unsigned char > >   Blocks;
+  std::vector< uLong >                          Checksums;
+  std::vector< char >                           Failed;
+};
+
+ITK_THREAD_RETURN_TYPE DeflateBlocksThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  DeflateBlocksStruct *            str = static_cast< DeflateBlocksStruct * >( info->UserData );
+
+  for ( size_t b = info->ThreadID; b < str->Blocks.size(); b += info->NumberOfThreads )
+    {
+    const size_t begin = b * str->BlockSize;
+    const size_t size = std::min( str->BlockSize, str->DataSize - begin );
+    const bool   endOfStream = str->EndOfStream && b + 1 == str->Blocks.size();
+    str->Failed[b] = !DeflateBlock(str->Data + begin, size, endOfStream, str->Blocks[b]);
+    str->Checksums[b] = adler32( adler32(0, Z_NULL, 0), str->Data + begin, static_cast< uInt >( size ) );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+struct InflateBlocksStruct
+{
+  std::vector< unsigned char >   Compressed;
+  const ImageIOBase::SizeType *  Offsets;
+  ImageIOBase::SizeType          FirstBlock;
+  unsigned int                   BlockSlices;
+  ImageIOBase::SizeType          NumberOfSlices;
+  unsigned char *                Data;
+  size_t                         SliceSize;
+  ImageIOBase::SizeType          FirstSlice;
+  ImageIOBase::SizeType          EndSlice;
+  std::vector< char >            Failed;
+};
+
+ITK_THREAD_RETURN_TYPE InflateBlocksThreaderCallback(void *arg)
+{
+  typedef ImageIOBase::SizeType SizeType;
+
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  InflateBlocksStruct *            str = static_cast< InflateBlocksStruct * >( info->UserData );
+
+  for ( size_t b = info->ThreadID; b < str->Failed.size(); b += info->NumberOfThreads )
+    {
+    const SizeType block = str->FirstBlock + b;
+    const SizeType blockFirstSlice = block * str->BlockSlices;
+    const SizeType blockEndSlice = std::min( blockFirstSlice + str->BlockSlices, str->NumberOfSlices );
+    const SizeType firstSlice = std::max( blockFirstSlice, str->FirstSlice );
+    const SizeType endSlice = std::min( blockEndSlice, str->EndSlice );
+
+    const unsigned char *compressed = &str->Compressed[0] + ( str->Offsets[block] - str->Offsets[str->FirstBlock] );
+    const size_t         compressedSize = static_cast< size_t >( str->Offsets[block + 1] - str->Offsets[block] );
+    unsigned char *      data = str->Data + ( firstSlice - str->FirstSlice ) * str->SliceSize;
+    if ( firstSlice == blockFirstSlice )
+      {
+      str->Failed[b] = !InflateBlock( compressed, compressedSize, data, ( endSlice - firstSlice ) * str->SliceSize );
+      }
+    else
+      {
+      // the block starts before the region
+      std::vector< unsigned char > slices( ( endSlice - blockFirstSlice ) * str->SliceSize );
+      str->Failed[b] = !InflateBlock( compressed, compressedSize, &slices[0], slices.size() );
+      memcpy( data, &slices[( firstSlice - blockFirstSlice ) * str->SliceSize],
+              ( endSlice - firstSlice ) * str->SliceSize );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void ProcessBlocksInParallel(ThreadFunctionType callback, void *data, unsigned int numberOfBlocks)
+{
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( std::min( static_cast< unsigned int >( threader->GetNumberOfThreads() ),
+                                          numberOfBlocks ) );
+  threader->SetSingleMethod(callback, data);
+  threader->SingleMethodExecute();
+}
+}
+
+bool MetaImageIO::GetPixelDataFileLocation(std::string & fileName, SizeType & offset)
+{
+  // streamed regions and subsampling are read through ReadROI
+  const unsigned int nDims = this->GetNumberOfDimensions();
+  ImageIORegion      largestRegion(nDims);
+  for ( unsigned int i = 0; i < nDims; i++ )
+    {
+    largestRegion.SetIndex(i, 0);
+    largestRegion.SetSize( i, this->GetDimensions(i) );
+    }
+  if ( largestRegion != m_IORegion
+       || !m_MetaImage.BinaryData()
+       || m_MetaImage.CompressedData()
+       || ( m_MetaImage.BinaryDataByteOrderMSB() != MET_SystemByteOrderMSB()
+            && this->GetComponentSize() > 1 ) )
+    {
+    return false;
+    }
+
+  return this->GetDataFileLocation( fileName, offset, this->GetImageSizeInBytes() );
+}
+
+bool MetaImageIO::GetDataFileLocation(std::string & fileName, SizeType & offset, SizeType dataSize)
+{
+  const std::string dataFileName = m_MetaImage.ElementDataFileName();
+  if ( itksys::SystemTools::Strucmp(dataFileName.c_str(), "LOCAL") == 0 )
+    {
+    fileName = m_FileName;
+    }
+  else if ( dataFileName.compare(0, 4, "LIST") == 0
+            || dataFileName.find('%') != std::string::npos )
+    {
+    // one file per slice
+    return false;
+    }
+  else
+    {
+    fileName = GetDataFilePath(m_FileName, dataFileName);
+    }
+
+  if ( m_MetaImage.HeaderSize() > 0 )
+    {
+    offset = m_MetaImage.HeaderSize();
+    }
+  else if ( m_MetaImage.HeaderSize() == -1 )
+    {
+    // the data is at the end of the file
+    offset = GetFileSize(fileName) - dataSize;
+    }
+  else if ( fileName == m_FileName )
+    {
+    // the data follows the header
+    std::ifstream file(m_FileName.c_str(), std::ios::in | std::ios::binary);
+    MetaImage     header;
+    if ( !file || !header.ReadStream(0, &file, false) )
+      {
+      return false;
+      }
+    offset = static_cast< SizeType >( file.tellg() );
+    }
+  else
+    {
+    offset = 0;
+    }
+  return offset >= 0;
+}
+
+bool MetaImageIO::ReadCompressedBlocks(void *buffer)
+{
+  // other regions are read by MetaIO
+  const unsigned int lastDimension = this->GetNumberOfDimensions() - 1;
+  if ( m_IORegion.GetImageDimension() != this->GetNumberOfDimensions() || m_SubSamplingFactor != 1 )
+    {
+    return false;
+    }
+  for ( unsigned int i = 0; i < lastDimension; i++ )
+    {
+    if ( m_IORegion.GetIndex(i) != 0
+         || m_IORegion.GetSize(i) != static_cast< SizeValueType >( this->GetDimensions(i) ) )
+      {
+      return false;
+      }
+    }
+
+  const SizeType numberOfSlices = this->GetDimensions(lastDimension);
+  const SizeType firstSlice = m_IORegion.GetIndex(lastDimension);
+  const SizeType endSlice = firstSlice + m_IORegion.GetSize(lastDimension);
+  const SizeType firstBlock = firstSlice / m_CompressedBlockSlices;
+  const SizeType endBlock = ( endSlice + m_CompressedBlockSlices - 1 ) / m_CompressedBlockSlices;
+
+  std::string fileName;
+  SizeType    offset = 0;
+  if ( !this->GetDataFileLocation( fileName, offset, m_CompressedBlockOffsets.back() + CompressedStreamTrailerSize ) )
+    {
+    itkExceptionMacro( "Compressed data cannot be located in: " << this->GetFileName() );
+    }
+
+  // the compressed blocks are read at once and decompressed in parallel
+  InflateBlocksStruct str;
+  str.Compressed.resize( m_CompressedBlockOffsets[endBlock] - m_CompressedBlockOffsets[firstBlock] );
+  str.Offsets = &m_CompressedBlockOffsets[0];
+  str.FirstBlock = firstBlock;
+  str.BlockSlices = m_CompressedBlockSlices;
+  str.NumberOfSlices = numberOfSlices;
+  str.Data = static_cast< unsigned char * >( buffer );
+  str.SliceSize = static_cast< size_t >( this->GetImageSizeInBytes() / numberOfSlices );
+  str.FirstSlice = firstSlice;
+  str.EndSlice = endSlice;
+  str.Failed.resize(endBlock - firstBlock, 0);
+
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  file.seekg(offset + m_CompressedBlockOffsets[firstBlock], std::ios::beg);
+  file.read( reinterpret_cast< char * >( &str.Compressed[0] ), str.Compressed.size() );
+  if ( !file )
+    {
+    itkExceptionMacro( "File cannot be read: "
+                       << fileName << " for reading."
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  ProcessBlocksInParallel( InflateBlocksThreaderCallback, &str, static_cast< unsigned int >( endBlock - firstBlock ) );
+  if ( std::find( str.Failed.begin(), str.Failed.end(), 1 ) != str.Failed.end() )
+    {
+    itkExceptionMacro( "Compressed data is corrupted in: " << this->GetFileName() );
+    }
+  return true;
+}
+
 MetaImage * MetaImageIO::GetMetaImagePointer(void)
 {
   return &m_MetaImage;
@@ -770,6 +1114,9 @@ MetaImageIO
   m_MetaImage.InitializeEssential( numberOfDimensions, dSize, eSpacing, eType, nChannels,
                                    const_cast< void * >( buffer ) );
   m_MetaImage.Position(eOrigin);
+  delete[] dSize;
+  delete[] eSpacing;
+  delete[] eOrigin;
   m_MetaImage.BinaryData(binaryData);
 
   //Write the image Information
@@ -1048,7 +1395,11 @@ MetaImageIO
     largestRegion.SetSize( ii, this->GetDimensions(ii) );
     }
 
-  if ( m_UseCompression && ( largestRegion != m_IORegion ) )
+  if ( this->WritesCompressedBlocks() )
+    {
+    this->WriteCompressedBlocks(buffer);
+    }
+  else if ( m_UseCompression && ( largestRegion != m_IORegion ) )
     {
     std::cout << "Compression in use: cannot stream the file writing" << std::endl;
     }
@@ -1067,9 +1418,6 @@ MetaImageIO
 
     if ( !m_MetaImage.WriteROI( indexMin, indexMax, m_FileName.c_str() ) )
       {
-      delete[] dSize;
-      delete[] eSpacing;
-      delete[] eOrigin;
       delete[] indexMin;
       delete[] indexMax;
       itkExceptionMacro( "File ROI cannot be written: "
@@ -1086,9 +1434,6 @@ MetaImageIO
     {
     if ( !m_MetaImage.Write( m_FileName.c_str() ) )
       {
-      delete[] dSize;
-      delete[] eSpacing;
-      delete[] eOrigin;
       itkExceptionMacro( "File cannot be written: "
                          << this->GetFileName()
                          << std::endl
@@ -1096,10 +1441,246 @@ MetaImageIO
                          << itksys::SystemTools::GetLastSystemError() );
       }
     }
+}
 
-  delete[] dSize;
-  delete[] eSpacing;
-  delete[] eOrigin;
+bool
+MetaImageIO
+::WritesCompressedBlocks() const
+{
+  if ( !m_UseCompressedBlocks || !this->GetUseCompression() || this->GetFileType() == ASCII || this->GetNumberOfDimensions() == 0 )
+    {
+    return false;
+    }
+
+  // MetaIO compresses the files of a list of slices itself
+  const std::string dataFileName = m_MetaImage.ElementDataFileName();
+  if ( dataFileName.compare(0, 4, "LIST") == 0
+       || dataFileName.find('%') != std::string::npos )
+    {
+    return false;
+    }
+
+  // each block is deflated in a single call
+  const SizeType sliceSize =
+    this->GetImageSizeInBytes() / this->GetDimensions(this->GetNumberOfDimensions() - 1);
+  return sliceSize <= ( 1 << 30 );
+}
+
+unsigned int
+MetaImageIO
+::GetNumberOfSlicesPerBlockForWriting() const
+{
+  const SizeType numberOfSlices = this->GetDimensions(this->GetNumberOfDimensions() - 1);
+  const SizeType sliceSize = this->GetImageSizeInBytes() / numberOfSlices;
+
+  SizeType blockSlices = m_SlicesPerCompressedBlock;
+  if ( blockSlices == 0 )
+    {
+    // about one megabyte
+    blockSlices = std::max( ( 1 << 20 ) / sliceSize, static_cast< SizeType >( 1 ) );
+    }
+  blockSlices = std::min( blockSlices, numberOfSlices );
+  // each block is deflated in a single call
+  blockSlices = std::min( blockSlices, std::max( ( 1 << 30 ) / sliceSize, static_cast< SizeType >( 1 ) ) );
+  return static_cast< unsigned int >( blockSlices );
+}
+
+std::string
+MetaImageIO
+::GetCompressedBlocksHeader() const
+{
+  const SizeType numberOfSlices = this->GetDimensions(this->GetNumberOfDimensions() - 1);
+  const SizeType numberOfBlocks = ( numberOfSlices + m_CompressedBlockSlices - 1 ) / m_CompressedBlockSlices;
+
+  // the numbers are padded to keep the size of the header until all
+  // blocks are written
+  SizeType compressedDataSize = 0;
+  if ( static_cast< SizeType >( m_CompressedBlockOffsets.size() ) == numberOfBlocks + 1 )
+    {
+    compressedDataSize = m_CompressedBlockOffsets.back() + CompressedStreamTrailerSize;
+    }
+
+  std::ostringstream header;
+  header << m_CompressedHeaderBegin
+         << "CompressedData = True\n"
+         << "CompressedDataSize = " << std::setfill('0') << std::setw(m_CompressedHeaderNumberWidth)
+         << compressedDataSize << "\n"
+         << "CompressedBlockSlices = " << m_CompressedBlockSlices << "\n";
+  for ( SizeType b = 0; b <= numberOfBlocks; ++b )
+    {
+    if ( b % CompressedBlockOffsetsPerLine == 0 )
+      {
+      header << ( b == 0 ? "" : "\n" ) << "CompressedBlockOffsets =";
+      }
+    header << ' ' << std::setw(m_CompressedHeaderNumberWidth)
+           << ( b < static_cast< SizeType >( m_CompressedBlockOffsets.size() ) ? m_CompressedBlockOffsets[b] : 0 );
+    }
+  header << "\n" << m_CompressedHeaderEnd;
+  return header.str();
+}
+
+void
+MetaImageIO
+::WriteCompressedBlocks(const void *buffer)
+{
+  const unsigned int lastDimension = this->GetNumberOfDimensions() - 1;
+  const SizeType     numberOfSlices = this->GetDimensions(lastDimension);
+  const SizeType     sliceSize = this->GetImageSizeInBytes() / numberOfSlices;
+  const unsigned int blockSlices = this->GetNumberOfSlicesPerBlockForWriting();
+  const SizeType     numberOfBlocks = ( numberOfSlices + blockSlices - 1 ) / blockSlices;
+
+  // the region must be made of whole blocks, see GetSplitRegionForWriting()
+  for ( unsigned int i = 0; i < lastDimension; ++i )
+    {
+    if ( m_IORegion.GetIndex(i) != 0
+         || m_IORegion.GetSize(i) != static_cast< SizeValueType >( this->GetDimensions(i) ) )
+      {
+      itkExceptionMacro( "Pasting and compression is not supported! Can't write:" << this->GetFileName() );
+      }
+    }
+  const SizeType firstSlice = m_IORegion.GetIndex(lastDimension);
+  const SizeType endSlice = firstSlice + m_IORegion.GetSize(lastDimension);
+  if ( firstSlice % blockSlices != 0 || ( endSlice % blockSlices != 0 && endSlice != numberOfSlices ) )
+    {
+    itkExceptionMacro( "Compressed regions must be made of blocks of " << blockSlices
+                       << " slices! Can't write:" << this->GetFileName() );
+    }
+  const SizeType firstBlock = firstSlice / blockSlices;
+  const SizeType endBlock = ( endSlice + blockSlices - 1 ) / blockSlices;
+
+  if ( firstBlock == 0 )
+    {
+    // MetaIO writes the header of an uncompressed file, into which the
+    // blocks are then described
+    std::string dataFileName;
+    if ( strlen( m_MetaImage.ElementDataFileName() ) == 0 )
+      {
+      dataFileName = itksys::SystemTools::GetFilenameLastExtension(m_FileName) == ".mha" ? "LOCAL"
+                     : m_FileName.substr( 0, m_FileName.rfind('.') ) + ".zraw";
+      }
+    m_MetaImage.CompressedData(false);
+    const bool written = m_MetaImage.Write( m_FileName.c_str(), dataFileName.empty() ? ITK_NULLPTR : dataFileName.c_str(),
+                                            false );
+    m_MetaImage.CompressedData(true);
+    if ( !written )
+      {
+      itkExceptionMacro( "File cannot be written: "
+                         << this->GetFileName()
+                         << std::endl
+                         << "Reason: "
+                         << itksys::SystemTools::GetLastSystemError() );
+      }
+    m_CompressedHeaderFileName = m_MetaImage.FileName();
+    if ( dataFileName.empty() )
+      {
+      dataFileName = GetDataFilePath( m_CompressedHeaderFileName, m_MetaImage.ElementDataFileName() );
+      }
+    const bool local = itksys::SystemTools::Strucmp(dataFileName.c_str(), "LOCAL") == 0;
+    m_CompressedDataFileName = local ? m_CompressedHeaderFileName : dataFileName;
+
+    std::ostringstream uncompressedHeader;
+      {
+      std::ifstream headerFile(m_CompressedHeaderFileName.c_str(), std::ios::in | std::ios::binary);
+      uncompressedHeader << headerFile.rdbuf();
+      }
+    const std::string            header = uncompressedHeader.str();
+    const std::string            field = "\nCompressedData = False\n";
+    const std::string::size_type fieldPosition = header.find(field);
+    if ( fieldPosition == std::string::npos )
+      {
+      itkExceptionMacro( "Unexpected header written in: " << m_CompressedHeaderFileName );
+      }
+    m_CompressedHeaderBegin = header.substr(0, fieldPosition + 1);
+    m_CompressedHeaderEnd = header.substr( fieldPosition + field.size() );
+
+    // wide enough for the size of incompressible blocks
+    const SizeType     dataSize = this->GetImageSizeInBytes();
+    std::ostringstream maximumSize;
+    maximumSize << dataSize + ( dataSize >> 12 ) + ( dataSize >> 14 ) + ( dataSize >> 25 ) + 18 * numberOfBlocks + 6;
+    m_CompressedHeaderNumberWidth = static_cast< unsigned int >( maximumSize.str().size() );
+
+    m_CompressedBlockSlices = blockSlices;
+    m_CompressedBlockOffsets.assign( 1, sizeof( CompressedStreamHeader ) );
+    m_CompressedDataChecksum = adler32(0, Z_NULL, 0);
+
+    const std::string compressedHeader = this->GetCompressedBlocksHeader();
+    std::ofstream     headerFile(m_CompressedHeaderFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    headerFile.write( compressedHeader.c_str(), compressedHeader.size() );
+    m_CompressedDataOffset = 0;
+    if ( local )
+      {
+      m_CompressedDataOffset = compressedHeader.size();
+      headerFile.write( reinterpret_cast< const char * >( CompressedStreamHeader ), sizeof( CompressedStreamHeader ) );
+      }
+    else
+      {
+      std::ofstream dataFile(m_CompressedDataFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      dataFile.write( reinterpret_cast< const char * >( CompressedStreamHeader ), sizeof( CompressedStreamHeader ) );
+      if ( !dataFile )
+        {
+        itkExceptionMacro( "File cannot be written: " << m_CompressedDataFileName );
+        }
+      }
+    if ( !headerFile )
+      {
+      itkExceptionMacro( "File cannot be written: " << m_CompressedHeaderFileName );
+      }
+    }
+  else if ( static_cast< SizeType >( m_CompressedBlockOffsets.size() ) != firstBlock + 1
+            || m_CompressedBlockSlices != blockSlices )
+    {
+    itkExceptionMacro( "Compressed blocks must be written in order! Can't write:" << this->GetFileName() );
+    }
+
+  // the blocks are compressed in parallel
+  DeflateBlocksStruct str;
+  str.Data = static_cast< const unsigned char * >( buffer );
+  str.DataSize = static_cast< size_t >( ( endSlice - firstSlice ) * sliceSize );
+  str.BlockSize = static_cast< size_t >( blockSlices * sliceSize );
+  str.EndOfStream = endBlock == numberOfBlocks;
+  str.Blocks.resize(endBlock - firstBlock);
+  str.Checksums.resize(endBlock - firstBlock);
+  str.Failed.resize(endBlock - firstBlock, 0);
+  ProcessBlocksInParallel( DeflateBlocksThreaderCallback, &str, static_cast< unsigned int >( endBlock - firstBlock ) );
+
+  std::fstream dataFile(m_CompressedDataFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  dataFile.seekp(m_CompressedDataOffset + m_CompressedBlockOffsets.back(), std::ios::beg);
+  for ( size_t b = 0; b < str.Blocks.size(); ++b )
+    {
+    if ( str.Failed[b] )
+      {
+      itkExceptionMacro( "Compression failed for: " << this->GetFileName() );
+      }
+    dataFile.write( reinterpret_cast< const char * >( &str.Blocks[b][0] ), str.Blocks[b].size() );
+    m_CompressedBlockOffsets.push_back( m_CompressedBlockOffsets.back() + str.Blocks[b].size() );
+    m_CompressedDataChecksum = adler32_combine( m_CompressedDataChecksum, str.Checksums[b],
+                                                std::min( str.BlockSize, str.DataSize - b * str.BlockSize ) );
+    }
+
+  if ( str.EndOfStream )
+    {
+    // the checksum of the pixels ends the stream, most significant byte first
+    const unsigned char trailer[CompressedStreamTrailerSize] = {
+      static_cast< unsigned char >( ( m_CompressedDataChecksum >> 24 ) & 0xff ),
+      static_cast< unsigned char >( ( m_CompressedDataChecksum >> 16 ) & 0xff ),
+      static_cast< unsigned char >( ( m_CompressedDataChecksum >> 8 ) & 0xff ),
+      static_cast< unsigned char >( m_CompressedDataChecksum & 0xff ) };
+    dataFile.write( reinterpret_cast< const char * >( trailer ), CompressedStreamTrailerSize );
+    dataFile.close();
+
+    // the header now describes all blocks
+    const std::string compressedHeader = this->GetCompressedBlocksHeader();
+    std::fstream      headerFile(m_CompressedHeaderFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    headerFile.write( compressedHeader.c_str(), compressedHeader.size() );
+    if ( !headerFile )
+      {
+      itkExceptionMacro( "File cannot be written: " << m_CompressedHeaderFileName );
+      }
+    }
+  else if ( !dataFile )
+    {
+    itkExceptionMacro( "File cannot be written: " << m_CompressedDataFileName );
+    }
 }
 
 /** Given a requested region, determine what could be the region that we can
@@ -1127,6 +1708,15 @@ MetaImageIO
   else
     {
     streamableRegion = requestedRegion;
+    if ( !m_CompressedBlockOffsets.empty() && requestedRegion.GetImageDimension() == this->m_NumberOfDimensions )
+      {
+      // compressed blocks are made of whole slices
+      for ( unsigned int i = 0; i + 1 < this->m_NumberOfDimensions; i++ )
+        {
+        streamableRegion.SetSize(i, this->m_Dimensions[i]);
+        streamableRegion.SetIndex(i, 0);
+        }
+      }
     }
 
   return streamableRegion;
@@ -1144,6 +1734,16 @@ MetaImageIO::GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSpl
       {
       itkExceptionMacro( "Pasting and compression is not supported! Can't write:" << this->GetFileName() );
       }
+    else if ( this->WritesCompressedBlocks() )
+      {
+      // each piece is made of whole blocks
+      const SizeType numberOfSlices = this->GetDimensions(this->GetNumberOfDimensions() - 1);
+      const SizeType blockSlices = this->GetNumberOfSlicesPerBlockForWriting();
+      const SizeType numberOfBlocks = ( numberOfSlices + blockSlices - 1 ) / blockSlices;
+      return static_cast< unsigned int >(
+        std::max( std::min( static_cast< SizeType >( numberOfRequestedSplits ), numberOfBlocks ),
+                  static_cast< SizeType >( 1 ) ) );
+      }
     else if ( numberOfRequestedSplits != 1 )
       {
       itkDebugMacro("Requested streaming and compression");
@@ -1261,6 +1861,22 @@ MetaImageIO::GetSplitRegionForWriting( unsigned int ithPiece,
                                        const ImageIORegion & pasteRegion,
                                        const ImageIORegion & itkNotUsed(largestPossibleRegion) )
 {
+  if ( this->WritesCompressedBlocks() )
+    {
+    // each piece is made of whole blocks, which are written in order
+    const unsigned int lastDimension = pasteRegion.GetImageDimension() - 1;
+    const SizeType     numberOfSlices = pasteRegion.GetSize(lastDimension);
+    const SizeType     blockSlices = this->GetNumberOfSlicesPerBlockForWriting();
+    const SizeType     numberOfBlocks = ( numberOfSlices + blockSlices - 1 ) / blockSlices;
+    const SizeType     firstSlice = ithPiece * numberOfBlocks / numberOfActualSplits * blockSlices;
+    const SizeType     endSlice =
+      std::min( ( ithPiece + 1 ) * numberOfBlocks / numberOfActualSplits * blockSlices, numberOfSlices );
+
+    ImageIORegion splitRegion = pasteRegion;
+    splitRegion.SetIndex( lastDimension, pasteRegion.GetIndex(lastDimension) + firstSlice );
+    splitRegion.SetSize( lastDimension, endSlice - firstSlice );
+    return splitRegion;
+    }
   return GetSplitRegionForWritingCanStreamWrite(ithPiece, numberOfActualSplits, pasteRegion);
 }
 } // end namespace itk
@@ -0,0 +1,253 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMetaImageIO.h"
+#include "itkMultiThreader.h"
+#include "itkStreamingImageFilter.h"
+#include <fstream>
+
+namespace
+{
+typedef itk::Image< float, 3 > ImageType;
+
+bool SameImages(const ImageType *image1, const ImageType *image2)
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image1, image1->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != image2->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " differs" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+ImageType::Pointer Read(const std::string & fileName)
+{
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+  ImageType::Pointer output = reader->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+// Read the pixels of a file with MetaIO alone, as earlier readers do.
+bool SameAsMetaIO(const ImageType *image, const std::string & fileName)
+{
+  MetaImage metaImage;
+  if( !metaImage.Read( fileName.c_str() ) || !metaImage.CompressedData() )
+    {
+    std::cerr << "MetaIO cannot read " << fileName << std::endl;
+    return false;
+    }
+  const float *pixels = static_cast< const float * >( metaImage.ElementData() );
+  for( itk::SizeValueType i = 0; i < image->GetLargestPossibleRegion().GetNumberOfPixels(); ++i )
+    {
+    if( pixels[i] != image->GetBufferPointer()[i] )
+      {
+      std::cerr << "MetaIO read pixel " << i << " of " << fileName << " differently" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Whether the header of a file describes blocks of compressed pixels.
+bool HasCompressedBlocks(const std::string & fileName)
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  std::string   line;
+  while( std::getline(file, line) && line.compare(0, 15, "ElementDataFile") != 0 )
+    {
+    if( line.compare(0, 21, "CompressedBlockSlices") == 0 )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+}
+
+int itkMetaImageIOCompressedBlocksTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  // blocks are processed by several threads
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads(4);
+
+  ImageType::RegionType region;
+  region.SetSize(0, 23);
+  region.SetSize(1, 17);
+  region.SetSize(2, 29);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+    {
+    image->GetBufferPointer()[i] = static_cast< float >( ( i * 7 ) % 113 ) - 0.5f * ( i % 3 );
+    }
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  typedef itk::MetaImageIO                  IOType;
+
+  // compressed files are written as a single stream by default
+  const std::string defaultFileName = directory + "/itkMetaImageIOCompressedBlocksTestDefault.mha";
+  IOType::Pointer defaultIO = IOType::New();
+  if( defaultIO->GetUseCompressedBlocks() )
+    {
+    std::cerr << "UseCompressedBlocks is on by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+  WriterType::Pointer defaultWriter = WriterType::New();
+  defaultWriter->SetInput(image);
+  defaultWriter->SetImageIO(defaultIO);
+  defaultWriter->SetFileName(defaultFileName);
+  defaultWriter->UseCompressionOn();
+  defaultWriter->Update();
+
+  if( HasCompressedBlocks( defaultFileName ) || defaultIO->CanStreamWrite() )
+    {
+    std::cerr << "A compressed file was written in blocks by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+  ImageType::Pointer defaultImage = Read(defaultFileName);
+  if( !SameImages( image, defaultImage ) || !SameAsMetaIO( image, defaultFileName ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // blocks of 4 slices, the last one of a single slice, written at once,
+  // which MetaIO reads as a single stream
+  const std::string blocksFileName = directory + "/itkMetaImageIOCompressedBlocksTest.mha";
+  IOType::Pointer io = IOType::New();
+  io->UseCompressedBlocksOn();
+  io->SetSlicesPerCompressedBlock(4);
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetImageIO(io);
+  writer->SetFileName(blocksFileName);
+  writer->UseCompressionOn();
+  writer->Update();
+
+  ImageType::Pointer blocks = Read(blocksFileName);
+  if( !HasCompressedBlocks( blocksFileName ) )
+    {
+    std::cerr << "UseCompressedBlocks did not write blocks" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !SameImages( image, blocks ) || !SameAsMetaIO( image, blocksFileName ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // streamed writing into a separate data file
+  const std::string streamedFileName = directory + "/itkMetaImageIOCompressedBlocksTestStreamed.mhd";
+  IOType::Pointer streamedIO = IOType::New();
+  streamedIO->UseCompressedBlocksOn();
+  streamedIO->SetSlicesPerCompressedBlock(3);
+  WriterType::Pointer streamingWriter = WriterType::New();
+  streamingWriter->SetInput(image);
+  streamingWriter->SetImageIO(streamedIO);
+  streamingWriter->SetFileName(streamedFileName);
+  streamingWriter->UseCompressionOn();
+  streamingWriter->SetNumberOfStreamDivisions(4);
+  streamingWriter->Update();
+
+  ImageType::Pointer streamed = Read(streamedFileName);
+  if( !SameImages( image, streamed ) || !SameAsMetaIO( image, streamedFileName ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // streamed reading and writing of a file compressed in blocks
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer streamingReader = ReaderType::New();
+  streamingReader->SetFileName(blocksFileName);
+  streamingReader->UseStreamingOn();
+
+  const std::string rewrittenFileName = directory + "/itkMetaImageIOCompressedBlocksTestRewritten.mha";
+  IOType::Pointer rewrittenIO = IOType::New();
+  rewrittenIO->UseCompressedBlocksOn();
+  rewrittenIO->SetSlicesPerCompressedBlock(2);
+  WriterType::Pointer rewriter = WriterType::New();
+  rewriter->SetInput( streamingReader->GetOutput() );
+  rewriter->SetImageIO(rewrittenIO);
+  rewriter->SetFileName(rewrittenFileName);
+  rewriter->UseCompressionOn();
+  rewriter->SetNumberOfStreamDivisions(5);
+  rewriter->Update();
+
+  const ImageType::RegionType & lastPiece = streamingReader->GetOutput()->GetBufferedRegion();
+  std::cout << "Last piece read: " << lastPiece;
+  if( lastPiece.GetSize(2) >= region.GetSize(2) || lastPiece.GetSize(0) != region.GetSize(0) )
+    {
+    std::cerr << "The compressed file was not streamed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer rewritten = Read(rewrittenFileName);
+  if( !SameImages( image, rewritten ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // streamed reading of regions that do not start at a block
+  typedef itk::StreamingImageFilter< ImageType, ImageType > StreamingFilterType;
+  ReaderType::Pointer pieceReader = ReaderType::New();
+  pieceReader->SetFileName(blocksFileName);
+  pieceReader->UseStreamingOn();
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( pieceReader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(7);
+  streamer->Update();
+  if( !SameImages( image, streamer->GetOutput() ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // files compressed as a single stream by MetaIO remain readable
+  const std::string singleStreamFileName = directory + "/itkMetaImageIOCompressedBlocksTestSingleStream.mha";
+  const int   dimensions[3] = { 23, 17, 29 };
+  const float spacing[3] = { 1.0f, 1.0f, 1.0f };
+  MetaImage   metaImage( 3, dimensions, spacing, MET_FLOAT, 1, image->GetBufferPointer() );
+  metaImage.CompressedData(true);
+  if( !metaImage.Write( singleStreamFileName.c_str() ) )
+    {
+    std::cerr << "MetaIO cannot write " << singleStreamFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  ImageType::Pointer singleStream = Read(singleStreamFileName);
+  if( !SameImages( image, singleStream ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
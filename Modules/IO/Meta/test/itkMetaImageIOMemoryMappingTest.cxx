@@ -0,0 +1,223 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMemoryMappedImportImageContainer.h"
+#include "itkMetaImageIO.h"
+#include "itkVectorImage.h"
+
+namespace
+{
+template< typename TImage >
+bool IsMapped(const TImage *image)
+{
+  typedef typename TImage::PixelContainer PixelContainerType;
+  typedef itk::MemoryMappedImportImageContainer< typename PixelContainerType::ElementIdentifier,
+                                                 typename PixelContainerType::Element >
+    MappedPixelContainerType;
+  const MappedPixelContainerType *container =
+    dynamic_cast< const MappedPixelContainerType * >( image->GetPixelContainer() );
+  return container != ITK_NULLPTR && container->GetMappedFile() != ITK_NULLPTR;
+}
+
+template< typename TImage >
+bool SameImages(const TImage *image1, const TImage *image2)
+{
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( image1, image1->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != image2->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " differs" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Whether the pixels of the file are stored as is at an offset aligned
+// for the pixel components, which depends on the length of the header.
+bool CanMap(const std::string & fileName, itk::ImageIOBase::SizeType alignment)
+{
+  itk::MetaImageIO::Pointer io = itk::MetaImageIO::New();
+  io->SetFileName(fileName);
+  io->ReadImageInformation();
+
+  itk::ImageIORegion region( io->GetNumberOfDimensions() );
+  for( unsigned int i = 0; i < io->GetNumberOfDimensions(); ++i )
+    {
+    region.SetSize( i, io->GetDimensions(i) );
+    }
+  io->SetIORegion(region);
+
+  std::string                fileNameOfPixels;
+  itk::ImageIOBase::SizeType offset = 0;
+  return io->GetPixelDataFileLocation(fileNameOfPixels, offset) && offset % alignment == 0;
+}
+
+template< typename TOutputImage >
+typename TOutputImage::Pointer Read(const std::string & fileName, bool expectMapped)
+{
+  typedef itk::ImageFileReader< TOutputImage > ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->UseMemoryMappingOn();
+  reader->Update();
+
+  typename TOutputImage::Pointer output = reader->GetOutput();
+  if( IsMapped( output.GetPointer() ) != expectMapped )
+    {
+    std::cerr << fileName << ( expectMapped ? " was not mapped" : " was mapped" ) << std::endl;
+    return ITK_NULLPTR;
+    }
+  output->DisconnectPipeline();
+  return output;
+}
+}
+
+int itkMetaImageIOMemoryMappingTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  typedef itk::Image< float, 3 >         ImageType;
+  typedef itk::Image< short, 3 >         ShortImageType;
+  typedef itk::Image< unsigned char, 3 > CharImageType;
+  typedef itk::VectorImage< short, 3 >   VectorImageType;
+
+  ImageType::RegionType region;
+  region.SetSize(0, 17);
+  region.SetSize(1, 9);
+  region.SetSize(2, 5);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+    {
+    image->GetBufferPointer()[i] = 0.25f * i - 100.0f;
+    }
+
+  CharImageType::Pointer charImage = CharImageType::New();
+  charImage->SetRegions(region);
+  charImage->Allocate();
+  for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+    {
+    charImage->GetBufferPointer()[i] = static_cast< unsigned char >( i % 251 );
+    }
+
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  vectorImage->SetRegions(region);
+  vectorImage->SetVectorLength(3);
+  vectorImage->Allocate();
+  for( itk::SizeValueType i = 0; i < 3 * region.GetNumberOfPixels(); ++i )
+    {
+    vectorImage->GetBufferPointer()[i] = static_cast< short >( 7 * i - 1000 );
+    }
+
+  typedef itk::ImageFileWriter< ImageType >       WriterType;
+  typedef itk::ImageFileWriter< CharImageType >   CharWriterType;
+  typedef itk::ImageFileWriter< VectorImageType > VectorWriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+
+  // pixels following the header, in a separate file, and compressed
+  writer->SetFileName(directory + "/itkMetaImageIOMemoryMappingTest.mha");
+  writer->Update();
+  writer->SetFileName(directory + "/itkMetaImageIOMemoryMappingTest.mhd");
+  writer->Update();
+  writer->SetFileName(directory + "/itkMetaImageIOMemoryMappingTestCompressed.mha");
+  writer->UseCompressionOn();
+  writer->Update();
+
+  CharWriterType::Pointer charWriter = CharWriterType::New();
+  charWriter->SetInput(charImage);
+  charWriter->SetFileName(directory + "/itkMetaImageIOMemoryMappingTestChar.mha");
+  charWriter->Update();
+
+  VectorWriterType::Pointer vectorWriter = VectorWriterType::New();
+  vectorWriter->SetInput(vectorImage);
+  vectorWriter->SetFileName(directory + "/itkMetaImageIOMemoryMappingTestVector.mha");
+  vectorWriter->Update();
+
+  // the pixels of the .mhd file start its data file, those of the .mha
+  // files follow the header and are aligned for bytes only
+  const std::string mhaFileName = directory + "/itkMetaImageIOMemoryMappingTest.mha";
+  const std::string vectorFileName = directory + "/itkMetaImageIOMemoryMappingTestVector.mha";
+  if( !CanMap(directory + "/itkMetaImageIOMemoryMappingTest.mhd", sizeof( float ) ) )
+    {
+    std::cerr << "The pixels of the .mhd file cannot be mapped" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const bool mhaMapped = CanMap( mhaFileName, sizeof( float ) );
+  const bool vectorMapped = CanMap( vectorFileName, sizeof( short ) );
+  std::cout << "Mapped .mha: " << mhaMapped << ", mapped vector .mha: " << vectorMapped << std::endl;
+
+  const char *fileNames[] = { "/itkMetaImageIOMemoryMappingTest.mhd",
+                              "/itkMetaImageIOMemoryMappingTest.mha" };
+  for( unsigned int i = 0; i < 2; ++i )
+    {
+    ImageType::Pointer mapped = Read< ImageType >(directory + fileNames[i], i == 0 || mhaMapped);
+    if( mapped.IsNull() || !SameImages( image.GetPointer(), mapped.GetPointer() ) )
+      {
+      return EXIT_FAILURE;
+      }
+
+    // the mapped pixels may be modified
+    mapped->GetBufferPointer()[0] = 1.0f;
+    }
+
+  CharImageType::Pointer mappedChar =
+    Read< CharImageType >(directory + "/itkMetaImageIOMemoryMappingTestChar.mha", true);
+  if( mappedChar.IsNull() || !SameImages( charImage.GetPointer(), mappedChar.GetPointer() ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  VectorImageType::Pointer mappedVector =
+    Read< VectorImageType >(vectorFileName, vectorMapped);
+  if( mappedVector.IsNull() || !SameImages( vectorImage.GetPointer(), mappedVector.GetPointer() ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // compressed pixels and pixels to convert are read
+  ImageType::Pointer decompressed =
+    Read< ImageType >(directory + "/itkMetaImageIOMemoryMappingTestCompressed.mha", false);
+  ShortImageType::Pointer converted = Read< ShortImageType >(mhaFileName, false);
+  if( decompressed.IsNull() || !SameImages( image.GetPointer(), decompressed.GetPointer() ) || converted.IsNull() )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // the file was not changed through the mapping
+  ImageType::Pointer reread =
+    Read< ImageType >(directory + "/itkMetaImageIOMemoryMappingTest.mhd", true);
+  if( reread.IsNull() || reread->GetBufferPointer()[0] != image->GetBufferPointer()[0] )
+    {
+    std::cerr << "The file was modified through the mapping" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -65,6 +65,22 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) ITK_OVERRIDE;
 
+  /** Returns true if the file that was read can be read in slabs along
+   * its last dimension: when its pixels are raw or gzip encoded in a
+   * single data file, with their components on the fastest axis. Raw
+   * slabs are read at their offset, gzip ones are decoded up to their
+   * end only. */
+  virtual bool CanStreamRead() ITK_OVERRIDE
+  {
+    return m_CanStreamRead;
+  }
+
+  /** Returns the slab of whole slices along the last dimension that
+   * contains the requested region, when streamed reading is used and
+   * possible, and the largest possible region otherwise. */
+  virtual ImageIORegion
+  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const ITK_OVERRIDE;
+
   /** Determine the file type. Returns true if this ImageIO can write the
    * file specified. */
   virtual bool CanWriteFile(const char *) ITK_OVERRIDE;
@@ -90,6 +106,16 @@ protected:
 private:
   NrrdImageIO(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
+
+  /** Read the slab of the IO region from the data file. Returns false
+   * if the IO region is not a slab smaller than the image. */
+  bool ReadSlab(void *buffer);
+
+  bool        m_CanStreamRead;
+  std::string m_DataFileName;
+  SizeType    m_DataFileOffset;
+  bool        m_DataFileGzipEncoded;
+  SizeType    m_DataByteSkip;
 };
 } // end namespace itk
 
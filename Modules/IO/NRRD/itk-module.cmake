@@ -7,6 +7,7 @@ itk_module(ITKIONRRD
   DEPENDS
     ITKNrrdIO
     ITKIOImageBase
+    ITKZLIB
   TEST_DEPENDS
     ITKTestKernel
   DESCRIPTION
@@ -22,12 +22,112 @@
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkByteSwapper.h"
+#include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
 
 namespace itk
 {
 #define KEY_PREFIX "NRRD_"
 
-NrrdImageIO::NrrdImageIO()
+namespace
+{
+// Decode the bytes [skip, skip + size) of the gzip stream that starts at
+// the current position of the file, leaving the bytes after them encoded.
+bool ReadGzipEncodedBytes(std::istream & file, ImageIOBase::SizeType skip, char *data, ImageIOBase::SizeType size)
+{
+  const ImageIOBase::SizeType chunkSize = 1 << 16;
+
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+  // accept a gzip or a zlib header
+  if ( inflateInit2(&stream, 32 + MAX_WBITS) != Z_OK )
+    {
+    return false;
+    }
+
+  std::vector< char > input(chunkSize);
+  std::vector< char > skipped( std::min(skip, chunkSize) + 1 );
+  bool                ok = true;
+  while ( ok && ( skip > 0 || size > 0 ) )
+    {
+    if ( stream.avail_in == 0 )
+      {
+      file.read( &input[0], chunkSize );
+      if ( file.gcount() <= 0 )
+        {
+        ok = false;
+        break;
+        }
+      stream.next_in = reinterpret_cast< Bytef * >( &input[0] );
+      stream.avail_in = static_cast< uInt >( file.gcount() );
+      }
+
+    // the bytes before the requested ones are decoded in a scratch buffer
+    if ( skip > 0 )
+      {
+      stream.next_out = reinterpret_cast< Bytef * >( &skipped[0] );
+      stream.avail_out = static_cast< uInt >( std::min(skip, chunkSize) );
+      }
+    else
+      {
+      stream.next_out = reinterpret_cast< Bytef * >( data );
+      stream.avail_out = static_cast< uInt >( std::min( size, static_cast< ImageIOBase::SizeType >( 1 << 30 ) ) );
+      }
+    const uInt                  availableOutput = stream.avail_out;
+    const int                   result = inflate(&stream, Z_NO_FLUSH);
+    const ImageIOBase::SizeType decoded = availableOutput - stream.avail_out;
+    if ( skip > 0 )
+      {
+      skip -= decoded;
+      }
+    else
+      {
+      data += decoded;
+      size -= decoded;
+      }
+
+    if ( result == Z_STREAM_END )
+      {
+      // the data may continue in a concatenated gzip member
+      ok = ( inflateReset(&stream) == Z_OK );
+      }
+    else if ( result != Z_OK )
+      {
+      ok = false;
+      }
+    }
+
+  inflateEnd(&stream);
+  return ok;
+}
+
+template< typename T >
+void SwapRangeFromFileByteOrder(void *buffer, ImageIOBase::SizeType number, bool bigEndian)
+{
+  T *components = static_cast< T * >( buffer );
+  const typename ByteSwapper< T >::BufferSizeType numberOfComponents =
+    static_cast< typename ByteSwapper< T >::BufferSizeType >( number );
+  if ( bigEndian )
+    {
+    ByteSwapper< T >::SwapRangeFromSystemToBigEndian(components, numberOfComponents);
+    }
+  else
+    {
+    ByteSwapper< T >::SwapRangeFromSystemToLittleEndian(components, numberOfComponents);
+    }
+}
+}
+
+NrrdImageIO::NrrdImageIO() :
+  m_CanStreamRead(false),
+  m_DataFileOffset(0),
+  m_DataFileGzipEncoded(false),
+  m_DataByteSkip(0)
 {
   this->SetNumberOfDimensions(3);
   this->AddSupportedWriteExtension(".nrrd");
@@ -55,6 +155,7 @@ bool NrrdImageIO::SupportsDimension(unsigned long dim)
 void NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "CanStreamRead: " << m_CanStreamRead << std::endl;
 }
 
 ImageIOBase::IOComponentType
@@ -230,6 +331,12 @@ void NrrdImageIO::ReadImageInformation()
   // image origin
   // meta data dictionary information
 
+  m_CanStreamRead = false;
+  m_DataFileName.clear();
+  m_DataFileOffset = 0;
+  m_DataFileGzipEncoded = false;
+  m_DataByteSkip = 0;
+
   Nrrd *       nrrd = nrrdNew();
   NrrdIoState *nio = nrrdIoStateNew();
 
@@ -240,8 +347,10 @@ void NrrdImageIO::ReadImageInformation()
     FloatingPointExceptions::Disable();
 
     // this is the mechanism by which we tell nrrdLoad to read
-    // just the header, and none of the data
+    // just the header, and none of the data; a single data file is kept
+    // open at the start of the data, so that we can locate it
     nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+    nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
     if ( nrrdLoad(nrrd, this->GetFileName(), nio) != 0 )
       {
       char *err = biffGetDone(NRRD);
@@ -258,6 +367,35 @@ void NrrdImageIO::ReadImageInformation()
     // restore state
     FloatingPointExceptions::SetEnabled(saveFPEState);
 
+    if ( nio->dataFile )
+      {
+      const long dataFileOffset = ftell(nio->dataFile);
+      nio->dataFile = airFclose(nio->dataFile);
+
+      // bytes are skipped before raw data, but within gzip encoded data
+      const bool gzipEncoded = ( nio->encoding == nrrdEncodingGzip );
+      if ( dataFileOffset >= 0 && !nio->dataFNFormat
+           && ( nio->encoding == nrrdEncodingRaw || ( gzipEncoded && nio->byteSkip >= 0 ) ) )
+        {
+        if ( nio->dataFNArr->len == 0 )
+          {
+          // attached data
+          m_DataFileName = this->GetFileName();
+          }
+        else if ( nio->dataFNArr->len == 1 && strcmp(nio->dataFN[0], "-") )
+          {
+          m_DataFileName = nio->dataFN[0];
+          if ( !itksys::SystemTools::FileIsFullPath( m_DataFileName.c_str() ) )
+            {
+            m_DataFileName = std::string(nio->path) + "/" + m_DataFileName;
+            }
+          }
+        m_DataFileOffset = dataFileOffset;
+        m_DataFileGzipEncoded = gzipEncoded;
+        m_DataByteSkip = gzipEncoded ? nio->byteSkip : 0;
+        }
+      }
+
     if ( nrrdTypeBlock == nrrd->type )
       {
       itkExceptionMacro("ReadImageInformation: Cannot currently "
@@ -680,6 +818,12 @@ void NrrdImageIO::ReadImageInformation()
                                                                   msrFrame);
       }
 
+    // slabs are read as is only when the pixels of the file are laid out
+    // as in the buffer
+    m_CanStreamRead = !m_DataFileName.empty()
+                      && ( 0 == rangeAxisNum || 0 == rangeAxisIdx[0] )
+                      && ImageIOBase::SYMMETRICSECONDRANKTENSOR != this->GetPixelType();
+
     nrrd = nrrdNix(nrrd);
     nio = nrrdIoStateNix(nio);
     }
@@ -696,6 +840,11 @@ void NrrdImageIO::ReadImageInformation()
 
 void NrrdImageIO::Read(void *buffer)
 {
+  if ( m_CanStreamRead && this->ReadSlab(buffer) )
+    {
+    return;
+    }
+
   Nrrd *       nrrd = nrrdNew();
   bool         nrrdAllocated;
 
@@ -828,6 +977,97 @@ void NrrdImageIO::Read(void *buffer)
     }
 }
 
+bool NrrdImageIO::ReadSlab(void *buffer)
+{
+  const unsigned int    numberOfDimensions = this->GetNumberOfDimensions();
+  const ImageIORegion & region = this->GetIORegion();
+
+  if ( numberOfDimensions < 2 || region.GetImageDimension() < numberOfDimensions )
+    {
+    return false;
+    }
+
+  // whole slices along the last dimension, but not all of them
+  SizeType sliceSize = this->GetPixelSize();
+  for ( unsigned int i = 0; i + 1 < numberOfDimensions; i++ )
+    {
+    if ( region.GetIndex(i) != 0 || region.GetSize(i) != this->GetDimensions(i) )
+      {
+      return false;
+      }
+    sliceSize *= this->GetDimensions(i);
+    }
+  const unsigned int lastDimension = numberOfDimensions - 1;
+  if ( region.GetSize(lastDimension) >= this->GetDimensions(lastDimension) )
+    {
+    return false;
+    }
+  const SizeType slabOffset = region.GetIndex(lastDimension) * sliceSize;
+  const SizeType slabSize = static_cast< SizeType >( region.GetSize(lastDimension) ) * sliceSize;
+
+  std::ifstream file;
+  this->OpenFileForReading(file, m_DataFileName);
+  if ( m_DataFileGzipEncoded )
+    {
+    file.seekg(m_DataFileOffset, std::ios::beg);
+    if ( file.fail()
+         || !ReadGzipEncodedBytes(file, m_DataByteSkip + slabOffset, static_cast< char * >( buffer ), slabSize) )
+      {
+      itkExceptionMacro("Read: Error decoding the slab of " << m_DataFileName);
+      }
+    }
+  else
+    {
+    file.seekg(m_DataFileOffset + slabOffset, std::ios::beg);
+    file.read(static_cast< char * >( buffer ), slabSize);
+    if ( file.fail() || file.gcount() != slabSize )
+      {
+      itkExceptionMacro("Read: Error reading the slab of " << m_DataFileName);
+      }
+    }
+
+  // like nrrdLoad, convert the pixels to the byte order of this machine
+  const SizeType numberOfComponents = slabSize / this->GetComponentSize();
+  const bool     bigEndian = ( this->GetByteOrder() == ImageIOBase::BigEndian );
+  if ( this->GetByteOrder() == ImageIOBase::BigEndian || this->GetByteOrder() == ImageIOBase::LittleEndian )
+    {
+    switch ( this->GetComponentSize() )
+      {
+      case 2:
+        SwapRangeFromFileByteOrder< uint16_t >(buffer, numberOfComponents, bigEndian);
+        break;
+      case 4:
+        SwapRangeFromFileByteOrder< uint32_t >(buffer, numberOfComponents, bigEndian);
+        break;
+      case 8:
+        SwapRangeFromFileByteOrder< uint64_t >(buffer, numberOfComponents, bigEndian);
+        break;
+      default:
+        break;
+      }
+    }
+
+  return true;
+}
+
+ImageIORegion
+NrrdImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const
+{
+  ImageIORegion streamableRegion = Superclass::GenerateStreamableReadRegionFromRequestedRegion(requested);
+
+  const unsigned int lastDimension = this->GetNumberOfDimensions() - 1;
+  if ( m_UseStreamedReading && m_CanStreamRead && lastDimension > 0
+       && lastDimension < requested.GetImageDimension()
+       && lastDimension < streamableRegion.GetImageDimension() )
+    {
+    // the slab of whole slices that contains the requested region
+    streamableRegion.SetIndex( lastDimension, requested.GetIndex(lastDimension) );
+    streamableRegion.SetSize( lastDimension, requested.GetSize(lastDimension) );
+    }
+
+  return streamableRegion;
+}
+
 bool NrrdImageIO::CanWriteFile(const char *name)
 {
   std::string filename = name;
@@ -0,0 +1,155 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkNrrdImageIO.h"
+#include "itkStreamingImageFilter.h"
+
+namespace
+{
+typedef short                      PixelType;
+typedef itk::Image< PixelType, 3 > ImageType;
+
+PixelType PixelValue(itk::SizeValueType i)
+{
+  return static_cast< PixelType >( 37 * i - 20000 );
+}
+
+// Read a file in pieces with a streaming reader, and check that the
+// pieces were smaller than the image.
+int StreamedReadTest(const ImageType *image, const std::string & fileName)
+{
+  typedef itk::ImageFileReader< ImageType >                 ReaderType;
+  typedef itk::StreamingImageFilter< ImageType, ImageType > StreamingFilterType;
+
+  itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
+  ReaderType::Pointer       reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(io);
+  reader->UseStreamingOn();
+
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( reader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(5);
+  streamer->Update();
+
+  if( !io->CanStreamRead() )
+    {
+    std::cerr << fileName << " cannot be read in slabs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::RegionType & lastPiece = reader->GetOutput()->GetBufferedRegion();
+  if( lastPiece.GetSize(2) >= image->GetLargestPossibleRegion().GetSize(2) )
+    {
+    std::cerr << fileName << " was not read in slabs: " << lastPiece << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != streamer->GetOutput()->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " of " << fileName << " was read as "
+                << streamer->GetOutput()->GetPixel( it.GetIndex() ) << " instead of " << it.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkNrrdImageIOStreamedReadTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  ImageType::RegionType region;
+  region.SetSize(0, 19);
+  region.SetSize(1, 13);
+  region.SetSize(2, 23);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+    {
+    image->GetBufferPointer()[i] = PixelValue(i);
+    }
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetImageIO( itk::NrrdImageIO::New() );
+
+  // raw data in a detached data file
+  const std::string rawFileName = directory + "/itkNrrdImageIOStreamedReadTest.nhdr";
+  writer->SetFileName(rawFileName);
+  writer->Update();
+  if( StreamedReadTest(image, rawFileName) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // gzip encoded attached data
+  const std::string gzipFileName = directory + "/itkNrrdImageIOStreamedReadTest.nrrd";
+  writer->SetFileName(gzipFileName);
+  writer->UseCompressionOn();
+  writer->Update();
+  if( StreamedReadTest(image, gzipFileName) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // big endian raw data, after a line and bytes to skip
+  const std::string bigEndianFileName = directory + "/itkNrrdImageIOStreamedReadTestBigEndian.nrrd";
+    {
+    std::ofstream file(bigEndianFileName.c_str(), std::ios::out | std::ios::binary);
+    file << "NRRD0004\n"
+         << "type: short\n"
+         << "dimension: 3\n"
+         << "sizes: 19 13 23\n"
+         << "encoding: raw\n"
+         << "endian: big\n"
+         << "line skip: 1\n"
+         << "byte skip: 3\n"
+         << "\n"
+         << "skipped line\n"
+         << "XYZ";
+    for( itk::SizeValueType i = 0; i < region.GetNumberOfPixels(); ++i )
+      {
+      const unsigned short value = static_cast< unsigned short >( PixelValue(i) );
+      const char           bytes[2] = { static_cast< char >( value >> 8 ), static_cast< char >( value & 0xff ) };
+      file.write(bytes, 2);
+      }
+    }
+  if( StreamedReadTest(image, bigEndianFileName) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -106,6 +106,10 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) ITK_OVERRIDE;
 
+  /** Binary files in the byte order of this machine are read as is,
+   * from the end of the header. */
+  virtual bool GetPixelDataFileLocation(std::string & fileName, SizeType & offset) ITK_OVERRIDE;
+
   /** Set/Get the Data mask. */
   itkGetConstReferenceMacro(ImageMask, unsigned short);
   void SetImageMask(unsigned long val)
@@ -105,6 +105,25 @@ void RawImageIO< TPixel, VImageDimension >
   m_ManualHeaderSize = true;
 }
 
+template< typename TPixel, unsigned int VImageDimension >
+bool RawImageIO< TPixel, VImageDimension >
+::GetPixelDataFileLocation(std::string & fileName, SizeType & offset)
+{
+  const ByteOrder systemByteOrder =
+    ByteSwapper< int >::SystemIsBigEndian() ? BigEndian : LittleEndian;
+
+  if ( m_FileType != Binary
+       || ( m_ByteOrder != systemByteOrder && m_ByteOrder != OrderNotApplicable
+            && this->GetComponentSize() > 1 ) )
+    {
+    return false;
+    }
+
+  fileName = m_FileName;
+  offset = static_cast< SizeType >( this->GetHeaderSize() );
+  return true;
+}
+
 template< typename TPixel, unsigned int VImageDimension >
 void RawImageIO< TPixel, VImageDimension >
 ::Read(void *buffer)
@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+#include "itkRawImageIO.h"
+#include "itkImageFileReader.h"
+#include "itkMemoryMappedImportImageContainer.h"
+
+int itkRawImageIOMemoryMappingTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file.raw" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef short                                                                  PixelType;
+  typedef itk::Image< PixelType, 2 >                                             ImageType;
+  typedef itk::RawImageIO< PixelType, 2 >                                        RawImageIOType;
+  typedef itk::ImageFileReader< ImageType >                                      ReaderType;
+  typedef itk::MemoryMappedImportImageContainer< itk::SizeValueType, PixelType > MappedContainerType;
+
+  const unsigned int headerSize = 6;
+  const unsigned int size[2] = { 31, 23 };
+
+  // a header followed by the pixels in the byte order of this machine
+    {
+    std::ofstream file(argv[1], std::ios::out | std::ios::binary);
+    file.write("HEADER", headerSize);
+    for( unsigned int i = 0; i < size[0] * size[1]; ++i )
+      {
+      const PixelType value = static_cast< PixelType >( 3 * i - 500 );
+      file.write(reinterpret_cast< const char * >( &value ), sizeof( PixelType ));
+      }
+    }
+
+  for( unsigned int swap = 0; swap < 2; ++swap )
+    {
+    RawImageIOType::Pointer io = RawImageIOType::New();
+    io->SetHeaderSize(headerSize);
+    io->SetDimensions(0, size[0]);
+    io->SetDimensions(1, size[1]);
+    const bool bigEndian = itk::ByteSwapper< int >::SystemIsBigEndian() != ( swap == 1 );
+    io->SetByteOrder(bigEndian ? RawImageIOType::BigEndian : RawImageIOType::LittleEndian);
+
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName(argv[1]);
+    reader->SetImageIO(io);
+    reader->UseMemoryMappingOn();
+    reader->Update();
+
+    const ImageType *output = reader->GetOutput();
+    const bool       mapped = dynamic_cast< const MappedContainerType * >( output->GetPixelContainer() ) != ITK_NULLPTR;
+    if( mapped != ( swap == 0 ) )
+      {
+      std::cerr << "Expected the pixels " << ( swap == 0 ? "to" : "not to" ) << " be mapped" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    ImageType::IndexType index;
+    index[0] = 5;
+    index[1] = 7;
+    PixelType expected = static_cast< PixelType >( 3 * ( 7 * size[0] + 5 ) - 500 );
+    if( swap == 1 )
+      {
+      itk::ByteSwapper< PixelType >::SwapFromSystemToBigEndian(&expected);
+      itk::ByteSwapper< PixelType >::SwapFromSystemToLittleEndian(&expected);
+      }
+    if( output->GetPixel(index) != expected )
+      {
+      std::cerr << "Read " << output->GetPixel(index) << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
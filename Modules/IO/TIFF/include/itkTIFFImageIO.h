@@ -69,6 +69,21 @@ public:
   /** Reads 3D data from multi-pages tiff. */
   virtual void ReadVolume(void *buffer);
 
+  /** Returns true if the rows and pages of the file that was read can
+   * be read on their own: when its orientation is top-left or
+   * bottom-left. Only the strips or tiles that contain them are then
+   * decoded. */
+  virtual bool CanStreamRead() ITK_OVERRIDE
+  {
+    return m_CanStreamRead;
+  }
+
+  /** Returns the whole rows of the pages that contain the requested
+   * region, when streamed reading is used and possible, and the largest
+   * possible region otherwise. */
+  virtual ImageIORegion
+  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const ITK_OVERRIDE;
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -170,6 +185,9 @@ private:
 
   void ReadCurrentPage(void *out, size_t pixelOffset);
 
+  // The rows of the IO region, counted from the top of a page.
+  void GetRowsToRead(unsigned int & firstRow, unsigned int & numberOfRows) const;
+
   template <typename TComponent>
   void ReadGenericImage(void *out,
                         unsigned int width,
@@ -204,6 +222,7 @@ private:
   unsigned short *m_ColorBlue;
   int             m_TotalColors;
   unsigned int    m_ImageFormat;
+  bool            m_CanStreamRead;
 };
 } // end namespace itk
 
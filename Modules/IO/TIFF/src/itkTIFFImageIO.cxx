@@ -142,9 +142,18 @@ unsigned int TIFFImageIO::GetFormat()
 void TIFFImageIO::ReadVolume(void *buffer)
 {
   const int width  = m_InternalImage->m_Width;
-  const int height = m_InternalImage->m_Height;
 
-  for ( unsigned int page = 0; page < m_InternalImage->m_NumberOfPages; page++ )
+  unsigned int firstRow;
+  unsigned int numberOfRows;
+  this->GetRowsToRead(firstRow, numberOfRows);
+
+  // the pages of the IO region, ignored subfiles aside
+  const ImageIORegion & region = this->GetIORegion();
+  const SizeValueType   firstSlice = static_cast< SizeValueType >( region.GetIndex(2) );
+  const SizeValueType   endSlice = firstSlice + region.GetSize(2);
+
+  SizeValueType slice = 0;
+  for ( unsigned int page = 0; page < m_InternalImage->m_NumberOfPages && slice < endSlice; page++ )
     {
     if ( m_InternalImage->m_IgnoredSubFiles > 0 )
       {
@@ -161,13 +170,16 @@ void TIFFImageIO::ReadVolume(void *buffer)
         }
       }
 
+    if ( slice >= firstSlice )
+      {
+      const size_t pixelOffset = static_cast<size_t>(width)
+        * static_cast<size_t>(numberOfRows)
+        * static_cast<size_t>(this->GetNumberOfComponents())
+        * static_cast<size_t>(slice - firstSlice);
 
-    const size_t pixelOffset = static_cast<size_t>(width)
-      * static_cast<size_t>(height)
-      * static_cast<size_t>(this->GetNumberOfComponents())
-      * static_cast<size_t>(page);
-
-    ReadCurrentPage(buffer, pixelOffset);
+      ReadCurrentPage(buffer, pixelOffset);
+      }
+    ++slice;
 
     TIFFReadDirectory(m_InternalImage->m_Image);
     }
@@ -211,6 +223,7 @@ TIFFImageIO::TIFFImageIO()
   m_ColorBlue   = ITK_NULLPTR;
   m_TotalColors = -1;
   m_ImageFormat = TIFFImageIO::NOFORMAT;
+  m_CanStreamRead = false;
 
   m_InternalImage = new TIFFReaderInternal;
 
@@ -443,6 +456,9 @@ void TIFFImageIO::ReadImageInformation()
     m_Origin[2] = 0.0;
     }
 
+  // rows are read on their own, from the top or from the bottom
+  m_CanStreamRead = ( m_InternalImage->m_Orientation == ORIENTATION_TOPLEFT
+                      || m_InternalImage->m_Orientation == ORIENTATION_BOTLEFT );
 }
 
 bool TIFFImageIO::CanWriteFile(const char *name)
@@ -1101,6 +1117,47 @@ void TIFFImageIO::ReadTIFFTags()
 }
 
 
+void TIFFImageIO::GetRowsToRead(unsigned int & firstRow, unsigned int & numberOfRows) const
+{
+  firstRow = 0;
+  numberOfRows = m_InternalImage->m_Height;
+
+  const ImageIORegion & region = this->GetIORegion();
+  if ( region.GetImageDimension() > 1 && region.GetIndex(1) >= 0 && region.GetSize(1) > 0
+       && static_cast< SizeValueType >( region.GetIndex(1) ) + region.GetSize(1) <= numberOfRows )
+    {
+    firstRow = static_cast< unsigned int >( region.GetIndex(1) );
+    numberOfRows = static_cast< unsigned int >( region.GetSize(1) );
+    }
+}
+
+ImageIORegion
+TIFFImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const
+{
+  ImageIORegion streamableRegion = Superclass::GenerateStreamableReadRegionFromRequestedRegion(requested);
+
+  if ( m_UseStreamedReading && m_CanStreamRead )
+    {
+    // whole rows of the requested pages; the first page only when fewer
+    // dimensions are requested
+    for ( unsigned int i = 1; i < this->GetNumberOfDimensions() && i < streamableRegion.GetImageDimension(); i++ )
+      {
+      if ( i < requested.GetImageDimension() )
+        {
+        streamableRegion.SetIndex( i, requested.GetIndex(i) );
+        streamableRegion.SetSize( i, requested.GetSize(i) );
+        }
+      else
+        {
+        streamableRegion.SetIndex(i, 0);
+        streamableRegion.SetSize(i, 1);
+        }
+      }
+    }
+
+  return streamableRegion;
+}
+
 void TIFFImageIO::ReadCurrentPage(void *buffer, size_t pixelOffset)
 {
   const int width  = m_InternalImage->m_Width;
@@ -1121,9 +1178,27 @@ void TIFFImageIO::ReadCurrentPage(void *buffer, size_t pixelOffset)
       itkExceptionMacro("Logic Error: Unexpected buffer type!")
       }
 
-    if ( !TIFFReadRGBAImageOriented(m_InternalImage->m_Image,
-                                    width, height,
-                                    tempImage, ORIENTATION_TOPLEFT, 1) )
+    // like TIFFReadRGBAImageOriented(), but for the rows to read only,
+    // which decodes the strips or tiles that contain them
+    unsigned int firstRow;
+    unsigned int numberOfRows;
+    this->GetRowsToRead(firstRow, numberOfRows);
+
+    TIFFRGBAImage rgbaImage;
+    char          emsg[1024] = "";
+    int           ok = 0;
+    if ( TIFFRGBAImageOK(m_InternalImage->m_Image, emsg)
+         && TIFFRGBAImageBegin(&rgbaImage, m_InternalImage->m_Image, 1, emsg) )
+      {
+      rgbaImage.req_orientation = ORIENTATION_TOPLEFT;
+      rgbaImage.row_offset = ( m_InternalImage->m_Orientation == ORIENTATION_BOTLEFT ) ?
+                             height - static_cast< int >( firstRow + numberOfRows ) :
+                             static_cast< int >( firstRow );
+      rgbaImage.col_offset = 0;
+      ok = TIFFRGBAImageGet(&rgbaImage, tempImage, width, numberOfRows);
+      TIFFRGBAImageEnd(&rgbaImage);
+      }
+    if ( !ok )
       {
       itkExceptionMacro(<< "Cannot read TIFF image or as a TIFF RGBA image");
       }
@@ -1221,11 +1296,31 @@ void TIFFImageIO::ReadGenericImage(void *_out,
       break;
     }
 
-  for ( int row = 0; row < (int)height; ++row )
+  // the scanlines of the rows to read, in the order of the file
+  unsigned int firstRow;
+  unsigned int numberOfRows;
+  this->GetRowsToRead(firstRow, numberOfRows);
+  const unsigned int firstScanline = ( m_InternalImage->m_Orientation == ORIENTATION_TOPLEFT ) ?
+                                     firstRow : height - ( firstRow + numberOfRows );
+
+  // codecs may not seek within a strip, so its decoding starts at its
+  // first scanline
+  uint32 rowsPerStrip = height;
+  TIFFGetFieldDefaulted(m_InternalImage->m_Image, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+  for ( unsigned int scanline = firstScanline - firstScanline % std::max< uint32 >( rowsPerStrip, 1 );
+        scanline < firstScanline; ++scanline )
+    {
+    if ( TIFFReadScanline(m_InternalImage->m_Image, buf, scanline, 0) <= 0 )
+      {
+      itkExceptionMacro(<< "Problem reading the row: " << scanline);
+      }
+    }
+
+  for ( unsigned int row = 0; row < numberOfRows; ++row )
     {
-    if ( TIFFReadScanline(m_InternalImage->m_Image, buf, row, 0) <= 0 )
+    if ( TIFFReadScanline(m_InternalImage->m_Image, buf, firstScanline + row, 0) <= 0 )
       {
-      itkExceptionMacro(<< "Problem reading the row: " << row);
+      itkExceptionMacro(<< "Problem reading the row: " << firstScanline + row);
       }
 
     if ( m_InternalImage->m_Orientation == ORIENTATION_TOPLEFT )
@@ -1234,7 +1329,7 @@ void TIFFImageIO::ReadGenericImage(void *_out,
       }
     else // bottom left
       {
-      image = out + (size_t) (width) * inc * ( height - ( row + 1 ) );
+      image = out + (size_t) (width) * inc * ( numberOfRows - ( row + 1 ) );
       }
 
     switch ( this->GetFormat() )
@@ -1378,7 +1473,11 @@ void  TIFFImageIO::RGBAImageToBuffer( void *out, const uint32_t *tempImage )
   typedef TComponent ComponentType;
 
   const int width  = m_InternalImage->m_Width;
-  const int height = m_InternalImage->m_Height;
+
+  unsigned int firstRow;
+  unsigned int numberOfRows;
+  this->GetRowsToRead(firstRow, numberOfRows);
+  const int height = static_cast< int >( numberOfRows );
 
   ComponentType *fimage = (ComponentType *)out;
 
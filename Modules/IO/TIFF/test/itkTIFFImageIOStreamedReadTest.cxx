@@ -0,0 +1,235 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <vector>
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkRGBAPixel.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTIFFImageIO.h"
+#include "itk_tiff.h"
+
+namespace
+{
+const unsigned int Width = 45;
+const unsigned int Height = 38;
+
+unsigned char FileValue(unsigned int x, unsigned int row)
+{
+  return static_cast< unsigned char >( ( 7 * x + 13 * row ) % 251 );
+}
+
+// Write a grayscale TIFF whose rows are stored from the bottom, in
+// strips of 5 rows or in tiles of 16 x 16 pixels.
+bool WriteBottomLeftTIFF(const std::string & fileName, bool tiled)
+{
+  TIFF *tiff = TIFFOpen(fileName.c_str(), "w");
+  if( !tiff )
+    {
+    return false;
+    }
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, Width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, Height);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_BOTLEFT);
+  TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_PACKBITS);
+
+  bool ok = true;
+  if( tiled )
+    {
+    const unsigned int tileSize = 16;
+    TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileSize);
+    TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileSize);
+    std::vector< unsigned char > tile(tileSize * tileSize);
+    for( unsigned int y0 = 0; y0 < Height; y0 += tileSize )
+      {
+      for( unsigned int x0 = 0; x0 < Width; x0 += tileSize )
+        {
+        for( unsigned int y = 0; y < tileSize; ++y )
+          {
+          for( unsigned int x = 0; x < tileSize; ++x )
+            {
+            tile[y * tileSize + x] = FileValue(x0 + x, y0 + y);
+            }
+          }
+        ok = ok && TIFFWriteTile(tiff, &tile[0], x0, y0, 0, 0) >= 0;
+        }
+      }
+    }
+  else
+    {
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 5);
+    std::vector< unsigned char > scanline(Width);
+    for( unsigned int row = 0; row < Height; ++row )
+      {
+      for( unsigned int x = 0; x < Width; ++x )
+        {
+        scanline[x] = FileValue(x, row);
+        }
+      ok = ok && TIFFWriteScanline(tiff, &scanline[0], row, 0) >= 0;
+      }
+    }
+  TIFFClose(tiff);
+  return ok;
+}
+
+// Read a file at once, or in pieces with a streaming reader while
+// checking that the pieces were smaller than the image.
+template< typename TImage >
+typename TImage::Pointer Read(const std::string & fileName, bool streamed)
+{
+  typedef itk::ImageFileReader< TImage >              ReaderType;
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamingFilterType;
+
+  itk::TIFFImageIO::Pointer    io = itk::TIFFImageIO::New();
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(io);
+  reader->SetUseStreaming(streamed);
+
+  typename StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( reader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(streamed ? 4 : 1);
+  streamer->Update();
+
+  const unsigned int lastDimension = TImage::ImageDimension - 1;
+  if( streamed && ( !io->CanStreamRead()
+                    || reader->GetOutput()->GetBufferedRegion().GetSize(lastDimension)
+                    >= reader->GetOutput()->GetLargestPossibleRegion().GetSize(lastDimension) ) )
+    {
+    std::cerr << fileName << " was not streamed" << std::endl;
+    return ITK_NULLPTR;
+    }
+
+  typename TImage::Pointer output = streamer->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+template< typename TImage >
+bool SameImages(const TImage *image1, const TImage *image2)
+{
+  if( !image1 || !image2 )
+    {
+    return false;
+    }
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( image1, image1->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != image2->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " differs" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkTIFFImageIOStreamedReadTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  // the rows of the files are stored from the bottom
+  typedef itk::Image< unsigned char, 2 >                  GrayImageType;
+  typedef itk::Image< itk::RGBAPixel< unsigned char >, 2 > RGBAImageType;
+
+  GrayImageType::RegionType region;
+  region.SetSize(0, Width);
+  region.SetSize(1, Height);
+  GrayImageType::Pointer expected = GrayImageType::New();
+  expected->SetRegions(region);
+  expected->Allocate();
+  RGBAImageType::Pointer expectedRGBA = RGBAImageType::New();
+  expectedRGBA->SetRegions(region);
+  expectedRGBA->Allocate();
+  itk::ImageRegionConstIteratorWithIndex< GrayImageType > it( expected, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const GrayImageType::IndexType & index = it.GetIndex();
+    const unsigned char              value = FileValue(index[0], Height - 1 - index[1]);
+    expected->SetPixel(index, value);
+    itk::RGBAPixel< unsigned char > rgba;
+    rgba.Set(value, value, value, 255);
+    expectedRGBA->SetPixel(index, rgba);
+    }
+
+  // strips are read scanline by scanline
+  const std::string stripsFileName = directory + "/itkTIFFImageIOStreamedReadTestStrips.tif";
+  if( !WriteBottomLeftTIFF(stripsFileName, false) )
+    {
+    std::cerr << "Cannot write " << stripsFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !SameImages< GrayImageType >( expected, Read< GrayImageType >( stripsFileName, false ) )
+      || !SameImages< GrayImageType >( expected, Read< GrayImageType >( stripsFileName, true ) ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // tiles are read as RGBA images
+  const std::string tilesFileName = directory + "/itkTIFFImageIOStreamedReadTestTiles.tif";
+  if( !WriteBottomLeftTIFF(tilesFileName, true) )
+    {
+    std::cerr << "Cannot write " << tilesFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( !SameImages< RGBAImageType >( expectedRGBA, Read< RGBAImageType >( tilesFileName, false ) )
+      || !SameImages< RGBAImageType >( expectedRGBA, Read< RGBAImageType >( tilesFileName, true ) ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // pages of a multipage file
+  typedef itk::Image< unsigned short, 3 > VolumeType;
+  VolumeType::RegionType volumeRegion;
+  volumeRegion.SetSize(0, 21);
+  volumeRegion.SetSize(1, 17);
+  volumeRegion.SetSize(2, 9);
+  VolumeType::Pointer volume = VolumeType::New();
+  volume->SetRegions(volumeRegion);
+  volume->Allocate();
+  for( itk::SizeValueType i = 0; i < volumeRegion.GetNumberOfPixels(); ++i )
+    {
+    volume->GetBufferPointer()[i] = static_cast< unsigned short >( 97 * i );
+    }
+
+  const std::string pagesFileName = directory + "/itkTIFFImageIOStreamedReadTestPages.tif";
+  typedef itk::ImageFileWriter< VolumeType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(volume);
+  writer->SetImageIO( itk::TIFFImageIO::New() );
+  writer->SetFileName(pagesFileName);
+  writer->Update();
+  if( !SameImages< VolumeType >( volume, Read< VolumeType >( pagesFileName, true ) ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
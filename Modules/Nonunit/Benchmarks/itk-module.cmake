@@ -0,0 +1,18 @@
+set(DOCUMENTATION "This module contains benchmarks that time a fixed suite of
+filters on synthetic volumes of several sizes for an increasing number of
+threads, and report the throughput and peak memory usage as JSON so that
+performance can be tracked across versions of the toolkit.")
+
+itk_module(ITKBenchmarks
+  TEST_DEPENDS
+    ITKCommon
+    ITKConnectedComponents
+    ITKImageGrid
+    ITKMetricsv4
+    ITKSmoothing
+    ITKTestKernel
+    ITKTransform
+  EXCLUDE_FROM_DEFAULT
+  DESCRIPTION
+    "${DOCUMENTATION}"
+)
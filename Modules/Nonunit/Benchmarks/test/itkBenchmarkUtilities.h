@@ -0,0 +1,282 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBenchmarkUtilities_h
+#define itkBenchmarkUtilities_h
+
+#include "itkImageRegionIterator.h"
+#include "itkMath.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace itk
+{
+/** Size of a synthetic benchmark volume. It is parsed from "N" for a
+ * N x N x N volume, or from "XxYxZ". */
+struct BenchmarkVolumeSize
+{
+  SizeValueType m_Size[3];
+
+  BenchmarkVolumeSize()
+  {
+    m_Size[0] = m_Size[1] = m_Size[2] = 0;
+  }
+
+  bool Parse(const std::string & text)
+  {
+    std::vector< SizeValueType > values;
+    std::istringstream           stream(text);
+    std::string                  item;
+    while( std::getline(stream, item, 'x') )
+      {
+      const long value = atol( item.c_str() );
+      if( value <= 0 )
+        {
+        return false;
+        }
+      values.push_back( static_cast< SizeValueType >( value ) );
+      }
+    if( values.size() == 1 )
+      {
+      m_Size[0] = m_Size[1] = m_Size[2] = values[0];
+      return true;
+      }
+    if( values.size() == 3 )
+      {
+      m_Size[0] = values[0];
+      m_Size[1] = values[1];
+      m_Size[2] = values[2];
+      return true;
+      }
+    return false;
+  }
+
+  SizeValueType GetNumberOfPixels() const
+  {
+    return m_Size[0] * m_Size[1] * m_Size[2];
+  }
+
+  std::string ToString() const
+  {
+    std::ostringstream stream;
+    stream << m_Size[0] << "x" << m_Size[1] << "x" << m_Size[2];
+    return stream.str();
+  }
+};
+
+/** Fill a 3D image of the given size with a deterministic pattern: a
+ * sum of one periodic profile per axis, shifted by phase, plus a small
+ * hashed noise. The pattern has structure at several scales, so that
+ * thresholding it gives many connected components of varied shapes. */
+template< typename TImage >
+typename TImage::Pointer
+GenerateBenchmarkVolume(const BenchmarkVolumeSize & volumeSize, double phase = 0.0)
+{
+  typename TImage::SizeType size;
+  for( unsigned int d = 0; d < 3; ++d )
+    {
+    size[d] = volumeSize.m_Size[d];
+    }
+  typename TImage::RegionType region;
+  region.SetSize(size);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  // per axis profiles, so that the fill costs a few additions per pixel
+  std::vector< double > profile[3];
+  const double          frequency[3] = { 0.071, 0.053, 0.097 };
+  for( unsigned int d = 0; d < 3; ++d )
+    {
+    profile[d].resize(size[d]);
+    for( SizeValueType i = 0; i < size[d]; ++i )
+      {
+      profile[d][i] = 40.0 * std::sin( frequency[d] * i + phase )
+                      + 20.0 * std::sin( 0.31 * frequency[d] * i + 2.0 * phase );
+      }
+    }
+
+  ImageRegionIterator< TImage > it(image, region);
+  unsigned int                  hash = 2166136261u;
+  for( SizeValueType z = 0; z < size[2]; ++z )
+    {
+    for( SizeValueType y = 0; y < size[1]; ++y )
+      {
+      const double planeValue = 128.0 + profile[2][z] + profile[1][y];
+      for( SizeValueType x = 0; x < size[0]; ++x )
+        {
+        hash = hash * 1664525u + 1013904223u;
+        const double noise = static_cast< double >( hash >> 24 ) / 32.0 - 4.0;
+        it.Set( static_cast< typename TImage::PixelType >( planeValue + profile[0][x] + noise ) );
+        ++it;
+        }
+      }
+    }
+  return image;
+}
+
+/** Peak resident set size of the process, in bytes, or 0 when it is not
+ * available on the platform. The value is a high water mark: it never
+ * decreases during the life of the process, so it covers everything the
+ * process ran so far, not only the last measurement. */
+inline unsigned long long GetProcessPeakResidentSetSize()
+{
+#if defined( _WIN32 )
+  PROCESS_MEMORY_COUNTERS counters;
+  if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    {
+    return static_cast< unsigned long long >( counters.PeakWorkingSetSize );
+    }
+  return 0;
+#else
+  struct rusage usage;
+  if( getrusage(RUSAGE_SELF, &usage) != 0 )
+    {
+    return 0;
+    }
+#if defined( __APPLE__ )
+  // bytes on Mac OS X
+  return static_cast< unsigned long long >( usage.ru_maxrss );
+#else
+  // kilobytes on Linux and the BSDs
+  return static_cast< unsigned long long >( usage.ru_maxrss ) * 1024;
+#endif
+#endif
+}
+
+/** One timed configuration of the benchmark suite. */
+struct BenchmarkRecord
+{
+  std::string        m_Filter;
+  std::string        m_Size;
+  SizeValueType      m_NumberOfPixels;
+  ThreadIdType       m_NumberOfThreads;
+  unsigned int       m_NumberOfRepetitions;
+  double             m_MinimumSeconds;
+  double             m_MeanSeconds;
+  // peak of the process up to the end of this configuration, including
+  // the configurations run before it
+  unsigned long long m_ProcessPeakResidentSetSize;
+};
+
+/** Collects the records of a benchmark run and writes them as JSON. */
+class BenchmarkReport
+{
+public:
+  void AddRecord(const BenchmarkRecord & record)
+  {
+    m_Records.push_back(record);
+  }
+
+  void AddProperty(const std::string & name, const std::string & value)
+  {
+    m_Properties.push_back( std::make_pair(name, value) );
+  }
+
+  bool Write(const std::string & fileName) const
+  {
+    std::ofstream file( fileName.c_str() );
+    if( !file )
+      {
+      return false;
+      }
+    this->Write(file);
+    return !file.fail();
+  }
+
+  void Write(std::ostream & os) const
+  {
+    os << "{\n";
+    for( size_t i = 0; i < m_Properties.size(); ++i )
+      {
+      os << "  " << Quote(m_Properties[i].first) << ": " << Quote(m_Properties[i].second) << ",\n";
+      }
+    os << "  \"results\": [";
+    for( size_t i = 0; i < m_Records.size(); ++i )
+      {
+      const BenchmarkRecord & record = m_Records[i];
+      const double            voxelsPerSecond = record.m_MinimumSeconds > 0.0
+        ? record.m_NumberOfPixels / record.m_MinimumSeconds : 0.0;
+      os << ( i == 0 ? "\n" : ",\n" );
+      os << "    {\"filter\": " << Quote(record.m_Filter)
+         << ", \"size\": " << Quote(record.m_Size)
+         << ", \"voxels\": " << record.m_NumberOfPixels
+         << ", \"threads\": " << record.m_NumberOfThreads
+         << ", \"repetitions\": " << record.m_NumberOfRepetitions
+         << ", \"seconds_min\": " << Number(record.m_MinimumSeconds)
+         << ", \"seconds_mean\": " << Number(record.m_MeanSeconds)
+         << ", \"voxels_per_second\": " << Number(voxelsPerSecond)
+         << ", \"process_peak_rss_bytes\": " << record.m_ProcessPeakResidentSetSize
+         << "}";
+      }
+    os << "\n  ]\n}\n";
+  }
+
+private:
+  static std::string Quote(const std::string & text)
+  {
+    std::string quoted = "\"";
+    for( size_t i = 0; i < text.size(); ++i )
+      {
+      const char c = text[i];
+      if( c == '"' || c == '\\' )
+        {
+        quoted += '\\';
+        quoted += c;
+        }
+      else if( static_cast< unsigned char >( c ) < 0x20 )
+        {
+        char escaped[8];
+        sprintf( escaped, "\\u%04x", static_cast< unsigned int >( c ) );
+        quoted += escaped;
+        }
+      else
+        {
+        quoted += c;
+        }
+      }
+    return quoted + "\"";
+  }
+
+  static std::string Number(double value)
+  {
+    char buffer[32];
+    sprintf(buffer, "%.6g", value);
+    return buffer;
+  }
+
+  std::vector< BenchmarkRecord >                         m_Records;
+  std::vector< std::pair< std::string, std::string > >   m_Properties;
+};
+} // end namespace itk
+
+#endif
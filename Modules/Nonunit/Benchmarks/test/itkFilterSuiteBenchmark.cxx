@@ -0,0 +1,348 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Times a fixed suite of filters on synthetic volumes, for 1, 2, 4, ...
+// up to N threads, and writes the throughput and the peak resident set
+// size of the process as JSON. The peak is cumulative: each record holds
+// the highest peak of the configurations run so far, not its own.
+//
+//   ITKBenchmarksTestDriver itkFilterSuiteBenchmark output.json
+//     [--sizes 256,512,1024x1024x300] [--threads N] [--repetitions R]
+//     [--filters Resample,DiscreteGaussian,MattesMutualInformation,ConnectedComponent]
+
+#include "itkBenchmarkUtilities.h"
+
+#include "itkConnectedComponentImageFilter.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkEuler3DTransform.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMultiThreader.h"
+#include "itkResampleImageFilter.h"
+#include "itkTimeProbe.h"
+#include "itkTranslationTransform.h"
+#include "itkVersion.h"
+
+#include <iomanip>
+
+namespace
+{
+typedef itk::Image< float, 3 >         BenchmarkImageType;
+typedef itk::Image< unsigned char, 3 > BenchmarkMaskType;
+typedef itk::Image< unsigned int, 3 >  BenchmarkLabelType;
+
+/** The volumes shared by all the filters of one size. */
+struct BenchmarkInputs
+{
+  BenchmarkImageType::Pointer m_Fixed;
+  BenchmarkImageType::Pointer m_Moving;
+  BenchmarkMaskType::Pointer  m_Mask;
+};
+
+/** Each benchmark builds its pipeline, then times only the execution. */
+typedef double (*BenchmarkFunctionType)(const BenchmarkInputs &, itk::ThreadIdType);
+
+double ResampleBenchmark(const BenchmarkInputs & inputs, itk::ThreadIdType numberOfThreads)
+{
+  typedef itk::Euler3DTransform< double > TransformType;
+  TransformType::Pointer transform = TransformType::New();
+
+  const BenchmarkImageType::RegionType region = inputs.m_Fixed->GetLargestPossibleRegion();
+  BenchmarkImageType::IndexType        centerIndex;
+  for( unsigned int d = 0; d < 3; ++d )
+    {
+    centerIndex[d] = region.GetIndex(d) + static_cast< itk::IndexValueType >( region.GetSize(d) / 2 );
+    }
+  TransformType::InputPointType center;
+  inputs.m_Fixed->TransformIndexToPhysicalPoint(centerIndex, center);
+  transform->SetCenter(center);
+  transform->SetRotation(0.05, -0.03, 0.08);
+  TransformType::OutputVectorType translation;
+  translation.Fill(1.5);
+  transform->SetTranslation(translation);
+
+  typedef itk::ResampleImageFilter< BenchmarkImageType, BenchmarkImageType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(inputs.m_Fixed);
+  filter->SetTransform(transform);
+  filter->SetOutputParametersFromImage(inputs.m_Fixed);
+  filter->SetNumberOfThreads(numberOfThreads);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  filter->Update();
+  probe.Stop();
+  return probe.GetTotal();
+}
+
+double DiscreteGaussianBenchmark(const BenchmarkInputs & inputs, itk::ThreadIdType numberOfThreads)
+{
+  typedef itk::DiscreteGaussianImageFilter< BenchmarkImageType, BenchmarkImageType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(inputs.m_Fixed);
+  filter->SetVariance(4.0);
+  filter->SetMaximumKernelWidth(32);
+  filter->SetNumberOfThreads(numberOfThreads);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  filter->Update();
+  probe.Stop();
+  return probe.GetTotal();
+}
+
+double MattesMutualInformationBenchmark(const BenchmarkInputs & inputs, itk::ThreadIdType numberOfThreads)
+{
+  typedef itk::TranslationTransform< double, 3 > TransformType;
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetIdentity();
+
+  typedef itk::MattesMutualInformationImageToImageMetricv4< BenchmarkImageType, BenchmarkImageType > MetricType;
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage(inputs.m_Fixed);
+  metric->SetMovingImage(inputs.m_Moving);
+  metric->SetMovingTransform(transform);
+  metric->SetNumberOfHistogramBins(32);
+  metric->SetMaximumNumberOfThreads(numberOfThreads);
+  metric->Initialize();
+
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+
+  itk::TimeProbe probe;
+  probe.Start();
+  metric->GetValueAndDerivative(value, derivative);
+  probe.Stop();
+  return probe.GetTotal();
+}
+
+double ConnectedComponentBenchmark(const BenchmarkInputs & inputs, itk::ThreadIdType numberOfThreads)
+{
+  typedef itk::ConnectedComponentImageFilter< BenchmarkMaskType, BenchmarkLabelType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(inputs.m_Mask);
+  filter->SetNumberOfThreads(numberOfThreads);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  filter->Update();
+  probe.Stop();
+  return probe.GetTotal();
+}
+
+struct BenchmarkDescription
+{
+  const char           *m_Name;
+  BenchmarkFunctionType m_Function;
+};
+
+const BenchmarkDescription benchmarkSuite[] =
+{
+  { "Resample",                ResampleBenchmark },
+  { "DiscreteGaussian",        DiscreteGaussianBenchmark },
+  { "MattesMutualInformation", MattesMutualInformationBenchmark },
+  { "ConnectedComponent",      ConnectedComponentBenchmark }
+};
+const unsigned int benchmarkSuiteSize = sizeof( benchmarkSuite ) / sizeof( benchmarkSuite[0] );
+
+std::vector< std::string > SplitList(const std::string & text)
+{
+  std::vector< std::string > items;
+  std::istringstream         stream(text);
+  std::string                item;
+  while( std::getline(stream, item, ',') )
+    {
+    if( !item.empty() )
+      {
+      items.push_back(item);
+      }
+    }
+  return items;
+}
+
+int Usage(const char *name)
+{
+  std::cerr << "Usage: " << name << " output.json [--sizes 256,512,1024x1024x300]"
+            << " [--threads N] [--repetitions R] [--filters ";
+  for( unsigned int i = 0; i < benchmarkSuiteSize; ++i )
+    {
+    std::cerr << ( i ? "," : "" ) << benchmarkSuite[i].m_Name;
+    }
+  std::cerr << "]" << std::endl;
+  return EXIT_FAILURE;
+}
+}
+
+int itkFilterSuiteBenchmark(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    return Usage(argv[0]);
+    }
+  const std::string outputFileName = argv[1];
+
+  std::vector< std::string > sizeList = SplitList("256,512,1024x1024x300");
+  itk::ThreadIdType          maximumNumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  unsigned int               numberOfRepetitions = 3;
+  std::vector< std::string > filterList;
+  for( unsigned int i = 0; i < benchmarkSuiteSize; ++i )
+    {
+    filterList.push_back(benchmarkSuite[i].m_Name);
+    }
+
+  for( int arg = 2; arg < argc; arg += 2 )
+    {
+    const std::string option = argv[arg];
+    if( arg + 1 >= argc )
+      {
+      return Usage(argv[0]);
+      }
+    const std::string value = argv[arg + 1];
+    if( option == "--sizes" )
+      {
+      sizeList = SplitList(value);
+      }
+    else if( option == "--threads" )
+      {
+      maximumNumberOfThreads = static_cast< itk::ThreadIdType >( atoi( value.c_str() ) );
+      }
+    else if( option == "--repetitions" )
+      {
+      numberOfRepetitions = static_cast< unsigned int >( atoi( value.c_str() ) );
+      }
+    else if( option == "--filters" )
+      {
+      filterList = SplitList(value);
+      }
+    else
+      {
+      return Usage(argv[0]);
+      }
+    }
+
+  std::vector< itk::BenchmarkVolumeSize > sizes( sizeList.size() );
+  for( size_t i = 0; i < sizeList.size(); ++i )
+    {
+    if( !sizes[i].Parse(sizeList[i]) )
+      {
+      std::cerr << "Invalid volume size: " << sizeList[i] << std::endl;
+      return Usage(argv[0]);
+      }
+    }
+  std::vector< const BenchmarkDescription * > filters;
+  for( size_t i = 0; i < filterList.size(); ++i )
+    {
+    const BenchmarkDescription *description = ITK_NULLPTR;
+    for( unsigned int j = 0; j < benchmarkSuiteSize; ++j )
+      {
+      if( filterList[i] == benchmarkSuite[j].m_Name )
+        {
+        description = &benchmarkSuite[j];
+        }
+      }
+    if( description == ITK_NULLPTR )
+      {
+      std::cerr << "Unknown filter: " << filterList[i] << std::endl;
+      return Usage(argv[0]);
+      }
+    filters.push_back(description);
+    }
+  if( maximumNumberOfThreads < 1 || numberOfRepetitions < 1 || sizes.empty() || filters.empty() )
+    {
+    return Usage(argv[0]);
+    }
+
+  // 1, 2, 4, ... and the maximum
+  std::vector< itk::ThreadIdType > threadCounts;
+  for( itk::ThreadIdType threads = 1; threads < maximumNumberOfThreads; threads *= 2 )
+    {
+    threadCounts.push_back(threads);
+    }
+  threadCounts.push_back(maximumNumberOfThreads);
+
+  itk::BenchmarkReport report;
+  report.AddProperty( "itk_version", itk::Version::GetITKVersion() );
+  report.AddProperty( "benchmark", "itkFilterSuiteBenchmark" );
+
+  // Internal filters of mini-pipelines take the global default number
+  // of threads, so it follows the number of threads being measured.
+  const itk::ThreadIdType defaultNumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  std::cout << std::setw(24) << std::left << "filter" << std::setw(16) << "size"
+            << std::right << std::setw(8) << "threads" << std::setw(12) << "seconds"
+            << std::setw(16) << "Mvoxels/s" << std::setw(18) << "process peak MB" << std::endl;
+
+  for( size_t s = 0; s < sizes.size(); ++s )
+    {
+    BenchmarkInputs inputs;
+    inputs.m_Fixed = itk::GenerateBenchmarkVolume< BenchmarkImageType >(sizes[s]);
+    inputs.m_Moving = itk::GenerateBenchmarkVolume< BenchmarkImageType >(sizes[s], 0.7);
+
+    // binary input of the connected components
+    inputs.m_Mask = BenchmarkMaskType::New();
+    inputs.m_Mask->CopyInformation(inputs.m_Fixed);
+    inputs.m_Mask->SetRegions( inputs.m_Fixed->GetLargestPossibleRegion() );
+    inputs.m_Mask->Allocate();
+    itk::ImageRegionConstIterator< BenchmarkImageType > fixedIt( inputs.m_Fixed, inputs.m_Fixed->GetLargestPossibleRegion() );
+    itk::ImageRegionIterator< BenchmarkMaskType >       maskIt( inputs.m_Mask, inputs.m_Mask->GetLargestPossibleRegion() );
+    for( ; !fixedIt.IsAtEnd(); ++fixedIt, ++maskIt )
+      {
+      maskIt.Set( fixedIt.Get() > 150.0f ? 1 : 0 );
+      }
+
+    for( size_t f = 0; f < filters.size(); ++f )
+      {
+      for( size_t t = 0; t < threadCounts.size(); ++t )
+        {
+        itk::MultiThreader::SetGlobalDefaultNumberOfThreads(threadCounts[t]);
+
+        itk::BenchmarkRecord record;
+        record.m_Filter = filters[f]->m_Name;
+        record.m_Size = sizes[s].ToString();
+        record.m_NumberOfPixels = sizes[s].GetNumberOfPixels();
+        record.m_NumberOfThreads = threadCounts[t];
+        record.m_NumberOfRepetitions = numberOfRepetitions;
+        record.m_MinimumSeconds = 0.0;
+        record.m_MeanSeconds = 0.0;
+        for( unsigned int r = 0; r < numberOfRepetitions; ++r )
+          {
+          const double seconds = ( *filters[f]->m_Function )(inputs, threadCounts[t]);
+          record.m_MinimumSeconds = ( r == 0 ) ? seconds : std::min(record.m_MinimumSeconds, seconds);
+          record.m_MeanSeconds += seconds / numberOfRepetitions;
+          }
+        record.m_ProcessPeakResidentSetSize = itk::GetProcessPeakResidentSetSize();
+        report.AddRecord(record);
+
+        std::cout << std::setw(24) << std::left << record.m_Filter << std::setw(16) << record.m_Size
+                  << std::right << std::setw(8) << record.m_NumberOfThreads
+                  << std::setw(12) << record.m_MinimumSeconds
+                  << std::setw(16) << ( record.m_MinimumSeconds > 0.0
+                                        ? record.m_NumberOfPixels / record.m_MinimumSeconds / 1.0e6 : 0.0 )
+                  << std::setw(18) << record.m_ProcessPeakResidentSetSize / ( 1024 * 1024 ) << std::endl;
+        }
+      }
+    }
+
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads(defaultNumberOfThreads);
+
+  if( !report.Write(outputFileName) )
+    {
+    std::cerr << "Could not write " << outputFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -19,7 +19,7 @@
 #define itkDiscreteGaussianDerivativeImageFilter_hxx
 
 #include "itkDiscreteGaussianDerivativeImageFilter.h"
-#include "itkNeighborhoodOperatorImageFilter.h"
+#include "itkDirectionalNeighborhoodOperatorImageFilter.h"
 #include "itkGaussianDerivativeOperator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressAccumulator.h"
@@ -126,14 +126,17 @@ DiscreteGaussianDerivativeImageFilter< TInputImage, TOutputImage >
   // Middle filters convolves from real to real
   // Last filter convolves and changes type from real type to output type
   // Streaming filter forces the mini-pipeline to run in chunks
-  typedef NeighborhoodOperatorImageFilter< InputImageType,
-                                           RealOutputImageType, RealOutputPixelType > FirstFilterType;
-  typedef NeighborhoodOperatorImageFilter< RealOutputImageType,
-                                           RealOutputImageType, RealOutputPixelType > IntermediateFilterType;
-  typedef NeighborhoodOperatorImageFilter< RealOutputImageType,
-                                           OutputImageType, RealOutputPixelType > LastFilterType;
-  typedef NeighborhoodOperatorImageFilter< InputImageType,
-                                           OutputImageType, RealOutputPixelType > SingleFilterType;
+  //
+  // The operators are directional, so they are applied along the
+  // scanlines of the images
+  typedef DirectionalNeighborhoodOperatorImageFilter< InputImageType,
+                                                      RealOutputImageType, RealOutputPixelType > FirstFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< RealOutputImageType,
+                                                      RealOutputImageType, RealOutputPixelType > IntermediateFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< RealOutputImageType,
+                                                      OutputImageType, RealOutputPixelType > LastFilterType;
+  typedef DirectionalNeighborhoodOperatorImageFilter< InputImageType,
+                                                      OutputImageType, RealOutputPixelType > SingleFilterType;
   typedef StreamingImageFilter< OutputImageType, OutputImageType >
   StreamingFilterType;
 
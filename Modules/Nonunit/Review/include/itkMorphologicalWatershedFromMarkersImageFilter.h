@@ -19,6 +19,8 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkBarrier.h"
+#include <vector>
 
 namespace itk
 {
@@ -63,6 +65,17 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * By default, the flooding is sequential: the order in which the pixels
+ * are taken from the hierarchical queue defines the position of the
+ * watershed lines. With UseTiledFlooding on, the image is split into slabs
+ * along its last dimension, one per thread, which are flooded in parallel.
+ * The pixels are then flooded by increasing (level, distance on the
+ * plateau, index in the image) where the level is the highest value on the
+ * path from the markers, and the slabs exchange their borders until none of
+ * them changes. This order does not depend on the slabs, so the output
+ * does not depend on the number of threads, but it may place the watershed
+ * lines differently from the sequential flooding on the plateaus.
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -99,7 +112,9 @@ public:
   typedef typename LabelImageType::RegionType   LabelImageRegionType;
   typedef typename LabelImageType::PixelType    LabelImagePixelType;
 
-  typedef typename LabelImageType::IndexType IndexType;
+  typedef typename LabelImageType::IndexType  IndexType;
+  typedef typename LabelImageType::OffsetType OffsetType;
+  typedef typename LabelImageType::SizeType   SizeType;
 
   /** ImageDimension constants */
   itkStaticConstMacro(ImageDimension, unsigned int,
@@ -157,6 +172,16 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the image is flooded in parallel, in slabs along its
+   * last dimension. The output then does not depend on the number of
+   * threads, but may differ from the sequential flooding on the plateaus
+   * of the input image. Default is false.
+   */
+  itkSetMacro(UseTiledFlooding, bool);
+  itkGetConstReferenceMacro(UseTiledFlooding, bool);
+  itkBooleanMacro(UseTiledFlooding);
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() {}
@@ -172,17 +197,89 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
 
-  /** The filter is single threaded. */
+  /** The filter is single threaded, unless UseTiledFlooding is on. */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Flood the slabs of the image in parallel. */
+  void TiledGenerateData();
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE TiledFloodingThreaderCallback(void *arg);
+
+  /** Flood the slab of a thread until the borders of all the slabs are
+   * stable. */
+  void ThreadedTiledFlooding(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
+  /** Whether the neighbor at the given offset of a pixel is in the slices
+   * [firstSlice, lastSlice) of the image. The index is relative to the
+   * start of the region. */
+  static bool IsInside(const IndexType & index, const OffsetType & offset,
+                       const SizeType & size,
+                       OffsetValueType firstSlice, OffsetValueType lastSlice);
+
 private:
   //purposely not implemented
   MorphologicalWatershedFromMarkersImageFilter(const Self &);
   void operator=(const Self &); //purposely not implemented
 
+  /** A pixel in the priority queue of the tiled flooding, with the highest
+   * value on its path from the markers, its distance on the plateau of that
+   * value, and its offset in the buffer. */
+  struct FloodingNode
+  {
+    InputImagePixelType m_Level;
+    SizeValueType       m_Distance;
+    OffsetValueType     m_Offset;
+  };
+
+  /** The order of the flooding: by level, then distance, then offset. */
+  struct FloodingNodeLess
+  {
+    bool operator()(const FloodingNode & a, const FloodingNode & b) const
+    {
+      if ( a.m_Level < b.m_Level ) { return true; }
+      if ( b.m_Level < a.m_Level ) { return false; }
+      if ( a.m_Distance != b.m_Distance ) { return a.m_Distance < b.m_Distance; }
+      return a.m_Offset < b.m_Offset;
+    }
+  };
+
+  /** Order the nodes so that the priority queue gives the lowest first. */
+  struct FloodingNodeGreater
+  {
+    bool operator()(const FloodingNode & a, const FloodingNode & b) const
+    {
+      return FloodingNodeLess()(b, a);
+    }
+  };
+
   bool m_FullyConnected;
 
   bool m_MarkWatershedLine;
+
+  bool m_UseTiledFlooding;
+
+  // the neighbors, and their offsets in the buffer
+  std::vector< OffsetType >      m_NeighborOffsets;
+  std::vector< OffsetValueType > m_NeighborBufferOffsets;
+
+  // the levels, distances and origins of the first and last slices of
+  // each slab, which are read by the neighbor slabs
+  std::vector< InputImagePixelType > m_BorderLevels;
+  std::vector< SizeValueType >       m_BorderDistances;
+  std::vector< OffsetValueType >     m_BorderOrigins;
+  std::vector< InputImagePixelType > m_BorderOriginLevels;
+  std::vector< SizeValueType >       m_BorderOriginDistances;
+
+  // whether the borders of the neighbors of a slab changed, for each
+  // thread
+  std::vector< char > m_SlabChanged;
+
+  // whether the flooding was aborted, for each thread. The threads stop
+  // together, after the barrier which follows the reading of the borders.
+  std::vector< char > m_SlabAborted;
+
+  Barrier::Pointer m_Barrier;
 }; // end of class
 } // end namespace itk
 
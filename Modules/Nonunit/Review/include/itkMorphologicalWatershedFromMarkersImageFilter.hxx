@@ -29,6 +29,7 @@
 #include "itkConstantBoundaryCondition.h"
 #include "itkSize.h"
 #include "itkConnectedComponentAlgorithm.h"
+#include "itkMultiThreader.h"
 
 /*
  * This code was contributed in the Insight Journal paper:
@@ -48,6 +49,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   this->SetNumberOfRequiredInputs(2);
   m_FullyConnected = false;
   m_MarkWatershedLine = true;
+  m_UseTiledFlooding = false;
 }
 
 template< typename TInputImage, typename TLabelImage >
@@ -94,6 +96,12 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   // the algorithm without watershed lines is from beucher
   // The 2 algorithms are very similar and so are integrated in the same filter.
 
+  if ( m_UseTiledFlooding )
+    {
+    this->TiledGenerateData();
+    return;
+    }
+
   //---------------------------------------------------------------------------
   // declare the vars common to the 2 algorithms: constants, iterators,
   // hierarchical queue, progress reporter, and status image
@@ -154,7 +162,6 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   // iterator for the output image
   typedef ShapedNeighborhoodIterator< LabelImageType > OutputIteratorType;
-  typedef typename OutputIteratorType::OffsetType      OffsetType;
   typename OutputIteratorType::Iterator noIt;
   OutputIteratorType
   outputIt( radius, outputImage, outputImage->GetRequestedRegion() );
@@ -450,6 +457,491 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     }
 }
 
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::TiledGenerateData()
+{
+  this->AllocateOutputs();
+
+  LabelImagePointer outputImage = this->GetOutput();
+
+  // mask and marker must have the same size
+  if ( this->GetMarkerImage()->GetRequestedRegion().GetSize() != this->GetInput()->GetRequestedRegion().GetSize() )
+    {
+    itkExceptionMacro(<< "Marker and input must have the same size.");
+    }
+
+  // the face or full connectivity
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  unsigned int numberOfNeighbors = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    numberOfNeighbors *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfNeighbors; n++ )
+    {
+    OffsetType   offset;
+    unsigned int code = n;
+    unsigned int numberOfNonZero = 0;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      offset[d] = static_cast< OffsetValueType >( code % 3 ) - 1;
+      numberOfNonZero += ( offset[d] != 0 );
+      code /= 3;
+      }
+    if ( numberOfNonZero == 1 || ( m_FullyConnected && numberOfNonZero > 1 ) )
+      {
+      m_NeighborOffsets.push_back(offset);
+      m_NeighborBufferOffsets.push_back( outputImage->ComputeOffset( outputImage->GetBufferedRegion().GetIndex() + offset ) );
+      }
+    }
+
+  const SizeType        size = outputImage->GetRequestedRegion().GetSize();
+  const SizeValueType   numberOfSlices = size[ImageDimension - 1];
+  const OffsetValueType sliceSize = outputImage->GetRequestedRegion().GetNumberOfPixels() / numberOfSlices;
+  ThreadIdType          numberOfThreads = this->GetNumberOfThreads();
+  if ( numberOfSlices < numberOfThreads )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( numberOfSlices );
+    }
+  MultiThreader *multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads(numberOfThreads);
+  numberOfThreads = multiThreader->GetNumberOfThreads();
+
+  m_BorderLevels.assign( 2 * numberOfThreads * sliceSize, NumericTraits< InputImagePixelType >::ZeroValue() );
+  m_BorderDistances.assign( 2 * numberOfThreads * sliceSize, NumericTraits< SizeValueType >::max() );
+  m_BorderOrigins.assign( 2 * numberOfThreads * sliceSize, -1 );
+  m_BorderOriginLevels.assign( 2 * numberOfThreads * sliceSize, NumericTraits< InputImagePixelType >::ZeroValue() );
+  m_BorderOriginDistances.assign( 2 * numberOfThreads * sliceSize, NumericTraits< SizeValueType >::max() );
+  m_SlabChanged.assign(numberOfThreads, 0);
+  m_SlabAborted.assign(numberOfThreads, 0);
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize(numberOfThreads);
+
+  multiThreader->SetSingleMethod(this->TiledFloodingThreaderCallback, this);
+  multiThreader->SingleMethodExecute();
+
+  const bool aborted =
+    std::find( m_SlabAborted.begin(), m_SlabAborted.end(), 1 ) != m_SlabAborted.end();
+
+  m_Barrier = ITK_NULLPTR;
+  m_NeighborOffsets.clear();
+  m_NeighborBufferOffsets.clear();
+  m_BorderLevels.clear();
+  m_BorderDistances.clear();
+  m_BorderOrigins.clear();
+  m_BorderOriginLevels.clear();
+  m_BorderOriginDistances.clear();
+  m_SlabChanged.clear();
+  m_SlabAborted.clear();
+
+  if ( aborted )
+    {
+    ProcessAborted e(__FILE__, __LINE__);
+    e.SetDescription("Object " + std::string( this->GetNameOfClass() ) + ": AbortGenerateDataOn");
+    throw e;
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+ITK_THREAD_RETURN_TYPE
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::TiledFloodingThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *filter = static_cast< Self * >( info->UserData );
+
+  filter->ThreadedTiledFlooding(info->ThreadID, info->NumberOfThreads);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TLabelImage >
+bool
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::IsInside(const IndexType & index, const OffsetType & offset,
+           const SizeType & size,
+           OffsetValueType firstSlice, OffsetValueType lastSlice)
+{
+  const unsigned int lastDimension = ImageDimension - 1;
+  for ( unsigned int d = 0; d < lastDimension; d++ )
+    {
+    const OffsetValueType i = index[d] + offset[d];
+    if ( i < 0 || i >= static_cast< OffsetValueType >( size[d] ) )
+      {
+      return false;
+      }
+    }
+  const OffsetValueType slice = index[lastDimension] + offset[lastDimension];
+  return slice >= firstSlice && slice < lastSlice;
+}
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedTiledFlooding(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  // the pixels are flooded by increasing (level, distance, offset), where
+  // the level is the highest value on the best path from the markers and
+  // the distance is the length of the end of that path on the plateau of
+  // that level. Each slab is flooded with the state of the borders of its
+  // neighbors, taken from the previous round, until none of these borders
+  // changes. The result is the one of the same flooding on the whole image,
+  // whatever the number of slabs.
+  // all the threads run this function: the constants are not static, as
+  // the initialization of the local statics is not thread safe with all
+  // the supported compilers
+  const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  const LabelImagePixelType wsLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  const SizeValueType   unreached = NumericTraits< SizeValueType >::max();
+  const OffsetValueType noOrigin = -1;
+
+  LabelImageType *      output = this->GetOutput();
+  const SizeType        size = output->GetRequestedRegion().GetSize();
+  const unsigned int    lastDimension = ImageDimension - 1;
+  const OffsetValueType numberOfSlices = size[lastDimension];
+  const OffsetValueType sliceSize = output->GetRequestedRegion().GetNumberOfPixels() / numberOfSlices;
+  const OffsetValueType firstSlice = numberOfSlices * threadId / numberOfThreads;
+  const OffsetValueType lastSlice = numberOfSlices * ( threadId + 1 ) / numberOfThreads;
+  const OffsetValueType begin = firstSlice * sliceSize;
+  const OffsetValueType end = lastSlice * sliceSize;
+  const size_t          numberOfNeighbors = m_NeighborOffsets.size();
+
+  // the slab and the border slices of its neighbors
+  const bool            hasPreviousSlab = firstSlice > 0;
+  const bool            hasNextSlab = lastSlice < numberOfSlices;
+  const OffsetValueType extendedFirstSlice = firstSlice - ( hasPreviousSlab ? 1 : 0 );
+  const OffsetValueType extendedLastSlice = lastSlice + ( hasNextSlab ? 1 : 0 );
+  const OffsetValueType extendedBegin = extendedFirstSlice * sliceSize;
+  const OffsetValueType extendedEnd = extendedLastSlice * sliceSize;
+
+  LabelImagePixelType *       out = output->GetBufferPointer();
+  const InputImagePixelType * input = this->GetInput()->GetBufferPointer();
+  const LabelImagePixelType * marker = this->GetMarkerImage()->GetBufferPointer();
+
+  // the state of the pixels of the extended slab, indexed by their offset
+  // minus extendedBegin. The origin of a pixel is the last pixel of a
+  // neighbor slab on its path from the markers, with the level and the
+  // distance of that pixel when the path went through it.
+  const size_t                       extendedSize = extendedEnd - extendedBegin;
+  std::vector< InputImagePixelType > levels( extendedSize, NumericTraits< InputImagePixelType >::ZeroValue() );
+  std::vector< SizeValueType >       distances(extendedSize, unreached);
+  std::vector< LabelImagePixelType > labels(extendedSize, wsLabel);
+  std::vector< OffsetValueType >     origins(extendedSize, noOrigin);
+  std::vector< InputImagePixelType > originLevels( extendedSize, NumericTraits< InputImagePixelType >::ZeroValue() );
+  std::vector< SizeValueType >       originDistances(extendedSize, unreached);
+  std::vector< char >                done(extendedSize, 0);
+
+  // the borders of the neighbor slabs: the last slice of the previous slab
+  // and the first slice of the next one
+  OffsetValueType borderBegin[2];
+  OffsetValueType borderSource[2];
+  bool            hasBorder[2];
+  hasBorder[0] = hasPreviousSlab;
+  borderBegin[0] = extendedBegin;
+  borderSource[0] = ( 2 * static_cast< OffsetValueType >( threadId ) - 1 ) * sliceSize;
+  hasBorder[1] = hasNextSlab;
+  borderBegin[1] = end;
+  borderSource[1] = 2 * static_cast< OffsetValueType >( threadId + 1 ) * sliceSize;
+
+  typedef std::priority_queue< FloodingNode, std::vector< FloodingNode >, FloodingNodeGreater > PriorityQueueType;
+
+  // the pixels of the slab are reported when they are flooded in the first
+  // round. An abort is only thrown after all the threads have stopped.
+  ProgressReporter progress( this, threadId, end - begin );
+  bool             aborted = false;
+
+  IndexType index;
+  bool      firstRound = true;
+  while ( true )
+    {
+    // read the borders of the neighbor slabs. The markers don't change and
+    // are taken from the marker image.
+    bool changed = firstRound;
+    for ( unsigned int b = 0; b < 2; b++ )
+      {
+      if ( !hasBorder[b] )
+        {
+        continue;
+        }
+      for ( OffsetValueType j = 0; j < sliceSize; j++ )
+        {
+        const OffsetValueType k = borderBegin[b] + j;
+        if ( marker[k] != bgLabel )
+          {
+          continue;
+          }
+        const OffsetValueType     i = k - extendedBegin;
+        const OffsetValueType     s = borderSource[b] + j;
+        const SizeValueType       distance = m_BorderDistances[s];
+        const LabelImagePixelType label = ( distance == unreached ) ? wsLabel : out[k];
+        if ( distance != distances[i]
+             || ( distance != unreached
+                  && ( m_BorderLevels[s] != levels[i] || label != labels[i]
+                       || m_BorderOrigins[s] != origins[i]
+                       || m_BorderOriginLevels[s] != originLevels[i]
+                       || m_BorderOriginDistances[s] != originDistances[i] ) ) )
+          {
+          changed = true;
+          distances[i] = distance;
+          levels[i] = m_BorderLevels[s];
+          labels[i] = label;
+          origins[i] = m_BorderOrigins[s];
+          originLevels[i] = m_BorderOriginLevels[s];
+          originDistances[i] = m_BorderOriginDistances[s];
+          }
+        }
+      }
+
+    // wait for all the threads to read the borders before changing them
+    m_SlabChanged[threadId] = changed;
+    m_SlabAborted[threadId] = aborted;
+    m_Barrier->Wait();
+    if ( std::find( m_SlabChanged.begin(), m_SlabChanged.end(), 1 ) == m_SlabChanged.end()
+         || std::find( m_SlabAborted.begin(), m_SlabAborted.end(), 1 ) != m_SlabAborted.end() )
+      {
+      break;
+      }
+
+    if ( changed )
+      {
+      PriorityQueueType queue;
+
+      // reset the slab, and put the markers and the reached pixels of the
+      // borders in the priority queue
+      for ( OffsetValueType k = extendedBegin; k < extendedEnd; k++ )
+        {
+        const OffsetValueType i = k - extendedBegin;
+        done[i] = 0;
+        if ( k >= begin && k < end )
+          {
+          distances[i] = unreached;
+          labels[i] = wsLabel;
+          origins[i] = noOrigin;
+          }
+        if ( marker[k] != bgLabel )
+          {
+          labels[i] = marker[k];
+          levels[i] = input[k];
+          distances[i] = 0;
+          if ( m_MarkWatershedLine )
+            {
+            // the markers are below all the other pixels: they are already
+            // flooded, and their neighbors are reached at their own value
+            done[i] = 1;
+            }
+          else
+            {
+            FloodingNode node = { input[k], 0, k };
+            queue.push(node);
+            }
+          }
+        else if ( ( k < begin || k >= end ) && distances[i] != unreached )
+          {
+          FloodingNode node = { levels[i], distances[i], k };
+          queue.push(node);
+          }
+        }
+
+      if ( m_MarkWatershedLine )
+        {
+        for ( OffsetValueType k = extendedBegin; k < extendedEnd; k++ )
+          {
+          if ( marker[k] == bgLabel )
+            {
+            continue;
+            }
+          OffsetValueType position = k;
+          for ( unsigned int d = 0; d < lastDimension; d++ )
+            {
+            index[d] = position % static_cast< OffsetValueType >( size[d] );
+            position /= static_cast< OffsetValueType >( size[d] );
+            }
+          index[lastDimension] = position;
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            const OffsetValueType q = k + m_NeighborBufferOffsets[n];
+            if ( IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice)
+                 && marker[q] == bgLabel )
+              {
+              const OffsetValueType j = q - extendedBegin;
+              if ( distances[j] == unreached || input[q] < levels[j]
+                   || ( !( levels[j] < input[q] ) && distances[j] > 0 ) )
+                {
+                levels[j] = input[q];
+                distances[j] = 0;
+                FloodingNode node = { input[q], 0, q };
+                queue.push(node);
+                }
+              }
+            }
+          }
+        }
+
+      // flood the slab
+      try
+        {
+        while ( !queue.empty() )
+          {
+          const FloodingNode node = queue.top();
+          queue.pop();
+
+          const OffsetValueType k = node.m_Offset;
+          const OffsetValueType i = k - extendedBegin;
+          if ( done[i] )
+            {
+            // an older node of a pixel reached again with a lower priority
+            continue;
+            }
+          const bool isInSlab = ( k >= begin && k < end );
+          if ( !isInSlab && origins[i] >= begin && origins[i] < end )
+            {
+            // the path of a pixel of a neighbor slab comes from this slab: it
+            // is only valid if it still goes through the same pixel. This
+            // prevents two slabs from reaching their borders from each other
+            // with the values of the previous rounds.
+            const OffsetValueType o = origins[i] - extendedBegin;
+            if ( !done[o] || labels[o] == wsLabel
+                 || levels[o] != originLevels[i] || distances[o] != originDistances[i] )
+              {
+              continue;
+              }
+            }
+          done[i] = 1;
+
+          OffsetValueType position = k;
+          for ( unsigned int d = 0; d < lastDimension; d++ )
+            {
+            index[d] = position % static_cast< OffsetValueType >( size[d] );
+            position /= static_cast< OffsetValueType >( size[d] );
+            }
+          index[lastDimension] = position;
+
+          if ( firstRound && isInSlab )
+            {
+            progress.CompletedPixel();
+            }
+
+          if ( m_MarkWatershedLine && isInSlab )
+            {
+            // if there is only one label in the already flooded neighbors,
+            // give that label to the pixel, else keep it as watershed line
+            LabelImagePixelType label = wsLabel;
+            bool                collision = false;
+            for ( size_t n = 0; n < numberOfNeighbors && !collision; n++ )
+              {
+              if ( IsInside(index, m_NeighborOffsets[n], size, extendedFirstSlice, extendedLastSlice) )
+                {
+                const OffsetValueType     j = i + m_NeighborBufferOffsets[n];
+                const LabelImagePixelType o = labels[j];
+                if ( done[j] && o != wsLabel )
+                  {
+                  collision = ( label != wsLabel && o != label );
+                  label = o;
+                  }
+                }
+              }
+            if ( !collision )
+              {
+              labels[i] = label;
+              }
+            }
+          if ( labels[i] == wsLabel )
+            {
+            // the watershed lines don't propagate
+            continue;
+            }
+
+          // propagate to the neighbors in the slab
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            const OffsetValueType q = k + m_NeighborBufferOffsets[n];
+            if ( !IsInside(index, m_NeighborOffsets[n], size, firstSlice, lastSlice)
+                 || marker[q] != bgLabel )
+              {
+              continue;
+              }
+            const OffsetValueType j = q - extendedBegin;
+            if ( done[j] )
+              {
+              continue;
+              }
+            InputImagePixelType level = node.m_Level;
+            SizeValueType       distance = node.m_Distance + 1;
+            if ( level < input[q] )
+              {
+              level = input[q];
+              distance = 0;
+              }
+            if ( distances[j] == unreached || level < levels[j]
+                 || ( !( levels[j] < level ) && distance < distances[j] ) )
+              {
+              levels[j] = level;
+              distances[j] = distance;
+              if ( !m_MarkWatershedLine )
+                {
+                labels[j] = labels[i];
+                }
+              if ( isInSlab )
+                {
+                origins[j] = origins[i];
+                originLevels[j] = originLevels[i];
+                originDistances[j] = originDistances[i];
+                }
+              else if ( marker[k] != bgLabel )
+                {
+                // the markers don't change
+                origins[j] = noOrigin;
+                }
+              else
+                {
+                origins[j] = k;
+                originLevels[j] = node.m_Level;
+                originDistances[j] = node.m_Distance;
+                }
+              FloodingNode next = { level, distance, q };
+              queue.push(next);
+              }
+            }
+          }
+        }
+      catch ( ProcessAborted & )
+        {
+        aborted = true;
+        }
+
+      // publish the slab and its borders
+      for ( OffsetValueType k = begin; k < end; k++ )
+        {
+        out[k] = labels[k - extendedBegin];
+        }
+      const OffsetValueType ownBorderBegin[2] = { begin, end - sliceSize };
+      for ( unsigned int b = 0; b < 2; b++ )
+        {
+        const OffsetValueType destination = ( 2 * static_cast< OffsetValueType >( threadId ) + b ) * sliceSize;
+        for ( OffsetValueType j = 0; j < sliceSize; j++ )
+          {
+          const OffsetValueType i = ownBorderBegin[b] + j - extendedBegin;
+          m_BorderLevels[destination + j] = levels[i];
+          m_BorderDistances[destination + j] = distances[i];
+          m_BorderOrigins[destination + j] = origins[i];
+          m_BorderOriginLevels[destination + j] = originLevels[i];
+          m_BorderOriginDistances[destination + j] = originDistances[i];
+          }
+        }
+      }
+
+    // wait for all the threads to publish their slab before reading the
+    // borders again
+    m_Barrier->Wait();
+    firstRound = false;
+    }
+}
+
 template< typename TInputImage, typename TLabelImage >
 void
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
@@ -459,6 +951,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "UseTiledFlooding: "  << m_UseTiledFlooding << std::endl;
 }
 } // end namespace itk
 #endif
@@ -37,6 +37,11 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The number of threads of this filter is passed to its internal filters,
+ * so that the h-minima reconstruction and the labeling of the regional
+ * minima run in parallel. The flooding is sequential unless
+ * UseTiledFlooding is on, see MorphologicalWatershedFromMarkersImageFilter.
+ *
  *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
@@ -110,6 +115,16 @@ public:
   itkSetMacro(Level, InputImagePixelType);
   itkGetConstMacro(Level, InputImagePixelType);
 
+  /**
+   * Set/Get whether the image is flooded in parallel, in slabs along its
+   * last dimension. The output then does not depend on the number of
+   * threads, but may differ from the sequential flooding on the plateaus
+   * of the input image. Default is false.
+   */
+  itkSetMacro(UseTiledFlooding, bool);
+  itkGetConstReferenceMacro(UseTiledFlooding, bool);
+  itkBooleanMacro(UseTiledFlooding);
+
 protected:
   MorphologicalWatershedImageFilter();
   ~MorphologicalWatershedImageFilter() {}
@@ -136,6 +151,8 @@ private:
   bool m_MarkWatershedLine;
 
   InputImagePixelType m_Level;
+
+  bool m_UseTiledFlooding;
 }; // end of class
 } // end namespace itk
 
@@ -43,6 +43,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   m_FullyConnected = false;
   m_MarkWatershedLine = true;
   m_Level = NumericTraits< InputImagePixelType >::ZeroValue();
+  m_UseTiledFlooding = false;
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -91,6 +92,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   typename RMinType::Pointer rmin = RMinType::New();
   rmin->SetInput( this->GetInput() );
   rmin->SetFullyConnected(m_FullyConnected);
+  rmin->SetNumberOfThreads( this->GetNumberOfThreads() );
   rmin->SetBackgroundValue(NumericTraits< OutputImagePixelType >::Zero);
   rmin->SetForegroundValue( NumericTraits< OutputImagePixelType >::max() );
 
@@ -99,6 +101,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   ConnectedCompType;
   typename ConnectedCompType::Pointer label = ConnectedCompType::New();
   label->SetFullyConnected(m_FullyConnected);
+  label->SetNumberOfThreads( this->GetNumberOfThreads() );
   label->SetInput( rmin->GetOutput() );
 
   // the watershed
@@ -109,7 +112,9 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   wshed->SetInput( this->GetInput() );
   wshed->SetMarkerImage( label->GetOutput() );
   wshed->SetFullyConnected(m_FullyConnected);
+  wshed->SetNumberOfThreads( this->GetNumberOfThreads() );
   wshed->SetMarkWatershedLine(m_MarkWatershedLine);
+  wshed->SetUseTiledFlooding(m_UseTiledFlooding);
 
   if ( m_Level != NumericTraits< InputImagePixelType >::ZeroValue() )
     {
@@ -119,6 +124,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
     hmin->SetInput( this->GetInput() );
     hmin->SetHeight(m_Level);
     hmin->SetFullyConnected(m_FullyConnected);
+    hmin->SetNumberOfThreads( this->GetNumberOfThreads() );
     // replace the input of the r-min filter
     rmin->SetInput( hmin->GetOutput() );
 
@@ -160,6 +166,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   os << indent << "Level: "
      << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_Level )
      << std::endl;
+  os << indent << "UseTiledFlooding: "  << m_UseTiledFlooding << std::endl;
 }
 } // end namespace itk
 #endif
@@ -0,0 +1,260 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkCommand.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkConstShapedNeighborhoodIterator.h"
+#include "itkConstantBoundaryCondition.h"
+#include "itkConnectedComponentAlgorithm.h"
+
+/* Check that the tiled flooding gives the same output with any number of
+ * threads, and the same output as the sequential flooding on an image
+ * without plateau, with markers at all the regional minima. */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension >          InputImageType;
+typedef itk::Image< unsigned short, Dimension > LabelImageType;
+
+typedef itk::MorphologicalWatershedFromMarkersImageFilter< InputImageType, LabelImageType > FilterType;
+
+LabelImageType::Pointer Flood( InputImageType *input, LabelImageType *markers,
+                               bool markWatershedLine, bool fullyConnected,
+                               bool useTiledFlooding, itk::ThreadIdType numberOfThreads )
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetMarkerImage( markers );
+  filter->SetMarkWatershedLine( markWatershedLine );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetUseTiledFlooding( useTiledFlooding );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+  LabelImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+bool SameImages( const LabelImageType *a, const LabelImageType *b )
+{
+  itk::ImageRegionConstIterator< LabelImageType > ait( a, a->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LabelImageType > bit( b, b->GetBufferedRegion() );
+  for( ; !ait.IsAtEnd(); ++ait, ++bit )
+    {
+    if( ait.Get() != bit.Get() )
+      {
+      std::cerr << "Different labels at " << ait.GetIndex() << ": "
+                << ait.Get() << " and " << bit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+void AbortOnProgress( itk::Object *object, const itk::EventObject &, void * )
+{
+  itk::ProcessObject *filter = dynamic_cast< itk::ProcessObject * >( object );
+  if( filter && filter->GetProgress() > 0.1 )
+    {
+    filter->AbortGenerateDataOn();
+    }
+}
+
+/* Label each regional minimum of an image without plateau. */
+LabelImageType::Pointer LabelMinima( const InputImageType *input, bool fullyConnected )
+{
+  LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( input->GetLargestPossibleRegion() );
+  markers->Allocate();
+  markers->FillBuffer( 0 );
+
+  typedef itk::ConstShapedNeighborhoodIterator< InputImageType > IteratorType;
+  IteratorType::RadiusType radius;
+  radius.Fill( 1 );
+  IteratorType it( radius, input, input->GetLargestPossibleRegion() );
+  itk::ConstantBoundaryCondition< InputImageType > boundaryCondition;
+  boundaryCondition.SetConstant( itk::NumericTraits< float >::max() );
+  it.OverrideBoundaryCondition( &boundaryCondition );
+  setConnectivity( &it, fullyConnected );
+
+  unsigned short label = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    bool isMinimum = true;
+    for( IteratorType::ConstIterator nit = it.Begin(); nit != it.End(); ++nit )
+      {
+      if( nit.Get() <= it.GetCenterPixel() )
+        {
+        isMinimum = false;
+        break;
+        }
+      }
+    if( isMinimum )
+      {
+      markers->SetPixel( it.GetIndex(), ++label );
+      }
+    }
+  return markers;
+}
+}
+
+int itkMorphologicalWatershedFromMarkersImageFilterTiledTest(int, char* [])
+{
+  InputImageType::SizeType size;
+  size[0] = 20;
+  size[1] = 18;
+  size[2] = 15;
+  InputImageType::RegionType region;
+  region.SetSize( size );
+
+  // An image with large plateaus, and a few markers
+  InputImageType::Pointer plateaus = InputImageType::New();
+  plateaus->SetRegions( region );
+  plateaus->Allocate();
+  itk::ImageRegionIteratorWithIndex< InputImageType > it( plateaus, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const InputImageType::IndexType index = it.GetIndex();
+    const double value = std::sin( index[0] / 3.0 ) + std::cos( index[1] / 4.0 ) + std::sin( index[2] / 2.5 );
+    it.Set( static_cast< float >( std::floor( 2.0 * value ) ) );
+    }
+
+  LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( region );
+  markers->Allocate();
+  markers->FillBuffer( 0 );
+  const long centers[4][3] = { { 2, 2, 2 }, { 15, 12, 3 }, { 5, 14, 12 }, { 17, 3, 13 } };
+  for( unsigned short label = 1; label <= 4; ++label )
+    {
+    LabelImageType::IndexType index;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      index[d] = centers[label - 1][d];
+      }
+    markers->SetPixel( index, label );
+    ++index[2];
+    markers->SetPixel( index, label );
+    }
+
+  // An image without plateau: a permutation of the pixel indices
+  InputImageType::Pointer distinct = InputImageType::New();
+  distinct->SetRegions( region );
+  distinct->Allocate();
+  const itk::SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  std::vector< float > values( numberOfPixels );
+  for( itk::SizeValueType i = 0; i < numberOfPixels; ++i )
+    {
+    values[i] = static_cast< float >( i );
+    }
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  for( itk::SizeValueType i = numberOfPixels - 1; i > 0; --i )
+    {
+    std::swap( values[i], values[generator->GetIntegerVariate( static_cast< GeneratorType::IntegerType >( i ) )] );
+    }
+  std::copy( values.begin(), values.end(), distinct->GetBufferPointer() );
+
+  // More threads than slices gives slabs of one slice
+  const itk::ThreadIdType numbersOfThreads[] = { 2, 3, 7, 16 };
+
+  for( unsigned int mode = 0; mode < 4; ++mode )
+    {
+    const bool markWatershedLine = ( mode & 1 ) != 0;
+    const bool fullyConnected = ( mode & 2 ) != 0;
+    std::cout << "MarkWatershedLine: " << markWatershedLine
+              << ", FullyConnected: " << fullyConnected << std::endl;
+
+    LabelImageType::Pointer reference =
+      Flood( plateaus, markers, markWatershedLine, fullyConnected, true, 1 );
+    for( unsigned int t = 0; t < sizeof( numbersOfThreads ) / sizeof( numbersOfThreads[0] ); ++t )
+      {
+      LabelImageType::Pointer output =
+        Flood( plateaus, markers, markWatershedLine, fullyConnected, true, numbersOfThreads[t] );
+      if( !SameImages( reference, output ) )
+        {
+        std::cerr << "The tiled flooding with " << numbersOfThreads[t]
+                  << " threads differs from the tiled flooding with 1 thread" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    // without watershed line, all the pixels must be labeled
+    if( !markWatershedLine )
+      {
+      itk::ImageRegionConstIterator< LabelImageType > rit( reference, region );
+      for( ; !rit.IsAtEnd(); ++rit )
+        {
+        if( rit.Get() == 0 )
+          {
+          std::cerr << "Pixel " << rit.GetIndex() << " is not labeled" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+
+    LabelImageType::Pointer minima = LabelMinima( distinct, fullyConnected );
+    LabelImageType::Pointer sequential =
+      Flood( distinct, minima, markWatershedLine, fullyConnected, false, 1 );
+    for( unsigned int t = 0; t < sizeof( numbersOfThreads ) / sizeof( numbersOfThreads[0] ); ++t )
+      {
+      LabelImageType::Pointer output =
+        Flood( distinct, minima, markWatershedLine, fullyConnected, true, numbersOfThreads[t] );
+      if( !SameImages( sequential, output ) )
+        {
+        std::cerr << "The tiled flooding with " << numbersOfThreads[t]
+                  << " threads differs from the sequential flooding" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // an abort must stop all the threads, and be thrown once they stopped
+  FilterType::Pointer aborted = FilterType::New();
+  aborted->SetInput( plateaus );
+  aborted->SetMarkerImage( markers );
+  aborted->SetUseTiledFlooding( true );
+  aborted->SetNumberOfThreads( 3 );
+  itk::CStyleCommand::Pointer abortCommand = itk::CStyleCommand::New();
+  abortCommand->SetCallback( AbortOnProgress );
+  aborted->AddObserver( itk::ProgressEvent(), abortCommand );
+  bool caughtAbort = false;
+  try
+    {
+    aborted->Update();
+    }
+  catch( itk::ProcessAborted & )
+    {
+    caughtAbort = true;
+    }
+  if( !caughtAbort )
+    {
+    std::cerr << "The tiled flooding was not aborted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -26,7 +26,8 @@ namespace itk
 
 template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
-::ANTSNeighborhoodCorrelationImageToImageMetricv4()
+::ANTSNeighborhoodCorrelationImageToImageMetricv4() :
+  m_UseBoxFilter( false )
 {
   // initialize radius. note that a radius of 1 can be unstable
   typedef typename RadiusType::SizeValueType RadiusValueType;
@@ -35,6 +36,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
   // ImageToImageMetricv4 to use.
   this->m_DenseGetValueAndDerivativeThreader  = ANTSNeighborhoodCorrelationImageToImageMetricv4DenseGetValueAndDerivativeThreaderType::New();
   this->m_SparseGetValueAndDerivativeThreader = ANTSNeighborhoodCorrelationImageToImageMetricv4SparseGetValueAndDerivativeThreaderType::New();
+  this->m_WindowSumsThreader = WindowSumsThreaderType::New();
 }
 
 template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -51,6 +53,57 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
   Superclass::Initialize();
 }
 
+template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::InitializeForIteration() const
+{
+  Superclass::InitializeForIteration();
+
+  if( this->m_UseFixedSampledPointSet || !this->m_UseBoxFilter )
+    {
+    // The window sums are only used by the dense evaluation.
+    this->m_WindowSumsImage = ITK_NULLPTR;
+    return;
+    }
+
+  const ImageRegionType & virtualRegion = this->GetVirtualRegion();
+  this->m_WindowSumsImage = WindowSumsImageType::New();
+  this->m_WindowSumsImage->SetRegions( virtualRegion );
+  this->m_WindowSumsImage->Allocate();
+
+  // Evaluate the images at each voxel, then sum along each dimension in turn
+  // over the lines starting on the first face of the region.
+  this->m_WindowSumsThreader->SetMaximumNumberOfThreads( this->GetMaximumNumberOfThreads() );
+  this->m_WindowSumsThreader->SetPass( 0 );
+  this->m_WindowSumsThreader->Execute( const_cast<Self *>(this), virtualRegion );
+  for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+    {
+    ImageRegionType lineStarts = virtualRegion;
+    lineStarts.SetSize( d, 1 );
+    this->m_WindowSumsThreader->SetPass( d + 1 );
+    this->m_WindowSumsThreader->Execute( const_cast<Self *>(this), lineStarts );
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::GetValueAndDerivativeExecute() const
+{
+  try
+    {
+    Superclass::GetValueAndDerivativeExecute();
+    }
+  catch( ... )
+    {
+    this->m_WindowSumsImage = ITK_NULLPTR;
+    throw;
+    }
+  // Do not keep the window sums between the evaluations.
+  this->m_WindowSumsImage = ITK_NULLPTR;
+}
+
 template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -58,6 +111,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Correlation window radius: " << m_Radius << std::endl;
+  os << indent << "Use box filter: " << m_UseBoxFilter << std::endl;
 }
 
 } // end namespace itk
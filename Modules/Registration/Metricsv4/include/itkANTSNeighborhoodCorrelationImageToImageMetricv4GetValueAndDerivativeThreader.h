@@ -42,8 +42,9 @@ struct IdentityHelper
  * \brief Threading implementation for ANTS CC metric \c ANTSNeighborhoodCorrelationImageToImageMetricv4 .
  * Supports both dense and sparse threading ways. The dense threader iterates over the whole image domain
  * in order and use a neighborhood scanning window to compute the local cross correlation metric and
- * its derivative incrementally inside the window. The sparse threader uses a sampled point set partitioner to
- * computer local cross correlation only at the sampled positions.
+ * its derivative incrementally inside the window, or reads the sums over the window of each voxel from
+ * the window sums image computed by the metric when its box filter is used. The sparse threader uses a
+ * sampled point set partitioner to computer local cross correlation only at the sampled positions.
  *
  * This threader class is designed to host the dense and sparse threader under the same name so most computation
  * routine functions and interior member variables can be shared. This eliminates the need to duplicate codes
@@ -95,6 +96,8 @@ public:
   typedef typename NeighborhoodCorrelationMetricType::FixedImageType                FixedImageType;
   typedef typename NeighborhoodCorrelationMetricType::MovingImageType               MovingImageType;
   typedef typename NeighborhoodCorrelationMetricType::RadiusType                    RadiusType;
+  typedef typename NeighborhoodCorrelationMetricType::WindowSumsType                WindowSumsType;
+  typedef typename NeighborhoodCorrelationMetricType::WindowSumsImageType           WindowSumsImageType;
 
   // interested values here updated during scanning
   typedef InternalComputationValueType                 QueueRealType;
@@ -145,7 +148,9 @@ public:
 protected:
   ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader() :
     m_ANTSAssociate(ITK_NULLPTR)
-  {}
+  {
+    this->m_SupportsSparseJacobian = true;
+  }
 
   /**
    * Dense threader and sparse threader invoke different in multi-threading. This class uses overloaded
@@ -275,11 +280,22 @@ protected:
     const ScanParametersType &scanParameters,
     const ThreadIdType threadId) const;
 
+  /** Compute the information at the voxel \c index from the sums over its
+   * window, either summed from the queues or read from the window sums
+   * image of the metric. */
+  bool ComputeInformationFromWindowSums(
+    const VirtualIndexType &index, const WindowSumsType &windowSums,
+    ScanMemType &scanMem, const ThreadIdType threadId) const;
+
   void ComputeMovingTransformDerivative(
     const ScanIteratorType &scanIt, ScanMemType &scanMem,
     const ScanParametersType &scanParameters, DerivativeType &deriv,
     MeasureType &local_cc, const ThreadIdType threadId) const;
 
+  void ComputeMovingTransformDerivative(
+    ScanMemType &scanMem, DerivativeType &deriv,
+    MeasureType &local_cc, const ThreadIdType threadId) const;
+
 private:
   ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader( const Self & ); // purposely not implemented
   void operator=( const Self & ); // purposely not implemented
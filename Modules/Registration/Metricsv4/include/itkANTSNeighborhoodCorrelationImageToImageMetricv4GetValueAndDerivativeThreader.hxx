@@ -19,6 +19,7 @@
 #define itkANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader_hxx
 
 #include "itkANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 
 namespace itk
 {
@@ -48,6 +49,46 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
 
   DerivativeType & localDerivativeResult = this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives;
 
+  /* The window sums were computed by the box filter of the metric in
+   * InitializeForIteration: read them instead of scanning. */
+  const WindowSumsImageType * windowSumsImage = this->m_ANTSAssociate->m_WindowSumsImage.GetPointer();
+  if( windowSumsImage != ITK_NULLPTR )
+    {
+    ImageRegionConstIteratorWithIndex< WindowSumsImageType > sumsIt( windowSumsImage, virtualImageSubRegion );
+    for( sumsIt.GoToBegin(); !sumsIt.IsAtEnd(); ++sumsIt )
+      {
+      try
+        {
+        pointIsValid = this->ComputeInformationFromWindowSums( sumsIt.GetIndex(), sumsIt.Get(), scanMem, threadId );
+        if( pointIsValid )
+          {
+          this->ComputeMovingTransformDerivative( scanMem, localDerivativeResult, metricValueResult, threadId );
+          }
+        }
+      catch (ExceptionObject & exc)
+        {
+        //NOTE: there must be a cleaner way to do this:
+        std::string msg("Caught exception: \n");
+        msg += exc.what();
+        ExceptionObject err(__FILE__, __LINE__, msg);
+        throw err;
+        }
+
+      if ( pointIsValid )
+        {
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].NumberOfValidPoints++;
+        metricValueSum -= metricValueResult;
+        if( this->GetComputeDerivative() )
+          {
+          this->StorePointDerivativeResult( sumsIt.GetIndex(), threadId );
+          }
+        }
+      }
+
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].Measure = metricValueSum;
+    return;
+    }
+
   /* Create an iterator over the virtual sub region */
   // this->m_ANTSAssociate->InitializeScanning( virtualImageSubRegion, scanIt, scanMem, scanParameters );
   this->InitializeScanning( virtualImageSubRegion, scanIt, scanMem, scanParameters );
@@ -349,7 +390,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
 template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
 bool
 ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
-::ComputeInformationFromQueues( const ScanIteratorType &scanIt, ScanMemType &scanMem, const ScanParametersType &, const ThreadIdType ) const
+::ComputeInformationFromQueues( const ScanIteratorType &scanIt, ScanMemType &scanMem, const ScanParametersType &, const ThreadIdType threadId ) const
 {
  typedef InternalComputationValueType LocalRealType;
 
@@ -397,6 +438,37 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
    ++itFixedMoving;
    }
 
+ WindowSumsType windowSums;
+ windowSums[NeighborhoodCorrelationMetricType::SumFixed2]      = sumFixed2;
+ windowSums[NeighborhoodCorrelationMetricType::SumMoving2]     = sumMoving2;
+ windowSums[NeighborhoodCorrelationMetricType::SumFixed]       = sumFixed;
+ windowSums[NeighborhoodCorrelationMetricType::SumMoving]      = sumMoving;
+ windowSums[NeighborhoodCorrelationMetricType::SumFixedMoving] = sumFixedMoving;
+ windowSums[NeighborhoodCorrelationMetricType::Count]          = count;
+
+ return this->ComputeInformationFromWindowSums( scanIt.GetIndex(), windowSums, scanMem, threadId );
+}
+
+template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
+bool
+ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
+::ComputeInformationFromWindowSums( const VirtualIndexType &oindex, const WindowSumsType &windowSums, ScanMemType &scanMem, const ThreadIdType ) const
+{
+ typedef InternalComputationValueType LocalRealType;
+
+ const LocalRealType count = windowSums[NeighborhoodCorrelationMetricType::Count];
+ if (count <= NumericTraits<LocalRealType>::ZeroValue())
+   {
+   // no points available in the window, perhaps out of image region
+   return false;
+   }
+
+ const LocalRealType sumFixed2      = windowSums[NeighborhoodCorrelationMetricType::SumFixed2];
+ const LocalRealType sumMoving2     = windowSums[NeighborhoodCorrelationMetricType::SumMoving2];
+ const LocalRealType sumFixed       = windowSums[NeighborhoodCorrelationMetricType::SumFixed];
+ const LocalRealType sumMoving      = windowSums[NeighborhoodCorrelationMetricType::SumMoving];
+ const LocalRealType sumFixedMoving = windowSums[NeighborhoodCorrelationMetricType::SumFixedMoving];
+
  LocalRealType fixedMean  = sumFixed  / count;
  LocalRealType movingMean = sumMoving / count;
 
@@ -404,8 +476,6 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
  LocalRealType sMovingMoving = sumMoving2 - movingMean * sumMoving - movingMean * sumMoving + count * movingMean * movingMean;
  LocalRealType sFixedMoving  = sumFixedMoving - movingMean * sumFixed - fixedMean * sumMoving + count * movingMean * fixedMean;
 
- typename VirtualImageType::IndexType oindex = scanIt.GetIndex();
-
  VirtualPointType        virtualPoint;
  FixedImagePointType     mappedFixedPoint;
  FixedImagePixelType     fixedImageValue;
@@ -468,6 +538,14 @@ template < typename TDomainPartitioner, typename TImageToImageMetric, typename T
 void
 ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
 ::ComputeMovingTransformDerivative( const ScanIteratorType &, ScanMemType &scanMem, const ScanParametersType &, DerivativeType &deriv, MeasureType &localCC, const ThreadIdType threadId) const
+{
+  this->ComputeMovingTransformDerivative( scanMem, deriv, localCC, threadId );
+}
+
+template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
+::ComputeMovingTransformDerivative( ScanMemType &scanMem, DerivativeType &deriv, MeasureType &localCC, const ThreadIdType threadId) const
 {
   MovingImageGradientType derivWRTImage;
   localCC = NumericTraits<MeasureType>::OneValue();
@@ -502,20 +580,12 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
       derivWRTImage[qq] = 2.0 * sFixedMoving / (sFixedFixed_sMovingMoving) * (fixedI - sFixedMoving / sMovingMoving * movingI) * movingImageGradient[qq];
       }
 
-    /* Use a pre-allocated jacobian object for efficiency */
-    typedef JacobianType & JacobianReferenceType;
-    JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
-    JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
-
-    /** For dense transforms, this returns identity */
-    this->m_Associate->GetMovingTransform()->
-      ComputeJacobianWithRespectToParametersCachedTemporaries(scanMem.virtualPoint,
-                                                              jacobian,
-                                                              jacobianPositional);
-
-    NumberOfParametersType numberOfLocalParameters = this->m_Associate->GetMovingTransform()->GetNumberOfLocalParameters();
+    /* Use a pre-allocated jacobian object for efficiency. With a sparse
+     * jacobian, only the parameters supporting the point are visited. */
+    const NumberOfParametersType numberOfLocalDerivatives = this->ComputeMovingTransformJacobian( scanMem.virtualPoint, threadId );
+    const JacobianType & jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
 
-    for (NumberOfParametersType par = 0; par < numberOfLocalParameters; par++)
+    for (NumberOfParametersType par = 0; par < numberOfLocalDerivatives; par++)
       {
       deriv[par] = NumericTraits<DerivativeValueType>::ZeroValue();
       for (ImageDimensionType dim = 0; dim < TImageToImageMetric::MovingImageDimension; dim++)
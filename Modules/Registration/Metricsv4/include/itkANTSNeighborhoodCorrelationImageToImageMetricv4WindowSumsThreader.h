@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader_h
+#define itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader_h
+
+#include "itkDomainThreader.h"
+#include "itkThreadedImageRegionPartitioner.h"
+
+namespace itk
+{
+
+/** \class ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader
+ * \brief Compute the sums over the neighborhood of each voxel for
+ * ANTSNeighborhoodCorrelationImageToImageMetricv4.
+ *
+ * The sums of the fixed and moving values, of their squares and products,
+ * and the number of valid voxels, over the neighborhood of every voxel of
+ * the virtual domain, are computed in the window sums image of the metric
+ * by a separable box filter. The first pass (pass 0) evaluates the images at
+ * the voxels of the domain. The pass \c d+1 then replaces the values along
+ * each line of dimension \c d, starting at a voxel of the domain, by their
+ * sums over a sliding window of radius \c Radius[d]. Each pass is threaded
+ * over its own domain: the virtual region for pass 0, and the region of the
+ * first voxels of the lines of dimension \c d for pass \c d+1.
+ *
+ * \ingroup ITKMetricsv4
+ */
+template < typename TNeighborhoodCorrelationMetric >
+class ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader
+  : public DomainThreader< ThreadedImageRegionPartitioner< TNeighborhoodCorrelationMetric::VirtualImageDimension >,
+                           TNeighborhoodCorrelationMetric >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader   Self;
+  typedef DomainThreader< ThreadedImageRegionPartitioner< TNeighborhoodCorrelationMetric::VirtualImageDimension >,
+                          TNeighborhoodCorrelationMetric >                    Superclass;
+  typedef SmartPointer< Self >                                                Pointer;
+  typedef SmartPointer< const Self >                                          ConstPointer;
+
+  itkTypeMacro( ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader, DomainThreader );
+
+  itkNewMacro( Self );
+
+  /** Superclass types. */
+  typedef typename Superclass::DomainType    DomainType;
+  typedef typename Superclass::AssociateType AssociateType;
+
+  /** Types of the associate class. */
+  typedef TNeighborhoodCorrelationMetric                                    NeighborhoodCorrelationMetricType;
+  typedef typename NeighborhoodCorrelationMetricType::VirtualIndexType      VirtualIndexType;
+  typedef typename NeighborhoodCorrelationMetricType::VirtualPointType      VirtualPointType;
+  typedef typename NeighborhoodCorrelationMetricType::WindowSumsType        WindowSumsType;
+  typedef typename NeighborhoodCorrelationMetricType::WindowSumsImageType   WindowSumsImageType;
+
+  typedef typename NeighborhoodCorrelationMetricType::InternalComputationValueType InternalComputationValueType;
+
+  /** Set/Get the pass of the next execution: 0 to evaluate the images, or
+   * \c d+1 to sum along the dimension \c d. */
+  itkSetMacro( Pass, unsigned int );
+  itkGetConstMacro( Pass, unsigned int );
+
+protected:
+  ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader() :
+    m_Pass( 0 )
+  {}
+
+  /** Evaluate the images at, or sum the lines starting at, the voxels of
+   * the sub domain. */
+  virtual void ThreadedExecution( const DomainType & subdomain,
+                                  const ThreadIdType threadId ) ITK_OVERRIDE;
+
+private:
+  ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  /** Store the products of the fixed and moving values at each voxel. */
+  void EvaluateImages( const DomainType & subdomain ) const;
+
+  /** Replace the values along the lines of dimension \c dimension by their
+   * sums over the sliding window. */
+  void SumLines( const DomainType & subdomain, const unsigned int dimension ) const;
+
+  unsigned int m_Pass;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader.hxx"
+#endif
+
+#endif
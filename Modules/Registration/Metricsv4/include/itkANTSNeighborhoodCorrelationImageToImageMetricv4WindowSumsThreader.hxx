@@ -0,0 +1,182 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader_hxx
+#define itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader_hxx
+
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader.h"
+
+#include "itkImageRegionIteratorWithIndex.h"
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+template < typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader< TNeighborhoodCorrelationMetric >
+::ThreadedExecution( const DomainType & subdomain,
+                     const ThreadIdType itkNotUsed(threadId) )
+{
+  if( this->m_Pass == 0 )
+    {
+    this->EvaluateImages( subdomain );
+    }
+  else
+    {
+    this->SumLines( subdomain, this->m_Pass - 1 );
+    }
+}
+
+template < typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader< TNeighborhoodCorrelationMetric >
+::EvaluateImages( const DomainType & subdomain ) const
+{
+  typedef InternalComputationValueType LocalRealType;
+
+  const AssociateType * associate = this->m_Associate;
+  const LocalRealType   localZero = NumericTraits< LocalRealType >::ZeroValue();
+  const LocalRealType   localOne = NumericTraits< LocalRealType >::OneValue();
+
+  VirtualPointType                                                   virtualPoint;
+  typename NeighborhoodCorrelationMetricType::FixedImagePointType    mappedFixedPoint;
+  typename NeighborhoodCorrelationMetricType::FixedImagePixelType    fixedImageValue;
+  typename NeighborhoodCorrelationMetricType::MovingImagePointType   mappedMovingPoint;
+  typename NeighborhoodCorrelationMetricType::MovingImagePixelType   movingImageValue;
+  WindowSumsType                                                     sums;
+
+  ImageRegionIteratorWithIndex< WindowSumsImageType > it( associate->m_WindowSumsImage, subdomain );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    associate->TransformVirtualIndexToPhysicalPoint( it.GetIndex(), virtualPoint );
+
+    bool pointIsValid;
+    try
+      {
+      pointIsValid = associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
+      if( pointIsValid )
+        {
+        pointIsValid = associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+        }
+      }
+    catch( ExceptionObject & exc )
+      {
+      //NOTE: there must be a cleaner way to do this:
+      std::string msg("Caught exception: \n");
+      msg += exc.what();
+      ExceptionObject err(__FILE__, __LINE__, msg);
+      throw err;
+      }
+
+    // The products are computed as in the scanning queues of the metric
+    // threader, so that both give the same sums up to the summation order.
+    if( pointIsValid )
+      {
+      sums[NeighborhoodCorrelationMetricType::SumFixed2] = fixedImageValue * fixedImageValue;
+      sums[NeighborhoodCorrelationMetricType::SumMoving2] = movingImageValue * movingImageValue;
+      sums[NeighborhoodCorrelationMetricType::SumFixed] = fixedImageValue;
+      sums[NeighborhoodCorrelationMetricType::SumMoving] = movingImageValue;
+      sums[NeighborhoodCorrelationMetricType::SumFixedMoving] = fixedImageValue * movingImageValue;
+      sums[NeighborhoodCorrelationMetricType::Count] = localOne;
+      }
+    else
+      {
+      sums.Fill( localZero );
+      }
+    it.Set( sums );
+    }
+}
+
+template < typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4WindowSumsThreader< TNeighborhoodCorrelationMetric >
+::SumLines( const DomainType & subdomain, const unsigned int dimension ) const
+{
+  typedef InternalComputationValueType LocalRealType;
+
+  const unsigned int numberOfSums = WindowSumsType::Dimension;
+
+  WindowSumsImageType * sumsImage = this->m_Associate->m_WindowSumsImage;
+  const OffsetValueType stride = sumsImage->GetOffsetTable()[dimension];
+  const SizeValueType   lineLength = sumsImage->GetBufferedRegion().GetSize( dimension );
+  const SizeValueType   radius = this->m_Associate->GetRadius()[dimension];
+
+  /* The line is cut in blocks of the window length. The sums from the start
+   * of its block to each position, and from each position to the end of its
+   * block, give the sum of any window as the sum of at most two of them, so
+   * that, unlike with running sums, a window sum never depends on the
+   * values outside of the window, whose rounding errors would otherwise
+   * accumulate along the line. */
+  const SizeValueType blockLength = 2 * radius + 1;
+  std::vector< WindowSumsType > prefix( lineLength );
+  std::vector< WindowSumsType > suffix( lineLength );
+
+  ImageRegionIteratorWithIndex< WindowSumsImageType > it( sumsImage, subdomain );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    WindowSumsType * lineBegin = sumsImage->GetBufferPointer() + sumsImage->ComputeOffset( it.GetIndex() );
+
+    WindowSumsType * value = lineBegin;
+    for( SizeValueType i = 0; i < lineLength; ++i, value += stride )
+      {
+      for( unsigned int s = 0; s < numberOfSums; ++s )
+        {
+        prefix[i][s] = ( i % blockLength == 0 ) ? (*value)[s] : prefix[i - 1][s] + (*value)[s];
+        }
+      }
+    for( SizeValueType i = lineLength; i-- > 0; )
+      {
+      value -= stride;
+      for( unsigned int s = 0; s < numberOfSums; ++s )
+        {
+        suffix[i][s] = ( ( i + 1 ) % blockLength == 0 || i + 1 == lineLength ) ? (*value)[s] : suffix[i + 1][s] + (*value)[s];
+        }
+      }
+
+    /* Sum of the window [i - radius, i + radius] clipped to the line. The
+     * window starts at the start of a block when it is within a block. */
+    value = lineBegin;
+    for( SizeValueType i = 0; i < lineLength; ++i, value += stride )
+      {
+      const SizeValueType first = ( i > radius ) ? i - radius : 0;
+      const SizeValueType last = std::min( i + radius, lineLength - 1 );
+      for( unsigned int s = 0; s < numberOfSums; ++s )
+        {
+        LocalRealType sum;
+        if( first / blockLength != last / blockLength )
+          {
+          sum = suffix[first][s] + prefix[last][s];
+          }
+        else if( first % blockLength == 0 )
+          {
+          sum = prefix[last][s];
+          }
+        else
+          {
+          sum = suffix[first][s];
+          }
+        (*value)[s] = sum;
+        }
+      }
+    }
+}
+
+} // end namespace itk
+
+#endif
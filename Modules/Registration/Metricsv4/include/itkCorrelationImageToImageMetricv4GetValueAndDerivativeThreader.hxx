@@ -28,7 +28,9 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner
 ::CorrelationImageToImageMetricv4GetValueAndDerivativeThreader() :
   m_CorrelationMetricValueDerivativePerThreadVariables( ITK_NULLPTR ),
   m_CorrelationAssociate( ITK_NULLPTR )
-{}
+{
+  this->m_SupportsSparseJacobian = true;
+}
 
 
 template<typename TDomainPartitioner, typename TImageToImageMetric, typename TCorrelationMetric>
@@ -290,17 +292,10 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
   if( this->m_CorrelationAssociate->GetComputeDerivative() )
     {
     /* Use a pre-allocated jacobian object for efficiency */
-    typedef typename TImageToImageMetric::JacobianType & JacobianReferenceType;
-    JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
-    JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
-
-    /** For dense transforms, this returns identity */
-    this->m_CorrelationAssociate->GetMovingTransform()->
-      ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                              jacobian,
-                                                              jacobianPositional);
+    const NumberOfParametersType numberOfLocalDerivatives = this->ComputeMovingTransformJacobian( virtualPoint, threadId );
+    const typename TImageToImageMetric::JacobianType & jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
 
-    for (unsigned int par = 0; par < this->m_CorrelationAssociate->GetNumberOfLocalParameters(); par++)
+    for (unsigned int par = 0; par < numberOfLocalDerivatives; par++)
       {
       InternalComputationValueType sum = NumericTraits< InternalComputationValueType >::ZeroValue();
       for (SizeValueType dim = 0; dim < ImageToImageMetricv4Type::MovingImageDimension; dim++)
@@ -308,8 +303,12 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
         sum += movingImageGradient[dim] * jacobian(dim, par);
         }
 
-      cumsum.fdm[par] += f1 * sum;
-      cumsum.mdm[par] += m1 * sum;
+      /* With a sparse jacobian, only the parameters supporting the point
+       * are visited. */
+      const NumberOfParametersType parameter = this->m_UseSparseJacobian ?
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].NonZeroJacobianIndices[par] : par;
+      cumsum.fdm[parameter] += f1 * sum;
+      cumsum.mdm[parameter] += m1 * sum;
       }
     }
 
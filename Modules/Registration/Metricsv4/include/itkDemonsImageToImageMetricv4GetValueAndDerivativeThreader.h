@@ -66,7 +66,9 @@ public:
 protected:
   DemonsImageToImageMetricv4GetValueAndDerivativeThreader() :
     m_DemonsAssociate(ITK_NULLPTR)
-  {}
+  {
+    this->m_SupportsCachedFixedSampledPointValues = true;
+  }
 
   /** Overload.
    *  Get pointer to metric object.
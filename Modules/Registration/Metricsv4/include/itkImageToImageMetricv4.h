@@ -31,6 +31,8 @@
 #include "itkPointSet.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkDefaultImageToImageMetricTraitsv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <vector>
 
 namespace itk
 {
@@ -99,13 +101,15 @@ namespace itk
  * Point sets are set via SetFixedSampledPointSet, and the point set is enabled
  * for use by calling SetUseFixedSampledPointSet.
  * \note If the point set is sparse, the option SetUse[Fixed|Moving]ImageGradientFilter
- * typically should be disabled to avoid excessive computation. However,
- * the gradient values of the fixed image are not cached
- * when using a point set (there are plans for this in the future), so
- * depending on the number of iterations (when used during optimization)
- * and the level of sparsity, it may be more efficient to
- * use a gradient image filter for it because it will only be
- * calculated once.
+ * typically should be disabled to avoid excessive computation. The values
+ * and gradients of the fixed image at the sampled points are computed once
+ * in Initialize() (see SetCacheFixedSampledPointValues), so only the moving
+ * image gradients are computed at each evaluation.
+ *
+ * The sampled points are sorted along a Z-order (Morton) curve of the
+ * virtual domain, so that consecutive points access nearby memory in the
+ * images.  A stochastic evaluation over a different subset of the points at
+ * each iteration is enabled by SetNumberOfSampledPointsPerIteration.
  *
  * Vector Images
  *
@@ -427,6 +431,24 @@ public:
   itkGetConstReferenceMacro(UseFixedSampledPointSet, bool);
   itkBooleanMacro(UseFixedSampledPointSet);
 
+  /** Set/Get flag to compute the fixed image values at the sampled points,
+   * and the fixed image gradients when the gradient source includes the
+   * fixed image, once in Initialize() instead of at each evaluation.  The
+   * cached values are not used if the fixed transform is modified after
+   * Initialize(). True by default. */
+  itkSetMacro(CacheFixedSampledPointValues, bool);
+  itkGetConstReferenceMacro(CacheFixedSampledPointValues, bool);
+  itkBooleanMacro(CacheFixedSampledPointValues);
+
+  /** Set/Get the number of sampled points used by each evaluation. The
+   * sorted sampled points are split into this number of strata of
+   * consecutive points, and a random point of each stratum is drawn at each
+   * iteration, so that the subset covers the virtual domain and is visited
+   * in a memory coherent order. Zero (default), or a number not less than
+   * the number of sampled points, uses all the points. */
+  itkSetMacro(NumberOfSampledPointsPerIteration, SizeValueType);
+  itkGetConstMacro(NumberOfSampledPointsPerIteration, SizeValueType);
+
   /** Get the virtual domain sampling point set */
   itkGetModifiableObjectMacro(VirtualSampledPointSet, VirtualPointSetType);
 
@@ -436,6 +458,17 @@ public:
   itkSetObjectMacro( MovingImageGradientFilter, MovingImageGradientFilterType );
   itkGetModifiableObjectMacro(MovingImageGradientFilter, MovingImageGradientFilterType );
 
+  /** Get whether the gradient filters are the default ones, i.e.
+   * not set by the user. */
+  bool GetFixedImageGradientFilterIsDefault() const
+    {
+    return this->m_FixedImageGradientFilter.GetPointer() == this->m_DefaultFixedImageGradientFilter.GetPointer();
+    }
+  bool GetMovingImageGradientFilterIsDefault() const
+    {
+    return this->m_MovingImageGradientFilter.GetPointer() == this->m_DefaultMovingImageGradientFilter.GetPointer();
+    }
+
   /** Set/Get gradient calculators */
   itkSetObjectMacro( FixedImageGradientCalculator, FixedImageGradientCalculatorType);
   itkGetModifiableObjectMacro(FixedImageGradientCalculator, FixedImageGradientCalculatorType);
@@ -493,7 +526,9 @@ public:
   /** Get the number of points in the domain used to evaluate
    * the metric. This will differ depending on whether a sampled
    * point set or dense sampling is used, and will be greater than
-   * or equal to GetNumberOfValidPoints(). */
+   * or equal to GetNumberOfValidPoints(). With a sampled point set, it is
+   * the number of points of the current evaluation, see
+   * SetNumberOfSampledPointsPerIteration(). */
   SizeValueType GetNumberOfDomainPoints() const;
 
   /** Set/Get the option for applying floating point resolution truncation
@@ -520,6 +555,19 @@ public:
   itkSetMacro( FloatingPointCorrectionResolution, DerivativeValueType );
   itkGetConstMacro( FloatingPointCorrectionResolution, DerivativeValueType );
 
+  /** Set/Get the option for computing the derivatives from the compact
+   * Jacobian of the moving transform, see
+   * Transform::ComputeSparseJacobianWithRespectToParameters. True by default.
+   * With a transform whose parameters have a compact support, like the
+   * BSplineTransform, only the parameters supporting a point are then
+   * visited for this point, instead of all the parameters of the transform.
+   * It has no effect with transforms with local support, or when a point
+   * depends on all the parameters of the transform, and it is only used
+   * by the metrics whose threaders support it. */
+  itkSetMacro(UseSparseJacobian, bool);
+  itkGetConstReferenceMacro(UseSparseJacobian, bool);
+  itkBooleanMacro(UseSparseJacobian);
+
   /* Initialize the metric before calling GetValue or GetDerivative.
    * Derived classes must call this Superclass version if they override
    * this to perform their own initialization.
@@ -697,15 +745,53 @@ protected:
   /** Flag to use FixedSampledPointSet, i.e. Sparse sampling. */
   bool                                    m_UseFixedSampledPointSet;
 
+  /** Get the identifier, in the virtual sampled point set, of the
+   * \c i-th point of the current evaluation. */
+  SizeValueType GetVirtualSampledPointIdentifier( const SizeValueType i ) const
+    {
+    return this->m_VirtualSampledPointSelection.empty() ? i : this->m_VirtualSampledPointSelection[i];
+    }
+
+  /** Virtual indices of the points of the virtual sampled point set. */
+  std::vector< VirtualIndexType >         m_VirtualSampledPointIndices;
+
+  /** Mapped fixed points, fixed pixel values, fixed image gradients and
+   * validity of the points of the virtual sampled point set, computed in
+   * Initialize() when CacheFixedSampledPointValues is set. */
+  std::vector< FixedImagePointType >      m_FixedSampledMappedPoints;
+  std::vector< FixedImagePixelType >      m_FixedSampledPixelValues;
+  std::vector< FixedImageGradientType >   m_FixedSampledImageGradients;
+  std::vector< bool >                     m_FixedSampledPointIsValid;
+
+  /** Whether the current evaluation uses the cached fixed values. */
+  mutable bool                            m_UseCachedFixedSampledPointValues;
+
+  /** Identifiers of the points of the current evaluation, when it uses a
+   * subset of the virtual sampled point set. Empty otherwise. */
+  mutable std::vector< SizeValueType >    m_VirtualSampledPointSelection;
+
+  /** A subclass whose evaluation makes several passes over the points
+   * sets it before each pass after the first one, so that
+   * InitializeForIteration() keeps the subset of the virtual sampled
+   * points drawn for the first pass. InitializeForIteration() resets it. */
+  mutable bool                            m_KeepVirtualSampledPointSelection;
+
   ImageToImageMetricv4();
   virtual ~ImageToImageMetricv4();
 
   void PrintSelf(std::ostream& os, Indent indent) const ITK_OVERRIDE;
 
 private:
-  /** Map the fixed point set samples to the virtual domain */
+  /** Map the fixed point set samples to the virtual domain, and sort them
+   * along a Z-order curve of the virtual domain. */
   void MapFixedSampledPointSetToVirtual();
 
+  /** Compute the fixed values at the virtual sampled points. */
+  void ComputeFixedSampledPointValues();
+
+  /** Draw the subset of the virtual sampled points of the current evaluation. */
+  void SelectVirtualSampledPoints() const;
+
   /** Transform a point. Avoid cast if possible */
   void LocalTransformPoint(const typename FixedTransformType::OutputPointType &virtualPoint,
                            typename FixedTransformType::OutputPointType &mappedFixedPoint) const
@@ -763,6 +849,15 @@ private:
   bool                m_UseFloatingPointCorrection;
   DerivativeValueType m_FloatingPointCorrectionResolution;
 
+  bool                m_UseSparseJacobian;
+
+  bool                m_CacheFixedSampledPointValues;
+  bool                m_FixedSampledImageGradientsAreCached;
+  ModifiedTimeType    m_FixedSampledPointValuesTransformMTime;
+
+  SizeValueType       m_NumberOfSampledPointsPerIteration;
+  typename Statistics::MersenneTwisterRandomVariateGenerator::Pointer m_SampledPointSelectionGenerator;
+
   MetricTraits m_MetricTraits;
 
   /** Flag to know if derivative should be calculated */
@@ -24,6 +24,7 @@
 #include "itkCompositeTransform.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkIdentityTransform.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -69,6 +70,15 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
 
   this->m_FloatingPointCorrectionResolution = 1e6;
   this->m_UseFloatingPointCorrection = false;
+  this->m_UseSparseJacobian = true;
+
+  this->m_CacheFixedSampledPointValues = true;
+  this->m_FixedSampledImageGradientsAreCached = false;
+  this->m_FixedSampledPointValuesTransformMTime = 0;
+  this->m_UseCachedFixedSampledPointValues = false;
+  this->m_KeepVirtualSampledPointSelection = false;
+  this->m_NumberOfSampledPointsPerIteration = 0;
+  this->m_SampledPointSelectionGenerator = Statistics::MersenneTwisterRandomVariateGenerator::New();
 
   this->m_HaveMadeGetValueWarning = false;
   this->m_NumberOfSkippedFixedSampledPoints = 0;
@@ -193,6 +203,24 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     itkDebugMacro("Initialize: ComputeMovingImageGradientFilterImage");
     this->ComputeMovingImageGradientFilterImage();
     }
+
+  /* The fixed image does not move during the optimization, so its values at
+   * the sampled points are computed once. */
+  this->m_FixedSampledMappedPoints.clear();
+  this->m_FixedSampledPixelValues.clear();
+  this->m_FixedSampledImageGradients.clear();
+  this->m_FixedSampledPointIsValid.clear();
+  this->m_VirtualSampledPointSelection.clear();
+  this->m_UseCachedFixedSampledPointValues = false;
+  if( this->m_UseFixedSampledPointSet )
+    {
+    if( this->m_CacheFixedSampledPointValues )
+      {
+      itkDebugMacro("Initialize: ComputeFixedSampledPointValues");
+      this->ComputeFixedSampledPointValues();
+      }
+    this->m_SampledPointSelectionGenerator->SetSeed( 1234 );
+    }
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -280,6 +308,24 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     /* Clear derivative final result. */
     this->m_DerivativeResult->Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
     }
+
+  if( this->m_UseFixedSampledPointSet )
+    {
+    /* The cached fixed values are only valid for the fixed transform they
+     * were computed with. */
+    this->m_UseCachedFixedSampledPointValues =
+      this->m_CacheFixedSampledPointValues &&
+      this->m_FixedSampledPointIsValid.size() == this->m_VirtualSampledPointSet->GetNumberOfPoints() &&
+      this->m_FixedSampledPointValuesTransformMTime == this->m_FixedTransform->GetMTime() &&
+      ( this->m_FixedSampledImageGradientsAreCached || ! this->GetGradientSourceIncludesFixed() );
+
+    /* All the passes of an evaluation use the same subset. */
+    if( ! this->m_KeepVirtualSampledPointSelection )
+      {
+      this->SelectVirtualSampledPoints();
+      }
+    }
+  this->m_KeepVirtualSampledPointSelection = false;
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -541,8 +587,21 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
                       " point set.");
     }
 
+  /* Key each valid point by its Z-order (Morton) code in the virtual
+   * region: the code interleaves the bits of the index offsets, so that
+   * points sorted by code are grouped in small blocks of the domain. */
+  typedef std::pair< uint64_t, SizeValueType > SortKeyType;
+  const unsigned int bitsPerDimension = 64 / VirtualImageDimension;
+  const VirtualIndexType regionIndex = this->GetVirtualRegion().GetIndex();
+
+  std::vector< typename FixedSampledPointSetType::PointType > validPoints;
+  std::vector< VirtualIndexType >                             validIndices;
+  std::vector< SortKeyType >                                  sortKeys;
+  validPoints.reserve( points->Size() );
+  validIndices.reserve( points->Size() );
+  sortKeys.reserve( points->Size() );
+
   this->m_NumberOfSkippedFixedSampledPoints = 0;
-  SizeValueType virtualIndex = 0;
   while( fixedIt != points->End() )
     {
     typename FixedSampledPointSetType::PointType point = inverseTransform->TransformPoint( fixedIt.Value() );
@@ -551,8 +610,18 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
      * and a fixed sampled point list that was created before the resizing. */
     if( this->TransformPhysicalPointToVirtualIndex( point, tempIndex ) )
       {
-      this->m_VirtualSampledPointSet->SetPoint( virtualIndex, point );
-      virtualIndex++;
+      uint64_t code = 0;
+      for( unsigned int bit = 0; bit < bitsPerDimension; bit++ )
+        {
+        for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+          {
+          const uint64_t offset = static_cast< uint64_t >( tempIndex[d] - regionIndex[d] );
+          code |= ( ( offset >> bit ) & 1 ) << ( bit * VirtualImageDimension + d );
+          }
+        }
+      sortKeys.push_back( SortKeyType( code, static_cast< SizeValueType >( validPoints.size() ) ) );
+      validPoints.push_back( point );
+      validIndices.push_back( tempIndex );
       }
     else
       {
@@ -560,12 +629,82 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
       }
     ++fixedIt;
     }
-  if( this->m_VirtualSampledPointSet->GetNumberOfPoints() == 0 )
+  if( validPoints.empty() )
     {
     itkExceptionMacro("The virtual sampled point set has zero points because "
                       "no fixed sampled points were within the virtual "
                       "domain after mapping. There are no points to evaulate.");
     }
+
+  /* Ties keep the order of the fixed sampled point set. */
+  std::sort( sortKeys.begin(), sortKeys.end() );
+
+  typename VirtualPointSetType::PointsContainer * virtualPoints = this->m_VirtualSampledPointSet->GetPoints();
+  virtualPoints->Reserve( validPoints.size() );
+  this->m_VirtualSampledPointIndices.resize( validPoints.size() );
+  for( SizeValueType n = 0; n < sortKeys.size(); n++ )
+    {
+    virtualPoints->SetElement( n, validPoints[sortKeys[n].second] );
+    this->m_VirtualSampledPointIndices[n] = validIndices[sortKeys[n].second];
+    }
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::ComputeFixedSampledPointValues()
+{
+  const SizeValueType numberOfPoints = this->m_VirtualSampledPointSet->GetNumberOfPoints();
+  const typename VirtualPointSetType::PointsContainer * virtualPoints = this->m_VirtualSampledPointSet->GetPoints();
+
+  FixedImageGradientType zeroGradient;
+  zeroGradient.Fill( NumericTraits< typename FixedImageGradientType::ValueType >::ZeroValue() );
+
+  this->m_FixedSampledImageGradientsAreCached = this->GetGradientSourceIncludesFixed();
+  this->m_FixedSampledMappedPoints.resize( numberOfPoints );
+  this->m_FixedSampledPixelValues.resize( numberOfPoints );
+  this->m_FixedSampledImageGradients.assign( numberOfPoints, zeroGradient );
+  this->m_FixedSampledPointIsValid.assign( numberOfPoints, false );
+  for( SizeValueType n = 0; n < numberOfPoints; n++ )
+    {
+    const bool pointIsValid = this->TransformAndEvaluateFixedPoint( virtualPoints->ElementAt( n ),
+                                                                    this->m_FixedSampledMappedPoints[n],
+                                                                    this->m_FixedSampledPixelValues[n] );
+    if( pointIsValid && this->m_FixedSampledImageGradientsAreCached )
+      {
+      this->ComputeFixedImageGradientAtPoint( this->m_FixedSampledMappedPoints[n], this->m_FixedSampledImageGradients[n] );
+      }
+    this->m_FixedSampledPointIsValid[n] = pointIsValid;
+    }
+  this->m_FixedSampledPointValuesTransformMTime = this->m_FixedTransform->GetMTime();
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::SelectVirtualSampledPoints() const
+{
+  const SizeValueType numberOfPoints = this->m_VirtualSampledPointSet->GetNumberOfPoints();
+  const SizeValueType numberOfSelectedPoints = this->m_NumberOfSampledPointsPerIteration;
+  if( numberOfSelectedPoints == 0 || numberOfSelectedPoints >= numberOfPoints )
+    {
+    this->m_VirtualSampledPointSelection.clear();
+    return;
+    }
+
+  /* Draw one point in each stratum of consecutive points. The selection
+   * keeps its storage from one iteration to the next. */
+  this->m_VirtualSampledPointSelection.resize( numberOfSelectedPoints );
+  for( SizeValueType s = 0; s < numberOfSelectedPoints; s++ )
+    {
+    const SizeValueType stratumBegin = static_cast< SizeValueType >(
+      static_cast< uint64_t >( s ) * numberOfPoints / numberOfSelectedPoints );
+    const SizeValueType stratumEnd = static_cast< SizeValueType >(
+      static_cast< uint64_t >( s + 1 ) * numberOfPoints / numberOfSelectedPoints );
+    this->m_VirtualSampledPointSelection[s] = stratumBegin +
+      this->m_SampledPointSelectionGenerator->GetIntegerVariate( static_cast<
+        Statistics::MersenneTwisterRandomVariateGenerator::IntegerType >( stratumEnd - stratumBegin - 1 ) );
+    }
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -577,6 +716,10 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     {
     //The virtual sampled point set holds the actual points
     // over which we're evaluating over.
+    if( ! this->m_VirtualSampledPointSelection.empty() )
+      {
+      return static_cast< SizeValueType >( this->m_VirtualSampledPointSelection.size() );
+      }
     return this->m_VirtualSampledPointSet->GetNumberOfPoints();
     }
   else
@@ -597,7 +740,10 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
      << indent << "GetUseFixedImageGradientFilter: " << this->GetUseFixedImageGradientFilter() << std::endl
      << indent << "GetUseMovingImageGradientFilter: " << this->GetUseMovingImageGradientFilter() << std::endl
      << indent << "UseFloatingPointCorrection: " << this->GetUseFloatingPointCorrection() << std::endl
-     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl;
+     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl
+     << indent << "UseSparseJacobian: " << this->GetUseSparseJacobian() << std::endl
+     << indent << "CacheFixedSampledPointValues: " << this->GetCacheFixedSampledPointValues() << std::endl
+     << indent << "NumberOfSampledPointsPerIteration: " << this->GetNumberOfSampledPointsPerIteration() << std::endl;
 
   itkPrintSelfObjectMacro( FixedImage );
   itkPrintSelfObjectMacro( MovingImage );
@@ -169,8 +169,8 @@ protected:
   /** Constructor. */
   ImageToImageMetricv4GetValueAndDerivativeThreader() {}
 
-  /** Walk through the given virtual image domain, and call \c ProcessVirtualPoint on every
-   * point. */
+  /** Walk through the given range of the points of the current evaluation,
+   * and call \c ProcessVirtualSampledPoint on every point. */
   virtual void ThreadedExecution( const DomainType & subdomain,
                                   const ThreadIdType threadId ) ITK_OVERRIDE;
 
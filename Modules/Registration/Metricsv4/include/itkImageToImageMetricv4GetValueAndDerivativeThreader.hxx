@@ -55,17 +55,13 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerParti
   //Initialize per thread buffers and variables.
   this->m_Associate->InitializeThread( threadId );
 
-  typename TImageToImageMetricv4::VirtualPointSetType::ConstPointer virtualSampledPointSet = this->m_Associate->GetVirtualSampledPointSet();
-  typedef typename TImageToImageMetricv4::VirtualPointSetType::MeshTraits::PointIdentifier ElementIdentifierType;
-  const ElementIdentifierType begin = indexSubRange[0];
-  const ElementIdentifierType end   = indexSubRange[1];
-  VirtualIndexType virtualIndex;
-  typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
-  for( ElementIdentifierType i = begin; i <= end; ++i )
+  /* The virtual indices of the sampled points, and possibly their fixed
+   * values, are cached by the metric. */
+  const SizeValueType begin = indexSubRange[0];
+  const SizeValueType end   = indexSubRange[1];
+  for( SizeValueType i = begin; i <= end; ++i )
     {
-    const VirtualPointType & virtualPoint = virtualSampledPointSet->GetPoint( i );
-    virtualImage->TransformPhysicalPointToIndex( virtualPoint, virtualIndex );
-    this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    this->ProcessVirtualSampledPoint( this->m_Associate->GetVirtualSampledPointIdentifier( i ), threadId );
     }
   //Finalize per thread actions
   this->m_Associate->FinalizeThread( threadId );
@@ -74,6 +74,7 @@ public:
   typedef typename FixedTransformType::OutputPointType               FixedOutputPointType;
   typedef typename ImageToImageMetricv4Type::MovingTransformType     MovingTransformType;
   typedef typename MovingTransformType::OutputPointType              MovingOutputPointType;
+  typedef typename MovingTransformType::NonZeroJacobianIndicesType   NonZeroJacobianIndicesType;
 
   typedef typename ImageToImageMetricv4Type::MeasureType             MeasureType;
   typedef typename ImageToImageMetricv4Type::DerivativeType          DerivativeType;
@@ -114,6 +115,21 @@ protected:
                                     const VirtualPointType & virtualPoint,
                                     const ThreadIdType threadId );
 
+  /** Method called by the sparse threaders to process the point \c id of the
+   * virtual sampled point set. It uses the fixed values cached by the metric
+   * when the derived class supports them and they are valid, and calls
+   * \c ProcessVirtualPoint otherwise. */
+  bool ProcessVirtualSampledPoint( const SizeValueType id, const ThreadIdType threadId );
+
+  /** Evaluate the moving image at the virtual point, and call \c ProcessPoint
+   * with the given fixed values. */
+  bool ProcessVirtualPointWithFixedValues( const VirtualIndexType & virtualIndex,
+                                           const VirtualPointType & virtualPoint,
+                                           const FixedImagePointType & mappedFixedPoint,
+                                           const FixedImagePixelType & mappedFixedPixelValue,
+                                           const FixedImageGradientType & mappedFixedImageGradient,
+                                           const ThreadIdType threadId );
+
   /** Method to calculate the metric value and derivative
    * given a point, value and image derivative for both fixed and moving
    * spaces. The provided values have been calculated from \c virtualPoint,
@@ -157,11 +173,25 @@ protected:
 
 
   /** Store derivative result from a single point calculation.
+   * With a sparse Jacobian, the local derivatives are added to the
+   * parameters listed in the per-thread NonZeroJacobianIndices.
    * \warning If this method is overridden or otherwise not used
    * in a derived class, be sure to *accumulate* results. */
   virtual void StorePointDerivativeResult( const VirtualIndexType & virtualIndex,
                                            const ThreadIdType threadId );
 
+  /** Compute the Jacobian of the moving transform with respect to its
+   * parameters at \c virtualPoint into the per-thread
+   * MovingTransformJacobian, and return its number of columns, which is
+   * also the number of local derivatives to compute. With a sparse
+   * Jacobian, the column \c i is the derivative with respect to the
+   * parameter NonZeroJacobianIndices[i]; otherwise the columns are the
+   * local parameters of the transform. Derived classes calling this
+   * method instead of computing the Jacobian of the transform themselves
+   * must set m_SupportsSparseJacobian in their constructor. */
+  NumberOfParametersType ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint,
+                                                         const ThreadIdType threadId ) const;
+
   struct GetValueAndDerivativePerThreadStruct
     {
     /** Intermediary threaded metric value storage. */
@@ -178,6 +208,9 @@ protected:
      * classes for efficiency. */
     JacobianType                 MovingTransformJacobian;
     JacobianType                 MovingTransformJacobianPositional;
+    /** Parameters of the columns of MovingTransformJacobian, with a sparse
+     * Jacobian. */
+    NonZeroJacobianIndicesType   NonZeroJacobianIndices;
     };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, GetValueAndDerivativePerThreadStruct,
                                             PaddedGetValueAndDerivativePerThreadStruct);
@@ -189,6 +222,24 @@ protected:
    *  These will only be set once threading has been started. */
   mutable NumberOfParametersType                      m_CachedNumberOfParameters;
   mutable NumberOfParametersType                      m_CachedNumberOfLocalParameters;
+  mutable NumberOfParametersType                      m_CachedNumberOfNonZeroJacobianIndices;
+
+  /** Whether the derived class computes its derivatives with
+   * ComputeMovingTransformJacobian, and thus supports a sparse Jacobian.
+   * False by default. */
+  bool                                                m_SupportsSparseJacobian;
+
+  /** Whether the derived class processes the points in \c ProcessPoint
+   * only, without overriding \c ProcessVirtualPoint, and can thus use the
+   * fixed values cached by the metric at the sampled points. Derived classes
+   * must set it in their constructor. False by default. */
+  bool                                                m_SupportsCachedFixedSampledPointValues;
+
+  /** Whether the Jacobian of the moving transform is sparse during the
+   * current evaluation. Set in BeforeThreadedExecution, when the metric
+   * allows it and a point depends on less parameters than the transform
+   * has. */
+  mutable bool                                        m_UseSparseJacobian;
 
 private:
   ImageToImageMetricv4GetValueAndDerivativeThreaderBase( const Self & ); // purposely not implemented
@@ -29,7 +29,11 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
 ::ImageToImageMetricv4GetValueAndDerivativeThreaderBase():
   m_GetValueAndDerivativePerThreadVariables( ITK_NULLPTR ),
   m_CachedNumberOfParameters( 0 ),
-  m_CachedNumberOfLocalParameters( 0 )
+  m_CachedNumberOfLocalParameters( 0 ),
+  m_CachedNumberOfNonZeroJacobianIndices( 0 ),
+  m_SupportsSparseJacobian( false ),
+  m_SupportsCachedFixedSampledPointValues( false ),
+  m_UseSparseJacobian( false )
 {
 }
 
@@ -52,6 +56,20 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   this->m_CachedNumberOfParameters      = this->m_Associate->GetNumberOfParameters();
   this->m_CachedNumberOfLocalParameters = this->m_Associate->GetNumberOfLocalParameters();
 
+  /* Use the compact Jacobian of the moving transform when a point depends
+   * on only a few of its parameters. */
+  this->m_UseSparseJacobian = false;
+  if( this->m_SupportsSparseJacobian &&
+      this->m_Associate->GetComputeDerivative() &&
+      this->m_Associate->GetUseSparseJacobian() &&
+      this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
+    {
+    this->m_CachedNumberOfNonZeroJacobianIndices = this->m_Associate->m_MovingTransform->GetNumberOfNonZeroJacobianIndices();
+    this->m_UseSparseJacobian = ( this->m_CachedNumberOfNonZeroJacobianIndices < this->m_CachedNumberOfParameters );
+    }
+  const NumberOfParametersType numberOfJacobianColumns = this->m_UseSparseJacobian ?
+    this->m_CachedNumberOfNonZeroJacobianIndices : this->m_CachedNumberOfLocalParameters;
+
   /* Per-thread results */
   const ThreadIdType numThreadsUsed = this->GetNumberOfThreadsUsed();
   delete[] m_GetValueAndDerivativePerThreadVariables;
@@ -63,9 +81,13 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
       {
       /* Allocate intermediary per-thread storage used to get results from
        * derived classes */
-      this->m_GetValueAndDerivativePerThreadVariables[i].LocalDerivatives.SetSize( this->m_CachedNumberOfLocalParameters );
+      this->m_GetValueAndDerivativePerThreadVariables[i].LocalDerivatives.SetSize( numberOfJacobianColumns );
       this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformJacobian.SetSize(
-        this->m_Associate->VirtualImageDimension, this->m_CachedNumberOfLocalParameters );
+        this->m_Associate->VirtualImageDimension, numberOfJacobianColumns );
+      if( this->m_UseSparseJacobian )
+        {
+        this->m_GetValueAndDerivativePerThreadVariables[i].NonZeroJacobianIndices.resize( numberOfJacobianColumns );
+        }
       this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformJacobianPositional.SetSize(
         this->m_Associate->VirtualImageDimension, this->m_Associate->VirtualImageDimension );
       if ( this->m_Associate->m_MovingTransform->GetTransformCategory() == MovingTransformType::DisplacementField )
@@ -183,11 +205,7 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   FixedImagePointType         mappedFixedPoint;
   FixedImagePixelType         mappedFixedPixelValue;
   FixedImageGradientType      mappedFixedImageGradient;
-  MovingImagePointType        mappedMovingPoint;
-  MovingImagePixelType        mappedMovingPixelValue;
-  MovingImageGradientType     mappedMovingImageGradient;
   bool                        pointIsValid = false;
-  MeasureType                 metricValueResult;
 
   /* Transform the point into fixed and moving spaces, and evaluate.
    * Do this in a try block to catch exceptions and print more useful info
@@ -215,6 +233,51 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     return pointIsValid;
     }
 
+  return this->ProcessVirtualPointWithFixedValues( virtualIndex, virtualPoint,
+                                                   mappedFixedPoint, mappedFixedPixelValue, mappedFixedImageGradient,
+                                                   threadId );
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+bool
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ProcessVirtualSampledPoint( const SizeValueType id, const ThreadIdType threadId )
+{
+  const TImageToImageMetricv4 * associate = this->m_Associate;
+  const VirtualIndexType & virtualIndex = associate->m_VirtualSampledPointIndices[id];
+  const VirtualPointType & virtualPoint = associate->m_VirtualSampledPointSet->GetPoints()->ElementAt( id );
+
+  if( !( this->m_SupportsCachedFixedSampledPointValues && associate->m_UseCachedFixedSampledPointValues ) )
+    {
+    return this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    }
+  if( !associate->m_FixedSampledPointIsValid[id] )
+    {
+    return false;
+    }
+  return this->ProcessVirtualPointWithFixedValues( virtualIndex, virtualPoint,
+                                                   associate->m_FixedSampledMappedPoints[id],
+                                                   associate->m_FixedSampledPixelValues[id],
+                                                   associate->m_FixedSampledImageGradients[id],
+                                                   threadId );
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+bool
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ProcessVirtualPointWithFixedValues( const VirtualIndexType & virtualIndex,
+                                      const VirtualPointType & virtualPoint,
+                                      const FixedImagePointType & mappedFixedPoint,
+                                      const FixedImagePixelType & mappedFixedPixelValue,
+                                      const FixedImageGradientType & mappedFixedImageGradient,
+                                      const ThreadIdType threadId )
+{
+  MovingImagePointType        mappedMovingPoint;
+  MovingImagePixelType        mappedMovingPixelValue;
+  MovingImageGradientType     mappedMovingImageGradient;
+  bool                        pointIsValid = false;
+  MeasureType                 metricValueResult;
+
   try
     {
     pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
@@ -281,18 +344,32 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
     {
     /* Global support */
+    const NumberOfParametersType numberOfLocalDerivatives = this->m_UseSparseJacobian ?
+      this->m_CachedNumberOfNonZeroJacobianIndices : this->m_CachedNumberOfParameters;
     if ( this->m_Associate->GetUseFloatingPointCorrection() )
       {
       DerivativeValueType correctionResolution = this->m_Associate->GetFloatingPointCorrectionResolution();
-      for (NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; p++ )
+      for (NumberOfParametersType p = 0; p < numberOfLocalDerivatives; p++ )
         {
         intmax_t test = static_cast< intmax_t >( this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p] * correctionResolution );
         this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p] = static_cast<DerivativeValueType>( test / correctionResolution );
         }
       }
-    for (NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; p++ )
+    if( this->m_UseSparseJacobian )
       {
-      this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[p] += this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p];
+      /* Scatter the derivatives to the parameters supporting the point */
+      const NonZeroJacobianIndicesType & nonZeroJacobianIndices = this->m_GetValueAndDerivativePerThreadVariables[threadId].NonZeroJacobianIndices;
+      for (NumberOfParametersType i = 0; i < numberOfLocalDerivatives; i++ )
+        {
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[nonZeroJacobianIndices[i]] += this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[i];
+        }
+      }
+    else
+      {
+      for (NumberOfParametersType p = 0; p < numberOfLocalDerivatives; p++ )
+        {
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[p] += this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives[p];
+        }
       }
     }
   else
@@ -321,6 +398,29 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     }
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+typename ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >::NumberOfParametersType
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ComputeMovingTransformJacobian( const VirtualPointType & virtualPoint, const ThreadIdType threadId ) const
+{
+  AlignedGetValueAndDerivativePerThreadStruct & threadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  if( this->m_UseSparseJacobian )
+    {
+    this->m_Associate->GetMovingTransform()->
+      ComputeSparseJacobianWithRespectToParameters( virtualPoint,
+                                                    threadVariables.MovingTransformJacobian,
+                                                    threadVariables.NonZeroJacobianIndices );
+    return this->m_CachedNumberOfNonZeroJacobianIndices;
+    }
+
+  /** For dense transforms, this returns identity */
+  this->m_Associate->GetMovingTransform()->
+    ComputeJacobianWithRespectToParametersCachedTemporaries( virtualPoint,
+                                                             threadVariables.MovingTransformJacobian,
+                                                             threadVariables.MovingTransformJacobianPositional );
+  return this->m_CachedNumberOfLocalParameters;
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
 bool
 ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
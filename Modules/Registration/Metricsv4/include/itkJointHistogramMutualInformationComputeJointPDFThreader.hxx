@@ -48,16 +48,24 @@ JointHistogramMutualInformationComputeJointPDFThreader< ThreadedIndexedContainer
 ::ThreadedExecution( const DomainType & indexSubRange,
                      const ThreadIdType threadId )
 {
-  VirtualPointType virtualPoint;
-  VirtualIndexType virtualIndex;
-  typedef typename VirtualPointSetType::MeshTraits::PointIdentifier ElementIdentifierType;
-  const ElementIdentifierType begin = indexSubRange[0];
-  const ElementIdentifierType end   = indexSubRange[1];
-  for( ElementIdentifierType i = begin; i <= end; ++i )
+  const AssociateType * associate = this->m_Associate;
+  const typename VirtualPointSetType::PointsContainer * virtualPoints = associate->m_VirtualSampledPointSet->GetPoints();
+  const SizeValueType begin = indexSubRange[0];
+  const SizeValueType end   = indexSubRange[1];
+  for( SizeValueType i = begin; i <= end; ++i )
     {
-    virtualPoint = this->m_Associate->m_VirtualSampledPointSet->GetPoint( i );
-    this->m_Associate->TransformPhysicalPointToVirtualIndex( virtualPoint, virtualIndex );
-    this->ProcessPoint( virtualIndex, virtualPoint, threadId );
+    const SizeValueType id = associate->GetVirtualSampledPointIdentifier( i );
+    if( associate->m_UseCachedFixedSampledPointValues )
+      {
+      if( associate->m_FixedSampledPointIsValid[id] )
+        {
+        this->ProcessPointWithFixedValue( virtualPoints->ElementAt( id ), associate->m_FixedSampledPixelValues[id], threadId );
+        }
+      }
+    else
+      {
+      this->ProcessPoint( associate->m_VirtualSampledPointIndices[id], virtualPoints->ElementAt( id ), threadId );
+      }
     }
 }
 
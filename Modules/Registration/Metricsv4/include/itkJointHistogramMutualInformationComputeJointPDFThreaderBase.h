@@ -73,6 +73,12 @@ protected:
                              const VirtualPointType & virtualPoint,
                              const ThreadIdType threadId );
 
+  /** Evaluate the moving image at the virtual point, and add the pair of
+   * the given fixed value and the moving value to the joint histogram. */
+  void ProcessPointWithFixedValue( const VirtualPointType & virtualPoint,
+                                   const typename AssociateType::Superclass::FixedImagePixelType & fixedImageValue,
+                                   const ThreadIdType threadId );
+
   /** Collect the results per and normalize. */
   virtual void AfterThreadedExecution() ITK_OVERRIDE;
 
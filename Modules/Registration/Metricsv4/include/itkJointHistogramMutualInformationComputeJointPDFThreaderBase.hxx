@@ -70,19 +70,41 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
 {
   typename AssociateType::Superclass::FixedImagePointType     mappedFixedPoint;
   typename AssociateType::Superclass::FixedImagePixelType     fixedImageValue;
-  typename AssociateType::Superclass::FixedImageGradientType  fixedImageGradients;
+  bool                                                        pointIsValid = false;
+
+  try
+    {
+    pointIsValid = this->m_Associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
+    }
+  catch( ExceptionObject & exc )
+    {
+    //NOTE: there must be a cleaner way to do this:
+    std::string msg("Caught exception: \n");
+    msg += exc.what();
+    ExceptionObject err(__FILE__, __LINE__, msg);
+    throw err;
+    }
+
+  if( pointIsValid )
+    {
+    this->ProcessPointWithFixedValue( virtualPoint, fixedImageValue, threadId );
+    }
+}
+
+template< typename TDomainPartitioner, typename TJointHistogramMetric >
+void
+JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
+::ProcessPointWithFixedValue( const VirtualPointType & virtualPoint,
+                              const typename AssociateType::Superclass::FixedImagePixelType & fixedImageValue,
+                              const ThreadIdType threadId )
+{
   typename AssociateType::Superclass::MovingImagePointType    mappedMovingPoint;
   typename AssociateType::Superclass::MovingImagePixelType    movingImageValue;
-  typename AssociateType::Superclass::MovingImageGradientType movingImageGradients;
   bool                                                        pointIsValid = false;
 
   try
     {
-    pointIsValid = this->m_Associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
-    if( pointIsValid )
-      {
-      pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
-      }
+    pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
     }
   catch( ExceptionObject & exc )
     {
@@ -28,7 +28,10 @@ JointHistogramMutualInformationGetValueAndDerivativeThreader< TDomainPartitioner
 ::JointHistogramMutualInformationGetValueAndDerivativeThreader() :
   m_JointHistogramMIPerThreadVariables( ITK_NULLPTR ),
   m_JointAssociate( ITK_NULLPTR )
-{}
+{
+  this->m_SupportsSparseJacobian = true;
+  this->m_SupportsCachedFixedSampledPointValues = true;
+}
 
 
 template< typename TDomainPartitioner, typename TImageToImageMetric, typename TJointHistogramMetric >
@@ -152,18 +155,12 @@ JointHistogramMutualInformationGetValueAndDerivativeThreader< TDomainPartitioner
     scalingfactor = NumericTraits< InternalComputationValueType >::ZeroValue();
     }
 
-  /* Use a pre-allocated jacobian object for efficiency */
-  typedef JacobianType & JacobianReferenceType;
-  JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
-  JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
-
-  /** For dense transforms, this returns identity */
-  this->m_JointAssociate->GetMovingTransform()->
-    ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                            jacobian,
-                                                            jacobianPositional);
+  /* Use a pre-allocated jacobian object for efficiency. With a sparse
+   * jacobian, only the parameters supporting the point are visited. */
+  const NumberOfParametersType numberOfLocalDerivatives = this->ComputeMovingTransformJacobian( virtualPoint, threadId );
+  const JacobianType & jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
 
-  for ( NumberOfParametersType par = 0; par < this->GetCachedNumberOfLocalParameters(); par++ )
+  for ( NumberOfParametersType par = 0; par < numberOfLocalDerivatives; par++ )
     {
     InternalComputationValueType sum = NumericTraits< InternalComputationValueType >::ZeroValue();
     for ( SizeValueType dim = 0; dim < TImageToImageMetric::MovingImageDimension; dim++ )
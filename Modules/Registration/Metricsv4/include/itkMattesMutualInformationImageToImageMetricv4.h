@@ -25,6 +25,7 @@
 #include "itkBSplineDerivativeKernelFunction.h"
 #include "itkArray2D.h"
 #include "itkThreadedIndexedContainerPartitioner.h"
+#include "itkBSplineBaseTransform.h"
 
 namespace itk
 {
@@ -60,10 +61,26 @@ namespace itk
  * One the PDF's have been contructed, the mutual information
  * is obtained by doubling summing over the discrete PDF values.
  *
+ * Each thread fills its own partial histograms, which are summed in a
+ * fixed thread order after the threaded execution, in parallel over the
+ * histogram bins, so that the results do not depend on the order in
+ * which the threads finish.
+ *
+ * When the moving transform is a cubic BSplineBaseTransform and
+ * UseSparseDerivative is on (the default), the derivative is computed in
+ * two passes over the samples instead of through the joint PDF
+ * derivatives, which hold the number of parameters times the squared
+ * number of bins per thread. The first pass builds the joint histogram
+ * and the metric value. The second one accumulates the contribution of
+ * each sample to the few parameters of the B-spline support of the
+ * sample only. The memory then grows with the number of parameters
+ * alone, and the time with the number of samples alone.
+ *
  * \warning Local-support transforms are not yet supported. If used,
  * an exception is thrown during Initialize().
  *
- * \note The per-iteration post-processing code is not multi-threaded, but could be
+ * \note Apart from the summation of the per-thread histograms, the
+ * per-iteration post-processing code is not multi-threaded, but could be
  * readily be made so for a small performance gain.
  * See GetValueCommonAfterThreadedExecution(), GetValueAndDerivative()
  * and threader::AfterThreadedExecution().
@@ -154,6 +171,17 @@ public:
 
   virtual void Initialize(void) throw ( itk::ExceptionObject ) ITK_OVERRIDE;
 
+  /** Compute the derivative for a cubic B-spline moving transform in a
+   * second pass over the samples, accumulating only the non-zero entries
+   * of the Jacobian. On by default. */
+  itkSetMacro(UseSparseDerivative, bool);
+  itkGetConstMacro(UseSparseDerivative, bool);
+  itkBooleanMacro(UseSparseDerivative);
+
+  /** Compute the value, then the derivative in a second pass over the
+   * samples when the sparse derivative is used. */
+  virtual void GetValueAndDerivative( MeasureType & value, DerivativeType & derivative ) const ITK_OVERRIDE;
+
   /** The marginal PDFs are stored as std::vector. */
   //NOTE:  floating point precision is not as stable.
   // Double precision proves faster and more robust in real-world testing.
@@ -179,8 +207,8 @@ public:
   /**
    * Get the internal JointPDFDeriviative image that was used in
    * creating the metric derivative value.
-   * This is only created when a global support transform is used, and
-   * derivatives are requested.
+   * This is only created when a global support transform is used,
+   * derivatives are requested, and the sparse derivative is not used.
    */
   const typename JointPDFDerivativesType::Pointer GetJointPDFDerivatives () const
     {
@@ -196,7 +224,6 @@ public:
     * per thread before processing each thread.
     */
   virtual void InitializeThread( const ThreadIdType threadId ) ITK_OVERRIDE;
-  virtual void FinalizeThread( const ThreadIdType threadId ) ITK_OVERRIDE;
 
 protected:
   MattesMutualInformationImageToImageMetricv4();
@@ -224,6 +251,10 @@ protected:
   typedef BSplineKernelFunction<3,PDFValueType>           CubicBSplineFunctionType;
   typedef BSplineDerivativeKernelFunction<3,PDFValueType> CubicBSplineDerivativeFunctionType;
 
+  /** Moving transform type for which the sparse derivative is used. */
+  typedef BSplineBaseTransform<TInternalComputationValueType,
+                               itkGetStaticConstMacro(MovingImageDimension), 3> MovingBSplineTransformType;
+
   /** Post-processing code common to both GetValue
    * and GetValueAndDerivative. */
   virtual void GetValueCommonAfterThreadedExecution();
@@ -271,6 +302,10 @@ protected:
    * For local-support transforms only. */
   mutable std::vector<DerivativeType>              m_LocalDerivativeByParzenBin;
 
+  /** The moving transform while the sparse derivative is computed,
+   * null otherwise. */
+  mutable const MovingBSplineTransformType *       m_SparseDerivativeTransform;
+
 private:
   MattesMutualInformationImageToImageMetricv4(const Self &); //purposely not implemented
   void operator = (const Self &); //purposely not implemented
@@ -278,8 +313,11 @@ private:
   /** Perform the final step in computing results */
   virtual void ComputeResults() const;
 
-  std::vector< MutexLock::Pointer >  m_JointPDFSubsectionLocks;
-  std::vector< MutexLock::Pointer >  m_JointPDFDerivativeSubsectionLocks;
+  /** Store the log ratios of the joint PDF to the moving marginal PDF,
+   * scaled like the joint PDF derivatives, for the sparse derivative. */
+  void ComputePRatioArray() const;
+
+  bool m_UseSparseDerivative;
 
   ThreadedIndexedContainerPartitioner::Pointer m_IndexedContainerPartitioner;
 };
@@ -20,8 +20,6 @@
 
 #include "itkMattesMutualInformationImageToImageMetricv4.h"
 #include "itkCompensatedSummation.h"
-#include "itkMutexLock.h"
-#include "itkMutexLockHolder.h"
 
 namespace itk
 {
@@ -53,7 +51,9 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
   m_ThreaderJointPDFDerivatives(0),
   m_AccumulatorJointPDF(ITK_NULLPTR),
   m_AccumulatorJointPDFDerivatives(ITK_NULLPTR),
-  m_JointPDFSum(0.0)
+  m_JointPDFSum(0.0),
+  m_SparseDerivativeTransform(ITK_NULLPTR),
+  m_UseSparseDerivative(true)
 {
   // We have our own GetValueAndDerivativeThreader's that we want
   // ImageToImageMetricv4 to use.
@@ -243,7 +243,7 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
       }
     }
 
-  if( this->GetComputeDerivative()  &&  ! this->HasLocalSupport() )
+  if( this->GetComputeDerivative()  &&  ! this->HasLocalSupport()  &&  this->m_SparseDerivativeTransform == ITK_NULLPTR )
     {
     JointPDFDerivativesRegionType jointPDFDerivativesRegion;
       {
@@ -276,117 +276,6 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
     }
 }
 
-template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
-void
-MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
-::FinalizeThread( const ThreadIdType threadId )
-{
-  const IndexValueType pdfNumberOfVoxels = this->m_NumberOfHistogramBins * this->m_NumberOfHistogramBins;
-  const IndexValueType derivativeTotalElementSize = this->GetNumberOfLocalParameters() * pdfNumberOfVoxels;
-
-  //NOTE: min needed hear so that if there are more threads than values,
-  //      that the IndexPartitioner does not overrun bounds.
-  const IndexValueType numberOfPDFSubsections = std::min(
-    static_cast< IndexValueType >( m_JointPDFSubsectionLocks.size() ),
-    pdfNumberOfVoxels);
-
-  const IndexValueType numberOfDerivativesSubsections = std::min(
-    static_cast< IndexValueType >( m_JointPDFDerivativeSubsectionLocks.size() ),
-    derivativeTotalElementSize);
-
-  std::vector<bool> isPDFSectionDone(numberOfPDFSubsections,false);
-  std::vector<bool> isPDFDerivativeSectionDone(numberOfDerivativesSubsections,false);
-
-  //NOTE:  IndexRange is INCLUSIVE of values, so subtract 1 from total number for zero indexing.
-  const ThreadedIndexedContainerPartitioner::IndexRangeType completeIndexRange = {
-      {0, pdfNumberOfVoxels - 1 } };
-  const ThreadedIndexedContainerPartitioner::IndexRangeType completeDerivativeIndexRange = {
-      {0, derivativeTotalElementSize - 1 } };
-
-  const bool needDerivativesComputation = ( this->GetComputeDerivative() && ( ! this->HasLocalSupport() ) );
-  bool someWorkDelayed;
-  do {
-    someWorkDelayed = false; //This is set to true while some more work needs to be done
-    // This method is from MattesMutualImageToImageMetric::GetValueThreadPostProcess. Common
-    // code used by GetValue and GetValueAndDerivative.
-    // Should be threaded. But if modified to do so, should probably not be threaded
-    // separately, but rather as a part of all post-processing.
-      {
-      JointPDFValueType * const accumPDFPtrStart = this->m_AccumulatorJointPDF->GetBufferPointer();
-      JointPDFValueType * const threadPdfStart = this->m_ThreaderJointPDF[threadId]->GetBufferPointer();
-      ThreadedIndexedContainerPartitioner::IndexRangeType indexRange;
-      for( IndexValueType subsection = 0; subsection < numberOfPDFSubsections; ++subsection )
-        {
-        if( ! isPDFSectionDone[subsection] )
-          {
-          //Get mutex lock for writing to protect subsections of the accumPDFPtr buffer
-          MutexLockHolder< MutexLock > lockHolder(*(m_JointPDFSubsectionLocks[subsection]), true);
-          if(lockHolder.GetLockCaptured())
-            {
-            this->m_IndexedContainerPartitioner->PartitionDomain( subsection, numberOfPDFSubsections,
-                                                                  completeIndexRange, indexRange );
-            JointPDFValueType *       threadPdf = threadPdfStart + indexRange[0];
-            JointPDFValueType *       accumPDFPtr = accumPDFPtrStart + indexRange[0];
-            JointPDFValueType const * const accumPDFEnd = accumPDFPtrStart + indexRange[1];
-            while( accumPDFPtr <= accumPDFEnd )
-              {
-              *( accumPDFPtr ) += *( threadPdf );
-              *( threadPdf ) = 0.0;
-              ++accumPDFPtr;
-              ++threadPdf;
-              }
-            isPDFSectionDone[subsection] = true;
-            }
-          else
-            {
-            someWorkDelayed = true;
-            }
-          }
-        }
-      }
-
-    if( needDerivativesComputation )
-      {
-      // This entire block of code is used to accumulate the per-thread buffers into 1 thread.
-      // For this thread, how many histogram elements are there?
-
-      //Accumulate this thread values for Derivatives
-      JointPDFDerivativesValueType * const accumPDFDerivPtrStart = this->m_AccumulatorJointPDFDerivatives->GetBufferPointer();
-      JointPDFDerivativesValueType  * const threadPdfDPtrStart = this->m_ThreaderJointPDFDerivatives[threadId]->GetBufferPointer();
-      ThreadedIndexedContainerPartitioner::IndexRangeType derivativeIndexRange;
-      for( IndexValueType subsection = 0; subsection < numberOfDerivativesSubsections; ++subsection )
-        {
-        if( ! isPDFDerivativeSectionDone[subsection] )
-          {
-          //Get mutex lock for writing
-          MutexLockHolder< MutexLock > lockHolder(*(m_JointPDFDerivativeSubsectionLocks[subsection]),true);
-          if(lockHolder.GetLockCaptured())
-            {
-            this->m_IndexedContainerPartitioner->PartitionDomain( subsection, numberOfDerivativesSubsections,
-                                                           completeDerivativeIndexRange, derivativeIndexRange );
-            JointPDFDerivativesValueType       * threadPdfDPtr = threadPdfDPtrStart + derivativeIndexRange[0];
-            JointPDFDerivativesValueType * accumPDFDerivPtr = accumPDFDerivPtrStart + derivativeIndexRange[0];
-            JointPDFDerivativesValueType const * const accumPDFDerivPtrEnd = accumPDFDerivPtrStart + derivativeIndexRange[1];
-            while( accumPDFDerivPtr <= accumPDFDerivPtrEnd )
-              {
-              *( accumPDFDerivPtr ) += *( threadPdfDPtr );
-              *( threadPdfDPtr ) = 0.0;
-              ++accumPDFDerivPtr;
-              ++threadPdfDPtr;
-              }
-            isPDFDerivativeSectionDone[subsection] = true;
-            }
-          else
-            {
-            someWorkDelayed = true;
-            }
-          }
-        }
-      }
-  } while ( someWorkDelayed );
-}
-
-
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -534,23 +423,7 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 ::GetValueCommonAfterThreadedExecution()
 {
   const ThreadIdType localNumberOfThreadsUsed = this->GetNumberOfThreadsUsed();
-  if( this->GetComputeDerivative() && ( ! this->HasLocalSupport() ) )
-    {
-    // This entire block of code is used to accumulate the per-thread buffers into 1 thread.
-    // For this thread, how many histogram elements are there?
-    const SizeValueType rowSize = this->GetNumberOfLocalParameters() * this->m_NumberOfHistogramBins;
-    const SizeValueType histogramTotalElementsSize = rowSize * this->m_NumberOfHistogramBins;
-    // This can not be threaded.
-    const PDFValueType nFactor = 1.0 / ( this->m_MovingImageBinSize * this->GetNumberOfValidPoints() );
-    JointPDFDerivativesValueType *const accumulatorPdfDPtrStart = this->m_AccumulatorJointPDFDerivatives->GetBufferPointer();
-    JointPDFDerivativesValueType *             accumulatorPdfDPtr = accumulatorPdfDPtrStart;
-    JointPDFDerivativesValueType const * const threadPdfDPtrEnd = accumulatorPdfDPtrStart + histogramTotalElementsSize;
-    while( accumulatorPdfDPtr < threadPdfDPtrEnd )
-      {
-      *( accumulatorPdfDPtr++ ) *= nFactor;
-      }
-    }
-
+  // The joint PDF derivatives have been summed and scaled by the threader.
   for( unsigned int t = 1; t < localNumberOfThreadsUsed; ++t )
     {
     for( SizeValueType i = 0; i < this->m_NumberOfHistogramBins; ++i )
@@ -572,12 +445,65 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 }
 
 
+template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::GetValueAndDerivative( MeasureType & value, DerivativeType & derivative ) const
+{
+  this->m_SparseDerivativeTransform = ITK_NULLPTR;
+  if( this->m_UseSparseDerivative )
+    {
+    this->m_SparseDerivativeTransform =
+      dynamic_cast< const MovingBSplineTransformType * >( this->m_MovingTransform.GetPointer() );
+    }
+  if( this->m_SparseDerivativeTransform == ITK_NULLPTR )
+    {
+    Superclass::GetValueAndDerivative( value, derivative );
+    return;
+    }
+
+  // The first pass builds the joint histogram and computes the value, the
+  // second one accumulates the derivative from the joint PDF ratios, over
+  // the same sampled points.
+  this->GetValue();
+  this->ComputePRatioArray();
+  this->m_KeepVirtualSampledPointSelection = true;
+  Superclass::GetValueAndDerivative( value, derivative );
+}
+
+template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::ComputePRatioArray() const
+{
+  this->m_PRatioArray.assign( this->m_NumberOfHistogramBins * this->m_NumberOfHistogramBins, 0.0 );
+
+  const PDFValueType nFactor = 1.0 / ( this->m_MovingImageBinSize * this->GetNumberOfValidPoints() );
+
+  static const PDFValueType closeToZero = std::numeric_limits<PDFValueType>::epsilon();
+  JointPDFValueType const * jointPDFPtr = this->m_AccumulatorJointPDF->GetBufferPointer();
+  PRatioType * pRatioPtr = &( this->m_PRatioArray[0] );
+  for( unsigned int fixedIndex = 0; fixedIndex < this->m_NumberOfHistogramBins; ++fixedIndex )
+    {
+    for( unsigned int movingIndex = 0; movingIndex < this->m_NumberOfHistogramBins; ++movingIndex, ++jointPDFPtr, ++pRatioPtr )
+      {
+      const PDFValueType movingImagePDFValue = this->m_MovingImageMarginalPDF[movingIndex];
+      const PDFValueType jointPDFValue = *( jointPDFPtr );
+      if( jointPDFValue > closeToZero && movingImagePDFValue > closeToZero )
+        {
+        *( pRatioPtr ) = std::log( jointPDFValue / movingImagePDFValue ) * nFactor;
+        }
+      }
+    }
+}
+
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::PrintSelf(std::ostream& os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "UseSparseDerivative: " << this->m_UseSparseDerivative << std::endl;
 }
 
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
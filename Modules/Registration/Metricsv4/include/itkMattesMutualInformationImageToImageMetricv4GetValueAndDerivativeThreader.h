@@ -20,8 +20,6 @@
 
 #include "itkImageToImageMetricv4GetValueAndDerivativeThreader.h"
 
-#include "itkMutexLock.h"
-
 namespace itk
 {
 
@@ -65,6 +63,7 @@ public:
   typedef typename Superclass::NumberOfParametersType   NumberOfParametersType;
 
   typedef typename ImageToImageMetricv4Type::MovingTransformType  MovingTransformType;
+  typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
 
   typedef typename TMattesMutualInformationMetric::PDFValueType                   PDFValueType;
   typedef typename TMattesMutualInformationMetric::JointPDFType                   JointPDFType;
@@ -83,10 +82,17 @@ public:
 
   typedef typename TMattesMutualInformationMetric::JacobianType             JacobianType;
 
+  typedef typename TMattesMutualInformationMetric::MovingBSplineTransformType  MovingBSplineTransformType;
+  typedef typename MovingBSplineTransformType::WeightsType                     BSplineWeightsType;
+  typedef typename MovingBSplineTransformType::ParameterIndexArrayType         BSplineParameterIndexArrayType;
+
 protected:
   MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader() :
     m_MattesAssociate(ITK_NULLPTR)
-  {}
+  {
+    this->m_SupportsSparseJacobian = true;
+    this->m_SupportsCachedFixedSampledPointValues = true;
+  }
 
   virtual void BeforeThreadedExecution() ITK_OVERRIDE;
 
@@ -123,10 +129,30 @@ protected:
                              const PDFValueType &            cubicBSplineDerivativeValue,
                              DerivativeValueType *           localSupportDerivativeResultPtr) const;
 
+  /** Add the derivative contribution of a point to the parameters of its
+   * B-spline support, for the sparse derivative. \c pRatioDerivativeValue
+   * is the sum over the Parzen window of the cubic B-spline derivative
+   * weighted by the joint PDF ratios. */
+  virtual void ComputeDerivativeSparseSupportTransform(const ThreadIdType &            threadId,
+                             const VirtualPointType &        virtualPoint,
+                             const MovingImageGradientType & movingGradient,
+                             const PDFValueType &            pRatioDerivativeValue) const;
+
 private:
   MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader( const Self & ); // purposely not implemented
   void operator=( const Self & ); // purposely not implemented
 
+  /** Sum the per-thread joint PDFs, and joint PDF derivatives, into the
+   * accumulators of the metric, in parallel over the bins. */
+  void AccumulateJointPDFs();
+
+  static ITK_THREAD_RETURN_TYPE AccumulateJointPDFsThreaderCallback( void *arg );
+
+  /** Per-thread B-spline weights and parameter indices, for the sparse
+   * derivative. */
+  mutable std::vector< BSplineWeightsType >             m_BSplineWeights;
+  mutable std::vector< BSplineParameterIndexArrayType > m_BSplineParameterIndices;
+
   /** Internal pointer to the Mattes metric object in use by this threader.
    *  This will avoid costly dynamic casting in tight loops. */
   TMattesMutualInformationMetric * m_MattesAssociate;
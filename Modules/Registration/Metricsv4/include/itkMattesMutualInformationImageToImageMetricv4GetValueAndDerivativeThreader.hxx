@@ -44,6 +44,22 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     itkExceptionMacro("Dynamic casting of associate pointer failed.");
     }
 
+  if( this->m_MattesAssociate->GetComputeDerivative() && this->m_MattesAssociate->m_SparseDerivativeTransform != ITK_NULLPTR )
+    {
+    /* Second pass of the sparse derivative: the histograms and the joint
+     * PDF ratios of the first pass are kept. */
+    const ThreadIdType numThreadsUsed = this->GetNumberOfThreadsUsed();
+    const SizeValueType numberOfWeights = this->m_MattesAssociate->m_SparseDerivativeTransform->GetNumberOfWeights();
+    this->m_BSplineWeights.resize( numThreadsUsed );
+    this->m_BSplineParameterIndices.resize( numThreadsUsed );
+    for( ThreadIdType threadId = 0; threadId < numThreadsUsed; ++threadId )
+      {
+      this->m_BSplineWeights[threadId].SetSize( numberOfWeights );
+      this->m_BSplineParameterIndices[threadId].SetSize( numberOfWeights );
+      }
+    return;
+    }
+
   /* Porting: these next blocks of code are from MattesMutualImageToImageMetric::Initialize */
 
   /*
@@ -103,6 +119,7 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       this->m_MattesAssociate->m_AccumulatorJointPDF->FillBuffer(0.0);
       }
     }
+  if( this->m_MattesAssociate->GetComputeDerivative() && ! this->m_MattesAssociate->HasLocalSupport() )
     {
     JointPDFDerivativesRegionType jointPDFDerivativesRegion;
       {
@@ -129,12 +146,8 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       // Set the regions and allocate
       this->m_MattesAssociate->m_AccumulatorJointPDFDerivatives = JointPDFDerivativesType::New();
       this->m_MattesAssociate->m_AccumulatorJointPDFDerivatives->SetRegions( jointPDFDerivativesRegion);
-      this->m_MattesAssociate->m_AccumulatorJointPDFDerivatives->Allocate(true);
-      }
-    else
-      {
-      // Still need to reset to zero for subsequent runs
-      this->m_MattesAssociate->m_AccumulatorJointPDFDerivatives->FillBuffer(0.0);
+      // No need to initialize: every bin is assigned by AccumulateJointPDFs
+      this->m_MattesAssociate->m_AccumulatorJointPDFDerivatives->Allocate();
       }
     }
 
@@ -154,18 +167,6 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   //NOTE: If container is the correct size, then no acion is taken.
   this->m_MattesAssociate->m_ThreaderJointPDF.resize(mattesAssociateNumThreadsUsed);
 
-  //Resize the sub-sections locks array!
-  if( this->m_MattesAssociate->m_JointPDFSubsectionLocks.size() != mattesAssociateNumThreadsUsed )
-    {
-    this->m_MattesAssociate->m_JointPDFSubsectionLocks.resize(mattesAssociateNumThreadsUsed);
-    this->m_MattesAssociate->m_JointPDFDerivativeSubsectionLocks.resize(mattesAssociateNumThreadsUsed);
-    for( ThreadIdType threadId = 0; threadId < mattesAssociateNumThreadsUsed; ++threadId )
-      {
-      this->m_MattesAssociate->m_JointPDFSubsectionLocks[threadId] = MutexLock::New();
-      this->m_MattesAssociate->m_JointPDFDerivativeSubsectionLocks[threadId] = MutexLock::New();
-      }
-    }
-
   //
   // Now allocate memory according to transform type
   //
@@ -265,6 +266,24 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
 
   const OffsetValueType fixedImageParzenWindowIndex = this->m_MattesAssociate->ComputeSingleFixedImageParzenWindowIndex( fixedImageValue );
 
+  if( doComputeDerivative && this->m_MattesAssociate->m_SparseDerivativeTransform != ITK_NULLPTR )
+    {
+    // Second pass of the sparse derivative: the histograms are complete,
+    // so the joint PDF ratios of the four affected bins are known.
+    typename TMattesMutualInformationMetric::PRatioType const * pRatioPtr = &( this->m_MattesAssociate->m_PRatioArray[0] )
+      + ( fixedImageParzenWindowIndex * this->m_MattesAssociate->m_NumberOfHistogramBins ) + pdfMovingIndex;
+    PDFValueType movingImageParzenWindowArg = static_cast<PDFValueType>( pdfMovingIndex ) - static_cast<PDFValueType>( movingImageParzenWindowTerm );
+    PDFValueType pRatioDerivativeValue = 0.0;
+    for( ; pdfMovingIndex <= pdfMovingIndexMax; ++pdfMovingIndex, ++pRatioPtr, movingImageParzenWindowArg += 1.0 )
+      {
+      pRatioDerivativeValue += this->m_MattesAssociate->m_CubicBSplineDerivativeKernel->Evaluate( movingImageParzenWindowArg ) * ( *pRatioPtr );
+      }
+    this->ComputeDerivativeSparseSupportTransform( threadId, virtualPoint, movingImageGradient, pRatioDerivativeValue );
+
+    // The valid points were counted in the first pass.
+    return false;
+    }
+
   // Since a zero-order BSpline (box car) kernel is used for
   // the fixed image marginal pdf, we need only increment the
   // fixedImageParzenWindowIndex by value of 1.0.
@@ -303,15 +322,10 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     }
 
   // Compute the transform Jacobian.
-  typedef JacobianType & JacobianReferenceType;
-  JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
+  const JacobianType & jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
   if( doComputeDerivative )
     {
-    JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
-    this->m_MattesAssociate->GetMovingTransform()->
-      ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                              jacobian,
-                                                              jacobianPositional);
+    this->ComputeMovingTransformJacobian( virtualPoint, threadId );
     }
 
   SizeValueType movingParzenBin = 0;
@@ -384,6 +398,24 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       + ( pdfFixedIndex  * this->m_MattesAssociate->m_ThreaderJointPDFDerivatives[threadId]->GetOffsetTable()[2] )
       + ( pdfMovingIndex * this->m_MattesAssociate->m_ThreaderJointPDFDerivatives[threadId]->GetOffsetTable()[1] );
 
+  if( this->m_UseSparseJacobian )
+    {
+    // Only update the parameters supporting the point
+    const NonZeroJacobianIndicesType & nonZeroJacobianIndices =
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].NonZeroJacobianIndices;
+    for( NumberOfParametersType mu = 0, maxElement = this->m_CachedNumberOfNonZeroJacobianIndices; mu < maxElement; ++mu )
+      {
+      PDFValueType innerProduct = 0.0;
+      for( SizeValueType dim = 0, lastDim = this->m_MattesAssociate->MovingImageDimension; dim < lastDim; ++dim )
+        {
+        innerProduct += jacobian[dim][mu] * movingImageGradient[dim];
+        }
+
+      derivPtr[nonZeroJacobianIndices[mu]] -= innerProduct * cubicBSplineDerivativeValue;
+      }
+    return;
+    }
+
   for( NumberOfParametersType mu = 0, maxElement=this->GetCachedNumberOfLocalParameters(); mu < maxElement; ++mu )
     {
     PDFValueType innerProduct = 0.0;
@@ -421,12 +453,130 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     }
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
+void
+MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
+::ComputeDerivativeSparseSupportTransform(const ThreadIdType &            threadId,
+                        const VirtualPointType &        virtualPoint,
+                        const MovingImageGradientType & movingImageGradient,
+                        const PDFValueType &            pRatioDerivativeValue) const
+{
+  const MovingBSplineTransformType * transform = this->m_MattesAssociate->m_SparseDerivativeTransform;
+  BSplineWeightsType & weights = this->m_BSplineWeights[threadId];
+  BSplineParameterIndexArrayType & indices = this->m_BSplineParameterIndices[threadId];
+  transform->ComputeJacobianFromBSplineWeightsWithRespectToPosition( virtualPoint, weights, indices );
+
+  // The Jacobian of the parameters of dimension dim is the B-spline weight
+  // along dim and zero along the other dimensions.
+  typename Superclass::CompensatedDerivativeType & derivatives =
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives;
+  const NumberOfParametersType numberOfParametersPerDimension = transform->GetNumberOfParametersPerDimension();
+  const SizeValueType numberOfWeights = weights.Size();
+  for( SizeValueType dim = 0, lastDim = this->m_MattesAssociate->MovingImageDimension; dim < lastDim; ++dim )
+    {
+    const PDFValueType derivativeContribution = movingImageGradient[dim] * pRatioDerivativeValue;
+    const NumberOfParametersType offset = dim * numberOfParametersPerDimension;
+    for( SizeValueType w = 0; w < numberOfWeights; ++w )
+      {
+      derivatives[offset + indices[w]] -= weights[w] * derivativeContribution;
+      }
+    }
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
+void
+MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
+::AccumulateJointPDFs()
+{
+  MultiThreader * multiThreader = this->GetMultiThreader();
+  multiThreader->SetSingleMethod( Self::AccumulateJointPDFsThreaderCallback, this );
+  multiThreader->SingleMethodExecute();
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
+ITK_THREAD_RETURN_TYPE
+MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
+::AccumulateJointPDFsThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self *self = static_cast<Self *>( info->UserData );
+  TMattesMutualInformationMetric *associate = self->m_MattesAssociate;
+  const ThreadIdType numberOfThreadsUsed = self->GetNumberOfThreadsUsed();
+
+  // The partial histograms are summed in thread order, so that the result
+  // does not depend on the order in which the threads have finished.
+  const IndexValueType pdfNumberOfVoxels = associate->m_NumberOfHistogramBins * associate->m_NumberOfHistogramBins;
+  ThreadedIndexedContainerPartitioner::IndexRangeType completeIndexRange;
+  completeIndexRange[0] = 0;
+  completeIndexRange[1] = pdfNumberOfVoxels - 1;
+  ThreadedIndexedContainerPartitioner::IndexRangeType indexRange;
+  if( info->ThreadID < associate->m_IndexedContainerPartitioner->PartitionDomain( info->ThreadID, info->NumberOfThreads,
+                                                                                 completeIndexRange, indexRange ) )
+    {
+    JointPDFValueType * const accumPDFPtr = associate->m_AccumulatorJointPDF->GetBufferPointer();
+    std::fill( accumPDFPtr + indexRange[0], accumPDFPtr + indexRange[1] + 1, 0.0 );
+    for( ThreadIdType threadId = 0; threadId < numberOfThreadsUsed; ++threadId )
+      {
+      JointPDFValueType * const threadPdfPtr = associate->m_ThreaderJointPDF[threadId]->GetBufferPointer();
+      for( IndexValueType i = indexRange[0]; i <= indexRange[1]; ++i )
+        {
+        accumPDFPtr[i] += threadPdfPtr[i];
+        threadPdfPtr[i] = 0.0;
+        }
+      }
+    }
+
+  if( associate->GetComputeDerivative() && ! associate->HasLocalSupport() )
+    {
+    completeIndexRange[1] = associate->GetNumberOfLocalParameters() * pdfNumberOfVoxels - 1;
+    if( info->ThreadID < associate->m_IndexedContainerPartitioner->PartitionDomain( info->ThreadID, info->NumberOfThreads,
+                                                                                   completeIndexRange, indexRange ) )
+      {
+      JointPDFDerivativesValueType * const accumPDFDerivPtr = associate->m_AccumulatorJointPDFDerivatives->GetBufferPointer();
+      std::fill( accumPDFDerivPtr + indexRange[0], accumPDFDerivPtr + indexRange[1] + 1, 0.0 );
+      for( ThreadIdType threadId = 0; threadId < numberOfThreadsUsed; ++threadId )
+        {
+        JointPDFDerivativesValueType * const threadPdfDPtr = associate->m_ThreaderJointPDFDerivatives[threadId]->GetBufferPointer();
+        for( IndexValueType i = indexRange[0]; i <= indexRange[1]; ++i )
+          {
+          accumPDFDerivPtr[i] += threadPdfDPtr[i];
+          threadPdfDPtr[i] = 0.0;
+          }
+        }
+      const PDFValueType nFactor = 1.0 / ( associate->m_MovingImageBinSize * associate->GetNumberOfValidPoints() );
+      for( IndexValueType i = indexRange[0]; i <= indexRange[1]; ++i )
+        {
+        accumPDFDerivPtr[i] *= nFactor;
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
 void
 MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
 ::AfterThreadedExecution()
 {
   const ThreadIdType localNumberOfThreadsUsed = this->GetNumberOfThreadsUsed();
+
+  if( this->m_MattesAssociate->GetComputeDerivative() && this->m_MattesAssociate->m_SparseDerivativeTransform != ITK_NULLPTR )
+    {
+    /* Second pass of the sparse derivative: sum the per-thread derivatives.
+     * The value has been computed by the first pass. */
+    for( NumberOfParametersType p = 0; p < this->m_CachedNumberOfParameters; ++p )
+      {
+      typename Superclass::CompensatedDerivativeValueType sum;
+      for( ThreadIdType threadId = 0; threadId < localNumberOfThreadsUsed; ++threadId )
+        {
+        sum += this->m_GetValueAndDerivativePerThreadVariables[threadId].CompensatedDerivatives[p].GetSum();
+        }
+      (*(this->m_MattesAssociate->m_DerivativeResult))[p] += sum.GetSum();
+      }
+    return;
+    }
+
   /* Store the number of valid points in the enclosing class
    * m_NumberOfValidPoints by collecting the valid points per thread.
    * We do this here because we're skipping Superclass::AfterThreadedExecution*/
@@ -436,6 +586,8 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     this->m_MattesAssociate->m_NumberOfValidPoints += this->m_GetValueAndDerivativePerThreadVariables[threadId].NumberOfValidPoints;
     }
 
+  this->AccumulateJointPDFs();
+
   /* Porting: This code is from
    * MattesMutualInformationImageToImageMetric::GetValueAndDerivativeThreadPostProcess */
   /* Post-processing that is common the GetValue and GetValueAndDerivative */
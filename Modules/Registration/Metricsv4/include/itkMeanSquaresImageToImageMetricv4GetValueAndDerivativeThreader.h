@@ -60,9 +60,14 @@ public:
   typedef typename Superclass::DerivativeType           DerivativeType;
   typedef typename Superclass::DerivativeValueType      DerivativeValueType;
   typedef typename Superclass::NumberOfParametersType   NumberOfParametersType;
+  typedef typename Superclass::JacobianType             JacobianType;
 
 protected:
-  MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader() {}
+  MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader()
+  {
+    this->m_SupportsSparseJacobian = true;
+    this->m_SupportsCachedFixedSampledPointValues = true;
+  }
 
   /** This function computes the local voxel-wise contribution of
    *  the metric to the global integral of the metric/derivative.
@@ -55,18 +55,12 @@ MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner
     return true;
     }
 
-  /* Use a pre-allocated jacobian object for efficiency */
-  typedef typename TImageToImageMetric::JacobianType & JacobianReferenceType;
-  JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
-  JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
+  /* Use a pre-allocated jacobian object for efficiency. With a sparse
+   * jacobian, only the parameters supporting the point are visited. */
+  const NumberOfParametersType numberOfLocalDerivatives = this->ComputeMovingTransformJacobian( virtualPoint, threadId );
+  const JacobianType & jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
 
-  /** For dense transforms, this returns identity */
-  this->m_Associate->GetMovingTransform()->
-    ComputeJacobianWithRespectToParametersCachedTemporaries(virtualPoint,
-                                                            jacobian,
-                                                            jacobianPositional);
-
-  for ( unsigned int par = 0; par < this->GetCachedNumberOfLocalParameters(); par++ )
+  for ( unsigned int par = 0; par < numberOfLocalDerivatives; par++ )
     {
     localDerivativeReturn[par] = NumericTraits<DerivativeValueType>::ZeroValue();
     for ( unsigned int nc = 0; nc < nComponents; nc++ )
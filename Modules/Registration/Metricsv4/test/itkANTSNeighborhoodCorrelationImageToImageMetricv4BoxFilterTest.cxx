@@ -0,0 +1,218 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+/* Compare the dense evaluation of the ANTS neighborhood correlation metric
+ * with the window sums computed by a box filter to the evaluation with the
+ * scanning queues. The images have a large region of constant intensity,
+ * where the variances of the windows must vanish with both evaluations,
+ * after lines of varying intensities. */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< double, Dimension >                                        ImageType;
+typedef itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType > MetricType;
+
+int Compare( MetricType *metric, const char *what )
+{
+  MetricType::MeasureType    queueValue;
+  MetricType::DerivativeType queueDerivative;
+  metric->SetUseBoxFilter( false );
+  metric->Initialize();
+  metric->GetValueAndDerivative( queueValue, queueDerivative );
+  const itk::SizeValueType queueNumberOfValidPoints = metric->GetNumberOfValidPoints();
+
+  MetricType::MeasureType    boxValue;
+  MetricType::DerivativeType boxDerivative;
+  metric->SetUseBoxFilter( true );
+  metric->Initialize();
+  metric->GetValueAndDerivative( boxValue, boxDerivative );
+  const itk::SizeValueType boxNumberOfValidPoints = metric->GetNumberOfValidPoints();
+
+  // Evaluate the value only, then the derivative again, to check that the
+  // window sums are computed again for each evaluation
+  const MetricType::MeasureType boxValueOnly = metric->GetValue();
+  MetricType::MeasureType    secondBoxValue;
+  MetricType::DerivativeType secondBoxDerivative;
+  metric->GetValueAndDerivative( secondBoxValue, secondBoxDerivative );
+
+  double maximumError = 0.0;
+  double maximumSecondError = 0.0;
+  for( unsigned int p = 0; p < queueDerivative.Size(); ++p )
+    {
+    maximumError = std::max( maximumError, std::fabs( boxDerivative[p] - queueDerivative[p] ) );
+    maximumSecondError = std::max( maximumSecondError, std::fabs( secondBoxDerivative[p] - boxDerivative[p] ) );
+    }
+  const double derivativeNorm = queueDerivative.inf_norm();
+
+  std::cout << what << ": value " << queueValue << " (queues), " << boxValue << " (box filter), "
+            << "relative derivative error " << maximumError / derivativeNorm << ", "
+            << queueNumberOfValidPoints << " valid points" << std::endl;
+
+  if( !( derivativeNorm > 0.0 ) )
+    {
+    std::cerr << "The derivative is zero" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( boxNumberOfValidPoints != queueNumberOfValidPoints )
+    {
+    std::cerr << "The number of valid points differ: " << boxNumberOfValidPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( std::fabs( boxValue - queueValue ) > 1e-8 * std::fabs( queueValue ) ||
+      maximumError > 1e-6 * derivativeNorm )
+    {
+    std::cerr << "The box filter results differ from the queue results" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( boxValueOnly != boxValue || secondBoxValue != boxValue || maximumSecondError != 0.0 )
+    {
+    std::cerr << "The box filter results differ between evaluations" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkANTSNeighborhoodCorrelationImageToImageMetricv4BoxFilterTest(int, char* [])
+{
+  // Images whose region does not start at the origin of the index space
+  ImageType::IndexType start;
+  start[0] = 3;
+  start[1] = -2;
+  start[2] = 1;
+  ImageType::SizeType size;
+  size[0] = 21;
+  size[1] = 17;
+  size[2] = 13;
+  ImageType::RegionType region( start, size );
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.1;
+  spacing[2] = 1.5;
+
+  ImageType::Pointer fixedImage = ImageType::New();
+  fixedImage->SetRegions( region );
+  fixedImage->SetSpacing( spacing );
+  fixedImage->Allocate();
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( region );
+  movingImage->SetSpacing( spacing );
+  movingImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const double x = static_cast< double >( index[0] - start[0] ) / size[0];
+    const double y = static_cast< double >( index[1] - start[1] ) / size[1];
+    const double z = static_cast< double >( index[2] - start[2] ) / size[2];
+    const double fixedValue = std::sin( 7.0 * x + 1.0 ) * std::cos( 6.0 * y ) * std::cos( 3.0 * z ) + x;
+    const double movingValue = std::sin( 7.0 * x + 1.3 ) * std::cos( 6.0 * y - 0.2 ) * std::cos( 3.0 * z + 0.1 ) + 0.9 * x;
+    if( index[0] - start[0] >= 11 )
+      {
+      it.Set( 100.0 );
+      movingImage->SetPixel( index, 60.0 );
+      }
+    else
+      {
+      it.Set( 100.0 * fixedValue );
+      movingImage->SetPixel( index, 50.0 - 80.0 * movingValue * movingValue );
+      }
+    }
+
+  MetricType::Pointer metric = MetricType::New();
+  MetricType::RadiusType radius;
+  radius[0] = 2;
+  radius[1] = 1;
+  radius[2] = 3;
+  metric->SetRadius( radius );
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetMaximumNumberOfThreads( 3 );
+
+  if( metric->GetUseBoxFilter() )
+    {
+    std::cerr << "The box filter is used by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  try
+    {
+    // Affine transform moving a part of the virtual domain outside of the
+    // moving image
+    typedef itk::AffineTransform< double, Dimension > AffineTransformType;
+    AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+    AffineTransformType::ParametersType parameters = affineTransform->GetParameters();
+    parameters[0] = 1.02;
+    parameters[1] = 0.03;
+    parameters[3] = -0.02;
+    parameters[4] = 0.97;
+    parameters[8] = 1.01;
+    parameters[9] = 2.6;
+    parameters[10] = -1.8;
+    parameters[11] = 0.4;
+    affineTransform->SetParameters( parameters );
+    metric->SetMovingTransform( affineTransform );
+    if( Compare( metric, "Affine transform" ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+
+    // Displacement field transform over the virtual domain
+    typedef itk::DisplacementFieldTransform< double, Dimension > DisplacementTransformType;
+    typedef DisplacementTransformType::DisplacementFieldType     FieldType;
+    FieldType::Pointer field = FieldType::New();
+    field->SetRegions( region );
+    field->SetSpacing( spacing );
+    field->Allocate();
+    itk::ImageRegionIteratorWithIndex< FieldType > fieldIt( field, region );
+    for( ; !fieldIt.IsAtEnd(); ++fieldIt )
+      {
+      const FieldType::IndexType index = fieldIt.GetIndex();
+      FieldType::PixelType displacement;
+      displacement[0] = 0.8 * std::sin( 0.3 * index[1] );
+      displacement[1] = -0.5 * std::cos( 0.2 * index[0] + 0.4 * index[2] );
+      displacement[2] = 0.3 * std::sin( 0.25 * index[0] * index[1] );
+      fieldIt.Set( displacement );
+      }
+    DisplacementTransformType::Pointer displacementTransform = DisplacementTransformType::New();
+    displacementTransform->SetDisplacementField( field );
+    metric->SetMovingTransform( displacementTransform );
+    if( Compare( metric, "Displacement field transform" ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
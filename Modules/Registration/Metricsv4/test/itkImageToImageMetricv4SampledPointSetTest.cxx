@@ -0,0 +1,325 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkCorrelationImageToImageMetricv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTranslationTransform.h"
+
+/* Test the evaluation of the image metrics over a sampled point set: the
+ * ordering of the virtual sampled points, the fixed values cached in
+ * Initialize(), and the evaluation over a random subset of the points. */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< float, Dimension >                      ImageType;
+typedef itk::ImageToImageMetricv4< ImageType, ImageType >   MetricType;
+typedef itk::AffineTransform< double, Dimension >           MovingTransformType;
+typedef itk::TranslationTransform< double, Dimension >      FixedTransformType;
+
+// Z-order code of a 2D index
+itk::uint64_t MortonCode( const ImageType::IndexType & index )
+{
+  itk::uint64_t code = 0;
+  for( unsigned int bit = 0; bit < 32; ++bit )
+    {
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      code |= ( ( static_cast< itk::uint64_t >( index[d] ) >> bit ) & 1 ) << ( bit * Dimension + d );
+      }
+    }
+  return code;
+}
+
+void Evaluate( MetricType *metric, bool cacheFixedValues, bool initialize,
+               MetricType::MeasureType & value, MetricType::DerivativeType & derivative )
+{
+  metric->SetCacheFixedSampledPointValues( cacheFixedValues );
+  if( initialize )
+    {
+    metric->Initialize();
+    }
+  metric->GetValueAndDerivative( value, derivative );
+}
+
+bool Compare( const char *what, MetricType::MeasureType value, const MetricType::DerivativeType & derivative,
+              MetricType::MeasureType referenceValue, const MetricType::DerivativeType & referenceDerivative )
+{
+  double maximumError = 0.0;
+  for( unsigned int p = 0; p < derivative.Size(); ++p )
+    {
+    maximumError = std::max( maximumError, std::fabs( derivative[p] - referenceDerivative[p] ) );
+    }
+  maximumError /= referenceDerivative.inf_norm();
+  std::cout << "  " << what << ": value " << value << ", relative derivative error " << maximumError << std::endl;
+  if( std::fabs( value - referenceValue ) > 1e-10 * std::fabs( referenceValue ) || maximumError > 1e-8 )
+    {
+    std::cerr << "The results differ from the reference: value " << referenceValue << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int TestMetric( const char *name, MetricType *metric, const ImageType *fixedImage, const ImageType *movingImage,
+                MovingTransformType *movingTransform, const MetricType::FixedSampledPointSetType *pointSet,
+                bool checkFixedGradients )
+{
+  std::cout << name << std::endl;
+
+  FixedTransformType::Pointer fixedTransform = FixedTransformType::New();
+  fixedTransform->SetIdentity();
+
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedTransform( fixedTransform );
+  metric->SetMovingTransform( movingTransform );
+  metric->SetFixedSampledPointSet( pointSet );
+  metric->SetUseFixedSampledPointSet( true );
+  metric->SetNumberOfSampledPointsPerIteration( 0 );
+  metric->SetMaximumNumberOfThreads( 3 );
+
+  // Reference results, evaluating the fixed image at each evaluation
+  MetricType::MeasureType    referenceValue;
+  MetricType::DerivativeType referenceDerivative;
+  Evaluate( metric, false, true, referenceValue, referenceDerivative );
+  if( !( referenceDerivative.inf_norm() > 0.0 ) )
+    {
+    std::cerr << "The derivative is zero" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The virtual sampled points are sorted along a Z-order curve
+  const MetricType::VirtualPointSetType * virtualPointSet = metric->GetVirtualSampledPointSet();
+  if( virtualPointSet->GetNumberOfPoints() != pointSet->GetNumberOfPoints() ||
+      metric->GetNumberOfDomainPoints() != pointSet->GetNumberOfPoints() )
+    {
+    std::cerr << "Wrong number of virtual sampled points: " << virtualPointSet->GetNumberOfPoints() << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::uint64_t previousCode = 0;
+  for( itk::SizeValueType n = 0; n < virtualPointSet->GetNumberOfPoints(); ++n )
+    {
+    ImageType::IndexType index;
+    fixedImage->TransformPhysicalPointToIndex( virtualPointSet->GetPoint( n ), index );
+    const itk::uint64_t code = MortonCode( index );
+    if( code < previousCode )
+      {
+      std::cerr << "The virtual sampled points are not in Z-order at " << n << std::endl;
+      return EXIT_FAILURE;
+      }
+    previousCode = code;
+    }
+
+  // Cached fixed values
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+  Evaluate( metric, true, true, value, derivative );
+  if( !Compare( "cached fixed values", value, derivative, referenceValue, referenceDerivative ) )
+    {
+    return EXIT_FAILURE;
+    }
+  Evaluate( metric, true, false, value, derivative );
+  if( !Compare( "cached fixed values, second evaluation", value, derivative, referenceValue, referenceDerivative ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The fixed gradients are also cached
+  if( checkFixedGradients )
+    {
+    metric->SetGradientSource( MetricType::GRADIENT_SOURCE_BOTH );
+    Evaluate( metric, false, true, referenceValue, referenceDerivative );
+    Evaluate( metric, true, true, value, derivative );
+    if( !Compare( "cached fixed gradients", value, derivative, referenceValue, referenceDerivative ) )
+      {
+      return EXIT_FAILURE;
+      }
+    metric->SetGradientSource( MetricType::GRADIENT_SOURCE_MOVING );
+    Evaluate( metric, false, true, referenceValue, referenceDerivative );
+    }
+
+  // The cached values are not used after the fixed transform is modified
+  Evaluate( metric, true, true, value, derivative );
+  FixedTransformType::ParametersType translation( Dimension );
+  translation[0] = 0.7;
+  translation[1] = -0.4;
+  fixedTransform->SetParameters( translation );
+  Evaluate( metric, true, false, value, derivative );
+  MetricType::MeasureType    translatedValue;
+  MetricType::DerivativeType translatedDerivative;
+  fixedTransform->SetIdentity();
+  Evaluate( metric, false, true, translatedValue, translatedDerivative );
+  fixedTransform->SetParameters( translation );
+  Evaluate( metric, false, false, translatedValue, translatedDerivative );
+  if( !Compare( "modified fixed transform", value, derivative, translatedValue, translatedDerivative ) )
+    {
+    return EXIT_FAILURE;
+    }
+  fixedTransform->SetIdentity();
+
+  // Evaluations over a quarter of the points
+  const itk::SizeValueType numberOfSelectedPoints = pointSet->GetNumberOfPoints() / 4;
+  metric->SetNumberOfSampledPointsPerIteration( numberOfSelectedPoints );
+  MetricType::MeasureType    firstValue;
+  MetricType::DerivativeType firstDerivative;
+  Evaluate( metric, true, true, firstValue, firstDerivative );
+  if( metric->GetNumberOfDomainPoints() != numberOfSelectedPoints ||
+      metric->GetNumberOfValidPoints() > numberOfSelectedPoints ||
+      metric->GetNumberOfValidPoints() == 0 )
+    {
+    std::cerr << "Wrong number of points: " << metric->GetNumberOfDomainPoints() << " domain points, "
+              << metric->GetNumberOfValidPoints() << " valid points" << std::endl;
+    return EXIT_FAILURE;
+    }
+  Evaluate( metric, true, false, value, derivative );
+  std::cout << "  subset: values " << firstValue << ", " << value << std::endl;
+  if( value == firstValue )
+    {
+    std::cerr << "The same subset is evaluated at each iteration" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The subsets are drawn again from the same seed after Initialize(), and
+  // do not depend on the cache
+  Evaluate( metric, false, true, value, derivative );
+  if( !Compare( "subset, no cache", value, derivative, firstValue, firstDerivative ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  metric->SetNumberOfSampledPointsPerIteration( 0 );
+  return EXIT_SUCCESS;
+}
+}
+
+int itkImageToImageMetricv4SampledPointSetTest(int, char* [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  ImageType::SizeType size;
+  size[0] = 48;
+  size[1] = 40;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.2;
+  ImageType::PointType origin;
+  origin[0] = -5.0;
+  origin[1] = 3.0;
+
+  // Two smooth images with different intensity mappings of the same blobs
+  ImageType::Pointer fixedImage = ImageType::New();
+  fixedImage->SetRegions( size );
+  fixedImage->SetSpacing( spacing );
+  fixedImage->SetOrigin( origin );
+  fixedImage->Allocate();
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( size );
+  movingImage->SetSpacing( spacing );
+  movingImage->SetOrigin( origin );
+  movingImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const double x = static_cast< double >( index[0] ) / size[0];
+    const double y = static_cast< double >( index[1] ) / size[1];
+    const double fixedValue = std::sin( 7.0 * x + 1.0 ) * std::cos( 6.0 * y ) + x;
+    const double movingValue = std::sin( 7.0 * x + 1.3 ) * std::cos( 6.0 * y - 0.2 ) + 0.9 * x;
+    it.Set( static_cast< float >( 100.0 * fixedValue ) );
+    movingImage->SetPixel( index, static_cast< float >( 50.0 - 80.0 * movingValue * movingValue ) );
+    }
+
+  MovingTransformType::Pointer movingTransform = MovingTransformType::New();
+  MovingTransformType::ParametersType parameters = movingTransform->GetParameters();
+  parameters[0] = 1.02;
+  parameters[1] = 0.03;
+  parameters[2] = -0.02;
+  parameters[3] = 0.97;
+  parameters[4] = 0.6;
+  parameters[5] = -0.8;
+  movingTransform->SetParameters( parameters );
+
+  // Random points, in random order, in the inner part of the image
+  MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  const unsigned int numberOfPoints = 600;
+  for( unsigned int n = 0; n < numberOfPoints; ++n )
+    {
+    MetricType::FixedSampledPointSetType::PointType point;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      point[d] = origin[d] + generator->GetUniformVariate( 2.0, size[d] - 3.0 ) * spacing[d];
+      }
+    pointSet->SetPoint( n, point );
+    }
+
+  typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >                    MeanSquaresMetricType;
+  typedef itk::CorrelationImageToImageMetricv4< ImageType, ImageType >                    CorrelationMetricType;
+  typedef itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType > JointHistogramMetricType;
+  typedef itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >        MattesMetricType;
+  typedef itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType >    ANTSMetricType;
+
+  MeanSquaresMetricType::Pointer    meanSquaresMetric = MeanSquaresMetricType::New();
+  CorrelationMetricType::Pointer    correlationMetric = CorrelationMetricType::New();
+  JointHistogramMetricType::Pointer jointHistogramMetric = JointHistogramMetricType::New();
+  MattesMetricType::Pointer         mattesMetric = MattesMetricType::New();
+  mattesMetric->SetNumberOfHistogramBins( 20 );
+  ANTSMetricType::Pointer           antsMetric = ANTSMetricType::New();
+  ANTSMetricType::RadiusType        radius;
+  radius.Fill( 2 );
+  antsMetric->SetRadius( radius );
+
+  const unsigned int numberOfMetrics = 5;
+  MetricType * metrics[numberOfMetrics] =
+    { meanSquaresMetric, correlationMetric, jointHistogramMetric, mattesMetric, antsMetric };
+  const char * metricNames[numberOfMetrics] =
+    { "MeanSquares", "Correlation", "JointHistogramMutualInformation", "MattesMutualInformation",
+      "ANTSNeighborhoodCorrelation" };
+  const bool checkFixedGradients[numberOfMetrics] = { true, false, false, false, false };
+
+  try
+    {
+    for( unsigned int m = 0; m < numberOfMetrics; ++m )
+      {
+      if( TestMetric( metricNames[m], metrics[m], fixedImage, movingImage, movingTransform,
+                      pointSet, checkFixedGradients[m] ) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
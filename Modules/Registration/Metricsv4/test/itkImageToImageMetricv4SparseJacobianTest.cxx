@@ -0,0 +1,350 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkCorrelationImageToImageMetricv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTranslationTransform.h"
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< float, Dimension >                    ImageType;
+typedef itk::BSplineTransform< double, Dimension, 3 >     TransformType;
+typedef itk::Transform< double, Dimension, Dimension >    BaseTransformType;
+typedef itk::ImageToImageMetricv4< ImageType, ImageType > MetricType;
+
+// Check that the compact Jacobian of the transform holds the non-zero
+// columns of its full Jacobian.
+int CheckSparseJacobian(const BaseTransformType *transform, const ImageType *image)
+{
+  BaseTransformType::JacobianType               jacobian;
+  BaseTransformType::JacobianType               sparseJacobian;
+  BaseTransformType::NonZeroJacobianIndicesType nonZeroJacobianIndices;
+
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    BaseTransformType::InputPointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    transform->ComputeJacobianWithRespectToParameters( point, jacobian );
+    transform->ComputeSparseJacobianWithRespectToParameters( point, sparseJacobian, nonZeroJacobianIndices );
+
+    if( sparseJacobian.cols() != transform->GetNumberOfNonZeroJacobianIndices() ||
+        nonZeroJacobianIndices.size() != transform->GetNumberOfNonZeroJacobianIndices() )
+      {
+      std::cerr << "Wrong size of the sparse Jacobian: " << sparseJacobian.cols() << std::endl;
+      return EXIT_FAILURE;
+      }
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      double sparseSum = 0.0;
+      for( unsigned int i = 0; i < sparseJacobian.cols(); ++i )
+        {
+        sparseSum += sparseJacobian( d, i );
+        const double value = jacobian( d, nonZeroJacobianIndices[i] );
+        if( std::fabs( sparseJacobian( d, i ) - value ) > 1e-12 * ( 1.0 + std::fabs( value ) ) )
+          {
+          std::cerr << "The sparse Jacobian differs from the Jacobian at " << point << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      double sum = 0.0;
+      for( unsigned int p = 0; p < jacobian.cols(); ++p )
+        {
+        sum += jacobian( d, p );
+        }
+      if( std::fabs( sum - sparseSum ) > 1e-12 )
+        {
+        std::cerr << "The sparse Jacobian misses non-zero columns at " << point << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+// Compute the value and derivative of the metric with and without the
+// sparse Jacobian, with several numbers of threads, and compare them to
+// the result computed with the full Jacobian with one thread.
+int CompareDerivatives(const char *name, MetricType *metric, const ImageType *fixedImage,
+                       const ImageType *movingImage, BaseTransformType *transform,
+                       const MetricType::FixedSampledPointSetType *pointSet)
+{
+  std::cout << name << ( pointSet ? ", sampled point set" : ", dense sampling" ) << std::endl;
+
+  MetricType::MeasureType    referenceValue = 0.0;
+  MetricType::DerivativeType referenceDerivative;
+
+  for( unsigned int useSparseJacobian = 0; useSparseJacobian < 2; ++useSparseJacobian )
+    {
+    for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; numberOfThreads += 2 )
+      {
+      metric->SetFixedImage( fixedImage );
+      metric->SetMovingImage( movingImage );
+      metric->SetMovingTransform( transform );
+      metric->SetMaximumNumberOfThreads( numberOfThreads );
+      metric->SetUseSparseJacobian( useSparseJacobian != 0 );
+      if( pointSet )
+        {
+        metric->SetFixedSampledPointSet( pointSet );
+        }
+      metric->SetUseFixedSampledPointSet( pointSet != ITK_NULLPTR );
+      metric->Initialize();
+
+      MetricType::MeasureType    value;
+      MetricType::DerivativeType derivative;
+      metric->GetValueAndDerivative( value, derivative );
+
+      if( !useSparseJacobian && numberOfThreads == 1 )
+        {
+        referenceValue = value;
+        referenceDerivative = derivative;
+        if( !( derivative.inf_norm() > 0.0 ) )
+          {
+          std::cerr << "The derivative is zero" << std::endl;
+          return EXIT_FAILURE;
+          }
+        continue;
+        }
+
+      double maximumError = 0.0;
+      for( unsigned int p = 0; p < derivative.Size(); ++p )
+        {
+        maximumError = std::max( maximumError, std::fabs( derivative[p] - referenceDerivative[p] ) );
+        }
+      maximumError /= referenceDerivative.inf_norm();
+      std::cout << "  sparse " << useSparseJacobian << ", " << numberOfThreads << " threads: value "
+                << value << ", relative derivative error " << maximumError << std::endl;
+      if( std::fabs( value - referenceValue ) > 1e-10 * std::fabs( referenceValue ) || maximumError > 1e-8 )
+        {
+        std::cerr << "The results differ from the full Jacobian with one thread: value "
+                  << referenceValue << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkImageToImageMetricv4SparseJacobianTest(int, char* [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  ImageType::SizeType size;
+  size[0] = 40;
+  size[1] = 36;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.3;
+  ImageType::PointType origin;
+  origin[0] = -5.0;
+  origin[1] = 3.0;
+
+  // Two smooth images with different intensity mappings of the same blobs
+  ImageType::Pointer fixedImage = ImageType::New();
+  fixedImage->SetRegions( size );
+  fixedImage->SetSpacing( spacing );
+  fixedImage->SetOrigin( origin );
+  fixedImage->Allocate();
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( size );
+  movingImage->SetSpacing( spacing );
+  movingImage->SetOrigin( origin );
+  movingImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const double x = static_cast< double >( index[0] ) / size[0];
+    const double y = static_cast< double >( index[1] ) / size[1];
+    const double fixedValue = std::sin( 7.0 * x + 1.0 ) * std::cos( 6.0 * y ) + x;
+    const double movingValue = std::sin( 7.0 * x + 1.3 ) * std::cos( 6.0 * y - 0.2 ) + 0.9 * x;
+    it.Set( static_cast< float >( 100.0 * fixedValue ) );
+    movingImage->SetPixel( index, static_cast< float >( 50.0 - 80.0 * movingValue * movingValue ) );
+    }
+
+  // The transform domain only covers a part of the image, so that some
+  // points have no support.
+  TransformType::PhysicalDimensionsType physicalDimensions;
+  TransformType::MeshSizeType           meshSize;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    physicalDimensions[d] = 0.8 * spacing[d] * ( size[d] - 1 );
+    meshSize[d] = 4 + d;
+    }
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetTransformDomainOrigin( origin );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  transform->SetTransformDomainDirection( fixedImage->GetDirection() );
+
+  TransformType::ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int p = 0; p < parameters.Size(); ++p )
+    {
+    parameters[p] = generator->GetUniformVariate( -1.0, 1.0 );
+    }
+  transform->SetParametersByValue( parameters );
+
+  if( transform->GetNumberOfNonZeroJacobianIndices() != Dimension * 16 )
+    {
+    std::cerr << "Wrong number of non-zero Jacobian indices: "
+              << transform->GetNumberOfNonZeroJacobianIndices() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( CheckSparseJacobian( transform, fixedImage ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Sample every third voxel
+  MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  unsigned int numberOfPoints = 0;
+  unsigned int count = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++count )
+    {
+    if( count % 3 == 0 )
+      {
+      MetricType::FixedSampledPointSetType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( numberOfPoints++, point );
+      }
+    }
+
+  typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >                 MeanSquaresMetricType;
+  typedef itk::CorrelationImageToImageMetricv4< ImageType, ImageType >                 CorrelationMetricType;
+  typedef itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType > JointHistogramMetricType;
+  typedef itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >     MattesMetricType;
+  typedef itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType > ANTSMetricType;
+
+  MeanSquaresMetricType::Pointer    meanSquaresMetric = MeanSquaresMetricType::New();
+  CorrelationMetricType::Pointer    correlationMetric = CorrelationMetricType::New();
+  JointHistogramMetricType::Pointer jointHistogramMetric = JointHistogramMetricType::New();
+  MattesMetricType::Pointer         mattesMetric = MattesMetricType::New();
+  mattesMetric->SetNumberOfHistogramBins( 20 );
+  ANTSMetricType::Pointer           antsMetric = ANTSMetricType::New();
+  ANTSMetricType::RadiusType        radius;
+  radius.Fill( 2 );
+  antsMetric->SetRadius( radius );
+
+  const unsigned int numberOfMetrics = 5;
+  MetricType * metrics[numberOfMetrics] =
+    { meanSquaresMetric, correlationMetric, jointHistogramMetric, mattesMetric, antsMetric };
+  const char * metricNames[numberOfMetrics] =
+    { "MeanSquares", "Correlation", "JointHistogramMutualInformation", "MattesMutualInformation",
+      "ANTSNeighborhoodCorrelation" };
+  const MetricType::FixedSampledPointSetType * pointSets[2] = { ITK_NULLPTR, pointSet };
+
+  // The B-spline transform inside a composite transform, as in the
+  // registration methods, between an affine transform applied after it and
+  // a translation applied before it. Only the B-spline transform is
+  // optimized, so the composite transform forwards its compact Jacobian.
+  typedef itk::AffineTransform< double, Dimension >      AffineTransformType;
+  typedef itk::TranslationTransform< double, Dimension > TranslationTransformType;
+  typedef itk::CompositeTransform< double, Dimension >   CompositeTransformType;
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters = affineTransform->GetParameters();
+  affineParameters[0] = 1.05;
+  affineParameters[1] = 0.1;
+  affineParameters[2] = -0.05;
+  affineParameters[3] = 0.95;
+  affineParameters[4] = 0.7;
+  affineParameters[5] = -0.4;
+  affineTransform->SetParameters( affineParameters );
+  TranslationTransformType::Pointer translationTransform = TranslationTransformType::New();
+  TranslationTransformType::ParametersType translation( Dimension );
+  translation[0] = 1.3;
+  translation[1] = -0.6;
+  translationTransform->SetParameters( translation );
+
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( affineTransform );
+  compositeTransform->AddTransform( transform );
+  compositeTransform->AddTransform( translationTransform );
+  compositeTransform->SetAllTransformsToOptimizeOff();
+  compositeTransform->SetNthTransformToOptimizeOn( 1 );
+
+  // the metrics use the sparse Jacobian when it has less columns than
+  // there are parameters
+  if( compositeTransform->GetNumberOfNonZeroJacobianIndices() != Dimension * 16
+      || compositeTransform->GetNumberOfParameters() != transform->GetNumberOfParameters() )
+    {
+    std::cerr << "Wrong number of non-zero Jacobian indices of the composite transform: "
+              << compositeTransform->GetNumberOfNonZeroJacobianIndices() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( CheckSparseJacobian( compositeTransform, fixedImage ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // with two transforms to optimize, the full Jacobian is used
+  compositeTransform->SetNthTransformToOptimizeOn( 0 );
+  if( compositeTransform->GetNumberOfNonZeroJacobianIndices() != compositeTransform->GetNumberOfParameters()
+      || CheckSparseJacobian( compositeTransform, fixedImage ) != EXIT_SUCCESS )
+    {
+    std::cerr << "Wrong sparse Jacobian with two transforms to optimize" << std::endl;
+    return EXIT_FAILURE;
+    }
+  compositeTransform->SetNthTransformToOptimizeOff( 0 );
+
+  try
+    {
+    for( unsigned int m = 0; m < numberOfMetrics; ++m )
+      {
+      for( unsigned int s = 0; s < 2; ++s )
+        {
+        if( CompareDerivatives( metricNames[m], metrics[m], fixedImage, movingImage,
+                                transform, pointSets[s] ) != EXIT_SUCCESS )
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    if( CompareDerivatives( "MeanSquares, composite transform", meanSquaresMetric, fixedImage, movingImage,
+                            compositeTransform, ITK_NULLPTR ) != EXIT_SUCCESS
+        || CompareDerivatives( "ANTSNeighborhoodCorrelation, composite transform", antsMetric, fixedImage,
+                               movingImage, compositeTransform, pointSet ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
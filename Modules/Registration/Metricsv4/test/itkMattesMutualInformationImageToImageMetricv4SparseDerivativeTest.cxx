@@ -0,0 +1,221 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkBSplineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension >                                          ImageType;
+typedef itk::BSplineTransform< double, Dimension, 3 >                           TransformType;
+typedef itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType > MetricType;
+
+// Compute the value and derivative of the metric with the dense and
+// sparse derivatives, and several numbers of threads, and compare them
+// to the dense derivative computed with one thread. The metrics draw the
+// same subsets of the sampled points, as they are initialized with the
+// same seed.
+int CompareDerivatives(const ImageType *fixedImage, const ImageType *movingImage,
+                       TransformType *transform, const MetricType::FixedSampledPointSetType *pointSet,
+                       itk::SizeValueType numberOfSampledPointsPerIteration = 0)
+{
+  MetricType::MeasureType    referenceValue = 0.0;
+  MetricType::DerivativeType referenceDerivative;
+
+  for( unsigned int useSparseDerivative = 0; useSparseDerivative < 2; ++useSparseDerivative )
+    {
+    for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; numberOfThreads += 2 )
+      {
+      MetricType::Pointer metric = MetricType::New();
+      metric->SetNumberOfHistogramBins( 32 );
+      metric->SetFixedImage( fixedImage );
+      metric->SetMovingImage( movingImage );
+      metric->SetMovingTransform( transform );
+      metric->SetMaximumNumberOfThreads( numberOfThreads );
+      metric->SetUseSparseDerivative( useSparseDerivative != 0 );
+      if( pointSet )
+        {
+        metric->SetFixedSampledPointSet( pointSet );
+        metric->SetUseFixedSampledPointSet( true );
+        metric->SetNumberOfSampledPointsPerIteration( numberOfSampledPointsPerIteration );
+        }
+      metric->Initialize();
+
+      MetricType::MeasureType    value;
+      MetricType::DerivativeType derivative;
+      // evaluate twice, to check that the buffers are reset between
+      // iterations
+      metric->GetValueAndDerivative( value, derivative );
+      metric->GetValueAndDerivative( value, derivative );
+
+      if( useSparseDerivative && metric->GetJointPDFDerivatives().IsNotNull() )
+        {
+        std::cerr << "The joint PDF derivatives were allocated with the sparse derivative" << std::endl;
+        return EXIT_FAILURE;
+        }
+      // GetValue() would draw another subset of the sampled points
+      if( numberOfSampledPointsPerIteration == 0 && metric->GetValue() != value )
+        {
+        std::cerr << "GetValue returned " << metric->GetValue() << " instead of " << value << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      if( !useSparseDerivative && numberOfThreads == 1 )
+        {
+        referenceValue = value;
+        referenceDerivative = derivative;
+        if( !( derivative.inf_norm() > 0.0 ) )
+          {
+          std::cerr << "The derivative is zero" << std::endl;
+          return EXIT_FAILURE;
+          }
+        continue;
+        }
+
+      double maximumError = 0.0;
+      for( unsigned int p = 0; p < derivative.Size(); ++p )
+        {
+        maximumError = std::max( maximumError, std::fabs( derivative[p] - referenceDerivative[p] ) );
+        }
+      maximumError /= referenceDerivative.inf_norm();
+      std::cout << "sparse " << useSparseDerivative << ", " << numberOfThreads << " threads: value "
+                << value << ", relative derivative error " << maximumError << std::endl;
+      if( std::fabs( value - referenceValue ) > 1e-10 * std::fabs( referenceValue ) || maximumError > 1e-8 )
+        {
+        std::cerr << "The results differ from the dense derivative with one thread: value "
+                  << referenceValue << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMattesMutualInformationImageToImageMetricv4SparseDerivativeTest(int, char* [])
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 4321 );
+
+  ImageType::SizeType size;
+  size[0] = 26;
+  size[1] = 22;
+  size[2] = 18;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.2;
+  spacing[2] = 1.5;
+  ImageType::PointType origin;
+  origin[0] = -3.0;
+  origin[1] = 2.0;
+  origin[2] = 0.5;
+
+  // Two smooth images with different intensity mappings of the same blobs
+  ImageType::Pointer fixedImage = ImageType::New();
+  fixedImage->SetRegions( size );
+  fixedImage->SetSpacing( spacing );
+  fixedImage->SetOrigin( origin );
+  fixedImage->Allocate();
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( size );
+  movingImage->SetSpacing( spacing );
+  movingImage->SetOrigin( origin );
+  movingImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const double x = static_cast< double >( index[0] ) / size[0];
+    const double y = static_cast< double >( index[1] ) / size[1];
+    const double z = static_cast< double >( index[2] ) / size[2];
+    const double fixedValue = std::sin( 6.0 * x + 1.0 ) * std::cos( 5.0 * y ) + z;
+    const double movingValue = std::sin( 6.0 * x + 1.3 ) * std::cos( 5.0 * y - 0.2 ) + 0.9 * z;
+    it.Set( static_cast< float >( 100.0 * fixedValue ) );
+    movingImage->SetPixel( index, static_cast< float >( 50.0 - 80.0 * movingValue * movingValue ) );
+    }
+
+  TransformType::PhysicalDimensionsType physicalDimensions;
+  TransformType::MeshSizeType           meshSize;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    physicalDimensions[d] = spacing[d] * ( size[d] - 1 );
+    meshSize[d] = 3 + d;
+    }
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetTransformDomainOrigin( origin );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  transform->SetTransformDomainDirection( fixedImage->GetDirection() );
+
+  TransformType::ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int p = 0; p < parameters.Size(); ++p )
+    {
+    parameters[p] = generator->GetUniformVariate( -1.0, 1.0 );
+    }
+  transform->SetParametersByValue( parameters );
+
+  // Sample every third voxel
+  MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  unsigned int numberOfPoints = 0;
+  unsigned int count = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++count )
+    {
+    if( count % 3 == 0 )
+      {
+      MetricType::FixedSampledPointSetType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( numberOfPoints++, point );
+      }
+    }
+
+  try
+    {
+    std::cout << "Dense sampling" << std::endl;
+    if( CompareDerivatives( fixedImage, movingImage, transform, ITK_NULLPTR ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Sampled point set" << std::endl;
+    if( CompareDerivatives( fixedImage, movingImage, transform, pointSet ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Subsets of the sampled point set" << std::endl;
+    if( CompareDerivatives( fixedImage, movingImage, transform, pointSet, 500 ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
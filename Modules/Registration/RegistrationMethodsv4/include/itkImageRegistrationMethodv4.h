@@ -27,6 +27,7 @@
 #include "itkObjectToObjectOptimizerBase.h"
 #include "itkImageToImageMetricv4.h"
 #include "itkPointSetToPointSetMetricv4.h"
+#include "itkRegistrationImagePyramidCache.h"
 #include "itkShrinkImageFilter.h"
 #include "itkTransform.h"
 #include "itkTransformParametersAdaptorBase.h"
@@ -183,6 +184,14 @@ public:
 
   typedef typename ImageMetricType::FixedSampledPointSetType          MetricSamplePointSetType;
 
+  /** Pyramid cache typedefs */
+  typedef RegistrationImagePyramidCache<FixedImageType,
+    typename ImageMetricType::FixedImageGradientImageType>            FixedImagePyramidCacheType;
+  typedef typename FixedImagePyramidCacheType::Pointer                FixedImagePyramidCachePointer;
+  typedef RegistrationImagePyramidCache<MovingImageType,
+    typename ImageMetricType::MovingImageGradientImageType>           MovingImagePyramidCacheType;
+  typedef typename MovingImagePyramidCacheType::Pointer               MovingImagePyramidCachePointer;
+
   /** Set/get the fixed images. */
   virtual void SetFixedImage( const FixedImageType *image )
     {
@@ -356,6 +365,21 @@ public:
   itkGetConstMacro( SmoothingSigmasAreSpecifiedInPhysicalUnits, bool );
   itkBooleanMacro( SmoothingSigmasAreSpecifiedInPhysicalUnits );
 
+  /**
+   * Set/Get the caches of the smoothed fixed and moving images.  By default,
+   * no cache is used and the images are smoothed at each level.  Setting
+   * the same caches on the successive stages of a registration (e.g. rigid,
+   * affine and SyN) computes the smoothed images of each level, and their
+   * gradient images, only once.  The cached gradient filters replace the
+   * default gradient filters of the image metrics; user-specified gradient
+   * filters are kept.  When the fixed and moving image types are the same,
+   * the same cache may be used for both.
+   */
+  itkSetObjectMacro( FixedImagePyramidCache, FixedImagePyramidCacheType );
+  itkGetModifiableObjectMacro( FixedImagePyramidCache, FixedImagePyramidCacheType );
+  itkSetObjectMacro( MovingImagePyramidCache, MovingImagePyramidCacheType );
+  itkGetModifiableObjectMacro( MovingImagePyramidCache, MovingImagePyramidCacheType );
+
   /** Make a DataObject of the correct type to be used as the specified output. */
   typedef ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
   using Superclass::MakeOutput;
@@ -454,6 +478,13 @@ protected:
   /** Get metric samples. */
   virtual void SetMetricSamplePoints();
 
+  /**
+   * Assign the gradient filters of the pyramid caches for the fixed and
+   * moving images to an image metric, unless the metric uses gradient
+   * filters specified by the user.
+   */
+  virtual void SetMetricGradientFiltersFromPyramidCaches( MetricType *, const FixedImageType *, const MovingImageType * );
+
   SizeValueType                                                   m_CurrentLevel;
   SizeValueType                                                   m_NumberOfLevels;
   SizeValueType                                                   m_CurrentIteration;
@@ -481,6 +512,8 @@ protected:
   std::vector<ShrinkFactorsPerDimensionContainerType>             m_ShrinkFactorsPerLevel;
   SmoothingSigmasArrayType                                        m_SmoothingSigmasPerLevel;
   bool                                                            m_SmoothingSigmasAreSpecifiedInPhysicalUnits;
+  FixedImagePyramidCachePointer                                   m_FixedImagePyramidCache;
+  MovingImagePyramidCachePointer                                  m_MovingImagePyramidCache;
 
   TransformParametersAdaptorsContainerType                        m_TransformParametersAdaptorsPerLevel;
 
@@ -121,6 +121,9 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 
   this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits = true;
 
+  this->m_FixedImagePyramidCache = ITK_NULLPTR;
+  this->m_MovingImagePyramidCache = ITK_NULLPTR;
+
   this->m_MetricSamplingStrategy = NONE;
   this->m_MetricSamplingPercentagePerLevel.SetSize( this->m_NumberOfLevels );
   this->m_MetricSamplingPercentagePerLevel.Fill( 1.0 );
@@ -574,41 +577,57 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
         ( this->m_Metric->GetMetricCategory() == MetricType::MULTI_METRIC &&
           multiMetric->GetMetricQueue()[n]->GetMetricCategory() == MetricType::IMAGE_METRIC ) )
       {
-      typedef DiscreteGaussianImageFilter<FixedImageType, FixedImageType> FixedImageSmoothingFilterType;
-      typename FixedImageSmoothingFilterType::Pointer fixedImageSmoothingFilter = FixedImageSmoothingFilterType::New();
-      if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
+      if( this->m_FixedImagePyramidCache.IsNotNull() )
         {
-        fixedImageSmoothingFilter->SetUseImageSpacingOn();
+        this->m_FixedSmoothImages[n] = this->m_FixedImagePyramidCache->GetSmoothedImage( this->GetFixedImage( n ),
+          this->m_SmoothingSigmasPerLevel[level], this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
         }
       else
         {
-        fixedImageSmoothingFilter->SetUseImageSpacingOff();
-        }
-      fixedImageSmoothingFilter->SetVariance( vnl_math_sqr( this->m_SmoothingSigmasPerLevel[level] ) );
-      fixedImageSmoothingFilter->SetMaximumError( 0.01 );
-      fixedImageSmoothingFilter->SetInput( this->GetFixedImage( n ) );
+        typedef DiscreteGaussianImageFilter<FixedImageType, FixedImageType> FixedImageSmoothingFilterType;
+        typename FixedImageSmoothingFilterType::Pointer fixedImageSmoothingFilter = FixedImageSmoothingFilterType::New();
+        if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
+          {
+          fixedImageSmoothingFilter->SetUseImageSpacingOn();
+          }
+        else
+          {
+          fixedImageSmoothingFilter->SetUseImageSpacingOff();
+          }
+        fixedImageSmoothingFilter->SetVariance( vnl_math_sqr( this->m_SmoothingSigmasPerLevel[level] ) );
+        fixedImageSmoothingFilter->SetMaximumError( 0.01 );
+        fixedImageSmoothingFilter->SetInput( this->GetFixedImage( n ) );
 
-      this->m_FixedSmoothImages[n] = fixedImageSmoothingFilter->GetOutput();
-      this->m_FixedSmoothImages[n]->Update();
-      this->m_FixedSmoothImages[n]->DisconnectPipeline();
+        this->m_FixedSmoothImages[n] = fixedImageSmoothingFilter->GetOutput();
+        this->m_FixedSmoothImages[n]->Update();
+        this->m_FixedSmoothImages[n]->DisconnectPipeline();
+        }
 
-      typedef DiscreteGaussianImageFilter<MovingImageType, MovingImageType> MovingImageSmoothingFilterType;
-      typename MovingImageSmoothingFilterType::Pointer movingImageSmoothingFilter = MovingImageSmoothingFilterType::New();
-      if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
+      if( this->m_MovingImagePyramidCache.IsNotNull() )
         {
-        movingImageSmoothingFilter->SetUseImageSpacingOn();
+        this->m_MovingSmoothImages[n] = this->m_MovingImagePyramidCache->GetSmoothedImage( this->GetMovingImage( n ),
+          this->m_SmoothingSigmasPerLevel[level], this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
         }
       else
         {
-        movingImageSmoothingFilter->SetUseImageSpacingOff();
-        }
-      movingImageSmoothingFilter->SetVariance( vnl_math_sqr( this->m_SmoothingSigmasPerLevel[level] ) );
-      movingImageSmoothingFilter->SetMaximumError( 0.01 );
-      movingImageSmoothingFilter->SetInput( this->GetMovingImage( n ) );
+        typedef DiscreteGaussianImageFilter<MovingImageType, MovingImageType> MovingImageSmoothingFilterType;
+        typename MovingImageSmoothingFilterType::Pointer movingImageSmoothingFilter = MovingImageSmoothingFilterType::New();
+        if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
+          {
+          movingImageSmoothingFilter->SetUseImageSpacingOn();
+          }
+        else
+          {
+          movingImageSmoothingFilter->SetUseImageSpacingOff();
+          }
+        movingImageSmoothingFilter->SetVariance( vnl_math_sqr( this->m_SmoothingSigmasPerLevel[level] ) );
+        movingImageSmoothingFilter->SetMaximumError( 0.01 );
+        movingImageSmoothingFilter->SetInput( this->GetMovingImage( n ) );
 
-      this->m_MovingSmoothImages[n] = movingImageSmoothingFilter->GetOutput();
-      this->m_MovingSmoothImages[n]->Update();
-      this->m_MovingSmoothImages[n]->DisconnectPipeline();
+        this->m_MovingSmoothImages[n] = movingImageSmoothingFilter->GetOutput();
+        this->m_MovingSmoothImages[n]->Update();
+        this->m_MovingSmoothImages[n]->DisconnectPipeline();
+        }
 
       // Update the image metric
 
@@ -616,11 +635,15 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
         {
         multiMetric->GetMetricQueue()[n]->SetFixedObject( this->m_FixedSmoothImages[n] );
         multiMetric->GetMetricQueue()[n]->SetMovingObject( this->m_MovingSmoothImages[n] );
+        this->SetMetricGradientFiltersFromPyramidCaches( multiMetric->GetMetricQueue()[n],
+          this->m_FixedSmoothImages[n], this->m_MovingSmoothImages[n] );
         }
       else if( this->m_Metric->GetMetricCategory() == MetricType::IMAGE_METRIC )
         {
         this->m_Metric->SetFixedObject( this->m_FixedSmoothImages[n] );
         this->m_Metric->SetMovingObject( this->m_MovingSmoothImages[n] );
+        this->SetMetricGradientFiltersFromPyramidCaches( this->m_Metric,
+          this->m_FixedSmoothImages[n], this->m_MovingSmoothImages[n] );
         }
       else
         {
@@ -837,6 +860,77 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     }
 }
 
+/**
+ * Assign the cached gradient filters to an image metric
+ */
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+void
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::SetMetricGradientFiltersFromPyramidCaches( MetricType * metric, const FixedImageType * fixedImage,
+  const MovingImageType * movingImage )
+{
+  if( this->m_FixedImagePyramidCache.IsNull() && this->m_MovingImagePyramidCache.IsNull() )
+    {
+    return;
+    }
+
+  ImageMetricType * imageMetric = dynamic_cast<ImageMetricType *>( metric );
+  if( imageMetric == ITK_NULLPTR )
+    {
+    return;
+    }
+
+  // The images may be swapped between the fixed and moving sides of the
+  // metric (e.g. SyN), so both caches are searched for each image.
+
+  typedef typename ImageMetricType::FixedImageGradientFilterType  FixedImageGradientFilterType;
+  typedef typename ImageMetricType::MovingImageGradientFilterType MovingImageGradientFilterType;
+
+  FixedImageGradientFilterType *fixedImageGradientFilter = ITK_NULLPTR;
+  if( this->m_FixedImagePyramidCache.IsNotNull() )
+    {
+    fixedImageGradientFilter = this->m_FixedImagePyramidCache->GetGradientFilter( fixedImage );
+    }
+  if( fixedImageGradientFilter == ITK_NULLPTR && this->m_MovingImagePyramidCache.IsNotNull() )
+    {
+    fixedImageGradientFilter = dynamic_cast<FixedImageGradientFilterType *>(
+      this->m_MovingImagePyramidCache->GetGradientFilter( fixedImage ) );
+    }
+
+  MovingImageGradientFilterType *movingImageGradientFilter = ITK_NULLPTR;
+  if( this->m_MovingImagePyramidCache.IsNotNull() )
+    {
+    movingImageGradientFilter = this->m_MovingImagePyramidCache->GetGradientFilter( movingImage );
+    }
+  if( movingImageGradientFilter == ITK_NULLPTR && this->m_FixedImagePyramidCache.IsNotNull() )
+    {
+    movingImageGradientFilter = dynamic_cast<MovingImageGradientFilterType *>(
+      this->m_FixedImagePyramidCache->GetGradientFilter( movingImage ) );
+    }
+
+  // Only the default gradient filters, or those of another cached level, are replaced.
+
+  const FixedImageGradientFilterType *currentFixedImageGradientFilter = imageMetric->GetFixedImageGradientFilter();
+  if( fixedImageGradientFilter != ITK_NULLPTR && ( imageMetric->GetFixedImageGradientFilterIsDefault() ||
+      ( this->m_FixedImagePyramidCache.IsNotNull() &&
+        this->m_FixedImagePyramidCache->IsCachedGradientFilter( currentFixedImageGradientFilter ) ) ||
+      ( this->m_MovingImagePyramidCache.IsNotNull() &&
+        this->m_MovingImagePyramidCache->IsCachedGradientFilter( currentFixedImageGradientFilter ) ) ) )
+    {
+    imageMetric->SetFixedImageGradientFilter( fixedImageGradientFilter );
+    }
+
+  const MovingImageGradientFilterType *currentMovingImageGradientFilter = imageMetric->GetMovingImageGradientFilter();
+  if( movingImageGradientFilter != ITK_NULLPTR && ( imageMetric->GetMovingImageGradientFilterIsDefault() ||
+      ( this->m_FixedImagePyramidCache.IsNotNull() &&
+        this->m_FixedImagePyramidCache->IsCachedGradientFilter( currentMovingImageGradientFilter ) ) ||
+      ( this->m_MovingImagePyramidCache.IsNotNull() &&
+        this->m_MovingImagePyramidCache->IsCachedGradientFilter( currentMovingImageGradientFilter ) ) ) )
+    {
+    imageMetric->SetMovingImageGradientFilter( movingImageGradientFilter );
+    }
+}
+
 /**
  * Get the metric samples
  */
@@ -1077,6 +1171,15 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     os << indent2 << "Smoothing sigmas are specified in voxel units." << std::endl;
     }
 
+  if( this->m_FixedImagePyramidCache.IsNotNull() )
+    {
+    os << indent << "Fixed image pyramid cache: " << this->m_FixedImagePyramidCache.GetPointer() << std::endl;
+    }
+  if( this->m_MovingImagePyramidCache.IsNotNull() )
+    {
+    os << indent << "Moving image pyramid cache: " << this->m_MovingImagePyramidCache.GetPointer() << std::endl;
+    }
+
   if( this->m_OptimizerWeights.Size() > 0 )
     {
     os << indent << "Optimizers weights: " << this->m_OptimizerWeights << std::endl;
@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRegistrationImagePyramidCache_h
+#define itkRegistrationImagePyramidCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkCovariantVector.h"
+#include "itkFixedArray.h"
+#include "itkGradientRecursiveGaussianImageFilter.h"
+#include "itkImage.h"
+#include "itkImageToImageFilter.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class RegistrationImagePyramidCache
+ * \brief Cache of the smoothed (and optionally shrunk) images of a
+ * multi-resolution registration, shared between registration stages.
+ *
+ * At each level, the registration methods smooth the fixed and moving
+ * images with a \c DiscreteGaussianImageFilter and the image metrics
+ * compute the gradient images of the smoothed images.  When several stages
+ * (e.g. rigid, affine and SyN) register the same image pair with the same
+ * schedule of smoothing sigmas, the same images are computed again by each
+ * stage.  Setting the same cache on each stage (see
+ * ImageRegistrationMethodv4::SetFixedImagePyramidCache() and
+ * ImageRegistrationMethodv4::SetMovingImagePyramidCache()) computes each
+ * level once.
+ *
+ * The levels are keyed by the source image (and its modification time),
+ * the smoothing sigma, the units of the sigma and the shrink factors.  Each
+ * level also holds a gradient filter, configured as the default gradient
+ * filter of the image metrics and connected to the smoothed image, which
+ * the registration methods assign to the image metrics.  The gradient
+ * image is computed the first time a metric is initialized with the level
+ * and is then reused by the following stages.
+ *
+ * The memory held by the cache may be bounded with
+ * SetMaximumMemorySize(), in which case the least recently used levels are
+ * released when a new level is added.  Images and filters still referenced
+ * by a registration method or a metric stay valid after being released.
+ *
+ * \ingroup ITKRegistrationMethodsv4
+ */
+template<typename TImage,
+         typename TGradientImage = Image<CovariantVector<typename NumericTraits<typename TImage::PixelType>::RealType,
+                                                         TImage::ImageDimension>,
+                                         TImage::ImageDimension> >
+class RegistrationImagePyramidCache
+:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef RegistrationImagePyramidCache             Self;
+  typedef Object                                    Superclass;
+  typedef SmartPointer<Self>                        Pointer;
+  typedef SmartPointer<const Self>                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RegistrationImagePyramidCache, Object );
+
+  /** ImageDimension constants */
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+
+  typedef TImage                                                      ImageType;
+  typedef typename ImageType::Pointer                                 ImagePointer;
+  typedef typename ImageType::ConstPointer                            ImageConstPointer;
+
+  typedef TGradientImage                                              GradientImageType;
+  typedef ImageToImageFilter<ImageType, GradientImageType>            GradientFilterType;
+  typedef GradientRecursiveGaussianImageFilter<ImageType, GradientImageType>
+                                                                      DefaultGradientFilterType;
+  typedef typename DefaultGradientFilterType::Pointer                 DefaultGradientFilterPointer;
+
+  typedef double                                                      RealType;
+  typedef FixedArray<unsigned int, ImageDimension>                    ShrinkFactorsType;
+
+  /**
+   * Get the image smoothed with a Gaussian of standard deviation \c sigma,
+   * in physical units or in voxels, and then shrunk by the shrink factors.
+   * The smoothing matches the one of ImageRegistrationMethodv4.  The level
+   * is computed on the first request and returned from the cache afterwards.
+   */
+  ImageType * GetSmoothedImage( const ImageType *image, const RealType sigma,
+    const bool sigmaIsSpecifiedInPhysicalUnits, const ShrinkFactorsType & shrinkFactors );
+
+  /** Get the smoothed image at full resolution. */
+  ImageType * GetSmoothedImage( const ImageType *image, const RealType sigma,
+    const bool sigmaIsSpecifiedInPhysicalUnits );
+
+  /**
+   * Get the gradient filter of a smoothed image returned by
+   * GetSmoothedImage(), or a null pointer if the image is not cached.
+   */
+  GradientFilterType * GetGradientFilter( const DataObject *smoothedImage );
+
+  /** Whether the gradient filter is the one of a cached level. */
+  bool IsCachedGradientFilter( const Object *filter ) const;
+
+  /**
+   * Set/Get the maximum size, in bytes, of the smoothed and gradient
+   * images held by the cache.  Zero (default) does not bound the cache.
+   */
+  itkSetMacro( MaximumMemorySize, SizeValueType );
+  itkGetConstMacro( MaximumMemorySize, SizeValueType );
+
+  /** Get the size, in bytes, of the smoothed and gradient images held by the cache. */
+  SizeValueType GetMemorySize() const;
+
+  /** Get the number of cached levels. */
+  SizeValueType GetNumberOfCachedImages() const
+    {
+    return static_cast<SizeValueType>( this->m_Levels.size() );
+    }
+
+  /** Get the number of requests found in, and missing from, the cache. */
+  itkGetConstMacro( NumberOfHits, SizeValueType );
+  itkGetConstMacro( NumberOfMisses, SizeValueType );
+
+  /** Release all the cached levels. */
+  void Clear();
+
+protected:
+  RegistrationImagePyramidCache();
+  virtual ~RegistrationImagePyramidCache();
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
+
+private:
+  RegistrationImagePyramidCache( const Self & );   //purposely not implemented
+  void operator=( const Self & );                  //purposely not implemented
+
+  struct CachedLevel
+    {
+    ImageConstPointer            m_SourceImage;
+    ModifiedTimeType             m_SourceImageMTime;
+    RealType                     m_Sigma;
+    bool                         m_SigmaIsSpecifiedInPhysicalUnits;
+    ShrinkFactorsType            m_ShrinkFactors;
+    ImagePointer                 m_SmoothedImage;
+    DefaultGradientFilterPointer m_GradientFilter;
+    SizeValueType                m_LastAccess;
+    };
+  typedef std::vector<CachedLevel>                                    CachedLevelsContainerType;
+
+  static SizeValueType GetLevelMemorySize( const CachedLevel & );
+
+  /** Release the least recently used levels, but the one at \c keep, until
+   * the memory size is within the maximum. */
+  void ReleaseLevels( SizeValueType keep );
+
+  CachedLevelsContainerType                                       m_Levels;
+  SizeValueType                                                   m_MaximumMemorySize;
+  SizeValueType                                                   m_AccessCounter;
+  SizeValueType                                                   m_NumberOfHits;
+  SizeValueType                                                   m_NumberOfMisses;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRegistrationImagePyramidCache.hxx"
+#endif
+
+#endif
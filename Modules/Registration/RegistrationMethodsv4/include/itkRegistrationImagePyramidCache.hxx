@@ -0,0 +1,279 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRegistrationImagePyramidCache_hxx
+#define itkRegistrationImagePyramidCache_hxx
+
+#include "itkRegistrationImagePyramidCache.h"
+
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkShrinkImageFilter.h"
+
+namespace itk
+{
+
+template<typename TImage, typename TGradientImage>
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::RegistrationImagePyramidCache() :
+  m_MaximumMemorySize( 0 ),
+  m_AccessCounter( 0 ),
+  m_NumberOfHits( 0 ),
+  m_NumberOfMisses( 0 )
+{
+}
+
+template<typename TImage, typename TGradientImage>
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::~RegistrationImagePyramidCache()
+{
+}
+
+template<typename TImage, typename TGradientImage>
+typename RegistrationImagePyramidCache<TImage, TGradientImage>::ImageType *
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::GetSmoothedImage( const ImageType *image, const RealType sigma, const bool sigmaIsSpecifiedInPhysicalUnits )
+{
+  ShrinkFactorsType shrinkFactors;
+  shrinkFactors.Fill( 1 );
+  return this->GetSmoothedImage( image, sigma, sigmaIsSpecifiedInPhysicalUnits, shrinkFactors );
+}
+
+template<typename TImage, typename TGradientImage>
+typename RegistrationImagePyramidCache<TImage, TGradientImage>::ImageType *
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::GetSmoothedImage( const ImageType *image, const RealType sigma, const bool sigmaIsSpecifiedInPhysicalUnits,
+  const ShrinkFactorsType & shrinkFactors )
+{
+  if( image == ITK_NULLPTR )
+    {
+    itkExceptionMacro( "The image to smooth is not set." );
+    }
+
+  // Look for the level, discarding the levels of a source image which was
+  // modified since they were computed.
+
+  for( SizeValueType n = 0; n < this->m_Levels.size(); n++ )
+    {
+    CachedLevel & cachedLevel = this->m_Levels[n];
+    if( cachedLevel.m_SourceImage.GetPointer() != image ||
+        cachedLevel.m_Sigma != sigma ||
+        cachedLevel.m_SigmaIsSpecifiedInPhysicalUnits != sigmaIsSpecifiedInPhysicalUnits ||
+        cachedLevel.m_ShrinkFactors != shrinkFactors )
+      {
+      continue;
+      }
+    if( cachedLevel.m_SourceImageMTime != image->GetMTime() )
+      {
+      this->m_Levels.erase( this->m_Levels.begin() + n );
+      break;
+      }
+    cachedLevel.m_LastAccess = ++this->m_AccessCounter;
+    this->m_NumberOfHits++;
+    return cachedLevel.m_SmoothedImage;
+    }
+
+  this->m_NumberOfMisses++;
+
+  CachedLevel level;
+  level.m_SourceImage = image;
+  level.m_SourceImageMTime = image->GetMTime();
+  level.m_Sigma = sigma;
+  level.m_SigmaIsSpecifiedInPhysicalUnits = sigmaIsSpecifiedInPhysicalUnits;
+  level.m_ShrinkFactors = shrinkFactors;
+  level.m_LastAccess = ++this->m_AccessCounter;
+
+  typedef DiscreteGaussianImageFilter<ImageType, ImageType> SmoothingFilterType;
+  typename SmoothingFilterType::Pointer smoothingFilter = SmoothingFilterType::New();
+  if( sigmaIsSpecifiedInPhysicalUnits == true )
+    {
+    smoothingFilter->SetUseImageSpacingOn();
+    }
+  else
+    {
+    smoothingFilter->SetUseImageSpacingOff();
+    }
+  smoothingFilter->SetVariance( vnl_math_sqr( sigma ) );
+  smoothingFilter->SetMaximumError( 0.01 );
+  smoothingFilter->SetInput( image );
+
+  bool isShrunk = false;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    if( shrinkFactors[d] > 1 )
+      {
+      isShrunk = true;
+      }
+    }
+  typedef ShrinkImageFilter<ImageType, ImageType> ShrinkFilterType;
+  typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+  if( isShrunk )
+    {
+    shrinkFilter->SetShrinkFactors( shrinkFactors );
+    shrinkFilter->SetInput( smoothingFilter->GetOutput() );
+
+    level.m_SmoothedImage = shrinkFilter->GetOutput();
+    }
+  else
+    {
+    level.m_SmoothedImage = smoothingFilter->GetOutput();
+    }
+  level.m_SmoothedImage->Update();
+  level.m_SmoothedImage->DisconnectPipeline();
+
+  // Configure the gradient filter as the default gradient filter of the image metrics
+
+  const typename ImageType::SpacingType & spacing = level.m_SmoothedImage->GetSpacing();
+  double maximumSpacing = 0.0;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    if( spacing[d] > maximumSpacing )
+      {
+      maximumSpacing = spacing[d];
+      }
+    }
+  level.m_GradientFilter = DefaultGradientFilterType::New();
+  level.m_GradientFilter->SetSigma( maximumSpacing );
+  level.m_GradientFilter->SetNormalizeAcrossScale( true );
+  level.m_GradientFilter->SetUseImageDirection( true );
+  level.m_GradientFilter->SetInput( level.m_SmoothedImage );
+
+  this->m_Levels.push_back( level );
+  this->ReleaseLevels( this->m_Levels.size() - 1 );
+  this->Modified();
+
+  return this->m_Levels.back().m_SmoothedImage;
+}
+
+template<typename TImage, typename TGradientImage>
+typename RegistrationImagePyramidCache<TImage, TGradientImage>::GradientFilterType *
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::GetGradientFilter( const DataObject *smoothedImage )
+{
+  for( SizeValueType n = 0; n < this->m_Levels.size(); n++ )
+    {
+    if( this->m_Levels[n].m_SmoothedImage.GetPointer() == smoothedImage )
+      {
+      this->m_Levels[n].m_LastAccess = ++this->m_AccessCounter;
+      return this->m_Levels[n].m_GradientFilter.GetPointer();
+      }
+    }
+  return ITK_NULLPTR;
+}
+
+template<typename TImage, typename TGradientImage>
+bool
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::IsCachedGradientFilter( const Object *filter ) const
+{
+  for( SizeValueType n = 0; n < this->m_Levels.size(); n++ )
+    {
+    if( this->m_Levels[n].m_GradientFilter.GetPointer() == filter )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+template<typename TImage, typename TGradientImage>
+SizeValueType
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::GetLevelMemorySize( const CachedLevel & level )
+{
+  SizeValueType memorySize = level.m_SmoothedImage->GetPixelContainer()->Size() *
+    sizeof( typename ImageType::InternalPixelType );
+
+  const GradientImageType *gradientImage = level.m_GradientFilter->GetOutput();
+  if( gradientImage->GetPixelContainer() )
+    {
+    memorySize += gradientImage->GetPixelContainer()->Size() *
+      sizeof( typename GradientImageType::InternalPixelType );
+    }
+  return memorySize;
+}
+
+template<typename TImage, typename TGradientImage>
+SizeValueType
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::GetMemorySize() const
+{
+  SizeValueType memorySize = 0;
+  for( SizeValueType n = 0; n < this->m_Levels.size(); n++ )
+    {
+    memorySize += Self::GetLevelMemorySize( this->m_Levels[n] );
+    }
+  return memorySize;
+}
+
+template<typename TImage, typename TGradientImage>
+void
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::ReleaseLevels( SizeValueType keep )
+{
+  if( this->m_MaximumMemorySize == 0 )
+    {
+    return;
+    }
+
+  // The gradient images are computed after the levels are added, so the
+  // memory size is measured again before each release.
+
+  while( this->m_Levels.size() > 1 && this->GetMemorySize() > this->m_MaximumMemorySize )
+    {
+    SizeValueType leastRecentlyUsed = ( keep == 0 ) ? 1 : 0;
+    for( SizeValueType n = 0; n < this->m_Levels.size(); n++ )
+      {
+      if( n != keep && this->m_Levels[n].m_LastAccess < this->m_Levels[leastRecentlyUsed].m_LastAccess )
+        {
+        leastRecentlyUsed = n;
+        }
+      }
+    itkDebugMacro( "Releasing the level of sigma " << this->m_Levels[leastRecentlyUsed].m_Sigma );
+    this->m_Levels.erase( this->m_Levels.begin() + leastRecentlyUsed );
+    if( leastRecentlyUsed < keep )
+      {
+      keep--;
+      }
+    }
+}
+
+template<typename TImage, typename TGradientImage>
+void
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::Clear()
+{
+  this->m_Levels.clear();
+  this->Modified();
+}
+
+template<typename TImage, typename TGradientImage>
+void
+RegistrationImagePyramidCache<TImage, TGradientImage>
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Maximum memory size: " << this->m_MaximumMemorySize << std::endl;
+  os << indent << "Memory size: " << this->GetMemorySize() << std::endl;
+  os << indent << "Number of cached images: " << this->m_Levels.size() << std::endl;
+  os << indent << "Number of hits: " << this->m_NumberOfHits << std::endl;
+  os << indent << "Number of misses: " << this->m_NumberOfMisses << std::endl;
+}
+
+} // end namespace itk
+
+#endif
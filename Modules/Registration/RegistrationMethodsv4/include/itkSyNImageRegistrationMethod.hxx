@@ -309,6 +309,8 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
           {
           multiMetric->GetMetricQueue()[n]->SetFixedObject( fixedImages[n] );
           multiMetric->GetMetricQueue()[n]->SetMovingObject( movingImages[n] );
+          this->SetMetricGradientFiltersFromPyramidCaches( multiMetric->GetMetricQueue()[n],
+            fixedImages[n], movingImages[n] );
           }
         else
           {
@@ -375,6 +377,7 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
         {
         this->m_Metric->SetFixedObject( fixedImages[0] );
         this->m_Metric->SetMovingObject( movingImages[0] );
+        this->SetMetricGradientFiltersFromPyramidCaches( this->m_Metric, fixedImages[0], movingImages[0] );
         dynamic_cast<ImageMetricType *>( this->m_Metric.GetPointer() )->SetFixedTransform( const_cast<TransformBaseType *>( fixedTransform ) );
         dynamic_cast<ImageMetricType *>( this->m_Metric.GetPointer() )->SetMovingTransform( const_cast<TransformBaseType *>( movingTransform ) );
         }
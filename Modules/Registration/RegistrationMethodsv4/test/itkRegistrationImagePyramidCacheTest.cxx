@@ -0,0 +1,290 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "itkAffineTransform.h"
+#include "itkGradientDescentOptimizerv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegistrationMethodv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkRegistrationImagePyramidCache.h"
+#include "itkSyNImageRegistrationMethod.h"
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image<double, Dimension>                                                   ImageType;
+typedef itk::AffineTransform<double, Dimension>                                         AffineTransformType;
+typedef itk::ImageRegistrationMethodv4<ImageType, ImageType, AffineTransformType>       AffineRegistrationType;
+typedef itk::SyNImageRegistrationMethod<ImageType, ImageType>                           SyNRegistrationType;
+typedef SyNRegistrationType::OutputTransformType                                        DisplacementFieldTransformType;
+typedef DisplacementFieldTransformType::DisplacementFieldType                           DisplacementFieldType;
+typedef itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType>                      MetricType;
+typedef AffineRegistrationType::FixedImagePyramidCacheType                              PyramidCacheType;
+
+ImageType::Pointer CreateImage( double centerX, double centerY )
+{
+  ImageType::SizeType size;
+  size.Fill( 32 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> It( image, image->GetLargestPossibleRegion() );
+  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    const double x = ( It.GetIndex()[0] - centerX ) / 7.0;
+    const double y = ( It.GetIndex()[1] - centerY ) / 5.0;
+    It.Set( 100.0 * std::exp( -x * x - y * y ) );
+    }
+  return image;
+}
+
+// Register the images with an affine stage followed by a SyN stage, both
+// using the pyramid cache if one is given.
+void RegisterImages( const ImageType *fixedImage, const ImageType *movingImage, PyramidCacheType *cache,
+  AffineTransformType::ParametersType & affineParameters, DisplacementFieldType::Pointer & displacementField,
+  bool & syNUsesCachedGradientFilters )
+{
+  AffineRegistrationType::ShrinkFactorsArrayType shrinkFactorsPerLevel( 3 );
+  shrinkFactorsPerLevel[0] = 2;
+  shrinkFactorsPerLevel[1] = 1;
+  shrinkFactorsPerLevel[2] = 1;
+
+  AffineRegistrationType::SmoothingSigmasArrayType smoothingSigmasPerLevel( 3 );
+  smoothingSigmasPerLevel[0] = 2.0;
+  smoothingSigmasPerLevel[1] = 1.0;
+  smoothingSigmasPerLevel[2] = 0.0;
+
+  typedef itk::GradientDescentOptimizerv4 OptimizerType;
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetLearningRate( 1.0e-6 );
+  optimizer->SetNumberOfIterations( 5 );
+
+  AffineRegistrationType::Pointer affineRegistration = AffineRegistrationType::New();
+  affineRegistration->SetFixedImage( fixedImage );
+  affineRegistration->SetMovingImage( movingImage );
+  affineRegistration->SetMetric( MetricType::New() );
+  affineRegistration->SetOptimizer( optimizer );
+  affineRegistration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  affineRegistration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  affineRegistration->SetFixedImagePyramidCache( cache );
+  affineRegistration->SetMovingImagePyramidCache( cache );
+  affineRegistration->Update();
+
+  affineParameters = affineRegistration->GetOutput()->Get()->GetParameters();
+
+  typedef AffineRegistrationType::CompositeTransformType CompositeTransformType;
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( affineRegistration->GetModifiableTransform() );
+
+  const DisplacementFieldType::PixelType zeroVector( 0.0 );
+
+  displacementField = DisplacementFieldType::New();
+  displacementField->CopyInformation( fixedImage );
+  displacementField->SetRegions( fixedImage->GetBufferedRegion() );
+  displacementField->Allocate();
+  displacementField->FillBuffer( zeroVector );
+
+  DisplacementFieldType::Pointer inverseDisplacementField = DisplacementFieldType::New();
+  inverseDisplacementField->CopyInformation( fixedImage );
+  inverseDisplacementField->SetRegions( fixedImage->GetBufferedRegion() );
+  inverseDisplacementField->Allocate();
+  inverseDisplacementField->FillBuffer( zeroVector );
+
+  DisplacementFieldTransformType::Pointer outputTransform = DisplacementFieldTransformType::New();
+  outputTransform->SetDisplacementField( displacementField );
+  outputTransform->SetInverseDisplacementField( inverseDisplacementField );
+
+  SyNRegistrationType::NumberOfIterationsArrayType numberOfIterationsPerLevel( 3 );
+  numberOfIterationsPerLevel[0] = 4;
+  numberOfIterationsPerLevel[1] = 3;
+  numberOfIterationsPerLevel[2] = 2;
+
+  shrinkFactorsPerLevel.Fill( 1 );
+
+  MetricType::Pointer syNMetric = MetricType::New();
+
+  SyNRegistrationType::Pointer syNRegistration = SyNRegistrationType::New();
+  syNRegistration->SetFixedImage( fixedImage );
+  syNRegistration->SetMovingImage( movingImage );
+  syNRegistration->SetMetric( syNMetric );
+  syNRegistration->SetInitialTransform( outputTransform );
+  syNRegistration->SetMovingInitialTransform( compositeTransform );
+  syNRegistration->SetDownsampleImagesForMetricDerivatives( false );
+  syNRegistration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  syNRegistration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  syNRegistration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  syNRegistration->SetFixedImagePyramidCache( cache );
+  syNRegistration->SetMovingImagePyramidCache( cache );
+  syNRegistration->Update();
+
+  displacementField = syNRegistration->GetModifiableTransform()->GetDisplacementField();
+
+  syNUsesCachedGradientFilters = cache != ITK_NULLPTR &&
+    cache->IsCachedGradientFilter( syNMetric->GetFixedImageGradientFilter() ) &&
+    cache->IsCachedGradientFilter( syNMetric->GetMovingImageGradientFilter() );
+}
+}
+
+int itkRegistrationImagePyramidCacheTest( int, char * [] )
+{
+  ImageType::Pointer fixedImage = CreateImage( 15.0, 16.0 );
+  ImageType::Pointer movingImage = CreateImage( 17.0, 15.0 );
+
+  try
+    {
+    // Test the cache on its own
+
+    PyramidCacheType::Pointer cache = PyramidCacheType::New();
+    cache->Print( std::cout );
+
+    PyramidCacheType::ShrinkFactorsType shrinkFactors;
+    shrinkFactors.Fill( 2 );
+
+    ImageType *smoothImage = cache->GetSmoothedImage( fixedImage, 1.0, true );
+    ImageType *shrunkImage = cache->GetSmoothedImage( fixedImage, 1.0, true, shrinkFactors );
+    if( cache->GetNumberOfMisses() != 2 || cache->GetNumberOfHits() != 0 || smoothImage == shrunkImage ||
+        shrunkImage->GetLargestPossibleRegion().GetSize()[0] != 16 )
+      {
+      std::cerr << "Unexpected cache levels." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( cache->GetSmoothedImage( fixedImage, 1.0, true ) != smoothImage ||
+        cache->GetSmoothedImage( fixedImage, 1.0, false ) == smoothImage ||
+        cache->GetNumberOfHits() != 1 || cache->GetNumberOfMisses() != 3 )
+      {
+      std::cerr << "The cached level is not returned." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( cache->GetGradientFilter( smoothImage ) == ITK_NULLPTR ||
+        cache->GetGradientFilter( smoothImage )->GetInput() != smoothImage ||
+        cache->GetGradientFilter( fixedImage ) != ITK_NULLPTR )
+      {
+      std::cerr << "Unexpected gradient filter." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // A modified source image is smoothed again
+    fixedImage->Modified();
+    if( cache->GetSmoothedImage( fixedImage, 1.0, true ) == smoothImage || cache->GetNumberOfCachedImages() != 3 )
+      {
+      std::cerr << "The level of the modified image is returned." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Bound the memory of the cache to a single level
+    const itk::SizeValueType imageMemorySize = 32 * 32 * sizeof( double );
+    if( cache->GetMemorySize() != 2 * imageMemorySize + imageMemorySize / 4 )
+      {
+      std::cerr << "Unexpected memory size " << cache->GetMemorySize() << std::endl;
+      return EXIT_FAILURE;
+      }
+    cache->SetMaximumMemorySize( imageMemorySize );
+    smoothImage = cache->GetSmoothedImage( movingImage, 2.0, true );
+    if( cache->GetNumberOfCachedImages() != 1 || cache->GetMemorySize() > imageMemorySize )
+      {
+      std::cerr << "The memory of the cache is not bounded." << std::endl;
+      return EXIT_FAILURE;
+      }
+    cache->GetGradientFilter( smoothImage )->Update();
+    if( cache->GetMemorySize() != imageMemorySize + 2 * imageMemorySize )
+      {
+      std::cerr << "The gradient image is not accounted for." << std::endl;
+      return EXIT_FAILURE;
+      }
+    cache->Clear();
+    if( cache->GetNumberOfCachedImages() != 0 || cache->GetMemorySize() != 0 )
+      {
+      std::cerr << "The cache is not cleared." << std::endl;
+      return EXIT_FAILURE;
+      }
+    cache->SetMaximumMemorySize( 0 );
+
+    // Register the images with and without a cache shared by the stages
+
+    AffineTransformType::ParametersType referenceAffineParameters;
+    DisplacementFieldType::Pointer referenceDisplacementField;
+    bool usesCachedGradientFilters = false;
+    RegisterImages( fixedImage, movingImage, ITK_NULLPTR, referenceAffineParameters,
+      referenceDisplacementField, usesCachedGradientFilters );
+
+    const itk::SizeValueType numberOfHits = cache->GetNumberOfHits();
+    const itk::SizeValueType numberOfMisses = cache->GetNumberOfMisses();
+
+    AffineTransformType::ParametersType affineParameters;
+    DisplacementFieldType::Pointer displacementField;
+    RegisterImages( fixedImage, movingImage, cache, affineParameters, displacementField, usesCachedGradientFilters );
+
+    // The affine stage computes the three levels of both images and the SyN
+    // stage reuses them.
+    std::cout << "Hits: " << cache->GetNumberOfHits() - numberOfHits
+              << ", misses: " << cache->GetNumberOfMisses() - numberOfMisses << std::endl;
+    if( cache->GetNumberOfMisses() - numberOfMisses != 6 || cache->GetNumberOfHits() - numberOfHits != 6 )
+      {
+      std::cerr << "The SyN stage does not reuse the levels of the affine stage." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( !usesCachedGradientFilters )
+      {
+      std::cerr << "The SyN metric does not use the cached gradient filters." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    for( unsigned int i = 0; i < affineParameters.Size(); i++ )
+      {
+      if( std::fabs( affineParameters[i] - referenceAffineParameters[i] ) > 1.0e-10 )
+        {
+        std::cerr << "The affine parameters differ: " << affineParameters << " instead of "
+                  << referenceAffineParameters << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    itk::ImageRegionIteratorWithIndex<DisplacementFieldType> It( displacementField,
+      displacementField->GetLargestPossibleRegion() );
+    double maximumDisplacement = 0.0;
+    for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+      {
+      const DisplacementFieldType::PixelType difference =
+        It.Get() - referenceDisplacementField->GetPixel( It.GetIndex() );
+      if( difference.GetNorm() > 1.0e-10 )
+        {
+        std::cerr << "The displacement fields differ at " << It.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+        }
+      maximumDisplacement = std::max( maximumDisplacement, It.Get().GetNorm() );
+      }
+    if( !( maximumDisplacement > 0.0 ) )
+      {
+      std::cerr << "The SyN stage did not update the displacement field." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -20,6 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
+#include <algorithm>
 #include <vector>
 #include <map>
 #include "itkProgressReporter.h"
@@ -43,9 +44,21 @@ namespace itk
  * component image filter which did not produce consecutive labels or
  * impose any particular ordering.
  *
- * \sa ImageToImageFilter
+ * Each thread encodes the runs of its block of lines, labels them and
+ * merges the runs of its block with a union-find structure. The
+ * blocks are then merged pairwise along their boundaries, in parallel,
+ * and each thread numbers the objects whose first run is in its
+ * block. Each thread only modifies the union-find entries of the
+ * blocks it merges, so that no locking is needed, and the labels do
+ * not depend on the number of threads.
+ *
+ * When SortByObjectSize is on, the objects are numbered by decreasing
+ * size instead, the objects of the same size keeping their raster
+ * order. The output is then the one of RelabelComponentImageFilter
+ * applied to the output of this filter, with a background value of 0.
+ *
+ * \sa ImageToImageFilter, RelabelComponentImageFilter
  *
- * \ingroup SingleThreaded
  * \ingroup ITKConnectedComponents
  *
  * \wiki
@@ -160,12 +173,21 @@ public:
   itkSetMacro(BackgroundValue, OutputImagePixelType);
   itkGetConstMacro(BackgroundValue, OutputImagePixelType);
 
+  /** Set/Get whether the object labels are sorted by decreasing
+   * object size, in the same way as RelabelComponentImageFilter.
+   * Default is SortByObjectSizeOff, which keeps the raster order of
+   * the objects. */
+  itkSetMacro(SortByObjectSize, bool);
+  itkGetConstMacro(SortByObjectSize, bool);
+  itkBooleanMacro(SortByObjectSize);
+
 protected:
   ConnectedComponentImageFilter()
   {
     m_FullyConnected = false;
     m_ObjectCount = 0;
     m_BackgroundValue = NumericTraits< OutputImagePixelType >::ZeroValue();
+    m_SortByObjectSize = false;
   }
 
   virtual ~ConnectedComponentImageFilter() {}
@@ -199,6 +221,7 @@ private:
 
   LabelType            m_ObjectCount;
   OutputImagePixelType m_BackgroundValue;
+  bool                 m_SortByObjectSize;
 
   // some additional types
   typedef typename TOutputImage::RegionType::SizeType OutSizeType;
@@ -237,14 +260,28 @@ public:
 
   void LinkLabels(const LabelType lab1, const LabelType lab2);
 
-  SizeValueType CreateConsecutive();
-
   //////////////////
   bool CheckNeighbors(const OutputIndexType & A,
                       const OutputIndexType & B);
 
   void CompareLines(lineEncoding & current, const lineEncoding & Neighbour);
 
+  /** Link the runs of the lines from firstLineId to lastLineId (excluded)
+   * to the runs of their previous neighbor lines, from
+   * firstNeighborLineId to lastNeighborLineId (excluded). */
+  void LinkLines(SizeValueType firstLineId, SizeValueType lastLineId,
+                 SizeValueType firstNeighborLineId, SizeValueType lastNeighborLineId,
+                 const OffsetVec & LineOffsets);
+
+  /** Number the objects whose root label is between firstLabel and
+   * lastLabel (excluded) by decreasing size, from the runs of the lines
+   * from firstLineId to lastLineId (excluded). All the threads must
+   * call it. */
+  void SortObjectsBySize(ThreadIdType threadId,
+                         SizeValueType firstLineId, SizeValueType lastLineId,
+                         LabelType firstLabel, LabelType lastLabel,
+                         LabelType firstObject);
+
   void FillOutput(const LineMapType & LineMap,
                   ProgressReporter & progress);
 
@@ -260,7 +297,34 @@ public:
   }
 
   typename std::vector< IdentifierType > m_NumberOfLabels;
-  typename std::vector< IdentifierType > m_FirstLineIdToJoin;
+  typename std::vector< IdentifierType > m_NumberOfObjectsForThread;
+
+  // the types to support the sorting of the objects by size
+  typedef std::map< LabelType, SizeValueType > ObjectSizeMapType;
+  UnionFindType                    m_ObjectSize;
+  std::vector< ObjectSizeMapType > m_OtherObjectSizes;
+  UnionFindType                    m_SortedObjects;
+
+  // order the objects by decreasing size, then by increasing label
+  class ObjectSizeComparator
+  {
+  public:
+    ObjectSizeComparator(const UnionFindType & objectSize):
+      m_ObjectSize(objectSize)
+    {}
+
+    bool operator()(const LabelType & a, const LabelType & b) const
+    {
+      if ( m_ObjectSize[a] != m_ObjectSize[b] )
+        {
+        return m_ObjectSize[a] > m_ObjectSize[b];
+        }
+      return a < b;
+    }
+
+  private:
+    const UnionFindType & m_ObjectSize;
+  };
 
   typename Barrier::Pointer m_Barrier;
 
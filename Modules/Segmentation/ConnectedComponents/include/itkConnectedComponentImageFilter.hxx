@@ -107,7 +107,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   const SizeValueType xsize = output->GetRequestedRegion().GetSize()[0];
   const SizeValueType linecount = pixelcount / xsize;
   m_LineMap.resize(linecount);
-  m_FirstLineIdToJoin.resize(nbOfThreads - 1);
+  m_NumberOfObjectsForThread.resize(nbOfThreads, 0);
 }
 
 template< typename TInputImage, typename TOutputImage, typename TMaskImage >
@@ -198,146 +198,146 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
     }
 
   m_NumberOfLabels[threadId] = nbOfLabels;
+  const LineIdType lastLineIdForThread = lineId;
 
   // wait for the other threads to complete that part
   this->Wait();
 
-  // compute the total number of labels
+  // compute the total number of labels, and the first label of the runs
+  // of this thread, so that the runs are labelled in raster order
   nbOfLabels = 0;
+  LabelType firstLabelForThread = 1;
   for ( ThreadIdType i = 0; i < nbOfThreads; i++ )
     {
+    if ( i < threadId )
+      {
+      firstLabelForThread += m_NumberOfLabels[i];
+      }
     nbOfLabels += m_NumberOfLabels[i];
     }
+  const LabelType lastLabelForThread = firstLabelForThread + m_NumberOfLabels[threadId];
 
   if ( threadId == 0 )
     {
     // set up the union find structure
     InitUnion(nbOfLabels);
-    // insert all the labels into the structure -- an extra loop but
-    // saves complicating the ones that come later
-    typename LineMapType::iterator MapBegin = m_LineMap.begin();
-    typename LineMapType::iterator MapEnd = m_LineMap.end();
-    typename LineMapType::iterator LineIt = MapBegin;
-    SizeValueType label = 1;
-    for ( LineIt = MapBegin; LineIt != MapEnd; ++LineIt )
+    m_Consecutive = UnionFindType(nbOfLabels + 1);
+    if ( m_SortByObjectSize )
       {
-      for ( typename lineEncoding::iterator cIt = LineIt->begin(); cIt != LineIt->end(); ++cIt )
-        {
-        cIt->label = label;
-        InsertSet(label);
-        label++;
-        }
+      m_ObjectSize = UnionFindType(nbOfLabels + 1);
+      m_SortedObjects = UnionFindType(nbOfLabels);
+      m_OtherObjectSizes.clear();
+      m_OtherObjectSizes.resize(nbOfThreads);
       }
     }
 
   // wait for the other threads to complete that part
   this->Wait();
 
+  // insert the labels of the runs of this thread into the structure
+  LabelType label = firstLabelForThread;
+  for ( LineIdType ThisIdx = firstLineIdForThread; ThisIdx < lastLineIdForThread; ++ThisIdx )
+    {
+    for ( typename lineEncoding::iterator cIt = m_LineMap[ThisIdx].begin(); cIt != m_LineMap[ThisIdx].end(); ++cIt )
+      {
+      cIt->label = label;
+      InsertSet(label);
+      label++;
+      }
+    }
+
   // now process the map and make appropriate entries in an equivalence
-  // table
-  // itkAssertInDebugAndIgnoreInReleaseMacro( linecount == m_LineMap.size() );
-  const SizeValueType pixelcount = output->GetRequestedRegion().GetNumberOfPixels();
-  const SizeValueType xsize = output->GetRequestedRegion().GetSize()[0];
-  const SizeValueType linecount = pixelcount / xsize;
+  // table, for the lines of the block of this thread
+  LinkLines(firstLineIdForThread, lastLineIdForThread,
+            firstLineIdForThread, lastLineIdForThread, LineOffsets);
+
+  // wait for the other threads to complete that part
+  this->Wait();
 
-  SizeValueType lastLineIdForThread =  linecount;
-  SizeValueType nbOfLineIdToJoin = 0;
-  if ( threadId != nbOfThreads - 1 )
+  // Merge the blocks along their boundaries, pairwise: at each step, the
+  // first plane of the block of some threads is merged with the group of
+  // blocks before it. Each thread only modifies the labels of its two
+  // groups, which no other thread is merging at the same step.
+  SizeValueType nbOfLinesPerPlane = 1;
+  for ( int i = 1; i < splitAxis; i++ )
     {
-    outputRegionForThreadSize = outputRegionForThread.GetSize();
-    outputRegionForThreadSize[splitAxis] -= 1;
-    lastLineIdForThread = firstLineIdForThread
-                          + RegionType(outputRegionIdx, outputRegionForThreadSize).GetNumberOfPixels() / xsizeForThread;
-    m_FirstLineIdToJoin[threadId] = lastLineIdForThread;
-    // found the number of line ids to join
-    nbOfLineIdToJoin =
-      RegionType( outputRegionIdx, outputRegionForThread.GetSize() ).GetNumberOfPixels() / xsizeForThread
-      - RegionType(outputRegionIdx, outputRegionForThreadSize).GetNumberOfPixels() / xsizeForThread;
+    nbOfLinesPerPlane *= outputRegionForThread.GetSize()[i];
+    }
+  for ( ThreadIdType step = 1; step < nbOfThreads; step *= 2 )
+    {
+    if ( threadId % ( 2 * step ) == step )
+      {
+      LinkLines(firstLineIdForThread, firstLineIdForThread + nbOfLinesPerPlane,
+                0, firstLineIdForThread, LineOffsets);
+      }
+
+    this->Wait();
     }
 
-  for ( SizeValueType ThisIdx = firstLineIdForThread; ThisIdx < lastLineIdForThread; ++ThisIdx )
+  // find the root of the labels of this thread; the structure is only read
+  // here. The roots are the smallest labels of their objects, so the
+  // objects are numbered by the threads of their roots.
+  IdentifierType nbOfObjects = 0;
+  for ( LabelType ThisLabel = firstLabelForThread; ThisLabel < lastLabelForThread; ++ThisLabel )
     {
-    if ( !m_LineMap[ThisIdx].empty() )
+    LabelType root = ThisLabel;
+    while ( m_UnionFind[root] != root )
       {
-      for ( typename OffsetVec::const_iterator I = LineOffsets.begin();
-            I != LineOffsets.end(); ++I )
-        {
-        const OffsetValueType NeighIdx = ( *I ) + ThisIdx;
-        // check if the neighbor is in the map
-        if ( NeighIdx >= 0 && NeighIdx < static_cast<OffsetValueType>( linecount ) && !m_LineMap[NeighIdx].empty() )
-          {
-          // Now check whether they are really neighbors
-          const bool areNeighbors =
-            CheckNeighbors(m_LineMap[ThisIdx][0].where, m_LineMap[NeighIdx][0].where);
-          if ( areNeighbors )
-            {
-            // Compare the two lines
-            CompareLines(m_LineMap[ThisIdx], m_LineMap[NeighIdx]);
-            }
-          }
-        }
+      root = m_UnionFind[root];
+      }
+    m_Consecutive[ThisLabel] = root;
+    if ( root == ThisLabel )
+      {
+      nbOfObjects++;
       }
     }
+  m_NumberOfObjectsForThread[threadId] = nbOfObjects;
 
   // wait for the other threads to complete that part
   this->Wait();
 
-  while ( m_FirstLineIdToJoin.size() != 0 )
+  LabelType firstObjectForThread = 0;
+  LabelType objectCount = 0;
+  for ( ThreadIdType i = 0; i < nbOfThreads; i++ )
     {
-    if ( threadId * 2 < static_cast<ThreadIdType>( m_FirstLineIdToJoin.size() ) )
+    if ( i < threadId )
       {
-      for ( SizeValueType ThisIdx = m_FirstLineIdToJoin[threadId * 2];
-            ThisIdx < m_FirstLineIdToJoin[threadId * 2] + nbOfLineIdToJoin;
-            ++ThisIdx )
-        {
-        if ( !m_LineMap[ThisIdx].empty() )
-          {
-          for ( typename OffsetVec::const_iterator I = LineOffsets.begin();
-                I != LineOffsets.end(); ++I )
-            {
-            const OffsetValueType NeighIdx = ( *I ) + ThisIdx;
-            // check if the neighbor is in the map
-            if ( NeighIdx >= 0 && NeighIdx < static_cast<OffsetValueType>( linecount ) && !m_LineMap[NeighIdx].empty() )
-              {
-              // Now check whether they are really neighbors
-              const bool areNeighbors =
-                CheckNeighbors(m_LineMap[ThisIdx][0].where, m_LineMap[NeighIdx][0].where);
-              if ( areNeighbors )
-                {
-                // Compare the two lines
-                CompareLines(m_LineMap[ThisIdx], m_LineMap[NeighIdx]);
-                }
-              }
-            }
-          }
-        }
+      firstObjectForThread += m_NumberOfObjectsForThread[i];
       }
+    objectCount += m_NumberOfObjectsForThread[i];
+    }
+  if ( threadId == 0 )
+    {
+    m_ObjectCount = objectCount;
+    }
 
-    this->Wait();
-
-    if ( threadId == 0 )
+  // The final label of each root replaces its parent in the union find
+  // structure, which is not used anymore.
+  if ( m_SortByObjectSize )
+    {
+    SortObjectsBySize(threadId, firstLineIdForThread, lastLineIdForThread,
+                      firstLabelForThread, lastLabelForThread, firstObjectForThread);
+    }
+  else
+    {
+    const SizeValueType background = static_cast< SizeValueType >( m_BackgroundValue );
+    LabelType           object = firstObjectForThread;
+    for ( LabelType ThisLabel = firstLabelForThread; ThisLabel < lastLabelForThread; ++ThisLabel )
       {
-      // remove the region already joined
-      typename std::vector< SizeValueType > newFirstLineIdToJoin;
-      for ( unsigned int i = 1; i < m_FirstLineIdToJoin.size(); i += 2 )
+      if ( m_Consecutive[ThisLabel] == ThisLabel )
         {
-        newFirstLineIdToJoin.push_back(m_FirstLineIdToJoin[i]);
+        // skip the background value
+        m_UnionFind[ThisLabel] = ( object < background ) ? object : object + 1;
+        object++;
         }
-      m_FirstLineIdToJoin = newFirstLineIdToJoin;
       }
-
-    this->Wait();
-    }
-
-  if ( threadId == 0 )
-    {
-    m_ObjectCount = CreateConsecutive();
     }
 
+  // wait for the other threads to complete that part
   this->Wait();
 
   // check for overflow exception here
-  if ( m_ObjectCount > static_cast< SizeValueType >(
+  if ( objectCount > static_cast< SizeValueType >(
          NumericTraits< OutputPixelType >::max() ) )
     {
     if ( threadId == 0 )
@@ -368,17 +368,12 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   ImageRegionIterator< OutputImageType > fend = oit;
   fend.GoToEnd();
 
-  lastLineIdForThread = firstLineIdForThread
-                        + RegionType( outputRegionIdx,
-                                      outputRegionForThread.GetSize() ).GetNumberOfPixels() / xsizeForThread;
-
   for ( SizeValueType ThisIdx = firstLineIdForThread; ThisIdx < lastLineIdForThread; ThisIdx++ )
     {
     // now fill the labelled sections
     for ( typename lineEncoding::const_iterator cIt = m_LineMap[ThisIdx].begin(); cIt != m_LineMap[ThisIdx].end(); ++cIt )
       {
-      const SizeValueType   Ilab = LookupSet(cIt->label);
-      const OutputPixelType lab = m_Consecutive[Ilab];
+      const OutputPixelType lab = static_cast< OutputPixelType >( m_UnionFind[m_Consecutive[cIt->label]] );
       oit.SetIndex(cIt->where);
       // initialize the non labelled pixels
       for (; fstart != oit; ++fstart )
@@ -401,15 +396,143 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
     }
 }
 
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::LinkLines(SizeValueType firstLineId, SizeValueType lastLineId,
+            SizeValueType firstNeighborLineId, SizeValueType lastNeighborLineId,
+            const OffsetVec & LineOffsets)
+{
+  for ( SizeValueType ThisIdx = firstLineId; ThisIdx < lastLineId; ++ThisIdx )
+    {
+    if ( !m_LineMap[ThisIdx].empty() )
+      {
+      for ( typename OffsetVec::const_iterator I = LineOffsets.begin();
+            I != LineOffsets.end(); ++I )
+        {
+        const OffsetValueType NeighIdx = ( *I ) + ThisIdx;
+        // check if the neighbor is in the map
+        if ( NeighIdx >= static_cast< OffsetValueType >( firstNeighborLineId )
+             && NeighIdx < static_cast< OffsetValueType >( lastNeighborLineId )
+             && !m_LineMap[NeighIdx].empty() )
+          {
+          // Now check whether they are really neighbors
+          const bool areNeighbors =
+            CheckNeighbors(m_LineMap[ThisIdx][0].where, m_LineMap[NeighIdx][0].where);
+          if ( areNeighbors )
+            {
+            // Compare the two lines
+            CompareLines(m_LineMap[ThisIdx], m_LineMap[NeighIdx]);
+            }
+          }
+        }
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::SortObjectsBySize(ThreadIdType threadId,
+                    SizeValueType firstLineId, SizeValueType lastLineId,
+                    LabelType firstLabel, LabelType lastLabel,
+                    LabelType firstObject)
+{
+  const ThreadIdType nbOfThreads = m_NumberOfLabels.size();
+
+  // Sum the sizes of the runs of this thread in their roots. The roots of
+  // the other threads, which come before this one, are accumulated apart.
+  for ( LabelType ThisLabel = firstLabel; ThisLabel < lastLabel; ++ThisLabel )
+    {
+    m_ObjectSize[ThisLabel] = 0;
+    }
+  ObjectSizeMapType & otherObjectSizes = m_OtherObjectSizes[threadId];
+  for ( SizeValueType ThisIdx = firstLineId; ThisIdx < lastLineId; ++ThisIdx )
+    {
+    for ( typename lineEncoding::const_iterator cIt = m_LineMap[ThisIdx].begin(); cIt != m_LineMap[ThisIdx].end(); ++cIt )
+      {
+      const LabelType root = m_Consecutive[cIt->label];
+      if ( root >= firstLabel )
+        {
+        m_ObjectSize[root] += cIt->length;
+        }
+      else
+        {
+        otherObjectSizes[root] += cIt->length;
+        }
+      }
+    }
+
+  // wait for the other threads to complete that part
+  this->Wait();
+
+  // add the sizes accumulated by the next threads
+  for ( ThreadIdType i = threadId + 1; i < nbOfThreads; i++ )
+    {
+    typename ObjectSizeMapType::const_iterator mIt = m_OtherObjectSizes[i].lower_bound(firstLabel);
+    for (; mIt != m_OtherObjectSizes[i].end() && mIt->first < lastLabel; ++mIt )
+      {
+      m_ObjectSize[mIt->first] += mIt->second;
+      }
+    }
+
+  // sort the roots of this thread, then merge the sorted roots of the
+  // threads pairwise
+  LabelType lastObject = firstObject;
+  for ( LabelType ThisLabel = firstLabel; ThisLabel < lastLabel; ++ThisLabel )
+    {
+    if ( m_Consecutive[ThisLabel] == ThisLabel )
+      {
+      m_SortedObjects[lastObject++] = ThisLabel;
+      }
+    }
+  const ObjectSizeComparator comparator(m_ObjectSize);
+  std::sort(m_SortedObjects.begin() + firstObject, m_SortedObjects.begin() + lastObject, comparator);
+
+  // wait for the other threads to complete that part
+  this->Wait();
+
+  std::vector< LabelType > firstObjectForThread(nbOfThreads + 1, 0);
+  for ( ThreadIdType i = 0; i < nbOfThreads; i++ )
+    {
+    firstObjectForThread[i + 1] = firstObjectForThread[i] + m_NumberOfObjectsForThread[i];
+    }
+  for ( ThreadIdType step = 1; step < nbOfThreads; step *= 2 )
+    {
+    if ( threadId % ( 2 * step ) == 0 && threadId + step < nbOfThreads )
+      {
+      std::inplace_merge(m_SortedObjects.begin() + firstObjectForThread[threadId],
+                         m_SortedObjects.begin() + firstObjectForThread[threadId + step],
+                         m_SortedObjects.begin() + firstObjectForThread[std::min(threadId + 2 * step, nbOfThreads)],
+                         comparator);
+      }
+
+    this->Wait();
+    }
+
+  // number the objects in their sorted order, skipping the background value
+  const SizeValueType background = static_cast< SizeValueType >( m_BackgroundValue );
+  for ( LabelType object = firstObject; object < lastObject; ++object )
+    {
+    m_UnionFind[m_SortedObjects[object]] = ( object < background ) ? object : object + 1;
+    }
+}
+
 template< typename TInputImage, typename TOutputImage, typename TMaskImage >
 void
 ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
 ::AfterThreadedGenerateData()
 {
   m_NumberOfLabels.clear();
+  m_NumberOfObjectsForThread.clear();
   m_Barrier = ITK_NULLPTR;
   m_LineMap.clear();
   m_Input = ITK_NULLPTR;
+  UnionFindType().swap(m_UnionFind);
+  UnionFindType().swap(m_Consecutive);
+  UnionFindType().swap(m_ObjectSize);
+  UnionFindType().swap(m_SortedObjects);
+  m_OtherObjectSizes.clear();
 }
 
 template< typename TInputImage, typename TOutputImage, typename TMaskImage >
@@ -593,32 +716,6 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   m_UnionFind[label] = label;
 }
 
-template< typename TInputImage, typename TOutputImage, typename TMaskImage >
-SizeValueType
-ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
-::CreateConsecutive()
-{
-  m_Consecutive = UnionFindType( m_UnionFind.size() );
-
-  SizeValueType CLab = 0;
-  SizeValueType count = 0;
-  for ( SizeValueType I = 1; I < m_UnionFind.size(); I++ )
-    {
-    SizeValueType L = m_UnionFind[I];
-    if ( L == I )
-      {
-      if ( CLab == static_cast< SizeValueType >( m_BackgroundValue ) )
-        {
-        ++CLab;
-        }
-      m_Consecutive[L] = CLab;
-      ++CLab;
-      ++count;
-      }
-    }
-  return count;
-}
-
 template< typename TInputImage, typename TOutputImage, typename TMaskImage >
 SizeValueType
 ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
@@ -661,6 +758,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   os << indent << "ObjectCount: "  << m_ObjectCount << std::endl;
   os << indent << "BackgroundValue: "
      << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+  os << indent << "SortByObjectSize: " << m_SortByObjectSize << std::endl;
 }
 } // end namespace itk
 
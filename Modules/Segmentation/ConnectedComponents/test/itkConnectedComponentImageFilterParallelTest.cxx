@@ -0,0 +1,270 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <iostream>
+#include <vector>
+
+#include "itkConnectedComponentImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkRelabelComponentImageFilter.h"
+
+namespace
+{
+typedef unsigned char InputPixelType;
+typedef unsigned int  LabelPixelType;
+
+// Label the objects of the image by flood filling them, in the raster
+// order of their first pixel, as ConnectedComponentImageFilter does.
+template< typename TInputImage, typename TLabelImage >
+typename TLabelImage::Pointer ReferenceLabels(const TInputImage *input, bool fullyConnected)
+{
+  const unsigned int Dimension = TInputImage::ImageDimension;
+  typedef typename TInputImage::OffsetType OffsetType;
+  typedef typename TInputImage::IndexType  IndexType;
+
+  std::vector< OffsetType > offsets;
+  unsigned int numberOfOffsets = 1;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    numberOfOffsets *= 3;
+    }
+  for( unsigned int n = 0; n < numberOfOffsets; ++n )
+    {
+    OffsetType   offset;
+    unsigned int code = n;
+    unsigned int numberOfNonZero = 0;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      offset[d] = static_cast< itk::OffsetValueType >( code % 3 ) - 1;
+      numberOfNonZero += ( offset[d] != 0 );
+      code /= 3;
+      }
+    if( numberOfNonZero == 1 || ( fullyConnected && numberOfNonZero > 1 ) )
+      {
+      offsets.push_back(offset);
+      }
+    }
+
+  const typename TInputImage::RegionType region = input->GetLargestPossibleRegion();
+  typename TLabelImage::Pointer labels = TLabelImage::New();
+  labels->SetRegions(region);
+  labels->Allocate();
+  labels->FillBuffer(0);
+
+  LabelPixelType label = 0;
+  itk::ImageRegionIteratorWithIndex< TInputImage > it( const_cast< TInputImage * >( input ), region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() == 0 || labels->GetPixel( it.GetIndex() ) != 0 )
+      {
+      continue;
+      }
+    ++label;
+    std::vector< IndexType > stack;
+    stack.push_back( it.GetIndex() );
+    labels->SetPixel(it.GetIndex(), label);
+    while( !stack.empty() )
+      {
+      const IndexType index = stack.back();
+      stack.pop_back();
+      for( unsigned int n = 0; n < offsets.size(); ++n )
+        {
+        const IndexType neighbor = index + offsets[n];
+        if( region.IsInside(neighbor) && input->GetPixel(neighbor) != 0
+            && labels->GetPixel(neighbor) == 0 )
+          {
+          labels->SetPixel(neighbor, label);
+          stack.push_back(neighbor);
+          }
+        }
+      }
+    }
+  return labels;
+}
+
+template< typename TImage >
+bool SameImages(const TImage *image1, const TImage *image2)
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+// Label random images with several numbers of threads, and compare the
+// labels to the reference ones and to the ones of
+// RelabelComponentImageFilter when they are sorted by size.
+template< unsigned int VDimension >
+int ParallelTest(const typename itk::Image< InputPixelType, VDimension >::SizeType & size, double density)
+{
+  typedef itk::Image< InputPixelType, VDimension >                              InputImageType;
+  typedef itk::Image< LabelPixelType, VDimension >                              LabelImageType;
+  typedef itk::ConnectedComponentImageFilter< InputImageType, LabelImageType >  FilterType;
+  typedef itk::RelabelComponentImageFilter< LabelImageType, LabelImageType >    RelabelType;
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(4321);
+
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions(size);
+  input->Allocate();
+  itk::ImageRegionIteratorWithIndex< InputImageType > it( input, input->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetUniformVariate(0.0, 1.0) < density ? 255 : 0 );
+    }
+
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+    {
+    typename LabelImageType::Pointer reference =
+      ReferenceLabels< InputImageType, LabelImageType >( input, fullyConnected != 0 );
+
+    for( unsigned int numberOfThreads = 1; numberOfThreads <= 5; ++numberOfThreads )
+      {
+      typename FilterType::Pointer filter = FilterType::New();
+      filter->SetInput(input);
+      filter->SetFullyConnected(fullyConnected != 0);
+      filter->SetNumberOfThreads(numberOfThreads);
+      filter->Update();
+
+      std::cout << "Dimension " << VDimension
+                << ", fully connected " << fullyConnected
+                << ", " << numberOfThreads << " threads: "
+                << filter->GetObjectCount() << " objects" << std::endl;
+
+      if( !SameImages< LabelImageType >( filter->GetOutput(), reference ) )
+        {
+        std::cerr << "The labels differ from the reference ones" << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      typename RelabelType::Pointer relabel = RelabelType::New();
+      relabel->SetInput( filter->GetOutput() );
+      relabel->Update();
+
+      typename FilterType::Pointer sortingFilter = FilterType::New();
+      sortingFilter->SetInput(input);
+      sortingFilter->SetFullyConnected(fullyConnected != 0);
+      sortingFilter->SetNumberOfThreads(numberOfThreads);
+      sortingFilter->SortByObjectSizeOn();
+      sortingFilter->Update();
+
+      if( sortingFilter->GetObjectCount() != filter->GetObjectCount()
+          || !SameImages< LabelImageType >( sortingFilter->GetOutput(), relabel->GetOutput() ) )
+        {
+        std::cerr << "The labels sorted by size differ from the ones of RelabelComponentImageFilter" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+// The pieces of the filter wait on each other at a barrier, so a
+// global thread budget smaller than its number of threads must not
+// reduce the number of pieces.
+int ThreadBudgetTest()
+{
+  typedef itk::Image< InputPixelType, 2 >                                       InputImageType;
+  typedef itk::Image< LabelPixelType, 2 >                                       LabelImageType;
+  typedef itk::ConnectedComponentImageFilter< InputImageType, LabelImageType >  FilterType;
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(8765);
+
+  InputImageType::SizeType size;
+  size[0] = 61;
+  size[1] = 47;
+  InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions(size);
+  input->Allocate();
+  itk::ImageRegionIteratorWithIndex< InputImageType > it( input, input->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetUniformVariate(0.0, 1.0) < 0.5 ? 255 : 0 );
+    }
+  LabelImageType::Pointer reference = ReferenceLabels< InputImageType, LabelImageType >( input, false );
+
+  const itk::ThreadIdType budget = itk::MultiThreader::GetGlobalThreadBudget();
+  itk::MultiThreader::SetGlobalThreadBudget(2);
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetNumberOfThreads(6);
+  try
+    {
+    filter->Update();
+    }
+  catch( ... )
+    {
+    itk::MultiThreader::SetGlobalThreadBudget(budget);
+    throw;
+    }
+  itk::MultiThreader::SetGlobalThreadBudget(budget);
+
+  std::cout << "Thread budget 2, 6 threads: " << filter->GetObjectCount() << " objects" << std::endl;
+  if( !SameImages< LabelImageType >( filter->GetOutput(), reference ) )
+    {
+    std::cerr << "The labels differ from the reference ones under a thread budget" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkConnectedComponentImageFilterParallelTest(int, char* [])
+{
+  try
+    {
+    itk::Size< 2 > size2D;
+    size2D[0] = 67;
+    size2D[1] = 53;
+    itk::Size< 3 > size3D;
+    size3D[0] = 23;
+    size3D[1] = 19;
+    size3D[2] = 17;
+    if( ParallelTest< 2 >( size2D, 0.45 ) != EXIT_SUCCESS
+        || ParallelTest< 2 >( size2D, 0.6 ) != EXIT_SUCCESS
+        || ParallelTest< 3 >( size3D, 0.3 ) != EXIT_SUCCESS
+        || ThreadBudgetTest() != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+
+    typedef itk::Image< InputPixelType, 2 >                                      ImageType;
+    typedef itk::ConnectedComponentImageFilter< ImageType, ImageType >           FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->Print(std::cout);
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}